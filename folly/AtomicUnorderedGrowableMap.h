@@ -0,0 +1,756 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/Likely.h>
+#include <folly/ScopeGuard.h>
+#include <folly/Traits.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+#include <folly/system/MemoryMapping.h>
+
+namespace folly {
+
+/// Options of AtomicUnorderedGrowableInsertMap, shared by all of its
+/// instantiations.
+struct AtomicUnorderedGrowableInsertMapOptions {
+  AtomicUnorderedGrowableInsertMapOptions() {}
+
+  // Convenience methods; return *this for chaining.
+  AtomicUnorderedGrowableInsertMapOptions& setMaxLoadFactor(float v) {
+    maxLoadFactor = v;
+    return *this;
+  }
+  AtomicUnorderedGrowableInsertMapOptions& setCommitBytes(size_t v) {
+    commitBytes = v;
+    return *this;
+  }
+  AtomicUnorderedGrowableInsertMapOptions& setHugePages(bool v) {
+    hugePages = v;
+    return *this;
+  }
+
+  // Average number of entries per bucket above which the bucket count
+  // is doubled.
+  float maxLoadFactor = 1.0f;
+
+  // Bytes committed at a time.  Must be a power of two and a multiple
+  // of the page size (of the huge page size for files on hugetlbfs).
+  size_t commitBytes = size_t(1) << 21;
+
+  // Advise the kernel to back the reservation with transparent huge
+  // pages.
+  bool hugePages = false;
+};
+
+/// AtomicUnorderedGrowableInsertMap is an insert-only hash map with the
+/// same contract as AtomicUnorderedInsertMap (see AtomicUnorderedMap.h):
+/// lock-free findOrConstruct, lock-free reads, keys and values that are
+/// never moved, and iterators that are never invalidated.  Unlike
+/// AtomicUnorderedInsertMap it does not need its capacity up front to
+/// size its table, and unlike AtomicHashMap it grows without chaining
+/// sub-maps, so a lookup never has to search more than one table.
+///
+/// GROWTH
+///
+/// All entries live on a single lock-free linked list sorted by the bit
+/// reversal of their hash (a "split-ordered list", Shalev and Shavit,
+/// 2006).  Buckets are shortcuts into that list: bucket b is a sentinel
+/// node placed right before the first entry whose hash is b modulo the
+/// bucket count.  Doubling the bucket count splits each bucket in place,
+/// so growing is a single CAS of the bucket count, no entry is ever
+/// relinked, and new buckets are spliced into the list lazily by the
+/// first insert that lands in them.  Lookups that find a bucket that is
+/// not spliced in yet start from its parent bucket, so they never write.
+///
+/// MEMORY
+///
+/// The maximum size is still a parameter, but it only decides how much
+/// virtual address space is reserved.  The reservation is one
+/// MemoryMapping with no access rights, so it costs neither memory nor
+/// commit charge.  Pages are committed (made readable and writable) in
+/// chunks of Options::commitBytes as the bucket directory and the entry
+/// arena reach them.  Options::hugePages asks for transparent huge pages
+/// on the reservation; commitBytes defaults to 2MB so that whole huge
+/// pages are committed at a time.
+///
+/// All links are indexes rather than pointers, which lets the map live in
+/// a file.  The File constructor maps the file shared: an empty file is
+/// initialized, while a file written by a previous instance with the same
+/// maxSize, options and types is remapped as is, which makes a warm
+/// restart free.  Keys and values of a file backed map must be trivially
+/// copyable, and Hash must be stable across processes.  The kernel writes
+/// the pages back, so the contents survive the process (even a crash,
+/// since entries are published with a single CAS), but not the machine
+/// unless the file is synced.  The file is sparse; its size is that of
+/// the full reservation.
+///
+/// The entry arena is allocated by bumping a counter.  Slots of entries
+/// whose construction loses a race to an equal key, or throws, go on a
+/// lock-free free list that later inserts take from first, so maxSize
+/// distinct keys always fit.  Beyond that findOrConstruct throws
+/// std::bad_alloc.  Each insert in flight holds a slot until it either
+/// links it or frees it, so leave one slot per writer thread of headroom
+/// if racing inserts of the same keys may fill the map completely.
+template <
+    typename Key,
+    typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>,
+    bool SkipKeyValueDeletion =
+        (std::is_trivially_destructible<Key>::value &&
+         std::is_trivially_destructible<Value>::value)>
+struct AtomicUnorderedGrowableInsertMap {
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<Key, Value>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using const_reference = const value_type&;
+
+  using Options = AtomicUnorderedGrowableInsertMapOptions;
+
+  struct ConstIterator {
+    ConstIterator(const AtomicUnorderedGrowableInsertMap& owner, uint64_t link)
+        : owner_(&owner), link_(link) {}
+
+    ConstIterator(const ConstIterator&) = default;
+    ConstIterator& operator=(const ConstIterator&) = default;
+
+    const value_type& operator*() const {
+      return *owner_->node(link_).keyValue();
+    }
+
+    const value_type* operator->() const {
+      return owner_->node(link_).keyValue();
+    }
+
+    // pre-increment
+    const ConstIterator& operator++() {
+      link_ = owner_->nextEntry(link_);
+      return *this;
+    }
+
+    // post-increment
+    ConstIterator operator++(int /* dummy */) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const ConstIterator& rhs) const {
+      return link_ == rhs.link_;
+    }
+    bool operator!=(const ConstIterator& rhs) const { return !(*this == rhs); }
+
+   private:
+    const AtomicUnorderedGrowableInsertMap* owner_;
+    uint64_t link_;
+  };
+  using const_iterator = ConstIterator;
+
+  friend ConstIterator;
+
+  /// Constructs an anonymous map that can hold up to maxSize key-value
+  /// pairs.  Throws invalid_argument if maxSize is zero or too large for
+  /// the address space, or if the options are invalid.
+  explicit AtomicUnorderedGrowableInsertMap(
+      size_t maxSize, Options options = Options())
+      : layout_(maxSize, options) {
+    mapping_ = MemoryMapping(
+        MemoryMapping::kAnonymous,
+        off64_t(layout_.totalBytes),
+        reservationOptions().setShared(false));
+    attach(options);
+    initialize();
+  }
+
+  /// Constructs a map backed by file, which must be open for reading and
+  /// writing.  If the file is empty a new map is created in it, otherwise
+  /// the map stored in it is remapped.  Throws invalid_argument if the
+  /// file holds something else, or a map created with a different
+  /// maxSize, options, or key and value types.
+  AtomicUnorderedGrowableInsertMap(
+      File file, size_t maxSize, Options options = Options())
+      : layout_(maxSize, options) {
+    static_assert(
+        std::is_trivially_copyable<Key>::value &&
+            std::is_trivially_copyable<Value>::value,
+        "a file backed AtomicUnorderedGrowableInsertMap needs trivially "
+        "copyable keys and values");
+    struct stat st;
+    checkUnixError(fstat(file.fd(), &st), "fstat");
+    bool const fresh = st.st_size == 0;
+    if (!fresh && uint64_t(st.st_size) != layout_.totalBytes) {
+      throw std::invalid_argument(
+          "AtomicUnorderedGrowableInsertMap file has the wrong size");
+    }
+    mapping_ = MemoryMapping(
+        std::move(file),
+        0,
+        off64_t(layout_.totalBytes),
+        reservationOptions().setGrow(true));
+    attach(options);
+    if (fresh) {
+      initialize();
+    } else {
+      remap();
+    }
+  }
+
+  AtomicUnorderedGrowableInsertMap(const AtomicUnorderedGrowableInsertMap&) =
+      delete;
+  AtomicUnorderedGrowableInsertMap& operator=(
+      const AtomicUnorderedGrowableInsertMap&) = delete;
+
+  ~AtomicUnorderedGrowableInsertMap() {
+    if (!SkipKeyValueDeletion) {
+      for (auto link = nextEntry(kBucketZero); link != kEnd;) {
+        auto& n = node(link);
+        link = nextEntry(link);
+        n.keyValue()->second.~Value();
+        n.keyValue()->first.~Key();
+      }
+    }
+  }
+
+  /// Searches for the key, returning (iter,false) if it is found.  If it
+  /// is not found constructs a Value from func() and returns (iter,true).
+  /// As with AtomicUnorderedInsertMap, func may be called and the value
+  /// immediately destroyed if a concurrent insert of an equal key wins.
+  ///
+  /// This function does not block other readers or writers, apart from
+  /// the mprotect() call made by the insert that first reaches a new
+  /// commit chunk.
+  template <typename Func>
+  std::pair<const_iterator, bool> findOrConstruct(const Key& key, Func&& func) {
+    auto const hash = uint64_t(hasher()(key));
+    auto const order = regularOrder(hash);
+    auto const bucketCount =
+        header_->bucketCount.load(std::memory_order_acquire);
+    auto prev = insertBucket(hash & (bucketCount - 1));
+    uint64_t next;
+
+    auto existing = locate(key, order, prev, next);
+    if (existing != kEnd) {
+      return std::make_pair(ConstIterator(*this, existing), false);
+    }
+
+    // The copying of key and the calling of func can throw exceptions.
+    // Either way the slot goes on the free list, as if a concurrent insert
+    // had won.
+    auto const idx = allocateNode();
+    if (idx == kNoNode) {
+      // the insert that filled the arena may have been of this key
+      existing = locate(key, order, prev, next);
+      if (existing != kEnd) {
+        return std::make_pair(ConstIterator(*this, existing), false);
+      }
+      throw std::bad_alloc();
+    }
+    auto guardSlot = folly::makeGuard([&] { freeNode(idx); });
+    auto& n = nodes_[idx];
+    value_type* addr = n.keyValue();
+    new (static_cast<void*>(std::addressof(addr->first))) Key(key);
+    auto guardKey = folly::makeGuard([&] { addr->first.~Key(); });
+    new (static_cast<void*>(std::addressof(addr->second))) Value(func());
+    auto guardMapped = folly::makeGuard([&] { addr->second.~Value(); });
+    n.order = order;
+
+    auto const link = nodeLink(idx);
+    while (true) {
+      n.next.store(next, std::memory_order_relaxed);
+      if (nextOf(prev).compare_exchange_strong(
+              next,
+              link,
+              std::memory_order_release,
+              std::memory_order_acquire)) {
+        guardMapped.dismiss();
+        guardKey.dismiss();
+        guardSlot.dismiss();
+        maybeGrow(bucketCount);
+        return std::make_pair(ConstIterator(*this, link), true);
+      }
+      // Entries are never unlinked, so prev is still in the list and the
+      // search can resume from it.
+      existing = locate(key, order, prev, next);
+      if (existing != kEnd) {
+        // our allocated key and value are no longer needed
+        // and so the guards expire and invoke the cleanups
+        return std::make_pair(ConstIterator(*this, existing), false);
+      }
+    }
+  }
+
+  /// This isn't really emplace, but it mirrors
+  /// AtomicUnorderedInsertMap::emplace.
+  template <class K, class V>
+  std::pair<const_iterator, bool> emplace(const K& key, V&& value) {
+    return findOrConstruct(key, [&] { return Value(std::forward<V>(value)); });
+  }
+
+  const_iterator find(const Key& key) const {
+    auto const hash = uint64_t(hasher()(key));
+    auto const bucketCount =
+        header_->bucketCount.load(std::memory_order_acquire);
+    auto prev = readyBucket(hash & (bucketCount - 1));
+    uint64_t next;
+    return ConstIterator(*this, locate(key, regularOrder(hash), prev, next));
+  }
+
+  /// Iteration is in split order, which is unrelated to insertion order.
+  const_iterator cbegin() const {
+    return ConstIterator(*this, nextEntry(kBucketZero));
+  }
+  const_iterator begin() const { return cbegin(); }
+
+  const_iterator cend() const { return ConstIterator(*this, kEnd); }
+  const_iterator end() const { return cend(); }
+
+  /// The number of entries.  Exact when there are no concurrent inserts.
+  size_t size() const {
+    return size_t(
+        allocatedNodes() -
+        header_->freeCount.load(std::memory_order_acquire));
+  }
+
+  size_t maxSize() const { return size_t(layout_.maxSize); }
+
+  size_t bucketCount() const {
+    return size_t(header_->bucketCount.load(std::memory_order_acquire));
+  }
+
+ private:
+  // Links name nodes of the list.  Even links are entries (their arena
+  // index plus one, doubled), odd links are bucket sentinels (the bucket
+  // index, doubled, plus one).  Zero, the value of zero-filled memory,
+  // ends the list.
+  static constexpr uint64_t kEnd = 0;
+  static constexpr uint64_t kBucketZero = 1;
+
+  /// returned by allocateNode when the arena is full
+  static constexpr uint64_t kNoNode = std::numeric_limits<uint64_t>::max();
+
+  static constexpr uint64_t kMagic = 0x4d4741594c4c4f46; // "FOLLYAGM"
+  static constexpr uint64_t kInitialBucketCount = 16;
+
+  // maxSize is at most 2^40, so node links fit in the low 42 bits
+  static constexpr unsigned kFreeTagShift = 42;
+  static constexpr uint64_t kFreeLinkMask =
+      (uint64_t(1) << kFreeTagShift) - 1;
+
+  enum BucketState : uint64_t {
+    UNINITIALIZED = 0,
+    INITIALIZING = 1,
+    READY = 2,
+  };
+
+  struct Header {
+    uint64_t magic;
+    uint64_t keySize;
+    uint64_t valueSize;
+    uint64_t maxSize;
+    uint64_t maxBuckets;
+    uint64_t commitBytes;
+    uint64_t maxLoadFactor;
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<uint64_t> bucketCount;
+
+    alignas(hardware_destructive_interference_size)
+        std::atomic<uint64_t> nodeCount;
+
+    /// Head of the free list: a tag in the top kFreeTagBits bits, against
+    /// ABA, and the link of the first free node in the rest.  Free nodes
+    /// are chained through their next field.
+    std::atomic<uint64_t> freeList;
+    std::atomic<uint64_t> freeCount;
+  };
+
+  /// A bucket is the sentinel node of the list that precedes its entries.
+  struct Bucket {
+    std::atomic<uint64_t> next;
+    std::atomic<uint64_t> state;
+  };
+
+  struct Node {
+    std::atomic<uint64_t> next;
+
+    /// bit reversed hash, see regularOrder
+    uint64_t order;
+
+    /// Key and Value
+    aligned_storage_for_t<value_type> raw;
+
+    value_type* keyValue() {
+      return static_cast<value_type*>(static_cast<void*>(&raw));
+    }
+
+    const value_type* keyValue() const {
+      return static_cast<const value_type*>(static_cast<const void*>(&raw));
+    }
+  };
+
+  /// Offsets of the three regions of the reservation, each of which is
+  /// aligned to commitBytes: the header, the bucket directory and the
+  /// entry arena.
+  struct Layout {
+    uint64_t maxSize;
+    uint64_t maxBuckets;
+    uint64_t commitBytes;
+    uint64_t bucketsOffset;
+    uint64_t nodesOffset;
+    uint64_t totalBytes;
+
+    Layout(size_t size, const Options& options)
+        : maxSize(size), commitBytes(options.commitBytes) {
+      auto const pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+      if (commitBytes < pageSize || (commitBytes & (commitBytes - 1)) != 0) {
+        throw std::invalid_argument(
+            "AtomicUnorderedGrowableInsertMap commitBytes must be a power of "
+            "two no smaller than the page size");
+      }
+      if (!(options.maxLoadFactor >= 0.125f)) {
+        throw std::invalid_argument(
+            "AtomicUnorderedGrowableInsertMap maxLoadFactor is too small");
+      }
+      // keep the whole reservation, and the links, well inside 64 bits
+      if (maxSize == 0 || maxSize > (uint64_t(1) << 40)) {
+        throw std::invalid_argument(
+            "AtomicUnorderedGrowableInsertMap maxSize must be in [1, 2^40]");
+      }
+      maxBuckets = nextPowTwo(std::max(
+          kInitialBucketCount,
+          uint64_t(double(maxSize) / options.maxLoadFactor) + 1));
+      bucketsOffset = commitBytes;
+      nodesOffset =
+          bucketsOffset + roundUp(maxBuckets * sizeof(Bucket), commitBytes);
+      totalBytes = nodesOffset + roundUp(maxSize * sizeof(Node), commitBytes);
+    }
+
+    static uint64_t roundUp(uint64_t n, uint64_t align) {
+      return (n + align - 1) & ~(align - 1);
+    }
+  };
+
+  Layout layout_;
+  float maxLoadFactor_;
+  MemoryMapping mapping_{MemoryMapping::kAnonymous, 0};
+  uint8_t* base_;
+  Header* header_;
+  Bucket* buckets_;
+  Node* nodes_;
+
+  /// Bytes of the bucket directory and of the entry arena that this
+  /// process has made accessible.
+  std::atomic<uint64_t> bucketsCommitted_{0};
+  std::atomic<uint64_t> nodesCommitted_{0};
+
+  static MemoryMapping::Options reservationOptions() {
+    return MemoryMapping::Options().setReadable(false).setWritable(false);
+  }
+
+  void attach(const Options& options) {
+    maxLoadFactor_ = options.maxLoadFactor;
+    base_ = const_cast<uint8_t*>(mapping_.range().data());
+#ifdef MADV_HUGEPAGE
+    if (options.hugePages) {
+      // only a hint, which may not be supported
+      ::madvise(base_, size_t(layout_.totalBytes), MADV_HUGEPAGE);
+    }
+#endif
+    commit(base_, 0, layout_.commitBytes);
+    header_ = reinterpret_cast<Header*>(base_);
+    buckets_ = reinterpret_cast<Bucket*>(base_ + layout_.bucketsOffset);
+    nodes_ = reinterpret_cast<Node*>(base_ + layout_.nodesOffset);
+  }
+
+  uint64_t fingerprintLoadFactor() const {
+    return uint64_t(double(maxLoadFactor_) * 1024);
+  }
+
+  void initialize() {
+    auto h = new (base_) Header();
+    h->keySize = sizeof(Key);
+    h->valueSize = sizeof(Value);
+    h->maxSize = layout_.maxSize;
+    h->maxBuckets = layout_.maxBuckets;
+    h->commitBytes = layout_.commitBytes;
+    h->maxLoadFactor = fingerprintLoadFactor();
+    auto const bucketCount = std::min(kInitialBucketCount, layout_.maxBuckets);
+    commitBuckets(bucketCount);
+    h->bucketCount.store(bucketCount, std::memory_order_relaxed);
+    buckets_[0].state.store(READY, std::memory_order_relaxed);
+    // the magic goes last, so that a file whose initialization was
+    // interrupted is rejected rather than remapped
+    h->magic = kMagic;
+  }
+
+  void remap() {
+    auto h = header_;
+    if (h->magic != kMagic || h->keySize != sizeof(Key) ||
+        h->valueSize != sizeof(Value) || h->maxSize != layout_.maxSize ||
+        h->maxBuckets != layout_.maxBuckets ||
+        h->commitBytes != layout_.commitBytes ||
+        h->maxLoadFactor != fingerprintLoadFactor()) {
+      throw std::invalid_argument(
+          "AtomicUnorderedGrowableInsertMap file does not hold a matching map");
+    }
+    commitBuckets(h->bucketCount.load(std::memory_order_acquire));
+    commitNodes(allocatedNodes());
+  }
+
+  uint64_t allocatedNodes() const {
+    return std::min(
+        header_->nodeCount.load(std::memory_order_acquire), layout_.maxSize);
+  }
+
+  /// Makes [0, bytes) of the region at offset accessible, given that
+  /// committed bytes of it already are.  Idempotent, so racing threads
+  /// may all call mprotect() for the same chunk.
+  void commit(uint8_t* base, uint64_t committed, uint64_t bytes) {
+    if (::mprotect(
+            base + committed,
+            size_t(bytes - committed),
+            PROT_READ | PROT_WRITE) != 0) {
+      throwSystemError("AtomicUnorderedGrowableInsertMap mprotect failed");
+    }
+  }
+
+  void commitRegion(
+      std::atomic<uint64_t>& committed,
+      uint64_t offset,
+      uint64_t regionBytes,
+      uint64_t bytes) {
+    auto done = committed.load(std::memory_order_acquire);
+    if (FOLLY_LIKELY(bytes <= done)) {
+      return;
+    }
+    auto const target =
+        std::min(Layout::roundUp(bytes, layout_.commitBytes), regionBytes);
+    commit(base_ + offset, done, target);
+    while (done < target &&
+           !committed.compare_exchange_weak(
+               done,
+               target,
+               std::memory_order_release,
+               std::memory_order_acquire)) {
+    }
+  }
+
+  void commitBuckets(uint64_t count) {
+    commitRegion(
+        bucketsCommitted_,
+        layout_.bucketsOffset,
+        layout_.nodesOffset - layout_.bucketsOffset,
+        count * sizeof(Bucket));
+  }
+
+  void commitNodes(uint64_t count) {
+    commitRegion(
+        nodesCommitted_,
+        layout_.nodesOffset,
+        layout_.totalBytes - layout_.nodesOffset,
+        count * sizeof(Node));
+  }
+
+  uint64_t allocateNode() {
+    auto head = header_->freeList.load(std::memory_order_acquire);
+    while ((head & kFreeLinkMask) != kEnd) {
+      auto const link = head & kFreeLinkMask;
+      auto const next = node(link).next.load(std::memory_order_relaxed);
+      if (header_->freeList.compare_exchange_weak(
+              head,
+              nextFreeTag(head) | next,
+              std::memory_order_acquire,
+              std::memory_order_acquire)) {
+        header_->freeCount.fetch_sub(1, std::memory_order_relaxed);
+        return (link >> 1) - 1;
+      }
+    }
+    auto const idx = header_->nodeCount.fetch_add(1, std::memory_order_relaxed);
+    if (idx >= layout_.maxSize) {
+      return kNoNode;
+    }
+    commitNodes(idx + 1);
+    return idx;
+  }
+
+  /// Pushes a node that never made it into the list onto the free list.
+  void freeNode(uint64_t idx) {
+    auto const link = nodeLink(idx);
+    header_->freeCount.fetch_add(1, std::memory_order_relaxed);
+    auto head = header_->freeList.load(std::memory_order_relaxed);
+    do {
+      nodes_[idx].next.store(head & kFreeLinkMask, std::memory_order_relaxed);
+    } while (!header_->freeList.compare_exchange_weak(
+        head,
+        nextFreeTag(head) | link,
+        std::memory_order_release,
+        std::memory_order_relaxed));
+  }
+
+  static uint64_t nextFreeTag(uint64_t head) {
+    return ((head >> kFreeTagShift) + 1) << kFreeTagShift;
+  }
+
+  void maybeGrow(uint64_t bucketCount) {
+    if (bucketCount >= layout_.maxBuckets ||
+        double(size()) <= double(bucketCount) * maxLoadFactor_) {
+      return;
+    }
+    // the new buckets must be accessible before anyone can pick them
+    commitBuckets(bucketCount * 2);
+    header_->bucketCount.compare_exchange_strong(
+        bucketCount, bucketCount * 2, std::memory_order_acq_rel);
+  }
+
+  static uint64_t reverseBits(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555) | ((v & 0x5555555555555555) << 1);
+    v = ((v >> 2) & 0x3333333333333333) | ((v & 0x3333333333333333) << 2);
+    v = ((v >> 4) & 0x0f0f0f0f0f0f0f0f) | ((v & 0x0f0f0f0f0f0f0f0f) << 4);
+    return Endian::swap(v);
+  }
+
+  /// Entries sort after the sentinel of their bucket, which sorts by the
+  /// plain reversal of the bucket index.  Bucket indexes never use the
+  /// top bit, so sentinel orders are even and entry orders are odd.
+  static uint64_t regularOrder(uint64_t hash) { return reverseBits(hash) | 1; }
+
+  static uint64_t bucketOrder(uint64_t bucket) { return reverseBits(bucket); }
+
+  static uint64_t nodeLink(uint64_t idx) { return (idx + 1) << 1; }
+
+  static uint64_t bucketLink(uint64_t bucket) { return (bucket << 1) | 1; }
+
+  static bool isBucket(uint64_t link) { return (link & 1) != 0; }
+
+  /// The bucket that bucket splits from: its index without the top bit.
+  static uint64_t parentBucket(uint64_t bucket) {
+    return bucket ^ (uint64_t(1) << (findLastSet(bucket) - 1));
+  }
+
+  Node& node(uint64_t link) const {
+    assert(link != kEnd && !isBucket(link));
+    return nodes_[(link >> 1) - 1];
+  }
+
+  std::atomic<uint64_t>& nextOf(uint64_t link) const {
+    return isBucket(link) ? buckets_[link >> 1].next : node(link).next;
+  }
+
+  uint64_t orderOf(uint64_t link) const {
+    return isBucket(link) ? bucketOrder(link >> 1) : node(link).order;
+  }
+
+  /// The first entry after link, skipping bucket sentinels.
+  uint64_t nextEntry(uint64_t link) const {
+    do {
+      link = nextOf(link).load(std::memory_order_acquire);
+    } while (link != kEnd && isBucket(link));
+    return link;
+  }
+
+  /// Walks the list from prev to the position of order.  Returns the
+  /// entry equal to key if there is one.  Otherwise returns kEnd, and
+  /// leaves prev and next around the position.
+  uint64_t locate(
+      const Key& key, uint64_t order, uint64_t& prev, uint64_t& next) const {
+    KeyEqual ke = {};
+    next = nextOf(prev).load(std::memory_order_acquire);
+    while (next != kEnd) {
+      auto const o = orderOf(next);
+      if (o > order) {
+        break;
+      }
+      if (o == order && ke(key, node(next).keyValue()->first)) {
+        return next;
+      }
+      prev = next;
+      next = nextOf(prev).load(std::memory_order_acquire);
+    }
+    return kEnd;
+  }
+
+  /// The sentinel of bucket, or of its nearest ancestor if bucket is not
+  /// in the list yet.  Bucket zero always is.
+  uint64_t readyBucket(uint64_t bucket) const {
+    while (buckets_[bucket].state.load(std::memory_order_acquire) != READY) {
+      bucket = parentBucket(bucket);
+    }
+    return bucketLink(bucket);
+  }
+
+  uint64_t insertBucket(uint64_t bucket) {
+    if (buckets_[bucket].state.load(std::memory_order_acquire) ==
+        UNINITIALIZED) {
+      initializeBucket(bucket);
+    }
+    return readyBucket(bucket);
+  }
+
+  /// Splices the sentinel of bucket into the list.  A bucket that another
+  /// thread is splicing is left to it; readyBucket falls back to the
+  /// parent until it is done.
+  void initializeBucket(uint64_t bucket) {
+    auto prev = insertBucket(parentBucket(bucket));
+    auto& b = buckets_[bucket];
+    uint64_t expected = UNINITIALIZED;
+    if (!b.state.compare_exchange_strong(
+            expected, INITIALIZING, std::memory_order_acq_rel)) {
+      return;
+    }
+    auto const order = bucketOrder(bucket);
+    auto const link = bucketLink(bucket);
+    auto next = nextOf(prev).load(std::memory_order_acquire);
+    while (true) {
+      while (next != kEnd && orderOf(next) < order) {
+        prev = next;
+        next = nextOf(prev).load(std::memory_order_acquire);
+      }
+      b.next.store(next, std::memory_order_relaxed);
+      if (nextOf(prev).compare_exchange_strong(
+              next,
+              link,
+              std::memory_order_release,
+              std::memory_order_acquire)) {
+        break;
+      }
+    }
+    b.state.store(READY, std::memory_order_release);
+  }
+};
+
+} // namespace folly
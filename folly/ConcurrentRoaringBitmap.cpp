@@ -0,0 +1,566 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/ConcurrentRoaringBitmap.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+#include <folly/algorithm/simd/Contains.h>
+
+namespace folly {
+
+struct ConcurrentRoaringBitmap::Ops {
+  using Words = std::array<uint64_t, kNumWords>;
+
+  /// Arrays up to this size are searched linearly, with simd::contains.
+  static constexpr size_t kMaxLinearSearch = 64;
+
+  static size_t wordIndex(uint16_t low) { return low / kWordBits; }
+
+  static uint64_t bitMask(uint16_t low) {
+    return uint64_t(1) << (low % kWordBits);
+  }
+
+  static ArrayContainer* asArray(Container* c) {
+    assert(c->kind == Kind::Array);
+    return static_cast<ArrayContainer*>(c);
+  }
+
+  static BitmapContainer* asBitmap(Container* c) {
+    assert(c->kind == Kind::Bitmap);
+    return static_cast<BitmapContainer*>(c);
+  }
+
+  static bool contains(const std::vector<uint16_t>& values, uint16_t low) {
+    if (values.size() <= kMaxLinearSearch) {
+      return simd::contains(values, low);
+    }
+    return std::binary_search(values.begin(), values.end(), low);
+  }
+
+  /// A snapshot of the bits of c, which may be null.
+  static void load(const Container* c, Words& out) {
+    if (!c) {
+      out.fill(0);
+    } else if (c->kind == Kind::Array) {
+      out.fill(0);
+      for (auto v : static_cast<const ArrayContainer*>(c)->values) {
+        out[wordIndex(v)] |= bitMask(v);
+      }
+    } else {
+      auto& words = static_cast<const BitmapContainer*>(c)->words;
+      for (size_t i = 0; i < kNumWords; ++i) {
+        out[i] = words[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  static size_t popcount(const Words& words) {
+    size_t n = 0;
+    for (auto w : words) {
+      n += size_t(folly::popcount(w));
+    }
+    return n;
+  }
+
+  /// A new container holding words, as an array if that is smaller, or
+  /// null if words are all zero.
+  static Container* make(const Words& words) {
+    auto const n = popcount(words);
+    if (n == 0) {
+      return nullptr;
+    }
+    if (n <= kMaxArraySize) {
+      std::vector<uint16_t> values;
+      values.reserve(n);
+      for (size_t i = 0; i < kNumWords; ++i) {
+        for (auto w = words[i]; w; w &= w - 1) {
+          values.push_back(uint16_t(i * kWordBits + findFirstSet(w) - 1));
+        }
+      }
+      return new ArrayContainer(std::move(values));
+    }
+    auto b = new BitmapContainer();
+    for (size_t i = 0; i < kNumWords; ++i) {
+      b->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    return b;
+  }
+
+  static Container* make(std::vector<uint16_t> values) {
+    if (values.empty()) {
+      return nullptr;
+    }
+    if (values.size() <= kMaxArraySize) {
+      return new ArrayContainer(std::move(values));
+    }
+    auto b = new BitmapContainer();
+    for (auto v : values) {
+      b->words[wordIndex(v)].fetch_or(bitMask(v), std::memory_order_relaxed);
+    }
+    return b;
+  }
+
+  /// A new container holding x op y, or null if that is empty.  Either
+  /// may be null.
+  static Container* combine(Op op, const Container* x, const Container* y) {
+    if (!x && !y) {
+      return nullptr;
+    }
+    if (x && y && x->kind == Kind::Array && y->kind == Kind::Array) {
+      auto& xs = static_cast<const ArrayContainer*>(x)->values;
+      auto& ys = static_cast<const ArrayContainer*>(y)->values;
+      std::vector<uint16_t> out;
+      switch (op) {
+        case Op::Or:
+          out.reserve(xs.size() + ys.size());
+          std::set_union(
+              xs.begin(),
+              xs.end(),
+              ys.begin(),
+              ys.end(),
+              std::back_inserter(out));
+          break;
+        case Op::And:
+          out.reserve(std::min(xs.size(), ys.size()));
+          std::set_intersection(
+              xs.begin(),
+              xs.end(),
+              ys.begin(),
+              ys.end(),
+              std::back_inserter(out));
+          break;
+        case Op::AndNot:
+          out.reserve(xs.size());
+          std::set_difference(
+              xs.begin(),
+              xs.end(),
+              ys.begin(),
+              ys.end(),
+              std::back_inserter(out));
+          break;
+      }
+      return make(std::move(out));
+    }
+    // At least one bitmap, or one side missing: work on plain words, in
+    // loops simple enough to be vectorized.
+    Words xw;
+    Words yw;
+    load(x, xw);
+    load(y, yw);
+    switch (op) {
+      case Op::Or:
+        for (size_t i = 0; i < kNumWords; ++i) {
+          xw[i] |= yw[i];
+        }
+        break;
+      case Op::And:
+        for (size_t i = 0; i < kNumWords; ++i) {
+          xw[i] &= yw[i];
+        }
+        break;
+      case Op::AndNot:
+        for (size_t i = 0; i < kNumWords; ++i) {
+          xw[i] &= ~yw[i];
+        }
+        break;
+    }
+    return make(xw);
+  }
+
+  /// Applies slot op= y.  A bitmap in the slot is updated word by word;
+  /// anything else is replaced with a CAS.
+  static void apply(Op op, Slot& slot, const Container* y) {
+    auto c = slot.load(std::memory_order_acquire);
+    while (true) {
+      if (!c && op != Op::Or) {
+        return;
+      }
+      if (c && c->kind == Kind::Bitmap) {
+        applyToBitmap(op, asBitmap(c)->words, y);
+        return;
+      }
+      auto next = combine(op, c, y);
+      if (slot.compare_exchange_strong(
+              c, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        if (c) {
+          retire(c);
+        }
+        return;
+      }
+      if (next) {
+        destroy(next);
+      }
+    }
+  }
+
+  static void applyToBitmap(
+      Op op,
+      std::array<std::atomic<uint64_t>, kNumWords>& words,
+      const Container* y) {
+    if (!y) {
+      if (op == Op::And) {
+        for (auto& w : words) {
+          if (w.load(std::memory_order_relaxed)) {
+            w.fetch_and(0, std::memory_order_acq_rel);
+          }
+        }
+      }
+      return;
+    }
+    Words yw;
+    load(y, yw);
+    for (size_t i = 0; i < kNumWords; ++i) {
+      switch (op) {
+        case Op::Or:
+          if (yw[i] &&
+              (words[i].load(std::memory_order_relaxed) & yw[i]) != yw[i]) {
+            words[i].fetch_or(yw[i], std::memory_order_acq_rel);
+          }
+          break;
+        case Op::And:
+          if (words[i].load(std::memory_order_relaxed) & ~yw[i]) {
+            words[i].fetch_and(yw[i], std::memory_order_acq_rel);
+          }
+          break;
+        case Op::AndNot:
+          if (words[i].load(std::memory_order_relaxed) & yw[i]) {
+            words[i].fetch_and(~yw[i], std::memory_order_acq_rel);
+          }
+          break;
+      }
+    }
+  }
+
+  static size_t count(const Container* c) {
+    if (c->kind == Kind::Array) {
+      return static_cast<const ArrayContainer*>(c)->values.size();
+    }
+    size_t n = 0;
+    for (auto& w : static_cast<const BitmapContainer*>(c)->words) {
+      n += size_t(folly::popcount(w.load(std::memory_order_relaxed)));
+    }
+    return n;
+  }
+
+  static size_t intersectionCount(const Container* x, const Container* y) {
+    if (x->kind == Kind::Bitmap && y->kind == Kind::Array) {
+      std::swap(x, y);
+    }
+    if (x->kind == Kind::Array) {
+      auto& xs = static_cast<const ArrayContainer*>(x)->values;
+      size_t n = 0;
+      if (y->kind == Kind::Array) {
+        auto& ys = static_cast<const ArrayContainer*>(y)->values;
+        auto i = xs.begin();
+        auto j = ys.begin();
+        while (i != xs.end() && j != ys.end()) {
+          if (*i < *j) {
+            ++i;
+          } else if (*j < *i) {
+            ++j;
+          } else {
+            ++n, ++i, ++j;
+          }
+        }
+        return n;
+      }
+      auto& words = static_cast<const BitmapContainer*>(y)->words;
+      for (auto v : xs) {
+        n += (words[wordIndex(v)].load(std::memory_order_relaxed) &
+              bitMask(v)) != 0;
+      }
+      return n;
+    }
+    auto& xw = static_cast<const BitmapContainer*>(x)->words;
+    auto& yw = static_cast<const BitmapContainer*>(y)->words;
+    size_t n = 0;
+    for (size_t i = 0; i < kNumWords; ++i) {
+      n += size_t(folly::popcount(
+          xw[i].load(std::memory_order_relaxed) &
+          yw[i].load(std::memory_order_relaxed)));
+    }
+    return n;
+  }
+};
+
+ConcurrentRoaringBitmap::ConcurrentRoaringBitmap(
+    ConcurrentRoaringBitmap&& other) noexcept {
+  *this = std::move(other);
+}
+
+ConcurrentRoaringBitmap& ConcurrentRoaringBitmap::operator=(
+    ConcurrentRoaringBitmap&& other) noexcept {
+  if (this != &other) {
+    for (size_t p = 0; p < kNumPages; ++p) {
+      auto page = pages_[p].load(std::memory_order_relaxed);
+      pages_[p].store(
+          other.pages_[p].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      other.pages_[p].store(page, std::memory_order_relaxed);
+    }
+  }
+  return *this;
+}
+
+ConcurrentRoaringBitmap::~ConcurrentRoaringBitmap() {
+  forEachSlot([](size_t, Container* c) { destroy(c); });
+  for (auto& page : pages_) {
+    delete page.load(std::memory_order_relaxed);
+  }
+}
+
+void ConcurrentRoaringBitmap::destroy(Container* c) {
+  if (c->kind == Kind::Array) {
+    delete Ops::asArray(c);
+  } else {
+    delete Ops::asBitmap(c);
+  }
+}
+
+void ConcurrentRoaringBitmap::retire(Container* c) {
+  // bitmap containers are never replaced, see the class comment
+  Ops::asArray(c)->retire();
+}
+
+auto ConcurrentRoaringBitmap::findSlot(size_t chunk) const -> Slot* {
+  auto page = pages_[chunk >> kPageBits].load(std::memory_order_acquire);
+  return page ? &page->slots[chunk & (kPageSize - 1)] : nullptr;
+}
+
+auto ConcurrentRoaringBitmap::getSlot(size_t chunk) -> Slot& {
+  auto& pageRef = pages_[chunk >> kPageBits];
+  auto page = pageRef.load(std::memory_order_acquire);
+  if (!page) {
+    auto fresh = new Page();
+    if (pageRef.compare_exchange_strong(
+            page,
+            fresh,
+            std::memory_order_acq_rel,
+            std::memory_order_acquire)) {
+      page = fresh;
+    } else {
+      delete fresh;
+    }
+  }
+  return page->slots[chunk & (kPageSize - 1)];
+}
+
+bool ConcurrentRoaringBitmap::set(uint32_t idx) {
+  auto const low = uint16_t(idx);
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  auto& slot = getSlot(idx >> kChunkBits);
+  auto c = slot.load(std::memory_order_acquire);
+  while (true) {
+    if (c && c->kind == Kind::Bitmap) {
+      auto const mask = Ops::bitMask(low);
+      return Ops::asBitmap(c)->words[Ops::wordIndex(low)].fetch_or(
+                 mask, std::memory_order_acq_rel) &
+          mask;
+    }
+    std::vector<uint16_t> values;
+    if (c) {
+      auto& old = Ops::asArray(c)->values;
+      auto it = std::lower_bound(old.begin(), old.end(), low);
+      if (it != old.end() && *it == low) {
+        return true;
+      }
+      values.reserve(old.size() + 1);
+      values.insert(values.end(), old.begin(), it);
+      values.push_back(low);
+      values.insert(values.end(), it, old.end());
+    } else {
+      values.push_back(low);
+    }
+    auto next = Ops::make(std::move(values));
+    if (slot.compare_exchange_strong(
+            c, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      if (c) {
+        retire(c);
+      }
+      return false;
+    }
+    destroy(next);
+  }
+}
+
+bool ConcurrentRoaringBitmap::reset(uint32_t idx) {
+  auto const low = uint16_t(idx);
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  auto slot = findSlot(idx >> kChunkBits);
+  if (!slot) {
+    return false;
+  }
+  auto c = slot->load(std::memory_order_acquire);
+  while (c) {
+    if (c->kind == Kind::Bitmap) {
+      auto const mask = Ops::bitMask(low);
+      return Ops::asBitmap(c)->words[Ops::wordIndex(low)].fetch_and(
+                 ~mask, std::memory_order_acq_rel) &
+          mask;
+    }
+    auto& old = Ops::asArray(c)->values;
+    auto it = std::lower_bound(old.begin(), old.end(), low);
+    if (it == old.end() || *it != low) {
+      return false;
+    }
+    std::vector<uint16_t> values;
+    values.reserve(old.size() - 1);
+    values.insert(values.end(), old.begin(), it);
+    values.insert(values.end(), it + 1, old.end());
+    auto next = Ops::make(std::move(values));
+    if (slot->compare_exchange_strong(
+            c, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      retire(c);
+      return true;
+    }
+    if (next) {
+      destroy(next);
+    }
+  }
+  return false;
+}
+
+bool ConcurrentRoaringBitmap::test(uint32_t idx) const {
+  auto const low = uint16_t(idx);
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  auto slot = findSlot(idx >> kChunkBits);
+  auto c = slot ? slot->load(std::memory_order_acquire) : nullptr;
+  if (!c) {
+    return false;
+  }
+  if (c->kind == Kind::Bitmap) {
+    return Ops::asBitmap(c)->words[Ops::wordIndex(low)].load(
+               std::memory_order_acquire) &
+        Ops::bitMask(low);
+  }
+  return Ops::contains(Ops::asArray(c)->values, low);
+}
+
+size_t ConcurrentRoaringBitmap::count() const {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  size_t n = 0;
+  forEachSlot([&](size_t, Container* c) { n += Ops::count(c); });
+  return n;
+}
+
+bool ConcurrentRoaringBitmap::none() const {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  bool any = false;
+  // arrays are never empty, but bitmaps may be
+  forEachSlot([&](size_t, Container* c) {
+    any = any || c->kind == Kind::Array || Ops::count(c) != 0;
+  });
+  return !any;
+}
+
+void ConcurrentRoaringBitmap::clear() {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  for (size_t p = 0; p < kNumPages; ++p) {
+    auto page = pages_[p].load(std::memory_order_acquire);
+    if (page) {
+      for (auto& slot : page->slots) {
+        Ops::apply(Op::And, slot, nullptr);
+      }
+    }
+  }
+}
+
+ConcurrentRoaringBitmap& ConcurrentRoaringBitmap::operator|=(
+    const ConcurrentRoaringBitmap& other) {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  other.forEachSlot([&](size_t chunk, Container* y) {
+    Ops::apply(Op::Or, getSlot(chunk), y);
+  });
+  return *this;
+}
+
+ConcurrentRoaringBitmap& ConcurrentRoaringBitmap::operator&=(
+    const ConcurrentRoaringBitmap& other) {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  for (size_t p = 0; p < kNumPages; ++p) {
+    auto page = pages_[p].load(std::memory_order_acquire);
+    if (!page) {
+      continue;
+    }
+    for (size_t s = 0; s < kPageSize; ++s) {
+      auto otherSlot = other.findSlot((p << kPageBits) | s);
+      auto y =
+          otherSlot ? otherSlot->load(std::memory_order_acquire) : nullptr;
+      Ops::apply(Op::And, page->slots[s], y);
+    }
+  }
+  return *this;
+}
+
+ConcurrentRoaringBitmap& ConcurrentRoaringBitmap::operator-=(
+    const ConcurrentRoaringBitmap& other) {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  other.forEachSlot([&](size_t chunk, Container* y) {
+    if (auto slot = findSlot(chunk)) {
+      Ops::apply(Op::AndNot, *slot, y);
+    }
+  });
+  return *this;
+}
+
+ConcurrentRoaringBitmap ConcurrentRoaringBitmap::combine(
+    Op op,
+    const ConcurrentRoaringBitmap& a,
+    const ConcurrentRoaringBitmap& b) {
+  ConcurrentRoaringBitmap res;
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  auto add = [&](size_t chunk, const Container* x, const Container* y) {
+    if (auto c = Ops::combine(op, x, y)) {
+      res.getSlot(chunk).store(c, std::memory_order_relaxed);
+    }
+  };
+  auto load = [](const ConcurrentRoaringBitmap& m, size_t chunk) {
+    auto slot = m.findSlot(chunk);
+    return slot ? slot->load(std::memory_order_acquire) : nullptr;
+  };
+  // the chunks of a, then those only in b
+  a.forEachSlot(
+      [&](size_t chunk, Container* x) { add(chunk, x, load(b, chunk)); });
+  if (op == Op::Or) {
+    b.forEachSlot([&](size_t chunk, Container* y) {
+      if (!load(a, chunk)) {
+        add(chunk, nullptr, y);
+      }
+    });
+  }
+  return res;
+}
+
+size_t intersectionCount(
+    const ConcurrentRoaringBitmap& a, const ConcurrentRoaringBitmap& b) {
+  using Container = ConcurrentRoaringBitmap::Container;
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  size_t n = 0;
+  a.forEachSlot([&](size_t chunk, Container* x) {
+    auto slot = b.findSlot(chunk);
+    auto y = slot ? slot->load(std::memory_order_acquire) : nullptr;
+    if (y) {
+      n += ConcurrentRoaringBitmap::Ops::intersectionCount(x, y);
+    }
+  });
+  return n;
+}
+
+} // namespace folly
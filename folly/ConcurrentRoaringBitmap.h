@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <folly/lang/Bits.h>
+#include <folly/synchronization/Rcu.h>
+
+namespace folly {
+
+/**
+ * A compressed bitmap over the uint32_t universe, safe for concurrent use.
+ *
+ * The layout follows Roaring bitmaps (Chambi, Lemire et al.): the universe
+ * is split into chunks of 2^16 values, keyed by the high 16 bits, and each
+ * non-empty chunk is stored in one of two containers:
+ *
+ *  - an array container: the sorted low 16 bits of up to 4096 values,
+ *  - a bitmap container: 2^16 bits in 1024 words.
+ *
+ * so a sparse bitmap costs about two bytes per value and a dense one at most
+ * a bit per value, and empty chunks cost nothing.
+ *
+ * Like ConcurrentBitSet, single bit updates are atomic and return the
+ * previous value of the bit.  A bit in a bitmap container is updated in
+ * place with fetch_or or fetch_and.  Array containers are immutable: an
+ * update installs a new container with a CAS, and the old one is reclaimed
+ * through RCU, so readers never block.  An array that would outgrow 4096
+ * values becomes a bitmap.  Bitmap containers are never replaced, so an
+ * update to one is never lost to a concurrent replacement; as a result a
+ * chunk that was dense once keeps its bitmap container even if it empties.
+ *
+ * The bulk operations (|=, &=, -=, and the |, &, - that return a new
+ * bitmap) work chunk by chunk, and may run in parallel with each other and
+ * with single bit updates, on the same bitmaps or not.  They are atomic for
+ * each bit, but not as a whole: a bit that is updated concurrently may or
+ * may not be reflected in the result.  count(), intersectionCount() and
+ * forEach() are similarly consistent for each bit.
+ *
+ * Container pairs with at least one bitmap are combined on plain 64-bit
+ * word arrays, which the compiler vectorizes; membership tests on small
+ * array containers use simd::contains.
+ */
+class ConcurrentRoaringBitmap {
+ public:
+  /**
+   * Construct an empty bitmap.
+   */
+  ConcurrentRoaringBitmap() = default;
+
+  ConcurrentRoaringBitmap(const ConcurrentRoaringBitmap&) = delete;
+  ConcurrentRoaringBitmap& operator=(const ConcurrentRoaringBitmap&) = delete;
+
+  /**
+   * Moves are not thread-safe: nothing may use either bitmap concurrently.
+   */
+  ConcurrentRoaringBitmap(ConcurrentRoaringBitmap&& other) noexcept;
+  ConcurrentRoaringBitmap& operator=(ConcurrentRoaringBitmap&& other) noexcept;
+
+  ~ConcurrentRoaringBitmap();
+
+  /**
+   * Set bit idx to true. Returns the previous value of the bit.
+   */
+  bool set(uint32_t idx);
+
+  /**
+   * Set bit idx to false. Returns the previous value of the bit.
+   */
+  bool reset(uint32_t idx);
+
+  /**
+   * Set bit idx to the given value. Returns the previous value of the bit.
+   */
+  bool set(uint32_t idx, bool value) { return value ? set(idx) : reset(idx); }
+
+  /**
+   * Read bit idx.
+   */
+  bool test(uint32_t idx) const;
+
+  /**
+   * Same as test().
+   */
+  bool operator[](uint32_t idx) const { return test(idx); }
+
+  /**
+   * The number of bits that are set.
+   */
+  size_t count() const;
+
+  /**
+   * Whether no bit is set.
+   */
+  bool none() const;
+
+  /**
+   * Reset all bits.
+   */
+  void clear();
+
+  /**
+   * Set every bit that is set in other.
+   */
+  ConcurrentRoaringBitmap& operator|=(const ConcurrentRoaringBitmap& other);
+
+  /**
+   * Reset every bit that is not set in other.
+   */
+  ConcurrentRoaringBitmap& operator&=(const ConcurrentRoaringBitmap& other);
+
+  /**
+   * Reset every bit that is set in other (and-not).
+   */
+  ConcurrentRoaringBitmap& operator-=(const ConcurrentRoaringBitmap& other);
+
+  friend ConcurrentRoaringBitmap operator|(
+      const ConcurrentRoaringBitmap& a, const ConcurrentRoaringBitmap& b) {
+    return combine(Op::Or, a, b);
+  }
+  friend ConcurrentRoaringBitmap operator&(
+      const ConcurrentRoaringBitmap& a, const ConcurrentRoaringBitmap& b) {
+    return combine(Op::And, a, b);
+  }
+  friend ConcurrentRoaringBitmap operator-(
+      const ConcurrentRoaringBitmap& a, const ConcurrentRoaringBitmap& b) {
+    return combine(Op::AndNot, a, b);
+  }
+
+  /**
+   * The number of bits set in both a and b, without materializing a & b.
+   */
+  friend size_t intersectionCount(
+      const ConcurrentRoaringBitmap& a, const ConcurrentRoaringBitmap& b);
+
+  /**
+   * Calls f(idx) for every set bit, in increasing order.
+   *
+   * f runs in an RCU read-side critical section, so it must not wait for
+   * RCU (for example by calling rcu_synchronize()).
+   */
+  template <typename F>
+  void forEach(F&& f) const;
+
+ private:
+  enum class Op { Or, And, AndNot };
+
+  // the container algorithms, defined in the .cpp
+  struct Ops;
+
+  static constexpr size_t kChunkBits = 16;
+  static constexpr size_t kPageBits = 8;
+  static constexpr size_t kNumPages = size_t(1) << (kChunkBits - kPageBits);
+  static constexpr size_t kPageSize = size_t(1) << kPageBits;
+  static constexpr size_t kWordBits = 64;
+  static constexpr size_t kNumWords = (size_t(1) << kChunkBits) / kWordBits;
+
+  /**
+   * Arrays hold at most this many values, the point at which a bitmap
+   * container (8KB) becomes smaller.
+   */
+  static constexpr size_t kMaxArraySize = 4096;
+
+  enum class Kind : uint8_t { Array, Bitmap };
+
+  struct Container {
+    explicit Container(Kind k) : kind(k) {}
+    Kind kind;
+  };
+
+  struct ArrayContainer : Container, rcu_obj_base<ArrayContainer> {
+    explicit ArrayContainer(std::vector<uint16_t> v)
+        : Container(Kind::Array), values(std::move(v)) {}
+    std::vector<uint16_t> values;
+  };
+
+  struct BitmapContainer : Container {
+    BitmapContainer() : Container(Kind::Bitmap) {}
+    std::array<std::atomic<uint64_t>, kNumWords> words{};
+  };
+
+  using Slot = std::atomic<Container*>;
+
+  struct Page {
+    std::array<Slot, kPageSize> slots{};
+  };
+
+  std::array<std::atomic<Page*>, kNumPages> pages_{};
+
+  Slot* findSlot(size_t chunk) const;
+  Slot& getSlot(size_t chunk);
+
+  template <typename F>
+  void forEachSlot(F&& f) const;
+
+  static void destroy(Container* c);
+  static void retire(Container* c);
+
+  static ConcurrentRoaringBitmap combine(
+      Op op,
+      const ConcurrentRoaringBitmap& a,
+      const ConcurrentRoaringBitmap& b);
+};
+
+template <typename F>
+void ConcurrentRoaringBitmap::forEachSlot(F&& f) const {
+  for (size_t p = 0; p < kNumPages; ++p) {
+    auto page = pages_[p].load(std::memory_order_acquire);
+    if (!page) {
+      continue;
+    }
+    for (size_t s = 0; s < kPageSize; ++s) {
+      auto c = page->slots[s].load(std::memory_order_acquire);
+      if (c) {
+        f((p << kPageBits) | s, c);
+      }
+    }
+  }
+}
+
+template <typename F>
+void ConcurrentRoaringBitmap::forEach(F&& f) const {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  forEachSlot([&](size_t chunk, Container* c) {
+    auto const base = uint32_t(chunk << kChunkBits);
+    if (c->kind == Kind::Array) {
+      for (auto v : static_cast<ArrayContainer*>(c)->values) {
+        f(base | v);
+      }
+      return;
+    }
+    auto& words = static_cast<BitmapContainer*>(c)->words;
+    for (size_t i = 0; i < kNumWords; ++i) {
+      auto w = words[i].load(std::memory_order_relaxed);
+      while (w) {
+        f(base | uint32_t(i * kWordBits + findFirstSet(w) - 1));
+        w &= w - 1;
+      }
+    }
+  });
+}
+
+} // namespace folly
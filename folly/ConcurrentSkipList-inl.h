@@ -39,6 +39,9 @@ namespace detail {
 template <typename ValT, typename NodeT>
 class csl_iterator;
 
+template <typename ValT, typename NodeT, typename Comp>
+class csl_bounded_iterator;
+
 template <typename T>
 class SkipListNode {
   enum : uint16_t {
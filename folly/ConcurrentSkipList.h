@@ -113,6 +113,21 @@ Sample usage:
        ...  ...
        // GC may happen when the accessor gets destructed.
      }
+
+ Sorted runs can be loaded with the range form of insert(), which
+ starts the search for each element from where the previous one was
+ linked instead of from the head.  A [lo, hi) scan is done with
+ range(), which stops at the first element not less than hi and
+ prefetches the next node while the current one is visited.
+
+     {
+       SkipListT::Accessor accessor(sl);
+       std::vector<int> run = {3, 5, 8, 13};
+       accessor.insert(run.begin(), run.end());
+       for (auto& elem : accessor.range(4, 13)) {
+         // visits 5 and 8
+       }
+     }
 */
 
 #pragma once
@@ -160,6 +175,7 @@ class ConcurrentSkipList {
 
   class Accessor;
   class Skipper;
+  class BoundedRange;
 
   explicit ConcurrentSkipList(int height, const NodeAlloc& alloc)
       : recycler_(alloc),
@@ -357,6 +373,83 @@ class ConcurrentSkipList {
     return std::make_pair(newNode, newSize);
   }
 
+  // Adds the elements of [first, last), and returns the number added.
+  // While the input is increasing, the search for an element starts from
+  // the predecessors of the previous one, at the lowest layer whose
+  // successor is not less than the element, so a sorted run costs about
+  // one step per element. Otherwise, and whenever the cached path turns
+  // out to be stale, it falls back to a search from the head.
+  template <typename InputIt>
+  size_t addRange(InputIt first, InputIt last) {
+    NodeType *preds[MAX_HEIGHT], *succs[MAX_HEIGHT];
+    NodeType* prev = nullptr; // the node of the previous element
+    int max_layer = 0;
+    size_t added = 0;
+    for (; first != last; ++first) {
+      auto&& data = *first;
+      size_t newSize = 0;
+      while (true) {
+        int layer;
+        if (prev != nullptr && Comp()(prev->data(), data)) {
+          int lyr = 0;
+          while (lyr < max_layer && greater(data, succs[lyr])) {
+            ++lyr;
+          }
+          layer = findInsertionPoint(preds[lyr], lyr, data, preds, succs);
+        } else {
+          layer = findInsertionPointGetMaxLayer(data, preds, succs, &max_layer);
+        }
+
+        if (layer >= 0) {
+          NodeType* nodeFound = succs[layer];
+          DCHECK(nodeFound != nullptr);
+          if (nodeFound->markedForRemoval()) {
+            prev = nullptr;
+            continue;
+          }
+          while (FOLLY_UNLIKELY(!nodeFound->fullyLinked())) {
+          }
+          prev = nodeFound;
+          break;
+        }
+
+        int nodeHeight =
+            detail::SkipListRandomHeight::instance()->getHeight(max_layer + 1);
+
+        ScopedLocker guards[MAX_HEIGHT];
+        if (!lockNodesForChange(nodeHeight, guards, preds, succs)) {
+          prev = nullptr;
+          continue;
+        }
+
+        NodeType* newNode = NodeType::create(
+            recycler_.alloc(), nodeHeight, std::forward<decltype(data)>(data));
+        for (int k = 0; k < nodeHeight; ++k) {
+          newNode->setSkip(k, succs[k]);
+          preds[k]->setSkip(k, newNode);
+          preds[k] = newNode;
+        }
+
+        newNode->setFullyLinked();
+        newSize = incrementSize(1);
+        prev = newNode;
+        ++added;
+        break;
+      }
+
+      if (newSize > 0) {
+        int hgt = height();
+        size_t sizeLimit =
+            detail::SkipListRandomHeight::instance()->getSizeLimit(hgt);
+        if (hgt < MAX_HEIGHT && newSize > sizeLimit) {
+          growHeight(hgt + 1);
+          prev = nullptr; // pick up the new head and its height
+        }
+      }
+    }
+    return added;
+  }
+
   bool remove(const value_type& data) {
     NodeType* nodeToDelete = nullptr;
     ScopedLocker nodeGuard;
@@ -615,10 +708,25 @@ class ConcurrentSkipList<T, Comp, NodeAlloc, MAX_HEIGHT>::Accessor {
   }
   size_t erase(const key_type& data) { return remove(data); }
 
+  // Inserts the elements of [first, last), skipping the ones already in
+  // the list, and returns the number inserted. Sorted input is the fast
+  // case: see the class comment.
+  template <typename InputIt>
+  size_t insert(InputIt first, InputIt last) {
+    return sl_->addRange(first, last);
+  }
+
   iterator lower_bound(const key_type& data) const {
     return iterator(sl_->lower_bound(data));
   }
 
+  // Returns the elements in [lo, hi), in order. The range holds its own
+  // Accessor, so the nodes it visits stay valid while it is alive. As
+  // with the other iterators, concurrent changes may or may not be seen.
+  BoundedRange range(const key_type& lo, const key_type& hi) const {
+    return BoundedRange(*this, lo, hi);
+  }
+
   size_t height() const { return sl_->height(); }
 
   // first() returns pointer to the first element in the skiplist, or
@@ -708,6 +816,62 @@ class detail::csl_iterator
   NodeT* node_;
 };
 
+// A forward iterator over the elements less than a bound, which ends
+// (compares equal to the default constructed iterator) at the first
+// element that is not. The next node is prefetched while the current one
+// is visited, as a scan would otherwise wait on one miss per node.
+template <typename ValT, typename NodeT, typename Comp>
+class detail::csl_bounded_iterator
+    : public detail::IteratorFacade<
+          csl_bounded_iterator<ValT, NodeT, Comp>,
+          const ValT,
+          std::forward_iterator_tag> {
+ public:
+  typedef const ValT value_type;
+  typedef value_type& reference;
+  typedef value_type* pointer;
+  typedef ptrdiff_t difference_type;
+
+  csl_bounded_iterator() : node_(nullptr), hi_(nullptr) {}
+
+  csl_bounded_iterator(NodeT* node, const ValT* hi) : node_(node), hi_(hi) {
+    check();
+  }
+
+  bool good() const { return node_ != nullptr; }
+
+ private:
+  friend class detail::IteratorFacade<
+      csl_bounded_iterator,
+      const ValT,
+      std::forward_iterator_tag>;
+
+  void check() {
+    if (node_ == nullptr) {
+      return;
+    }
+    if (!Comp()(node_->data(), *hi_)) {
+      node_ = nullptr;
+      return;
+    }
+#ifndef _WIN32
+    __builtin_prefetch(node_->skip(0));
+#endif
+  }
+
+  void increment() {
+    node_ = node_->next();
+    check();
+  }
+  bool equal(const csl_bounded_iterator& other) const {
+    return node_ == other.node_;
+  }
+  value_type& dereference() const { return node_->data(); }
+
+  NodeT* node_;
+  const ValT* hi_;
+};
+
 // Skipper interface
 template <typename T, typename Comp, typename NodeAlloc, int MAX_HEIGHT>
 class ConcurrentSkipList<T, Comp, NodeAlloc, MAX_HEIGHT>::Skipper {
@@ -825,4 +989,38 @@ class ConcurrentSkipList<T, Comp, NodeAlloc, MAX_HEIGHT>::Skipper {
   uint8_t hints_[MAX_HEIGHT];
 };
 
+// The elements in [lo, hi), see Accessor::range(). Its iterators point
+// to the bound stored in the range, so it can't be copied or moved.
+template <typename T, typename Comp, typename NodeAlloc, int MAX_HEIGHT>
+class ConcurrentSkipList<T, Comp, NodeAlloc, MAX_HEIGHT>::BoundedRange {
+  typedef detail::SkipListNode<T> NodeType;
+  typedef ConcurrentSkipList<T, Comp, NodeAlloc, MAX_HEIGHT> SkipListType;
+  typedef typename SkipListType::Accessor Accessor;
+
+ public:
+  typedef T value_type;
+  typedef detail::csl_bounded_iterator<T, NodeType, Comp> iterator;
+  typedef iterator const_iterator;
+
+  BoundedRange(const Accessor& accessor, const T& lo, const T& hi)
+      : accessor_(accessor),
+        hi_(hi),
+        first_(accessor.skiplist()->lower_bound(lo)) {}
+
+  BoundedRange(const BoundedRange&) = delete;
+  BoundedRange& operator=(const BoundedRange&) = delete;
+
+  iterator begin() const { return iterator(first_, &hi_); }
+  iterator end() const { return iterator(); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return begin() == end(); }
+
+ private:
+  Accessor accessor_;
+  T hi_;
+  NodeType* first_;
+};
+
 } // namespace folly
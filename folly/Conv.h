@@ -75,6 +75,10 @@
  * parse out a type from the beginning of a string, and modify the passed-in
  * StringPiece to indicate the portion of the string not consumed.
  *
+ * Columns of numbers convert faster in batches: `tryToBatch<T>` converts a
+ * range of strings, or the delimited fields of one string, into a range of
+ * T, and `toAppendDelimBatch` formats a range of numbers.
+ *
  *******************************************************************************
  * ## NUMERIC / ENUM CONVERSIONS
  *******************************************************************************
@@ -114,6 +118,7 @@
 #include <climits>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <limits>
 #include <optional>
 #include <stdexcept>
@@ -140,6 +145,7 @@
 #include <folly/Traits.h>
 #include <folly/Unit.h>
 #include <folly/Utility.h>
+#include <folly/lang/Bits.h>
 #include <folly/lang/Exception.h>
 #include <folly/lang/Pretty.h>
 #include <folly/lang/ToAscii.h>
@@ -750,33 +756,34 @@ constexpr double_conversion::DoubleToStringConverter::Flags convert(
 }
 } // namespace detail
 
-/**
- * `numDigits` is only used with `FIXED` && `PRECISION`.
- */
-template <class Tgt, class Src>
-typename std::enable_if<
-    std::is_floating_point<Src>::value && IsSomeString<Tgt>::value>::type
-toAppend(
+namespace detail {
+/// Large enough for the output of any floatingToChars call.
+constexpr size_t kFloatingToCharsBufferSize = 256;
+
+/// Writes value to buffer, which must hold kFloatingToCharsBufferSize
+/// characters, as toAppend(value, &str, mode, numDigits, flags) appends it to
+/// str, and returns the number of characters written.
+template <class Src>
+typename std::enable_if<std::is_floating_point<Src>::value, size_t>::type
+floatingToChars(
+    char* buffer,
     Src value,
-    Tgt* result,
     DtoaMode mode,
     unsigned int numDigits,
-    DtoaFlags flags = DtoaFlags::NO_FLAGS) {
-  double_conversion::DoubleToStringConverter::Flags dcFlags =
-      detail::convert(flags);
+    DtoaFlags flags) {
+  double_conversion::DoubleToStringConverter::Flags dcFlags = convert(flags);
   double_conversion::DoubleToStringConverter conv(
       dcFlags,
       "Infinity",
       "NaN",
       'E',
-      detail::kConvMaxDecimalInShortestLow,
-      detail::kConvMaxDecimalInShortestHigh,
+      kConvMaxDecimalInShortestLow,
+      kConvMaxDecimalInShortestHigh,
       6, // max leading padding zeros
       1); // max trailing padding zeros
-  char buffer[256];
-  double_conversion::StringBuilder builder(buffer, sizeof(buffer));
-  double_conversion::DoubleToStringConverter::DtoaMode dcMode =
-      detail::convert(mode);
+  double_conversion::StringBuilder builder(
+      buffer, int(kFloatingToCharsBufferSize));
+  double_conversion::DoubleToStringConverter::DtoaMode dcMode = convert(mode);
   FOLLY_PUSH_WARNING
   FOLLY_CLANG_DISABLE_WARNING("-Wcovered-switch-default")
   switch (dcMode) {
@@ -798,7 +805,25 @@ toAppend(
   FOLLY_POP_WARNING
   const size_t length = size_t(builder.position());
   builder.Finalize();
-  result->append(buffer, length);
+  return length;
+}
+} // namespace detail
+
+/**
+ * `numDigits` is only used with `FIXED` && `PRECISION`.
+ */
+template <class Tgt, class Src>
+typename std::enable_if<
+    std::is_floating_point<Src>::value && IsSomeString<Tgt>::value>::type
+toAppend(
+    Src value,
+    Tgt* result,
+    DtoaMode mode,
+    unsigned int numDigits,
+    DtoaFlags flags = DtoaFlags::NO_FLAGS) {
+  char buffer[detail::kFloatingToCharsBufferSize];
+  result->append(
+      buffer, detail::floatingToChars(buffer, value, mode, numDigits, flags));
 }
 
 /**
@@ -1711,6 +1736,274 @@ Tgt to(StringPiece* src) {
           [=](Error e) { return makeConversionError(e, *src); });
 }
 
+/**
+ * Batch conversions from strings to arithmetic types, for columns of
+ * numbers.
+ *
+ * tryToBatch<Tgt>(src, out) converts src[i] into out[i], as
+ * tryTo<Tgt>(src[i]) would, for the first min(src.size(), out.size())
+ * strings of src, and stops at the first one that does not convert.
+ *
+ * tryToBatch<Tgt>(&src, delim, out) does the same with the fields of src
+ * separated by delim, such as a line of a CSV file, without splitting it
+ * first. It converts up to out.size() fields, and leaves src at the fields
+ * that are left, or at the one that did not convert. An empty src has no
+ * fields; a trailing delimiter ends in an empty field.
+ *
+ * Integers written the common way, an optional '-' and up to 19 digits, are
+ * validated and converted 8 bytes at a time; other forms take the path of
+ * tryTo(), and get the same results and errors.
+ */
+struct ConversionBatchResult {
+  /// The number of values converted.
+  size_t count{0};
+  /// SUCCESS, or why the value after them did not convert.
+  ConversionCode code{ConversionCode::SUCCESS};
+
+  explicit operator bool() const noexcept {
+    return code == ConversionCode::SUCCESS;
+  }
+};
+
+namespace detail {
+
+template <class Tgt>
+constexpr bool is_batch_target_v = std::is_floating_point<Tgt>::value ||
+    (is_integral_v<Tgt> && !std::is_same<Tgt, bool>::value &&
+     sizeof(Tgt) <= sizeof(uint64_t));
+
+// 0x80 in each byte of chunk, of 8 characters with the first in the lowest
+// byte, that is not an ASCII digit. The bytes after the first non-digit may
+// be wrong, as carries and borrows only propagate upwards.
+inline uint64_t nonDigitBytes(uint64_t chunk) noexcept {
+  return ((chunk + 0x4646464646464646) | (chunk - 0x3030303030303030)) &
+      0x8080808080808080;
+}
+
+// The value of the 8 digits of chunk, the first in the lowest byte.
+inline uint64_t eightDigitsValue(uint64_t chunk) noexcept {
+  constexpr uint64_t kMask = 0x000000FF000000FF;
+  constexpr uint64_t kMul1 = 100 + (1000000ULL << 32);
+  constexpr uint64_t kMul2 = 1 + (10000ULL << 32);
+  chunk -= 0x3030303030303030;
+  chunk = (chunk * 10) + (chunk >> 8);
+  return (((chunk & kMask) * kMul1) + (((chunk >> 16) & kMask) * kMul2)) >>
+      32;
+}
+
+constexpr uint64_t kBatchPowersOf10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+// Converts the integer that starts at p and ends at e, or, if Delimited, at
+// delim, and moves p to its end. Returns false, leaving p alone, for input
+// that tryTo() must handle.
+template <class Tgt, bool Delimited>
+bool tryToBatchFast(
+    const char*& p, const char* e, char delim, Tgt& out) noexcept {
+  using UT = make_unsigned_t<Tgt>;
+  auto b = p;
+  bool negative = false;
+  if (is_signed_v<Tgt> && b != e && *b == '-') {
+    negative = true;
+    ++b;
+  }
+  uint64_t value = 0;
+  size_t digits = 0;
+  if (kIsLittleEndian) {
+    while (e - b >= 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, b, sizeof(chunk));
+      auto nonDigits = nonDigitBytes(chunk);
+      size_t n = nonDigits ? (findFirstSet(nonDigits) - 1) / 8 : 8;
+      if (n == 0) {
+        break;
+      }
+      if (FOLLY_UNLIKELY(digits + n > 19)) {
+        return false;
+      }
+      if (n < 8) {
+        // Shift the digits to the end, after '0's.
+        chunk = (chunk << (8 * (8 - n))) | (0x3030303030303030 >> (8 * n));
+      }
+      value = value * kBatchPowersOf10[n] + eightDigitsValue(chunk);
+      digits += n;
+      b += n;
+      if (n < 8) {
+        break;
+      }
+    }
+  }
+  for (; b != e && static_cast<unsigned char>(*b - '0') < 10; ++b) {
+    if (FOLLY_UNLIKELY(++digits > 19)) {
+      return false;
+    }
+    value = value * 10 + static_cast<unsigned char>(*b - '0');
+  }
+  if (digits == 0 || (b != e && (!Delimited || *b != delim))) {
+    return false;
+  }
+  if (negative) {
+    if (value > uint64_t(UT(std::numeric_limits<Tgt>::max())) + 1) {
+      return false;
+    }
+    out = static_cast<Tgt>(UT(UT(0) - UT(value)));
+  } else {
+    if (value > uint64_t(std::numeric_limits<Tgt>::max())) {
+      return false;
+    }
+    out = static_cast<Tgt>(value);
+  }
+  p = b;
+  return true;
+}
+
+} // namespace detail
+
+template <class Tgt>
+typename std::enable_if<
+    detail::is_batch_target_v<Tgt>,
+    ConversionBatchResult>::type
+tryToBatch(Range<const StringPiece*> src, Range<Tgt*> out) noexcept {
+  ConversionBatchResult ret;
+  auto n = std::min(src.size(), out.size());
+  for (; ret.count < n; ++ret.count) {
+    auto field = src[ret.count];
+    auto p = field.begin();
+    if constexpr (is_integral_v<Tgt>) {
+      if (detail::tryToBatchFast<Tgt, false>(
+              p, field.end(), '\0', out[ret.count])) {
+        continue;
+      }
+    }
+    auto value = tryTo<Tgt>(field);
+    if (FOLLY_UNLIKELY(!value)) {
+      ret.code = value.error();
+      break;
+    }
+    out[ret.count] = *value;
+  }
+  return ret;
+}
+
+template <class Tgt>
+typename std::enable_if<
+    detail::is_batch_target_v<Tgt>,
+    ConversionBatchResult>::type
+tryToBatch(StringPiece* src, char delim, Range<Tgt*> out) noexcept {
+  ConversionBatchResult ret;
+  auto b = src->begin();
+  auto e = src->end();
+  // Digits and signs delimit nothing the fast path would see.
+  bool fast = is_integral_v<Tgt> && (delim < '0' || delim > '9') &&
+      delim != '-';
+  while (b != e && ret.count < out.size()) {
+    auto p = b;
+    bool converted = false;
+    if constexpr (is_integral_v<Tgt>) {
+      converted = fast &&
+          detail::tryToBatchFast<Tgt, true>(p, e, delim, out[ret.count]);
+    }
+    if (!converted) {
+      p = static_cast<const char*>(std::memchr(b, delim, size_t(e - b)));
+      if (!p) {
+        p = e;
+      }
+      auto value = tryTo<Tgt>(StringPiece(b, p));
+      if (FOLLY_UNLIKELY(!value)) {
+        ret.code = value.error();
+        break;
+      }
+      out[ret.count] = *value;
+    }
+    ++ret.count;
+    if (p == e) {
+      b = e;
+      break;
+    }
+    b = p + 1;
+    if (b == e && ret.count < out.size()) {
+      // A trailing delimiter, before an empty field.
+      ret.code = ConversionCode::EMPTY_INPUT_STRING;
+      break;
+    }
+  }
+  src->assign(b, e);
+  return ret;
+}
+
+/**
+ * Like tryToBatch(src, out), but throws a ConversionError for the first
+ * string that does not convert.
+ */
+template <class Tgt>
+typename std::enable_if<detail::is_batch_target_v<Tgt>>::type toBatch(
+    Range<const StringPiece*> src, Range<Tgt*> out) {
+  auto ret = tryToBatch(src, out);
+  if (FOLLY_UNLIKELY(!ret)) {
+    throw_exception(makeConversionError(ret.code, src[ret.count]));
+  }
+}
+
+/**
+ * Appends the values of src to *result, separated by delim, as
+ * toAppendDelim(delim, src[0], src[1], ..., result) would. The values are
+ * written into a buffer that they share, which is appended to result a few
+ * kilobytes at a time.
+ */
+template <class Delimiter, class Src, class Tgt>
+typename std::enable_if<
+    detail::is_batch_target_v<std::remove_const_t<Src>> &&
+    !std::is_same<std::remove_const_t<Src>, char>::value &&
+    IsSomeString<Tgt>::value>::type
+toAppendDelimBatch(const Delimiter& delim, Range<Src*> src, Tgt* result) {
+  using Value = std::remove_const_t<Src>;
+  constexpr size_t kBufferSize = 4096;
+  constexpr size_t kMaxValueSize = std::is_floating_point<Value>::value
+      ? detail::kFloatingToCharsBufferSize
+      : to_ascii_size_max_decimal<uint64_t> + 1;
+  StringPiece separator;
+  if constexpr (std::is_same<Delimiter, char>::value) {
+    separator = StringPiece(&delim, 1);
+  } else {
+    separator = StringPiece(delim);
+  }
+  if (separator.size() > kBufferSize / 2) {
+    for (size_t i = 0; i < src.size(); ++i) {
+      if (i != 0) {
+        toAppend(separator, result);
+      }
+      toAppend(src[i], result);
+    }
+    return;
+  }
+
+  char buffer[kBufferSize];
+  size_t pos = 0;
+  for (size_t i = 0; i < src.size(); ++i) {
+    if (pos + separator.size() + kMaxValueSize > kBufferSize) {
+      result->append(buffer, pos);
+      pos = 0;
+    }
+    if (i != 0) {
+      std::memcpy(buffer + pos, separator.data(), separator.size());
+      pos += separator.size();
+    }
+    Value value = src[i];
+    if constexpr (std::is_floating_point<Value>::value) {
+      pos += detail::floatingToChars(
+          buffer + pos, value, DtoaMode::SHORTEST, 0, DtoaFlags::NO_FLAGS);
+    } else {
+      uint64_t magnitude = static_cast<uint64_t>(value);
+      if (is_signed_v<Value> && value < 0) {
+        buffer[pos++] = '-';
+        magnitude = uint64_t(0) - magnitude;
+      }
+      pos += to_ascii_decimal(buffer + pos, buffer + kBufferSize, magnitude);
+    }
+  }
+  result->append(buffer, pos);
+}
+
 /**
  * Enum to anything and back
  */
@@ -24,6 +24,7 @@
 #include <folly/Optional.h>
 #include <folly/Range.h>
 #include <folly/Utility.h>
+#include <folly/container/span.h>
 #include <folly/lang/Exception.h>
 
 namespace folly {
@@ -63,6 +64,13 @@ class Executor {
   /// This is up to the implementation to enforce
   virtual void addWithPriority(Func, int8_t priority);
 
+  /// Enqueue several functions at once, moving them out of the span, as if
+  /// by add() for each of them in order. Executors that can enqueue a batch
+  /// more cheaply than one function at a time, for example with a single
+  /// reservation in their queue and a single wakeup of their threads,
+  /// override this; the default calls add() for each function.
+  virtual void addBatch(span<Func> funcs);
+
   virtual uint8_t getNumPriorities() const { return 1; }
 
   static constexpr int8_t LO_PRI = SCHAR_MIN;
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/NumaTopology.h>
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#include <fmt/core.h>
+#include <glog/logging.h>
+#include <folly/Indestructible.h>
+#include <folly/Portability.h>
+
+namespace folly {
+
+namespace {
+
+// Parses a list in the format of the cpulist and online files: a
+// comma-separated list of decimal numbers and ranges, where the ranges are
+// pairs of decimal numbers separated by a '-', for example "0-3,8,10-11".
+std::vector<size_t> parseList(const std::string& line) {
+  std::vector<size_t> values;
+  auto const error = [&] {
+    return std::runtime_error(fmt::format("error parsing list '{}'", line));
+  };
+  auto const parseNumber = [&](const char*& pos) -> size_t {
+    char* end;
+    unsigned long val = strtoul(pos, &end, 10);
+    if (end == pos) {
+      throw error();
+    }
+    pos = end;
+    return val;
+  };
+  auto pos = line.c_str();
+  while (*pos != 0 && *pos != '\n') {
+    auto const first = parseNumber(pos);
+    auto last = first;
+    if (*pos == '-') {
+      ++pos;
+      last = parseNumber(pos);
+      if (last < first) {
+        throw error();
+      }
+    }
+    for (auto v = first; v <= last; ++v) {
+      values.push_back(v);
+    }
+    if (*pos == ',') {
+      ++pos;
+    } else if (*pos != 0 && *pos != '\n') {
+      throw error();
+    }
+  }
+  return values;
+}
+
+NumaTopology getSystemTopology() {
+  if (kIsLinux) {
+    try {
+      return NumaTopology::readFromSysfs();
+    } catch (...) {
+      // no NUMA support in the kernel, or no sysfs
+    }
+  }
+  return NumaTopology::uniform(CacheLocality::system().numCpus);
+}
+
+Getcpu::Func getcpuFunc() {
+  static Getcpu::Func const func = [] {
+    auto best = Getcpu::resolveVdsoFunc();
+    return best ? best : &FallbackGetcpuType::getcpu;
+  }();
+  return func;
+}
+
+unsigned currentCpu() {
+  unsigned cpu = 0;
+  getcpuFunc()(&cpu, nullptr, nullptr);
+  return cpu;
+}
+
+} // namespace
+
+///////////// NumaTopology
+
+NumaTopology::NumaTopology(
+    std::vector<std::vector<size_t>> cpus, std::vector<size_t> ids)
+    : cpusByNode(std::move(cpus)), nodeIds(std::move(ids)) {
+  DCHECK(!cpusByNode.empty());
+  DCHECK_EQ(cpusByNode.size(), nodeIds.size());
+  size_t numCpus = 0;
+  for (auto& nodeCpus : cpusByNode) {
+    std::sort(nodeCpus.begin(), nodeCpus.end());
+    numCpus = std::max(numCpus, nodeCpus.back() + 1);
+  }
+  nodeByCpu.resize(numCpus, 0);
+  for (size_t node = 0; node < cpusByNode.size(); ++node) {
+    for (auto cpu : cpusByNode[node]) {
+      nodeByCpu[cpu] = node;
+    }
+  }
+}
+
+size_t NumaTopology::currentNode() const {
+  return nodeOfCpu(currentCpu());
+}
+
+const NumaTopology& NumaTopology::system() {
+  static const Indestructible<NumaTopology> topology{getSystemTopology()};
+  return *topology;
+}
+
+NumaTopology NumaTopology::readFromSysfsTree(
+    const std::function<std::string(std::string const&)>& mapping) {
+  auto const online = mapping("/sys/devices/system/node/online");
+  if (online.empty()) {
+    throw std::runtime_error("unable to load NUMA node info");
+  }
+
+  std::vector<std::vector<size_t>> cpusByNode;
+  std::vector<size_t> nodeIds;
+  for (auto id : parseList(online)) {
+    auto cpus = parseList(
+        mapping(fmt::format("/sys/devices/system/node/node{}/cpulist", id)));
+    if (cpus.empty()) {
+      // memory-only node
+      continue;
+    }
+    cpusByNode.push_back(std::move(cpus));
+    nodeIds.push_back(id);
+  }
+
+  if (cpusByNode.empty()) {
+    throw std::runtime_error("no NUMA node with cpus");
+  }
+
+  return NumaTopology{std::move(cpusByNode), std::move(nodeIds)};
+}
+
+NumaTopology NumaTopology::readFromSysfs(std::string const& sysfsRoot) {
+  return readFromSysfsTree([&](std::string const& name) {
+    // name starts with "/sys"
+    std::ifstream xi((sysfsRoot + name.substr(4)).c_str());
+    std::string rv;
+    std::getline(xi, rv);
+    return rv;
+  });
+}
+
+NumaTopology NumaTopology::uniform(size_t numCpus) {
+  CHECK_GT(numCpus, 0);
+  std::vector<size_t> cpus(numCpus);
+  std::iota(cpus.begin(), cpus.end(), 0);
+  return NumaTopology{{std::move(cpus)}, {0}};
+}
+
+///////////// NumaAccessSpreader
+
+NumaAccessSpreader::NumaAccessSpreader(
+    size_t stripesPerNode,
+    const NumaTopology& topology,
+    const CacheLocality& locality)
+    : stripesPerNode_(stripesPerNode),
+      numStripes_(stripesPerNode * topology.numNodes()),
+      stripeByCpu_(topology.nodeByCpu.size(), 0) {
+  CHECK_GT(stripesPerNode, 0);
+  // cpus unknown to the locality info go last, in cpu order
+  auto const localityIndex = [&](size_t cpu) {
+    return cpu < locality.numCpus ? locality.localityIndexByCpu[cpu]
+                                  : locality.numCpus + cpu;
+  };
+  for (size_t node = 0; node < topology.numNodes(); ++node) {
+    auto cpus = topology.cpusByNode[node];
+    std::sort(cpus.begin(), cpus.end(), [&](size_t lhs, size_t rhs) {
+      return localityIndex(lhs) < localityIndex(rhs);
+    });
+    // as in AccessSpreader, the i-th of n cpus goes to stripe i * k / n
+    for (size_t i = 0; i < cpus.size(); ++i) {
+      stripeByCpu_[cpus[i]] =
+          node * stripesPerNode + i * stripesPerNode / cpus.size();
+    }
+  }
+}
+
+size_t NumaAccessSpreader::current() const {
+  return stripeOfCpu(currentCpu());
+}
+
+} // namespace folly
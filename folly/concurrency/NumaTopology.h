@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <folly/concurrency/CacheLocality.h>
+
+namespace folly {
+
+/// The NUMA nodes of the system, and the cpus of each node.
+///
+/// Nodes are identified by their index in cpusByNode, in the range
+/// 0..numNodes()-1, which is also the kernel's node id unless node ids have
+/// gaps; nodeIds holds the kernel's ids. Nodes without cpus, such as
+/// memory-only nodes, are left out, since no thread can run on them.
+struct NumaTopology {
+  /// The cpus of each node, in increasing order.
+  std::vector<std::vector<size_t>> cpusByNode;
+
+  /// The kernel's id of each node, parallel to cpusByNode.
+  std::vector<size_t> nodeIds;
+
+  /// A map from cpu (from sched_getcpu or getcpu) to the index of its node.
+  /// Cpus that belong to no node map to node 0.
+  std::vector<size_t> nodeByCpu;
+
+  size_t numNodes() const { return cpusByNode.size(); }
+
+  /// Returns the index of the node of the given cpu. Cpus outside of the
+  /// table wrap around, so the result is always < numNodes().
+  size_t nodeOfCpu(size_t cpu) const {
+    return nodeByCpu[cpu % nodeByCpu.size()];
+  }
+
+  /// Returns the index of the node of the cpu the calling thread runs on,
+  /// using the same getcpu implementation as AccessSpreader. Threads that are
+  /// not pinned may move to another node right after the call.
+  size_t currentNode() const;
+
+  /// Returns the NUMA topology of the current system, cached for fast access.
+  /// This will be loaded from sysfs if possible, otherwise it is a single
+  /// node with all cpus of CacheLocality::system().
+  static const NumaTopology& system();
+
+  /// Reads the NUMA topology from a tree structured like the sysfs
+  /// filesystem. As with CacheLocality::readFromSysfsTree, the provided
+  /// function is evaluated for each file that needs to be queried, and
+  /// should return the first line of the file (not including the newline),
+  /// or an empty string if the file does not exist. The function will be
+  /// called with /sys/devices/system/node/online and paths of the form
+  /// /sys/devices/system/node/node*/cpulist . Throws an exception if no node
+  /// with cpus can be parsed.
+  static NumaTopology readFromSysfsTree(
+      const std::function<std::string(std::string const&)>& mapping);
+
+  /// Reads the NUMA topology from the sysfs filesystem mounted at sysfsRoot,
+  /// which tests may point at a fake tree. Throws an exception if no node
+  /// information can be loaded.
+  static NumaTopology readFromSysfs(std::string const& sysfsRoot = "/sys");
+
+  /// Returns a topology with a single node holding cpus 0..numCpus-1.
+  static NumaTopology uniform(size_t numCpus);
+
+ private:
+  NumaTopology(
+      std::vector<std::vector<size_t>> cpus, std::vector<size_t> ids);
+};
+
+/// NumaAccessSpreader arranges access to a striped data structure like
+/// AccessSpreader, except that no stripe spans two NUMA nodes: the stripes
+/// [n * stripesPerNode, (n + 1) * stripesPerNode) belong to the cpus of node
+/// n. Memory for each stripe can then be allocated on its node, and is only
+/// accessed by threads on that node.
+///
+/// Within a node the cpus are split in the order of the CacheLocality
+/// locality index, so that cpus sharing caches also share stripes.
+///
+/// The stripe table is computed at construction, so instances should be
+/// created once and shared.
+class NumaAccessSpreader {
+ public:
+  explicit NumaAccessSpreader(
+      size_t stripesPerNode,
+      const NumaTopology& topology = NumaTopology::system(),
+      const CacheLocality& locality = CacheLocality::system());
+
+  size_t stripesPerNode() const { return stripesPerNode_; }
+
+  size_t numStripes() const { return numStripes_; }
+
+  /// Returns the stripe of the given cpu, which is < numStripes(). Cpus
+  /// outside of the table wrap around.
+  size_t stripeOfCpu(size_t cpu) const {
+    return stripeByCpu_[cpu % stripeByCpu_.size()];
+  }
+
+  /// Returns the node the stripe belongs to.
+  size_t nodeOfStripe(size_t stripe) const { return stripe / stripesPerNode_; }
+
+  /// Returns the stripe of the cpu the calling thread runs on.
+  size_t current() const;
+
+ private:
+  size_t stripesPerNode_;
+  size_t numStripes_;
+  std::vector<size_t> stripeByCpu_;
+};
+
+} // namespace folly
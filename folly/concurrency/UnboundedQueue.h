@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <iterator>
 #include <memory>
 
 #include <glog/logging.h>
@@ -79,6 +80,10 @@ namespace folly {
 ///     void enqueue(const T&);
 ///     void enqueue(T&&);
 ///         Adds an element to the end of the queue.
+///     template <typename It> void enqueue_bulk(It first, It last);
+///         Adds the elements of [first, last) to the end of the queue,
+///         in order and consecutively, reserving their positions with a
+///         single update of the producer ticket.
 ///
 ///   Consumer operations:
 ///     void dequeue(T&);
@@ -280,6 +285,23 @@ class UnboundedQueue {
 
   FOLLY_ALWAYS_INLINE void enqueue(T&& arg) { enqueueImpl(std::move(arg)); }
 
+  /** enqueue_bulk */
+  template <typename It>
+  void enqueue_bulk(It first, It last) {
+    auto const n = static_cast<Ticket>(std::distance(first, last));
+    if (n == 0) {
+      return;
+    }
+    if (SPSC) {
+      Segment* s = tail();
+      enqueueBulkCommon(s, first, n);
+    } else {
+      hazptr_holder<Atom> hptr = make_hazard_pointer<Atom>();
+      Segment* s = hptr.protect(p_.tail);
+      enqueueBulkCommon(s, first, n);
+    }
+  }
+
   /** dequeue */
   FOLLY_ALWAYS_INLINE void dequeue(T& item) noexcept { item = dequeueImpl(); }
 
@@ -400,6 +422,28 @@ class UnboundedQueue {
     }
   }
 
+  /** enqueueBulkCommon */
+  template <typename It>
+  void enqueueBulkCommon(Segment* s, It first, Ticket n) {
+    Ticket const begin = fetchAddProducerTicket(n);
+    for (Ticket t = begin; t != begin + n; ++t, ++first) {
+      // Segments of earlier tickets in the batch are allocated before they
+      // are reached, as in enqueueCommon(), so this only walks forward.
+      s = findSegment(s, t);
+      DCHECK_GE(t, s->minTicket());
+      DCHECK_LT(t, s->minTicket() + SegmentSize);
+      size_t idx = index(t);
+      Entry& e = s->entry(idx);
+      e.putItem(*first);
+      if (responsibleForAlloc(t)) {
+        allocNextSegment(s);
+      }
+      if (responsibleForAdvance(t)) {
+        advanceTail(s);
+      }
+    }
+  }
+
   /** dequeueImpl */
   FOLLY_ALWAYS_INLINE T dequeueImpl() noexcept {
     if (SPSC) {
@@ -757,6 +801,16 @@ class UnboundedQueue {
     }
   }
 
+  FOLLY_ALWAYS_INLINE Ticket fetchAddProducerTicket(Ticket n) noexcept {
+    if (SingleProducer) {
+      Ticket oldval = producerTicket();
+      setProducerTicket(oldval + n);
+      return oldval;
+    } else { // MP
+      return p_.ticket.fetch_add(n, std::memory_order_acq_rel);
+    }
+  }
+
   /**
    *  Entry
    */
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <folly/Optional.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+/// WorkStealingDeque<T> is the Chase-Lev work-stealing deque ("Dynamic
+/// Circular Work-Stealing Deque", Chase and Lev, SPAA 2005), with the memory
+/// orderings of "Correct and Efficient Work-Stealing for Weak Memory Models"
+/// (Lê, Pop, Cohen and Zappa Nardelli, PPoPP 2013).
+///
+/// One thread, the owner, pushes and pops at the bottom of the deque, in LIFO
+/// order. Any thread may steal from the top, in FIFO order. push() and pop()
+/// touch no shared cache line unless the deque is nearly empty; steal() costs
+/// one CAS.
+///
+/// The owner may change over time, for example when a thread hands the deque
+/// over to another, as long as the handover synchronizes the two threads.
+///
+/// The buffer grows by doubling when full and never shrinks. Buffers that were
+/// outgrown are kept until destruction, since a concurrent steal() may still
+/// read them; together they take less memory than the current buffer.
+///
+/// Elements are stored behind pointers, so a thief may read a slot while the
+/// owner writes it. Each push() allocates.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(size_t initialCapacity = 64)
+      : buffers_(1), buffer_(nullptr) {
+    CHECK_GT(initialCapacity, 0);
+    buffers_.front() = std::make_unique<Buffer>(nextPowTwo(initialCapacity));
+    buffer_.store(buffers_.front().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  /// Not thread-safe: nothing may use the deque concurrently.
+  ~WorkStealingDeque() {
+    auto buf = buffer_.load(std::memory_order_relaxed);
+    auto const b = bottom_.load(std::memory_order_relaxed);
+    for (auto t = top_.load(std::memory_order_relaxed); t < b; ++t) {
+      delete buf->get(t);
+    }
+  }
+
+  /// Owner only.
+  void push(T value) {
+    auto const b = bottom_.load(std::memory_order_relaxed);
+    auto const t = top_.load(std::memory_order_acquire);
+    auto buf = buffer_.load(std::memory_order_relaxed);
+    if (b - t >= int64_t(buf->capacity())) {
+      buf = grow(buf, t, b);
+    }
+    buf->put(b, new T(std::move(value)));
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  /// Owner only. Takes the most recently pushed element.
+  Optional<T> pop() {
+    auto const b = bottom_.load(std::memory_order_relaxed) - 1;
+    auto buf = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      // empty
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return none;
+    }
+    auto p = buf->get(b);
+    if (t == b) {
+      // the last element, which a thief may be taking too
+      bool const won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      if (!won) {
+        return none;
+      }
+    }
+    return unwrap(p);
+  }
+
+  /// Any thread. Takes the least recently pushed element. Returns none if the
+  /// deque is empty, and may also return none if it loses a race with the
+  /// owner or another thief.
+  Optional<T> steal() {
+    auto t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto const b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return none;
+    }
+    // the slot may be stale, but then the CAS fails and p is not used
+    auto p = buffer_.load(std::memory_order_acquire)->get(t);
+    if (!top_.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return none;
+    }
+    return unwrap(p);
+  }
+
+  /// Any thread. A recent number of elements.
+  size_t size() const {
+    auto const b = bottom_.load(std::memory_order_acquire);
+    auto const t = top_.load(std::memory_order_acquire);
+    return b > t ? size_t(b - t) : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+ private:
+  class Buffer {
+   public:
+    explicit Buffer(size_t capacity)
+        : mask_(capacity - 1), slots_(new std::atomic<T*>[capacity]()) {}
+
+    size_t capacity() const { return mask_ + 1; }
+
+    T* get(int64_t i) const {
+      return slots_[size_t(i) & mask_].load(std::memory_order_acquire);
+    }
+
+    void put(int64_t i, T* p) {
+      slots_[size_t(i) & mask_].store(p, std::memory_order_release);
+    }
+
+   private:
+    size_t mask_;
+    std::unique_ptr<std::atomic<T*>[]> slots_;
+  };
+
+  static T unwrap(T* p) {
+    std::unique_ptr<T> owned(p);
+    return std::move(*owned);
+  }
+
+  Buffer* grow(Buffer* buf, int64_t t, int64_t b) {
+    auto next = std::make_unique<Buffer>(buf->capacity() * 2);
+    for (auto i = t; i < b; ++i) {
+      next->put(i, buf->get(i));
+    }
+    buffers_.push_back(std::move(next));
+    auto raw = buffers_.back().get();
+    buffer_.store(raw, std::memory_order_release);
+    return raw;
+  }
+
+  alignas(hardware_destructive_interference_size) std::atomic<int64_t> top_{0};
+  alignas(hardware_destructive_interference_size)
+      std::atomic<int64_t> bottom_{0};
+  // owner only, the current buffer last
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+  std::atomic<Buffer*> buffer_;
+};
+
+} // namespace folly
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/container/WorkStealingDeque.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+namespace folly {
+
+TEST(WorkStealingDeque, pushPop) {
+  WorkStealingDeque<int> q;
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.pop().has_value());
+  EXPECT_FALSE(q.steal().has_value());
+
+  for (int i = 0; i < 10; ++i) {
+    q.push(i);
+  }
+  EXPECT_EQ(10, q.size());
+  // LIFO at the bottom, FIFO at the top
+  EXPECT_EQ(9, q.pop());
+  EXPECT_EQ(0, q.steal());
+  EXPECT_EQ(8, q.pop());
+  EXPECT_EQ(1, q.steal());
+  EXPECT_EQ(6, q.size());
+  for (int i = 7; i >= 2; --i) {
+    EXPECT_EQ(i, q.pop());
+  }
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST(WorkStealingDeque, grow) {
+  WorkStealingDeque<std::string> q(2);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      q.push(std::to_string(i));
+    }
+    for (int i = 0; i < 500; ++i) {
+      ASSERT_EQ(std::to_string(i), q.steal());
+    }
+    for (int i = 999; i >= 500; --i) {
+      ASSERT_EQ(std::to_string(i), q.pop());
+    }
+    EXPECT_TRUE(q.empty());
+  }
+}
+
+TEST(WorkStealingDeque, destroysElements) {
+  auto counted = std::make_shared<int>(0);
+  {
+    WorkStealingDeque<std::shared_ptr<int>> q(4);
+    for (int i = 0; i < 100; ++i) {
+      q.push(counted);
+    }
+    q.pop();
+    q.steal();
+    EXPECT_EQ(99, counted.use_count());
+  }
+  EXPECT_EQ(1, counted.use_count());
+}
+
+TEST(WorkStealingDeque, moveOnly) {
+  WorkStealingDeque<std::unique_ptr<int>> q;
+  q.push(std::make_unique<int>(1));
+  q.push(std::make_unique<int>(2));
+  EXPECT_EQ(2, **q.pop());
+  EXPECT_EQ(1, **q.steal());
+}
+
+TEST(WorkStealingDeque, concurrentSteal) {
+  constexpr int kItems = 200000;
+  constexpr int kThieves = 4;
+  WorkStealingDeque<int> q(8);
+  std::vector<std::atomic<int>> taken(kItems);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < kThieves; ++t) {
+    thieves.emplace_back([&] {
+      while (!done.load(std::memory_order_acquire) || !q.empty()) {
+        if (auto v = q.steal()) {
+          taken[*v].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  // the owner pushes and pops in bursts, so that it races with the thieves
+  // for the last element, and the buffer grows while they are stealing
+  for (int i = 0; i < kItems;) {
+    for (int j = 0; j < 64 && i < kItems; ++j) {
+      q.push(i++);
+    }
+    for (int j = 0; j < 16; ++j) {
+      if (auto v = q.pop()) {
+        taken[*v].fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  while (auto v = q.pop()) {
+    taken[*v].fetch_add(1, std::memory_order_relaxed);
+  }
+  done.store(true, std::memory_order_release);
+  for (auto& thr : thieves) {
+    thr.join();
+  }
+
+  for (int i = 0; i < kItems; ++i) {
+    ASSERT_EQ(1, taken[i].load()) << i;
+  }
+}
+
+} // namespace folly
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <limits>
 #include <mutex>
 #include <new>
 
@@ -311,11 +312,19 @@ class alignas(64) BucketTable {
   }
 
   ~BucketTable() {
+    // We can delete and not retire() here, since users must have
+    // their own synchronization around destruction. The tables of an
+    // unfinished migration share nodes, which are reclaimed once their
+    // last link is released.
+    auto next = next_buckets_.load(std::memory_order_relaxed);
+    if (next) {
+      auto ncount = next_bucket_count_.load(std::memory_order_relaxed);
+      next->unlink_and_reclaim_nodes(ncount);
+      next->destroy(ncount);
+    }
     auto buckets = buckets_.load(std::memory_order_relaxed);
     // To catch use-after-destruction bugs in user code.
     buckets_.store(nullptr, std::memory_order_release);
-    // We can delete and not retire() here, since users must have
-    // their own synchronization around destruction.
     auto count = bucket_count_.load(std::memory_order_relaxed);
     buckets->unlink_and_reclaim_nodes(count);
     buckets->destroy(count);
@@ -363,80 +372,30 @@ class alignas(64) BucketTable {
     return doInsert(it, h, k, type, match, cur, cohort, cur);
   }
 
-  // Must hold lock.
+  // Grows the table to at least bucket_count buckets in one step, for
+  // reserve(). Growth on insertion is incremental, see migrate().
   void rehash(size_t bucket_count, hazptr_obj_cohort<Atom>* cohort) {
-    auto oldcount = bucket_count_.load(std::memory_order_relaxed);
     // bucket_count must be a power of 2
     DCHECK_EQ(bucket_count & (bucket_count - 1), 0);
-    if (bucket_count <= oldcount) {
-      return; // Rehash only if expanding.
-    }
-    auto buckets = buckets_.load(std::memory_order_relaxed);
-    DCHECK(buckets); // Use-after-destruction by user.
-    auto newbuckets = Buckets::create(bucket_count, cohort);
-    load_factor_nodes_ =
-        to_integral(static_cast<float>(bucket_count) * load_factor_);
-    for (size_t i = 0; i < oldcount; i++) {
-      auto bucket = &buckets->buckets_[i]();
-      auto node = bucket->load(std::memory_order_relaxed);
-      if (!node) {
-        continue;
-      }
-      auto h = HashFn()(node->getItem().first);
-      auto idx = getIdx(bucket_count, h);
-      // Reuse as long a chain as possible from the end.  Since the
-      // nodes don't have previous pointers, the longest last chain
-      // will be the same for both the previous hashmap and the new one,
-      // assuming all the nodes hash to the same bucket.
-      auto lastrun = node;
-      auto lastidx = idx;
-      auto last = node->next_.load(std::memory_order_relaxed);
-      for (; last != nullptr;
-           last = last->next_.load(std::memory_order_relaxed)) {
-        auto k = getIdx(bucket_count, HashFn()(last->getItem().first));
-        if (k != lastidx) {
-          lastidx = k;
-          lastrun = last;
-        }
-      }
-      // Set longest last run in new bucket, incrementing the refcount.
-      lastrun->acquire_link(); // defined in hazptr_obj_base_linked
-      newbuckets->buckets_[lastidx]().store(lastrun, std::memory_order_relaxed);
-      // Clone remaining nodes
-      for (; node != lastrun;
-           node = node->next_.load(std::memory_order_relaxed)) {
-        auto newnode = (Node*)Allocator().allocate(sizeof(Node));
-        new (newnode) Node(cohort, node);
-        auto k = getIdx(bucket_count, HashFn()(node->getItem().first));
-        auto prevhead = &newbuckets->buckets_[k]();
-        newnode->next_.store(prevhead->load(std::memory_order_relaxed));
-        prevhead->store(newnode, std::memory_order_relaxed);
-      }
-    }
-
-    auto oldbuckets = buckets_.load(std::memory_order_relaxed);
-    DCHECK(oldbuckets); // Use-after-destruction by user.
-    seqlock_.fetch_add(1, std::memory_order_release);
-    bucket_count_.store(bucket_count, std::memory_order_release);
-    buckets_.store(newbuckets, std::memory_order_release);
-    seqlock_.fetch_add(1, std::memory_order_release);
-    oldbuckets->retire(concurrenthashmap::HazptrTableDeleter(oldcount));
+    std::lock_guard g(m_);
+    finishMigration(cohort);
+    startMigration(bucket_count, cohort);
+    finishMigration(cohort);
   }
 
   template <typename K>
   bool find(Iterator& res, size_t h, const K& k) {
     auto& hazcurr = res.hazptrs_[1];
     auto& haznext = res.hazptrs_[2];
-    size_t bcount;
-    Buckets* buckets;
-    getBucketsAndCount(bcount, buckets, res.hazptrs_[0]);
+    Tables tables;
+    getTables(tables, res);
 
-    auto idx = getIdx(bcount, h);
-    auto prev = &buckets->buckets_[idx]();
+    auto pos = position(tables, h);
+    auto prev = &bucket(tables, pos);
     auto node = hazcurr.protect(*prev);
     while (node) {
       if (KeyEqual()(k, node->getItem().first)) {
-        res.setNode(node, buckets, bcount, idx);
+        res.setNode(node, this, tables, pos);
         return true;
       }
       node = haznext.protect(node->next_);
@@ -451,11 +410,9 @@ class alignas(64) BucketTable {
     {
       std::lock_guard g(m_);
 
-      size_t bcount = bucket_count_.load(std::memory_order_relaxed);
-      auto buckets = buckets_.load(std::memory_order_relaxed);
-      DCHECK(buckets); // Use-after-destruction by user.
-      auto idx = getIdx(bcount, h);
-      auto head = &buckets->buckets_[idx]();
+      auto tables = lockedTables();
+      auto pos = position(tables, h);
+      auto head = &bucket(tables, pos);
       node = head->load(std::memory_order_relaxed);
       Node* prev = nullptr;
       while (node) {
@@ -475,12 +432,12 @@ class alignas(64) BucketTable {
           }
 
           if (iter) {
-            iter->hazptrs_[0].reset_protection(buckets);
+            protectTables(*iter, tables);
             iter->setNode(
                 node->next_.load(std::memory_order_acquire),
-                buckets,
-                bcount,
-                idx);
+                this,
+                tables,
+                pos);
             iter->next();
           }
           decSize();
@@ -500,33 +457,43 @@ class alignas(64) BucketTable {
   }
 
   void clear(hazptr_obj_cohort<Atom>* cohort) {
-    size_t bcount;
-    Buckets* buckets;
+    Tables tables;
     {
       std::lock_guard g(m_);
-      bcount = bucket_count_.load(std::memory_order_relaxed);
-      auto newbuckets = Buckets::create(bcount, cohort);
-      buckets = buckets_.load(std::memory_order_relaxed);
+      tables = lockedTables();
+      // Keep the size that an unfinished migration was growing to.
+      auto count = tables.next ? tables.ncount : tables.bcount;
+      auto newbuckets = Buckets::create(count, cohort);
+      seqlock_.fetch_add(1, std::memory_order_release);
+      bucket_count_.store(count, std::memory_order_release);
       buckets_.store(newbuckets, std::memory_order_release);
+      next_buckets_.store(nullptr, std::memory_order_release);
+      seqlock_.fetch_add(1, std::memory_order_release);
       clearSize();
     }
-    DCHECK(buckets); // Use-after-destruction by user.
-    buckets->retire(concurrenthashmap::HazptrTableDeleter(bcount));
+    DCHECK(tables.buckets); // Use-after-destruction by user.
+    tables.buckets->retire(
+        concurrenthashmap::HazptrTableDeleter(tables.bcount));
+    if (tables.next) {
+      tables.next->retire(concurrenthashmap::HazptrTableDeleter(tables.ncount));
+    }
   }
 
   void max_load_factor(float factor) {
     std::lock_guard g(m_);
     load_factor_ = factor;
+    auto tables = lockedTables();
     load_factor_nodes_ =
-        bucket_count_.load(std::memory_order_relaxed) * load_factor_;
+        (tables.next ? tables.ncount : tables.bcount) * load_factor_;
   }
 
   Iterator cbegin() {
     Iterator res;
-    size_t bcount;
-    Buckets* buckets;
-    getBucketsAndCount(bcount, buckets, res.hazptrs_[0]);
-    res.setNode(nullptr, buckets, bcount, 0);
+    Tables tables;
+    getTables(tables, res);
+    Position pos;
+    pos.in_next = tables.next && tables.migrated > 0;
+    res.setNode(nullptr, this, tables, pos);
     res.next();
     return res;
   }
@@ -588,6 +555,27 @@ class alignas(64) BucketTable {
     BucketRoot buckets_[0];
   };
 
+  // A consistent view of the tables of the segment. While the segment
+  // grows, next is the larger table that the buckets of buckets are being
+  // migrated to, and the buckets of buckets below migrated have been.
+  struct Tables {
+    Buckets* buckets{nullptr};
+    size_t bcount{0};
+    Buckets* next{nullptr};
+    size_t ncount{0};
+    size_t migrated{0};
+  };
+
+  // The bucket of a key, or of an iterator: bucket idx of buckets, unless
+  // it was migrated, then bucket next_idx of next. Iterators walk the
+  // buckets of next that bucket idx was split into, next_idx = idx + k *
+  // bcount, before moving to bucket idx + 1.
+  struct Position {
+    uint64_t idx{0};
+    uint64_t next_idx{0};
+    bool in_next{false};
+  };
+
  public:
   class Iterator {
    public:
@@ -597,11 +585,14 @@ class alignas(64) BucketTable {
     FOLLY_ALWAYS_INLINE ~Iterator() {}
 
     void setNode(
-        Node* node, Buckets* buckets, size_t bucket_count, uint64_t idx) {
+        Node* node,
+        BucketTable* table,
+        const Tables& tables,
+        const Position& pos) {
       node_ = node;
-      buckets_ = buckets;
-      idx_ = idx;
-      bucket_count_ = bucket_count;
+      table_ = table;
+      tables_ = tables;
+      pos_ = pos;
     }
 
     const value_type& operator*() const {
@@ -619,7 +610,7 @@ class alignas(64) BucketTable {
       node_ = hazptrs_[2].protect(node_->next_);
       hazptrs_[1].swap(hazptrs_[2]);
       if (!node_) {
-        ++idx_;
+        nextBucket();
         next();
       }
       return *this;
@@ -627,15 +618,15 @@ class alignas(64) BucketTable {
 
     void next() {
       while (!node_) {
-        if (idx_ >= bucket_count_) {
+        if (pos_.idx >= tables_.bcount) {
           break;
         }
-        DCHECK(buckets_);
-        node_ = hazptrs_[1].protect(buckets_->buckets_[idx_]());
+        DCHECK(tables_.buckets);
+        node_ = hazptrs_[1].protect(bucket(tables_, pos_));
         if (node_) {
           break;
         }
-        ++idx_;
+        nextBucket();
       }
     }
 
@@ -648,10 +639,11 @@ class alignas(64) BucketTable {
     Iterator& operator=(Iterator&& o) noexcept {
       if (this != &o) {
         hazptrs_ = std::move(o.hazptrs_);
+        hazmigration_ = std::move(o.hazmigration_);
         node_ = std::exchange(o.node_, nullptr);
-        buckets_ = std::exchange(o.buckets_, nullptr);
-        bucket_count_ = std::exchange(o.bucket_count_, 0);
-        idx_ = std::exchange(o.idx_, 0);
+        table_ = std::exchange(o.table_, nullptr);
+        tables_ = std::exchange(o.tables_, Tables());
+        pos_ = std::exchange(o.pos_, Position());
       }
       return *this;
     }
@@ -660,39 +652,225 @@ class alignas(64) BucketTable {
 
     Iterator(Iterator&& o) noexcept
         : hazptrs_(std::move(o.hazptrs_)),
+          hazmigration_(std::move(o.hazmigration_)),
           node_(std::exchange(o.node_, nullptr)),
-          buckets_(std::exchange(o.buckets_, nullptr)),
-          bucket_count_(std::exchange(o.bucket_count_, 0)),
-          idx_(std::exchange(o.idx_, 0)) {}
+          table_(std::exchange(o.table_, nullptr)),
+          tables_(std::exchange(o.tables_, Tables())),
+          pos_(std::exchange(o.pos_, Position())) {}
 
     // These are accessed directly from the functions above
     hazptr_array<3, Atom> hazptrs_;
+    // Protects tables_.next, only made while the segment grows.
+    hazptr_holder<Atom> hazmigration_;
 
    private:
+    void nextBucket() {
+      if (pos_.in_next && pos_.next_idx + tables_.bcount < tables_.ncount) {
+        pos_.next_idx += tables_.bcount;
+        return;
+      }
+      ++pos_.idx;
+      pos_.next_idx = pos_.idx;
+      // The bucket is read from next if it was migrated, or if the
+      // migration finished since this iterator was made: the chains of
+      // buckets may then miss later changes.
+      pos_.in_next = tables_.next && pos_.idx < tables_.bcount &&
+          table_->isMigrated(tables_, pos_.idx);
+    }
+
     Node* node_{nullptr};
-    Buckets* buckets_{nullptr};
-    size_t bucket_count_{0};
-    uint64_t idx_{0};
+    BucketTable* table_{nullptr};
+    Tables tables_;
+    Position pos_;
   };
 
  private:
+  // Buckets migrated by each write while the segment grows. A segment
+  // of n buckets grows once it holds about n nodes, so it is done well
+  // before the next growth.
+  static constexpr size_t kMigrateBuckets = 8;
+
   // Shards have already used low ShardBits of the hash.
   // Shift it over to use fresh bits.
-  uint64_t getIdx(size_t bucket_count, size_t hash) {
+  static uint64_t getIdx(size_t bucket_count, size_t hash) {
     return (hash >> ShardBits) & (bucket_count - 1);
   }
-  void getBucketsAndCount(
-      size_t& bcount, Buckets*& buckets, hazptr_holder<Atom>& hazptr) {
+
+  static Position position(const Tables& tables, size_t h) {
+    Position pos;
+    pos.idx = getIdx(tables.bcount, h);
+    pos.in_next = tables.next && pos.idx < tables.migrated;
+    pos.next_idx = pos.in_next ? getIdx(tables.ncount, h) : pos.idx;
+    return pos;
+  }
+
+  static Atom<Node*>& bucket(const Tables& tables, const Position& pos) {
+    return pos.in_next ? tables.next->buckets_[pos.next_idx]()
+                       : tables.buckets->buckets_[pos.idx]();
+  }
+
+  void getTables(Tables& tables, Iterator& it) {
     while (true) {
       auto seqlock = seqlock_.load(std::memory_order_acquire);
-      bcount = bucket_count_.load(std::memory_order_acquire);
-      buckets = hazptr.protect(buckets_);
+      tables.bcount = bucket_count_.load(std::memory_order_acquire);
+      tables.buckets = it.hazptrs_[0].protect(buckets_);
+      tables.next = next_buckets_.load(std::memory_order_acquire);
+      if (FOLLY_UNLIKELY(tables.next != nullptr)) {
+        getNext(tables, it);
+      }
       auto seqlock2 = seqlock_.load(std::memory_order_acquire);
       if (!(seqlock & 1) && (seqlock == seqlock2)) {
         break;
       }
     }
-    DCHECK(buckets) << "Use-after-destruction by user.";
+    DCHECK(tables.buckets) << "Use-after-destruction by user.";
+  }
+
+  FOLLY_NOINLINE void getNext(Tables& tables, Iterator& it) {
+    if (!it.hazmigration_.hprec()) {
+      it.hazmigration_ = make_hazard_pointer<Atom>();
+    }
+    tables.next = it.hazmigration_.protect(next_buckets_);
+    tables.ncount = next_bucket_count_.load(std::memory_order_acquire);
+    tables.migrated = migrated_.load(std::memory_order_acquire);
+  }
+
+  // Whether bucket idx of tables.buckets is to be read from tables.next.
+  bool isMigrated(const Tables& tables, uint64_t idx) {
+    while (true) {
+      auto seqlock = seqlock_.load(std::memory_order_acquire);
+      auto buckets = buckets_.load(std::memory_order_acquire);
+      auto migrated = migrated_.load(std::memory_order_acquire);
+      auto seqlock2 = seqlock_.load(std::memory_order_acquire);
+      if (!(seqlock & 1) && (seqlock == seqlock2)) {
+        return buckets != tables.buckets || idx < migrated;
+      }
+    }
+  }
+
+  // Must hold lock.
+  Tables lockedTables() {
+    Tables tables;
+    tables.buckets = buckets_.load(std::memory_order_relaxed);
+    DCHECK(tables.buckets) << "Use-after-destruction by user.";
+    tables.bcount = bucket_count_.load(std::memory_order_relaxed);
+    tables.next = next_buckets_.load(std::memory_order_relaxed);
+    if (tables.next) {
+      tables.ncount = next_bucket_count_.load(std::memory_order_relaxed);
+      tables.migrated = migrated_.load(std::memory_order_relaxed);
+    }
+    return tables;
+  }
+
+  // Must hold lock.
+  void protectTables(Iterator& it, const Tables& tables) {
+    it.hazptrs_[0].reset_protection(tables.buckets);
+    if (tables.next) {
+      if (!it.hazmigration_.hprec()) {
+        it.hazmigration_ = make_hazard_pointer<Atom>();
+      }
+      it.hazmigration_.reset_protection(tables.next);
+    }
+  }
+
+  // Must hold lock. Publishes an empty table of bucket_count buckets,
+  // which the buckets of the current one are migrated to by the next
+  // writes. Readers look a key up in the table its bucket is in.
+  void startMigration(size_t bucket_count, hazptr_obj_cohort<Atom>* cohort) {
+    DCHECK(!next_buckets_.load(std::memory_order_relaxed));
+    if (bucket_count <= bucket_count_.load(std::memory_order_relaxed)) {
+      return; // Rehash only if expanding.
+    }
+    auto newbuckets = Buckets::create(bucket_count, cohort);
+    load_factor_nodes_ =
+        to_integral(static_cast<float>(bucket_count) * load_factor_);
+    seqlock_.fetch_add(1, std::memory_order_release);
+    next_bucket_count_.store(bucket_count, std::memory_order_release);
+    migrated_.store(0, std::memory_order_release);
+    next_buckets_.store(newbuckets, std::memory_order_release);
+    seqlock_.fetch_add(1, std::memory_order_release);
+  }
+
+  // Must hold lock. Migrates up to n buckets, and retires the old table
+  // once they all are. The chains of the migrated buckets are left as
+  // they are, for the readers that are still walking them.
+  void migrate(size_t n, hazptr_obj_cohort<Atom>* cohort) {
+    auto tables = lockedTables();
+    if (FOLLY_LIKELY(!tables.next)) {
+      return;
+    }
+    auto end = tables.migrated + std::min(n, tables.bcount - tables.migrated);
+    for (auto i = tables.migrated; i < end; ++i) {
+      migrateBucket(tables, i, cohort);
+    }
+    migrated_.store(end, std::memory_order_release);
+    if (end < tables.bcount) {
+      return;
+    }
+    seqlock_.fetch_add(1, std::memory_order_release);
+    bucket_count_.store(tables.ncount, std::memory_order_release);
+    buckets_.store(tables.next, std::memory_order_release);
+    next_buckets_.store(nullptr, std::memory_order_release);
+    seqlock_.fetch_add(1, std::memory_order_release);
+    tables.buckets->retire(
+        concurrenthashmap::HazptrTableDeleter(tables.bcount));
+  }
+
+  // Must hold lock.
+  void finishMigration(hazptr_obj_cohort<Atom>* cohort) {
+    migrate(std::numeric_limits<size_t>::max(), cohort);
+  }
+
+  // Must hold lock. Links the nodes of bucket i of tables.buckets into
+  // the buckets of tables.next that it splits into.
+  void migrateBucket(
+      const Tables& tables, size_t i, hazptr_obj_cohort<Atom>* cohort) {
+    auto bucket_count = tables.ncount;
+    auto newbuckets = tables.next;
+    auto node = tables.buckets->buckets_[i]().load(std::memory_order_relaxed);
+    if (!node) {
+      return;
+    }
+    auto h = HashFn()(node->getItem().first);
+    auto idx = getIdx(bucket_count, h);
+    // Reuse as long a chain as possible from the end.  Since the
+    // nodes don't have previous pointers, the longest last chain
+    // will be the same for both the previous hashmap and the new one,
+    // assuming all the nodes hash to the same bucket.
+    auto lastrun = node;
+    auto lastidx = idx;
+    auto last = node->next_.load(std::memory_order_relaxed);
+    for (; last != nullptr;
+         last = last->next_.load(std::memory_order_relaxed)) {
+      auto k = getIdx(bucket_count, HashFn()(last->getItem().first));
+      if (k != lastidx) {
+        lastidx = k;
+        lastrun = last;
+      }
+    }
+    // Set longest last run in new bucket, incrementing the refcount.
+    lastrun->acquire_link(); // defined in hazptr_obj_base_linked
+    newbuckets->buckets_[lastidx]().store(lastrun, std::memory_order_relaxed);
+    // Clone remaining nodes
+    for (; node != lastrun;
+         node = node->next_.load(std::memory_order_relaxed)) {
+      auto newnode = (Node*)Allocator().allocate(sizeof(Node));
+      new (newnode) Node(cohort, node);
+      auto k = getIdx(bucket_count, HashFn()(node->getItem().first));
+      auto prevhead = &newbuckets->buckets_[k]();
+      newnode->next_.store(prevhead->load(std::memory_order_relaxed));
+      prevhead->store(newnode, std::memory_order_relaxed);
+    }
+  }
+
+  // Must hold lock.
+  void grow(hazptr_obj_cohort<Atom>* cohort) {
+    if (max_size_ && size() << 1 > max_size_) {
+      // Would exceed max size.
+      throw_exception<std::bad_alloc>();
+    }
+    finishMigration(cohort);
+    startMigration(bucket_count_.load(std::memory_order_relaxed) << 1, cohort);
   }
 
   template <typename MatchFunc, typename K, typename... Args>
@@ -706,36 +884,29 @@ class alignas(64) BucketTable {
       hazptr_obj_cohort<Atom>* cohort,
       Args&&... args) {
     std::unique_lock g(m_);
+    migrate(kMigrateBuckets, cohort);
 
-    size_t bcount = bucket_count_.load(std::memory_order_relaxed);
-    auto buckets = buckets_.load(std::memory_order_relaxed);
     // Check for rehash needed for DOES_NOT_EXIST
     if (size() >= load_factor_nodes_ &&
         (type == InsertType::DOES_NOT_EXIST ||
          type == InsertType::MATCH_OR_DOES_NOT_EXIST)) {
-      if (max_size_ && size() << 1 > max_size_) {
-        // Would exceed max size.
-        throw_exception<std::bad_alloc>();
-      }
-      rehash(bcount << 1, cohort);
-      buckets = buckets_.load(std::memory_order_relaxed);
-      bcount = bucket_count_.load(std::memory_order_relaxed);
+      grow(cohort);
     }
 
-    DCHECK(buckets) << "Use-after-destruction by user.";
-    auto idx = getIdx(bcount, h);
-    auto head = &buckets->buckets_[idx]();
+    auto tables = lockedTables();
+    auto pos = position(tables, h);
+    auto head = &bucket(tables, pos);
     auto node = head->load(std::memory_order_relaxed);
     auto headnode = node;
     auto prev = head;
     auto& hazbuckets = it.hazptrs_[0];
     auto& haznode = it.hazptrs_[1];
-    hazbuckets.reset_protection(buckets);
+    protectTables(it, tables);
     bool matched = false;
     while (node) {
       // Is the key found?
       if (KeyEqual()(k, node->getItem().first)) {
-        it.setNode(node, buckets, bcount, idx);
+        it.setNode(node, this, tables, pos);
         haznode.reset_protection(node);
         if (type == InsertType::MATCH ||
             type == InsertType::MATCH_OR_DOES_NOT_EXIST) {
@@ -758,7 +929,7 @@ class alignas(64) BucketTable {
             next->acquire_link(); // defined in hazptr_obj_base_linked
           }
           prev->store(cur, std::memory_order_release);
-          it.setNode(cur, buckets, bcount, idx);
+          it.setNode(cur, this, tables, pos);
           haznode.reset_protection(cur);
           g.unlock();
           // Release not under lock.
@@ -779,19 +950,13 @@ class alignas(64) BucketTable {
     }
     // Node not found, check for rehash on ANY
     if (size() >= load_factor_nodes_ && type == InsertType::ANY) {
-      if (max_size_ && size() << 1 > max_size_) {
-        // Would exceed max size.
-        throw_exception<std::bad_alloc>();
-      }
-      rehash(bcount << 1, cohort);
+      grow(cohort);
 
       // Reload correct bucket.
-      buckets = buckets_.load(std::memory_order_relaxed);
-      DCHECK(buckets); // Use-after-destruction by user.
-      bcount <<= 1;
-      hazbuckets.reset_protection(buckets);
-      idx = getIdx(bcount, h);
-      head = &buckets->buckets_[idx]();
+      tables = lockedTables();
+      protectTables(it, tables);
+      pos = position(tables, h);
+      head = &bucket(tables, pos);
       headnode = head->load(std::memory_order_relaxed);
     }
 
@@ -808,7 +973,7 @@ class alignas(64) BucketTable {
     }
     cur->next_.store(headnode, std::memory_order_relaxed);
     head->store(cur, std::memory_order_release);
-    it.setNode(cur, buckets, bcount, idx);
+    it.setNode(cur, this, tables, pos);
     haznode.reset_protection(cur);
     return true;
   }
@@ -823,6 +988,10 @@ class alignas(64) BucketTable {
   alignas(64) Atom<Buckets*> buckets_{nullptr};
   std::atomic<uint64_t> seqlock_{0};
   Atom<size_t> bucket_count_;
+  // The table the buckets are migrated to while the segment grows.
+  Atom<Buckets*> next_buckets_{nullptr};
+  Atom<size_t> next_bucket_count_{0};
+  Atom<size_t> migrated_{0};
 };
 
 } // namespace bucket
@@ -1360,8 +1529,11 @@ class alignas(64) SIMDTable {
     return true;
   }
 
+  // For reserve(). Growth on insertion calls rehash_internal(), under the
+  // lock it already holds.
   void rehash(size_t size, hazptr_obj_cohort<Atom>* cohort) {
     size_t new_chunk_count = size == 0 ? 0 : (size - 1) / Chunk::kCapacity + 1;
+    std::lock_guard g(m_);
     rehash_internal(folly::nextPowTwo(new_chunk_count), cohort);
   }
 
@@ -1931,7 +2103,7 @@ class alignas(64) ConcurrentHashMapSegment {
     return impl_.insert(it, h, k, type, match, cur, cohort_);
   }
 
-  // Must hold lock.
+  // Takes the segment lock, so reserve() can run concurrently with writers.
   void rehash(size_t bucket_count) {
     impl_.rehash(folly::nextPowTwo(bucket_count), cohort_);
   }
@@ -16,9 +16,11 @@
 
 #include <folly/concurrency/ConcurrentHashMap.h>
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include <folly/BenchmarkUtil.h>
 #include <folly/portability/GFlags.h>
@@ -204,6 +206,44 @@ uint64_t bench_size(const int nthr, int size, const std::string& name) {
   return runBench(name, ops, repFn);
 }
 
+// The latency of the insertions into a map that grows from empty, which
+// includes the rehashes of its segments.
+void bench_insert_latency(const int nthr, const std::string& name) {
+  int ops = FLAGS_ops / nthr;
+  std::vector<uint64_t> latencies;
+  for (int r = 0; r < FLAGS_reps; ++r) {
+    folly::ConcurrentHashMap<int, int> m;
+    std::vector<std::vector<uint64_t>> perThread(nthr);
+    auto fn = [&](int tid) {
+      auto& mine = perThread[tid];
+      mine.reserve(ops);
+      for (int i = 0; i < ops; ++i) {
+        int key = tid * ops + i;
+        auto begin = std::chrono::steady_clock::now();
+        folly::doNotOptimizeAway(m.insert(key, key));
+        auto end = std::chrono::steady_clock::now();
+        mine.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+                .count());
+      }
+    };
+    auto endfn = [&] {};
+    run_once(nthr, fn, endfn);
+    for (auto& mine : perThread) {
+      latencies.insert(latencies.end(), mine.begin(), mine.end());
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+  };
+  std::cout << name;
+  for (double p : {0.5, 0.99, 0.999}) {
+    std::cout << "   " << std::setw(6) << percentile(p) << " ns";
+  }
+  std::cout << "   " << std::setw(6) << latencies.back() << " ns" << std::endl;
+}
+
 void dottedLine() {
   std::cout << ".............................................................."
             << std::endl;
@@ -255,6 +295,15 @@ void benches() {
   }
   std::cout << "=============================================================="
             << std::endl;
+  std::cout << "Test name                     "
+            << "      p50         p99       p99.9         max" << std::endl;
+  for (int nthr : {1, 10}) {
+    std::cout << "========================= " << std::setw(2) << nthr
+              << " threads" << " =========================" << std::endl;
+    bench_insert_latency(nthr, "CHM insert() -- growing       ");
+  }
+  std::cout << "=============================================================="
+            << std::endl;
 }
 
 int main() {
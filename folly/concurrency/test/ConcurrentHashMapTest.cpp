@@ -229,6 +229,59 @@ TYPED_TEST_P(ConcurrentHashMapTest, ReserveTest) {
   EXPECT_EQ(insert_count, actual_count);
 }
 
+// A single segment grows in steps, so every state of a migration is seen
+// by the lookups, erasures and iterations between the insertions.
+TYPED_TEST_P(ConcurrentHashMapTest, MigrationTest) {
+  CHM<uint64_t,
+      uint64_t,
+      std::hash<uint64_t>,
+      std::equal_to<uint64_t>,
+      std::allocator<uint8_t>,
+      0>
+      foomap(2);
+  constexpr uint64_t kSize = 2000;
+  for (uint64_t i = 0; i < kSize; i++) {
+    EXPECT_TRUE(foomap.insert(i, i).second);
+    if (i % 3 == 2) {
+      EXPECT_TRUE(foomap.erase(i - 1));
+    }
+    for (uint64_t j = 0; j <= i; j += 7) {
+      auto it = foomap.find(j);
+      if (j % 3 == 1 && j < i) {
+        EXPECT_EQ(foomap.cend(), it) << j;
+      } else {
+        ASSERT_NE(foomap.cend(), it) << j;
+        EXPECT_EQ(j, it->second);
+      }
+    }
+    if (i % 31 == 0) {
+      size_t count = 0;
+      for (auto it = foomap.cbegin(); it != foomap.cend(); ++it) {
+        count++;
+      }
+      EXPECT_EQ(foomap.size(), count);
+    }
+  }
+  // Erase through iterators, then iterate from a lookup.
+  auto size = foomap.size();
+  size_t erased = 0;
+  for (auto it = foomap.cbegin(); it != foomap.cend();) {
+    if (it->first % 2 == 0) {
+      it = foomap.erase(it);
+      erased++;
+    } else {
+      ++it;
+    }
+  }
+  EXPECT_EQ(size - erased, foomap.size());
+  size_t count = 0;
+  for (auto it = foomap.find(1999); it != foomap.cend(); ++it) {
+    EXPECT_EQ(1, it->first % 2);
+    count++;
+  }
+  EXPECT_LE(count, foomap.size());
+}
+
 // Ensure we can insert objects without copy constructors.
 TYPED_TEST_P(ConcurrentHashMapTest, MapNoCopiesTest) {
   struct Uncopyable {
@@ -733,6 +786,60 @@ TYPED_TEST_P(ConcurrentHashMapTest, insertStressTest) {
   }
 }
 
+// Writers grow the map while readers look up the keys they inserted and
+// iterate over the keys that are never erased.
+TYPED_TEST_P(ConcurrentHashMapTest, GrowStressTest) {
+  constexpr unsigned long kFixed = 10;
+  constexpr unsigned long kPerThread = 20000;
+  CHM<unsigned long,
+      unsigned long,
+      std::hash<unsigned long>,
+      std::equal_to<unsigned long>,
+      std::allocator<uint8_t>,
+      2,
+      Atom,
+      Mutex>
+      m(2);
+  for (unsigned long i = 0; i < kFixed; i++) {
+    m.insert(i, i);
+  }
+  std::vector<std::thread> threads;
+  unsigned int num_threads = 8;
+  for (uint32_t t = 0; t < num_threads; t++) {
+    threads.push_back(lib::thread([&, t]() {
+      unsigned long base = kFixed + t * kPerThread;
+      for (unsigned long i = 0; i < kPerThread; i++) {
+        auto k = base + i;
+        EXPECT_TRUE(m.insert(k, k).second);
+        auto j = base + i / 2;
+        auto it = m.find(j);
+        if (j % 4 == 3 && j + 1 < k) {
+          EXPECT_EQ(it, m.cend());
+        } else {
+          ASSERT_NE(it, m.cend());
+          EXPECT_EQ(j, it->second);
+        }
+        if (k % 4 == 0) {
+          EXPECT_TRUE(m.erase(k - 1));
+        }
+        if (t % 2 == 0 && i % 1000 == 0) {
+          unsigned long count = 0;
+          for (auto iter = m.cbegin(); iter != m.cend(); ++iter) {
+            if (iter->first < kFixed) {
+              count++;
+            }
+          }
+          EXPECT_EQ(kFixed, count);
+        }
+      }
+    }));
+  }
+  for (auto& t : threads) {
+    join;
+  }
+  EXPECT_EQ(kFixed + num_threads * kPerThread * 3 / 4, m.size());
+}
+
 TYPED_TEST_P(ConcurrentHashMapTest, assignStressTest) {
   DeterministicSchedule sched(DeterministicSchedule::uniform(FLAGS_seed));
 
@@ -1256,6 +1363,7 @@ REGISTER_TYPED_TEST_SUITE_P(
     EmplaceTest,
     MapResizeTest,
     ReserveTest,
+    MigrationTest,
     MapNoCopiesTest,
     MapMovableKeysTest,
     MapUpdateTest,
@@ -1286,6 +1394,7 @@ REGISTER_TYPED_TEST_SUITE_P(
     UpdateStressTest,
     assignStressTest,
     insertStressTest,
+    GrowStressTest,
     IteratorMove,
     IteratorLoop,
     HeterogeneousLookup,
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/NumaTopology.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+using namespace folly;
+
+// Two nodes with 4 cores and 8 hyperthreads each, a memory-only node 2, and
+// a gap in the node ids.
+static const std::map<std::string, std::string> fakeSysfsTree = {
+    {"/sys/devices/system/node/online", "0-1,3"},
+    {"/sys/devices/system/node/node0/cpulist", "0-3,8-11"},
+    {"/sys/devices/system/node/node1/cpulist", "4-7,12-15"},
+    {"/sys/devices/system/node/node3/cpulist", ""},
+};
+
+static NumaTopology readFake(const std::map<std::string, std::string>& tree) {
+  return NumaTopology::readFromSysfsTree([&](std::string const& name) {
+    auto iter = tree.find(name);
+    return iter == tree.end() ? std::string() : iter->second;
+  });
+}
+
+TEST(NumaTopology, FakeSysfs) {
+  auto parsed = readFake(fakeSysfsTree);
+
+  EXPECT_EQ(2, parsed.numNodes());
+  EXPECT_EQ((std::vector<size_t>{0, 1}), parsed.nodeIds);
+  EXPECT_EQ(
+      (std::vector<size_t>{0, 1, 2, 3, 8, 9, 10, 11}), parsed.cpusByNode[0]);
+  EXPECT_EQ(
+      (std::vector<size_t>{4, 5, 6, 7, 12, 13, 14, 15}), parsed.cpusByNode[1]);
+  EXPECT_EQ(
+      (std::vector<size_t>{0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1}),
+      parsed.nodeByCpu);
+  EXPECT_EQ(1, parsed.nodeOfCpu(13));
+  // wraps around
+  EXPECT_EQ(1, parsed.nodeOfCpu(16 + 4));
+}
+
+TEST(NumaTopology, NodeIdGaps) {
+  auto parsed = readFake({
+      {"/sys/devices/system/node/online", "0,2"},
+      {"/sys/devices/system/node/node0/cpulist", "1"},
+      {"/sys/devices/system/node/node2/cpulist", "0,2-3"},
+  });
+
+  EXPECT_EQ(2, parsed.numNodes());
+  EXPECT_EQ((std::vector<size_t>{0, 2}), parsed.nodeIds);
+  EXPECT_EQ((std::vector<size_t>{1, 0, 1, 1}), parsed.nodeByCpu);
+}
+
+TEST(NumaTopology, Errors) {
+  // no NUMA support
+  EXPECT_THROW(readFake({}), std::runtime_error);
+  // no node with cpus
+  EXPECT_THROW(
+      readFake({{"/sys/devices/system/node/online", "0"}}), std::runtime_error);
+  EXPECT_THROW(
+      readFake({
+          {"/sys/devices/system/node/online", "0"},
+          {"/sys/devices/system/node/node0/cpulist", "0-x"},
+      }),
+      std::runtime_error);
+  EXPECT_THROW(
+      readFake({
+          {"/sys/devices/system/node/online", "0"},
+          {"/sys/devices/system/node/node0/cpulist", "3-1"},
+      }),
+      std::runtime_error);
+}
+
+TEST(NumaTopology, FakeSysfsRoot) {
+  test::TemporaryDirectory root;
+  for (auto& [name, value] : fakeSysfsTree) {
+    auto path = root.path() / name.substr(5);
+    fs::create_directories(path.parent_path());
+    ASSERT_TRUE(writeFile(value + "\n", path.string().c_str()));
+  }
+
+  auto parsed = NumaTopology::readFromSysfs(root.path().string());
+  auto expected = readFake(fakeSysfsTree);
+  EXPECT_EQ(expected.cpusByNode, parsed.cpusByNode);
+  EXPECT_EQ(expected.nodeIds, parsed.nodeIds);
+  EXPECT_EQ(expected.nodeByCpu, parsed.nodeByCpu);
+
+  EXPECT_THROW(
+      NumaTopology::readFromSysfs((root.path() / "missing").string()),
+      std::runtime_error);
+}
+
+TEST(NumaTopology, Uniform) {
+  auto uniform = NumaTopology::uniform(4);
+  EXPECT_EQ(1, uniform.numNodes());
+  EXPECT_EQ((std::vector<size_t>{0, 1, 2, 3}), uniform.cpusByNode[0]);
+  EXPECT_EQ((std::vector<size_t>{0, 0, 0, 0}), uniform.nodeByCpu);
+}
+
+TEST(NumaTopology, System) {
+  auto& topology = NumaTopology::system();
+  ASSERT_GE(topology.numNodes(), 1);
+  EXPECT_LT(topology.currentNode(), topology.numNodes());
+  size_t numCpus = 0;
+  for (auto& cpus : topology.cpusByNode) {
+    EXPECT_FALSE(cpus.empty());
+    numCpus += cpus.size();
+  }
+  EXPECT_LE(numCpus, topology.nodeByCpu.size());
+}
+
+TEST(NumaAccessSpreader, StripesAreNodeLocal) {
+  auto topology = readFake(fakeSysfsTree);
+  // hyperthreads i and i + 8 share a core
+  std::vector<std::vector<size_t>> equivClasses(16);
+  for (size_t cpu = 0; cpu < 16; ++cpu) {
+    equivClasses[cpu] = {cpu % 8, cpu < 4 || (cpu >= 8 && cpu < 12) ? 0u : 4u};
+  }
+  auto locality = CacheLocality::readFromSysfsTree([&](std::string name) {
+    size_t cpu, index;
+    char file[32];
+    if (sscanf(
+            name.c_str(),
+            "/sys/devices/system/cpu/cpu%zu/cache/index%zu/%31s",
+            &cpu,
+            &index,
+            file) != 3 ||
+        cpu >= 16 || index >= 2) {
+      return std::string();
+    }
+    if (std::string(file) == "type") {
+      return std::string("Unified");
+    }
+    return std::to_string(equivClasses[cpu][index]);
+  });
+
+  NumaAccessSpreader spreader(2, topology, locality);
+  EXPECT_EQ(4, spreader.numStripes());
+  std::map<size_t, std::set<size_t>> cpusByStripe;
+  for (size_t cpu = 0; cpu < 16; ++cpu) {
+    auto stripe = spreader.stripeOfCpu(cpu);
+    ASSERT_LT(stripe, 4);
+    EXPECT_EQ(topology.nodeOfCpu(cpu), spreader.nodeOfStripe(stripe)) << cpu;
+    cpusByStripe[stripe].insert(cpu);
+  }
+  // each stripe holds 2 cores, with both of their hyperthreads
+  ASSERT_EQ(4, cpusByStripe.size());
+  for (auto& [stripe, cpus] : cpusByStripe) {
+    EXPECT_EQ(4, cpus.size()) << stripe;
+    for (auto cpu : cpus) {
+      EXPECT_EQ(1, cpus.count(cpu < 8 ? cpu + 8 : cpu - 8)) << cpu;
+    }
+  }
+
+  // more stripes than cpus
+  NumaAccessSpreader wide(100, topology, locality);
+  for (size_t cpu = 0; cpu < 16; ++cpu) {
+    auto stripe = wide.stripeOfCpu(cpu);
+    EXPECT_EQ(topology.nodeOfCpu(cpu), wide.nodeOfStripe(stripe)) << cpu;
+  }
+}
+
+TEST(NumaAccessSpreader, System) {
+  NumaAccessSpreader spreader(4);
+  EXPECT_EQ(4 * NumaTopology::system().numNodes(), spreader.numStripes());
+  EXPECT_LT(spreader.current(), spreader.numStripes());
+}
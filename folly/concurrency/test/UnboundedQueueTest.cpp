@@ -27,7 +27,9 @@
 
 #include <atomic>
 #include <iomanip>
+#include <numeric>
 #include <thread>
+#include <vector>
 
 DEFINE_bool(bench, false, "run benchmark");
 DEFINE_int32(reps, 10, "number of reps");
@@ -166,6 +168,85 @@ TEST(UnboundedQueue, basic) {
   basic_test<UMPMC, true>();
 }
 
+template <bool SingleProducer, bool SingleConsumer, bool MayBlock>
+void bulk_test() {
+  // small segments, so that batches span several of them
+  folly::UnboundedQueue<int, SingleProducer, SingleConsumer, MayBlock, 2> q;
+  std::vector<int> items(11);
+  std::iota(items.begin(), items.end(), 0);
+  q.enqueue_bulk(items.begin(), items.begin());
+  ASSERT_TRUE(q.empty());
+  q.enqueue_bulk(items.begin(), items.end());
+  ASSERT_EQ(q.size(), 11);
+  q.enqueue(11);
+  q.enqueue_bulk(items.begin(), items.begin() + 3);
+  ASSERT_EQ(q.size(), 15);
+  for (int i = 0; i < 12; ++i) {
+    int v = -1;
+    ASSERT_TRUE(q.try_dequeue(v));
+    ASSERT_EQ(v, i);
+  }
+  for (int i = 0; i < 3; ++i) {
+    int v = -1;
+    ASSERT_TRUE(q.try_dequeue(v));
+    ASSERT_EQ(v, i);
+  }
+  ASSERT_TRUE(q.empty());
+}
+
+TEST(UnboundedQueue, bulk) {
+  bulk_test<true, true, false>();
+  bulk_test<false, true, false>();
+  bulk_test<true, false, false>();
+  bulk_test<false, false, false>();
+  bulk_test<true, true, true>();
+  bulk_test<false, true, true>();
+  bulk_test<true, false, true>();
+  bulk_test<false, false, true>();
+}
+
+TEST(UnboundedQueue, bulkConcurrent) {
+  // Each producer enqueues batches of consecutive values. The items of a
+  // batch must be dequeued consecutively, and batches of a producer in order.
+  constexpr int kProducers = 4;
+  constexpr int kBatches = 2000;
+  folly::UnboundedQueue<int, false, true, true, 3> q;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      std::vector<int> batch;
+      for (int b = 0; b < kBatches; ++b) {
+        batch.clear();
+        for (int i = 0; i <= b % 13; ++i) {
+          batch.push_back((p << 24) | (b << 4) | i);
+        }
+        q.enqueue_bulk(batch.begin(), batch.end());
+      }
+    });
+  }
+  std::vector<int> nextBatch(kProducers, 0);
+  int remaining = 0;
+  for (int b = 0; b < kBatches; ++b) {
+    remaining += kProducers * (b % 13 + 1);
+  }
+  while (remaining > 0) {
+    int v = q.dequeue();
+    int const p = v >> 24;
+    int const b = (v >> 4) & 0xfffff;
+    ASSERT_EQ(v & 0xf, 0);
+    ASSERT_EQ(b, nextBatch[p]);
+    for (int i = 1; i <= b % 13; ++i) {
+      ASSERT_EQ(q.dequeue(), (p << 24) | (b << 4) | i);
+    }
+    ++nextBatch[p];
+    remaining -= b % 13 + 1;
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  ASSERT_TRUE(q.empty());
+}
+
 template <template <typename, bool> class Q, bool MayBlock>
 void timeout_test() {
   Q<int, MayBlock> q;
@@ -0,0 +1,652 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/intrusive/list.hpp>
+
+#include <folly/Likely.h>
+#include <folly/SharedMutex.h>
+#include <folly/container/F14Set.h>
+#include <folly/container/HeterogeneousAccess.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+namespace detail {
+
+/**
+ * The frequency sketch of TinyLFU: a count-min sketch of 4 bit counters, 16
+ * to a word. All counters are halved once there have been 10 increments per
+ * entry of the cache, so that old accesses are forgotten.
+ */
+class EvictingCacheFrequencySketch {
+ public:
+  explicit EvictingCacheFrequencySketch(std::size_t capacity)
+      : table_(nextPowTwo(std::max<std::size_t>(capacity, 16)) / 2),
+        mask_(table_.size() - 1),
+        sampleSize_(10 * std::max<std::size_t>(capacity, 16)) {}
+
+  void increment(std::uint64_t hash) {
+    auto h = mix(hash);
+    bool added = false;
+    for (unsigned i = 0; i < kDepth; ++i) {
+      auto& word = table_[index(h, i)];
+      auto shift = offset(h, i);
+      if (((word >> shift) & 0xf) != 0xf) {
+        word += std::uint64_t(1) << shift;
+        added = true;
+      }
+    }
+    if (added && ++size_ == sampleSize_) {
+      for (auto& word : table_) {
+        word = (word >> 1) & 0x7777777777777777;
+      }
+      size_ /= 2;
+    }
+  }
+
+  unsigned frequency(std::uint64_t hash) const {
+    auto h = mix(hash);
+    unsigned ret = 0xf;
+    for (unsigned i = 0; i < kDepth; ++i) {
+      ret = std::min(ret, unsigned(table_[index(h, i)] >> offset(h, i)) & 0xf);
+    }
+    return ret;
+  }
+
+ private:
+  static constexpr unsigned kDepth = 4;
+
+  // Seeded, so that the bits do not correlate with the choice of shards.
+  static std::uint64_t mix(std::uint64_t hash) {
+    return hash::twang_mix64(hash ^ 0x9e3779b97f4a7c15);
+  }
+  // Each row picks a word with its own multiplier, and a counter in the
+  // word with 4 bits of the hash.
+  std::size_t index(std::uint64_t h, unsigned i) const {
+    static constexpr std::uint64_t kSeeds[kDepth] = {
+        0xc3a5c85c97cb3127, 0xb492b66fbe98f273, 0x9ae16a3b2f90404f,
+        0xcbf29ce484222325};
+    h = (h + kSeeds[i]) * kSeeds[i];
+    return std::size_t(h + (h >> 32)) & mask_;
+  }
+  static unsigned offset(std::uint64_t h, unsigned i) {
+    return (unsigned(h >> (4 * i)) & 0xf) * 4;
+  }
+
+  std::vector<std::uint64_t> table_;
+  std::size_t mask_;
+  std::size_t sampleSize_;
+  std::size_t size_{0};
+};
+
+inline std::size_t evictingCacheStripe() {
+  static thread_local const std::size_t stripe = hash::twang_mix64(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+  return stripe;
+}
+
+} // namespace detail
+
+/**
+ * A thread-safe evicting cache, for the cases where a Synchronized
+ * EvictingCacheMap would be a contended lock.
+ *
+ *   ConcurrentEvictingCache<std::string, std::shared_ptr<Result>> cache(
+ *       10000);
+ *   if (auto result = cache.get(key)) {
+ *     return *result;
+ *   }
+ *   cache.set(key, compute(key));
+ *
+ * Entries are spread over shards by hash, each with its own lock and its
+ * own share of the capacity, and evicted from their shard. Lookups take the
+ * shard lock in shared mode and return a copy of the value, so TValue
+ * should be cheap to copy, e.g. a shared_ptr. They do not reorder the LRU
+ * lists themselves: they record the access in a small per-thread buffer of
+ * the shard, and the accesses are applied in batches by the next writer of
+ * the shard, or by a reader that finds its buffer full. Accesses that do
+ * not fit in a full buffer are dropped, so recency is approximate.
+ *
+ * There are two eviction policies:
+ *  - LRU: each shard evicts its least recently used entries.
+ *  - W_TINY_LFU: new entries go into a small LRU window, 1% of the
+ *    capacity. Entries leaving the window are admitted into the main
+ *    space, a segmented LRU, only if they have been accessed more often
+ *    than the entry they would evict, according to a frequency sketch of
+ *    recent accesses. This resists scans and one-hit wonders that would
+ *    flush an LRU cache.
+ *
+ * The capacity is a total weight, where the weight of each entry is given
+ * by Options::weigher, or 1. Entries heavier than the capacity of a shard
+ * are not cached.
+ *
+ * The prune hook is called for evicted entries, with the shard locked: it
+ * must not use the cache.
+ */
+template <
+    class TKey,
+    class TValue,
+    class THash = HeterogeneousAccessHash<TKey>,
+    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>>
+class ConcurrentEvictingCache {
+ public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using hasher = THash;
+  using PruneHookCall = std::function<void(const TKey&, TValue&&)>;
+  using WeightFn = std::function<std::size_t(const TKey&, const TValue&)>;
+
+  enum class Policy { LRU, W_TINY_LFU };
+
+  struct Options {
+    Policy policy{Policy::LRU};
+    // 0 for a number proportional to the number of CPUs. Rounded up to a
+    // power of 2, and reduced so that each shard holds at least 64 units of
+    // weight.
+    std::size_t numShards{0};
+    WeightFn weigher;
+    PruneHookCall pruneHook;
+  };
+
+  explicit ConcurrentEvictingCache(
+      std::size_t capacity,
+      Options options = {},
+      const THash& keyHash = THash(),
+      const TKeyEqual& keyEqual = TKeyEqual())
+      : keyHash_(keyHash),
+        keyEqual_(keyEqual),
+        options_(std::move(options)),
+        capacity_(capacity) {
+    std::size_t numShards = options_.numShards
+        ? options_.numShards
+        : 4 * std::max(1u, std::thread::hardware_concurrency());
+    numShards = nextPowTwo(numShards);
+    while (numShards > 1 && capacity / numShards < kMinShardCapacity) {
+      numShards /= 2;
+    }
+    shardMask_ = numShards - 1;
+    auto shardCapacity = (capacity + numShards - 1) / numShards;
+    shards_.reserve(numShards);
+    for (std::size_t i = 0; i < numShards; ++i) {
+      shards_.push_back(std::make_unique<Shard>(*this, shardCapacity));
+    }
+  }
+
+  ConcurrentEvictingCache(const ConcurrentEvictingCache&) = delete;
+  ConcurrentEvictingCache& operator=(const ConcurrentEvictingCache&) = delete;
+
+  /**
+   * A copy of the value associated with key, or none. Counts as an access.
+   */
+  template <typename K = TKey>
+  std::optional<TValue> get(const K& key) {
+    auto hash = keyHash_(key);
+    auto& shard = shardFor(hash);
+    std::optional<TValue> ret;
+    bool full = false;
+    {
+      std::shared_lock lock(shard.mutex);
+      if (auto node = shard.find(key, hash)) {
+        ret.emplace(node->value);
+        full = !shard.recordAccess(node);
+      }
+    }
+    if (FOLLY_UNLIKELY(full)) {
+      std::unique_lock lock(shard.mutex, std::try_to_lock);
+      if (lock.owns_lock()) {
+        shard.drain();
+      }
+    }
+    return ret;
+  }
+
+  /**
+   * Like get(), but without counting as an access.
+   */
+  template <typename K = TKey>
+  std::optional<TValue> getWithoutPromotion(const K& key) const {
+    auto hash = keyHash_(key);
+    auto& shard = shardFor(hash);
+    std::shared_lock lock(shard.mutex);
+    if (auto node = shard.find(key, hash)) {
+      return node->value;
+    }
+    return std::nullopt;
+  }
+
+  template <typename K = TKey>
+  bool exists(const K& key) const {
+    auto hash = keyHash_(key);
+    auto& shard = shardFor(hash);
+    std::shared_lock lock(shard.mutex);
+    return shard.find(key, hash) != nullptr;
+  }
+
+  /**
+   * Associate value with key, replacing any previous value, and count it as
+   * an access. Returns whether the entry is in the cache afterwards: with
+   * W_TINY_LFU, an entry may be evicted right away.
+   */
+  bool set(const TKey& key, TValue value) {
+    return setImpl(key, std::move(value), /* replace = */ true);
+  }
+
+  /**
+   * Associate value with key if key is not in the cache. Returns whether
+   * value was inserted, and is still in the cache.
+   */
+  bool insert(const TKey& key, TValue value) {
+    return setImpl(key, std::move(value), /* replace = */ false);
+  }
+
+  /**
+   * Erase the entry of key, if any, without calling the prune hook.
+   */
+  template <typename K = TKey>
+  bool erase(const K& key) {
+    auto hash = keyHash_(key);
+    auto& shard = shardFor(hash);
+    std::unique_lock lock(shard.mutex);
+    shard.drain();
+    auto node = shard.find(key, hash);
+    if (!node) {
+      return false;
+    }
+    shard.remove(node, /* evicted = */ false);
+    return true;
+  }
+
+  /**
+   * Evict all entries.
+   */
+  void clear() {
+    for (auto& shard : shards_) {
+      std::unique_lock lock(shard->mutex);
+      shard->drain();
+      shard->clear();
+    }
+  }
+
+  std::size_t size() const {
+    std::size_t ret = 0;
+    for (auto& shard : shards_) {
+      ret += shard->size.load(std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  std::size_t getTotalWeight() const {
+    std::size_t ret = 0;
+    for (auto& shard : shards_) {
+      ret += shard->weight.load(std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
+  std::size_t getCapacity() const { return capacity_; }
+
+  std::size_t numShards() const { return shards_.size(); }
+
+ private:
+  static constexpr std::size_t kMinShardCapacity = 64;
+  // Buffers of recorded accesses per shard, and their size.
+  static constexpr std::size_t kStripes = 4;
+  static constexpr std::size_t kStripeSize = 32;
+
+  enum class Segment : std::uint8_t { WINDOW, PROBATION, PROTECTED };
+
+  using NodeHook = boost::intrusive::list_base_hook<
+      boost::intrusive::link_mode<boost::intrusive::normal_link>>;
+
+  struct Node : NodeHook {
+    template <typename V>
+    Node(const TKey& k, V&& v, std::size_t h, std::size_t w)
+        : key(k), value(std::forward<V>(v)), hash(h), weight(w) {}
+
+    const TKey key;
+    TValue value;
+    std::size_t hash;
+    std::size_t weight;
+    Segment segment{Segment::WINDOW};
+  };
+  using NodeList = boost::intrusive::list<Node>;
+
+  struct KeyHasher {
+    using is_transparent = void;
+    using folly_is_avalanching = IsAvalanchingHasher<THash, TKey>;
+
+    const THash* hash;
+
+    template <typename K>
+    std::size_t operator()(const K& key) const {
+      return (*hash)(key);
+    }
+    std::size_t operator()(Node* const& node) const { return node->hash; }
+  };
+
+  struct KeyEqual {
+    using is_transparent = void;
+
+    const TKeyEqual* equal;
+
+    template <typename K>
+    bool operator()(const K& lhs, Node* const& rhs) const {
+      return (*equal)(lhs, rhs->key);
+    }
+    template <typename K>
+    bool operator()(Node* const& lhs, const K& rhs) const {
+      return (*equal)(lhs->key, rhs);
+    }
+    bool operator()(Node* const& lhs, Node* const& rhs) const {
+      return lhs == rhs;
+    }
+  };
+
+  // Accesses recorded by readers holding the shard lock in shared mode,
+  // and applied with it held exclusively.
+  struct alignas(hardware_destructive_interference_size) Stripe {
+    std::atomic<std::size_t> count{0};
+    Node* nodes[kStripeSize];
+  };
+
+  struct Shard {
+    Shard(const ConcurrentEvictingCache& cache, std::size_t cap)
+        : parent(cache),
+          index(0, KeyHasher{&cache.keyHash_}, KeyEqual{&cache.keyEqual_}),
+          capacity(cap),
+          windowCapacity(
+              cache.options_.policy == Policy::LRU
+                  ? cap
+                  : std::max<std::size_t>(1, cap / 100)),
+          protectedCapacity((cap - windowCapacity) * 4 / 5) {
+      if (cache.options_.policy == Policy::W_TINY_LFU) {
+        sketch.emplace(cap);
+      }
+    }
+
+    ~Shard() { clear(/* notify = */ false); }
+
+    template <typename K>
+    Node* find(const K& key, std::size_t hash) const {
+      auto it = index.find(index.prehash(key, hash), key);
+      return it == index.end() ? nullptr : *it;
+    }
+
+    // Returns false if the access did not fit in the buffer.
+    bool recordAccess(Node* node) {
+      auto& stripe = stripes[detail::evictingCacheStripe() % kStripes];
+      auto i = stripe.count.fetch_add(1, std::memory_order_relaxed);
+      if (i >= kStripeSize) {
+        return false;
+      }
+      stripe.nodes[i] = node;
+      return true;
+    }
+
+    void drain() {
+      for (auto& stripe : stripes) {
+        auto n = std::min(
+            stripe.count.load(std::memory_order_relaxed), kStripeSize);
+        for (std::size_t i = 0; i < n; ++i) {
+          onAccess(stripe.nodes[i]);
+        }
+        stripe.count.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    void onAccess(Node* node) {
+      if (sketch) {
+        sketch->increment(node->hash);
+      }
+      switch (node->segment) {
+        case Segment::WINDOW:
+          window.splice(window.begin(), window, window.iterator_to(*node));
+          break;
+        case Segment::PROBATION:
+          probation.erase(probation.iterator_to(*node));
+          node->segment = Segment::PROTECTED;
+          protectedList.push_front(*node);
+          protectedWeight += node->weight;
+          while (protectedWeight > protectedCapacity) {
+            auto& demoted = protectedList.back();
+            protectedList.pop_back();
+            protectedWeight -= demoted.weight;
+            demoted.segment = Segment::PROBATION;
+            probation.push_front(demoted);
+          }
+          break;
+        case Segment::PROTECTED:
+          protectedList.splice(
+              protectedList.begin(),
+              protectedList,
+              protectedList.iterator_to(*node));
+          break;
+      }
+    }
+
+    // Adds node to the window, and evicts entries to make room for it.
+    // Returns whether it is still there.
+    bool add(std::unique_ptr<Node> owner) {
+      auto node = owner.get();
+      index.insert(node);
+      owner.release();
+      if (sketch) {
+        sketch->increment(node->hash);
+      }
+      window.push_front(*node);
+      windowWeight += node->weight;
+      addWeight(node->weight);
+      size.store(index.size(), std::memory_order_relaxed);
+      return evict(node);
+    }
+
+    void addWeight(std::ptrdiff_t delta) {
+      totalWeight += delta;
+      weight.store(totalWeight, std::memory_order_relaxed);
+    }
+
+    // Evicts entries until the shard is within its capacity. Returns
+    // whether node survived.
+    bool evict(Node* node) {
+      bool survived = true;
+      auto evictNode = [&](Node* victim) {
+        survived = survived && victim != node;
+        remove(victim, /* evicted = */ true);
+      };
+      if (!sketch) {
+        while (totalWeight > capacity) {
+          evictNode(&window.back());
+        }
+        return survived;
+      }
+      // Entries leaving the window are candidates for the main space, and
+      // compete with its least recently used entry when it is full.
+      while (windowWeight > windowCapacity) {
+        auto candidate = &window.back();
+        window.pop_back();
+        windowWeight -= candidate->weight;
+        candidate->segment = Segment::PROBATION;
+        probation.push_front(*candidate);
+        while (totalWeight > capacity) {
+          auto victim = mainVictim();
+          if (victim == candidate ||
+              sketch->frequency(candidate->hash) <=
+                  sketch->frequency(victim->hash)) {
+            evictNode(candidate);
+            break;
+          }
+          evictNode(victim);
+        }
+      }
+      while (totalWeight > capacity) {
+        auto victim = mainVictim();
+        evictNode(victim ? victim : &window.back());
+      }
+      return survived;
+    }
+
+    Node* mainVictim() {
+      if (!probation.empty()) {
+        return &probation.back();
+      }
+      if (!protectedList.empty()) {
+        return &protectedList.back();
+      }
+      return nullptr;
+    }
+
+    NodeList& listOf(Node* node) {
+      switch (node->segment) {
+        case Segment::WINDOW:
+          return window;
+        case Segment::PROBATION:
+          return probation;
+        case Segment::PROTECTED:
+          break;
+      }
+      return protectedList;
+    }
+
+    // Changes the weight of node after its value changed, and evicts
+    // entries if it grew.
+    bool reweigh(Node* node, std::size_t newWeight) {
+      auto delta = std::ptrdiff_t(newWeight) - std::ptrdiff_t(node->weight);
+      node->weight = newWeight;
+      if (node->segment == Segment::WINDOW) {
+        windowWeight += delta;
+      } else if (node->segment == Segment::PROTECTED) {
+        protectedWeight += delta;
+      }
+      addWeight(delta);
+      return evict(node);
+    }
+
+    void remove(Node* node, bool evicted) {
+      std::unique_ptr<Node> owner(node);
+      listOf(node).erase(listOf(node).iterator_to(*node));
+      if (node->segment == Segment::WINDOW) {
+        windowWeight -= node->weight;
+      } else if (node->segment == Segment::PROTECTED) {
+        protectedWeight -= node->weight;
+      }
+      addWeight(-std::ptrdiff_t(node->weight));
+      index.erase(node);
+      size.store(index.size(), std::memory_order_relaxed);
+      if (evicted && parent.options_.pruneHook) {
+        parent.options_.pruneHook(node->key, std::move(node->value));
+      }
+    }
+
+    void clear(bool notify = true) {
+      for (auto* list : {&window, &probation, &protectedList}) {
+        while (!list->empty()) {
+          auto node = &list->back();
+          if (notify) {
+            remove(node, /* evicted = */ true);
+          } else {
+            list->pop_back();
+            delete node;
+          }
+        }
+      }
+      index.clear();
+      windowWeight = protectedWeight = 0;
+      addWeight(-std::ptrdiff_t(totalWeight));
+      size.store(0, std::memory_order_relaxed);
+    }
+
+    const ConcurrentEvictingCache& parent;
+    mutable SharedMutex mutex;
+    F14FastSet<Node*, KeyHasher, KeyEqual> index;
+    NodeList window;
+    NodeList probation;
+    NodeList protectedList;
+    std::optional<detail::EvictingCacheFrequencySketch> sketch;
+    const std::size_t capacity;
+    const std::size_t windowCapacity;
+    const std::size_t protectedCapacity;
+    std::size_t totalWeight{0};
+    std::size_t windowWeight{0};
+    std::size_t protectedWeight{0};
+    // Readable without the lock.
+    std::atomic<std::size_t> size{0};
+    std::atomic<std::size_t> weight{0};
+    Stripe stripes[kStripes];
+  };
+
+  Shard& shardFor(std::size_t hash) const {
+    return *shards_[hash::twang_mix64(hash) & shardMask_];
+  }
+
+  std::size_t weigh(const TKey& key, const TValue& value) const {
+    return options_.weigher ? options_.weigher(key, value) : 1;
+  }
+
+  template <typename V>
+  bool setImpl(const TKey& key, V&& value, bool replace) {
+    auto hash = keyHash_(key);
+    auto& shard = shardFor(hash);
+    auto weight = weigh(key, value);
+    std::unique_lock lock(shard.mutex);
+    shard.drain();
+    if (auto node = shard.find(key, hash)) {
+      if (!replace) {
+        return false;
+      }
+      if (weight > shard.capacity) {
+        shard.remove(node, /* evicted = */ true);
+        return false;
+      }
+      node->value = std::forward<V>(value);
+      shard.onAccess(node);
+      return shard.reweigh(node, weight);
+    }
+    if (weight > shard.capacity) {
+      return false;
+    }
+    return shard.add(
+        std::make_unique<Node>(key, std::forward<V>(value), hash, weight));
+  }
+
+  THash keyHash_;
+  TKeyEqual keyEqual_;
+  Options options_;
+  std::size_t capacity_;
+  std::size_t shardMask_{0};
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace folly
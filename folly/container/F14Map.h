@@ -215,7 +215,7 @@ class F14BasicMap {
 
   F14BasicMap& operator=(std::initializer_list<value_type> ilist) {
     clear();
-    bulkInsert(ilist.begin(), ilist.end(), true);
+    rangeInsert(ilist.begin(), ilist.end(), true);
     return *this;
   }
 
@@ -353,7 +353,7 @@ class F14BasicMap {
 
  private:
   template <class InputIt>
-  FOLLY_ALWAYS_INLINE void bulkInsert(
+  FOLLY_ALWAYS_INLINE void rangeInsert(
       InputIt first, InputIt last, bool autoReserve) {
     if (autoReserve) {
       auto n = std::distance(first, last);
@@ -382,7 +382,7 @@ class F14BasicMap {
             std::random_access_iterator_tag,
             typename std::iterator_traits<InputIt>::iterator_category>::value &&
         initialCapacity == 0;
-    bulkInsert(std::move(first), std::move(last), autoReserve);
+    rangeInsert(std::move(first), std::move(last), autoReserve);
   }
 
  public:
@@ -397,7 +397,7 @@ class F14BasicMap {
             std::random_access_iterator_tag,
             typename std::iterator_traits<InputIt>::iterator_category>::value &&
         bucket_count() == 0;
-    bulkInsert(std::move(first), std::move(last), autoReserve);
+    rangeInsert(std::move(first), std::move(last), autoReserve);
   }
 
   /// Add elements from an initializer list
@@ -405,6 +405,46 @@ class F14BasicMap {
     insert(ilist.begin(), ilist.end());
   }
 
+  /**
+   * Add the elements of a random access range, like insert(first, last),
+   * and return how many were inserted.
+   *
+   * Reserves room for the whole range, then hashes the keys and prefetches
+   * their chunks a few elements ahead of inserting them, which overlaps the
+   * cache misses of consecutive inserts into a large map. The elements must
+   * be references to pairs, e.g. an iterator of std::vector<value_type> or
+   * a std::move_iterator of one.
+   *
+   * @methodset Modifiers
+   */
+  template <class RandomIt>
+  std::size_t bulkInsert(RandomIt first, RandomIt last) {
+    static_assert(
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<RandomIt>::iterator_category>::
+            value,
+        "bulkInsert() requires random access iterators");
+    std::size_t n = last - first;
+    if (n == 0) {
+      return 0;
+    }
+    table_.reserveForInsert(n);
+    std::size_t inserted = 0;
+    table_.forEachPrefetched(
+        n,
+        [&](std::size_t i) -> auto const& { return first[i].first; },
+        [&](std::size_t i, F14HashToken const& token) {
+          auto&& value = first[i];
+          inserted += try_emplace_token(
+                          token,
+                          std::forward<decltype(value)>(value).first,
+                          std::forward<decltype(value)>(value).second)
+                          .second;
+        });
+    return inserted;
+  }
+
   /// Insert if the key is missing, overwrite using operator= if present.
   /// @methodset Modifiers
   template <typename M>
@@ -898,6 +938,119 @@ class F14BasicMap {
     return !table_.find(token, key).atEnd();
   }
 
+  /**
+   * @overloadbrief Look up many keys at once.
+   * @methodset Lookup
+   *
+   * bulkFind(keys, out) stores find(keys[i]) in out[i], for each key, and
+   * bulkFind(keys, visitor) calls visitor(i, find(keys[i])) in order. They
+   * hash the keys and prefetch their chunks a few keys ahead of the probes,
+   * so that the cache misses of the lookups overlap instead of being paid
+   * one after the other, like a hand-written loop of prehash(), prefetch()
+   * and find(token, key). This pays off once the map is too large for the
+   * CPU caches. The visitor form is the faster one when the found values
+   * are used right away, as it avoids going through the out array.
+   */
+  void bulkFind(Range<key_type const*> keys, iterator* out) {
+    bulkFindImpl<iterator>(
+        keys, [out](std::size_t i, iterator iter) { out[i] = iter; });
+  }
+
+  void bulkFind(Range<key_type const*> keys, const_iterator* out) const {
+    bulkFindImpl<const_iterator>(
+        keys, [out](std::size_t i, const_iterator iter) { out[i] = iter; });
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, void> bulkFind(
+      Range<K*> keys, iterator* out) {
+    bulkFindImpl<iterator>(
+        keys, [out](std::size_t i, iterator iter) { out[i] = iter; });
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, void> bulkFind(
+      Range<K*> keys, const_iterator* out) const {
+    bulkFindImpl<const_iterator>(
+        keys, [out](std::size_t i, const_iterator iter) { out[i] = iter; });
+  }
+
+  template <typename F>
+  std::enable_if_t<std::is_invocable_v<F&, std::size_t, iterator>> bulkFind(
+      Range<key_type const*> keys, F&& visitor) {
+    bulkFindImpl<iterator>(keys, visitor);
+  }
+
+  template <typename F>
+  std::enable_if_t<std::is_invocable_v<F&, std::size_t, const_iterator>>
+  bulkFind(Range<key_type const*> keys, F&& visitor) const {
+    bulkFindImpl<const_iterator>(keys, visitor);
+  }
+
+  template <typename K, typename F>
+  EnableHeterogeneousFind<
+      std::remove_const_t<K>,
+      std::enable_if_t<std::is_invocable_v<F&, std::size_t, iterator>>>
+  bulkFind(Range<K*> keys, F&& visitor) {
+    bulkFindImpl<iterator>(keys, visitor);
+  }
+
+  template <typename K, typename F>
+  EnableHeterogeneousFind<
+      std::remove_const_t<K>,
+      std::enable_if_t<std::is_invocable_v<F&, std::size_t, const_iterator>>>
+  bulkFind(Range<K*> keys, F&& visitor) const {
+    bulkFindImpl<const_iterator>(keys, visitor);
+  }
+
+  /**
+   * @overloadbrief Check for many keys at once.
+   * @methodset Lookup
+   *
+   * Stores contains(keys[i]) in out[i] and returns the number of keys
+   * found, with the prefetching of bulkFind().
+   */
+  std::size_t bulkContains(Range<key_type const*> keys, bool* out) const {
+    return bulkContainsImpl(keys, out);
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, std::size_t> bulkContains(
+      Range<K*> keys, bool* out) const {
+    return bulkContainsImpl(keys, out);
+  }
+
+ private:
+  template <typename Iter, typename K, typename F>
+  FOLLY_ALWAYS_INLINE void bulkFindImpl(Range<K*> keys, F&& visitor) const {
+    table_.forEachPrefetched(
+        keys.size(),
+        [&](std::size_t i) -> K const& { return keys[i]; },
+        [&](std::size_t i, F14HashToken const& token) {
+          auto iter = table_.find(token, keys[i]);
+          if constexpr (std::is_same_v<Iter, iterator>) {
+            visitor(i, table_.makeIter(iter));
+          } else {
+            visitor(i, table_.makeConstIter(iter));
+          }
+        });
+  }
+
+  template <typename K>
+  std::size_t bulkContainsImpl(Range<K*> keys, bool* out) const {
+    std::size_t found = 0;
+    table_.forEachPrefetched(
+        keys.size(),
+        [&](std::size_t i) -> K const& { return keys[i]; },
+        [&](std::size_t i, F14HashToken const& token) {
+          out[i] = !table_.find(token, keys[i]).atEnd();
+          found += out[i];
+        });
+    return found;
+  }
+
+ public:
+
   /// @overloadbrief Returns the range of elements matching a specific key.
   /// @methodset Lookup
   std::pair<iterator, iterator> equal_range(key_type const& key) {
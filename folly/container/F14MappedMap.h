@@ -0,0 +1,447 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * A read-only hash map that is looked up in place, in a buffer that holds
+ * no pointers, so it can be built once, written to a file, and mapped by
+ * any number of processes without a fix-up pass:
+ *
+ *   // Offline.
+ *   F14FastMap<uint64_t, Entry> map = build();
+ *   writeFile(F14MappedMap<uint64_t, Entry>::serialize(map), "entries.f14");
+ *
+ *   // At startup, in constant time.
+ *   auto entries = F14MappedMap<uint64_t, Entry>::mapFile("entries.f14");
+ *   auto it = entries.find(id);
+ *
+ * The buffer has the layout of an F14VectorMap: the values are stored
+ * contiguously in the order of the map they were serialized from, and
+ * they are indexed by an array of 64 byte chunks that each hold 12 tags
+ * and the 32-bit indexes of their values. Lookups filter the tags of a
+ * chunk with SIMD instructions, like F14, and usually touch one chunk and
+ * one value.
+ *
+ * Keys and mapped values must be trivially copyable, as they are stored
+ * as bytes. The hasher must give the same hashes in the process that
+ * serializes the map and in those that map it, which rules out seeded
+ * hashers, and is checked with the hash of the first key when the buffer
+ * is loaded. The buffer is in the byte order of the machine that wrote
+ * it, and holds at most 2^32 - 1 values.
+ *
+ * @file F14MappedMap.h
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <folly/Portability.h>
+#include <folly/Range.h>
+#include <folly/container/detail/F14Defaults.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Bits.h>
+#include <folly/lang/Exception.h>
+#include <folly/system/MemoryMapping.h>
+
+#if FOLLY_NEON
+#include <arm_neon.h>
+#elif FOLLY_SSE >= 2
+#include <emmintrin.h>
+#endif
+
+namespace folly {
+
+namespace detail {
+
+struct F14MappedHeader {
+  static constexpr std::uint32_t kMagic = 0x4d343146; // "F14M"
+  static constexpr std::uint32_t kVersion = 1;
+
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t keySize;
+  std::uint32_t mappedSize;
+  std::uint32_t valueSize;
+  std::uint32_t mappedOffset;
+  std::uint32_t hashSize;
+  std::uint32_t chunkShift;
+  std::uint64_t size;
+  std::uint64_t valuesOffset;
+  // The hash of the first key, and the chunk index it was mixed into, to
+  // catch a hasher or a mixer that doesn't match the ones the map was
+  // serialized with.
+  std::uint64_t firstKeyHash;
+  std::uint64_t firstKeyIndex;
+};
+
+// The F14Chunk of an F14VectorMap: tags, of which 12 are used, the number
+// of values that overflowed from this chunk to the next ones in their
+// probe sequence, and the indexes of the values.
+struct alignas(64) F14MappedChunk {
+  static constexpr unsigned kCapacity = 12;
+  static constexpr std::uint8_t kOutboundOverflowMax = 254;
+
+  std::array<std::uint8_t, 14> tags;
+  std::uint8_t unused;
+  std::uint8_t outboundOverflowCount;
+  std::array<std::uint32_t, kCapacity> items;
+
+#if FOLLY_NEON
+  static constexpr unsigned kMaskSpacing = 4;
+
+  std::uint64_t tagMatchMask(std::size_t tag) const {
+    auto eqV = vceqq_u8(
+        vld1q_u8(tags.data()), vdupq_n_u8(static_cast<std::uint8_t>(tag)));
+    auto maskV = vshrn_n_u16(vreinterpretq_u16_u8(eqV), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(maskV), 0) & 0x111111111111;
+  }
+#elif FOLLY_SSE >= 2
+  static constexpr unsigned kMaskSpacing = 1;
+
+  std::uint64_t tagMatchMask(std::size_t tag) const {
+    auto tagV = _mm_load_si128(reinterpret_cast<__m128i const*>(tags.data()));
+    auto eqV =
+        _mm_cmpeq_epi8(tagV, _mm_set1_epi8(static_cast<std::uint8_t>(tag)));
+    return static_cast<unsigned>(_mm_movemask_epi8(eqV)) & 0xfff;
+  }
+#else
+  static constexpr unsigned kMaskSpacing = 1;
+
+  std::uint64_t tagMatchMask(std::size_t tag) const {
+    std::uint64_t mask = 0;
+    for (unsigned i = 0; i < kCapacity; ++i) {
+      mask |= std::uint64_t(tags[i] == tag) << i;
+    }
+    return mask;
+  }
+#endif
+};
+
+static_assert(sizeof(F14MappedHeader) == 64);
+static_assert(sizeof(F14MappedChunk) == 64);
+
+} // namespace detail
+
+template <
+    typename K,
+    typename M,
+    typename Hasher = f14::DefaultHasher<K>,
+    typename KeyEqual = f14::DefaultKeyEqual<K>>
+class F14MappedMap {
+  static_assert(
+      std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<M>,
+      "F14MappedMap stores keys and values as bytes");
+
+  using Header = detail::F14MappedHeader;
+  using Chunk = detail::F14MappedChunk;
+
+ public:
+  using key_type = K;
+  using mapped_type = M;
+  using value_type = std::pair<K, M>;
+  using size_type = std::size_t;
+  using hasher = Hasher;
+  using key_equal = KeyEqual;
+  using const_reference = value_type const&;
+  using const_pointer = value_type const*;
+  using const_iterator = value_type const*;
+  using iterator = const_iterator;
+
+  /**
+   * The buffer of a map with the elements of map, a container of pairs of
+   * K and M with distinct keys, like an F14 map. Throws std::length_error
+   * if map has 2^32 values or more.
+   */
+  template <typename Map>
+  static std::string serialize(Map const& map);
+
+  /**
+   * Use a buffer returned by serialize() without copying it. bytes must be
+   * aligned like a value_type and on 16 bytes, and must outlive the result
+   * and its copies.
+   *
+   * Only the header is checked, so this is constant time; call validate()
+   * before looking up a buffer that may be corrupt.
+   */
+  static F14MappedMap fromBytes(ByteRange bytes);
+
+  /**
+   * Map a file that holds a buffer returned by serialize(). The mapping is
+   * shared by the copies of the result, and unmapped with the last of them.
+   */
+  static F14MappedMap mapFile(char const* path);
+
+  /**
+   * An empty map.
+   */
+  F14MappedMap() = default;
+
+  ByteRange bytes() const { return bytes_; }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /// The values, in the order of the map they were serialized from.
+  const_iterator begin() const { return values_; }
+  const_iterator end() const { return values_ + size_; }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  const_iterator find(key_type const& key) const {
+    if (FOLLY_UNLIKELY(size_ == 0)) {
+      return end();
+    }
+    auto hp = splitHash(Hasher{}(key));
+    std::size_t index = hp.first;
+    std::size_t step = 2 * hp.second + 1;
+    for (std::size_t tries = chunkMask_ + 1; tries > 0; --tries) {
+      auto& chunk = chunks_[index & chunkMask_];
+      auto hits = chunk.tagMatchMask(hp.second);
+      while (hits != 0) {
+        auto i = findFirstSet(hits) - 1;
+        hits &= hits - 1;
+        auto& value = values_[chunk.items[i / Chunk::kMaskSpacing]];
+        if (FOLLY_LIKELY(KeyEqual{}(key, value.first))) {
+          return &value;
+        }
+      }
+      if (FOLLY_LIKELY(chunk.outboundOverflowCount == 0)) {
+        break;
+      }
+      index += step;
+    }
+    return end();
+  }
+
+  bool contains(key_type const& key) const { return find(key) != end(); }
+
+  size_type count(key_type const& key) const { return contains(key); }
+
+  /// Throws std::out_of_range if key is missing.
+  mapped_type const& at(key_type const& key) const {
+    auto it = find(key);
+    if (it == end()) {
+      throw_exception<std::out_of_range>("F14MappedMap::at() key not found");
+    }
+    return it->second;
+  }
+
+  /**
+   * Check that every index of the chunks refers to a value, once, and that
+   * every value can be found. Throws std::runtime_error if not.
+   */
+  void validate() const;
+
+ private:
+  // The bits that select the first chunk of a hash, and its tag. Unlike
+  // F14's, the split doesn't depend on the instructions available, so that
+  // the buffers are portable. The mixer is short, as it is on the critical
+  // path of the cache misses of a lookup.
+  static std::pair<std::size_t, std::size_t> splitHash(std::uint64_t hash) {
+    if (!IsAvalanchingHasher<Hasher, K>::value) {
+#if FOLLY_HAVE_INT128_T
+      auto product = static_cast<unsigned __int128>(hash) * kMul;
+      hash = static_cast<std::uint64_t>(product >> 64) ^
+          static_cast<std::uint64_t>(product);
+#else
+      hash = hash::twang_mix64(hash);
+#endif
+    }
+    return {static_cast<std::size_t>(hash), (hash >> 56) | 0x80};
+  }
+
+  static constexpr std::uint64_t kMul = 0xc4ceb9fe1a85ec53;
+
+  [[noreturn]] static void throwCorrupt(char const* what) {
+    throw_exception<std::runtime_error>(
+        std::string("F14MappedMap: corrupt buffer: ") + what);
+  }
+
+  ByteRange bytes_;
+  Chunk const* chunks_{nullptr};
+  std::size_t chunkMask_{0};
+  value_type const* values_{nullptr};
+  std::size_t size_{0};
+  // Keeps the bytes alive, unless they are borrowed.
+  std::shared_ptr<void const> owner_;
+};
+
+template <typename K, typename M, typename Hasher, typename KeyEqual>
+template <typename Map>
+std::string F14MappedMap<K, M, Hasher, KeyEqual>::serialize(Map const& map) {
+  std::size_t n = map.size();
+  if (n > std::numeric_limits<std::uint32_t>::max() - 1) {
+    throw_exception<std::length_error>("F14MappedMap: too many values");
+  }
+  // At most 10 values per chunk of 12, like a full F14VectorMap.
+  std::size_t chunkShift = 0;
+  while ((std::size_t{10} << chunkShift) < n) {
+    ++chunkShift;
+  }
+  std::size_t numChunks = std::size_t{1} << chunkShift;
+  std::size_t valuesOffset = sizeof(Header) + numChunks * sizeof(Chunk);
+  std::string ret(valuesOffset + n * sizeof(value_type), '\0');
+  auto base = reinterpret_cast<std::uint8_t*>(ret.data());
+
+  Header header{};
+  header.magic = Header::kMagic;
+  header.version = Header::kVersion;
+  header.keySize = sizeof(K);
+  header.mappedSize = sizeof(M);
+  header.valueSize = sizeof(value_type);
+  header.mappedOffset = offsetof(value_type, second);
+  header.hashSize = sizeof(std::size_t);
+  header.chunkShift = static_cast<std::uint32_t>(chunkShift);
+  header.size = n;
+  header.valuesOffset = valuesOffset;
+
+  auto chunks = reinterpret_cast<Chunk*>(base + sizeof(Header));
+  std::uint32_t item = 0;
+  for (auto const& [key, mapped] : map) {
+    std::uint64_t hash = Hasher{}(key);
+    auto hp = splitHash(hash);
+    if (item == 0) {
+      header.firstKeyHash = hash;
+      header.firstKeyIndex = hp.first;
+    }
+    value_type value(key, mapped);
+    std::memcpy(
+        base + valuesOffset + item * sizeof(value_type),
+        &value,
+        sizeof(value_type));
+
+    std::size_t index = hp.first;
+    while (true) {
+      auto& chunk = chunks[index & (numChunks - 1)];
+      auto slot = std::find(
+          chunk.tags.begin(), chunk.tags.begin() + Chunk::kCapacity, 0);
+      if (slot != chunk.tags.begin() + Chunk::kCapacity) {
+        *slot = static_cast<std::uint8_t>(hp.second);
+        chunk.items[slot - chunk.tags.begin()] = item;
+        break;
+      }
+      if (chunk.outboundOverflowCount != Chunk::kOutboundOverflowMax) {
+        ++chunk.outboundOverflowCount;
+      }
+      index += 2 * hp.second + 1;
+    }
+    ++item;
+  }
+  std::memcpy(base, &header, sizeof(header));
+  return ret;
+}
+
+template <typename K, typename M, typename Hasher, typename KeyEqual>
+F14MappedMap<K, M, Hasher, KeyEqual>
+F14MappedMap<K, M, Hasher, KeyEqual>::fromBytes(ByteRange bytes) {
+  auto alignment = std::max<std::size_t>(16, alignof(value_type));
+  if (reinterpret_cast<std::uintptr_t>(bytes.data()) % alignment != 0) {
+    throw_exception<std::invalid_argument>("F14MappedMap: misaligned buffer");
+  }
+  Header header;
+  if (bytes.size() < sizeof(header)) {
+    throwCorrupt("truncated header");
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != Header::kMagic) {
+    throwCorrupt("bad magic");
+  }
+  if (header.version != Header::kVersion) {
+    throwCorrupt("unsupported version");
+  }
+  if (header.keySize != sizeof(K) || header.mappedSize != sizeof(M) ||
+      header.valueSize != sizeof(value_type) ||
+      header.mappedOffset != offsetof(value_type, second) ||
+      header.hashSize != sizeof(std::size_t)) {
+    throwCorrupt("types don't match");
+  }
+  if (header.chunkShift >= 32) {
+    throwCorrupt("too many chunks");
+  }
+  std::uint64_t numChunks = std::uint64_t{1} << header.chunkShift;
+  if (header.valuesOffset != sizeof(Header) + numChunks * sizeof(Chunk) ||
+      header.size > (std::uint64_t{10} << header.chunkShift) ||
+      header.valuesOffset + header.size * sizeof(value_type) > bytes.size()) {
+    throwCorrupt("size out of bounds");
+  }
+
+  F14MappedMap ret;
+  ret.bytes_ = bytes;
+  ret.chunks_ = reinterpret_cast<Chunk const*>(bytes.data() + sizeof(Header));
+  ret.chunkMask_ = numChunks - 1;
+  ret.values_ =
+      reinterpret_cast<value_type const*>(bytes.data() + header.valuesOffset);
+  ret.size_ = header.size;
+  if (ret.size_ > 0) {
+    std::uint64_t hash = Hasher{}(ret.values_[0].first);
+    if (hash != header.firstKeyHash ||
+        splitHash(hash).first != header.firstKeyIndex) {
+      throwCorrupt("hasher doesn't match");
+    }
+  }
+  return ret;
+}
+
+template <typename K, typename M, typename Hasher, typename KeyEqual>
+F14MappedMap<K, M, Hasher, KeyEqual>
+F14MappedMap<K, M, Hasher, KeyEqual>::mapFile(char const* path) {
+  auto mapping = std::make_shared<MemoryMapping>(path);
+  auto ret = fromBytes(mapping->range());
+  ret.owner_ = std::move(mapping);
+  return ret;
+}
+
+template <typename K, typename M, typename Hasher, typename KeyEqual>
+void F14MappedMap<K, M, Hasher, KeyEqual>::validate() const {
+  if (size_ == 0) {
+    return;
+  }
+  std::unique_ptr<bool[]> seen(new bool[size_]());
+  for (std::size_t c = 0; c <= chunkMask_; ++c) {
+    auto& chunk = chunks_[c];
+    for (unsigned i = 0; i < chunk.tags.size(); ++i) {
+      if (chunk.tags[i] == 0) {
+        continue;
+      }
+      if (i >= Chunk::kCapacity || (chunk.tags[i] & 0x80) == 0) {
+        throwCorrupt("bad tag");
+      }
+      auto item = chunk.items[i];
+      if (item >= size_ || seen[item]) {
+        throwCorrupt("bad index");
+      }
+      seen[item] = true;
+    }
+  }
+  for (auto const& value : *this) {
+    if (!seen[&value - values_] || find(value.first) != &value) {
+      throwCorrupt("value can't be found");
+    }
+  }
+}
+
+} // namespace folly
@@ -33,6 +33,7 @@
 #include <tuple>
 
 #include <folly/Portability.h>
+#include <folly/Range.h>
 #include <folly/container/View.h>
 #include <folly/lang/SafeAssert.h>
 
@@ -209,7 +210,7 @@ class F14BasicSet {
 
   F14BasicSet& operator=(std::initializer_list<value_type> ilist) {
     clear();
-    bulkInsert(ilist.begin(), ilist.end(), true);
+    rangeInsert(ilist.begin(), ilist.end(), true);
     return *this;
   }
 
@@ -303,7 +304,7 @@ class F14BasicSet {
 
  private:
   template <class InputIt>
-  FOLLY_ALWAYS_INLINE void bulkInsert(
+  FOLLY_ALWAYS_INLINE void rangeInsert(
       InputIt first, InputIt last, bool autoReserve) {
     if (autoReserve) {
       auto n = std::distance(first, last);
@@ -332,7 +333,7 @@ class F14BasicSet {
             std::random_access_iterator_tag,
             typename std::iterator_traits<InputIt>::iterator_category>::value &&
         initialCapacity == 0;
-    bulkInsert(first, last, autoReserve);
+    rangeInsert(first, last, autoReserve);
   }
 
  public:
@@ -347,7 +348,7 @@ class F14BasicSet {
             std::random_access_iterator_tag,
             typename std::iterator_traits<InputIt>::iterator_category>::value &&
         bucket_count() == 0;
-    bulkInsert(first, last, autoReserve);
+    rangeInsert(first, last, autoReserve);
   }
 
   /// Add elements from an initializer list.
@@ -355,6 +356,41 @@ class F14BasicSet {
     insert(ilist.begin(), ilist.end());
   }
 
+  /**
+   * Add the elements of a random access range, like insert(first, last),
+   * and return how many were inserted.
+   *
+   * Reserves room for the whole range, then hashes the elements and
+   * prefetches their chunks a few elements ahead of inserting them, which
+   * overlaps the cache misses of consecutive inserts into a large set. The
+   * elements must be references, e.g. an iterator of
+   * std::vector<value_type> or a std::move_iterator of one.
+   *
+   * @methodset Modifiers
+   */
+  template <class RandomIt>
+  std::size_t bulkInsert(RandomIt first, RandomIt last) {
+    static_assert(
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<RandomIt>::iterator_category>::
+            value,
+        "bulkInsert() requires random access iterators");
+    std::size_t n = last - first;
+    if (n == 0) {
+      return 0;
+    }
+    table_.reserveForInsert(n);
+    std::size_t inserted = 0;
+    table_.forEachPrefetched(
+        n,
+        [&](std::size_t i) -> auto const& { return first[i]; },
+        [&](std::size_t i, F14HashToken const& token) {
+          inserted += emplace_token(token, first[i]).second;
+        });
+    return inserted;
+  }
+
  private:
   template <typename Arg>
   using UsableAsKey = ::folly::detail::
@@ -627,6 +663,86 @@ class F14BasicSet {
     return !table_.find(token, key).atEnd();
   }
 
+  /**
+   * @overloadbrief Look up many keys at once.
+   * @methodset Lookup
+   *
+   * bulkFind(keys, out) stores find(keys[i]) in out[i], for each key, and
+   * bulkFind(keys, visitor) calls visitor(i, find(keys[i])) in order. They
+   * hash the keys and prefetch their chunks a few keys ahead of the probes,
+   * so that the cache misses of the lookups overlap instead of being paid
+   * one after the other, like a hand-written loop of prehash(), prefetch()
+   * and find(token, key). This pays off once the set is too large for the
+   * CPU caches. The visitor form is the faster one when the found values
+   * are used right away, as it avoids going through the out array.
+   */
+  void bulkFind(Range<key_type const*> keys, iterator* out) const {
+    bulkFindImpl(keys, [out](std::size_t i, iterator iter) { out[i] = iter; });
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, void> bulkFind(
+      Range<K*> keys, iterator* out) const {
+    bulkFindImpl(keys, [out](std::size_t i, iterator iter) { out[i] = iter; });
+  }
+
+  template <typename F>
+  std::enable_if_t<std::is_invocable_v<F&, std::size_t, iterator>> bulkFind(
+      Range<key_type const*> keys, F&& visitor) const {
+    bulkFindImpl(keys, visitor);
+  }
+
+  template <typename K, typename F>
+  EnableHeterogeneousFind<
+      std::remove_const_t<K>,
+      std::enable_if_t<std::is_invocable_v<F&, std::size_t, iterator>>>
+  bulkFind(Range<K*> keys, F&& visitor) const {
+    bulkFindImpl(keys, visitor);
+  }
+
+  /**
+   * @overloadbrief Check for many keys at once.
+   * @methodset Lookup
+   *
+   * Stores contains(keys[i]) in out[i] and returns the number of keys
+   * found, with the prefetching of bulkFind().
+   */
+  std::size_t bulkContains(Range<key_type const*> keys, bool* out) const {
+    return bulkContainsImpl(keys, out);
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, std::size_t> bulkContains(
+      Range<K*> keys, bool* out) const {
+    return bulkContainsImpl(keys, out);
+  }
+
+ private:
+  template <typename K, typename F>
+  FOLLY_ALWAYS_INLINE void bulkFindImpl(Range<K*> keys, F&& visitor) const {
+    table_.forEachPrefetched(
+        keys.size(),
+        [&](std::size_t i) -> K const& { return keys[i]; },
+        [&](std::size_t i, F14HashToken const& token) {
+          visitor(i, table_.makeIter(table_.find(token, keys[i])));
+        });
+  }
+
+  template <typename K>
+  std::size_t bulkContainsImpl(Range<K*> keys, bool* out) const {
+    std::size_t found = 0;
+    table_.forEachPrefetched(
+        keys.size(),
+        [&](std::size_t i) -> K const& { return keys[i]; },
+        [&](std::size_t i, F14HashToken const& token) {
+          out[i] = !table_.find(token, keys[i]).atEnd();
+          found += out[i];
+        });
+    return found;
+  }
+
+ public:
+
   /**
    * @overloadbrief Returns the range of elements matching a specific key.
    * @methodset Lookup
@@ -24,6 +24,9 @@ struct HeterogeneousAccessEqualTo;
 template <typename T, typename Enable = void>
 struct HeterogeneousAccessHash;
 
+template <typename T, typename Enable = void>
+struct HeterogeneousAccessLess;
+
 template <typename CharT>
 struct TransparentStringEqualTo;
 
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <string>
 #include <string_view>
@@ -27,18 +28,18 @@
 
 namespace folly {
 
-// folly::HeterogeneousAccessEqualTo<T>, and
-// folly::HeterogeneousAccessHash<T> are functors suitable as defaults
+// folly::HeterogeneousAccessEqualTo<T>,
+// folly::HeterogeneousAccessHash<T>, and
+// folly::HeterogeneousAccessLess<T> are functors suitable as defaults
 // for containers that support heterogeneous access.  When possible, they
 // will be marked as transparent.  When no transparent implementation
-// is available then they fall back to std::equal_to and std::hash
-// respectively.  Since the fallbacks are not marked as transparent,
-// heterogeneous lookup won't be available in that case.  A corresponding
-// HeterogeneousAccessLess<T> could be easily added if desired.
+// is available then they fall back to std::equal_to, std::hash and
+// std::less respectively.  Since the fallbacks are not marked as
+// transparent, heterogeneous lookup won't be available in that case.
 //
 // If T can be implicitly converted to a StringPiece or
 // to a Range<T::value_type const*> that is hashable, then
-// HeterogeneousAccess{EqualTo,Hash}<T> will be transparent without any
+// HeterogeneousAccess{EqualTo,Hash,Less}<T> will be transparent without any
 // additional work.  In practice this is true for T that can be convered to
 // StringPiece or Range<IntegralType const*>.  This includes std::string,
 // std::string_view (when available), std::array, folly::Range,
@@ -56,6 +57,9 @@ struct HeterogeneousAccessHash : std::hash<T> {
   using folly_is_avalanching = IsAvalanchingHasher<std::hash<T>, T>;
 };
 
+template <typename T, typename Enable>
+struct HeterogeneousAccessLess : std::less<T> {};
+
 //////// strings
 
 namespace detail {
@@ -99,6 +103,40 @@ struct TransparentRangeEqualTo {
   }
 };
 
+template <typename T>
+struct TransparentRangeLess {
+  using is_transparent = void;
+
+  template <typename U1, typename U2>
+  bool operator()(U1 const& lhs, U2 const& rhs) const {
+    Range<T const*> l{lhs};
+    Range<T const*> r{rhs};
+    return std::lexicographical_compare(l.begin(), l.end(), r.begin(), r.end());
+  }
+};
+
+template <>
+struct TransparentRangeLess<char> {
+  using is_transparent = void;
+
+  // Comparing as std::string_view, rather than element by element, keeps
+  // the order of std::less<std::string> on platforms where char is signed.
+  template <typename U1, typename U2>
+  bool operator()(U1 const& lhs, U2 const& rhs) const {
+    StringPiece l{lhs};
+    StringPiece r{rhs};
+    return std::string_view{l.data(), l.size()} <
+        std::string_view{r.data(), r.size()};
+  }
+
+  // This overload is not required for functionality, but
+  // guarantees that replacing std::less<std::string> with
+  // HeterogeneousAccessLess<std::string> is truly zero overhead
+  bool operator()(std::string const& lhs, std::string const& rhs) const {
+    return lhs < rhs;
+  }
+};
+
 template <typename T>
 struct TransparentRangeHash {
   using is_transparent = void;
@@ -168,4 +206,12 @@ struct HeterogeneousAccessHash<
           typename detail::ValueTypeForTransparentConversionToRange<T>::type> {
 };
 
+template <typename T>
+struct HeterogeneousAccessLess<
+    T,
+    std::enable_if_t<detail::TransparentlyConvertibleToRange<T>::value>>
+    : detail::TransparentRangeLess<
+          typename detail::ValueTypeForTransparentConversionToRange<T>::type> {
+};
+
 } // namespace folly
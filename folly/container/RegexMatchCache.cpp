@@ -29,6 +29,7 @@
 #include <folly/container/Reserve.h>
 #include <folly/ssl/OpenSSLHash.h>
 #include <folly/synchronization/AtomicUtil.h>
+#include <folly/synchronization/Rcu.h>
 
 namespace folly {
 
@@ -528,4 +529,290 @@ void RegexMatchCache::purge(time_point const expiry) {
   }
 }
 
+struct ConcurrentRegexMatchCache::Entry {
+  std::shared_ptr<RegexObject const> object;
+  mutable std::atomic<time_point> accessed_at;
+  std::vector<string_pointer> matches;
+
+  Entry(
+      std::shared_ptr<RegexObject const> object_,
+      time_point const accessed_at_,
+      std::vector<string_pointer> matches_) noexcept
+      : object{std::move(object_)},
+        accessed_at{accessed_at_},
+        matches{std::move(matches_)} {}
+
+  void touch(time_point const now) const noexcept {
+    atomic_fetch_modify(
+        accessed_at,
+        [now](auto const val) { return std::max(now, val); },
+        std::memory_order_relaxed);
+  }
+};
+
+struct ConcurrentRegexMatchCache::Snapshot : rcu_obj_base<Snapshot> {
+  folly::F14FastMap<regex_key, std::shared_ptr<Entry const>> entries;
+};
+
+void ConcurrentRegexMatchCache::publish(
+    std::unique_ptr<Snapshot> next) noexcept {
+  if (next && next->entries.empty()) {
+    next = nullptr;
+  }
+  auto const prev =
+      snapshot_.exchange(next.release(), std::memory_order_acq_rel);
+  if (prev) {
+    prev->retire();
+  }
+}
+
+void ConcurrentRegexMatchCache::repair() noexcept {
+  publish(nullptr);
+}
+
+ConcurrentRegexMatchCache::ConcurrentRegexMatchCache() noexcept = default;
+
+ConcurrentRegexMatchCache::~ConcurrentRegexMatchCache() {
+  delete snapshot_.load(std::memory_order_relaxed);
+}
+
+std::vector<ConcurrentRegexMatchCache::string_pointer>
+ConcurrentRegexMatchCache::getStringList() const {
+  std::unique_lock lock{mutex_};
+  std::vector<string_pointer> result;
+  result.reserve(strings_.size());
+  for (auto const& [string, serial] : strings_) {
+    result.push_back(string);
+  }
+  return result;
+}
+
+bool ConcurrentRegexMatchCache::hasRegex(
+    regex_key const& regex) const noexcept {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  auto const snapshot = snapshot_.load(std::memory_order_acquire);
+  return snapshot && snapshot->entries.contains(regex);
+}
+
+void ConcurrentRegexMatchCache::eraseRegex(regex_key const& regex) {
+  std::unique_lock lock{mutex_};
+  auto const prev = snapshot_.load(std::memory_order_relaxed);
+  if (!prev || !prev->entries.contains(regex)) {
+    return;
+  }
+  auto next = std::make_unique<Snapshot>();
+  next->entries = prev->entries;
+  next->entries.erase(regex);
+  publish(std::move(next));
+}
+
+bool ConcurrentRegexMatchCache::hasString(string_pointer const string) const {
+  std::unique_lock lock{mutex_};
+  return strings_.contains(string);
+}
+
+void ConcurrentRegexMatchCache::addString(string_pointer const string) {
+  addStrings({&string, 1});
+}
+
+void ConcurrentRegexMatchCache::addStrings(
+    span<string_pointer const> const strings) {
+  std::unique_lock lock{mutex_};
+
+  //  a string in the universe which a cached regex was not evaluated over
+  //  would make that regex stale, so on any failure purge all regexes
+  auto guard = makeGuard(std::bind(&ConcurrentRegexMatchCache::repair, this));
+  auto const serial = ++serial_;
+  std::vector<string_pointer> added;
+  for (auto const string : strings) {
+    if (strings_.try_emplace(string, serial).second) {
+      added.push_back(string);
+    }
+  }
+  auto const prev = snapshot_.load(std::memory_order_relaxed);
+  if (added.empty() || !prev) {
+    guard.dismiss();
+    return;
+  }
+
+  //  evaluate all cached regexes over the added strings as one batch
+  auto next = std::make_unique<Snapshot>();
+  next->entries.reserve(prev->entries.size());
+  std::vector<string_pointer> hits;
+  for (auto const& [regex, entry] : prev->entries) {
+    hits.clear();
+    for (auto const string : added) {
+      if ((*entry->object)(*string)) {
+        hits.push_back(string);
+      }
+    }
+    if (hits.empty()) {
+      next->entries.emplace(regex, entry);
+      continue;
+    }
+    auto matches = entry->matches;
+    matches.insert(matches.end(), hits.begin(), hits.end());
+    next->entries.emplace(
+        regex,
+        std::make_shared<Entry const>(
+            entry->object,
+            entry->accessed_at.load(std::memory_order_relaxed),
+            std::move(matches)));
+  }
+  publish(std::move(next));
+  guard.dismiss();
+}
+
+void ConcurrentRegexMatchCache::eraseString(string_pointer const string) {
+  {
+    std::unique_lock lock{mutex_};
+    if (!strings_.erase(string)) {
+      return;
+    }
+    auto guard = makeGuard(std::bind(&ConcurrentRegexMatchCache::repair, this));
+    auto const prev = snapshot_.load(std::memory_order_relaxed);
+    if (prev) {
+      auto next = std::make_unique<Snapshot>();
+      next->entries.reserve(prev->entries.size());
+      for (auto const& [regex, entry] : prev->entries) {
+        auto const& matches = entry->matches;
+        auto const iter = std::find(matches.begin(), matches.end(), string);
+        if (iter == matches.end()) {
+          next->entries.emplace(regex, entry);
+          continue;
+        }
+        std::vector<string_pointer> rest;
+        rest.reserve(matches.size() - 1);
+        rest.insert(rest.end(), matches.begin(), iter);
+        rest.insert(rest.end(), std::next(iter), matches.end());
+        next->entries.emplace(
+            regex,
+            std::make_shared<Entry const>(
+                entry->object,
+                entry->accessed_at.load(std::memory_order_relaxed),
+                std::move(rest)));
+      }
+      publish(std::move(next));
+    }
+    guard.dismiss();
+  }
+
+  //  wait out lookups which copied the universe before the erase and may still
+  //  be evaluating a regex over the string
+  std::unique_lock evaluating{evaluating_};
+}
+
+std::optional<std::vector<ConcurrentRegexMatchCache::string_pointer>>
+ConcurrentRegexMatchCache::findMatchesIfCached(
+    regex_key const& regex, time_point const now) const {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  auto const snapshot = snapshot_.load(std::memory_order_acquire);
+  auto const entry = !snapshot ? nullptr : get_ptr(snapshot->entries, regex);
+  if (!entry) {
+    return std::nullopt;
+  }
+  (*entry)->touch(now);
+  return (*entry)->matches;
+}
+
+std::vector<ConcurrentRegexMatchCache::string_pointer>
+ConcurrentRegexMatchCache::findMatches(
+    regex_key_and_view const& regex, time_point const now) {
+  if (auto matches = findMatchesIfCached(regex.key, now)) {
+    return std::move(*matches);
+  }
+
+  //  evaluate the regex over a copy of the universe without holding the lock
+  auto const object = std::make_shared<RegexObject const>(regex.view);
+  std::vector<string_pointer> matches;
+  uint64_t serial;
+  {
+    std::shared_lock evaluating{evaluating_};
+    std::vector<string_pointer> strings;
+    {
+      std::unique_lock lock{mutex_};
+      serial = serial_;
+      strings.reserve(strings_.size());
+      for (auto const& [string, added] : strings_) {
+        strings.push_back(string);
+      }
+    }
+    for (auto const string : strings) {
+      if ((*object)(*string)) {
+        matches.push_back(string);
+      }
+    }
+  }
+
+  //  reconcile with strings added or erased in the meantime, and publish
+  std::unique_lock lock{mutex_};
+  auto const prev = snapshot_.load(std::memory_order_relaxed);
+  if (auto const entry = !prev ? nullptr : get_ptr(prev->entries, regex.key)) {
+    (*entry)->touch(now);
+    return (*entry)->matches;
+  }
+  auto const stale = [&](string_pointer const string) {
+    auto const added = get_ptr(strings_, string);
+    return !added || *added > serial;
+  };
+  matches.erase(
+      std::remove_if(matches.begin(), matches.end(), stale), matches.end());
+  for (auto const& [string, added] : strings_) {
+    if (added > serial && (*object)(*string)) {
+      matches.push_back(string);
+    }
+  }
+  auto next = std::make_unique<Snapshot>();
+  if (prev) {
+    next->entries = prev->entries;
+  }
+  next->entries.emplace(
+      regex.key, std::make_shared<Entry const>(object, now, matches));
+  publish(std::move(next));
+  return matches;
+}
+
+bool ConcurrentRegexMatchCache::hasItemsToPurge(
+    time_point const expiry) const noexcept {
+  std::scoped_lock<rcu_domain> reader{rcu_default_domain()};
+  auto const snapshot = snapshot_.load(std::memory_order_acquire);
+  if (!snapshot) {
+    return false;
+  }
+  for (auto const& [regex, entry] : snapshot->entries) {
+    auto const accessed_at = entry->accessed_at.load(std::memory_order_relaxed);
+    if (accessed_at <= expiry) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ConcurrentRegexMatchCache::clear() {
+  {
+    std::unique_lock lock{mutex_};
+    std::exchange(strings_, {});
+    publish(nullptr);
+  }
+  std::unique_lock evaluating{evaluating_};
+}
+
+void ConcurrentRegexMatchCache::purge(time_point const expiry) {
+  std::unique_lock lock{mutex_};
+  auto const prev = snapshot_.load(std::memory_order_relaxed);
+  if (!prev) {
+    return;
+  }
+  auto next = std::make_unique<Snapshot>();
+  for (auto const& [regex, entry] : prev->entries) {
+    auto const accessed_at = entry->accessed_at.load(std::memory_order_relaxed);
+    if (!(accessed_at <= expiry)) {
+      next->entries.emplace(regex, entry);
+    }
+  }
+  if (next->entries.size() != prev->entries.size()) {
+    publish(std::move(next));
+  }
+}
+
 } // namespace folly
@@ -17,9 +17,13 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -29,6 +33,7 @@
 
 #include <folly/Chrono.h>
 #include <folly/Function.h>
+#include <folly/SharedMutex.h>
 #include <folly/container/F14Map.h>
 #include <folly/container/F14Set.h>
 #include <folly/container/Reserve.h>
@@ -525,6 +530,8 @@ class RegexMatchCache {
   using regex_key_and_view = RegexMatchCacheKeyAndView;
 
  private:
+  friend class ConcurrentRegexMatchCache;
+
   using regex_pointer = regex_key const*;
   using string_pointer = std::string const*;
 
@@ -699,4 +706,106 @@ class RegexMatchCache {
   void purge(time_point expiry);
 };
 
+/// ConcurrentRegexMatchCache
+///
+/// A thread-safe cache around boost::regex_match(string, regex). It is meant
+/// for many threads that look up the same regexes over a shared set of strings.
+///
+/// Like RegexMatchCache, the data structure owns regexes but does not own
+/// strings. Unlike RegexMatchCache, all member functions may be called
+/// concurrently, without external synchronization.
+///
+/// Cached results are published as an immutable snapshot:
+/// * A lookup of a cached regex reads the snapshot within an RCU reader section
+///   and takes no locks.
+/// * A lookup of an uncached regex compiles the regex and evaluates it over the
+///   strings without holding the writer lock. It takes the lock only to
+///   reconcile with strings added or erased in the meantime and to publish.
+///
+/// Strings are matched eagerly. Addition of strings evaluates every cached
+/// regex over the new strings in one batch and publishes once. Cached regexes
+/// therefore never go stale, and lookups never need to coalesce.
+///
+/// Each publication copies the map of cached regexes but shares the match lists
+/// of regexes which did not change. Its cost is small next to the regex
+/// evaluations which precede it.
+///
+/// Lookups racing with eraseString may still return the erased string. Once
+/// eraseString returns, no lookup is still evaluating a regex over the string.
+///
+/// The data structure is exception-safe in the same sense as RegexMatchCache.
+/// If evaluating a cached regex over added strings throws, all cached regexes
+/// are purged, the strings are kept, and the exception propagates. A lookup
+/// whose regex fails to parse or to evaluate leaves the cache unchanged.
+class ConcurrentRegexMatchCache {
+ public:
+  using clock = RegexMatchCache::clock;
+  using time_point = RegexMatchCache::time_point;
+
+  using regex_key = RegexMatchCacheKey;
+  using regex_key_and_view = RegexMatchCacheKeyAndView;
+  using string_pointer = std::string const*;
+
+ private:
+  using RegexObject = RegexMatchCache::RegexObject;
+
+  struct Entry;
+  struct Snapshot;
+
+  /// snapshot_
+  ///
+  /// The published map from cached regexes to their matches. Null when no
+  /// regexes are cached. Replaced only with mutex_ held, and retired through
+  /// RCU.
+  std::atomic<Snapshot*> snapshot_{nullptr};
+
+  mutable std::mutex mutex_;
+
+  /// evaluating_
+  ///
+  /// Held shared by lookups while they evaluate a regex over strings without
+  /// holding mutex_, and held exclusive by eraseString to wait them out.
+  mutable SharedMutex evaluating_;
+
+  /// strings_
+  ///
+  /// The universe of strings, each mapped to the serial at which it was added.
+  /// A lookup which copies the universe and evaluates it without holding
+  /// mutex_ uses the serials to find the strings added in the meantime.
+  ///
+  /// Guarded by mutex_.
+  folly::F14FastMap<string_pointer, uint64_t> strings_;
+  uint64_t serial_{};
+
+  void publish(std::unique_ptr<Snapshot> next) noexcept;
+  void repair() noexcept;
+
+ public:
+  ConcurrentRegexMatchCache() noexcept;
+  ~ConcurrentRegexMatchCache();
+
+  ConcurrentRegexMatchCache(ConcurrentRegexMatchCache const&) = delete;
+  void operator=(ConcurrentRegexMatchCache const&) = delete;
+
+  std::vector<string_pointer> getStringList() const;
+
+  bool hasRegex(regex_key const& regex) const noexcept;
+  void eraseRegex(regex_key const& regex);
+
+  bool hasString(string_pointer string) const;
+  void addString(string_pointer string);
+  void addStrings(span<string_pointer const> strings);
+  void eraseString(string_pointer string);
+
+  std::optional<std::vector<string_pointer>> findMatchesIfCached(
+      regex_key const& regex, time_point now) const;
+  std::vector<string_pointer> findMatches(
+      regex_key_and_view const& regex, time_point now);
+
+  bool hasItemsToPurge(time_point expiry) const noexcept;
+
+  void clear();
+  void purge(time_point expiry);
+};
+
 } // namespace folly
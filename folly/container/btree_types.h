@@ -0,0 +1,1608 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * This header defines btree_set and btree_map, ordered containers that
+ * store their elements in a B+tree.  They fill the gap between
+ * sorted_vector_map/heap_vector_map, which have fast lookups but O(N)
+ * insertions and deletions, and std::map, which has O(log N) updates but
+ * chases one pointer, and usually misses the cache once, per level of a
+ * deep binary tree.
+ *
+ * Every node spans four cache lines.  Leaves hold up to as many elements
+ * as fit in a node and are linked to each other, so iteration walks
+ * contiguous arrays.  Interior nodes hold only keys and child pointers.
+ * With 8 byte keys a tree of a million elements is 5 levels deep.
+ * Lookups count the keys of a node that are less than the searched key,
+ * rather than bisecting them; for 32-bit and 64-bit integral keys
+ * compared with std::less the count uses SSE2 or SSE4.2 compares.
+ *
+ * The default comparator is HeterogeneousAccessLess<Key>, so string keys
+ * can be looked up with a StringPiece or std::string_view without making
+ * a std::string.  As with the F14 maps, heterogeneous lookups are enabled
+ * whenever the comparator is transparent.
+ *
+ * Construction from, and insertion of, a range that is already sorted and
+ * unique (the sorted_unique_t overloads) builds the tree bottom up in
+ * linear time with packed nodes.
+ *
+ * Important differences from std::set and std::map:
+ *   - insert(), emplace() and erase() invalidate all iterators, references
+ *     and pointers to elements.  erase(iterator) returns an iterator to the
+ *     next element.
+ *   - btree_map::value_type is pair<K,V>, not pair<const K,V>, because
+ *     elements move between nodes.  Don't modify the key through an
+ *     iterator.
+ *   - key_type must be copy constructible, because interior nodes keep
+ *     copies of some keys.  Both types must be nothrow move constructible
+ *     for the exception guarantees below to hold.
+ *   - Single element insertions provide the strong exception guarantee;
+ *     erase() does not throw.  Range insertions provide only the basic
+ *     guarantee.
+ *   - Allocators must be stateless or propagate on swap and move
+ *     assignment.  Fancy pointers are not supported.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <folly/CPortability.h>
+#include <folly/Memory.h>
+#include <folly/Portability.h>
+#include <folly/ScopeGuard.h>
+#include <folly/Traits.h>
+#include <folly/Utility.h>
+#include <folly/container/HeterogeneousAccess.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+#include <folly/lang/Exception.h>
+
+#if FOLLY_SSE_PREREQ(4, 2)
+#include <nmmintrin.h>
+#elif FOLLY_SSE_PREREQ(2, 0)
+#include <emmintrin.h>
+#endif
+
+namespace folly {
+
+namespace detail {
+namespace btree {
+
+// A node is a few cache lines: wide enough that a lookup visits few nodes,
+// narrow enough that inserting into one moves little memory.
+constexpr std::size_t kNodeAlign = hardware_constructive_interference_size;
+constexpr std::size_t kNodeBytes = 4 * kNodeAlign;
+
+template <typename Key, typename Compare>
+using IsLessThan = std::bool_constant<
+    std::is_same<Compare, std::less<Key>>::value ||
+    std::is_same<Compare, std::less<>>::value ||
+    std::is_same<Compare, HeterogeneousAccessLess<Key>>::value>;
+
+#if FOLLY_SSE_PREREQ(4, 2)
+constexpr std::size_t kMaxSimdKeyBytes = 8;
+#elif FOLLY_SSE_PREREQ(2, 0)
+constexpr std::size_t kMaxSimdKeyBytes = 4;
+#else
+constexpr std::size_t kMaxSimdKeyBytes = 0;
+#endif
+
+// Keys whose in-node search counts with vector compares.
+template <typename Key, typename Compare>
+using IsSimdSearchable = std::bool_constant<
+    IsLessThan<Key, Compare>::value && std::is_integral<Key>::value &&
+    !std::is_same<Key, bool>::value &&
+    (sizeof(Key) == 4 || sizeof(Key) == 8) &&
+    sizeof(Key) <= kMaxSimdKeyBytes>;
+
+// Keys whose in-node search counts with a branch-free scalar loop.
+template <typename Key, typename Compare>
+using IsLinearSearchable = std::bool_constant<
+    IsLessThan<Key, Compare>::value && std::is_arithmetic<Key>::value>;
+
+FOLLY_ALWAYS_INLINE void prefetchNode(void const* node) {
+#ifndef _WIN32
+  auto p = static_cast<char const*>(node);
+  for (std::size_t i = 0; i < kNodeBytes; i += kNodeAlign) {
+    __builtin_prefetch(p + i);
+  }
+#else
+  (void)node;
+#endif
+}
+
+#if FOLLY_SSE_PREREQ(2, 0)
+// Counts the keys that are less than x (kStrict), or not greater than x.
+template <bool kStrict, typename Key>
+FOLLY_ALWAYS_INLINE std::size_t simdRank(
+    Key const* keys, std::size_t n, Key x) {
+  constexpr std::size_t kLanes = 16 / sizeof(Key);
+  std::size_t rank = 0;
+  std::size_t i = 0;
+  if constexpr (sizeof(Key) == 4) {
+    // SSE compares are signed; flipping the sign bit makes them unsigned
+    auto const bias = _mm_set1_epi32(
+        std::is_signed<Key>::value ? 0
+                                   : std::numeric_limits<std::int32_t>::min());
+    auto const vx =
+        _mm_xor_si128(_mm_set1_epi32(static_cast<std::int32_t>(x)), bias);
+    for (; i + kLanes <= n; i += kLanes) {
+      auto v = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i)), bias);
+      auto m = kStrict ? _mm_cmpgt_epi32(vx, v) : _mm_cmpgt_epi32(v, vx);
+      std::size_t bits = popcount(
+          static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m))));
+      rank += kStrict ? bits : kLanes - bits;
+    }
+  } else {
+#if FOLLY_SSE_PREREQ(4, 2)
+    auto const bias = _mm_set1_epi64x(
+        std::is_signed<Key>::value ? 0
+                                   : std::numeric_limits<std::int64_t>::min());
+    auto const vx =
+        _mm_xor_si128(_mm_set1_epi64x(static_cast<std::int64_t>(x)), bias);
+    for (; i + kLanes <= n; i += kLanes) {
+      auto v = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i)), bias);
+      auto m = kStrict ? _mm_cmpgt_epi64(vx, v) : _mm_cmpgt_epi64(v, vx);
+      std::size_t bits = popcount(
+          static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m))));
+      rank += kStrict ? bits : kLanes - bits;
+    }
+#endif
+  }
+  for (; i < n; ++i) {
+    rank += kStrict ? keys[i] < x : !(x < keys[i]);
+  }
+  return rank;
+}
+#endif
+
+struct Identity {
+  template <typename T>
+  T const& operator()(T const& t) const {
+    return t;
+  }
+};
+
+// Returns the number of elements of the sorted array [elems, elems + n)
+// whose key is less than x (kStrict), or not greater than x.  The first is
+// the index of the lower bound of x, the second that of its upper bound.
+template <
+    bool kStrict,
+    typename T,
+    typename K,
+    typename Compare,
+    typename KeyOf>
+FOLLY_ALWAYS_INLINE std::size_t rank(
+    T const* elems,
+    std::size_t n,
+    K const& x,
+    Compare const& comp,
+    KeyOf keyOf) {
+  using Key = remove_cvref_t<decltype(keyOf(*elems))>;
+#if FOLLY_SSE_PREREQ(2, 0)
+  if constexpr (
+      std::is_same<T, Key>::value && std::is_same<K, Key>::value &&
+      IsSimdSearchable<Key, Compare>::value) {
+    return simdRank<kStrict>(elems, n, x);
+  } else
+#endif
+      if constexpr (
+          std::is_same<K, Key>::value &&
+          IsLinearSearchable<Key, Compare>::value) {
+    std::size_t r = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      Key const& k = keyOf(elems[i]);
+      r += kStrict ? k < x : !(x < k);
+    }
+    return r;
+  } else {
+    return std::partition_point(
+               elems,
+               elems + n,
+               [&](T const& e) {
+                 return kStrict ? comp(keyOf(e), x) : !comp(x, keyOf(e));
+               }) -
+        elems;
+  }
+}
+
+template <typename Key>
+struct SetPolicy {
+  using key_type = Key;
+  using value_type = Key;
+
+  struct KeyOf {
+    Key const& operator()(value_type const& v) const { return v; }
+  };
+};
+
+template <typename Key, typename Mapped>
+struct MapPolicy {
+  using key_type = Key;
+  using value_type = std::pair<Key, Mapped>;
+
+  struct KeyOf {
+    Key const& operator()(value_type const& v) const { return v.first; }
+  };
+};
+
+template <typename, typename Compare, typename Key, typename T>
+struct btree_enable_if_is_transparent {};
+
+template <typename Compare, typename Key, typename T>
+struct btree_enable_if_is_transparent<
+    void_t<typename Compare::is_transparent>,
+    Compare,
+    Key,
+    T> {
+  using type = T;
+};
+
+// The B+tree shared by btree_set and btree_map.  Every element lives in a
+// leaf; interior node i routes a key x to child number
+// rank</*kStrict=*/false>(keys, x), so all keys in children[j] are at least
+// keys[j - 1] and less than keys[j].  Nodes don't keep their index in
+// their parent, which would need fixing up on every shift; it is found by
+// scanning the parent's child pointers instead.
+template <typename Policy, typename Compare, typename Allocator>
+class BTree {
+ public:
+  using key_type = typename Policy::key_type;
+  using value_type = typename Policy::value_type;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = value_type const&;
+  using pointer = value_type*;
+  using const_pointer = value_type const*;
+
+  class value_compare {
+   public:
+    bool operator()(value_type const& a, value_type const& b) const {
+      return comp_(KeyOf{}(a), KeyOf{}(b));
+    }
+
+   private:
+    friend class BTree;
+    explicit value_compare(Compare const& comp) : comp_(comp) {}
+    Compare comp_;
+  };
+
+ private:
+  using KeyOf = typename Policy::KeyOf;
+
+  template <typename K, typename V>
+  using if_is_transparent =
+      _t<btree_enable_if_is_transparent<void, Compare, K, V>>;
+
+  using AllocTraits = std::allocator_traits<Allocator>;
+  using KeyAlloc = typename AllocTraits::template rebind_alloc<key_type>;
+  using KeyAllocTraits = std::allocator_traits<KeyAlloc>;
+  using ByteAlloc = typename AllocTraits::template rebind_alloc<std::uint8_t>;
+  using BytePtr = typename std::allocator_traits<ByteAlloc>::pointer;
+
+  static_assert(
+      std::is_same<typename AllocTraits::value_type, value_type>::value,
+      "allocator_type::value_type must be value_type");
+  static_assert(
+      std::is_copy_constructible<key_type>::value,
+      "btree keys must be copy constructible");
+
+  struct LeafNode;
+  struct InternalNode;
+
+  struct NodeBase {
+    explicit NodeBase(bool isLeaf) : leaf(isLeaf) {}
+
+    InternalNode* parent{nullptr};
+    std::uint16_t count{0};
+    bool leaf;
+  };
+
+  struct LeafLinks : NodeBase {
+    LeafLinks() : NodeBase(true) {}
+
+    LeafNode* prev{nullptr};
+    LeafNode* next{nullptr};
+  };
+
+  static constexpr std::size_t kLeafSlots = std::max<std::size_t>(
+      3, (kNodeBytes - sizeof(LeafLinks)) / sizeof(value_type));
+  static constexpr std::size_t kInternalSlots = std::max<std::size_t>(
+      3,
+      (kNodeBytes - sizeof(NodeBase) - sizeof(void*)) /
+          (sizeof(key_type) + sizeof(void*)));
+  static constexpr std::size_t kMinLeafCount = kLeafSlots / 2;
+  static constexpr std::size_t kMinInternalCount = kInternalSlots / 2;
+
+  struct LeafNode : LeafLinks {
+    value_type* values() {
+      return std::launder(reinterpret_cast<value_type*>(storage));
+    }
+    value_type const* values() const {
+      return std::launder(reinterpret_cast<value_type const*>(storage));
+    }
+
+    alignas(value_type) unsigned char storage[kLeafSlots * sizeof(value_type)];
+  };
+
+  struct InternalNode : NodeBase {
+    InternalNode() : NodeBase(false) {}
+
+    key_type* keys() {
+      return std::launder(reinterpret_cast<key_type*>(storage));
+    }
+    key_type const* keys() const {
+      return std::launder(reinterpret_cast<key_type const*>(storage));
+    }
+
+    alignas(key_type) unsigned char storage[kInternalSlots * sizeof(key_type)];
+    NodeBase* children[kInternalSlots + 1];
+  };
+
+  static_assert(kLeafSlots <= std::numeric_limits<std::uint16_t>::max(), "");
+
+  template <bool kConst>
+  class Iter {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename BTree::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = conditional_t<kConst, value_type const*, value_type*>;
+    using reference = conditional_t<kConst, value_type const&, value_type&>;
+
+    Iter() = default;
+
+    template <
+        bool kOtherConst,
+        std::enable_if_t<kConst && !kOtherConst, int> = 0>
+    /* implicit */ Iter(Iter<kOtherConst> const& other)
+        : leaf_(other.leaf_), pos_(other.pos_) {}
+
+    reference operator*() const { return leaf_->values()[pos_]; }
+    pointer operator->() const { return &**this; }
+
+    Iter& operator++() {
+      if (++pos_ == leaf_->count && leaf_->next != nullptr) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+      }
+      return *this;
+    }
+    Iter operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    Iter& operator--() {
+      if (pos_ == 0) {
+        leaf_ = leaf_->prev;
+        pos_ = leaf_->count;
+      }
+      --pos_;
+      return *this;
+    }
+    Iter operator--(int) {
+      auto prev = *this;
+      --*this;
+      return prev;
+    }
+
+    friend bool operator==(Iter const& a, Iter const& b) {
+      return a.leaf_ == b.leaf_ && a.pos_ == b.pos_;
+    }
+    friend bool operator!=(Iter const& a, Iter const& b) { return !(a == b); }
+
+   private:
+    friend class BTree;
+    template <bool>
+    friend class Iter;
+
+    Iter(LeafNode* leaf, std::size_t pos) : leaf_(leaf), pos_(pos) {}
+
+    // Moves an iterator that is past the end of its leaf to the start of
+    // the next one.
+    Iter& normalize() {
+      if (leaf_ != nullptr && pos_ == leaf_->count &&
+          leaf_->next != nullptr) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+      }
+      return *this;
+    }
+
+    LeafNode* leaf_{nullptr};
+    std::size_t pos_{0};
+  };
+
+ public:
+  using iterator = Iter<false>;
+  using const_iterator = Iter<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  BTree() = default;
+
+  explicit BTree(
+      Compare const& comp, Allocator const& alloc = Allocator())
+      : comp_(comp), alloc_(alloc) {}
+
+  explicit BTree(Allocator const& alloc) : alloc_(alloc) {}
+
+  template <typename InputIterator>
+  BTree(
+      InputIterator first,
+      InputIterator last,
+      Compare const& comp = Compare(),
+      Allocator const& alloc = Allocator())
+      : comp_(comp), alloc_(alloc) {
+    insert(first, last);
+  }
+
+  // Builds the tree bottom up from [first, last), which must be sorted and
+  // free of duplicates.  Takes linear time.
+  template <typename InputIterator>
+  BTree(
+      sorted_unique_t,
+      InputIterator first,
+      InputIterator last,
+      Compare const& comp = Compare(),
+      Allocator const& alloc = Allocator())
+      : comp_(comp), alloc_(alloc) {
+    insert(sorted_unique, first, last);
+  }
+
+  BTree(
+      std::initializer_list<value_type> list,
+      Compare const& comp = Compare(),
+      Allocator const& alloc = Allocator())
+      : BTree(list.begin(), list.end(), comp, alloc) {}
+
+  BTree(
+      sorted_unique_t,
+      std::initializer_list<value_type> list,
+      Compare const& comp = Compare(),
+      Allocator const& alloc = Allocator())
+      : BTree(sorted_unique, list.begin(), list.end(), comp, alloc) {}
+
+  BTree(BTree const& other)
+      : comp_(other.comp_),
+        alloc_(AllocTraits::select_on_container_copy_construction(
+            other.alloc_)) {
+    build(other.begin(), other.size());
+  }
+
+  BTree(BTree const& other, Allocator const& alloc)
+      : comp_(other.comp_), alloc_(alloc) {
+    build(other.begin(), other.size());
+  }
+
+  BTree(BTree&& other) noexcept
+      : root_(std::exchange(other.root_, nullptr)),
+        first_(std::exchange(other.first_, nullptr)),
+        last_(std::exchange(other.last_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        comp_(other.comp_),
+        alloc_(std::move(other.alloc_)) {}
+
+  ~BTree() { clear(); }
+
+  BTree& operator=(BTree const& other) {
+    if (this != &other) {
+      BTree copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  BTree& operator=(BTree&& other) noexcept {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  void swap(BTree& other) noexcept {
+    using std::swap;
+    swap(root_, other.root_);
+    swap(first_, other.first_);
+    swap(last_, other.last_);
+    swap(size_, other.size_);
+    swap(comp_, other.comp_);
+    swap(alloc_, other.alloc_);
+  }
+
+  friend void swap(BTree& a, BTree& b) noexcept { a.swap(b); }
+
+  allocator_type get_allocator() const { return alloc_; }
+  key_compare key_comp() const { return comp_; }
+  value_compare value_comp() const { return value_compare(comp_); }
+
+  iterator begin() { return iterator(first_, 0); }
+  iterator end() {
+    return iterator(last_, last_ != nullptr ? last_->count : 0);
+  }
+  const_iterator begin() const { return const_cast<BTree*>(this)->begin(); }
+  const_iterator end() const { return const_cast<BTree*>(this)->end(); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+  const_reverse_iterator crend() const { return rend(); }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type max_size() const {
+    return std::numeric_limits<difference_type>::max() / sizeof(value_type);
+  }
+
+  void clear() {
+    if (root_ != nullptr) {
+      destroySubtree(root_);
+    }
+    root_ = nullptr;
+    first_ = last_ = nullptr;
+    size_ = 0;
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return emplaceKey(KeyOf{}(value), value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return emplaceKey(KeyOf{}(value), std::move(value));
+  }
+
+  // Hints other than end() are ignored; end() makes appending in order cost
+  // no descent.
+  iterator insert(const_iterator hint, value_type const& value) {
+    return emplaceKeyHint(hint, KeyOf{}(value), value).first;
+  }
+
+  iterator insert(const_iterator hint, value_type&& value) {
+    return emplaceKeyHint(hint, KeyOf{}(value), std::move(value)).first;
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    using Category =
+        typename std::iterator_traits<InputIterator>::iterator_category;
+    if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::
+                      value) {
+      auto n = static_cast<size_type>(std::distance(first, last));
+      if (shouldRebuild(n)) {
+        std::vector<value_type> sorted(first, last);
+        std::stable_sort(
+            sorted.begin(), sorted.end(), value_compare(comp_));
+        sorted.erase(
+            std::unique(
+                sorted.begin(),
+                sorted.end(),
+                [&](value_type const& a, value_type const& b) {
+                  return !comp_(KeyOf{}(a), KeyOf{}(b));
+                }),
+            sorted.end());
+        mergeSorted(std::make_move_iterator(sorted.begin()), sorted.size());
+        return;
+      }
+    }
+    for (; first != last; ++first) {
+      emplace_hint(cend(), *first);
+    }
+  }
+
+  // [first, last) must be sorted and free of duplicates.  Into an empty
+  // tree, or a tree not much larger than the range, this builds (or
+  // rebuilds) the tree bottom up in linear time; otherwise it inserts
+  // element by element.
+  template <typename InputIterator>
+  void insert(sorted_unique_t, InputIterator first, InputIterator last) {
+    using Category =
+        typename std::iterator_traits<InputIterator>::iterator_category;
+    if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::
+                      value) {
+      auto n = static_cast<size_type>(std::distance(first, last));
+      assert(std::is_sorted(first, last, value_compare(comp_)));
+      if (root_ == nullptr) {
+        build(first, n);
+        return;
+      }
+      if (shouldRebuild(n)) {
+        mergeSorted(first, n);
+        return;
+      }
+    }
+    for (; first != last; ++first) {
+      emplace_hint(cend(), *first);
+    }
+  }
+
+  void insert(std::initializer_list<value_type> list) {
+    insert(list.begin(), list.end());
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    return insert(std::move(value));
+  }
+
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    return insert(hint, std::move(value));
+  }
+
+  iterator erase(const_iterator pos) { return eraseAt(pos.leaf_, pos.pos_); }
+
+  iterator erase(iterator pos) { return eraseAt(pos.leaf_, pos.pos_); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    // Rebalancing moves elements, so last doesn't survive the first erase;
+    // count instead.
+    auto n = std::distance(first, last);
+    iterator it(first.leaf_, first.pos_);
+    while (n-- > 0) {
+      it = eraseAt(it.leaf_, it.pos_);
+    }
+    return it;
+  }
+
+  size_type erase(key_type const& key) { return eraseKey(key); }
+
+  template <typename K>
+  if_is_transparent<K, size_type> erase(K const& key) {
+    return eraseKey(key);
+  }
+
+  iterator find(key_type const& key) { return findImpl(key); }
+  const_iterator find(key_type const& key) const { return findImpl(key); }
+
+  template <typename K>
+  if_is_transparent<K, iterator> find(K const& key) {
+    return findImpl(key);
+  }
+
+  template <typename K>
+  if_is_transparent<K, const_iterator> find(K const& key) const {
+    return findImpl(key);
+  }
+
+  size_type count(key_type const& key) const { return contains(key); }
+
+  template <typename K>
+  if_is_transparent<K, size_type> count(K const& key) const {
+    return contains(key);
+  }
+
+  bool contains(key_type const& key) const { return findImpl(key) != end(); }
+
+  template <typename K>
+  if_is_transparent<K, bool> contains(K const& key) const {
+    return findImpl(key) != end();
+  }
+
+  iterator lower_bound(key_type const& key) { return bound<true>(key); }
+  const_iterator lower_bound(key_type const& key) const {
+    return bound<true>(key);
+  }
+
+  template <typename K>
+  if_is_transparent<K, iterator> lower_bound(K const& key) {
+    return bound<true>(key);
+  }
+
+  template <typename K>
+  if_is_transparent<K, const_iterator> lower_bound(K const& key) const {
+    return bound<true>(key);
+  }
+
+  iterator upper_bound(key_type const& key) { return bound<false>(key); }
+  const_iterator upper_bound(key_type const& key) const {
+    return bound<false>(key);
+  }
+
+  template <typename K>
+  if_is_transparent<K, iterator> upper_bound(K const& key) {
+    return bound<false>(key);
+  }
+
+  template <typename K>
+  if_is_transparent<K, const_iterator> upper_bound(K const& key) const {
+    return bound<false>(key);
+  }
+
+  std::pair<iterator, iterator> equal_range(key_type const& key) {
+    return equalRange(key);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(
+      key_type const& key) const {
+    return equalRange(key);
+  }
+
+  template <typename K>
+  if_is_transparent<K, std::pair<iterator, iterator>> equal_range(
+      K const& key) {
+    return equalRange(key);
+  }
+
+  template <typename K>
+  if_is_transparent<K, std::pair<const_iterator, const_iterator>> equal_range(
+      K const& key) const {
+    return equalRange(key);
+  }
+
+  friend bool operator==(BTree const& a, BTree const& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+  friend bool operator!=(BTree const& a, BTree const& b) { return !(a == b); }
+  friend bool operator<(BTree const& a, BTree const& b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+  }
+  friend bool operator>(BTree const& a, BTree const& b) { return b < a; }
+  friend bool operator<=(BTree const& a, BTree const& b) { return !(b < a); }
+  friend bool operator>=(BTree const& a, BTree const& b) { return !(a < b); }
+
+ protected:
+  // Inserts a value constructed from args, whose key compares equal to
+  // key, unless the tree already has that key.  key may refer into args.
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplaceKey(K const& key, Args&&... args) {
+    if (root_ == nullptr) {
+      return emplaceFirst(std::forward<Args>(args)...);
+    }
+    LeafNode* leaf = findLeaf(key);
+    return emplaceInLeaf(leaf, key, std::forward<Args>(args)...);
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplaceKeyHint(
+      const_iterator hint, K const& key, Args&&... args) {
+    if (root_ == nullptr) {
+      return emplaceFirst(std::forward<Args>(args)...);
+    }
+    if (hint == cend() &&
+        comp_(KeyOf{}(last_->values()[last_->count - 1]), key)) {
+      return emplaceAt(last_, last_->count, std::forward<Args>(args)...);
+    }
+    return emplaceKey(key, std::forward<Args>(args)...);
+  }
+
+ private:
+  template <typename... Args>
+  std::pair<iterator, bool> emplaceFirst(Args&&... args) {
+    auto leaf = newNode<LeafNode>();
+    auto guard = makeGuard([&] { deleteNode(leaf); });
+    AllocTraits::construct(
+        alloc_, leaf->values(), std::forward<Args>(args)...);
+    guard.dismiss();
+    leaf->count = 1;
+    root_ = first_ = last_ = leaf;
+    size_ = 1;
+    return {iterator(leaf, 0), true};
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplaceInLeaf(
+      LeafNode* leaf, K const& key, Args&&... args) {
+    auto values = leaf->values();
+    auto pos = rank<true>(values, leaf->count, key, comp_, KeyOf{});
+    if (pos < leaf->count && !comp_(key, KeyOf{}(values[pos]))) {
+      return {iterator(leaf, pos), false};
+    }
+    return emplaceAt(leaf, pos, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplaceAt(
+      LeafNode* leaf, std::size_t pos, Args&&... args) {
+    if (leaf->count < kLeafSlots) {
+      auto values = leaf->values();
+      relocate(values + pos, leaf->count - pos, values + pos + 1);
+      auto rollback = makeGuard([&] {
+        relocate(values + pos + 1, leaf->count - pos, values + pos);
+      });
+      AllocTraits::construct(
+          alloc_, values + pos, std::forward<Args>(args)...);
+      rollback.dismiss();
+      ++leaf->count;
+      ++size_;
+      return {iterator(leaf, pos), true};
+    }
+    value_type value(std::forward<Args>(args)...);
+    return {splitLeafAndInsert(leaf, pos, std::move(value)), true};
+  }
+
+  // Spare nodes for one split cascade, allocated before anything is
+  // modified, so that a failed allocation leaves the tree untouched.
+  struct SpareNodes {
+    explicit SpareNodes(BTree& tree) : tree_(tree) {}
+    ~SpareNodes() {
+      if (leaf_ != nullptr) {
+        tree_.deleteNode(leaf_);
+      }
+      while (numInternal_ > 0) {
+        tree_.deleteNode(internal_[--numInternal_]);
+      }
+    }
+
+    LeafNode* takeLeaf() { return std::exchange(leaf_, nullptr); }
+    InternalNode* takeInternal() {
+      assert(numInternal_ > 0);
+      return internal_[--numInternal_];
+    }
+
+    BTree& tree_;
+    LeafNode* leaf_{nullptr};
+    // A tree of 2^64 elements is less than 64 levels deep.
+    InternalNode* internal_[64];
+    std::size_t numInternal_{0};
+  };
+
+  iterator splitLeafAndInsert(
+      LeafNode* leaf, std::size_t pos, value_type&& value) {
+    SpareNodes spare(*this);
+    spare.leaf_ = newNode<LeafNode>();
+    // One sibling for every full ancestor, and a new root if they all are.
+    for (auto node = leaf->parent;; node = node->parent) {
+      if (node != nullptr && node->count < kInternalSlots) {
+        break;
+      }
+      spare.internal_[spare.numInternal_++] = newNode<InternalNode>();
+      if (node == nullptr) {
+        break;
+      }
+    }
+
+    // Conceptually value is inserted at pos and the result is split into
+    // [0, keep) and [keep, kLeafSlots + 1).  Appending to either end of
+    // the tree leaves the old leaf full, so that keys inserted in order
+    // pack the nodes.
+    std::size_t const n = kLeafSlots;
+    std::size_t keep = (n + 1) / 2;
+    if (leaf == last_ && pos == n) {
+      keep = n;
+    } else if (leaf == first_ && pos == 0) {
+      keep = 1;
+    }
+    auto values = leaf->values();
+    key_type const& sepSource = pos < keep
+        ? KeyOf{}(values[keep - 1])
+        : KeyOf{}(pos == keep ? value : values[keep]);
+    key_type separator(sepSource);
+
+    // Nothing below throws.
+    auto right = spare.takeLeaf();
+    auto rightValues = right->values();
+    LeafNode* target;
+    if (pos < keep) {
+      relocate(values + keep - 1, n - keep + 1, rightValues);
+      right->count = static_cast<std::uint16_t>(n - keep + 1);
+      leaf->count = static_cast<std::uint16_t>(keep - 1);
+      target = leaf;
+    } else {
+      relocate(values + keep, n - keep, rightValues);
+      right->count = static_cast<std::uint16_t>(n - keep);
+      leaf->count = static_cast<std::uint16_t>(keep);
+      target = right;
+      pos -= keep;
+    }
+    auto targetValues = target->values();
+    relocate(targetValues + pos, target->count - pos, targetValues + pos + 1);
+    AllocTraits::construct(alloc_, targetValues + pos, std::move(value));
+    ++target->count;
+    ++size_;
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next != nullptr) {
+      leaf->next->prev = right;
+    } else {
+      last_ = right;
+    }
+    leaf->next = right;
+    insertIntoParent(leaf, std::move(separator), right, spare);
+    return iterator(target, pos);
+  }
+
+  // Links right into the tree just after its left sibling, with separator
+  // between them, splitting ancestors as needed.
+  void insertIntoParent(
+      NodeBase* left,
+      key_type&& separator,
+      NodeBase* right,
+      SpareNodes& spare) {
+    InternalNode* parent = left->parent;
+    if (parent == nullptr) {
+      auto root = spare.takeInternal();
+      constructKey(root->keys(), std::move(separator));
+      root->children[0] = left;
+      root->children[1] = right;
+      root->count = 1;
+      left->parent = right->parent = root;
+      root_ = root;
+      return;
+    }
+    if (parent->count == kInternalSlots) {
+      std::size_t const n = kInternalSlots;
+      std::size_t mid = n / 2;
+      if (parent->children[n] == left && isRightmost(parent)) {
+        mid = n - 1;
+      }
+      auto sibling = spare.takeInternal();
+      auto keys = parent->keys();
+      relocate(keys + mid + 1, n - mid - 1, sibling->keys());
+      for (std::size_t i = mid + 1; i <= n; ++i) {
+        sibling->children[i - mid - 1] = parent->children[i];
+        parent->children[i]->parent = sibling;
+      }
+      sibling->count = static_cast<std::uint16_t>(n - mid - 1);
+      key_type promoted(std::move(keys[mid]));
+      destroyKey(keys + mid);
+      parent->count = static_cast<std::uint16_t>(mid);
+      insertChild(left->parent, left, std::move(separator), right);
+      insertIntoParent(parent, std::move(promoted), sibling, spare);
+      return;
+    }
+    insertChild(parent, left, std::move(separator), right);
+  }
+
+  // Whether node is on the rightmost path from the root.
+  static bool isRightmost(NodeBase const* node) {
+    for (auto parent = node->parent; parent != nullptr;
+         node = parent, parent = parent->parent) {
+      if (parent->children[parent->count] != node) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void insertChild(
+      InternalNode* parent,
+      NodeBase* left,
+      key_type&& separator,
+      NodeBase* right) {
+    std::size_t idx = childIndex(parent, left);
+    auto keys = parent->keys();
+    relocate(keys + idx, parent->count - idx, keys + idx + 1);
+    constructKey(keys + idx, std::move(separator));
+    std::memmove(
+        parent->children + idx + 2,
+        parent->children + idx + 1,
+        (parent->count - idx) * sizeof(NodeBase*));
+    parent->children[idx + 1] = right;
+    right->parent = parent;
+    ++parent->count;
+  }
+
+  static std::size_t childIndex(InternalNode const* parent, NodeBase* child) {
+    std::size_t i = 0;
+    while (parent->children[i] != child) {
+      ++i;
+    }
+    return i;
+  }
+
+  template <typename K>
+  size_type eraseKey(K const& key) {
+    auto it = findImpl(key);
+    if (it == end()) {
+      return 0;
+    }
+    eraseAt(it.leaf_, it.pos_);
+    return 1;
+  }
+
+  iterator eraseAt(LeafNode* leaf, std::size_t pos) {
+    auto values = leaf->values();
+    AllocTraits::destroy(alloc_, values + pos);
+    relocate(values + pos + 1, leaf->count - pos - 1, values + pos);
+    --leaf->count;
+    --size_;
+    if (leaf == root_) {
+      if (leaf->count == 0) {
+        clear();
+        return end();
+      }
+    } else if (leaf->count < kMinLeafCount) {
+      std::tie(leaf, pos) = rebalanceLeaf(leaf, pos);
+    }
+    return iterator(leaf, pos).normalize();
+  }
+
+  // Merges an underfull leaf with a sibling if they fit in one node.  A
+  // leaf whose siblings are too full to merge with stays underfull, rather
+  // than borrowing from them: that would copy a key into the parent, which
+  // could throw.  An empty leaf always fits.  Returns the new location of
+  // the element that was at pos.
+  std::pair<LeafNode*, std::size_t> rebalanceLeaf(
+      LeafNode* leaf, std::size_t pos) {
+    auto parent = leaf->parent;
+    std::size_t idx = childIndex(parent, leaf);
+    if (idx > 0) {
+      auto left = static_cast<LeafNode*>(parent->children[idx - 1]);
+      if (std::size_t{left->count} + leaf->count <= kLeafSlots) {
+        pos += left->count;
+        mergeLeaves(left, leaf, idx - 1);
+        return {left, pos};
+      }
+    }
+    if (idx < parent->count) {
+      auto right = static_cast<LeafNode*>(parent->children[idx + 1]);
+      if (std::size_t{leaf->count} + right->count <= kLeafSlots) {
+        mergeLeaves(leaf, right, idx);
+        return {leaf, pos};
+      }
+    }
+    assert(leaf->count > 0);
+    return {leaf, pos};
+  }
+
+  void mergeLeaves(LeafNode* left, LeafNode* right, std::size_t sepIdx) {
+    relocate(right->values(), right->count, left->values() + left->count);
+    left->count = static_cast<std::uint16_t>(left->count + right->count);
+    right->count = 0;
+    unlinkLeaf(right);
+    auto parent = left->parent;
+    removeChild(parent, sepIdx, sepIdx + 1);
+    deleteNode(right);
+    rebalanceInternal(parent);
+  }
+
+  void unlinkLeaf(LeafNode* leaf) {
+    if (leaf->prev != nullptr) {
+      leaf->prev->next = leaf->next;
+    } else {
+      first_ = leaf->next;
+    }
+    if (leaf->next != nullptr) {
+      leaf->next->prev = leaf->prev;
+    } else {
+      last_ = leaf->prev;
+    }
+  }
+
+  // Removes keys[keyIdx] and children[childIdx] from node.
+  void removeChild(
+      InternalNode* node, std::size_t keyIdx, std::size_t childIdx) {
+    auto keys = node->keys();
+    destroyKey(keys + keyIdx);
+    relocate(keys + keyIdx + 1, node->count - keyIdx - 1, keys + keyIdx);
+    std::memmove(
+        node->children + childIdx,
+        node->children + childIdx + 1,
+        (node->count - childIdx) * sizeof(NodeBase*));
+    --node->count;
+  }
+
+  void rebalanceInternal(InternalNode* node) {
+    while (node != root_ && node->count < kMinInternalCount) {
+      auto parent = node->parent;
+      std::size_t idx = childIndex(parent, node);
+      if (idx > 0) {
+        auto left = static_cast<InternalNode*>(parent->children[idx - 1]);
+        if (std::size_t{left->count} + 1 + node->count <= kInternalSlots) {
+          mergeInternal(parent, idx - 1);
+          node = parent;
+          continue;
+        }
+      }
+      if (idx < parent->count) {
+        auto right = static_cast<InternalNode*>(parent->children[idx + 1]);
+        if (std::size_t{node->count} + 1 + right->count <= kInternalSlots) {
+          mergeInternal(parent, idx);
+          node = parent;
+          continue;
+        }
+      }
+      if (idx > 0) {
+        rotateFromLeft(parent, idx);
+      } else {
+        rotateFromRight(parent, idx);
+      }
+      return;
+    }
+    if (node == root_ && node->count == 0) {
+      root_ = node->children[0];
+      root_->parent = nullptr;
+      deleteNode(node);
+    }
+  }
+
+  // Merges children[idx + 1] of parent, and the key between them, into
+  // children[idx].
+  void mergeInternal(InternalNode* parent, std::size_t idx) {
+    auto left = static_cast<InternalNode*>(parent->children[idx]);
+    auto right = static_cast<InternalNode*>(parent->children[idx + 1]);
+    auto leftKeys = left->keys();
+    std::size_t n = left->count;
+    constructKey(leftKeys + n, std::move(parent->keys()[idx]));
+    relocate(right->keys(), right->count, leftKeys + n + 1);
+    for (std::size_t i = 0; i <= right->count; ++i) {
+      left->children[n + 1 + i] = right->children[i];
+      right->children[i]->parent = left;
+    }
+    left->count = static_cast<std::uint16_t>(n + 1 + right->count);
+    right->count = 0;
+    removeChild(parent, idx, idx + 1);
+    deleteNode(right);
+  }
+
+  // Moves the last child of children[idx - 1] to the front of
+  // children[idx], rotating the keys through parent.
+  void rotateFromLeft(InternalNode* parent, std::size_t idx) {
+    auto left = static_cast<InternalNode*>(parent->children[idx - 1]);
+    auto node = static_cast<InternalNode*>(parent->children[idx]);
+    auto keys = node->keys();
+    relocate(keys, node->count, keys + 1);
+    constructKey(keys, std::move(parent->keys()[idx - 1]));
+    std::memmove(
+        node->children + 1,
+        node->children,
+        (node->count + 1) * sizeof(NodeBase*));
+    node->children[0] = left->children[left->count];
+    node->children[0]->parent = node;
+    ++node->count;
+    auto leftLast = left->keys() + left->count - 1;
+    parent->keys()[idx - 1] = std::move(*leftLast);
+    destroyKey(leftLast);
+    --left->count;
+  }
+
+  // Moves the first child of children[idx + 1] to the back of
+  // children[idx], rotating the keys through parent.
+  void rotateFromRight(InternalNode* parent, std::size_t idx) {
+    auto node = static_cast<InternalNode*>(parent->children[idx]);
+    auto right = static_cast<InternalNode*>(parent->children[idx + 1]);
+    constructKey(node->keys() + node->count, std::move(parent->keys()[idx]));
+    node->children[node->count + 1] = right->children[0];
+    node->children[node->count + 1]->parent = node;
+    ++node->count;
+    auto rightKeys = right->keys();
+    parent->keys()[idx] = std::move(rightKeys[0]);
+    destroyKey(rightKeys);
+    relocate(rightKeys + 1, right->count - 1, rightKeys);
+    std::memmove(
+        right->children,
+        right->children + 1,
+        right->count * sizeof(NodeBase*));
+    --right->count;
+  }
+
+  template <typename K>
+  LeafNode* findLeaf(K const& key) const {
+    NodeBase* node = root_;
+    while (!node->leaf) {
+      auto internal = static_cast<InternalNode*>(node);
+      node = internal->children[rank<false>(
+          internal->keys(), internal->count, key, comp_, Identity{})];
+      prefetchNode(node);
+    }
+    return static_cast<LeafNode*>(node);
+  }
+
+  template <typename K>
+  iterator findImpl(K const& key) const {
+    if (root_ == nullptr) {
+      return iterator();
+    }
+    auto leaf = findLeaf(key);
+    auto values = leaf->values();
+    auto pos = rank<true>(values, leaf->count, key, comp_, KeyOf{});
+    if (pos < leaf->count && !comp_(key, KeyOf{}(values[pos]))) {
+      return iterator(leaf, pos);
+    }
+    return const_cast<BTree*>(this)->end();
+  }
+
+  template <bool kLower, typename K>
+  iterator bound(K const& key) const {
+    if (root_ == nullptr) {
+      return iterator();
+    }
+    auto leaf = findLeaf(key);
+    auto pos = rank<kLower>(leaf->values(), leaf->count, key, comp_, KeyOf{});
+    return iterator(leaf, pos).normalize();
+  }
+
+  template <typename K>
+  std::pair<iterator, iterator> equalRange(K const& key) const {
+    auto lower = bound<true>(key);
+    auto upper = lower;
+    if (upper != const_cast<BTree*>(this)->end() &&
+        !comp_(key, KeyOf{}(*upper))) {
+      ++upper;
+    }
+    return {lower, upper};
+  }
+
+  bool shouldRebuild(size_type n) const {
+    // Rebuilding costs a few nanoseconds per element, and an insertion
+    // costs a descent and some shifting, so rebuild once the new elements
+    // are a fair fraction of the old ones.
+    return n > 0 && n * 8 >= size_;
+  }
+
+  // Merges n sorted, unique values from first with the elements of the
+  // tree, keeping the existing element for keys that appear in both, and
+  // rebuilds the tree from the result.
+  template <typename InputIterator>
+  void mergeSorted(InputIterator first, size_type n) {
+    std::vector<value_type> merged;
+    merged.reserve(size_ + n);
+    // Once elements are moved out, their keys no longer order the tree.
+    auto failed = makeGuard([&] { clear(); });
+    auto it = begin();
+    auto last = end();
+    for (; n > 0; --n, ++first) {
+      auto&& value = *first;
+      auto const& key = KeyOf{}(value);
+      while (it != last && comp_(KeyOf{}(*it), key)) {
+        merged.push_back(std::move(*it++));
+      }
+      if (it == last || comp_(key, KeyOf{}(*it))) {
+        merged.push_back(std::forward<decltype(value)>(value));
+      }
+    }
+    for (; it != last; ++it) {
+      merged.push_back(std::move(*it));
+    }
+    failed.dismiss();
+    clear();
+    build(std::make_move_iterator(merged.begin()), merged.size());
+  }
+
+  // Builds the tree bottom up from n sorted, unique values, spreading them
+  // evenly over as few nodes as will hold them.  The tree must be empty.
+  template <typename InputIterator>
+  void build(InputIterator first, size_type n) {
+    assert(root_ == nullptr);
+    if (n == 0) {
+      return;
+    }
+    // level holds the roots of the subtrees built so far, and parents the
+    // partially built level above them.  Leaves are reached through the
+    // list.
+    std::vector<NodeBase*> level;
+    std::vector<NodeBase*> parents;
+    std::vector<key_type const*> firstKeys;
+    std::vector<key_type const*> parentKeys;
+    auto failed = makeGuard([&] {
+      for (auto node : parents) {
+        destroyInternal(static_cast<InternalNode*>(node), false);
+      }
+      for (auto node : level) {
+        destroyInternalNodes(node);
+      }
+      for (auto leaf = first_; leaf != nullptr;) {
+        auto next = leaf->next;
+        destroyLeaf(leaf);
+        leaf = next;
+      }
+      first_ = last_ = nullptr;
+      size_ = 0;
+    });
+
+    size_type numLeaves = (n + kLeafSlots - 1) / kLeafSlots;
+    level.reserve(numLeaves);
+    firstKeys.reserve(numLeaves);
+    for (size_type i = 0; i < numLeaves; ++i) {
+      auto leaf = newNode<LeafNode>();
+      leaf->prev = last_;
+      (last_ != nullptr ? last_->next : first_) = leaf;
+      last_ = leaf;
+      size_type count = n / numLeaves + (i < n % numLeaves);
+      auto values = leaf->values();
+      for (; leaf->count < count; ++first) {
+        AllocTraits::construct(alloc_, values + leaf->count, *first);
+        ++leaf->count;
+      }
+      size_ += count;
+      level.push_back(leaf);
+      firstKeys.push_back(&KeyOf{}(values[0]));
+    }
+
+    while (level.size() > 1) {
+      size_type numChildren = level.size();
+      size_type numParents =
+          (numChildren + kInternalSlots) / (kInternalSlots + 1);
+      parents.clear();
+      parentKeys.clear();
+      // So that push_back below can't throw and leak a node.
+      parents.reserve(numParents);
+      parentKeys.reserve(numParents);
+      size_type child = 0;
+      for (size_type i = 0; i < numParents; ++i) {
+        size_type count =
+            numChildren / numParents + (i < numChildren % numParents);
+        auto parent = newNode<InternalNode>();
+        parents.push_back(parent);
+        parentKeys.push_back(firstKeys[child]);
+        auto keys = parent->keys();
+        for (size_type j = 0; j < count; ++j, ++child) {
+          if (j > 0) {
+            constructKey(keys + j - 1, *firstKeys[child]);
+            ++parent->count;
+          }
+          parent->children[j] = level[child];
+        }
+        for (size_type j = 0; j < count; ++j) {
+          parent->children[j]->parent = parent;
+        }
+      }
+      level.swap(parents);
+      firstKeys.swap(parentKeys);
+    }
+    parents.clear();
+    failed.dismiss();
+    root_ = level.front();
+  }
+
+  // Frees the interior nodes of a subtree, but not its leaves.
+  void destroyInternalNodes(NodeBase* node) {
+    if (node->leaf) {
+      return;
+    }
+    auto internal = static_cast<InternalNode*>(node);
+    for (std::size_t i = 0; i <= internal->count; ++i) {
+      destroyInternalNodes(internal->children[i]);
+    }
+    destroyInternal(internal, false);
+  }
+
+  void destroySubtree(NodeBase* node) {
+    if (node->leaf) {
+      destroyLeaf(static_cast<LeafNode*>(node));
+    } else {
+      destroyInternal(static_cast<InternalNode*>(node), true);
+    }
+  }
+
+  void destroyLeaf(LeafNode* leaf) {
+    auto values = leaf->values();
+    for (std::size_t i = 0; i < leaf->count; ++i) {
+      AllocTraits::destroy(alloc_, values + i);
+    }
+    deleteNode(leaf);
+  }
+
+  void destroyInternal(InternalNode* node, bool recursive) {
+    auto keys = node->keys();
+    for (std::size_t i = 0; i < node->count; ++i) {
+      destroyKey(keys + i);
+    }
+    if (recursive) {
+      for (std::size_t i = 0; i <= node->count; ++i) {
+        destroySubtree(node->children[i]);
+      }
+    }
+    deleteNode(node);
+  }
+
+  template <typename... Args>
+  void constructKey(key_type* p, Args&&... args) {
+    KeyAlloc a(alloc_);
+    KeyAllocTraits::construct(a, p, std::forward<Args>(args)...);
+  }
+
+  void destroyKey(key_type* p) {
+    KeyAlloc a(alloc_);
+    KeyAllocTraits::destroy(a, p);
+  }
+
+  template <typename Node>
+  Node* newNode() {
+    auto raw = allocateOverAligned<ByteAlloc, kNodeAlign>(
+        ByteAlloc(alloc_), sizeof(Node));
+    return ::new (static_cast<void*>(std::addressof(*raw))) Node();
+  }
+
+  template <typename Node>
+  void deleteNode(Node* node) {
+    node->~Node();
+    deallocateOverAligned<ByteAlloc, kNodeAlign>(
+        ByteAlloc(alloc_),
+        std::pointer_traits<BytePtr>::pointer_to(
+            *reinterpret_cast<std::uint8_t*>(node)),
+        sizeof(Node));
+  }
+
+  // Moves n elements from src to the uninitialized dst, leaving src
+  // uninitialized.  The ranges may overlap.
+  template <typename T>
+  void relocate(T* src, std::size_t n, T* dst) {
+    if (n == 0 || src == dst) {
+      return;
+    }
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      std::memmove(static_cast<void*>(dst), src, n * sizeof(T));
+    } else {
+      static_assert(
+          std::is_nothrow_move_constructible<T>::value,
+          "btree elements must be nothrow move constructible");
+      if (dst < src) {
+        for (std::size_t i = 0; i < n; ++i) {
+          ::new (static_cast<void*>(dst + i)) T(std::move(src[i]));
+          src[i].~T();
+        }
+      } else {
+        for (std::size_t i = n; i-- > 0;) {
+          ::new (static_cast<void*>(dst + i)) T(std::move(src[i]));
+          src[i].~T();
+        }
+      }
+    }
+  }
+
+  NodeBase* root_{nullptr};
+  LeafNode* first_{nullptr};
+  LeafNode* last_{nullptr};
+  size_type size_{0};
+  [[FOLLY_ATTR_NO_UNIQUE_ADDRESS]] Compare comp_;
+  [[FOLLY_ATTR_NO_UNIQUE_ADDRESS]] Allocator alloc_;
+};
+
+} // namespace btree
+} // namespace detail
+
+/**
+ * An ordered set stored in a B+tree.  See the top of this file for how it
+ * differs from std::set.
+ */
+template <
+    class Key,
+    class Compare = HeterogeneousAccessLess<Key>,
+    class Allocator = std::allocator<Key>>
+class btree_set : public detail::btree::
+                      BTree<detail::btree::SetPolicy<Key>, Compare, Allocator> {
+  using Base = detail::btree::
+      BTree<detail::btree::SetPolicy<Key>, Compare, Allocator>;
+
+ public:
+  using Base::Base;
+  using value_compare = Compare;
+
+  btree_set() = default;
+
+  value_compare value_comp() const { return this->key_comp(); }
+};
+
+/**
+ * An ordered map stored in a B+tree.  See the top of this file for how it
+ * differs from std::map.
+ */
+template <
+    class Key,
+    class Value,
+    class Compare = HeterogeneousAccessLess<Key>,
+    class Allocator = std::allocator<std::pair<Key, Value>>>
+class btree_map
+    : public detail::btree::
+          BTree<detail::btree::MapPolicy<Key, Value>, Compare, Allocator> {
+  using Base = detail::btree::
+      BTree<detail::btree::MapPolicy<Key, Value>, Compare, Allocator>;
+
+ public:
+  using mapped_type = Value;
+  using typename Base::iterator;
+  using typename Base::key_type;
+  using typename Base::value_type;
+
+  using Base::Base;
+  using Base::insert;
+
+  btree_map() = default;
+
+  template <
+      typename P,
+      std::enable_if_t<std::is_constructible<value_type, P&&>::value, int> = 0>
+  std::pair<iterator, bool> insert(P&& value) {
+    return this->emplace(std::forward<P>(value));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type const& key, Args&&... args) {
+    return this->emplaceKey(
+        key,
+        std::piecewise_construct,
+        std::forward_as_tuple(key),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+    return this->emplaceKey(
+        key,
+        std::piecewise_construct,
+        std::forward_as_tuple(std::move(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type const& key, M&& obj) {
+    auto ret = try_emplace(key, std::forward<M>(obj));
+    if (!ret.second) {
+      ret.first->second = std::forward<M>(obj);
+    }
+    return ret;
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+    auto ret = try_emplace(std::move(key), std::forward<M>(obj));
+    if (!ret.second) {
+      ret.first->second = std::forward<M>(obj);
+    }
+    return ret;
+  }
+
+  mapped_type& operator[](key_type const& key) {
+    return try_emplace(key).first->second;
+  }
+
+  mapped_type& operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  mapped_type& at(key_type const& key) {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw_exception<std::out_of_range>("btree_map::at");
+    }
+    return it->second;
+  }
+
+  mapped_type const& at(key_type const& key) const {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw_exception<std::out_of_range>("btree_map::at");
+    }
+    return it->second;
+  }
+};
+
+} // namespace folly
@@ -0,0 +1,688 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Portability.h>
+#include <folly/Range.h>
+#include <folly/Traits.h>
+#include <folly/container/Iterator.h>
+#include <folly/container/tape.h>
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace folly {
+
+/* # Columnar tape
+ *
+ * A table of records stored as a struct of arrays: one column per field.
+ *
+ *   columnar_tape<std::string, std::int64_t, std::string> t;
+ *   t.push_back("alice", 42, "alice@example.com");
+ *
+ * Fields of fixed width (any trivially copyable type) are stored in a
+ * `std::vector` each. Fields of variable width (`std::string` and
+ * `std::vector<T>`) are stored in a `tape` each, so a column of strings is
+ * one buffer plus offsets, and not one heap allocation per string.
+ *
+ * Compared to `vector<struct>`, building the table allocates per column
+ * instead of per string, and a scan of one column reads only that column.
+ * Reading a whole record touches one cache line per column instead.
+ *
+ * ## Rows
+ *
+ * `t[i]` is a row proxy, `columnar_tape_row`. `row.get<I>()` is `T&` for a
+ * fixed-width field, which can be assigned, and the tape's record reference
+ * (e.g. `StringPiece`) for a variable-width field, which cannot. Rows support
+ * structured bindings and convert to `value_type`, a `std::tuple` of the
+ * field types.
+ *
+ * ## Bulk append
+ *
+ * `append(first, last)` takes a range of tuple-like rows, such as
+ * `std::tuple`, `std::pair` or the rows of another columnar_tape. For forward
+ * ranges it sizes every column up front and then fills them without
+ * reallocation, like the range constructor of `tape`.
+ *
+ * ## Serialization
+ *
+ * `serialize()` writes the columns one after another: a header with the
+ * number of columns and rows, then for each column the size of its element
+ * type, its offsets if it is a tape, and its elements. Integers and elements
+ * are in native byte order, so the format is meant for caches and IPC between
+ * like machines, not for long-term storage. `deserialize()` validates the
+ * structure and throws `std::invalid_argument` on malformed input.
+ *
+ * ## Exception safety
+ *
+ * As for `tape`: only basic exception safety.
+ */
+template <typename... Columns>
+class columnar_tape;
+
+template <typename Tape>
+class columnar_tape_row;
+
+namespace detail {
+
+// The column which stores a field of type T.
+template <typename T>
+struct columnar_tape_column {
+  static_assert(
+      std::is_trivially_copyable_v<T>,
+      "columnar_tape: fixed-width fields must be trivially copyable");
+  using type = std::vector<T>;
+  using scalar_type = T;
+  static constexpr bool is_variable = false;
+};
+
+template <typename C, typename Traits, typename Allocator>
+struct columnar_tape_column<std::basic_string<C, Traits, Allocator>> {
+  using type = tape<std::vector<C>>;
+  using scalar_type = C;
+  static constexpr bool is_variable = true;
+};
+
+template <typename T, typename Allocator>
+struct columnar_tape_column<std::vector<T, Allocator>> {
+  using type = tape<std::vector<T>>;
+  using scalar_type = T;
+  static constexpr bool is_variable = true;
+};
+
+// Allows both std::get and ADL get, for rows of a columnar_tape.
+template <std::size_t I, typename Row>
+decltype(auto) columnar_tape_get(Row&& row) {
+  using std::get;
+  return get<I>(static_cast<Row&&>(row));
+}
+
+template <typename Field>
+std::size_t columnar_tape_field_size(const Field& field) {
+  if constexpr (std::is_convertible_v<const Field&, StringPiece>) {
+    return StringPiece(field).size();
+  } else {
+    return static_cast<std::size_t>(
+        std::distance(std::begin(field), std::end(field)));
+  }
+}
+
+// Little helpers for the serialized format. All integers are std::uint64_t.
+struct columnar_tape_writer {
+  std::string& out;
+
+  void write(const void* p, std::size_t n) {
+    out.append(static_cast<const char*>(p), n);
+  }
+  void write_u64(std::uint64_t v) { write(&v, sizeof(v)); }
+};
+
+struct columnar_tape_reader {
+  ByteRange in;
+
+  [[noreturn]] static void fail(const char* what) {
+    throw std::invalid_argument(std::string("columnar_tape: ") + what);
+  }
+
+  void check(bool cond, const char* what) const {
+    if (FOLLY_UNLIKELY(!cond)) {
+      fail(what);
+    }
+  }
+
+  void read(void* p, std::size_t n) {
+    check(n <= in.size(), "truncated input");
+    if (n) {
+      std::memcpy(p, in.data(), n);
+    }
+    in.advance(n);
+  }
+
+  std::uint64_t read_u64() {
+    std::uint64_t v;
+    read(&v, sizeof(v));
+    return v;
+  }
+
+  // reads count elements of T, checking the length before allocating
+  template <typename T>
+  void read_array(std::vector<T>& out, std::uint64_t count) {
+    check(count <= in.size() / sizeof(T), "truncated input");
+    out.resize(static_cast<std::size_t>(count));
+    read(out.data(), out.size() * sizeof(T));
+  }
+};
+
+} // namespace detail
+
+template <typename... Columns>
+class columnar_tape {
+  static_assert(sizeof...(Columns) > 0, "columnar_tape: no columns");
+
+  template <std::size_t I>
+  using column_traits = detail::columnar_tape_column<
+      std::tuple_element_t<I, std::tuple<Columns...>>>;
+
+  using indices = std::index_sequence_for<Columns...>;
+
+ public:
+  static constexpr std::size_t column_count = sizeof...(Columns);
+
+  template <std::size_t I>
+  using column_type = typename column_traits<I>::type;
+
+  template <std::size_t I>
+  static constexpr bool is_variable_column = column_traits<I>::is_variable;
+
+  using value_type = std::tuple<Columns...>;
+  using reference = columnar_tape_row<columnar_tape>;
+  using const_reference = columnar_tape_row<const columnar_tape>;
+
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  using iterator = index_iterator<columnar_tape>;
+  using const_iterator = index_iterator<const columnar_tape>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // constructors -----
+
+  columnar_tape() = default;
+
+  template <typename I, typename S>
+  columnar_tape(I f, S l) {
+    append(f, l);
+  }
+
+  explicit columnar_tape(std::initializer_list<value_type> il) {
+    append(il.begin(), il.end());
+  }
+
+  // access ------
+
+  [[nodiscard]] reference operator[](size_type i) noexcept {
+    assert(i < size());
+    return reference{*this, i};
+  }
+  [[nodiscard]] const_reference operator[](size_type i) const noexcept {
+    assert(i < size());
+    return const_reference{*this, i};
+  }
+
+  [[nodiscard]] reference at(size_type i) {
+    if (FOLLY_UNLIKELY(i >= size())) {
+      throw std::out_of_range("columnar_tape");
+    }
+    return operator[](i);
+  }
+  [[nodiscard]] const_reference at(size_type i) const {
+    if (FOLLY_UNLIKELY(i >= size())) {
+      throw std::out_of_range("columnar_tape");
+    }
+    return operator[](i);
+  }
+
+  [[nodiscard]] reference front() noexcept { return operator[](0); }
+  [[nodiscard]] const_reference front() const noexcept { return operator[](0); }
+  [[nodiscard]] reference back() noexcept { return operator[](size() - 1); }
+  [[nodiscard]] const_reference back() const noexcept {
+    return operator[](size() - 1);
+  }
+
+  // the field of column I of row i
+  template <std::size_t I>
+  [[nodiscard]] decltype(auto) get(size_type i) noexcept {
+    return std::get<I>(columns_)[i];
+  }
+  template <std::size_t I>
+  [[nodiscard]] decltype(auto) get(size_type i) const noexcept {
+    return std::get<I>(columns_)[i];
+  }
+
+  // the whole column I, a std::vector or a tape
+  template <std::size_t I>
+  [[nodiscard]] const column_type<I>& column() const noexcept {
+    return std::get<I>(columns_);
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+  [[nodiscard]] size_type size() const noexcept {
+    return std::get<0>(columns_).size();
+  }
+
+  // iterators ----
+
+  [[nodiscard]] iterator begin() noexcept { return {*this, 0}; }
+  [[nodiscard]] const_iterator begin() const noexcept { return {*this, 0}; }
+  [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+  [[nodiscard]] iterator end() noexcept { return {*this, size()}; }
+  [[nodiscard]] const_iterator end() const noexcept { return {*this, size()}; }
+  [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+  [[nodiscard]] reverse_iterator rbegin() noexcept {
+    return reverse_iterator{end()};
+  }
+  [[nodiscard]] const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+  [[nodiscard]] const_reverse_iterator crbegin() const noexcept {
+    return rbegin();
+  }
+
+  [[nodiscard]] reverse_iterator rend() noexcept {
+    return reverse_iterator{begin()};
+  }
+  [[nodiscard]] const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+  [[nodiscard]] const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // push / emplace_back --------
+
+  // one argument per column: a value for a fixed-width column, anything that
+  // tape::push_back accepts for a variable-width one.
+  template <
+      typename... Args,
+      typename = std::enable_if_t<sizeof...(Args) == column_count>>
+  void push_back(Args&&... args) {
+    push_back_impl(indices{}, static_cast<Args&&>(args)...);
+  }
+
+  template <
+      typename... Args,
+      typename = std::enable_if_t<sizeof...(Args) == column_count>>
+  void emplace_back(Args&&... args) {
+    push_back(static_cast<Args&&>(args)...);
+  }
+
+  // append many rows --------
+
+  template <typename I, typename S>
+  void append(I f, S l);
+
+  void append(const columnar_tape& other);
+
+  // capacity ------
+
+  void reserve(size_type rows) {
+    for_each_column([&](auto& column) { column.reserve(rows); });
+  }
+
+  void shrink_to_fit() {
+    for_each_column([](auto& column) { column.shrink_to_fit(); });
+  }
+
+  // erase -------
+
+  void clear() noexcept {
+    for_each_column([](auto& column) { column.clear(); });
+  }
+
+  void pop_back() noexcept {
+    assert(!empty());
+    for_each_column([](auto& column) { column.pop_back(); });
+  }
+
+  // note: same behaviour as for std::vector, erasing end() is UB
+  iterator erase(const_iterator pos) {
+    assert(pos != end());
+    return erase(pos, pos + 1);
+  }
+
+  iterator erase(const_iterator f, const_iterator l);
+
+  // serialization -------
+
+  void serialize(std::string& out) const;
+
+  [[nodiscard]] std::string serialize() const {
+    std::string out;
+    serialize(out);
+    return out;
+  }
+
+  [[nodiscard]] static columnar_tape deserialize(ByteRange in);
+
+  // comparison --------
+
+  friend bool operator==(const columnar_tape& x, const columnar_tape& y) {
+    return x.columns_ == y.columns_;
+  }
+  friend bool operator!=(const columnar_tape& x, const columnar_tape& y) {
+    return !(x == y);
+  }
+
+ private:
+  template <typename Tape>
+  friend class columnar_tape_row;
+
+  // "FOLYCTP1", which also fails to match when read in the other byte order
+  static constexpr std::uint64_t kSerializationMagic = 0x31505443594c4f46;
+
+  template <std::size_t... I, typename... Args>
+  void push_back_impl(std::index_sequence<I...>, Args&&... args) {
+    (std::get<I>(columns_).push_back(static_cast<Args&&>(args)), ...);
+  }
+
+  template <typename F>
+  void for_each_column(F f) {
+    std::apply([&](auto&... column) { (f(column), ...); }, columns_);
+  }
+
+  template <std::size_t... I, typename Row>
+  static void add_flat_sizes(
+      std::index_sequence<I...>,
+      std::array<size_type, column_count>& flat,
+      const Row& row) {
+    ((flat[I] += flat_size_of<I>(row)), ...);
+  }
+
+  template <std::size_t I, typename Row>
+  static size_type flat_size_of(const Row& row) {
+    if constexpr (is_variable_column<I>) {
+      return detail::columnar_tape_field_size(
+          detail::columnar_tape_get<I>(row));
+    } else {
+      return 0;
+    }
+  }
+
+  template <std::size_t... I>
+  void reserve_columns(
+      std::index_sequence<I...>,
+      size_type rows,
+      const std::array<size_type, column_count>& flat) {
+    auto one = [&](auto& column, size_type more) {
+      if constexpr (is_instantiation_of_v<
+                        std::vector,
+                        std::remove_reference_t<decltype(column)>>) {
+        column.reserve(rows);
+      } else {
+        column.reserve(rows, column.size_flat() + more);
+      }
+    };
+    (one(std::get<I>(columns_), flat[I]), ...);
+  }
+
+  template <std::size_t... I, typename Row>
+  void push_back_row(std::index_sequence<I...>, Row&& row) {
+    push_back(detail::columnar_tape_get<I>(row)...);
+  }
+
+  template <std::size_t... I, typename Row>
+  void push_back_row_unsafe(std::index_sequence<I...>, Row&& row) {
+    (push_back_field_unsafe<I>(detail::columnar_tape_get<I>(row)), ...);
+  }
+
+  template <std::size_t I, typename Field>
+  void push_back_field_unsafe(Field&& field) {
+    if constexpr (is_variable_column<I>) {
+      std::get<I>(columns_).push_back_unsafe(static_cast<Field&&>(field));
+    } else {
+      std::get<I>(columns_).push_back(static_cast<Field&&>(field));
+    }
+  }
+
+  template <std::size_t... I>
+  void append_impl(std::index_sequence<I...>, const columnar_tape& other);
+
+  template <std::size_t... I>
+  void serialize_impl(
+      std::index_sequence<I...>, detail::columnar_tape_writer& w) const;
+
+  template <std::size_t... I>
+  void deserialize_impl(
+      std::index_sequence<I...>,
+      detail::columnar_tape_reader& r,
+      std::uint64_t rows);
+
+  std::tuple<typename detail::columnar_tape_column<Columns>::type...> columns_;
+};
+
+// A proxy for one row of a columnar_tape. Tape is either columnar_tape<...>
+// or const columnar_tape<...>.
+template <typename Tape>
+class columnar_tape_row {
+ public:
+  using tape_type = std::remove_const_t<Tape>;
+  using value_type = typename tape_type::value_type;
+  using size_type = typename tape_type::size_type;
+
+  columnar_tape_row(Tape& self, size_type index) noexcept
+      : self_(&self), index_(index) {}
+
+  template <
+      typename Other,
+      typename = std::enable_if_t<
+          std::is_const_v<Tape> && std::is_same_v<Other, tape_type>>>
+  /* implicit */ columnar_tape_row(columnar_tape_row<Other> other) noexcept
+      : self_(other.self_), index_(other.index_) {}
+
+  // T& (or const T&) for a fixed-width field, the tape reference for a
+  // variable-width one.
+  template <std::size_t I>
+  [[nodiscard]] decltype(auto) get() const noexcept {
+    return std::get<I>(self_->columns_)[index_];
+  }
+
+  template <std::size_t I>
+  friend decltype(auto) get(const columnar_tape_row& row) noexcept {
+    return row.template get<I>();
+  }
+
+  [[nodiscard]] size_type index() const noexcept { return index_; }
+
+  [[nodiscard]] value_type to_value() const {
+    return to_value_impl(std::make_index_sequence<tape_type::column_count>{});
+  }
+
+  /* implicit */ operator value_type() const { return to_value(); }
+
+ private:
+  template <typename>
+  friend class columnar_tape_row;
+
+  template <std::size_t... I>
+  value_type to_value_impl(std::index_sequence<I...>) const {
+    return value_type{make_field<I>()...};
+  }
+
+  template <std::size_t I>
+  auto make_field() const {
+    using field = std::tuple_element_t<I, value_type>;
+    if constexpr (tape_type::template is_variable_column<I>) {
+      auto r = get<I>();
+      return field(r.begin(), r.end());
+    } else {
+      return field(get<I>());
+    }
+  }
+
+  Tape* self_;
+  size_type index_;
+};
+
+// columnar_tape methods -----
+
+template <typename... Columns>
+template <typename I, typename S>
+void columnar_tape<Columns...>::append(I f, S l) {
+  if constexpr (!iterator_category_matches_v<I, std::forward_iterator_tag>) {
+    for (; f != l; ++f) {
+      push_back_row(indices{}, *f);
+    }
+  } else {
+    // size every column first, then fill without reallocating
+    size_type rows = 0;
+    std::array<size_type, column_count> flat{};
+    for (I i = f; i != l; ++i) {
+      ++rows;
+      add_flat_sizes(indices{}, flat, *i);
+    }
+    reserve_columns(indices{}, size() + rows, flat);
+    for (; f != l; ++f) {
+      push_back_row_unsafe(indices{}, *f);
+    }
+  }
+}
+
+template <typename... Columns>
+void columnar_tape<Columns...>::append(const columnar_tape& other) {
+  if (this == &other) {
+    const columnar_tape copy = other;
+    append_impl(indices{}, copy);
+  } else {
+    append_impl(indices{}, other);
+  }
+}
+
+template <typename... Columns>
+template <std::size_t... I>
+void columnar_tape<Columns...>::append_impl(
+    std::index_sequence<I...>, const columnar_tape& other) {
+  auto one = [&](auto& column, const auto& from) {
+    if constexpr (is_instantiation_of_v<
+                      std::vector,
+                      std::remove_reference_t<decltype(column)>>) {
+      column.insert(column.end(), from.begin(), from.end());
+    } else {
+      column.reserve(
+          column.size() + from.size(), column.size_flat() + from.size_flat());
+      for (auto record : from) {
+        column.push_back_unsafe(record);
+      }
+    }
+  };
+  (one(std::get<I>(columns_), std::get<I>(other.columns_)), ...);
+}
+
+template <typename... Columns>
+auto columnar_tape<Columns...>::erase(const_iterator f, const_iterator l)
+    -> iterator {
+  auto from = f.get_index();
+  auto to = l.get_index();
+  for_each_column([&](auto& column) {
+    column.erase(column.begin() + from, column.begin() + to);
+  });
+  return {*this, static_cast<size_type>(from)};
+}
+
+template <typename... Columns>
+void columnar_tape<Columns...>::serialize(std::string& out) const {
+  detail::columnar_tape_writer w{out};
+  w.write_u64(kSerializationMagic);
+  w.write_u64(column_count);
+  w.write_u64(size());
+  serialize_impl(indices{}, w);
+}
+
+template <typename... Columns>
+template <std::size_t... I>
+void columnar_tape<Columns...>::serialize_impl(
+    std::index_sequence<I...>, detail::columnar_tape_writer& w) const {
+  auto one = [&](auto c) {
+    constexpr std::size_t C = decltype(c)::value;
+    using scalar = typename column_traits<C>::scalar_type;
+    static_assert(
+        std::is_trivially_copyable_v<scalar>,
+        "columnar_tape: serialized elements must be trivially copyable");
+    const auto& column = std::get<C>(columns_);
+    w.write_u64(sizeof(scalar));
+    if constexpr (is_variable_column<C>) {
+      for (auto m : column.markers()) {
+        w.write_u64(static_cast<std::uint64_t>(m));
+      }
+      auto scalars = column.scalars();
+      w.write(scalars.data(), scalars.size() * sizeof(scalar));
+    } else {
+      w.write(column.data(), column.size() * sizeof(scalar));
+    }
+  };
+  (one(std::integral_constant<std::size_t, I>{}), ...);
+}
+
+template <typename... Columns>
+auto columnar_tape<Columns...>::deserialize(ByteRange in) -> columnar_tape {
+  detail::columnar_tape_reader r{in};
+  r.check(r.read_u64() == kSerializationMagic, "bad magic");
+  r.check(r.read_u64() == column_count, "column count mismatch");
+  auto rows = r.read_u64();
+  columnar_tape result;
+  result.deserialize_impl(indices{}, r, rows);
+  r.check(r.in.empty(), "trailing bytes");
+  return result;
+}
+
+template <typename... Columns>
+template <std::size_t... I>
+void columnar_tape<Columns...>::deserialize_impl(
+    std::index_sequence<I...>,
+    detail::columnar_tape_reader& r,
+    std::uint64_t rows) {
+  auto one = [&](auto c) {
+    constexpr std::size_t C = decltype(c)::value;
+    using scalar = typename column_traits<C>::scalar_type;
+    auto& column = std::get<C>(columns_);
+    r.check(r.read_u64() == sizeof(scalar), "element size mismatch");
+    if constexpr (is_variable_column<C>) {
+      r.check(rows < r.in.size() / sizeof(std::uint64_t), "truncated input");
+      std::vector<std::uint64_t> markers;
+      r.read_array(markers, rows + 1);
+      r.check(markers.front() == 0, "bad offsets");
+      for (std::size_t i = 0; i != rows; ++i) {
+        r.check(markers[i] <= markers[i + 1], "bad offsets");
+      }
+      std::vector<scalar> scalars;
+      r.read_array(scalars, markers.back());
+      column.reserve(rows, scalars.size());
+      for (std::size_t i = 0; i != rows; ++i) {
+        column.push_back_unsafe(
+            scalars.data() + markers[i], scalars.data() + markers[i + 1]);
+      }
+    } else {
+      r.read_array(column, rows);
+    }
+  };
+  (one(std::integral_constant<std::size_t, I>{}), ...);
+}
+
+} // namespace folly
+
+namespace std {
+
+template <typename Tape>
+struct tuple_size<::folly::columnar_tape_row<Tape>>
+    : integral_constant<size_t, remove_const_t<Tape>::column_count> {};
+
+template <size_t I, typename Tape>
+struct tuple_element<I, ::folly::columnar_tape_row<Tape>> {
+  using type = decltype(std::declval<const ::folly::columnar_tape_row<Tape>&>()
+                            .template get<I>());
+};
+
+} // namespace std
@@ -21,6 +21,7 @@
 #include <unordered_map>
 
 #include <folly/Optional.h>
+#include <folly/Range.h>
 #include <folly/lang/Assume.h>
 
 #include <folly/container/detail/F14Table.h>
@@ -152,6 +153,16 @@ class F14BasicMap : public std::unordered_map<K, M, H, E, A> {
     insert(ilist.begin(), ilist.end());
   }
 
+  template <class RandomIt>
+  std::size_t bulkInsert(RandomIt first, RandomIt last) {
+    std::size_t inserted = 0;
+    this->reserve(this->size() + (last - first));
+    for (; first != last; ++first) {
+      inserted += insert(*first).second;
+    }
+    return inserted;
+  }
+
   template <typename M2>
   std::pair<iterator, bool> insert_or_assign(key_type const& key, M2&& obj) {
     auto rv = try_emplace(key, std::forward<M2>(obj));
@@ -615,6 +626,88 @@ class F14BasicMap : public std::unordered_map<K, M, H, E, A> {
       F14HashToken const&, K2 const& key) const {
     return contains(key);
   }
+
+  void bulkFind(Range<key_type const*> keys, iterator* out) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  void bulkFind(Range<key_type const*> keys, const_iterator* out) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  template <typename K2>
+  EnableHeterogeneousFind<std::remove_const_t<K2>, void> bulkFind(
+      Range<K2*> keys, iterator* out) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  template <typename K2>
+  EnableHeterogeneousFind<std::remove_const_t<K2>, void> bulkFind(
+      Range<K2*> keys, const_iterator* out) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  template <typename F>
+  std::enable_if_t<std::is_invocable_v<F&, std::size_t, iterator>> bulkFind(
+      Range<key_type const*> keys, F&& visitor) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      visitor(i, find(keys[i]));
+    }
+  }
+
+  template <typename K2, typename F>
+  EnableHeterogeneousFind<
+      std::remove_const_t<K2>,
+      std::enable_if_t<std::is_invocable_v<F&, std::size_t, iterator>>>
+  bulkFind(Range<K2*> keys, F&& visitor) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      visitor(i, find(keys[i]));
+    }
+  }
+
+  template <typename F>
+  std::enable_if_t<std::is_invocable_v<F&, std::size_t, const_iterator>>
+  bulkFind(Range<key_type const*> keys, F&& visitor) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      visitor(i, find(keys[i]));
+    }
+  }
+
+  template <typename K2, typename F>
+  EnableHeterogeneousFind<
+      std::remove_const_t<K2>,
+      std::enable_if_t<std::is_invocable_v<F&, std::size_t, const_iterator>>>
+  bulkFind(Range<K2*> keys, F&& visitor) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      visitor(i, find(keys[i]));
+    }
+  }
+
+  std::size_t bulkContains(Range<key_type const*> keys, bool* out) const {
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      found += out[i] = contains(keys[i]);
+    }
+    return found;
+  }
+
+  template <typename K2>
+  EnableHeterogeneousFind<std::remove_const_t<K2>, std::size_t> bulkContains(
+      Range<K2*> keys, bool* out) const {
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      found += out[i] = contains(keys[i]);
+    }
+    return found;
+  }
 };
 } // namespace detail
 } // namespace f14
@@ -20,6 +20,7 @@
 #include <type_traits>
 #include <unordered_set>
 
+#include <folly/Range.h>
 #include <folly/container/detail/F14Table.h>
 #include <folly/container/detail/Util.h>
 
@@ -101,6 +102,16 @@ class F14BasicSet
     }
   }
 
+  template <class RandomIt>
+  std::size_t bulkInsert(RandomIt first, RandomIt last) {
+    std::size_t inserted = 0;
+    this->reserve(this->size() + (last - first));
+    for (; first != last; ++first) {
+      inserted += insert(*first).second;
+    }
+    return inserted;
+  }
+
  private:
   template <typename Arg>
   using UsableAsKey = ::folly::detail::
@@ -448,6 +459,70 @@ class F14BasicSet
       F14HashToken const&, K const& key) const {
     return find(key) != this->end();
   }
+
+  void bulkFind(Range<key_type const*> keys, iterator* out) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  void bulkFind(Range<key_type const*> keys, const_iterator* out) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, void> bulkFind(
+      Range<K*> keys, iterator* out) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, void> bulkFind(
+      Range<K*> keys, const_iterator* out) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find(keys[i]);
+    }
+  }
+
+  template <typename F>
+  std::enable_if_t<std::is_invocable_v<F&, std::size_t, const_iterator>>
+  bulkFind(Range<key_type const*> keys, F&& visitor) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      visitor(i, find(keys[i]));
+    }
+  }
+
+  template <typename K, typename F>
+  EnableHeterogeneousFind<
+      std::remove_const_t<K>,
+      std::enable_if_t<std::is_invocable_v<F&, std::size_t, const_iterator>>>
+  bulkFind(Range<K*> keys, F&& visitor) const {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      visitor(i, find(keys[i]));
+    }
+  }
+
+  std::size_t bulkContains(Range<key_type const*> keys, bool* out) const {
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      found += out[i] = contains(keys[i]);
+    }
+    return found;
+  }
+
+  template <typename K>
+  EnableHeterogeneousFind<std::remove_const_t<K>, std::size_t> bulkContains(
+      Range<K*> keys, bool* out) const {
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      found += out[i] = contains(keys[i]);
+    }
+    return found;
+  }
 };
 } // namespace detail
 } // namespace f14
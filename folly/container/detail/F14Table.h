@@ -1766,6 +1766,31 @@ class F14Table : public Policy {
     prefetchAddr(firstChunk);
   }
 
+  // Calls fn(i, prehash(keyAt(i))) for each i in [0, n), pipelined like a
+  // loop of prehash() and prefetch(): the first chunk of each key is
+  // prefetched kBulkLookahead keys ahead of its call, so that the cache
+  // misses of consecutive lookups overlap. fn may insert, as tokens stay
+  // valid across rehashes; it just makes the prefetches useless.
+  template <typename KeyAt, typename F>
+  FOLLY_ALWAYS_INLINE void forEachPrefetched(
+      std::size_t n, KeyAt&& keyAt, F&& fn) const {
+    constexpr std::size_t kBulkLookahead = 8;
+    F14HashToken tokens[kBulkLookahead];
+    for (std::size_t i = 0; i < n && i < kBulkLookahead; ++i) {
+      tokens[i] = prehash(keyAt(i));
+      prefetch(tokens[i]);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      auto& slot = tokens[i % kBulkLookahead];
+      auto token = slot;
+      if (i + kBulkLookahead < n) {
+        slot = prehash(keyAt(i + kBulkLookahead));
+        prefetch(slot);
+      }
+      fn(i, token);
+    }
+  }
+
   template <typename K>
   FOLLY_ALWAYS_INLINE ItemIter find(K const& key) const {
     auto hp = computeHash(key);
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/ConcurrentEvictingCache.h>
+
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+
+using namespace folly;
+
+namespace {
+
+constexpr size_t kCapacity = 100000;
+// Keys are drawn from twice the capacity, skewed towards the small ones.
+constexpr size_t kKeySpace = 2 * kCapacity;
+constexpr size_t kKeysPerThread = 1 << 16;
+
+uint64_t key(size_t i) {
+  return hash::twang_mix64(i);
+}
+
+std::vector<uint64_t> skewedKeys(size_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> dist;
+  std::vector<uint64_t> ret(kKeysPerThread);
+  for (auto& k : ret) {
+    auto u = dist(rng);
+    k = key(size_t(u * u * u * kKeySpace));
+  }
+  return ret;
+}
+
+struct LockedEvictingCacheMap {
+  explicit LockedEvictingCacheMap(size_t capacity)
+      : map(std::in_place, capacity) {}
+
+  bool get(uint64_t k) {
+    auto locked = map.wlock();
+    auto it = locked->find(k);
+    return it != locked->end();
+  }
+  void set(uint64_t k, size_t v) { map.wlock()->set(k, v); }
+
+  Synchronized<EvictingCacheMap<uint64_t, size_t>> map;
+};
+
+template <ConcurrentEvictingCache<uint64_t, size_t>::Policy kPolicy>
+struct Concurrent {
+  using Cache = ConcurrentEvictingCache<uint64_t, size_t>;
+
+  explicit Concurrent(size_t capacity)
+      : cache(capacity, [] {
+          Cache::Options options;
+          options.policy = kPolicy;
+          return options;
+        }()) {}
+
+  bool get(uint64_t k) { return cache.get(k).has_value(); }
+  void set(uint64_t k, size_t v) { cache.set(k, v); }
+
+  Cache cache;
+};
+
+using ConcurrentLru = Concurrent<
+    ConcurrentEvictingCache<uint64_t, size_t>::Policy::LRU>;
+using ConcurrentTinyLfu = Concurrent<
+    ConcurrentEvictingCache<uint64_t, size_t>::Policy::W_TINY_LFU>;
+
+// Each thread looks up skewed keys, and sets the value of the misses, like
+// a cache in front of a slower lookup.
+template <typename Cache>
+size_t readThrough(uint32_t n, size_t numThreads) {
+  BenchmarkSuspender suspender;
+  Cache cache(kCapacity);
+  std::vector<std::vector<uint64_t>> keys;
+  for (size_t t = 0; t < numThreads; ++t) {
+    keys.push_back(skewedKeys(t));
+  }
+  for (auto k : skewedKeys(numThreads)) {
+    if (!cache.get(k)) {
+      cache.set(k, k);
+    }
+  }
+
+  suspender.dismiss();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&, t] {
+      auto& mine = keys[t];
+      for (size_t i = 0; i < n; ++i) {
+        auto k = mine[i % kKeysPerThread];
+        if (!cache.get(k)) {
+          cache.set(k, k);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  suspender.rehire();
+  return n * numThreads;
+}
+
+size_t locked(uint32_t n, size_t numThreads) {
+  return readThrough<LockedEvictingCacheMap>(n, numThreads);
+}
+size_t concurrentLru(uint32_t n, size_t numThreads) {
+  return readThrough<ConcurrentLru>(n, numThreads);
+}
+size_t concurrentTinyLfu(uint32_t n, size_t numThreads) {
+  return readThrough<ConcurrentTinyLfu>(n, numThreads);
+}
+
+} // namespace
+
+#define CACHE_BENCHMARKS(threads)                                             \
+  BENCHMARK_NAMED_PARAM_MULTI(locked, threads##_threads, threads)             \
+  BENCHMARK_RELATIVE_NAMED_PARAM_MULTI(                                       \
+      concurrentLru, threads##_threads, threads)                              \
+  BENCHMARK_RELATIVE_NAMED_PARAM_MULTI(                                       \
+      concurrentTinyLfu, threads##_threads, threads)                          \
+  BENCHMARK_DRAW_LINE();
+
+CACHE_BENCHMARKS(1)
+CACHE_BENCHMARKS(2)
+CACHE_BENCHMARKS(4)
+CACHE_BENCHMARKS(8)
+CACHE_BENCHMARKS(16)
+CACHE_BENCHMARKS(32)
+CACHE_BENCHMARKS(64)
+
+int main(int argc, char** argv) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  runBenchmarks();
+}
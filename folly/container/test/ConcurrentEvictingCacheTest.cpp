@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/ConcurrentEvictingCache.h>
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+using Cache = ConcurrentEvictingCache<int, int>;
+
+namespace {
+
+Cache::Options options(Cache::Policy policy, size_t numShards = 1) {
+  Cache::Options ret;
+  ret.policy = policy;
+  ret.numShards = numShards;
+  return ret;
+}
+
+} // namespace
+
+TEST(ConcurrentEvictingCache, SanityTest) {
+  for (auto policy : {Cache::Policy::LRU, Cache::Policy::W_TINY_LFU}) {
+    Cache cache(1000, options(policy, 4));
+    EXPECT_EQ(4, cache.numShards());
+    EXPECT_TRUE(cache.empty());
+    EXPECT_FALSE(cache.get(1));
+
+    EXPECT_TRUE(cache.set(1, 10));
+    EXPECT_EQ(10, cache.get(1));
+    EXPECT_TRUE(cache.exists(1));
+    EXPECT_FALSE(cache.insert(1, 11));
+    EXPECT_EQ(10, cache.getWithoutPromotion(1));
+    EXPECT_TRUE(cache.set(1, 12));
+    EXPECT_EQ(12, cache.get(1));
+    EXPECT_EQ(1, cache.size());
+
+    EXPECT_TRUE(cache.insert(2, 20));
+    EXPECT_EQ(2, cache.size());
+    EXPECT_TRUE(cache.erase(1));
+    EXPECT_FALSE(cache.erase(1));
+    EXPECT_FALSE(cache.exists(1));
+    EXPECT_EQ(20, cache.get(2));
+    EXPECT_EQ(1, cache.size());
+    EXPECT_EQ(1, cache.getTotalWeight());
+  }
+}
+
+TEST(ConcurrentEvictingCache, NumShards) {
+  // Shards hold at least 64 entries.
+  EXPECT_EQ(1, Cache(100, options(Cache::Policy::LRU, 16)).numShards());
+  EXPECT_EQ(8, Cache(512, options(Cache::Policy::LRU, 6)).numShards());
+  EXPECT_EQ(1, Cache(10).numShards());
+  EXPECT_LE(1, Cache(1 << 20).numShards());
+}
+
+TEST(ConcurrentEvictingCache, LruPromotion) {
+  Cache cache(100, options(Cache::Policy::LRU));
+  for (int i = 0; i < 100; ++i) {
+    cache.set(i, i);
+  }
+  EXPECT_EQ(100, cache.size());
+  // Accesses are applied by the next writer.
+  EXPECT_EQ(0, cache.get(0));
+  EXPECT_EQ(2, cache.getWithoutPromotion(2));
+  cache.set(100, 100);
+  EXPECT_TRUE(cache.exists(0));
+  EXPECT_FALSE(cache.exists(1));
+  cache.set(101, 101);
+  EXPECT_FALSE(cache.exists(2));
+  EXPECT_EQ(100, cache.size());
+
+  // More accesses than the buffers hold.
+  for (int i = 0; i < 1000; ++i) {
+    cache.get(50);
+  }
+  for (int i = 200; i < 299; ++i) {
+    cache.set(i, i);
+  }
+  EXPECT_TRUE(cache.exists(50));
+  EXPECT_EQ(100, cache.size());
+}
+
+TEST(ConcurrentEvictingCache, TinyLfuResistsScans) {
+  constexpr int kHot = 500;
+  for (auto policy : {Cache::Policy::LRU, Cache::Policy::W_TINY_LFU}) {
+    Cache cache(1000, options(policy));
+    for (int round = 0; round < 4; ++round) {
+      for (int i = 0; i < kHot; ++i) {
+        if (!cache.get(i)) {
+          cache.set(i, i);
+        }
+      }
+    }
+    // Keys accessed once, twice the size of the cache.
+    for (int i = kHot; i < kHot + 2000; ++i) {
+      cache.set(i, i);
+    }
+    EXPECT_EQ(1000, cache.size());
+    int hot = 0;
+    for (int i = 0; i < kHot; ++i) {
+      hot += cache.exists(i);
+    }
+    if (policy == Cache::Policy::LRU) {
+      EXPECT_EQ(0, hot);
+    } else {
+      EXPECT_LT(kHot * 9 / 10, hot);
+    }
+  }
+}
+
+TEST(ConcurrentEvictingCache, Weights) {
+  using StringCache = ConcurrentEvictingCache<std::string, std::string>;
+  StringCache::Options opts;
+  opts.numShards = 1;
+  opts.weigher = [](const std::string&, const std::string& value) {
+    return value.size();
+  };
+  StringCache cache(100, opts);
+  EXPECT_TRUE(cache.set("a", std::string(40, 'a')));
+  EXPECT_TRUE(cache.set("b", std::string(40, 'b')));
+  EXPECT_EQ(80, cache.getTotalWeight());
+  EXPECT_TRUE(cache.set("c", std::string(30, 'c')));
+  EXPECT_FALSE(cache.exists("a"));
+  EXPECT_EQ(70, cache.getTotalWeight());
+
+  // Growing a value evicts others, too heavy values are not cached.
+  EXPECT_TRUE(cache.set("c", std::string(61, 'c')));
+  EXPECT_FALSE(cache.exists("b"));
+  EXPECT_EQ(61, cache.getTotalWeight());
+  EXPECT_FALSE(cache.set("d", std::string(101, 'd')));
+  EXPECT_FALSE(cache.exists("d"));
+  EXPECT_FALSE(cache.set("c", std::string(101, 'c')));
+  EXPECT_FALSE(cache.exists("c"));
+  EXPECT_EQ(0, cache.getTotalWeight());
+  EXPECT_EQ(0, cache.size());
+
+  // Heterogeneous lookups.
+  cache.set("e", "e");
+  EXPECT_EQ("e", cache.get(std::string_view("e")));
+}
+
+TEST(ConcurrentEvictingCache, PruneHook) {
+  std::vector<std::pair<int, int>> pruned;
+  auto opts = options(Cache::Policy::LRU);
+  opts.pruneHook = [&](const int& key, int&& value) {
+    pruned.emplace_back(key, value);
+  };
+  {
+    Cache cache(64, opts);
+    for (int i = 0; i < 66; ++i) {
+      cache.set(i, -i);
+    }
+    ASSERT_EQ(2, pruned.size());
+    EXPECT_EQ(std::make_pair(0, 0), pruned[0]);
+    EXPECT_EQ(std::make_pair(1, -1), pruned[1]);
+
+    // Not called for erase() nor for the destructor, but for clear().
+    cache.erase(2);
+    EXPECT_EQ(2, pruned.size());
+    cache.clear();
+    EXPECT_EQ(65, pruned.size());
+    EXPECT_TRUE(cache.empty());
+    EXPECT_EQ(0, cache.getTotalWeight());
+    cache.set(1, 1);
+  }
+  EXPECT_EQ(65, pruned.size());
+}
+
+TEST(ConcurrentEvictingCache, Concurrent) {
+  constexpr int kThreads = 8;
+  constexpr int kOps = 20000;
+  for (auto policy : {Cache::Policy::LRU, Cache::Policy::W_TINY_LFU}) {
+    Cache cache(512, options(policy, 4));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        uint32_t x = t + 1;
+        for (int i = 0; i < kOps; ++i) {
+          x = x * 1664525 + 1013904223;
+          int key = (x >> 8) % 2048;
+          switch (x & 7) {
+            case 0:
+              cache.set(key, key);
+              break;
+            case 1:
+              cache.erase(key);
+              break;
+            default:
+              if (auto value = cache.get(key)) {
+                EXPECT_EQ(key, *value);
+              } else {
+                cache.insert(key, key);
+              }
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_LE(cache.size(), 512);
+    EXPECT_EQ(cache.size(), cache.getTotalWeight());
+  }
+}
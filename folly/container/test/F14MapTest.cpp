@@ -18,11 +18,15 @@
 
 #include <algorithm>
 #include <chrono>
+#include <memory>
 #include <random>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <typeinfo>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -927,6 +931,93 @@ TEST(F14FastMap, prehash) {
   runPrehash<F14FastMap<std::string, std::string>>();
 }
 
+template <typename T>
+void runBulkOperations() {
+  T h;
+  std::vector<std::string> keys;
+  bool found[1];
+  typename T::iterator iters[1];
+  h.bulkFind(folly::range(keys), iters);
+  EXPECT_EQ(0, h.bulkContains(folly::range(keys), found));
+
+  // More than the lookahead, with duplicates and misses.
+  std::vector<std::pair<std::string, std::string>> pairs;
+  for (int i = 0; i < 100; ++i) {
+    pairs.emplace_back(folly::to<std::string>(i % 90), s("x"));
+  }
+  EXPECT_EQ(90, h.bulkInsert(pairs.begin(), pairs.end()));
+  EXPECT_EQ(90, h.size());
+  std::vector<std::pair<std::string, std::string>> moved = {
+      {s("new"), s("y")}, {s("0"), s("z")}};
+  EXPECT_EQ(
+      1,
+      h.bulkInsert(
+          std::make_move_iterator(moved.begin()),
+          std::make_move_iterator(moved.end())));
+  EXPECT_EQ(91, h.size());
+  EXPECT_EQ("y", h.at("new"));
+  EXPECT_EQ("x", h.at("0"));
+  EXPECT_EQ("z", moved[1].second);
+
+  for (int i = 0; i < 200; i += 3) {
+    keys.push_back(folly::to<std::string>(i));
+  }
+  std::vector<typename T::iterator> out(keys.size());
+  std::vector<typename T::const_iterator> constOut(keys.size());
+  std::unique_ptr<bool[]> contained(new bool[keys.size()]);
+  h.bulkFind(folly::range(keys), out.data());
+  std::as_const(h).bulkFind(folly::range(keys), constOut.data());
+  EXPECT_EQ(30, h.bulkContains(folly::range(keys), contained.get()));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(out[i] == h.find(keys[i]));
+    EXPECT_TRUE(constOut[i] == h.find(keys[i]));
+    EXPECT_EQ(h.contains(keys[i]), contained[i]);
+  }
+
+  // Heterogeneous keys.
+  std::vector<std::string_view> views(keys.begin(), keys.end());
+  h.bulkFind(folly::range(views), out.data());
+  EXPECT_EQ(30, h.bulkContains(folly::range(views), contained.get()));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(out[i] == h.find(keys[i]));
+  }
+
+  // Visitors, called in order.
+  size_t next = 0;
+  h.bulkFind(folly::range(keys), [&](size_t i, typename T::iterator iter) {
+    EXPECT_EQ(next++, i);
+    EXPECT_TRUE(iter == out[i]);
+    if (iter != h.end()) {
+      iter->second = "found";
+    }
+  });
+  EXPECT_EQ(keys.size(), next);
+  EXPECT_EQ("found", h.at("3"));
+  next = 0;
+  std::as_const(h).bulkFind(
+      folly::range(views), [&](size_t i, typename T::const_iterator iter) {
+        EXPECT_EQ(next++, i);
+        EXPECT_EQ(contained[i], iter != h.cend());
+      });
+  EXPECT_EQ(keys.size(), next);
+}
+
+TEST(F14ValueMap, bulkOperations) {
+  runBulkOperations<F14ValueMap<std::string, std::string>>();
+}
+
+TEST(F14NodeMap, bulkOperations) {
+  runBulkOperations<F14NodeMap<std::string, std::string>>();
+}
+
+TEST(F14VectorMap, bulkOperations) {
+  runBulkOperations<F14VectorMap<std::string, std::string>>();
+}
+
+TEST(F14FastMap, bulkOperations) {
+  runBulkOperations<F14FastMap<std::string, std::string>>();
+}
+
 TEST(F14ValueMap, random) {
   runRandom<F14ValueMap<
       uint64_t,
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/F14MappedMap.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <folly/FileUtil.h>
+#include <folly/container/F14Map.h>
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+using namespace folly;
+
+namespace {
+
+struct Entry {
+  uint32_t id;
+  double score;
+};
+
+// Every key collides, so lookups walk the probe sequence of all chunks.
+struct ConstantHasher {
+  size_t operator()(int) const { return 42; }
+};
+
+std::vector<uint64_t> alignedCopy(std::string const& bytes) {
+  std::vector<uint64_t> ret((bytes.size() + 15) / 8);
+  std::memcpy(ret.data(), bytes.data(), bytes.size());
+  return ret;
+}
+
+ByteRange rangeOf(std::vector<uint64_t> const& v, size_t size) {
+  return {reinterpret_cast<uint8_t const*>(v.data()), size};
+}
+
+} // namespace
+
+TEST(F14MappedMap, Empty) {
+  F14MappedMap<int, int> empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty.end(), empty.find(1));
+
+  auto bytes = F14MappedMap<int, int>::serialize(F14FastMap<int, int>());
+  auto map = F14MappedMap<int, int>::fromBytes(ByteRange(StringPiece(bytes)));
+  map.validate();
+  EXPECT_EQ(0, map.size());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_FALSE(map.contains(0));
+}
+
+TEST(F14MappedMap, Lookups) {
+  using Map = F14MappedMap<uint64_t, Entry>;
+  for (size_t n : {1, 10, 11, 1000, 100000}) {
+    F14VectorMap<uint64_t, Entry> source;
+    for (uint64_t i = 0; i < n; ++i) {
+      source[i * 7] = {uint32_t(i), i * 0.5};
+    }
+    auto bytes = Map::serialize(source);
+    auto map = Map::fromBytes(ByteRange(StringPiece(bytes)));
+    map.validate();
+    ASSERT_EQ(n, map.size());
+    for (uint64_t i = 0; i < n; ++i) {
+      auto it = map.find(i * 7);
+      ASSERT_NE(map.end(), it) << i;
+      EXPECT_EQ(i * 7, it->first);
+      EXPECT_EQ(i, it->second.id);
+      EXPECT_EQ(i * 0.5, map.at(i * 7).score);
+      EXPECT_FALSE(map.contains(i * 7 + 1));
+    }
+    EXPECT_EQ(0, map.count(n * 7));
+    EXPECT_THROW(map.at(1), std::out_of_range);
+
+    // Values keep the order of the source.
+    auto it = map.begin();
+    for (auto const& [key, entry] : source) {
+      EXPECT_EQ(key, it->first);
+      EXPECT_EQ(entry.id, it->second.id);
+      ++it;
+    }
+  }
+}
+
+TEST(F14MappedMap, Collisions) {
+  using Map = F14MappedMap<int, int, ConstantHasher>;
+  F14FastMap<int, int> source;
+  for (int i = 0; i < 500; ++i) {
+    source[i] = -i;
+  }
+  auto bytes = Map::serialize(source);
+  auto map = Map::fromBytes(ByteRange(StringPiece(bytes)));
+  map.validate();
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(-i, map.at(i));
+  }
+  EXPECT_FALSE(map.contains(500));
+}
+
+TEST(F14MappedMap, FromBytes) {
+  using Map = F14MappedMap<uint64_t, uint32_t>;
+  F14FastMap<uint64_t, uint32_t> source;
+  for (uint32_t i = 1; i <= 100; ++i) {
+    source[i] = i;
+  }
+  auto bytes = Map::serialize(source);
+  auto copy = alignedCopy(bytes);
+  auto range = rangeOf(copy, bytes.size());
+  EXPECT_EQ(100, Map::fromBytes(range).size());
+
+  EXPECT_THROW(Map::fromBytes(range.subpiece(8)), std::invalid_argument);
+  EXPECT_THROW(Map::fromBytes(range.subpiece(0, 32)), std::runtime_error);
+  EXPECT_THROW(
+      Map::fromBytes(range.subpiece(0, range.size() - 1)), std::runtime_error);
+  // Other types, another hasher.
+  EXPECT_THROW(
+      (F14MappedMap<uint64_t, uint64_t>::fromBytes(range)),
+      std::runtime_error);
+  EXPECT_THROW(
+      (F14MappedMap<uint32_t, uint32_t>::fromBytes(range)),
+      std::runtime_error);
+  EXPECT_THROW(
+      (F14MappedMap<uint64_t, uint32_t, hasher<uint64_t>>::fromBytes(range)),
+      std::runtime_error);
+
+  auto corrupt = [&](size_t at, uint8_t byte) {
+    auto c = copy;
+    reinterpret_cast<uint8_t*>(c.data())[at] = byte;
+    Map::fromBytes(rangeOf(c, range.size())).validate();
+  };
+  // The magic, the version, the chunk shift.
+  EXPECT_THROW(corrupt(0, 'x'), std::runtime_error);
+  EXPECT_THROW(corrupt(4, 2), std::runtime_error);
+  EXPECT_THROW(corrupt(28, 40), std::runtime_error);
+  // A tag, an index, a key of the first chunk.
+  EXPECT_THROW(corrupt(64 + 13, 0x80), std::runtime_error);
+  EXPECT_THROW(corrupt(64 + 16, 0xff), std::runtime_error);
+  auto valuesOffset = range.size() - 100 * sizeof(Map::value_type);
+  EXPECT_THROW(corrupt(valuesOffset + 16, 0xff), std::runtime_error);
+}
+
+TEST(F14MappedMap, MapFile) {
+  using Map = F14MappedMap<uint64_t, Entry>;
+  F14FastMap<uint64_t, Entry> source;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    source[i * i] = {uint32_t(i), 1.0 / (i + 1)};
+  }
+  test::TemporaryFile file;
+  {
+    auto bytes = Map::serialize(source);
+    ASSERT_EQ(bytes.size(), writeFull(file.fd(), bytes.data(), bytes.size()));
+  }
+  // The mapping outlives the first map, through its copy.
+  auto map = [&] {
+    auto mapped = Map::mapFile(file.path().string().c_str());
+    auto ret = mapped;
+    return ret;
+  }();
+  map.validate();
+  EXPECT_EQ(source.size(), map.size());
+  for (auto const& [key, entry] : source) {
+    EXPECT_EQ(entry.id, map.at(key).id);
+  }
+}
@@ -26,11 +26,14 @@ FOLLY_GNU_DISABLE_WARNING("-Wdeprecated-declarations")
 // clang-format on
 
 #include <chrono>
+#include <memory>
 #include <numeric>
 #include <random>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -1459,6 +1462,62 @@ TEST(F14FastSet, heterogeneousInsert) {
   runHeterogeneousInsertStringTest<F14FastSet<std::string>>();
 }
 
+template <typename S>
+void runBulkOperations() {
+  S set;
+  std::vector<std::string> values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(folly::to<std::string>(i % 90));
+  }
+  EXPECT_EQ(90, set.bulkInsert(values.begin(), values.end()));
+  EXPECT_EQ(0, set.bulkInsert(values.begin(), values.begin()));
+  EXPECT_EQ(90, set.size());
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 200; i += 3) {
+    keys.push_back(folly::to<std::string>(i));
+  }
+  std::vector<typename S::iterator> out(keys.size());
+  std::unique_ptr<bool[]> contained(new bool[keys.size()]);
+  set.bulkFind(folly::range(keys), out.data());
+  EXPECT_EQ(30, set.bulkContains(folly::range(keys), contained.get()));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(out[i] == set.find(keys[i]));
+    EXPECT_EQ(set.contains(keys[i]), contained[i]);
+  }
+
+  std::vector<std::string_view> views(keys.begin(), keys.end());
+  EXPECT_EQ(30, set.bulkContains(folly::range(views), contained.get()));
+  set.bulkFind(folly::range(views), out.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(out[i] == set.find(keys[i]));
+  }
+
+  size_t next = 0;
+  set.bulkFind(
+      folly::range(keys), [&](size_t i, typename S::const_iterator iter) {
+        EXPECT_EQ(next++, i);
+        EXPECT_TRUE(iter == out[i]);
+      });
+  EXPECT_EQ(keys.size(), next);
+}
+
+TEST(F14ValueSet, bulkOperations) {
+  runBulkOperations<F14ValueSet<std::string>>();
+}
+
+TEST(F14NodeSet, bulkOperations) {
+  runBulkOperations<F14NodeSet<std::string>>();
+}
+
+TEST(F14VectorSet, bulkOperations) {
+  runBulkOperations<F14VectorSet<std::string>>();
+}
+
+TEST(F14FastSet, bulkOperations) {
+  runBulkOperations<F14FastSet<std::string>>();
+}
+
 namespace {
 
 // std::is_convertible is not transitive :( Problem scenario: B<T> is
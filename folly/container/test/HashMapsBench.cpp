@@ -19,7 +19,9 @@
 #include <map>
 #include <random>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include <glog/logging.h>
 #include <folly/Benchmark.h>
@@ -264,6 +266,51 @@ void benchmarkFind(int runs, int size) {
       2);
 }
 
+// The lookups of benchmarkFind, 64 at a time through bulkFind(), or through
+// find() for std::unordered_map.
+template <template <class, class> class Map, class K, class V>
+void benchmarkBulkFind(int runs, int size) {
+  constexpr size_t kBatch = 64;
+  BenchmarkSuspender braces;
+  Map<K, V> map(size);
+  std::vector<K> toInsert;
+  prepare<K>(size);
+  for (int i = 0; i < size; ++i) {
+    toInsert.push_back(key<K>(i));
+  }
+  for (int i = 0; i * 2 < size; ++i) {
+    map.insert(std::pair<K, V>(toInsert[i], value<V>(i * 3)));
+  }
+  std::shuffle(toInsert.begin(), toInsert.end(), getRNG());
+  std::vector<K> toFind;
+  for (int i = 0; i < size; i += 2) {
+    toFind.push_back(toInsert[i]);
+  }
+  folly::makeUnpredictable(map);
+  folly::makeUnpredictable(toFind);
+  int x = 0;
+  auto use = [&](size_t, typename Map<K, V>::iterator it) {
+    if (it != map.end()) {
+      x ^= it->second[0];
+    }
+  };
+  braces.dismissing([&] {
+    for (int r = 0; r < runs; ++r) {
+      for (size_t i = 0; i < toFind.size(); i += kBatch) {
+        auto keys = folly::range(toFind).subpiece(i, kBatch);
+        if constexpr (std::is_same_v<Map<K, V>, std::unordered_map<K, V>>) {
+          for (size_t j = 0; j < keys.size(); ++j) {
+            use(j, map.find(keys[j]));
+          }
+        } else {
+          map.bulkFind(keys, use);
+        }
+        folly::doNotOptimizeAway(x);
+      }
+    }
+  });
+}
+
 template <template <class, class> class Map, class K, class V>
 void benchmarkManyFind(int runs, int size) {
   int x = 0;
@@ -412,6 +459,7 @@ void runAllHashMapTests() {
   X(InsertSqBr);
   X(InsertGrow);
   X(Find);
+  X(BulkFind);
   X(ManyFind);
   X(SqBrFind);
   X(Erase);
@@ -37,12 +37,14 @@ template <typename T>
 void checkTransparent() {
   static_assert(is_transparent_v<HeterogeneousAccessEqualTo<T>>, "");
   static_assert(is_transparent_v<HeterogeneousAccessHash<T>>, "");
+  static_assert(is_transparent_v<HeterogeneousAccessLess<T>>, "");
 }
 
 template <typename T>
 void checkNotTransparent() {
   static_assert(!is_transparent_v<HeterogeneousAccessEqualTo<T>>, "");
   static_assert(!is_transparent_v<HeterogeneousAccessHash<T>>, "");
+  static_assert(!is_transparent_v<HeterogeneousAccessLess<T>>, "");
 }
 
 struct StringVector {
@@ -142,6 +144,7 @@ void runTestMatches2(S src) {
 
   HeterogeneousAccessEqualTo<L> equalTo;
   HeterogeneousAccessHash<L> hash;
+  HeterogeneousAccessLess<L> less;
 
   EXPECT_TRUE(equalTo(lhs1, rhs1));
   EXPECT_FALSE(equalTo(lhs1, rhs2));
@@ -153,6 +156,11 @@ void runTestMatches2(S src) {
   EXPECT_NE(hash(lhs2), hash(rhs1)); // technically only low probability
   EXPECT_EQ(hash(lhs2), hash(rhs2));
 
+  EXPECT_FALSE(less(lhs1, rhs1));
+  EXPECT_FALSE(less(lhs1, rhs2));
+  EXPECT_TRUE(less(lhs2, rhs1));
+  EXPECT_FALSE(less(lhs2, rhs2));
+
   auto v0 = smaller[0];
   std::array<decltype(v0), 1> a{{v0}};
   EXPECT_FALSE(equalTo(a, lhs1));
@@ -222,6 +230,27 @@ TEST(HeterogeneousAccess, transparentMatches) {
   runTestMatches<small_vector<int, 2>>({1, 2, 3, 4});
 }
 
+TEST(HeterogeneousAccess, lessMatchesStdLess) {
+  std::vector<std::string> strs{"", "a", "ab", "b", "\x7f", "\x80", "\xff"};
+  HeterogeneousAccessLess<std::string> less;
+  for (auto const& a : strs) {
+    for (auto const& b : strs) {
+      bool expected = std::less<std::string>{}(a, b);
+      EXPECT_EQ(expected, less(a, b));
+      EXPECT_EQ(expected, less(StringPiece{a}, b));
+      EXPECT_EQ(expected, less(a, std::string_view{b}));
+    }
+  }
+
+  std::vector<std::vector<int>> vecs{{}, {-1}, {-1, 2}, {0}, {1}};
+  HeterogeneousAccessLess<std::vector<int>> vecLess;
+  for (auto const& a : vecs) {
+    for (auto const& b : vecs) {
+      EXPECT_EQ(a < b, vecLess(a, Range<int const*>{b}));
+    }
+  }
+}
+
 TEST(HeterogeneousAccess, Stress) {
   constexpr std::size_t kMinLen = 1;
   constexpr std::size_t kMaxLen = 2048;
@@ -21,6 +21,7 @@
 #include <random>
 #include <string>
 #include <string_view>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/ranges.h>
@@ -37,6 +38,7 @@
 
 using namespace std::literals;
 
+using folly::ConcurrentRegexMatchCache;
 using folly::RegexMatchCache;
 using folly::RegexMatchCacheDynamicBitset;
 using folly::RegexMatchCacheKey;
@@ -636,3 +638,203 @@ TEST_F(RegexMatchCacheTest, combinatorics) {
     }
   }
 }
+
+struct ConcurrentRegexMatchCacheTest : testing::Test {
+  using clock = ConcurrentRegexMatchCache::clock;
+  using time_point = ConcurrentRegexMatchCache::time_point;
+  using string_pointer = ConcurrentRegexMatchCache::string_pointer;
+
+  static auto lookup(
+      ConcurrentRegexMatchCache& cache,
+      std::string_view const regex,
+      time_point const now) {
+    return cache.findMatches(RegexMatchCacheKeyAndView(regex), now);
+  }
+};
+
+TEST_F(ConcurrentRegexMatchCacheTest, clean_lookup) {
+  ConcurrentRegexMatchCache cache;
+  auto const key = RegexMatchCacheKey("foo|bar");
+  EXPECT_FALSE(cache.hasRegex(key));
+  EXPECT_EQ(std::nullopt, cache.findMatchesIfCached(key, time_point()));
+
+  EXPECT_THAT(
+      lookup(cache, "foo|bar", time_point() + 5s), //
+      testing::UnorderedElementsAre());
+  EXPECT_TRUE(cache.hasRegex(key));
+  EXPECT_THAT(
+      cache.findMatchesIfCached(key, time_point()),
+      testing::Optional(testing::UnorderedElementsAre()));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, add_strings_lookup) {
+  auto const foo = "foo"s;
+  auto const bar = "bar"s;
+  ConcurrentRegexMatchCache cache;
+
+  cache.addString(&foo);
+  cache.addString(&bar);
+  EXPECT_TRUE(cache.hasString(&foo));
+  EXPECT_THAT(cache.getStringList(), testing::UnorderedElementsAre(&foo, &bar));
+
+  EXPECT_THAT(
+      lookup(cache, "foo|qux", time_point() + 5s), //
+      testing::UnorderedElementsAre(&foo));
+  EXPECT_THAT(
+      cache.findMatchesIfCached(RegexMatchCacheKey("foo|qux"), time_point()),
+      testing::Optional(testing::UnorderedElementsAre(&foo)));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, add_strings_updates_cached_regexes) {
+  auto const foo = "foo"s;
+  auto const bar = "bar"s;
+  auto const cat = "cat"s;
+  auto const dog = "dog"s;
+  ConcurrentRegexMatchCache cache;
+
+  cache.addString(&foo);
+  EXPECT_THAT(
+      lookup(cache, "foo|dog", time_point()), //
+      testing::UnorderedElementsAre(&foo));
+  EXPECT_THAT(
+      lookup(cache, "bar|cat", time_point()), //
+      testing::UnorderedElementsAre());
+
+  std::vector<string_pointer> const batch{&bar, &cat, &dog, &foo};
+  cache.addStrings(batch);
+  EXPECT_THAT(
+      cache.findMatchesIfCached(RegexMatchCacheKey("foo|dog"), time_point()),
+      testing::Optional(testing::UnorderedElementsAre(&foo, &dog)));
+  EXPECT_THAT(
+      cache.findMatchesIfCached(RegexMatchCacheKey("bar|cat"), time_point()),
+      testing::Optional(testing::UnorderedElementsAre(&bar, &cat)));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, erase_string) {
+  auto const foo = "foo"s;
+  auto const bar = "bar"s;
+  ConcurrentRegexMatchCache cache;
+
+  cache.addString(&foo);
+  cache.addString(&bar);
+  EXPECT_THAT(
+      lookup(cache, "foo|bar", time_point()), //
+      testing::UnorderedElementsAre(&foo, &bar));
+
+  cache.eraseString(&foo);
+  EXPECT_FALSE(cache.hasString(&foo));
+  EXPECT_THAT(
+      lookup(cache, "foo|bar", time_point()), //
+      testing::UnorderedElementsAre(&bar));
+
+  cache.addString(&foo);
+  EXPECT_THAT(
+      lookup(cache, "foo|bar", time_point()), //
+      testing::UnorderedElementsAre(&foo, &bar));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, erase_regex_and_purge) {
+  auto const foo = "foo"s;
+  auto const a = RegexMatchCacheKey("foo");
+  auto const b = RegexMatchCacheKey("bar");
+  ConcurrentRegexMatchCache cache;
+  cache.addString(&foo);
+
+  lookup(cache, "foo", time_point() + 1s);
+  lookup(cache, "bar", time_point() + 3s);
+  EXPECT_TRUE(cache.hasRegex(a));
+  EXPECT_TRUE(cache.hasRegex(b));
+
+  cache.eraseRegex(a);
+  EXPECT_FALSE(cache.hasRegex(a));
+  EXPECT_TRUE(cache.hasRegex(b));
+
+  lookup(cache, "foo", time_point() + 1s);
+  cache.findMatchesIfCached(b, time_point() + 5s);
+  EXPECT_FALSE(cache.hasItemsToPurge(time_point()));
+  EXPECT_TRUE(cache.hasItemsToPurge(time_point() + 2s));
+  cache.purge(time_point() + 2s);
+  EXPECT_FALSE(cache.hasRegex(a));
+  EXPECT_TRUE(cache.hasRegex(b));
+  EXPECT_FALSE(cache.hasItemsToPurge(time_point() + 2s));
+  EXPECT_TRUE(cache.hasString(&foo));
+
+  cache.clear();
+  EXPECT_FALSE(cache.hasRegex(b));
+  EXPECT_FALSE(cache.hasString(&foo));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, invalid_regex) {
+  auto const foo = "foo"s;
+  ConcurrentRegexMatchCache cache;
+  cache.addString(&foo);
+  lookup(cache, "foo", time_point());
+
+  EXPECT_ANY_THROW(lookup(cache, "foo(", time_point()));
+  EXPECT_FALSE(cache.hasRegex(RegexMatchCacheKey("foo(")));
+  EXPECT_TRUE(cache.hasRegex(RegexMatchCacheKey("foo")));
+  EXPECT_TRUE(cache.hasString(&foo));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, concurrent) {
+  constexpr size_t nreaders = 4;
+  constexpr size_t nregexes = 16;
+  constexpr size_t rounds = folly::kIsSanitize ? 64 : 512;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < nregexes * 2; ++i) {
+    strings.push_back(fmt::format("s{}", i));
+  }
+  std::vector<std::string> regexes;
+  for (size_t i = 0; i < nregexes; ++i) {
+    regexes.push_back(fmt::format("s{}|s{}", i, i + nregexes));
+  }
+  ConcurrentRegexMatchCache cache;
+
+  //  readers check that every result, cached or not, is a subset of the two
+  //  strings which the regex can match
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < nreaders; ++t) {
+    readers.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      while (!done.load(std::memory_order_relaxed)) {
+        auto const i = rng() % nregexes;
+        auto const matches = lookup(cache, regexes[i], time_point());
+        for (auto const match : matches) {
+          EXPECT_TRUE(match == &strings[i] || match == &strings[i + nregexes]);
+        }
+      }
+    });
+  }
+
+  std::mt19937 rng;
+  for (size_t r = 0; r < rounds; ++r) {
+    auto const string = &strings[rng() % strings.size()];
+    if (rng() % 2) {
+      cache.addString(string);
+    } else {
+      cache.eraseString(string);
+    }
+    if (rng() % 16 == 0) {
+      cache.eraseRegex(RegexMatchCacheKey(regexes[rng() % nregexes]));
+    }
+    std::this_thread::yield();
+  }
+  done.store(true, std::memory_order_relaxed);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  //  once quiescent, every result must be exact
+  for (size_t i = 0; i < nregexes; ++i) {
+    std::vector<string_pointer> expected;
+    for (auto const string : {&strings[i], &strings[i + nregexes]}) {
+      if (cache.hasString(string)) {
+        expected.push_back(string);
+      }
+    }
+    EXPECT_THAT(
+        lookup(cache, regexes[i], time_point()),
+        testing::UnorderedElementsAreArray(expected));
+  }
+}
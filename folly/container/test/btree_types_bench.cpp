@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/btree_types.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/container/heap_vector_types.h>
+#include <folly/init/Init.h>
+#include <folly/sorted_vector_types.h>
+
+namespace {
+
+using Key = std::uint64_t;
+using BTreeMap = folly::btree_map<Key, Key>;
+using StdMap = std::map<Key, Key>;
+using SortedVectorMap = folly::sorted_vector_map<Key, Key>;
+using HeapVectorMap = folly::heap_vector_map<Key, Key>;
+
+std::vector<Key> randomKeys(std::size_t n, unsigned seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<Key> keys(n);
+  for (auto& k : keys) {
+    k = rng();
+  }
+  return keys;
+}
+
+template <typename Map>
+Map const& filledMap(std::size_t n) {
+  static std::map<std::size_t, Map> maps;
+  auto it = maps.find(n);
+  if (it == maps.end()) {
+    auto keys = randomKeys(n, 1);
+    std::vector<std::pair<Key, Key>> sorted;
+    sorted.reserve(n);
+    for (auto k : keys) {
+      sorted.emplace_back(k, k);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    it = maps.emplace(n, Map(sorted.begin(), sorted.end())).first;
+  }
+  return it->second;
+}
+
+// Random hits, looked up in an order unrelated to the key order.
+template <typename Map>
+void find(std::size_t iters, std::size_t n) {
+  std::vector<Key> keys;
+  BENCHMARK_SUSPEND {
+    filledMap<Map>(n);
+    keys = randomKeys(n, 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(2));
+  }
+  auto const& map = filledMap<Map>(n);
+  Key sum = 0;
+  for (std::size_t i = 0; i < iters; ++i) {
+    sum += map.find(keys[i % n])->second;
+  }
+  folly::doNotOptimizeAway(sum);
+}
+
+// Grows a map to n random keys, one insert per iteration.
+template <typename Map>
+void insert(std::size_t iters, std::size_t n) {
+  std::vector<Key> keys;
+  Map map;
+  BENCHMARK_SUSPEND {
+    keys = randomKeys(n, 3);
+  }
+  for (std::size_t i = 0; i < iters; ++i) {
+    if (i % n == 0 && i > 0) {
+      BENCHMARK_SUSPEND {
+        map = Map();
+      }
+    }
+    map.emplace(keys[i % n], i);
+  }
+  folly::doNotOptimizeAway(map.size());
+}
+
+// Erases a random key and inserts a new one, keeping n keys.
+template <typename Map>
+void update(std::size_t iters, std::size_t n) {
+  Map map;
+  std::vector<Key> keys;
+  BENCHMARK_SUSPEND {
+    map = filledMap<Map>(n);
+    keys = randomKeys(n, 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(4));
+  }
+  std::mt19937_64 rng(5);
+  for (std::size_t i = 0; i < iters; ++i) {
+    auto& k = keys[i % n];
+    map.erase(k);
+    k = rng();
+    map.emplace(k, k);
+  }
+  folly::doNotOptimizeAway(map.size());
+}
+
+template <typename Map>
+void iterate(std::size_t iters, std::size_t n) {
+  BENCHMARK_SUSPEND {
+    filledMap<Map>(n);
+  }
+  auto const& map = filledMap<Map>(n);
+  Key sum = 0;
+  std::size_t i = 0;
+  while (i < iters) {
+    for (auto const& kv : map) {
+      sum += kv.second;
+      if (++i == iters) {
+        break;
+      }
+    }
+  }
+  folly::doNotOptimizeAway(sum);
+}
+
+template <typename Map, typename Build>
+unsigned buildSorted(std::size_t n, Build build) {
+  std::vector<std::pair<Key, Key>> sorted;
+  BENCHMARK_SUSPEND {
+    for (std::size_t i = 0; i < n; ++i) {
+      sorted.emplace_back(i * 2, i);
+    }
+  }
+  Map map = build(sorted);
+  folly::doNotOptimizeAway(map.size());
+  BENCHMARK_SUSPEND {
+    map = Map();
+  }
+  return static_cast<unsigned>(n);
+}
+
+} // namespace
+
+#define MAP_BENCHMARKS(op, n)                     \
+  BENCHMARK(op##_std_map_##n, iters) {            \
+    op<StdMap>(iters, n);                         \
+  }                                               \
+  BENCHMARK_RELATIVE(op##_btree_map_##n, iters) { \
+    op<BTreeMap>(iters, n);                       \
+  }
+
+#define VECTOR_BENCHMARKS(op, n)                          \
+  BENCHMARK_RELATIVE(op##_sorted_vector_map_##n, iters) { \
+    op<SortedVectorMap>(iters, n);                        \
+  }                                                       \
+  BENCHMARK_RELATIVE(op##_heap_vector_map_##n, iters) {   \
+    op<HeapVectorMap>(iters, n);                          \
+  }
+
+MAP_BENCHMARKS(find, 1000)
+VECTOR_BENCHMARKS(find, 1000)
+BENCHMARK_DRAW_LINE();
+MAP_BENCHMARKS(find, 1000000)
+VECTOR_BENCHMARKS(find, 1000000)
+BENCHMARK_DRAW_LINE();
+MAP_BENCHMARKS(insert, 10000)
+VECTOR_BENCHMARKS(insert, 10000)
+BENCHMARK_DRAW_LINE();
+MAP_BENCHMARKS(insert, 1000000)
+BENCHMARK_DRAW_LINE();
+MAP_BENCHMARKS(update, 1000000)
+VECTOR_BENCHMARKS(update, 1000000)
+BENCHMARK_DRAW_LINE();
+MAP_BENCHMARKS(iterate, 1000000)
+VECTOR_BENCHMARKS(iterate, 1000000)
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_MULTI(build_sorted_std_map_1000000) {
+  return buildSorted<StdMap>(1000000, [](auto const& sorted) {
+    StdMap map;
+    for (auto const& kv : sorted) {
+      map.emplace_hint(map.end(), kv);
+    }
+    return map;
+  });
+}
+
+BENCHMARK_RELATIVE_MULTI(build_sorted_btree_map_1000000) {
+  return buildSorted<BTreeMap>(1000000, [](auto const& sorted) {
+    return BTreeMap(folly::sorted_unique, sorted.begin(), sorted.end());
+  });
+}
+
+BENCHMARK_RELATIVE_MULTI(build_sorted_sorted_vector_map_1000000) {
+  return buildSorted<SortedVectorMap>(1000000, [](auto const& sorted) {
+    return SortedVectorMap(
+        folly::sorted_unique, std::vector<std::pair<Key, Key>>(sorted));
+  });
+}
+
+int main(int argc, char** argv) {
+  folly::Init init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
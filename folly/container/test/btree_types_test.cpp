@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/btree_types.h>
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/Range.h>
+#include <folly/portability/GTest.h>
+
+using folly::btree_map;
+using folly::btree_set;
+
+namespace {
+
+// Large enough that a leaf holds only a few of them, so that small tests
+// reach splits and merges several levels deep.
+struct FatKey {
+  /* implicit */ FatKey(int v = 0) : value(v) {}
+  bool operator<(FatKey const& other) const { return value < other.value; }
+  bool operator==(FatKey const& other) const { return value == other.value; }
+
+  int value;
+  char padding[120]{};
+};
+
+int liveCount = 0;
+
+struct Counted {
+  /* implicit */ Counted(int v = 0) : value(v) { ++liveCount; }
+  Counted(Counted const& other) : value(other.value) { ++liveCount; }
+  Counted(Counted&& other) noexcept : value(other.value) { ++liveCount; }
+  Counted& operator=(Counted const&) = default;
+  Counted& operator=(Counted&&) = default;
+  ~Counted() { --liveCount; }
+  bool operator<(Counted const& other) const { return value < other.value; }
+
+  int value;
+};
+
+template <typename Key>
+Key makeKey(std::int64_t i) {
+  if constexpr (std::is_same<Key, std::string>::value) {
+    return folly::to<std::string>("key", i);
+  } else if constexpr (std::is_same<Key, FatKey>::value) {
+    return FatKey(static_cast<int>(i));
+  } else {
+    return static_cast<Key>(i);
+  }
+}
+
+template <typename Container, typename Reference>
+void expectSame(Container const& c, Reference const& ref) {
+  ASSERT_EQ(ref.size(), c.size());
+  ASSERT_EQ(ref.empty(), c.empty());
+  auto it = c.begin();
+  for (auto const& v : ref) {
+    ASSERT_TRUE(it != c.end());
+    EXPECT_TRUE(*it == v);
+    ++it;
+  }
+  EXPECT_TRUE(it == c.end());
+  auto rit = c.rbegin();
+  for (auto v = ref.rbegin(); v != ref.rend(); ++v, ++rit) {
+    ASSERT_TRUE(rit != c.rend());
+    EXPECT_TRUE(*rit == *v);
+  }
+  EXPECT_TRUE(rit == c.rend());
+}
+
+template <typename Key>
+void randomOps(std::int64_t range, int steps) {
+  std::mt19937 rng(static_cast<unsigned>(range));
+  std::uniform_int_distribution<std::int64_t> dist(-range, range);
+  btree_map<Key, int> map;
+  std::map<Key, int> ref;
+  for (int step = 0; step < steps; ++step) {
+    auto key = makeKey<Key>(dist(rng));
+    switch (rng() % 8) {
+      case 0:
+      case 1:
+      case 2: {
+        auto a = map.insert({key, step});
+        auto b = ref.insert({key, step});
+        ASSERT_EQ(b.second, a.second);
+        ASSERT_TRUE(a.first->first == key);
+        ASSERT_EQ(b.first->second, a.first->second);
+        break;
+      }
+      case 3: {
+        map[key] = step;
+        ref[key] = step;
+        break;
+      }
+      case 4:
+      case 5: {
+        ASSERT_EQ(ref.erase(key), map.erase(key));
+        break;
+      }
+      case 6: {
+        auto a = map.lower_bound(key);
+        auto b = ref.lower_bound(key);
+        if (b == ref.end()) {
+          ASSERT_TRUE(a == map.end());
+        } else {
+          ASSERT_TRUE(a != map.end());
+          ASSERT_TRUE(a->first == b->first);
+          auto next = map.erase(a);
+          b = ref.erase(b);
+          if (b == ref.end()) {
+            ASSERT_TRUE(next == map.end());
+          } else {
+            ASSERT_TRUE(next->first == b->first);
+          }
+        }
+        break;
+      }
+      case 7: {
+        auto a = map.upper_bound(key);
+        auto b = ref.upper_bound(key);
+        ASSERT_EQ(
+            std::distance(ref.begin(), b), std::distance(map.begin(), a));
+        ASSERT_EQ(ref.count(key), map.count(key));
+        auto f = map.find(key);
+        ASSERT_EQ(ref.count(key) != 0, f != map.end());
+        break;
+      }
+    }
+    ASSERT_EQ(ref.size(), map.size());
+  }
+  expectSame(map, std::vector<std::pair<Key, int>>(ref.begin(), ref.end()));
+  while (!ref.empty()) {
+    auto key = ref.begin()->first;
+    ref.erase(ref.begin());
+    ASSERT_EQ(1, map.erase(key));
+  }
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
+} // namespace
+
+TEST(BTree, Set) {
+  btree_set<int> s;
+  EXPECT_TRUE(s.empty());
+  EXPECT_TRUE(s.begin() == s.end());
+  EXPECT_TRUE(s.find(1) == s.end());
+  EXPECT_TRUE(s.lower_bound(1) == s.end());
+
+  for (int i = 999; i >= 0; --i) {
+    EXPECT_TRUE(s.insert(i * 2).second);
+  }
+  EXPECT_FALSE(s.insert(10).second);
+  EXPECT_EQ(1000, s.size());
+  EXPECT_EQ(0, *s.begin());
+  EXPECT_EQ(1998, *s.rbegin());
+  EXPECT_EQ(1, s.count(4));
+  EXPECT_EQ(0, s.count(5));
+  EXPECT_TRUE(s.contains(6));
+  EXPECT_EQ(6, *s.lower_bound(5));
+  EXPECT_EQ(6, *s.lower_bound(6));
+  EXPECT_EQ(8, *s.upper_bound(6));
+  EXPECT_TRUE(s.upper_bound(1998) == s.end());
+  auto range = s.equal_range(6);
+  EXPECT_EQ(6, *range.first);
+  EXPECT_EQ(8, *range.second);
+  range = s.equal_range(7);
+  EXPECT_TRUE(range.first == range.second);
+
+  int expected = 0;
+  for (int v : s) {
+    EXPECT_EQ(expected, v);
+    expected += 2;
+  }
+
+  auto it = s.erase(s.find(100));
+  EXPECT_EQ(102, *it);
+  EXPECT_EQ(0, s.erase(100));
+  it = s.erase(s.find(200), s.find(300));
+  EXPECT_EQ(300, *it);
+  EXPECT_EQ(1000 - 1 - 50, s.size());
+  EXPECT_TRUE(s.find(250) == s.end());
+
+  s.clear();
+  EXPECT_TRUE(s.empty());
+  s.insert({3, 1, 2, 3});
+  expectSame(s, std::vector<int>{1, 2, 3});
+}
+
+TEST(BTree, Map) {
+  btree_map<std::string, int> m;
+  m["b"] = 2;
+  EXPECT_TRUE(m.try_emplace("a", 1).second);
+  EXPECT_FALSE(m.try_emplace("a", 5).second);
+  EXPECT_EQ(1, m.at("a"));
+  EXPECT_FALSE(m.insert_or_assign("a", 10).second);
+  EXPECT_EQ(10, m.at("a"));
+  EXPECT_TRUE(m.insert(std::make_pair("c", 3)).second);
+  EXPECT_TRUE(m.emplace("d", 4).second);
+  EXPECT_THROW(m.at("e"), std::out_of_range);
+  std::vector<std::pair<std::string, int>> expected{
+      {"a", 10}, {"b", 2}, {"c", 3}, {"d", 4}};
+  expectSame(m, expected);
+
+  btree_map<int, std::unique_ptr<int>> owners;
+  for (int i = 0; i < 500; ++i) {
+    owners.try_emplace(i, std::make_unique<int>(i));
+  }
+  for (int i = 0; i < 500; i += 3) {
+    owners.erase(i);
+  }
+  for (auto& [k, v] : owners) {
+    EXPECT_EQ(k, *v);
+  }
+}
+
+TEST(BTree, HeterogeneousLookup) {
+  btree_map<std::string, int> m;
+  for (int i = 0; i < 1000; ++i) {
+    m[folly::to<std::string>(i)] = i;
+  }
+  EXPECT_EQ(42, m.find(std::string_view("42"))->second);
+  EXPECT_EQ(42, m.find(folly::StringPiece("42"))->second);
+  EXPECT_TRUE(m.contains("999"));
+  EXPECT_FALSE(m.contains(std::string_view("1000")));
+  EXPECT_EQ("11", m.lower_bound(folly::StringPiece("10a"))->first);
+  EXPECT_EQ(1, m.erase(std::string_view("500")));
+  EXPECT_EQ(999, m.size());
+
+  btree_set<std::int64_t, std::less<>> s{1, 5, 9};
+  EXPECT_EQ(5, *s.lower_bound(4));
+  EXPECT_EQ(1, s.count(9));
+}
+
+TEST(BTree, RandomOps) {
+  randomOps<std::int64_t>(1000, 30000);
+  randomOps<std::int32_t>(100000, 30000);
+  randomOps<std::uint32_t>(100000, 30000);
+  randomOps<std::string>(1000, 20000);
+  randomOps<FatKey>(300, 20000);
+  randomOps<double>(1000, 10000);
+}
+
+TEST(BTree, UnsignedExtremes) {
+  // The SIMD search compares as signed and biases unsigned keys.
+  btree_set<std::uint64_t> s;
+  std::set<std::uint64_t> ref;
+  std::uint64_t const top = std::numeric_limits<std::uint64_t>::max();
+  for (std::uint64_t i = 0; i < 2000; ++i) {
+    for (auto v : {i, top - i, (top >> 1) + i, (top >> 1) - i}) {
+      s.insert(v);
+      ref.insert(v);
+    }
+  }
+  expectSame(s, ref);
+  for (auto v : ref) {
+    ASSERT_TRUE(s.find(v) != s.end());
+    ASSERT_EQ(v, *s.lower_bound(v));
+  }
+  EXPECT_TRUE(s.find(5000) == s.end());
+}
+
+TEST(BTree, SortedUniqueConstruction) {
+  for (int n : {0, 1, 2, 15, 16, 17, 100, 1000, 12345}) {
+    std::vector<std::pair<int, int>> sorted;
+    for (int i = 0; i < n; ++i) {
+      sorted.emplace_back(i * 3, i);
+    }
+    btree_map<int, int> m(folly::sorted_unique, sorted.begin(), sorted.end());
+    expectSame(m, sorted);
+    for (int i = 0; i < n; ++i) {
+      ASSERT_EQ(i, m.at(i * 3));
+    }
+    // Updates after a packed build split the full nodes.
+    for (int i = 0; i < n; ++i) {
+      m[i * 3 + 1] = -i;
+    }
+    EXPECT_EQ(2 * n, m.size());
+    for (int i = 0; i < n; i += 2) {
+      m.erase(i * 3);
+    }
+    EXPECT_EQ(2 * n - (n + 1) / 2, m.size());
+  }
+
+  btree_set<FatKey> fat(
+      folly::sorted_unique, {FatKey(1), FatKey(2), FatKey(3), FatKey(4)});
+  EXPECT_EQ(4, fat.size());
+  EXPECT_EQ(4, fat.rbegin()->value);
+}
+
+TEST(BTree, BulkInsert) {
+  btree_map<int, int> m;
+  for (int i = 0; i < 1000; i += 2) {
+    m[i] = 0;
+  }
+  // Mostly new keys: merged and rebuilt.
+  std::vector<std::pair<int, int>> sorted;
+  for (int i = 0; i < 1000; ++i) {
+    sorted.emplace_back(i, 1);
+  }
+  m.insert(folly::sorted_unique, sorted.begin(), sorted.end());
+  EXPECT_EQ(1000, m.size());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i % 2, m[i]) << i;
+  }
+
+  // A few keys: inserted one by one.
+  std::vector<std::pair<int, int>> few{{-1, 1}, {2000, 1}};
+  m.insert(folly::sorted_unique, few.begin(), few.end());
+  EXPECT_EQ(1002, m.size());
+  EXPECT_EQ(-1, m.begin()->first);
+
+  // Unsorted with duplicates: the first occurrence wins, as for std::map.
+  btree_map<int, int> u;
+  u[5] = 0;
+  std::vector<std::pair<int, int>> unsorted{{3, 1}, {5, 1}, {1, 1}, {3, 2}};
+  u.insert(unsorted.begin(), unsorted.end());
+  std::vector<std::pair<int, int>> expected{{1, 1}, {3, 1}, {5, 0}};
+  expectSame(u, expected);
+}
+
+TEST(BTree, HintedAppend) {
+  btree_set<int> s;
+  for (int i = 0; i < 10000; ++i) {
+    s.insert(s.end(), i);
+  }
+  s.insert(s.end(), -1);
+  EXPECT_EQ(10001, s.size());
+  EXPECT_EQ(-1, *s.begin());
+  EXPECT_EQ(9999, *s.rbegin());
+}
+
+TEST(BTree, CopyMoveCompare) {
+  btree_map<int, std::string> a;
+  for (int i = 0; i < 3000; ++i) {
+    a[i] = folly::to<std::string>(i);
+  }
+  auto b = a;
+  EXPECT_TRUE(a == b);
+  b[3000] = "x";
+  EXPECT_TRUE(a != b);
+  EXPECT_TRUE(a < b);
+  auto c = std::move(b);
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(3001, c.size());
+  b = c;
+  EXPECT_TRUE(b == c);
+  a.swap(c);
+  EXPECT_EQ(3001, a.size());
+  EXPECT_EQ(3000, c.size());
+  c = std::move(a);
+  EXPECT_EQ(3001, c.size());
+}
+
+TEST(BTree, NoLeaks) {
+  {
+    btree_map<Counted, Counted> m;
+    for (int i = 0; i < 5000; ++i) {
+      m.try_emplace(Counted((i * 37) % 5003), i);
+    }
+    for (int i = 0; i < 5000; i += 3) {
+      m.erase(Counted((i * 37) % 5003));
+    }
+    auto copy = m;
+    std::vector<std::pair<Counted, Counted>> sorted;
+    for (int i = 0; i < 100; ++i) {
+      sorted.emplace_back(Counted(10000 + i), Counted(i));
+    }
+    copy.insert(folly::sorted_unique, sorted.begin(), sorted.end());
+    EXPECT_EQ(m.size() + 100, copy.size());
+  }
+  EXPECT_EQ(0, liveCount);
+}
+
+namespace {
+
+int throwCountdown = -1;
+
+struct ThrowingValue {
+  /* implicit */ ThrowingValue(int v) : value(v) {
+    if (throwCountdown >= 0 && throwCountdown-- == 0) {
+      throw std::runtime_error("ThrowingValue");
+    }
+  }
+  ThrowingValue(ThrowingValue const& other) : ThrowingValue(other.value) {}
+  ThrowingValue(ThrowingValue&& other) noexcept : value(other.value) {}
+  ThrowingValue& operator=(ThrowingValue const&) = default;
+  ThrowingValue& operator=(ThrowingValue&&) = default;
+
+  int value;
+};
+
+} // namespace
+
+TEST(BTree, InsertIsStronglyExceptionSafe) {
+  btree_map<int, ThrowingValue> m;
+  std::map<int, int> ref;
+  std::mt19937 rng(1);
+  for (int i = 0; i < 5000; ++i) {
+    int key = static_cast<int>(rng() % 10000);
+    throwCountdown = i % 4 == 0 ? 0 : -1;
+    try {
+      m.try_emplace(key, i);
+      ref.emplace(key, i);
+    } catch (std::runtime_error const&) {
+      EXPECT_EQ(0, i % 4);
+    }
+    ASSERT_EQ(ref.size(), m.size());
+  }
+  throwCountdown = -1;
+  auto it = m.begin();
+  for (auto const& [k, v] : ref) {
+    ASSERT_EQ(k, it->first);
+    ASSERT_EQ(v, it->second.value);
+    ++it;
+  }
+}
+
+TEST(BTree, BuildCleansUpOnThrow) {
+  std::vector<std::pair<int, ThrowingValue>> sorted;
+  for (int i = 0; i < 1000; ++i) {
+    sorted.emplace_back(i, i);
+  }
+  throwCountdown = 500;
+  EXPECT_THROW(
+      (btree_map<int, ThrowingValue>(
+          folly::sorted_unique, sorted.begin(), sorted.end())),
+      std::runtime_error);
+  throwCountdown = -1;
+}
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/columnar_tape.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+namespace {
+
+struct Record {
+  std::string name;
+  std::int64_t id;
+  std::string email;
+  std::int32_t score;
+};
+
+using RecordTuple =
+    std::tuple<std::string, std::int64_t, std::string, std::int32_t>;
+using vec_struct = std::vector<Record>;
+using col_tape =
+    folly::columnar_tape<std::string, std::int64_t, std::string, std::int32_t>;
+
+constexpr std::size_t kRows = 100'000;
+
+std::string randomString(
+    std::mt19937& g, std::size_t minLen, std::size_t maxLen) {
+  std::uniform_int_distribution<std::size_t> len(minLen, maxLen);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::string s(len(g), ' ');
+  for (auto& c : s) {
+    c = static_cast<char>(letter(g));
+  }
+  return s;
+}
+
+// names mostly fit in the SSO buffer, emails mostly do not
+const std::vector<RecordTuple>& inputRows() {
+  static const std::vector<RecordTuple> res = [] {
+    std::mt19937 g{kRows};
+    std::vector<RecordTuple> r;
+    r.reserve(kRows);
+    for (std::size_t i = 0; i != kRows; ++i) {
+      r.emplace_back(
+          randomString(g, 4, 20),
+          static_cast<std::int64_t>(g()),
+          randomString(g, 12, 40),
+          static_cast<std::int32_t>(g() % 1000));
+    }
+    return r;
+  }();
+  return res;
+}
+
+const std::vector<std::size_t>& shuffledIndexes() {
+  static const std::vector<std::size_t> res = [] {
+    std::vector<std::size_t> r(kRows);
+    for (std::size_t i = 0; i != kRows; ++i) {
+      r[i] = i;
+    }
+    std::shuffle(r.begin(), r.end(), std::mt19937{1});
+    return r;
+  }();
+  return res;
+}
+
+void pushBack(vec_struct& c, const RecordTuple& r) {
+  const auto& [name, id, email, score] = r;
+  c.push_back(Record{name, id, email, score});
+}
+
+void pushBack(col_tape& c, const RecordTuple& r) {
+  const auto& [name, id, email, score] = r;
+  c.push_back(name, id, email, score);
+}
+
+void bulkAppend(vec_struct& c, const std::vector<RecordTuple>& rows) {
+  c.reserve(c.size() + rows.size());
+  for (const auto& r : rows) {
+    pushBack(c, r);
+  }
+}
+
+void bulkAppend(col_tape& c, const std::vector<RecordTuple>& rows) {
+  c.append(rows.begin(), rows.end());
+}
+
+template <typename Container>
+const Container& filled() {
+  static const Container res = [] {
+    Container c;
+    bulkAppend(c, inputRows());
+    return c;
+  }();
+  return res;
+}
+
+template <typename Container>
+void pushBackRows(std::size_t iters) {
+  const auto& rows = inputRows();
+  while (iters--) {
+    Container c;
+    for (const auto& r : rows) {
+      pushBack(c, r);
+    }
+    folly::doNotOptimizeAway(c);
+  }
+}
+
+template <typename Container>
+void bulkAppendRows(std::size_t iters) {
+  const auto& rows = inputRows();
+  while (iters--) {
+    Container c;
+    bulkAppend(c, rows);
+    folly::doNotOptimizeAway(c);
+  }
+}
+
+template <typename Container>
+void copy(std::size_t iters) {
+  const auto& c = filled<Container>();
+  while (iters--) {
+    Container copy = c;
+    folly::doNotOptimizeAway(copy);
+  }
+}
+
+// a scan of one fixed-width field
+std::int64_t sumScores(const vec_struct& c) {
+  std::int64_t sum = 0;
+  for (const auto& r : c) {
+    sum += r.score;
+  }
+  return sum;
+}
+
+std::int64_t sumScores(const col_tape& c) {
+  std::int64_t sum = 0;
+  for (auto score : c.column<3>()) {
+    sum += score;
+  }
+  return sum;
+}
+
+// a scan of one variable-width field
+std::size_t countEmailsStartingWithA(const vec_struct& c) {
+  std::size_t n = 0;
+  for (const auto& r : c) {
+    n += !r.email.empty() && r.email[0] == 'a';
+  }
+  return n;
+}
+
+std::size_t countEmailsStartingWithA(const col_tape& c) {
+  std::size_t n = 0;
+  for (auto email : c.column<2>()) {
+    n += !email.empty() && email[0] == 'a';
+  }
+  return n;
+}
+
+// whole records, in random order
+std::size_t readRecord(const vec_struct& c, std::size_t i) {
+  const auto& r = c[i];
+  return r.name.size() + static_cast<std::size_t>(r.id) + r.email.size() +
+      static_cast<std::size_t>(r.score);
+}
+
+std::size_t readRecord(const col_tape& c, std::size_t i) {
+  auto [name, id, email, score] = c[i];
+  return name.size() + static_cast<std::size_t>(id) + email.size() +
+      static_cast<std::size_t>(score);
+}
+
+template <typename Container>
+void scanInts(std::size_t iters) {
+  const auto& c = filled<Container>();
+  while (iters--) {
+    folly::doNotOptimizeAway(sumScores(c));
+  }
+}
+
+template <typename Container>
+void scanStrings(std::size_t iters) {
+  const auto& c = filled<Container>();
+  while (iters--) {
+    folly::doNotOptimizeAway(countEmailsStartingWithA(c));
+  }
+}
+
+template <typename Container>
+void readRandomRecords(std::size_t iters) {
+  const auto& c = filled<Container>();
+  const auto& indexes = shuffledIndexes();
+  while (iters--) {
+    std::size_t sum = 0;
+    for (auto i : indexes) {
+      sum += readRecord(c, i);
+    }
+    folly::doNotOptimizeAway(sum);
+  }
+}
+
+void serialize(std::size_t iters) {
+  const auto& c = filled<col_tape>();
+  while (iters--) {
+    folly::doNotOptimizeAway(c.serialize());
+  }
+}
+
+void deserialize(std::size_t iters) {
+  std::string bytes;
+  BENCHMARK_SUSPEND {
+    bytes = filled<col_tape>().serialize();
+  }
+  while (iters--) {
+    folly::doNotOptimizeAway(col_tape::deserialize(folly::StringPiece(bytes)));
+  }
+}
+
+// Disabling clang format for table formatting
+// clang-format off
+BENCHMARK(PushBackVecStruct,            n) { pushBackRows<vec_struct>(n); }
+BENCHMARK_RELATIVE(PushBackColumnar,    n) { pushBackRows<col_tape>(n); }
+BENCHMARK(BulkAppendVecStruct,          n) { bulkAppendRows<vec_struct>(n); }
+BENCHMARK_RELATIVE(BulkAppendColumnar,  n) { bulkAppendRows<col_tape>(n); }
+BENCHMARK(CopyVecStruct,                n) { copy<vec_struct>(n); }
+BENCHMARK_RELATIVE(CopyColumnar,        n) { copy<col_tape>(n); }
+BENCHMARK_DRAW_LINE();
+BENCHMARK(ScanIntsVecStruct,            n) { scanInts<vec_struct>(n); }
+BENCHMARK_RELATIVE(ScanIntsColumnar,    n) { scanInts<col_tape>(n); }
+BENCHMARK(ScanStringsVecStruct,         n) { scanStrings<vec_struct>(n); }
+BENCHMARK_RELATIVE(ScanStringsColumnar, n) { scanStrings<col_tape>(n); }
+BENCHMARK(ReadRandomVecStruct,          n) { readRandomRecords<vec_struct>(n); }
+BENCHMARK_RELATIVE(ReadRandomColumnar,  n) { readRandomRecords<col_tape>(n); }
+BENCHMARK_DRAW_LINE();
+BENCHMARK(SerializeColumnar,            n) { serialize(n); }
+BENCHMARK(DeserializeColumnar,          n) { deserialize(n); }
+// clang-format on
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::Init init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/columnar_tape.h>
+
+#include <cstdint>
+#include <cstring>
+#include <forward_list>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+namespace {
+
+using person_tape =
+    folly::columnar_tape<std::string, std::int64_t, std::string>;
+using person = person_tape::value_type;
+
+template <typename I>
+struct InputIter {
+  I wrapped;
+
+  using value_type = typename std::iterator_traits<I>::value_type;
+  using reference = typename std::iterator_traits<I>::reference;
+  using difference_type = typename std::iterator_traits<I>::difference_type;
+  using pointer = typename std::iterator_traits<I>::pointer;
+  using iterator_category = std::input_iterator_tag;
+
+  InputIter& operator++() {
+    ++wrapped;
+    return *this;
+  }
+
+  reference operator*() const { return *wrapped; }
+
+  friend bool operator==(const InputIter& x, const InputIter& y) {
+    return x.wrapped == y.wrapped;
+  }
+  friend bool operator!=(const InputIter& x, const InputIter& y) {
+    return !(x == y);
+  }
+};
+
+std::vector<person> samplePeople() {
+  return {
+      {"alice", 1, "alice@example.com"},
+      {"bob", 2, ""},
+      {"", 3, "nobody@example.com"},
+      {"a much longer name than fits in sso", 4, "x"},
+  };
+}
+
+} // namespace
+
+// columnar_tape types
+
+static_assert(
+    std::is_same_v<
+        std::tuple<std::string, std::int64_t, std::string>,
+        person_tape::value_type>);
+static_assert(
+    std::is_same_v<folly::string_tape, person_tape::column_type<0>>);
+static_assert(
+    std::is_same_v<std::vector<std::int64_t>, person_tape::column_type<1>>);
+static_assert(person_tape::is_variable_column<0>);
+static_assert(!person_tape::is_variable_column<1>);
+static_assert(
+    std::is_same_v<
+        folly::StringPiece,
+        std::tuple_element_t<0, person_tape::reference>>);
+static_assert(
+    std::is_same_v<
+        std::int64_t&,
+        std::tuple_element_t<1, person_tape::reference>>);
+static_assert(
+    std::is_same_v<
+        const std::int64_t&,
+        std::tuple_element_t<1, person_tape::const_reference>>);
+static_assert(
+    std::is_same_v<
+        std::random_access_iterator_tag,
+        std::iterator_traits<person_tape::iterator>::iterator_category>);
+
+TEST(ColumnarTape, SmokeTest) {
+  person_tape t;
+  EXPECT_TRUE(t.empty());
+
+  t.push_back("alice", 1, "alice@example.com");
+  t.emplace_back(std::string("bob"), 2, folly::StringPiece("bob@example.com"));
+  ASSERT_EQ(2, t.size());
+
+  EXPECT_EQ("alice", t[0].get<0>());
+  EXPECT_EQ(1, t[0].get<1>());
+  EXPECT_EQ("alice@example.com", t[0].get<2>());
+  EXPECT_EQ("bob", t.get<0>(1));
+  EXPECT_EQ(2, t.get<1>(1));
+  EXPECT_EQ(person("bob", 2, "bob@example.com"), t.back().to_value());
+  EXPECT_THROW((void)t.at(2), std::out_of_range);
+
+  EXPECT_EQ(2, t.column<0>().size());
+  EXPECT_EQ(8, t.column<0>().size_flat());
+  EXPECT_THAT(t.column<1>(), testing::ElementsAre(1, 2));
+}
+
+TEST(ColumnarTape, RowProxies) {
+  auto const people = samplePeople();
+  person_tape t{people.begin(), people.end()};
+
+  auto [name, id, email] = t[2];
+  EXPECT_EQ("", name);
+  EXPECT_EQ("nobody@example.com", email);
+  id = 30;
+  EXPECT_EQ(30, t[2].get<1>());
+
+  t[0].get<1>() += 10;
+  using std::get;
+  EXPECT_EQ(11, get<1>(t[0]));
+
+  person_tape::const_reference cref = t[1];
+  EXPECT_EQ(1, cref.index());
+  person value = cref;
+  EXPECT_EQ(person("bob", 2, ""), value);
+
+  std::vector<person> rows(t.begin(), t.end());
+  EXPECT_EQ(4, rows.size());
+  EXPECT_EQ("a much longer name than fits in sso", std::get<0>(rows[3]));
+
+  std::int64_t sum = 0;
+  for (auto row : std::as_const(t)) {
+    sum += row.get<1>();
+  }
+  EXPECT_EQ(11 + 2 + 30 + 4, sum);
+  EXPECT_EQ(4, t.rbegin()->get<1>());
+}
+
+TEST(ColumnarTape, Append) {
+  auto people = samplePeople();
+
+  person_tape random{people.begin(), people.end()};
+  std::forward_list<person> list(people.begin(), people.end());
+  person_tape forward{list.begin(), list.end()};
+  person_tape input{
+      InputIter<std::vector<person>::iterator>{people.begin()},
+      InputIter<std::vector<person>::iterator>{people.end()}};
+
+  ASSERT_EQ(people.size(), random.size());
+  EXPECT_EQ(random, forward);
+  EXPECT_EQ(random, input);
+  for (std::size_t i = 0; i != people.size(); ++i) {
+    EXPECT_EQ(people[i], random[i].to_value());
+  }
+
+  // rows of another columnar_tape
+  person_tape copy;
+  copy.append(random.begin(), random.end());
+  EXPECT_EQ(random, copy);
+
+  // whole tapes, including itself
+  copy.append(random);
+  copy.append(copy);
+  ASSERT_EQ(4 * people.size(), copy.size());
+  for (std::size_t i = 0; i != copy.size(); ++i) {
+    EXPECT_EQ(people[i % people.size()], copy[i].to_value());
+  }
+
+  // pairs
+  std::vector<std::pair<std::int32_t, std::string>> pairs{{1, "a"}, {2, "bc"}};
+  folly::columnar_tape<std::int32_t, std::string> p{pairs.begin(), pairs.end()};
+  EXPECT_EQ("bc", p[1].get<1>());
+}
+
+TEST(ColumnarTape, VectorColumns) {
+  using row = std::tuple<std::vector<int>, double>;
+  folly::columnar_tape<std::vector<int>, double> t{
+      row{std::vector<int>{1, 2, 3}, 0.5},
+      row{std::vector<int>{}, 1.5},
+  };
+  t.push_back(std::vector<int>{4}, 2.5);
+  ASSERT_EQ(3, t.size());
+  EXPECT_THAT(t[0].get<0>(), testing::ElementsAre(1, 2, 3));
+  EXPECT_TRUE(t[1].get<0>().empty());
+  EXPECT_EQ(2.5, t[2].get<1>());
+  EXPECT_EQ(std::vector<int>{4}, std::get<0>(t[2].to_value()));
+}
+
+TEST(ColumnarTape, Erase) {
+  auto const people = samplePeople();
+  person_tape t{people.begin(), people.end()};
+
+  auto it = t.erase(t.begin() + 1);
+  EXPECT_EQ(1, it - t.begin());
+  ASSERT_EQ(3, t.size());
+  EXPECT_EQ("", t[1].get<0>());
+  EXPECT_EQ(3, t[1].get<1>());
+
+  t.erase(t.begin(), t.begin() + 2);
+  ASSERT_EQ(1, t.size());
+  EXPECT_EQ(4, t[0].get<1>());
+
+  t.pop_back();
+  EXPECT_TRUE(t.empty());
+
+  t.push_back("x", 5, "y");
+  t.clear();
+  EXPECT_TRUE(t.empty());
+  EXPECT_EQ(0, t.column<2>().size_flat());
+}
+
+TEST(ColumnarTape, Serialize) {
+  auto const people = samplePeople();
+  person_tape t{people.begin(), people.end()};
+  auto bytes = t.serialize();
+  auto back = person_tape::deserialize(folly::StringPiece(bytes));
+  EXPECT_EQ(t, back);
+
+  person_tape empty;
+  EXPECT_EQ(
+      empty, person_tape::deserialize(folly::StringPiece(empty.serialize())));
+
+  // appends to an existing buffer
+  std::string out = "prefix";
+  t.serialize(out);
+  EXPECT_EQ("prefix" + bytes, out);
+}
+
+TEST(ColumnarTape, DeserializeRejectsMalformedInput) {
+  auto const people = samplePeople();
+  person_tape t{people.begin(), people.end()};
+  auto const bytes = t.serialize();
+
+  auto deserialize = [](std::string s) {
+    return person_tape::deserialize(folly::StringPiece(s));
+  };
+
+  // every truncation
+  for (std::size_t n = 0; n != bytes.size(); ++n) {
+    EXPECT_THROW(deserialize(bytes.substr(0, n)), std::invalid_argument) << n;
+  }
+  EXPECT_THROW(deserialize(bytes + "x"), std::invalid_argument);
+
+  // a different schema
+  using other_tape =
+      folly::columnar_tape<std::string, std::int32_t, std::string>;
+  EXPECT_THROW(
+      other_tape::deserialize(folly::StringPiece(bytes)),
+      std::invalid_argument);
+  using short_tape = folly::columnar_tape<std::string, std::int64_t>;
+  EXPECT_THROW(
+      short_tape::deserialize(folly::StringPiece(bytes)),
+      std::invalid_argument);
+
+  // a huge row count does not allocate
+  auto huge = bytes;
+  std::uint64_t rows = ~std::uint64_t(0);
+  std::memcpy(huge.data() + 16, &rows, sizeof(rows));
+  EXPECT_THROW(deserialize(huge), std::invalid_argument);
+
+  // offsets which decrease
+  auto bad = bytes;
+  std::uint64_t offset = 100;
+  std::memcpy(bad.data() + 24 + 8 + 8, &offset, sizeof(offset));
+  EXPECT_THROW(deserialize(bad), std::invalid_argument);
+}
+
+TEST(ColumnarTape, ReserveShrink) {
+  person_tape t;
+  t.reserve(100);
+  EXPECT_LE(100, t.column<1>().capacity());
+  t.push_back("a", 1, "b");
+  t.shrink_to_fit();
+  EXPECT_EQ(1, t.size());
+  EXPECT_EQ(1, t.column<1>().capacity());
+}
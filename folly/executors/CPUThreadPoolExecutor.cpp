@@ -18,12 +18,15 @@
 #include <folly/executors/CPUThreadPoolExecutor.h>
 
 #include <atomic>
+#include <vector>
+
 #include <folly/Memory.h>
 #include <folly/Optional.h>
 #include <folly/executors/QueueObserver.h>
 #include <folly/executors/task_queue/PriorityLifoSemMPMCQueue.h>
 #include <folly/executors/task_queue/PriorityUnboundedBlockingQueue.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
+#include <folly/executors/task_queue/WorkStealingBlockingQueue.h>
 #include <folly/portability/GFlags.h>
 #include <folly/synchronization/ThrottledLifoSem.h>
 
@@ -98,6 +101,17 @@ CPUThreadPoolExecutor::CPUTask::CPUTask()
       numPriorities, opts);
 }
 
+/* static */ auto CPUThreadPoolExecutor::makeWorkStealingQueue()
+    -> std::unique_ptr<BlockingQueue<CPUTask>> {
+  return std::make_unique<WorkStealingBlockingQueue<CPUTask>>();
+}
+
+/* static */ auto CPUThreadPoolExecutor::makeWorkStealingPriorityQueue(
+    int8_t numPriorities) -> std::unique_ptr<BlockingQueue<CPUTask>> {
+  CHECK_GT(numPriorities, 0) << "Number of priorities should be positive";
+  return std::make_unique<WorkStealingBlockingQueue<CPUTask>>(numPriorities);
+}
+
 CPUThreadPoolExecutor::CPUThreadPoolExecutor(
     size_t numThreads,
     std::unique_ptr<BlockingQueue<CPUTask>> taskQueue,
@@ -237,8 +251,8 @@ void CPUThreadPoolExecutor::add(
       std::move(func), priority, expiration, std::move(expireCallback));
 }
 
-template <bool withPriority>
-void CPUThreadPoolExecutor::addImpl(
+folly::Optional<CPUThreadPoolExecutor::CPUTask>
+CPUThreadPoolExecutor::makeTask(
     Func func,
     int8_t priority,
     std::chrono::milliseconds expiration,
@@ -246,11 +260,7 @@ void CPUThreadPoolExecutor::addImpl(
   if (!func) {
     // Reserve empty funcs as poison by logging the error inline.
     invokeCatchingExns("ThreadPoolExecutor: func", std::move(func));
-    return;
-  }
-
-  if (withPriority) {
-    CHECK_GT(getNumPriorities(), 0);
+    return folly::none;
   }
 
   CPUTask task(
@@ -259,7 +269,11 @@ void CPUThreadPoolExecutor::addImpl(
     task.queueObserverPayload_ = queueObserver->onEnqueued(task.context_.get());
   }
   registerTaskEnqueue(task);
+  return task;
+}
 
+template <typename Enqueue>
+void CPUThreadPoolExecutor::enqueueTasks(Enqueue&& enqueue) {
   // It's not safe to expect that the executor is alive after a task is added to
   // the queue (this task could be holding the last KeepAlive and when finished
   // - it may unblock the executor shutdown).
@@ -272,15 +286,53 @@ void CPUThreadPoolExecutor::addImpl(
       ? getKeepAliveToken(this)
       : folly::Executor::KeepAlive<>{};
 
-  auto result = withPriority
-      ? taskQueue_->addWithPriority(std::move(task), priority)
-      : taskQueue_->add(std::move(task));
+  size_t numNotReused = enqueue();
 
-  if (mayNeedToAddThreads && !result.reusedThread) {
-    ensureActiveThreads();
+  if (mayNeedToAddThreads && numNotReused > 0) {
+    ensureActiveThreads(numNotReused);
   }
 }
 
+template <bool withPriority>
+void CPUThreadPoolExecutor::addImpl(
+    Func func,
+    int8_t priority,
+    std::chrono::milliseconds expiration,
+    Func expireCallback) {
+  if (withPriority && func) {
+    CHECK_GT(getNumPriorities(), 0);
+  }
+
+  auto task =
+      makeTask(std::move(func), priority, expiration, std::move(expireCallback));
+  if (!task) {
+    return;
+  }
+
+  enqueueTasks([&]() -> size_t {
+    auto result = withPriority
+        ? taskQueue_->addWithPriority(std::move(*task), priority)
+        : taskQueue_->add(std::move(*task));
+    return result.reusedThread ? 0 : 1;
+  });
+}
+
+void CPUThreadPoolExecutor::addBatch(span<Func> funcs) {
+  std::vector<CPUTask> tasks;
+  tasks.reserve(funcs.size());
+  for (auto& func : funcs) {
+    if (auto task =
+            makeTask(std::move(func), 0, std::chrono::milliseconds(0), nullptr)) {
+      tasks.push_back(std::move(*task));
+    }
+  }
+  if (tasks.empty()) {
+    return;
+  }
+
+  enqueueTasks([&] { return taskQueue_->addBatch(tasks); });
+}
+
 uint8_t CPUThreadPoolExecutor::getNumPriorities() const {
   return taskQueue_->getNumPriorities();
 }
@@ -64,6 +64,10 @@ namespace folly {
  * themselves don't have priorities set, so a series of long running low
  * priority tasks could still hog all the threads. (at last check pthreads
  * thread priorities didn't work very well).
+ *
+ * @note For many short tasks that are mostly added from the pool's own threads,
+ * makeWorkStealingQueue() gives each thread its own deque, which it runs in
+ * LIFO order and which idle threads steal from, instead of the single queue.
  */
 class CPUThreadPoolExecutor
     : public ThreadPoolExecutor,
@@ -103,6 +107,13 @@ class CPUThreadPoolExecutor
   makeThrottledLifoSemPriorityQueue(
       int8_t numPriorities, std::chrono::nanoseconds wakeUpInterval = {});
 
+  // These function return unbounded work-stealing queues, see
+  // WorkStealingBlockingQueue. They suit pools whose tasks mostly schedule
+  // further tasks on the same pool.
+  static std::unique_ptr<BlockingQueue<CPUTask>> makeWorkStealingQueue();
+  static std::unique_ptr<BlockingQueue<CPUTask>> makeWorkStealingPriorityQueue(
+      int8_t numPriorities);
+
   CPUThreadPoolExecutor(
       size_t numThreads,
       std::unique_ptr<BlockingQueue<CPUTask>> taskQueue,
@@ -154,6 +165,12 @@ class CPUThreadPoolExecutor
       Func expireCallback = nullptr) override;
 
   void addWithPriority(Func func, int8_t priority) override;
+
+  // Enqueues the batch with a single addBatch() on the task queue, which wakes
+  // at most one idle thread per task, and starts threads at once for the tasks
+  // that no idle thread was woken for.
+  void addBatch(span<Func> funcs) override;
+
   virtual void add(
       Func func,
       int8_t priority,
@@ -196,6 +213,16 @@ class CPUThreadPoolExecutor
   bool tryDecrToStop();
   bool taskShouldStop(folly::Optional<CPUTask>&);
 
+  // Returns none for empty funcs, which are logged instead.
+  folly::Optional<CPUTask> makeTask(
+      Func func,
+      int8_t priority,
+      std::chrono::milliseconds expiration,
+      Func expireCallback);
+  // Calls enqueue() to add tasks to the queue, and starts threads for the
+  // number of them it returns, those no existing thread will work on.
+  template <typename Enqueue>
+  void enqueueTasks(Enqueue&& enqueue);
   template <bool withPriority>
   void addImpl(
       Func func,
@@ -22,6 +22,7 @@
 #include <chrono>
 #include <cstddef>
 #include <exception>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <queue>
@@ -335,6 +336,13 @@ void EDFThreadPoolExecutor::add(std::vector<Func> fs, uint64_t deadline) {
   }
 }
 
+void EDFThreadPoolExecutor::addBatch(span<Func> funcs) {
+  add(std::vector<Func>(
+          std::make_move_iterator(funcs.begin()),
+          std::make_move_iterator(funcs.end())),
+      kLatestDeadline);
+}
+
 size_t EDFThreadPoolExecutor::getTaskQueueSize() const {
   return taskQueue_->size();
 }
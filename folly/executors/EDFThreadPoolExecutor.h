@@ -85,6 +85,10 @@ class EDFThreadPoolExecutor
   void add(Func f, std::size_t total, uint64_t deadline) override;
   void add(std::vector<Func> fs, uint64_t deadline) override;
 
+  // Adds the batch as a single task, with the latest deadline, as
+  // add(std::vector<Func>, deadline) does.
+  void addBatch(span<Func> funcs) override;
+
   size_t getTaskQueueSize() const;
 
  protected:
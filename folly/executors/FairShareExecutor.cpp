@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/FairShareExecutor.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <folly/portability/Time.h>
+
+namespace folly {
+
+namespace {
+
+std::chrono::nanoseconds threadCpuTime() {
+  timespec tp{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tp);
+  return std::chrono::seconds(tp.tv_sec) + std::chrono::nanoseconds(tp.tv_nsec);
+}
+
+} // namespace
+
+class FairShareExecutor::TenantExecutor : public Executor {
+ public:
+  TenantExecutor(FairShareExecutor& owner, NodeId id)
+      : owner_(owner), id_(id) {}
+
+  void add(Func func) override { owner_.enqueue(id_, std::move(func)); }
+
+ protected:
+  bool keepAliveAcquire() noexcept override {
+    return Executor::keepAliveAcquire(&owner_);
+  }
+
+  void keepAliveRelease() noexcept override {
+    Executor::keepAliveRelease(&owner_);
+  }
+
+ private:
+  FairShareExecutor& owner_;
+  const NodeId id_;
+};
+
+FairShareExecutor::FairShareExecutor(KeepAlive<> parent, Options options)
+    : options_(std::move(options)), parent_(std::move(parent)) {
+  CHECK_GE(options_.maxInFlight, 1);
+  CHECK_GT(options_.quantum.count(), 0);
+  auto root = std::make_unique<Node>();
+  root->stats.id = kRoot;
+  root->stats.name = "root";
+  root->stats.weight = 1;
+  nodes_.push_back(std::move(root));
+  auto tenant = addTenant("default", 1);
+  DCHECK_EQ(tenant, kDefaultTenant);
+}
+
+FairShareExecutor::~FairShareExecutor() {
+  joinKeepAlive();
+}
+
+void FairShareExecutor::add(Func func) {
+  enqueue(kDefaultTenant, std::move(func));
+}
+
+FairShareExecutor::NodeId FairShareExecutor::addGroup(
+    std::string name, uint32_t weight, NodeId parent) {
+  return addNode(std::move(name), weight, parent, false);
+}
+
+FairShareExecutor::NodeId FairShareExecutor::addTenant(
+    std::string name, uint32_t weight, NodeId parent) {
+  return addNode(std::move(name), weight, parent, true);
+}
+
+FairShareExecutor::NodeId FairShareExecutor::addNode(
+    std::string name, uint32_t weight, NodeId parent, bool tenant) {
+  CHECK_GT(weight, 0);
+  std::lock_guard lock(mutex_);
+  groupLocked(parent);
+  auto node = std::make_unique<Node>();
+  node->stats.id = static_cast<NodeId>(nodes_.size());
+  node->stats.parent = parent;
+  node->stats.name = std::move(name);
+  node->stats.isTenant = tenant;
+  node->stats.weight = weight;
+  if (tenant) {
+    node->executor = std::make_unique<TenantExecutor>(*this, node->stats.id);
+  }
+  nodes_.push_back(std::move(node));
+  return nodes_.back()->stats.id;
+}
+
+FairShareExecutor::Node& FairShareExecutor::groupLocked(NodeId id) {
+  CHECK_LT(id, nodes_.size()) << "Unknown node " << id;
+  auto& node = *nodes_[id];
+  CHECK(!node.stats.isTenant) << "Node " << id << " is not a group";
+  return node;
+}
+
+Executor::KeepAlive<> FairShareExecutor::getTenant(NodeId tenant) {
+  std::lock_guard lock(mutex_);
+  CHECK_LT(tenant, nodes_.size()) << "Unknown node " << tenant;
+  auto& node = *nodes_[tenant];
+  CHECK(node.stats.isTenant) << "Node " << tenant << " is not a tenant";
+  return getKeepAliveToken(node.executor.get());
+}
+
+void FairShareExecutor::setWeight(NodeId node, uint32_t weight) {
+  CHECK_GT(weight, 0);
+  CHECK_NE(node, kRoot) << "The root has no weight";
+  std::lock_guard lock(mutex_);
+  CHECK_LT(node, nodes_.size()) << "Unknown node " << node;
+  nodes_[node]->stats.weight = weight;
+}
+
+FairShareExecutor::NodeStats FairShareExecutor::getStats(NodeId node) const {
+  std::lock_guard lock(mutex_);
+  CHECK_LT(node, nodes_.size()) << "Unknown node " << node;
+  return nodes_[node]->stats;
+}
+
+std::vector<FairShareExecutor::NodeStats> FairShareExecutor::getAllStats()
+    const {
+  std::lock_guard lock(mutex_);
+  std::vector<NodeStats> stats;
+  stats.reserve(nodes_.size());
+  for (auto& node : nodes_) {
+    stats.push_back(node->stats);
+  }
+  return stats;
+}
+
+size_t FairShareExecutor::pendingTasks() const {
+  std::lock_guard lock(mutex_);
+  return pending_;
+}
+
+void FairShareExecutor::enqueue(NodeId tenant, Func func) {
+  Task task{
+      std::move(func),
+      RequestContext::saveContext(),
+      std::chrono::steady_clock::now()};
+
+  bool shouldScheduleWorker = false;
+  {
+    std::lock_guard lock(mutex_);
+    auto& node = *nodes_[tenant];
+    node.queue.push_back(std::move(task));
+    for (auto id = tenant;; id = nodes_[id]->stats.parent) {
+      auto& stats = nodes_[id]->stats;
+      ++stats.addedTasks;
+      ++stats.pendingTasks;
+      if (id == kRoot) {
+        break;
+      }
+    }
+    if (node.queue.size() == 1) {
+      activateLocked(tenant);
+    }
+    ++pending_;
+    if (inFlight_ < options_.maxInFlight) {
+      ++inFlight_;
+      shouldScheduleWorker = true;
+    }
+  }
+
+  if (shouldScheduleWorker) {
+    scheduleWorker();
+  }
+}
+
+void FairShareExecutor::activateLocked(NodeId id) {
+  // Join the rounds up to the first group that already has pending tasks.
+  while (id != kRoot) {
+    auto& node = *nodes_[id];
+    DCHECK(!node.active);
+    node.active = true;
+    // Credit is not kept across idle periods.
+    node.deficit = std::min<int64_t>(node.deficit, 0);
+    auto& parent = *nodes_[node.stats.parent];
+    parent.round.push_back(id);
+    if (parent.round.size() > 1) {
+      break;
+    }
+    id = node.stats.parent;
+  }
+}
+
+void FairShareExecutor::deactivateLocked(NodeId id) {
+  // Leave the rounds up to the first group that still has pending tasks.
+  while (id != kRoot) {
+    auto& node = *nodes_[id];
+    DCHECK(node.active);
+    node.active = false;
+    node.deficit = std::min<int64_t>(node.deficit, 0);
+    auto& round = nodes_[node.stats.parent]->round;
+    round.erase(std::find(round.begin(), round.end(), id));
+    if (!round.empty()) {
+      break;
+    }
+    id = node.stats.parent;
+  }
+}
+
+FairShareExecutor::NodeId FairShareExecutor::pickLocked(Task& task) {
+  DCHECK_GT(pending_, 0);
+  auto const quantum = options_.quantum.count();
+
+  auto id = kRoot;
+  while (!nodes_[id]->stats.isTenant) {
+    auto& round = nodes_[id]->round;
+    DCHECK(!round.empty());
+    // The child at the front runs while it has credit. A child that used up
+    // its credit goes to the back of the round, and gets its quantum for its
+    // next turn.
+    for (size_t rotations = 0;; ++rotations) {
+      if (rotations == round.size()) {
+        // A full round went by without any child getting back to credit, as
+        // happens after long tasks. Skip the rounds in which that stays true.
+        int64_t skip = std::numeric_limits<int64_t>::max();
+        for (auto child : round) {
+          auto& c = *nodes_[child];
+          int64_t perRound = quantum * c.stats.weight;
+          skip = std::min(skip, std::max<int64_t>(-c.deficit / perRound, 0));
+        }
+        for (auto child : round) {
+          auto& c = *nodes_[child];
+          c.deficit += skip * quantum * c.stats.weight;
+        }
+        rotations = 0;
+      }
+      auto& front = *nodes_[round.front()];
+      if (front.deficit > 0) {
+        break;
+      }
+      front.deficit += quantum * front.stats.weight;
+      round.push_back(round.front());
+      round.pop_front();
+    }
+    id = round.front();
+  }
+
+  auto& tenant = *nodes_[id];
+  DCHECK(!tenant.queue.empty());
+  task = std::move(tenant.queue.front());
+  tenant.queue.pop_front();
+  --pending_;
+
+  // The cost is charged when the task completes, but the estimate is charged
+  // now, so that concurrent workers do not all pick the same tenant.
+  auto const delay = std::chrono::steady_clock::now() - task.enqueueTime;
+  for (auto n = id;; n = nodes_[n]->stats.parent) {
+    auto& node = *nodes_[n];
+    node.deficit -= tenant.costEstimate;
+    auto& stats = node.stats;
+    --stats.pendingTasks;
+    stats.totalQueueDelay += delay;
+    stats.maxQueueDelay = std::max<std::chrono::nanoseconds>(
+        stats.maxQueueDelay, delay);
+    if (n == kRoot) {
+      break;
+    }
+  }
+
+  if (tenant.queue.empty()) {
+    deactivateLocked(id);
+  }
+  return id;
+}
+
+void FairShareExecutor::chargeLocked(
+    NodeId tenant, int64_t cost, int64_t estimate) {
+  for (auto n = tenant;; n = nodes_[n]->stats.parent) {
+    auto& node = *nodes_[n];
+    node.deficit -= cost - estimate;
+    ++node.stats.executedTasks;
+    node.stats.usage += std::chrono::nanoseconds(cost);
+    if (n == kRoot) {
+      break;
+    }
+  }
+  auto& estimated = nodes_[tenant]->costEstimate;
+  estimated += (cost - estimated) / 8;
+}
+
+void FairShareExecutor::worker() {
+  Task task;
+  NodeId tenant;
+  int64_t estimate;
+  {
+    std::lock_guard lock(mutex_);
+    if (pending_ == 0) {
+      --inFlight_;
+      return;
+    }
+    tenant = pickLocked(task);
+    estimate = nodes_[tenant]->costEstimate;
+  }
+
+  auto const now = [&] {
+    return options_.chargeCpuTime
+        ? threadCpuTime()
+        : std::chrono::steady_clock::now().time_since_epoch();
+  };
+  auto const start = now();
+  {
+    folly::RequestContextScopeGuard rctxGuard{std::move(task.ctx)};
+    invokeCatchingExns("FairShareExecutor", std::exchange(task.func, {}));
+  }
+  auto const cost =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now() - start);
+
+  bool shouldRescheduleWorker;
+  {
+    std::lock_guard lock(mutex_);
+    chargeLocked(tenant, cost.count(), estimate);
+    shouldRescheduleWorker = pending_ > 0;
+    if (!shouldRescheduleWorker) {
+      --inFlight_;
+    }
+  }
+  if (shouldRescheduleWorker) {
+    scheduleWorker();
+  }
+}
+
+void FairShareExecutor::scheduleWorker() {
+  folly::RequestContextScopeGuard rctxGuard{nullptr};
+  parent_->add([self = getKeepAliveToken(this)] { self->worker(); });
+}
+
+} // namespace folly
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/DefaultKeepAliveExecutor.h>
+#include <folly/io/async/Request.h>
+
+namespace folly {
+
+/// FairShareExecutor shares an executor between tenants in proportion to
+/// their weights, so that a tenant that adds more work than its share only
+/// delays its own tasks.
+///
+/// Tenants are the leaves of a tree of groups. Every node has a weight, and
+/// the time of its parent is divided between the children that have pending
+/// tasks in proportion to their weights: with a group A of weight 3 holding
+/// tenants A1 and A2 of weight 1, and a tenant B of weight 1, A1 and A2 get
+/// 3/8 each and B 1/4 when all of them are busy, and A1 gets 3/4 when A2 is
+/// idle.
+///
+/// Each group schedules its children with deficit round robin: the child at
+/// the front of the round runs tasks until it has used its weight times
+/// Options::quantum, then moves to the back and the next child takes over.
+/// The time a task used is measured on the thread that ran it, by default
+/// as cpu time, and charged to its tenant and every group above it. Since
+/// the cost is only known after the task ran, a tenant is charged an
+/// estimate when its task is dispatched, and the difference when it
+/// completes. A tenant that runs out of tasks keeps its debt, but not its
+/// credit.
+///
+/// Tasks are dispatched to the parent executor one at a time, by up to
+/// Options::maxInFlight workers, similarly to MeteredExecutor. The
+/// scheduler only orders the tasks of this executor: the parent's other
+/// work, and other FairShareExecutors on the same parent, are not accounted.
+///
+/// Per-node counters of tasks, queueing delay and usage are available with
+/// getStats(); a group's counters include those of its descendants.
+///
+/// Example:
+///
+///   FairShareExecutor fse(getKeepAliveToken(pool));
+///   auto batch = fse.addGroup("batch", 1);
+///   auto interactive = fse.addTenant("interactive", 4);
+///   auto reports = fse.addTenant("reports", 1, batch);
+///   auto backfill = fse.addTenant("backfill", 1, batch);
+///   fse.getTenant(reports)->add(...);
+class FairShareExecutor : public DefaultKeepAliveExecutor {
+ public:
+  using NodeId = uint32_t;
+
+  /// The root group, which holds the default tenant and all the nodes added
+  /// without a parent.
+  static constexpr NodeId kRoot = 0;
+  /// The tenant of the tasks added to the FairShareExecutor itself, of
+  /// weight 1.
+  static constexpr NodeId kDefaultTenant = 1;
+
+  struct Options {
+    Options() {}
+
+    /// The number of tasks that may be in the parent executor at a time.
+    size_t maxInFlight{1};
+
+    /// The time a node of weight 1 may use per round. Shorter quanta
+    /// interleave tenants more finely, at the cost of more rotations.
+    std::chrono::nanoseconds quantum{std::chrono::microseconds(500)};
+
+    /// Charge tenants the cpu time of their tasks rather than the wall time.
+    /// Wall time also charges the time tasks spend blocked.
+    bool chargeCpuTime{true};
+  };
+
+  struct NodeStats {
+    NodeId id{kRoot};
+    NodeId parent{kRoot};
+    std::string name;
+    bool isTenant{false};
+    uint32_t weight{0};
+    uint64_t addedTasks{0};
+    uint64_t executedTasks{0};
+    uint64_t pendingTasks{0};
+    /// The time tasks waited in this executor before they were dispatched.
+    std::chrono::nanoseconds totalQueueDelay{0};
+    std::chrono::nanoseconds maxQueueDelay{0};
+    /// The time charged for the tasks that completed.
+    std::chrono::nanoseconds usage{0};
+  };
+
+  explicit FairShareExecutor(KeepAlive<> parent, Options options = {});
+  ~FairShareExecutor() override;
+
+  FairShareExecutor(const FairShareExecutor&) = delete;
+  FairShareExecutor& operator=(const FairShareExecutor&) = delete;
+
+  /// Adds to the default tenant.
+  void add(Func func) override;
+
+  /// Adds a group or a tenant under the given group. Weights must be
+  /// positive. Names are only used in stats, and need not be unique.
+  NodeId addGroup(std::string name, uint32_t weight, NodeId parent = kRoot);
+  NodeId addTenant(std::string name, uint32_t weight, NodeId parent = kRoot);
+
+  /// Returns the executor of a tenant. It keeps this FairShareExecutor alive.
+  KeepAlive<> getTenant(NodeId tenant);
+
+  /// Changes the weight of a node, from its next round on.
+  void setWeight(NodeId node, uint32_t weight);
+
+  NodeStats getStats(NodeId node) const;
+  /// Returns the stats of every node, in the order they were added.
+  std::vector<NodeStats> getAllStats() const;
+
+  size_t pendingTasks() const;
+
+ private:
+  class TenantExecutor;
+
+  struct Task {
+    Func func;
+    std::shared_ptr<RequestContext> ctx;
+    std::chrono::steady_clock::time_point enqueueTime;
+  };
+
+  struct Node {
+    NodeStats stats;
+    // Credit in ns for the current round; negative when in debt.
+    int64_t deficit{0};
+    // Whether the node is in its parent's round, that is, it has pending
+    // tasks.
+    bool active{false};
+    // groups: the children with pending tasks, the one to run first at the
+    // front
+    std::deque<NodeId> round;
+    // tenants
+    std::deque<Task> queue;
+    int64_t costEstimate{0};
+    std::unique_ptr<TenantExecutor> executor;
+  };
+
+  NodeId addNode(std::string name, uint32_t weight, NodeId parent, bool tenant);
+  Node& groupLocked(NodeId id);
+  void enqueue(NodeId tenant, Func func);
+  void activateLocked(NodeId id);
+  void deactivateLocked(NodeId id);
+  NodeId pickLocked(Task& task);
+  void chargeLocked(NodeId tenant, int64_t cost, int64_t estimate);
+  void worker();
+  void scheduleWorker();
+
+  const Options options_;
+  const KeepAlive<> parent_;
+
+  mutable std::mutex mutex_;
+  // Indexed by NodeId; nodes are never removed.
+  std::vector<std::unique_ptr<Node>> nodes_;
+  size_t pending_{0};
+  size_t inFlight_{0};
+};
+
+} // namespace folly
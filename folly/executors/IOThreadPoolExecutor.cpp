@@ -16,6 +16,9 @@
 
 #include <folly/executors/IOThreadPoolExecutor.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <glog/logging.h>
 
 #include <folly/detail/MemoryIdler.h>
@@ -154,6 +157,53 @@ void IOThreadPoolExecutor::add(
   ioThread->eventBase->runInEventBaseThread(std::move(wrappedFunc));
 }
 
+void IOThreadPoolExecutor::addBatch(span<Func> funcs) {
+  if (funcs.empty()) {
+    return;
+  }
+  ensureActiveThreads(funcs.size());
+  std::shared_lock r{threadListLock_};
+  auto& ths = threadList_.get();
+  if (ths.empty()) {
+    throw std::runtime_error("No threads available");
+  }
+
+  // As in pickThread(), the tasks added from one of the threads run on it,
+  // and the others go round-robin, one thread per task.
+  std::vector<std::shared_ptr<IOThread>> groupThreads;
+  auto& me = *thisThread_;
+  if (me && threadList_.contains(me)) {
+    groupThreads.push_back(me);
+  } else {
+    auto const n = ths.size();
+    auto const first = nextThread_.fetch_add(funcs.size());
+    groupThreads.reserve(std::min(n, funcs.size()));
+    for (size_t i = 0; i < std::min(n, funcs.size()); ++i) {
+      groupThreads.push_back(
+          std::static_pointer_cast<IOThread>(ths[(first + i) % n]));
+    }
+  }
+
+  std::vector<std::vector<Task>> groups(groupThreads.size());
+  for (size_t i = 0; i < funcs.size(); ++i) {
+    auto& group = groups[i % groups.size()];
+    group.emplace_back(
+        std::move(funcs[i]), std::chrono::milliseconds(0), nullptr);
+    registerTaskEnqueue(group.back());
+  }
+  for (size_t g = 0; g < groups.size(); ++g) {
+    auto& ioThread = groupThreads[g];
+    ioThread->pendingTasks += groups[g].size();
+    ioThread->eventBase->runInEventBaseThread(
+        [this, ioThread, tasks = std::move(groups[g])]() mutable {
+          for (auto& task : tasks) {
+            runTask(ioThread, std::move(task));
+            ioThread->pendingTasks--;
+          }
+        });
+  }
+}
+
 std::shared_ptr<IOThreadPoolExecutor::IOThread>
 IOThreadPoolExecutor::pickThread() {
   auto& me = *thisThread_;
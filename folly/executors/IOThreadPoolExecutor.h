@@ -119,6 +119,10 @@ class IOThreadPoolExecutor : public IOThreadPoolExecutorBase {
       std::chrono::milliseconds expiration,
       Func expireCallback = nullptr) override;
 
+  // Spreads the batch over the threads as add() would, but posts the tasks
+  // for each thread to its EventBase at once.
+  void addBatch(span<Func> funcs) override;
+
   folly::EventBase* getEventBase() override;
 
   // Ensures that the maximum number of active threads is running and returns
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/NumaThreadPoolExecutor.h>
+
+#include <glog/logging.h>
+#include <folly/Conv.h>
+#include <folly/executors/thread_factory/CpuAffinityThreadFactory.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+
+namespace folly {
+
+NumaThreadPoolExecutor::NumaThreadPoolExecutor(
+    Options options, const NumaTopology& topology)
+    : topology_(topology) {
+  CHECK_GT(options.numPriorities, 0)
+      << "Number of priorities should be positive";
+  pools_.reserve(topology_.numNodes());
+  for (size_t node = 0; node < topology_.numNodes(); ++node) {
+    auto const& cpus = topology_.cpusByNode[node];
+    std::shared_ptr<ThreadFactory> threadFactory =
+        std::make_shared<NamedThreadFactory>(
+            to<std::string>(options.namePrefix, node, "-"));
+    if (options.pinThreads) {
+      threadFactory = std::make_shared<CpuAffinityThreadFactory>(
+          std::move(threadFactory), cpus);
+    }
+    auto const numThreads =
+        options.threadsPerNode ? options.threadsPerNode : cpus.size();
+    pools_.push_back(std::make_unique<CPUThreadPoolExecutor>(
+        numThreads, options.numPriorities, std::move(threadFactory)));
+  }
+}
+
+NumaThreadPoolExecutor::~NumaThreadPoolExecutor() {
+  joinKeepAlive();
+  // the pools' destructors would drop pending tasks
+  join();
+}
+
+void NumaThreadPoolExecutor::add(Func func) {
+  currentPool().add(std::move(func));
+}
+
+void NumaThreadPoolExecutor::add(Func func, size_t nodeHint) {
+  pools_[nodeHint % pools_.size()]->add(std::move(func));
+}
+
+void NumaThreadPoolExecutor::addWithPriority(Func func, int8_t priority) {
+  currentPool().addWithPriority(std::move(func), priority);
+}
+
+void NumaThreadPoolExecutor::addWithPriority(
+    Func func, int8_t priority, size_t nodeHint) {
+  pools_[nodeHint % pools_.size()]->addWithPriority(std::move(func), priority);
+}
+
+uint8_t NumaThreadPoolExecutor::getNumPriorities() const {
+  return pools_.front()->getNumPriorities();
+}
+
+size_t NumaThreadPoolExecutor::numThreads() const {
+  size_t n = 0;
+  for (auto& pool : pools_) {
+    n += pool->numThreads();
+  }
+  return n;
+}
+
+size_t NumaThreadPoolExecutor::getPendingTaskCount() const {
+  size_t n = 0;
+  for (auto& pool : pools_) {
+    n += pool->getPendingTaskCount();
+  }
+  return n;
+}
+
+void NumaThreadPoolExecutor::stop() {
+  for (auto& pool : pools_) {
+    pool->stop();
+  }
+}
+
+void NumaThreadPoolExecutor::join() {
+  for (auto& pool : pools_) {
+    pool->join();
+  }
+}
+
+} // namespace folly
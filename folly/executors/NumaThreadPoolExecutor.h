@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/DefaultKeepAliveExecutor.h>
+#include <folly/concurrency/NumaTopology.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+
+namespace folly {
+
+/**
+ * A thread pool for CPU bound tasks with one CPUThreadPoolExecutor per NUMA
+ * node, whose threads are pinned to the cpus of that node (see
+ * CpuAffinityThreadFactory), so that tasks run close to the memory they
+ * touch.
+ *
+ * add(func) runs the task on the node of the calling thread, which keeps
+ * tasks added from the pool on their node. add(func, nodeHint) runs it on the
+ * given node, for a task whose data is known to live there, for example
+ * because it was allocated by a thread of that node.
+ *
+ * Each node has its own queue, and idle threads do not take tasks of other
+ * nodes, so work that is added unevenly across nodes is also run unevenly.
+ *
+ * The destructor blocks until all tasks have run and all keep-alive tokens
+ * are released.
+ */
+class NumaThreadPoolExecutor : public DefaultKeepAliveExecutor {
+ public:
+  struct Options {
+    Options() {}
+
+    /**
+     * The number of threads of each node. 0 means one thread per cpu of the
+     * node.
+     */
+    size_t threadsPerNode{0};
+
+    /**
+     * The number of priorities of each node's queue.
+     */
+    int8_t numPriorities{1};
+
+    /**
+     * Whether to pin the threads of each node to its cpus.
+     */
+    bool pinThreads{true};
+
+    /**
+     * The threads of node n are named "<namePrefix><n>-<thread>".
+     */
+    std::string namePrefix{"NumaPool"};
+  };
+
+  explicit NumaThreadPoolExecutor(
+      Options options = {},
+      const NumaTopology& topology = NumaTopology::system());
+
+  ~NumaThreadPoolExecutor() override;
+
+  /**
+   * Runs the task on the node the calling thread runs on.
+   */
+  void add(Func func) override;
+
+  /**
+   * Runs the task on node nodeHint % numNodes().
+   */
+  void add(Func func, size_t nodeHint);
+
+  void addWithPriority(Func func, int8_t priority) override;
+  void addWithPriority(Func func, int8_t priority, size_t nodeHint);
+
+  uint8_t getNumPriorities() const override;
+
+  const NumaTopology& topology() const { return topology_; }
+
+  size_t numNodes() const { return pools_.size(); }
+
+  /**
+   * The pool running the tasks of the given node.
+   */
+  CPUThreadPoolExecutor& nodePool(size_t node) { return *pools_.at(node); }
+
+  size_t numThreads() const;
+
+  size_t getPendingTaskCount() const;
+
+  void stop();
+  void join();
+
+ private:
+  CPUThreadPoolExecutor& currentPool() {
+    return *pools_[topology_.currentNode() % pools_.size()];
+  }
+
+  NumaTopology topology_;
+  std::vector<std::unique_ptr<CPUThreadPoolExecutor>> pools_;
+};
+
+} // namespace folly
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <iterator>
+#include <vector>
+
 #include <glog/logging.h>
 
 #include <folly/ExceptionString.h>
@@ -100,6 +103,26 @@ void SerialExecutorImpl<Queue>::addWithPriority(Func func, int8_t priority) {
   }
 }
 
+template <template <typename> typename Queue>
+void SerialExecutorImpl<Queue>::addBatch(span<Func> funcs) {
+  if (funcs.empty()) {
+    return;
+  }
+  std::vector<Task> tasks;
+  tasks.reserve(funcs.size());
+  auto ctx = RequestContext::saveContext();
+  for (auto& func : funcs) {
+    tasks.push_back(Task{std::move(func), ctx});
+  }
+  queue_.enqueue_bulk(
+      std::make_move_iterator(tasks.begin()),
+      std::make_move_iterator(tasks.end()));
+  // As in scheduleTask(), one worker runs the whole batch, in order.
+  if (scheduled_.fetch_add(tasks.size(), std::memory_order_acq_rel) == 0) {
+    parent_->add(Worker{getKeepAliveToken(this)});
+  }
+}
+
 template <template <typename> typename Queue>
 bool SerialExecutorImpl<Queue>::scheduleTask(Func&& func) {
   queue_.enqueue(Task{std::move(func), RequestContext::saveContext()});
@@ -199,24 +222,17 @@ class SerialExecutorMPSCQueue {
   }
 
   void enqueue(Task&& task) {
+    mutex_.lock_combine([&] { push(std::move(task)); });
+  }
+
+  // Enqueues the tasks in [first, last) in order, under a single acquisition
+  // of the mutex.
+  template <typename It>
+  void enqueue_bulk(It first, It last) {
     mutex_.lock_combine([&] {
-      // dequeue() will not delete a segment or try to read head_->next until
-      // the next write has completed, so this is safe.
-      if (tail_->writeIdx.load() == kSegmentSize) {
-        auto* segment =
-            segmentCache_.exchange(nullptr, std::memory_order_acquire);
-        if (segment == nullptr) {
-          segment = new Segment;
-        } else {
-          std::destroy_at(segment);
-          new (segment) Segment;
-        }
-        tail_->next = segment;
-        tail_ = segment;
+      for (; first != last; ++first) {
+        push(*first);
       }
-      auto idx = tail_->writeIdx.load();
-      new (&tail_->tasks[idx]) Task(std::move(task));
-      tail_->writeIdx.store(idx + 1);
     });
   }
 
@@ -255,6 +271,26 @@ class SerialExecutorMPSCQueue {
   };
   static_assert(std::is_trivially_destructible_v<Segment>);
 
+  // Must be called under mutex_.
+  void push(Task&& task) {
+    // dequeue() will not delete a segment or try to read head_->next until
+    // the next write has completed, so this is safe.
+    if (tail_->writeIdx.load() == kSegmentSize) {
+      auto* segment = segmentCache_.exchange(nullptr, std::memory_order_acquire);
+      if (segment == nullptr) {
+        segment = new Segment;
+      } else {
+        std::destroy_at(segment);
+        new (segment) Segment;
+      }
+      tail_->next = segment;
+      tail_ = segment;
+    }
+    auto idx = tail_->writeIdx.load();
+    new (&tail_->tasks[idx]) Task(std::move(task));
+    tail_->writeIdx.store(idx + 1);
+  }
+
   void deleteSegment(Segment* segment) {
     if (segment == &inlineSegment_) {
       return;
@@ -106,6 +106,13 @@ class SerialExecutorImpl : public SerializedExecutor {
    * for the execution of one of the SerialExecutor's tasks.
    */
   void addWithPriority(Func func, int8_t priority) override;
+
+  /**
+   * Add several tasks, which run in order, with a single enqueue and at most
+   * one task submission to the parent executor
+   */
+  void addBatch(span<Func> funcs) override;
+
   uint8_t getNumPriorities() const override {
     return parent_->getNumPriorities();
   }
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/ThreadPoolAutoscaler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <glog/logging.h>
+
+namespace folly {
+
+///////////// AutoscalingPolicy
+
+AutoscalingPolicy::AutoscalingPolicy(Options options)
+    : options_(std::move(options)) {
+  CHECK_GT(options_.minThreads, 0);
+  CHECK_LE(options_.minThreads, options_.maxThreads);
+  CHECK_GT(options_.targetUtilization, 0);
+  CHECK_GE(options_.maxGrowFactor, 1);
+  CHECK_GE(options_.maxShrinkFraction, 0);
+  CHECK_GT(options_.shrinkAfterIntervals, 0);
+}
+
+AutoscalingPolicy::Decision AutoscalingPolicy::decide(const Sample& sample) {
+  Decision decision;
+  decision.sample = sample;
+  auto const threads = sample.numThreads;
+  decision.oldThreads = threads;
+  decision.newThreads = threads;
+
+  if (sample.dequeuedTasks > 0) {
+    decision.queueDelay = sample.totalQueueDelay / sample.dequeuedTasks;
+  }
+  if (sample.pendingTasks > 0 && sample.dequeuedTasks == 0) {
+    // nothing ran, and something waited for the whole interval
+    decision.queueDelay = std::max(decision.queueDelay, sample.interval);
+  }
+  if (sample.interval.count() > 0) {
+    double const busy = sample.busyTime.count();
+    double const interval = sample.interval.count();
+    if (threads > 0) {
+      decision.utilization = busy / (interval * threads);
+    }
+    // the pending tasks are work the interval should have done too, assuming
+    // they take as long as the tasks that ran
+    double backlog = 0;
+    if (sample.dequeuedTasks > 0) {
+      backlog = sample.pendingTasks * busy / sample.dequeuedTasks;
+    }
+    decision.demand = static_cast<size_t>(
+        std::ceil((busy + backlog) / (interval * options_.targetUtilization)));
+  }
+
+  auto const change = [&](size_t to) {
+    decision.newThreads = to;
+    decision.action = to > threads ? Action::GROW : Action::SHRINK;
+    reset();
+    return decision;
+  };
+
+  if (threads < options_.minThreads) {
+    return change(options_.minThreads);
+  }
+  if (threads > options_.maxThreads) {
+    return change(options_.maxThreads);
+  }
+
+  if (decision.queueDelay > options_.targetQueueDelay) {
+    reset();
+    auto const limit = std::max(
+        threads + 1,
+        static_cast<size_t>(std::floor(threads * options_.maxGrowFactor)));
+    auto const to = std::min(
+        {std::max(threads + 1, decision.demand), limit, options_.maxThreads});
+    if (to > threads) {
+      return change(to);
+    }
+    return decision;
+  }
+
+  auto const quietDelay = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      options_.targetQueueDelay * options_.shrinkDelayFraction);
+  if (decision.queueDelay > quietDelay || decision.demand >= threads) {
+    reset();
+    return decision;
+  }
+
+  quietDemand_ = std::max(quietDemand_, decision.demand);
+  if (++quietIntervals_ < options_.shrinkAfterIntervals) {
+    return decision;
+  }
+  auto const step = std::max<size_t>(
+      1, static_cast<size_t>(threads * options_.maxShrinkFraction));
+  auto const to = std::max(
+      {options_.minThreads, quietDemand_, threads > step ? threads - step : 0});
+  if (to < threads) {
+    return change(to);
+  }
+  reset();
+  return decision;
+}
+
+const char* toString(AutoscalingPolicy::Action action) {
+  switch (action) {
+    case AutoscalingPolicy::Action::HOLD:
+      return "HOLD";
+    case AutoscalingPolicy::Action::GROW:
+      return "GROW";
+    case AutoscalingPolicy::Action::SHRINK:
+      return "SHRINK";
+  }
+  return "UNKNOWN";
+}
+
+///////////// ThreadPoolAutoscaler
+
+struct ThreadPoolAutoscaler::Counters {
+  std::atomic<bool> enabled{true};
+  std::atomic<uint64_t> dequeuedTasks{0};
+  std::atomic<int64_t> queueDelayNs{0};
+  std::atomic<int64_t> runTimeNs{0};
+};
+
+class ThreadPoolAutoscaler::Observer : public ThreadPoolExecutor::TaskObserver {
+ public:
+  explicit Observer(std::shared_ptr<Counters> counters)
+      : counters_(std::move(counters)) {}
+
+  void taskDequeued(
+      const ThreadPoolExecutor::DequeuedTaskInfo& info) noexcept override {
+    if (!counters_->enabled.load(std::memory_order_relaxed)) {
+      return;
+    }
+    counters_->dequeuedTasks.fetch_add(1, std::memory_order_relaxed);
+    counters_->queueDelayNs.fetch_add(
+        info.waitTime.count(), std::memory_order_relaxed);
+  }
+
+  void taskProcessed(
+      const ThreadPoolExecutor::ProcessedTaskInfo& info) noexcept override {
+    if (!counters_->enabled.load(std::memory_order_relaxed)) {
+      return;
+    }
+    counters_->runTimeNs.fetch_add(
+        info.runTime.count(), std::memory_order_relaxed);
+  }
+
+ private:
+  std::shared_ptr<Counters> counters_;
+};
+
+ThreadPoolAutoscaler::ThreadPoolAutoscaler(
+    ThreadPoolExecutor& pool, Options options)
+    : pool_(pool),
+      options_(std::move(options)),
+      policy_(options_.policy),
+      counters_(std::make_shared<Counters>()),
+      lastTick_(std::chrono::steady_clock::now()) {
+  pool_.addTaskObserver(std::make_unique<Observer>(counters_));
+  if (options_.useCpuTime) {
+    lastCpuTime_ = pool_.getUsedCpuTime();
+  }
+  if (options_.interval.count() > 0) {
+    scheduler_.setThreadName("TPAutoscaler");
+    scheduler_.addFunction(
+        [this] { tick(); }, options_.interval, "ThreadPoolAutoscaler");
+    scheduler_.start();
+  }
+}
+
+ThreadPoolAutoscaler::~ThreadPoolAutoscaler() {
+  scheduler_.shutdown();
+  counters_->enabled.store(false, std::memory_order_relaxed);
+}
+
+ThreadPoolAutoscaler::Decision ThreadPoolAutoscaler::tick() {
+  auto const now = std::chrono::steady_clock::now();
+  AutoscalingPolicy::Sample sample;
+  sample.interval = now - lastTick_;
+  lastTick_ = now;
+  sample.numThreads = pool_.numThreads();
+  sample.dequeuedTasks =
+      counters_->dequeuedTasks.exchange(0, std::memory_order_relaxed);
+  sample.totalQueueDelay = std::chrono::nanoseconds(
+      counters_->queueDelayNs.exchange(0, std::memory_order_relaxed));
+  auto const runTime = std::chrono::nanoseconds(
+      counters_->runTimeNs.exchange(0, std::memory_order_relaxed));
+  if (options_.useCpuTime) {
+    auto const cpuTime = pool_.getUsedCpuTime();
+    sample.busyTime = cpuTime - lastCpuTime_;
+    lastCpuTime_ = cpuTime;
+  } else {
+    sample.busyTime = runTime;
+  }
+  sample.pendingTasks = pool_.getPendingTaskCount();
+
+  auto const decision = policy_.decide(sample);
+  if (decision.newThreads != decision.oldThreads) {
+    pool_.setNumThreads(decision.newThreads);
+  }
+  VLOG(decision.action == AutoscalingPolicy::Action::HOLD ? 4 : 1)
+      << "ThreadPoolAutoscaler " << pool_.getName() << ": "
+      << toString(decision.action) << " " << decision.oldThreads << " -> "
+      << decision.newThreads << " threads, queue delay "
+      << decision.queueDelay.count() << "ns, utilization "
+      << decision.utilization << ", demand " << decision.demand;
+
+  stats_.withWLock([&](auto& stats) {
+    ++stats.numDecisions;
+    if (decision.action == AutoscalingPolicy::Action::GROW) {
+      ++stats.numGrows;
+    } else if (decision.action == AutoscalingPolicy::Action::SHRINK) {
+      ++stats.numShrinks;
+    }
+    stats.lastDecision = decision;
+  });
+  if (options_.onDecision) {
+    options_.onDecision(decision);
+  }
+  return decision;
+}
+
+} // namespace folly
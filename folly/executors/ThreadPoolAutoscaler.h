@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <folly/Synchronized.h>
+#include <folly/executors/FunctionScheduler.h>
+#include <folly/executors/ThreadPoolExecutor.h>
+
+namespace folly {
+
+/// AutoscalingPolicy decides how many threads a pool should have, from what
+/// the pool did during the last interval. It aims for a queueing delay below
+/// targetQueueDelay, at a thread utilization around targetUtilization.
+///
+/// The policy grows quickly and shrinks slowly:
+///
+/// - If the average queueing delay of the interval exceeds targetQueueDelay,
+///   it grows at once, to the number of threads the measured work and the
+///   backlog need at targetUtilization, but at least by one thread and at
+///   most by maxGrowFactor.
+/// - It only shrinks after shrinkAfterIntervals consecutive quiet intervals,
+///   in which the delay stayed below targetQueueDelay * shrinkDelayFraction
+///   and the pool needed fewer threads than it had. It then shrinks to the
+///   most threads any of those intervals needed, and by at most
+///   maxShrinkFraction of the pool.
+///
+/// The gap between the grow and shrink conditions, and the quiet window, are
+/// the hysteresis that keeps the pool from flapping under noisy load.
+///
+/// The policy is a pure function of the samples fed to it, so it can be
+/// tested and simulated without a pool; see ThreadPoolAutoscaler for the part
+/// that samples a real pool.
+class AutoscalingPolicy {
+ public:
+  struct Options {
+    Options() {}
+
+    size_t minThreads{1};
+    size_t maxThreads{64};
+
+    /// The queueing delay to stay below, averaged over an interval.
+    std::chrono::nanoseconds targetQueueDelay{std::chrono::milliseconds(5)};
+
+    /// The fraction of time the threads should be busy with tasks. Lower
+    /// values keep more spare threads for bursts.
+    double targetUtilization{0.75};
+
+    /// Limits on the change per decision.
+    double maxGrowFactor{2.0};
+    double maxShrinkFraction{0.25};
+
+    /// Shrinking requires this many quiet intervals in a row, with a queueing
+    /// delay below targetQueueDelay * shrinkDelayFraction.
+    size_t shrinkAfterIntervals{10};
+    double shrinkDelayFraction{0.5};
+  };
+
+  /// What the pool did during one interval.
+  struct Sample {
+    std::chrono::nanoseconds interval{0};
+    /// The number of threads the pool had during the interval.
+    size_t numThreads{0};
+    /// Tasks dequeued during the interval, and their total queueing delay.
+    uint64_t dequeuedTasks{0};
+    std::chrono::nanoseconds totalQueueDelay{0};
+    /// The time threads spent running tasks, or using cpu.
+    std::chrono::nanoseconds busyTime{0};
+    /// Tasks waiting in the queue at the end of the interval.
+    uint64_t pendingTasks{0};
+  };
+
+  enum class Action { HOLD, GROW, SHRINK };
+
+  struct Decision {
+    Action action{Action::HOLD};
+    size_t oldThreads{0};
+    size_t newThreads{0};
+    /// The average queueing delay of the interval. If tasks were pending but
+    /// none was dequeued, the whole interval.
+    std::chrono::nanoseconds queueDelay{0};
+    /// busyTime / (numThreads * interval)
+    double utilization{0};
+    /// The number of threads that would have run the interval's work, and
+    /// the pending tasks, at targetUtilization.
+    size_t demand{0};
+    Sample sample;
+  };
+
+  explicit AutoscalingPolicy(Options options = {});
+
+  const Options& options() const { return options_; }
+
+  /// Decides from the sample of the last interval. Not thread-safe.
+  Decision decide(const Sample& sample);
+
+  /// Forgets the quiet intervals seen so far.
+  void reset() {
+    quietIntervals_ = 0;
+    quietDemand_ = 0;
+  }
+
+ private:
+  Options options_;
+  size_t quietIntervals_{0};
+  size_t quietDemand_{0};
+};
+
+const char* toString(AutoscalingPolicy::Action action);
+
+/// ThreadPoolAutoscaler resizes a ThreadPoolExecutor with AutoscalingPolicy.
+///
+/// It records the queueing delay and run time of every task through a
+/// TaskObserver, and every interval feeds them to the policy and applies its
+/// decision with setNumThreads(). Since the pool's threads are started lazily
+/// and reaped after the thread death timeout, the autoscaler sets an upper
+/// bound that the pool approaches as needed.
+///
+/// Every decision, including HOLD, is passed to Options::onDecision and
+/// counted in getStats(), so scaling can be logged and exported.
+///
+/// The autoscaler must be destroyed before the pool. The TaskObserver stays
+/// installed, as observers cannot be removed, but stops recording.
+class ThreadPoolAutoscaler {
+ public:
+  using Decision = AutoscalingPolicy::Decision;
+
+  struct Options {
+    Options() {}
+
+    AutoscalingPolicy::Options policy;
+
+    /// How often to decide. If 0, no background thread is started, and
+    /// tick() must be called instead.
+    std::chrono::milliseconds interval{100};
+
+    /// Measure busy time with the cpu time of the pool's threads, see
+    /// ThreadPoolExecutor::getUsedCpuTime(), rather than with the run time of
+    /// tasks. Cpu time leaves out tasks that block, so the pool grows past the
+    /// number of cpus for blocking work only when the delay demands it.
+    bool useCpuTime{false};
+
+    /// Called with every decision, from the thread that runs tick().
+    std::function<void(const Decision&)> onDecision;
+  };
+
+  struct Stats {
+    uint64_t numDecisions{0};
+    uint64_t numGrows{0};
+    uint64_t numShrinks{0};
+    Decision lastDecision;
+  };
+
+  explicit ThreadPoolAutoscaler(ThreadPoolExecutor& pool, Options options = {});
+  ~ThreadPoolAutoscaler();
+
+  ThreadPoolAutoscaler(const ThreadPoolAutoscaler&) = delete;
+  ThreadPoolAutoscaler& operator=(const ThreadPoolAutoscaler&) = delete;
+
+  /// Samples the pool since the last tick, and applies the policy's decision.
+  /// Must not be called concurrently with itself.
+  Decision tick();
+
+  Stats getStats() const { return stats_.copy(); }
+
+ private:
+  struct Counters;
+  class Observer;
+
+  ThreadPoolExecutor& pool_;
+  Options options_;
+  AutoscalingPolicy policy_;
+  std::shared_ptr<Counters> counters_;
+  std::chrono::steady_clock::time_point lastTick_;
+  std::chrono::nanoseconds lastCpuTime_{0};
+  Synchronized<Stats> stats_;
+  // Last, so it is stopped before the rest is destroyed.
+  FunctionScheduler scheduler_;
+};
+
+} // namespace folly
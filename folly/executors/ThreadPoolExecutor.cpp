@@ -16,6 +16,7 @@
 
 #include <folly/executors/ThreadPoolExecutor.h>
 
+#include <algorithm>
 #include <ctime>
 
 #include <folly/concurrency/ProcessLocalUniqueId.h>
@@ -522,7 +523,7 @@ bool ThreadPoolExecutor::tryTimeoutThread() {
 // If we can't ensure that we were able to hand off a task to a thread,
 // attempt to start a thread that handled the task, if we aren't already
 // running the maximum number of threads.
-void ThreadPoolExecutor::ensureActiveThreads() {
+void ThreadPoolExecutor::ensureActiveThreads(size_t n) {
   ensureJoined();
 
   // Matches barrier in tryTimeoutThread().  Ensure task added
@@ -544,8 +545,9 @@ void ThreadPoolExecutor::ensureActiveThreads() {
   if (active >= total) {
     return;
   }
-  ThreadPoolExecutor::addThreads(1);
-  activeThreads_.store(active + 1, std::memory_order_relaxed);
+  auto const toAdd = std::min<size_t>(n, total - active);
+  ThreadPoolExecutor::addThreads(toAdd);
+  activeThreads_.store(active + toAdd, std::memory_order_relaxed);
 }
 
 void ThreadPoolExecutor::ensureMaxActiveThreads() {
@@ -49,7 +49,9 @@ namespace folly {
  * On task add(), if an executor can guarantee there is an active
  * thread that will handle the task, then nothing needs to be done.
  * If not, then ensureActiveThreads() should be called to possibly
- * start another pool thread, up to maxThreads_.
+ * start another pool thread, up to maxThreads_. On addBatch(), the
+ * executor may ask for as many threads as there are tasks in the batch
+ * that it could not hand off to an existing thread.
  *
  * ensureJoined() is called on add(), such that we can join idle
  * threads that were destroyed (which can't be joined from
@@ -384,7 +386,8 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
 
   // Dynamic thread sizing functions and variables
   void ensureMaxActiveThreads();
-  void ensureActiveThreads();
+  // Starts up to n more threads, up to maxThreads_.
+  void ensureActiveThreads(size_t n = 1);
   void ensureJoined();
   bool minActive();
   bool tryTimeoutThread();
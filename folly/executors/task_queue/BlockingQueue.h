@@ -24,6 +24,7 @@
 
 #include <folly/CPortability.h>
 #include <folly/Optional.h>
+#include <folly/container/span.h>
 
 namespace folly {
 
@@ -55,6 +56,21 @@ class BlockingQueue {
       T item, int8_t /* priority */) {
     return add(std::move(item));
   }
+  // Adds all items, moving them out of the span, like add() for each of them
+  // in order. Queues may implement this with a single reservation in the
+  // queue and a single semaphore post.
+  //
+  // Returns how many of the items no existing thread was able to work on, for
+  // which a thread pool may start new threads.
+  virtual size_t addBatch(span<T> items) {
+    size_t numNotReused = 0;
+    for (auto& item : items) {
+      if (!add(std::move(item)).reusedThread) {
+        ++numNotReused;
+      }
+    }
+    return numNotReused;
+  }
   virtual uint8_t getNumPriorities() { return 1; }
   virtual T take() = 0;
   virtual folly::Optional<T> try_take_for(std::chrono::milliseconds time) = 0;
@@ -35,19 +35,25 @@ class LifoSemMPMCQueue : public BlockingQueue<T> {
       : sem_(semaphoreOptions), queue_(max_capacity) {}
 
   BlockingQueueAddResult add(T item) override {
-    switch (kBehavior) { // static
-      case QueueBehaviorIfFull::THROW:
-        if (!queue_.writeIfNotFull(std::move(item))) {
-          throw QueueFullException("LifoSemMPMCQueue full, can't add item");
-        }
-        break;
-      case QueueBehaviorIfFull::BLOCK:
-        queue_.blockingWrite(std::move(item));
-        break;
-    }
+    write(std::move(item));
     return sem_.post();
   }
 
+  size_t addBatch(span<T> items) override {
+    uint32_t written = 0;
+    try {
+      for (auto& item : items) {
+        write(std::move(item));
+        ++written;
+      }
+    } catch (...) {
+      // wake consumers for the items that made it into the queue
+      sem_.post(written);
+      throw;
+    }
+    return sem_.post(written);
+  }
+
   T take() override {
     T item;
     while (!queue_.readIfNotEmpty(item)) {
@@ -71,6 +77,19 @@ class LifoSemMPMCQueue : public BlockingQueue<T> {
   size_t size() override { return queue_.size(); }
 
  private:
+  void write(T&& item) {
+    switch (kBehavior) { // static
+      case QueueBehaviorIfFull::THROW:
+        if (!queue_.writeIfNotFull(std::move(item))) {
+          throw QueueFullException("LifoSemMPMCQueue full, can't add item");
+        }
+        break;
+      case QueueBehaviorIfFull::BLOCK:
+        queue_.blockingWrite(std::move(item));
+        break;
+    }
+  }
+
   Semaphore sem_;
   folly::MPMCQueue<T> queue_;
 };
@@ -68,24 +68,25 @@ class PriorityLifoSemMPMCQueue : public BlockingQueue<T> {
   }
 
   BlockingQueueAddResult addWithPriority(T item, int8_t priority) override {
-    int mid = getNumPriorities() / 2;
-    size_t queue = priority < 0
-        ? std::max(0, mid + priority)
-        : std::min(getNumPriorities() - 1, mid + priority);
-    CHECK_LT(queue, queues_.size());
-    switch (kBehavior) { // static
-      case QueueBehaviorIfFull::THROW:
-        if (!queues_[queue].writeIfNotFull(std::move(item))) {
-          throw QueueFullException("LifoSemMPMCQueue full, can't add item");
-        }
-        break;
-      case QueueBehaviorIfFull::BLOCK:
-        queues_[queue].blockingWrite(std::move(item));
-        break;
-    }
+    write(std::move(item), priority);
     return sem_.post();
   }
 
+  size_t addBatch(span<T> items) override {
+    uint32_t written = 0;
+    try {
+      for (auto& item : items) {
+        write(std::move(item), folly::Executor::MID_PRI);
+        ++written;
+      }
+    } catch (...) {
+      // wake consumers for the items that made it into the queue
+      sem_.post(written);
+      throw;
+    }
+    return sem_.post(written);
+  }
+
   T take() override {
     T item;
     while (true) {
@@ -134,6 +135,24 @@ class PriorityLifoSemMPMCQueue : public BlockingQueue<T> {
   }
 
  private:
+  void write(T&& item, int8_t priority) {
+    int mid = getNumPriorities() / 2;
+    size_t queue = priority < 0
+        ? std::max(0, mid + priority)
+        : std::min(getNumPriorities() - 1, mid + priority);
+    CHECK_LT(queue, queues_.size());
+    switch (kBehavior) { // static
+      case QueueBehaviorIfFull::THROW:
+        if (!queues_[queue].writeIfNotFull(std::move(item))) {
+          throw QueueFullException("LifoSemMPMCQueue full, can't add item");
+        }
+        break;
+      case QueueBehaviorIfFull::BLOCK:
+        queues_[queue].blockingWrite(std::move(item));
+        break;
+    }
+  }
+
   Semaphore sem_;
   std::vector<folly::MPMCQueue<T>> queues_;
 };
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <iterator>
+
 #include <folly/ConstexprMath.h>
 #include <folly/Executor.h>
 #include <folly/concurrency/PriorityUnboundedQueueSet.h>
@@ -47,6 +49,14 @@ class PriorityUnboundedBlockingQueue : public BlockingQueue<T> {
     return sem_.post();
   }
 
+  size_t addBatch(span<T> items) override {
+    queue_.at_priority(translatePriority(folly::Executor::MID_PRI))
+        .enqueue_bulk(
+            std::make_move_iterator(items.begin()),
+            std::make_move_iterator(items.end()));
+    return sem_.post(static_cast<uint32_t>(items.size()));
+  }
+
   T take() override {
     sem_.wait();
     return dequeue();
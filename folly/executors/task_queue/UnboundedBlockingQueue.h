@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <iterator>
+
 #include <folly/concurrency/UnboundedQueue.h>
 #include <folly/executors/task_queue/BlockingQueue.h>
 #include <folly/synchronization/LifoSem.h>
@@ -34,6 +36,13 @@ class UnboundedBlockingQueue : public BlockingQueue<T> {
     return sem_.post();
   }
 
+  size_t addBatch(span<T> items) override {
+    queue_.enqueue_bulk(
+        std::make_move_iterator(items.begin()),
+        std::make_move_iterator(items.end()));
+    return sem_.post(static_cast<uint32_t>(items.size()));
+  }
+
   T take() override {
     sem_.wait();
     return queue_.dequeue();
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <vector>
+
+#include <folly/ConstexprMath.h>
+#include <folly/Executor.h>
+#include <folly/ThreadLocal.h>
+#include <folly/concurrency/PriorityUnboundedQueueSet.h>
+#include <folly/concurrency/container/WorkStealingDeque.h>
+#include <folly/concurrency/container/atomic_grow_array.h>
+#include <folly/executors/task_queue/BlockingQueue.h>
+#include <folly/lang/Bits.h>
+#include <folly/portability/Asm.h>
+#include <folly/synchronization/LifoSem.h>
+
+namespace folly {
+
+/// A BlockingQueue that spreads its items over one deque per consumer thread,
+/// for thread pools running many short tasks on many cores, where a single
+/// shared queue and its semaphore become the bottleneck.
+///
+/// Every thread that takes from the queue owns a WorkStealingDeque (per
+/// priority). Items added by such a thread go to its own deque, and it takes
+/// them back in LIFO order, without touching shared cache lines. Items added
+/// by other threads go to a shared FIFO injection queue. A thread whose own
+/// deque is empty takes from the injection queue, and then steals from the
+/// deques of the other threads, starting at a random one.
+///
+/// Higher priorities are searched first, in all three places, so priorities
+/// are respected for each thread's search but not strictly across threads.
+///
+/// A consumer only sleeps on the semaphore after it found nothing to take,
+/// and producers only post to it when a consumer sleeps, so a busy pool does
+/// no semaphore operations at all.
+///
+/// Items added from outside, including the poison tasks that
+/// ThreadPoolExecutor uses to stop threads, stay FIFO. A consumer only takes
+/// from the injection queue once its own deque is empty, so a thread that
+/// takes its poison leaves nothing behind, and join() still runs every task
+/// added before it.
+///
+/// A thread that stops taking items, for example because the pool shrank,
+/// may leave items in its deque; they are stolen by the other threads, or
+/// popped by the next thread that takes over the deque.
+template <class T, class Semaphore = folly::LifoSem>
+class WorkStealingBlockingQueue : public BlockingQueue<T> {
+ public:
+  // Note: To use folly::Executor::*_PRI, for numPriorities == 2
+  //       MID_PRI and HI_PRI are treated at the same priority level.
+  explicit WorkStealingBlockingQueue(
+      uint8_t numPriorities = 1,
+      const typename Semaphore::Options& semaphoreOptions = {})
+      : sem_(semaphoreOptions),
+        injected_(numPriorities),
+        workers_(WorkerPolicy{numPriorities}) {
+    CHECK_GT(numPriorities, 0) << "Number of priorities should be positive";
+  }
+
+  uint8_t getNumPriorities() override { return injected_.priorities(); }
+
+  // Add at medium priority by default
+  BlockingQueueAddResult add(T item) override {
+    return addWithPriority(std::move(item), folly::Executor::MID_PRI);
+  }
+
+  BlockingQueueAddResult addWithPriority(T item, int8_t priority) override {
+    auto const pri = translatePriority(priority);
+    if (auto self = local_.get()) {
+      self->worker->deques[pri].push(std::move(item));
+    } else {
+      injected_.at_priority(pri).enqueue(std::move(item));
+    }
+    // Pairs with the fence in takeUntil(): either a consumer going to sleep
+    // sees the item, or we see the consumer.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return wakeOne();
+  }
+
+  size_t addBatch(span<T> items) override {
+    auto const pri = translatePriority(folly::Executor::MID_PRI);
+    if (auto self = local_.get()) {
+      for (auto& item : items) {
+        self->worker->deques[pri].push(std::move(item));
+      }
+    } else {
+      injected_.at_priority(pri).enqueue_bulk(
+          std::make_move_iterator(items.begin()),
+          std::make_move_iterator(items.end()));
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return wakeUpTo(items.size());
+  }
+
+  T take() override {
+    return std::move(*takeUntil(std::chrono::steady_clock::time_point::max()));
+  }
+
+  folly::Optional<T> try_take_for(std::chrono::milliseconds time) override {
+    return takeUntil(std::chrono::steady_clock::now() + time);
+  }
+
+  size_t size() override {
+    size_t n = injected_.size();
+    auto workers = workers_.as_view();
+    for (size_t i = 0; i < workers.size(); ++i) {
+      for (auto& deque : workers[i].deques) {
+        n += deque.size();
+      }
+    }
+    return n;
+  }
+
+ private:
+  // Rounds of searching before a consumer goes to sleep.
+  static constexpr size_t kSpinRounds = 16;
+
+  struct Worker {
+    explicit Worker(size_t numPriorities) : deques(numPriorities) {}
+
+    std::atomic<bool> owned{false};
+    std::vector<WorkStealingDeque<T>> deques;
+  };
+
+  struct WorkerPolicy {
+    size_t numPriorities;
+
+    size_t grow(size_t /* curr */, size_t index) const noexcept {
+      return nextPowTwo(index + 1);
+    }
+    Worker make() const { return Worker(numPriorities); }
+  };
+
+  // The deque a consumer thread owns, released when the thread exits.
+  struct Registration {
+    Registration(WorkStealingBlockingQueue& q, Worker& w, uint32_t seed)
+        : queue(q), worker(&w), rng(seed) {}
+
+    ~Registration() {
+      bool leftover = false;
+      for (auto& deque : worker->deques) {
+        leftover = leftover || !deque.empty();
+      }
+      worker->owned.store(false, std::memory_order_release);
+      if (leftover) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        queue.wakeOne();
+      }
+    }
+
+    uint32_t nextRandom() {
+      // xorshift32
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      return rng;
+    }
+
+    WorkStealingBlockingQueue& queue;
+    Worker* worker;
+    uint32_t rng;
+  };
+
+  size_t translatePriority(int8_t const priority) {
+    size_t const priorities = injected_.priorities();
+    assert(priorities <= 255);
+    int8_t const hi = (priorities + 1) / 2 - 1;
+    int8_t const lo = hi - (priorities - 1);
+    return hi - constexpr_clamp(priority, lo, hi);
+  }
+
+  Registration& registration() {
+    if (auto self = local_.get()) {
+      return *self;
+    }
+    for (size_t i = 0;; ++i) {
+      auto& worker = workers_[i];
+      bool expected = false;
+      if (!worker.owned.load(std::memory_order_relaxed) &&
+          worker.owned.compare_exchange_strong(
+              expected,
+              true,
+              std::memory_order_acquire,
+              std::memory_order_relaxed)) {
+        local_.reset(new Registration(*this, worker, uint32_t(i) * 2 + 1));
+        return *local_;
+      }
+    }
+  }
+
+  folly::Optional<T> tryTake(Registration& self) {
+    for (size_t pri = 0; pri < injected_.priorities(); ++pri) {
+      if (auto item = self.worker->deques[pri].pop()) {
+        return item;
+      }
+      if (auto item = injected_.at_priority(pri).try_dequeue()) {
+        return item;
+      }
+      if (auto item = steal(self, pri)) {
+        return item;
+      }
+    }
+    return none;
+  }
+
+  folly::Optional<T> steal(Registration& self, size_t pri) {
+    auto workers = workers_.as_view();
+    auto const n = workers.size();
+    if (n < 2) {
+      return none;
+    }
+    auto const start = self.nextRandom() % n;
+    for (size_t i = 0; i < n; ++i) {
+      auto& victim = workers[(start + i) % n];
+      if (&victim == self.worker) {
+        continue;
+      }
+      auto& deque = victim.deques[pri];
+      // a failed steal may have lost a race, retry until the deque is empty
+      while (!deque.empty()) {
+        if (auto item = deque.steal()) {
+          return item;
+        }
+      }
+    }
+    return none;
+  }
+
+  folly::Optional<T> takeUntil(std::chrono::steady_clock::time_point deadline) {
+    auto& self = registration();
+    while (true) {
+      for (size_t i = 0; i < kSpinRounds; ++i) {
+        if (auto item = tryTake(self)) {
+          return item;
+        }
+        asm_volatile_pause();
+      }
+
+      idle_.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (auto item = tryTake(self)) {
+        if (!tryUnidle()) {
+          // A producer already posted for us, pass the wakeup on.
+          sem_.wait();
+          wakeOne();
+        }
+        return item;
+      }
+      if (!sem_.try_wait_until(deadline)) {
+        if (tryUnidle()) {
+          return none;
+        }
+        // A producer claimed us after the timeout, consume its post.
+        sem_.wait();
+      }
+    }
+  }
+
+  // Leaves the idle state on our own, unless a producer claimed every idle
+  // consumer, including us.
+  bool tryUnidle() {
+    auto idle = idle_.load(std::memory_order_relaxed);
+    while (idle > 0) {
+      if (idle_.compare_exchange_weak(
+              idle, idle - 1, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Wakes one idle consumer, if any. Must follow a seq_cst fence.
+  bool wakeOne() {
+    if (!tryUnidle()) {
+      return false;
+    }
+    sem_.post();
+    return true;
+  }
+
+  // Wakes min(n, idle) idle consumers, and returns how many of the n were left
+  // without one. Must follow a seq_cst fence.
+  size_t wakeUpTo(size_t n) {
+    auto idle = idle_.load(std::memory_order_relaxed);
+    size_t claimed = 0;
+    while (idle > 0 && n > 0) {
+      claimed = std::min(n, idle);
+      if (idle_.compare_exchange_weak(
+              idle, idle - claimed, std::memory_order_relaxed)) {
+        break;
+      }
+      claimed = 0;
+    }
+    if (claimed > 0) {
+      sem_.post(static_cast<uint32_t>(claimed));
+    }
+    return n - claimed;
+  }
+
+  Semaphore sem_;
+  // The number of consumers that are, or are about to be, waiting on sem_.
+  // Each one either decrements idle_ itself or consumes a post from sem_.
+  alignas(hardware_destructive_interference_size) std::atomic<size_t> idle_{0};
+  PriorityUMPMCQueueSet<T, /* MayBlock = */ false> injected_;
+  atomic_grow_array<Worker, WorkerPolicy> workers_;
+  // Destroyed first, releasing the workers.
+  ThreadLocalPtr<Registration> local_;
+};
+
+} // namespace folly
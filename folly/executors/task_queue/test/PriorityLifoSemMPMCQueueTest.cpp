@@ -37,3 +37,19 @@ TEST(PriorityLifoSemMPMCQueue, Capacities) {
     EXPECT_THROW(q.addWithPriority(0, pri), QueueFullException) << *capacity;
   }
 }
+
+TEST(PriorityLifoSemMPMCQueue, AddBatch) {
+  const std::vector<size_t> capacities = {1, 2, 3};
+  PriorityLifoSemMPMCQueue<int, QueueBehaviorIfFull::THROW> q(
+      folly::range(capacities));
+
+  q.addWithPriority(42, Executor::HI_PRI);
+  std::vector<int> items = {1, 2, 3};
+  // the batch goes to the mid priority, which only has room for two items
+  EXPECT_THROW(q.addBatch(items), QueueFullException);
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(42, q.take());
+  EXPECT_EQ(1, q.take());
+  EXPECT_EQ(2, q.take());
+  EXPECT_FALSE(q.try_take_for(std::chrono::milliseconds(0)));
+}
@@ -80,6 +80,20 @@ TEST_F(PriorityUnboundedBlockingQueueTest, priority_order) {
   EXPECT_EQ(0, q.size());
 }
 
+TEST_F(PriorityUnboundedBlockingQueueTest, add_batch) {
+  PriorityUnboundedBlockingQueue<int> q(3);
+  q.addWithPriority(12, -1);
+  q.addWithPriority(42, 1);
+  std::vector<int> items = {27, 55};
+  EXPECT_EQ(2, q.addBatch(items));
+  EXPECT_EQ(4, q.size());
+  EXPECT_EQ(42, q.take());
+  EXPECT_EQ(27, q.take());
+  EXPECT_EQ(55, q.take());
+  EXPECT_EQ(12, q.take());
+  EXPECT_EQ(0, q.size());
+}
+
 // Since PriorityUnboundedBlockingQueue implements folly::BlockingQueue<T>,
 // addWithPriority method has to accept priority as int_8. This means invalid
 // values for priority (such as negative or very large numbers) might get
@@ -16,7 +16,9 @@
 
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
 
+#include <atomic>
 #include <thread>
+#include <vector>
 
 #include <folly/portability/GTest.h>
 #include <folly/synchronization/Baton.h>
@@ -52,3 +54,35 @@ TEST(UnboundedBlockingQueue, concurrentPushPop) {
   EXPECT_EQ(0, q.size());
   t.join();
 }
+
+TEST(UnboundedBlockingQueue, addBatch) {
+  UnboundedBlockingQueue<int> q;
+  std::vector<int> items = {1, 2, 3};
+  // without waiting consumers, no item is handed off
+  EXPECT_EQ(3, q.addBatch(items));
+  EXPECT_EQ(0, q.addBatch({}));
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(1, q.take());
+  EXPECT_EQ(2, q.take());
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(UnboundedBlockingQueue, addBatchWakesConsumers) {
+  constexpr int kConsumers = 4;
+  UnboundedBlockingQueue<int> q;
+  std::atomic<int> sum(0);
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < kConsumers; ++i) {
+    consumers.emplace_back([&] { sum += q.take(); });
+  }
+  /* sleep override */ std::this_thread::sleep_for(
+      std::chrono::milliseconds(10));
+  std::vector<int> items = {1, 2, 3, 4};
+  q.addBatch(items);
+  for (auto& t : consumers) {
+    t.join();
+  }
+  EXPECT_EQ(10, sum);
+  EXPECT_EQ(0, q.size());
+}
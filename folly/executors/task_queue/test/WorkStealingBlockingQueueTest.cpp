@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/task_queue/WorkStealingBlockingQueue.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+TEST(WorkStealingBlockingQueue, pushPop) {
+  WorkStealingBlockingQueue<int> q;
+  q.add(42);
+  q.add(77);
+  EXPECT_EQ(42, q.take());
+  EXPECT_EQ(77, q.take());
+}
+
+TEST(WorkStealingBlockingQueue, size) {
+  WorkStealingBlockingQueue<int> q;
+  EXPECT_EQ(0, q.size());
+  q.add(42);
+  EXPECT_EQ(1, q.size());
+  q.take();
+  EXPECT_EQ(0, q.size());
+  // now a consumer, so this goes to its own deque
+  q.add(43);
+  EXPECT_EQ(1, q.size());
+  q.take();
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(WorkStealingBlockingQueue, timeout) {
+  WorkStealingBlockingQueue<int> q;
+  EXPECT_FALSE(q.try_take_for(std::chrono::milliseconds(1)).has_value());
+  q.add(1);
+  EXPECT_EQ(1, q.try_take_for(std::chrono::milliseconds(1)));
+}
+
+TEST(WorkStealingBlockingQueue, localItemsAreLifo) {
+  WorkStealingBlockingQueue<int> q;
+  q.add(0);
+  EXPECT_EQ(0, q.take());
+  for (int i = 1; i <= 3; ++i) {
+    q.add(i);
+  }
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(2, q.take());
+  EXPECT_EQ(1, q.take());
+}
+
+TEST(WorkStealingBlockingQueue, priorityOrder) {
+  WorkStealingBlockingQueue<int> q(3);
+  EXPECT_EQ(3, q.getNumPriorities());
+  q.addWithPriority(27, 0);
+  q.addWithPriority(42, 1);
+  q.addWithPriority(55, 0);
+  q.addWithPriority(12, -1);
+  q.addWithPriority(99, Executor::HI_PRI);
+  EXPECT_EQ(5, q.size());
+  EXPECT_EQ(42, q.take());
+  EXPECT_EQ(99, q.take());
+  EXPECT_EQ(27, q.take());
+  EXPECT_EQ(55, q.take());
+  EXPECT_EQ(12, q.take());
+
+  // same for items in the consumer's own deque
+  q.addWithPriority(1, Executor::LO_PRI);
+  q.addWithPriority(2, Executor::HI_PRI);
+  q.addWithPriority(3, Executor::MID_PRI);
+  EXPECT_EQ(2, q.take());
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(1, q.take());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(WorkStealingBlockingQueue, wakesSleepingConsumer) {
+  WorkStealingBlockingQueue<int> q;
+  Baton<> b1, b2;
+  std::thread t([&] {
+    b1.post();
+    EXPECT_EQ(42, q.take());
+    EXPECT_EQ(0, q.size());
+    b2.post();
+  });
+  b1.wait();
+  /* sleep override */ std::this_thread::sleep_for(
+      std::chrono::milliseconds(10));
+  q.add(42);
+  b2.wait();
+  EXPECT_EQ(0, q.size());
+  t.join();
+}
+
+TEST(WorkStealingBlockingQueue, addBatch) {
+  WorkStealingBlockingQueue<int> q;
+  std::vector<int> items = {1, 2, 3};
+  std::thread([&] { EXPECT_EQ(3, q.addBatch(items)); }).join();
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(1, q.take());
+  // a consumer adds its batch to its own deque
+  items = {4, 5};
+  q.addBatch(items);
+  EXPECT_EQ(5, q.take());
+  EXPECT_EQ(4, q.take());
+  EXPECT_EQ(2, q.take());
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(WorkStealingBlockingQueue, addBatchWakesConsumers) {
+  constexpr int kConsumers = 4;
+  WorkStealingBlockingQueue<int> q;
+  std::atomic<int> sum(0);
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < kConsumers; ++i) {
+    consumers.emplace_back([&] { sum += q.take(); });
+  }
+  /* sleep override */ std::this_thread::sleep_for(
+      std::chrono::milliseconds(10));
+  std::vector<int> items = {1, 2, 3, 4};
+  q.addBatch(items);
+  for (auto& t : consumers) {
+    t.join();
+  }
+  EXPECT_EQ(10, sum);
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(WorkStealingBlockingQueue, stealsFromOtherConsumers) {
+  WorkStealingBlockingQueue<int> q;
+  Baton<> filled, stolen;
+  std::thread owner([&] {
+    q.add(0);
+    EXPECT_EQ(0, q.take());
+    for (int i = 1; i <= 100; ++i) {
+      q.add(i);
+    }
+    filled.post();
+    stolen.wait();
+  });
+  filled.wait();
+  // thieves take from the top, oldest first
+  for (int i = 1; i <= 100; ++i) {
+    EXPECT_EQ(i, q.take());
+  }
+  stolen.post();
+  owner.join();
+}
+
+TEST(WorkStealingBlockingQueue, leftoversOfExitedConsumer) {
+  WorkStealingBlockingQueue<int> q;
+  std::thread([&] {
+    q.add(0);
+    EXPECT_EQ(0, q.take());
+    q.add(1);
+    q.add(2);
+  }).join();
+  EXPECT_EQ(2, q.size());
+  // this thread takes over the released deque, and pops it
+  EXPECT_EQ(2, q.take());
+  EXPECT_EQ(1, q.take());
+}
+
+TEST(WorkStealingBlockingQueue, concurrentProducersAndConsumers) {
+  constexpr int kConsumers = 8;
+  constexpr int kProducers = 2;
+  constexpr int kItems = 20000;
+  WorkStealingBlockingQueue<int> q(2);
+  std::vector<std::atomic<int>> taken(kItems * kProducers * 2);
+  std::atomic<int> remaining(kItems * kProducers * 2);
+
+  // Consumers re-add every item they take from outside as a local item, so
+  // that local pushes, pops, steals and external adds all race.
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumers; ++c) {
+    consumers.emplace_back([&] {
+      while (true) {
+        auto v = q.take();
+        if (v < 0) {
+          return;
+        }
+        taken[v].fetch_add(1);
+        if (v % 2 == 0) {
+          q.addWithPriority(v + 1, Executor::LO_PRI);
+        }
+        if (remaining.fetch_sub(1) == 1) {
+          for (int i = 0; i < kConsumers; ++i) {
+            q.add(-1);
+          }
+        }
+      }
+    });
+  }
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < kItems; ++i) {
+        q.addWithPriority(2 * (p * kItems + i), Executor::HI_PRI);
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  for (auto& t : consumers) {
+    t.join();
+  }
+  for (size_t i = 0; i < taken.size(); ++i) {
+    ASSERT_EQ(1, taken[i].load()) << i;
+  }
+  EXPECT_EQ(0, q.size());
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/init/Init.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+// Use 19 threads because it's common to use 0.8 * numCores, and 24 is a common
+// number of cores.
+static constexpr size_t kNumThreads = 19;
+
+static std::unique_ptr<CPUThreadPoolExecutor> makeDefault() {
+  return std::make_unique<CPUThreadPoolExecutor>(kNumThreads);
+}
+
+static std::unique_ptr<CPUThreadPoolExecutor> makeWorkStealing() {
+  return std::make_unique<CPUThreadPoolExecutor>(
+      kNumThreads, CPUThreadPoolExecutor::makeWorkStealingQueue());
+}
+
+// Tasks added from outside the pool, where both queues share one FIFO queue.
+void externalAdd(
+    uint32_t n, std::unique_ptr<CPUThreadPoolExecutor> ex, size_t producers) {
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (uint32_t i = p; i < n; i += producers) {
+        ex->add([] {});
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ex->join();
+}
+
+BENCHMARK_NAMED_PARAM(externalAdd, Default_1, makeDefault(), 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    externalAdd, WorkStealing_1, makeWorkStealing(), 1)
+BENCHMARK_NAMED_PARAM(externalAdd, Default_4, makeDefault(), 4)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    externalAdd, WorkStealing_4, makeWorkStealing(), 4)
+
+BENCHMARK_DRAW_LINE();
+
+// Tasks that add further tasks, as in a recursive fork-join computation: each
+// of kRoots root tasks spawns a binary tree of tasks from the pool's threads.
+void fanOut(uint32_t n, std::unique_ptr<CPUThreadPoolExecutor> ex) {
+  static constexpr size_t kRoots = 64;
+  auto const perRoot = std::max<uint32_t>(n / kRoots, 1);
+  std::atomic<size_t> pending{kRoots * perRoot};
+  Baton<> done;
+
+  struct Spawn {
+    CPUThreadPoolExecutor& ex;
+    std::atomic<size_t>& pending;
+    Baton<>& done;
+
+    // Runs the tasks [begin, end), splitting the range in halves.
+    void operator()(uint32_t begin, uint32_t end) const {
+      while (end - begin > 1) {
+        auto const mid = begin + (end - begin) / 2;
+        ex.add([self = *this, mid, end] { self(mid, end); });
+        end = mid;
+      }
+      if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        done.post();
+      }
+    }
+  };
+
+  Spawn spawn{*ex, pending, done};
+  for (size_t r = 0; r < kRoots; ++r) {
+    ex->add([=] { spawn(0, perRoot); });
+  }
+  done.wait();
+  ex->join();
+}
+
+BENCHMARK_NAMED_PARAM(fanOut, Default, makeDefault())
+BENCHMARK_RELATIVE_NAMED_PARAM(fanOut, WorkStealing, makeWorkStealing())
+
+int main(int argc, char* argv[]) {
+  folly::Init init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
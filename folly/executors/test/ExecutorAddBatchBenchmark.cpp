@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/EDFThreadPoolExecutor.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/executors/SerialExecutor.h>
+#include <folly/init/Init.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+// Use 19 threads because it's common to use 0.8 * numCores, and 24 is a common
+// number of cores.
+static constexpr size_t kNumThreads = 19;
+
+// Every root task fans out to this many small tasks, as a request handler that
+// scatters a request over shards would.
+static constexpr size_t kFanOut = 32;
+
+static std::unique_ptr<ThreadPoolExecutor> makeDefault() {
+  return std::make_unique<CPUThreadPoolExecutor>(kNumThreads);
+}
+
+static std::unique_ptr<ThreadPoolExecutor> makeLifoSem() {
+  return std::make_unique<CPUThreadPoolExecutor>(
+      kNumThreads, CPUThreadPoolExecutor::makeLifoSemQueue());
+}
+
+static std::unique_ptr<ThreadPoolExecutor> makeWorkStealing() {
+  return std::make_unique<CPUThreadPoolExecutor>(
+      kNumThreads, CPUThreadPoolExecutor::makeWorkStealingQueue());
+}
+
+static std::unique_ptr<ThreadPoolExecutor> makeIO() {
+  return std::make_unique<IOThreadPoolExecutor>(kNumThreads);
+}
+
+static std::unique_ptr<ThreadPoolExecutor> makeEDF() {
+  return std::make_unique<EDFThreadPoolExecutor>(kNumThreads);
+}
+
+// Runs roots * kFanOut tasks: the root tasks are added from outside the
+// executor, and each adds kFanOut leaf tasks, one at a time or as a batch.
+void runFanOut(Executor::KeepAlive<> ex, uint32_t roots, bool batch) {
+  std::atomic<size_t> pending{roots * kFanOut};
+  Baton<> done;
+  auto const leaf = [&] {
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      done.post();
+    }
+  };
+  for (uint32_t r = 0; r < roots; ++r) {
+    ex->add([&] {
+      std::vector<Func> leaves(kFanOut);
+      for (auto& func : leaves) {
+        func = leaf;
+      }
+      if (batch) {
+        ex->addBatch(leaves);
+      } else {
+        for (auto& func : leaves) {
+          ex->add(std::move(func));
+        }
+      }
+    });
+  }
+  done.wait();
+}
+
+// Runs n tasks in total, on a pool whose threads are all started. If serial,
+// the tasks are added to a SerialExecutor on top of the pool.
+void fanOut(
+    uint32_t n,
+    std::unique_ptr<ThreadPoolExecutor> (*makePool)(),
+    bool serial,
+    bool batch) {
+  BenchmarkSuspender suspender;
+  auto pool = makePool();
+  Executor::KeepAlive<> ex = serial
+      ? Executor::KeepAlive<>(SerialExecutor::create(pool.get()))
+      : getKeepAliveToken(pool.get());
+  runFanOut(ex, kNumThreads, batch);
+
+  suspender.dismissing([&] {
+    runFanOut(ex, std::max<uint32_t>(n / kFanOut, 1), batch);
+  });
+
+  ex = {};
+  pool->join();
+}
+
+BENCHMARK_NAMED_PARAM(fanOut, Default_add, makeDefault, false, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fanOut, Default_addBatch, makeDefault, false, true)
+BENCHMARK_NAMED_PARAM(fanOut, LifoSem_add, makeLifoSem, false, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fanOut, LifoSem_addBatch, makeLifoSem, false, true)
+BENCHMARK_NAMED_PARAM(fanOut, WorkStealing_add, makeWorkStealing, false, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fanOut, WorkStealing_addBatch, makeWorkStealing, false, true)
+BENCHMARK_NAMED_PARAM(fanOut, IO_add, makeIO, false, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(fanOut, IO_addBatch, makeIO, false, true)
+BENCHMARK_NAMED_PARAM(fanOut, EDF_add, makeEDF, false, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(fanOut, EDF_addBatch, makeEDF, false, true)
+BENCHMARK_NAMED_PARAM(fanOut, Serial_add, makeDefault, true, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    fanOut, Serial_addBatch, makeDefault, true, true)
+
+int main(int argc, char* argv[]) {
+  folly::Init init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
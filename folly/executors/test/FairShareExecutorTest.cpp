@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/FairShareExecutor.h>
+
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/Time.h>
+#include <folly/synchronization/Latch.h>
+
+using namespace folly;
+using namespace std::chrono_literals;
+using NodeId = FairShareExecutor::NodeId;
+
+namespace {
+
+std::chrono::nanoseconds threadCpuTime() {
+  timespec tp{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tp);
+  return std::chrono::seconds(tp.tv_sec) + std::chrono::nanoseconds(tp.tv_nsec);
+}
+
+// Uses the given cpu time, which is what tasks are charged, however loaded the
+// machine is.
+void spin(std::chrono::nanoseconds duration) {
+  auto const end = threadCpuTime() + duration;
+  while (threadCpuTime() < end) {
+  }
+}
+
+FairShareExecutor::Options withQuantum(std::chrono::nanoseconds quantum) {
+  FairShareExecutor::Options options;
+  options.quantum = quantum;
+  return options;
+}
+
+// Adds n tasks to each tenant, which spin for the given time and append their
+// tenant to order.
+void addSpinning(
+    FairShareExecutor& fse,
+    const std::vector<NodeId>& tenants,
+    size_t n,
+    std::chrono::nanoseconds duration,
+    std::vector<NodeId>& order) {
+  for (auto tenant : tenants) {
+    auto ex = fse.getTenant(tenant);
+    for (size_t i = 0; i < n; ++i) {
+      ex->add([&order, tenant, duration] {
+        spin(duration);
+        order.push_back(tenant);
+      });
+    }
+  }
+}
+
+std::map<NodeId, size_t> countFirst(
+    const std::vector<NodeId>& order, size_t n) {
+  std::map<NodeId, size_t> counts;
+  for (size_t i = 0; i < n && i < order.size(); ++i) {
+    ++counts[order[i]];
+  }
+  return counts;
+}
+
+} // namespace
+
+TEST(FairShareExecutorTest, DefaultTenant) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual));
+
+  int ran = 0;
+  for (int i = 0; i < 10; ++i) {
+    fse.add([&] { ++ran; });
+  }
+  EXPECT_EQ(10, fse.pendingTasks());
+  manual.drain();
+  EXPECT_EQ(10, ran);
+  EXPECT_EQ(0, fse.pendingTasks());
+
+  auto stats = fse.getStats(FairShareExecutor::kDefaultTenant);
+  EXPECT_TRUE(stats.isTenant);
+  EXPECT_EQ("default", stats.name);
+  EXPECT_EQ(1, stats.weight);
+  EXPECT_EQ(10, stats.addedTasks);
+  EXPECT_EQ(10, stats.executedTasks);
+  EXPECT_EQ(0, stats.pendingTasks);
+  auto root = fse.getStats(FairShareExecutor::kRoot);
+  EXPECT_FALSE(root.isTenant);
+  EXPECT_EQ(10, root.executedTasks);
+}
+
+TEST(FairShareExecutorTest, NoisyTenantDoesNotStarveOthers) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual), withQuantum(1us));
+  auto noisy = fse.addTenant("noisy", 1);
+  auto quiet = fse.addTenant("quiet", 1);
+
+  std::vector<NodeId> order;
+  addSpinning(fse, {noisy}, 100, 10us, order);
+  addSpinning(fse, {quiet}, 1, 10us, order);
+  manual.drain();
+
+  ASSERT_EQ(101, order.size());
+  // The noisy tenant uses up its quantum with its first task.
+  EXPECT_EQ(quiet, order[1]);
+}
+
+TEST(FairShareExecutorTest, WeightedShares) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual), withQuantum(100us));
+  auto heavy = fse.addTenant("heavy", 3);
+  auto light = fse.addTenant("light", 1);
+
+  std::vector<NodeId> order;
+  addSpinning(fse, {heavy, light}, 400, 20us, order);
+  manual.drain();
+
+  ASSERT_EQ(800, order.size());
+  // While both have tasks, heavy gets 3/4 of the time.
+  auto counts = countFirst(order, 400);
+  EXPECT_NEAR(300, counts[heavy], 30);
+  EXPECT_NEAR(100, counts[light], 30);
+}
+
+TEST(FairShareExecutorTest, NestedGroups) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual), withQuantum(100us));
+  auto group = fse.addGroup("group", 2);
+  auto a = fse.addTenant("a", 1, group);
+  auto b = fse.addTenant("b", 3, group);
+  auto c = fse.addTenant("c", 1);
+
+  std::vector<NodeId> order;
+  addSpinning(fse, {a, b, c}, 300, 20us, order);
+  manual.drain();
+
+  ASSERT_EQ(900, order.size());
+  // The group gets 2/3, split 1:3 between a and b, and c gets 1/3.
+  auto counts = countFirst(order, 360);
+  EXPECT_NEAR(60, counts[a], 25);
+  EXPECT_NEAR(180, counts[b], 30);
+  EXPECT_NEAR(120, counts[c], 30);
+
+  auto groupStats = fse.getStats(group);
+  EXPECT_FALSE(groupStats.isTenant);
+  EXPECT_EQ(FairShareExecutor::kRoot, groupStats.parent);
+  EXPECT_EQ(600, groupStats.executedTasks);
+  EXPECT_EQ(fse.getStats(a).usage + fse.getStats(b).usage, groupStats.usage);
+}
+
+TEST(FairShareExecutorTest, IdleTenantDoesNotBankCredit) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual), withQuantum(100us));
+  auto early = fse.addTenant("early", 1);
+  auto late = fse.addTenant("late", 1);
+
+  std::vector<NodeId> order;
+  addSpinning(fse, {late}, 1, 10us, order);
+  manual.drain();
+  // late left with credit, which it must not have kept.
+  order.clear();
+  addSpinning(fse, {early, late}, 200, 20us, order);
+  manual.drain();
+
+  auto counts = countFirst(order, 200);
+  EXPECT_NEAR(100, counts[early], 20);
+  EXPECT_NEAR(100, counts[late], 20);
+}
+
+TEST(FairShareExecutorTest, ChargesCpuTime) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual), withQuantum(100us));
+  auto sleeping = fse.addTenant("sleeping", 1);
+  auto spinning = fse.addTenant("spinning", 1);
+
+  std::vector<NodeId> order;
+  for (int i = 0; i < 100; ++i) {
+    fse.getTenant(sleeping)->add([&] {
+      /* sleep override */ std::this_thread::sleep_for(200us);
+      order.push_back(sleeping);
+    });
+  }
+  addSpinning(fse, {spinning}, 100, 200us, order);
+  manual.drain();
+
+  // Sleeping costs little cpu, so the sleeping tenant runs most of its tasks
+  // first.
+  auto counts = countFirst(order, 100);
+  EXPECT_GT(counts[sleeping], 2 * counts[spinning]);
+  EXPECT_LT(fse.getStats(sleeping).usage * 2, fse.getStats(spinning).usage);
+}
+
+TEST(FairShareExecutorTest, SetWeight) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual), withQuantum(100us));
+  auto a = fse.addTenant("a", 1);
+  auto b = fse.addTenant("b", 1);
+  fse.setWeight(b, 4);
+  EXPECT_EQ(4, fse.getStats(b).weight);
+
+  std::vector<NodeId> order;
+  addSpinning(fse, {a, b}, 300, 20us, order);
+  manual.drain();
+
+  auto counts = countFirst(order, 300);
+  EXPECT_NEAR(60, counts[a], 25);
+  EXPECT_NEAR(240, counts[b], 25);
+}
+
+TEST(FairShareExecutorTest, Stats) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual));
+  auto group = fse.addGroup("group", 1);
+  auto tenant = fse.addTenant("tenant", 2, group);
+
+  for (int i = 0; i < 5; ++i) {
+    fse.getTenant(tenant)->add([] { spin(100us); });
+  }
+  /* sleep override */ std::this_thread::sleep_for(1ms);
+  auto stats = fse.getStats(tenant);
+  EXPECT_EQ(5, stats.addedTasks);
+  EXPECT_EQ(5, stats.pendingTasks);
+  EXPECT_EQ(0, stats.executedTasks);
+  EXPECT_EQ(5, fse.getStats(group).pendingTasks);
+  EXPECT_EQ(5, fse.getStats(FairShareExecutor::kRoot).pendingTasks);
+
+  manual.drain();
+  stats = fse.getStats(tenant);
+  EXPECT_EQ(tenant, stats.id);
+  EXPECT_EQ(group, stats.parent);
+  EXPECT_EQ("tenant", stats.name);
+  EXPECT_EQ(2, stats.weight);
+  EXPECT_EQ(0, stats.pendingTasks);
+  EXPECT_EQ(5, stats.executedTasks);
+  EXPECT_GE(stats.maxQueueDelay, 1ms);
+  EXPECT_GE(stats.totalQueueDelay, 5 * stats.maxQueueDelay / 2);
+  EXPECT_GT(stats.usage, 0ns);
+
+  auto all = fse.getAllStats();
+  ASSERT_EQ(4, all.size());
+  EXPECT_EQ("root", all[FairShareExecutor::kRoot].name);
+  EXPECT_EQ("default", all[FairShareExecutor::kDefaultTenant].name);
+  EXPECT_EQ(stats.usage, all[group].usage);
+  EXPECT_EQ(stats.usage, all[FairShareExecutor::kRoot].usage);
+  EXPECT_EQ(0, all[FairShareExecutor::kDefaultTenant].addedTasks);
+}
+
+TEST(FairShareExecutorTest, RequestContext) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual));
+  auto tenant = fse.addTenant("tenant", 1);
+
+  RequestContextScopeGuard guard;
+  auto ctx = RequestContext::saveContext();
+  std::shared_ptr<RequestContext> seen;
+  fse.getTenant(tenant)->add([&] { seen = RequestContext::saveContext(); });
+  {
+    RequestContextScopeGuard other;
+    manual.drain();
+  }
+  EXPECT_EQ(ctx, seen);
+}
+
+TEST(FairShareExecutorTest, Exceptions) {
+  ManualExecutor manual;
+  FairShareExecutor fse(getKeepAliveToken(manual));
+
+  int ran = 0;
+  fse.add([] { throw std::runtime_error("task failed"); });
+  fse.add([&] { ++ran; });
+  manual.drain();
+  EXPECT_EQ(1, ran);
+  EXPECT_EQ(2, fse.getStats(FairShareExecutor::kDefaultTenant).executedTasks);
+}
+
+TEST(FairShareExecutorTest, MaxInFlight) {
+  constexpr int kTasks = 1000;
+  CPUThreadPoolExecutor pool(4);
+  std::atomic<int> running{0};
+  std::atomic<int> maxRunning{0};
+  Latch done(kTasks);
+  {
+    FairShareExecutor::Options options;
+    options.maxInFlight = 2;
+    FairShareExecutor fse(getKeepAliveToken(pool), options);
+    std::vector<Executor::KeepAlive<>> tenants;
+    for (int i = 0; i < 4; ++i) {
+      tenants.push_back(fse.getTenant(fse.addTenant("t", i + 1)));
+    }
+    for (int i = 0; i < kTasks; ++i) {
+      tenants[i % tenants.size()]->add([&] {
+        auto now = running.fetch_add(1) + 1;
+        auto prev = maxRunning.load();
+        while (now > prev && !maxRunning.compare_exchange_weak(prev, now)) {
+        }
+        std::this_thread::yield();
+        running.fetch_sub(1);
+        done.count_down();
+      });
+    }
+    // The destructor waits for the tenants' tasks.
+  }
+  EXPECT_TRUE(done.try_wait());
+  EXPECT_LE(maxRunning.load(), 2);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/NumaThreadPoolExecutor.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+
+#include <folly/String.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/system/ThreadName.h>
+
+using namespace folly;
+
+namespace {
+
+// Three nodes, two cpus each.
+NumaTopology fakeTopology() {
+  static const std::map<std::string, std::string> tree = {
+      {"/sys/devices/system/node/online", "0-2"},
+      {"/sys/devices/system/node/node0/cpulist", "0-1"},
+      {"/sys/devices/system/node/node1/cpulist", "2-3"},
+      {"/sys/devices/system/node/node2/cpulist", "4-5"},
+  };
+  return NumaTopology::readFromSysfsTree([](std::string const& name) {
+    auto iter = tree.find(name);
+    return iter == tree.end() ? std::string() : iter->second;
+  });
+}
+
+NumaThreadPoolExecutor::Options unpinned() {
+  // the fake cpus may not exist on this machine
+  NumaThreadPoolExecutor::Options options;
+  options.pinThreads = false;
+  return options;
+}
+
+// The node of the pool thread this runs on, from its name.
+size_t currentPoolNode() {
+  auto name = getCurrentThreadName().value_or("");
+  EXPECT_TRUE(StringPiece(name).startsWith("NumaPool")) << name;
+  return name.at(8) - '0';
+}
+
+} // namespace
+
+TEST(NumaThreadPoolExecutorTest, Threads) {
+  NumaThreadPoolExecutor ex(unpinned(), fakeTopology());
+  EXPECT_EQ(3, ex.numNodes());
+  EXPECT_EQ(6, ex.numThreads());
+  for (size_t node = 0; node < ex.numNodes(); ++node) {
+    EXPECT_EQ(2, ex.nodePool(node).numThreads());
+  }
+
+  auto options = unpinned();
+  options.threadsPerNode = 3;
+  NumaThreadPoolExecutor ex3(options, fakeTopology());
+  EXPECT_EQ(9, ex3.numThreads());
+}
+
+TEST(NumaThreadPoolExecutorTest, NodeHint) {
+  NumaThreadPoolExecutor ex(unpinned(), fakeTopology());
+  std::atomic<int> wrongNode{0};
+  std::atomic<int> done{0};
+  for (size_t i = 0; i < 300; ++i) {
+    ex.add(
+        [&, node = i % 3] {
+          wrongNode += currentPoolNode() != node;
+          ++done;
+        },
+        i);
+  }
+  ex.join();
+  EXPECT_EQ(300, done);
+  EXPECT_EQ(0, wrongNode);
+}
+
+TEST(NumaThreadPoolExecutorTest, AddStaysOnNode) {
+  // Without pinning the current node of a pool thread is arbitrary, so use a
+  // single node to check that tasks added from the pool run on it.
+  NumaThreadPoolExecutor ex(unpinned(), NumaTopology::uniform(2));
+  Baton<> baton;
+  size_t node = 1;
+  ex.add([&] {
+    ex.add([&] {
+      node = currentPoolNode();
+      baton.post();
+    });
+  });
+  baton.wait();
+  EXPECT_EQ(0, node);
+}
+
+TEST(NumaThreadPoolExecutorTest, Priorities) {
+  auto options = unpinned();
+  options.numPriorities = 2;
+  options.threadsPerNode = 1;
+  NumaThreadPoolExecutor ex(options, fakeTopology());
+  EXPECT_EQ(2, ex.getNumPriorities());
+
+  // block node 1, then queue a low and a high priority task behind it
+  Baton<> started, unblock;
+  ex.add(
+      [&] {
+        started.post();
+        unblock.wait();
+      },
+      1);
+  started.wait();
+  std::vector<int> order;
+  ex.addWithPriority([&] { order.push_back(0); }, Executor::LO_PRI, 1);
+  ex.addWithPriority([&] { order.push_back(1); }, Executor::HI_PRI, 1);
+  EXPECT_EQ(2, ex.getPendingTaskCount());
+  unblock.post();
+  ex.join();
+  EXPECT_EQ((std::vector<int>{1, 0}), order);
+}
+
+TEST(NumaThreadPoolExecutorTest, KeepAlive) {
+  std::atomic<int> done{0};
+  {
+    NumaThreadPoolExecutor ex(unpinned(), fakeTopology());
+    auto ka = getKeepAliveToken(ex);
+    ex.add([&, ka = std::move(ka)] { ++done; });
+  }
+  EXPECT_EQ(1, done);
+}
+
+TEST(NumaThreadPoolExecutorTest, SystemTopology) {
+  std::atomic<int> done{0};
+  {
+    NumaThreadPoolExecutor ex;
+    EXPECT_EQ(NumaTopology::system().numNodes(), ex.numNodes());
+    for (int i = 0; i < 100; ++i) {
+      ex.add([&] { ++done; });
+    }
+  }
+  EXPECT_EQ(100, done);
+}
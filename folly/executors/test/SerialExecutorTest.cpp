@@ -17,7 +17,9 @@
 #include <folly/executors/SerialExecutor.h>
 
 #include <chrono>
+#include <iterator>
 #include <optional>
+#include <vector>
 
 #include <folly/Random.h>
 #include <folly/ScopeGuard.h>
@@ -254,6 +256,66 @@ TYPED_TEST(SerialExecutorTest, Stress) {
   EXPECT_EQ(tasksRan, kNumProducers * (kNumIterations + 1));
 }
 
+template <class SerialExecutorType>
+void addBatchTest(folly::Executor& parent) {
+  auto executor = SerialExecutorType::create(&parent);
+
+  std::vector<int> values;
+  std::vector<int> expected;
+  int next = 0;
+  for (int round = 0; round < 20; ++round) {
+    std::vector<folly::Func> batch;
+    for (int i = 0; i < round; ++i) {
+      expected.push_back(next);
+      batch.emplace_back([i = next++, &values] { values.push_back(i); });
+    }
+    executor->addBatch(batch);
+    expected.push_back(next);
+    executor->add([i = next++, &values] { values.push_back(i); });
+  }
+
+  folly::Baton<> finished_baton;
+  executor->add([&finished_baton] { finished_baton.post(); });
+  finished_baton.wait();
+
+  EXPECT_EQ(expected, values);
+}
+
+TYPED_TEST(SerialExecutorTest, AddBatch) {
+  folly::CPUThreadPoolExecutor parent{4};
+  addBatchTest<TypeParam>(parent);
+}
+TYPED_TEST(SerialExecutorTest, AddBatchInline) {
+  addBatchTest<TypeParam>(folly::InlineExecutor::instance());
+}
+
+TYPED_TEST(SerialExecutorTest, AddBatchStress) {
+  folly::CPUThreadPoolExecutor parent{4};
+  auto se = TypeParam::create(&parent);
+
+  size_t tasksRan = 0;
+  constexpr size_t kNumProducers = 16;
+  static constexpr size_t kNumBatches = 256;
+  static constexpr size_t kBatchSize = 16;
+  folly::CPUThreadPoolExecutor producers{kNumProducers};
+  for (size_t i = 0; i < kNumProducers; ++i) {
+    producers.add([se, &tasksRan] {
+      for (size_t j = 0; j < kNumBatches; ++j) {
+        std::vector<folly::Func> batch(kBatchSize);
+        for (auto& func : batch) {
+          func = [&tasksRan] { ++tasksRan; };
+        }
+        se->addBatch(batch);
+      }
+    });
+  }
+
+  producers.join();
+  se = {};
+  parent.join();
+  EXPECT_EQ(tasksRan, kNumProducers * kNumBatches * kBatchSize);
+}
+
 // Basic test for SerialExecutorMPSCQueue, does not exercise concurrent access
 // but just ensure that the state stays consistent under different
 // enqueue/dequeue patterns.
@@ -291,6 +353,37 @@ TEST(SerialExecutorTest2, SerialExecutorMPSCQueue) {
   consume(size);
 }
 
+// Bulk enqueues of every size up to a few segments, interleaved with single
+// enqueues and partial dequeues so that batches start at every offset within
+// a segment.
+TEST(SerialExecutorTest2, SerialExecutorMPSCQueueBulk) {
+  folly::detail::SerialExecutorMPSCQueue<std::unique_ptr<size_t>> q;
+  size_t nextWrite = 0;
+  size_t nextRead = 0;
+
+  auto consume = [&](size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+      std::unique_ptr<size_t> entry;
+      q.dequeue(entry);
+      EXPECT_EQ(*entry, nextRead++);
+    }
+  };
+
+  for (size_t n = 0; n <= 50; ++n) {
+    std::vector<std::unique_ptr<size_t>> batch;
+    for (size_t i = 0; i < n; ++i) {
+      batch.push_back(std::make_unique<size_t>(nextWrite++));
+    }
+    q.enqueue_bulk(
+        std::make_move_iterator(batch.begin()),
+        std::make_move_iterator(batch.end()));
+    q.enqueue(std::make_unique<size_t>(nextWrite++));
+    // Leave n / 2 entries behind.
+    consume(nextWrite - nextRead - n / 2);
+  }
+  consume(nextWrite - nextRead);
+}
+
 TEST(SerialExecutorTest2, SPSerialExecutor) {
   folly::CPUThreadPoolExecutor parent{1};
   auto se = folly::SPSerialExecutor::create(&parent);
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/ThreadPoolAutoscaler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <fmt/core.h>
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+
+using namespace folly;
+using namespace std::chrono_literals;
+
+DEFINE_bool(simulate, true, "Run the bursty load simulation");
+DEFINE_bool(simulate_trace, false, "Print every resize of the simulation");
+DEFINE_int32(simulate_seconds, 60, "Simulated time");
+
+// The simulation models a pool as a FIFO queue of fluid work, in steps of 1ms.
+// Every task takes 1ms of a thread. The load is 2 threads' worth, with a
+// burst of 10 times that for 2s out of every 10s, and +-50% of noise per step.
+// Each configuration is fed the same arrivals. The autoscaled pool decides
+// every 100ms with the default policy, which targets a queueing delay of 5ms
+// at 75% utilization.
+
+namespace {
+
+constexpr double kServiceMs = 1;
+constexpr int kDecideEveryMs = 100;
+
+struct Result {
+  double p50WaitMs{0};
+  double p99WaitMs{0};
+  double maxWaitMs{0};
+  double meanThreads{0};
+  size_t maxThreads{0};
+  size_t resizes{0};
+};
+
+std::vector<double> makeArrivals(int ms) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> noise(0.5, 1.5);
+  std::vector<double> arrivals(ms);
+  for (int t = 0; t < ms; ++t) {
+    double const rate = (t % 10000) >= 8000 ? 20 : 2;
+    arrivals[t] = rate * noise(rng);
+  }
+  return arrivals;
+}
+
+// A histogram of queueing delays, in buckets of 0.1ms, weighted by the amount
+// of work that waited.
+struct WaitHistogram {
+  explicit WaitHistogram(size_t maxMs) : buckets(maxMs * 10 + 1) {}
+
+  std::vector<double> buckets;
+  double total{0};
+
+  void add(double waitMs, double weight) {
+    auto const b = std::min<size_t>(waitMs * 10, buckets.size() - 1);
+    buckets[b] += weight;
+    total += weight;
+  }
+
+  double percentile(double p) const {
+    double seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+      seen += buckets[b];
+      if (seen >= total * p) {
+        return b / 10.0;
+      }
+    }
+    return buckets.size() / 10.0;
+  }
+};
+
+Result simulate(
+    const std::vector<double>& arrivals,
+    size_t threads,
+    AutoscalingPolicy* policy) {
+  std::deque<std::pair<int, double>> queue; // (arrival ms, amount)
+  WaitHistogram waits(arrivals.size());
+  Result result;
+  double threadMs = 0;
+  // of the current decision interval
+  double dequeued = 0;
+  double waitMs = 0;
+  double busyMs = 0;
+
+  for (int t = 0; t < static_cast<int>(arrivals.size()); ++t) {
+    queue.emplace_back(t, arrivals[t]);
+    double capacity = threads / kServiceMs;
+    while (capacity > 0 && !queue.empty()) {
+      auto& [arrival, amount] = queue.front();
+      auto const taken = std::min(capacity, amount);
+      auto const wait = t - arrival;
+      waits.add(wait, taken);
+      result.maxWaitMs = std::max<double>(result.maxWaitMs, wait);
+      dequeued += taken;
+      waitMs += taken * wait;
+      busyMs += taken * kServiceMs;
+      capacity -= taken;
+      amount -= taken;
+      if (amount <= 1e-9) {
+        queue.pop_front();
+      }
+    }
+    threadMs += threads;
+    result.maxThreads = std::max(result.maxThreads, threads);
+
+    if (policy && (t + 1) % kDecideEveryMs == 0) {
+      AutoscalingPolicy::Sample sample;
+      sample.interval = std::chrono::milliseconds(kDecideEveryMs);
+      sample.numThreads = threads;
+      sample.dequeuedTasks = std::llround(dequeued);
+      sample.totalQueueDelay =
+          std::chrono::nanoseconds(std::llround(waitMs * 1e6));
+      sample.busyTime = std::chrono::nanoseconds(std::llround(busyMs * 1e6));
+      double pending = 0;
+      for (auto& [arrival, amount] : queue) {
+        pending += amount;
+      }
+      sample.pendingTasks = std::llround(pending);
+      dequeued = waitMs = busyMs = 0;
+      auto const d = policy->decide(sample);
+      if (d.newThreads != threads) {
+        ++result.resizes;
+        if (FLAGS_simulate_trace) {
+          fmt::print(
+              "  t={:>6}ms {:<6} {:>3} -> {:>3} threads, delay {:>8.3f}ms, "
+              "utilization {:.2f}, demand {}\n",
+              t + 1,
+              toString(d.action),
+              d.oldThreads,
+              d.newThreads,
+              d.queueDelay.count() / 1e6,
+              d.utilization,
+              d.demand);
+        }
+        threads = d.newThreads;
+      }
+    }
+  }
+
+  result.p50WaitMs = waits.percentile(0.5);
+  result.p99WaitMs = waits.percentile(0.99);
+  result.meanThreads = threadMs / arrivals.size();
+  return result;
+}
+
+void runSimulation() {
+  auto const arrivals = makeArrivals(FLAGS_simulate_seconds * 1000);
+  auto const print = [](const char* name, const Result& r) {
+    fmt::print(
+        "{:<22} {:>10.1f} {:>10.1f} {:>10.1f} {:>12.2f} {:>11} {:>8}\n",
+        name,
+        r.p50WaitMs,
+        r.p99WaitMs,
+        r.maxWaitMs,
+        r.meanThreads,
+        r.maxThreads,
+        r.resizes);
+  };
+
+  fmt::print(
+      "{:<22} {:>10} {:>10} {:>10} {:>12} {:>11} {:>8}\n",
+      "pool",
+      "p50 (ms)",
+      "p99 (ms)",
+      "max (ms)",
+      "mean threads",
+      "max threads",
+      "resizes");
+  print("static, base (3)", simulate(arrivals, 3, nullptr));
+  print("static, peak (30)", simulate(arrivals, 30, nullptr));
+  AutoscalingPolicy policy;
+  print("autoscaled", simulate(arrivals, 3, &policy));
+  AutoscalingPolicy::Options noHysteresis;
+  noHysteresis.shrinkAfterIntervals = 1;
+  noHysteresis.shrinkDelayFraction = 1;
+  noHysteresis.maxShrinkFraction = 1;
+  AutoscalingPolicy eager(noHysteresis);
+  print("autoscaled, eager", simulate(arrivals, 3, &eager));
+  fmt::print("\n");
+}
+
+} // namespace
+
+BENCHMARK(policyDecide, iters) {
+  AutoscalingPolicy policy;
+  std::vector<AutoscalingPolicy::Sample> samples(64);
+  std::mt19937 rng(42);
+  for (auto& s : samples) {
+    s.interval = 100ms;
+    s.numThreads = 16;
+    s.dequeuedTasks = 1000;
+    s.totalQueueDelay = std::chrono::microseconds(rng() % 10000) * 1000;
+    s.busyTime = std::chrono::milliseconds(rng() % 1600);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    doNotOptimizeAway(policy.decide(samples[i % samples.size()]));
+  }
+}
+
+int main(int argc, char* argv[]) {
+  folly::Init init(&argc, &argv);
+  if (FLAGS_simulate) {
+    runSimulation();
+  }
+  folly::runBenchmarks();
+  return 0;
+}
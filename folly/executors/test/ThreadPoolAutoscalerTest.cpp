@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/ThreadPoolAutoscaler.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+using namespace std::chrono_literals;
+
+using Action = AutoscalingPolicy::Action;
+
+namespace {
+
+AutoscalingPolicy::Options policyOptions() {
+  AutoscalingPolicy::Options options;
+  options.minThreads = 1;
+  options.maxThreads = 32;
+  options.targetQueueDelay = 10ms;
+  options.targetUtilization = 0.5;
+  options.shrinkAfterIntervals = 3;
+  return options;
+}
+
+// A sample of an interval of 100ms in which the threads were busy for
+// busyThreads * 100ms, and tasks waited for queueDelay on average.
+AutoscalingPolicy::Sample sample(
+    size_t threads,
+    double busyThreads,
+    std::chrono::nanoseconds queueDelay,
+    uint64_t pending = 0) {
+  AutoscalingPolicy::Sample s;
+  s.interval = 100ms;
+  s.numThreads = threads;
+  s.dequeuedTasks = 100;
+  s.totalQueueDelay = queueDelay * 100;
+  s.busyTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      busyThreads * s.interval);
+  s.pendingTasks = pending;
+  return s;
+}
+
+} // namespace
+
+TEST(AutoscalingPolicy, measures) {
+  AutoscalingPolicy policy(policyOptions());
+  auto d = policy.decide(sample(4, 2, 3ms));
+  EXPECT_EQ(3ms, d.queueDelay);
+  EXPECT_DOUBLE_EQ(0.5, d.utilization);
+  EXPECT_EQ(4, d.demand);
+  EXPECT_EQ(Action::HOLD, d.action);
+  EXPECT_EQ(4, d.newThreads);
+}
+
+TEST(AutoscalingPolicy, growsToDemand) {
+  AutoscalingPolicy policy(policyOptions());
+  auto d = policy.decide(sample(4, 3, 20ms));
+  EXPECT_EQ(Action::GROW, d.action);
+  EXPECT_EQ(4, d.oldThreads);
+  EXPECT_EQ(6, d.newThreads);
+}
+
+TEST(AutoscalingPolicy, growsByAtLeastOne) {
+  AutoscalingPolicy policy(policyOptions());
+  // blocked tasks: long waits, but little busy time
+  auto d = policy.decide(sample(4, 0.5, 20ms));
+  EXPECT_EQ(Action::GROW, d.action);
+  EXPECT_EQ(5, d.newThreads);
+}
+
+TEST(AutoscalingPolicy, growthIsLimited) {
+  auto options = policyOptions();
+  options.targetUtilization = 0.25;
+  AutoscalingPolicy policy(options);
+  auto d = policy.decide(sample(4, 4, 20ms));
+  EXPECT_EQ(16, d.demand);
+  EXPECT_EQ(8, d.newThreads);
+  d = policy.decide(sample(20, 20, 20ms));
+  EXPECT_EQ(32, d.newThreads);
+  d = policy.decide(sample(32, 32, 20ms));
+  EXPECT_EQ(Action::HOLD, d.action);
+  EXPECT_EQ(32, d.newThreads);
+}
+
+TEST(AutoscalingPolicy, growsWhenNothingIsDequeued) {
+  AutoscalingPolicy policy(policyOptions());
+  auto s = sample(2, 2, 0ms, 10);
+  s.dequeuedTasks = 0;
+  s.totalQueueDelay = 0ms;
+  auto d = policy.decide(s);
+  EXPECT_EQ(100ms, d.queueDelay);
+  EXPECT_EQ(Action::GROW, d.action);
+  EXPECT_EQ(4, d.newThreads);
+}
+
+TEST(AutoscalingPolicy, shrinksAfterQuietIntervals) {
+  AutoscalingPolicy policy(policyOptions());
+  EXPECT_EQ(Action::HOLD, policy.decide(sample(8, 0, 1ms)).action);
+  EXPECT_EQ(Action::HOLD, policy.decide(sample(8, 0, 1ms)).action);
+  auto d = policy.decide(sample(8, 0, 1ms));
+  EXPECT_EQ(Action::SHRINK, d.action);
+  EXPECT_EQ(6, d.newThreads);
+  // the window starts over
+  EXPECT_EQ(Action::HOLD, policy.decide(sample(6, 0, 1ms)).action);
+}
+
+TEST(AutoscalingPolicy, shrinksToPeakDemandOfWindow) {
+  auto options = policyOptions();
+  options.maxShrinkFraction = 1;
+  AutoscalingPolicy policy(options);
+  policy.decide(sample(16, 1, 1ms));
+  policy.decide(sample(16, 3.5, 1ms));
+  auto d = policy.decide(sample(16, 0.5, 1ms));
+  EXPECT_EQ(Action::SHRINK, d.action);
+  EXPECT_EQ(7, d.newThreads);
+}
+
+TEST(AutoscalingPolicy, hysteresis) {
+  AutoscalingPolicy policy(policyOptions());
+  // between half the target and the target: neither grow nor count as quiet
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(Action::HOLD, policy.decide(sample(8, 0, 8ms)).action);
+  }
+  // a single busy interval restarts the quiet window
+  policy.decide(sample(8, 0, 1ms));
+  policy.decide(sample(8, 0, 1ms));
+  EXPECT_EQ(Action::HOLD, policy.decide(sample(8, 0, 8ms)).action);
+  EXPECT_EQ(Action::HOLD, policy.decide(sample(8, 0, 1ms)).action);
+  EXPECT_EQ(Action::HOLD, policy.decide(sample(8, 0, 1ms)).action);
+  EXPECT_EQ(Action::SHRINK, policy.decide(sample(8, 0, 1ms)).action);
+  // enough work to need every thread keeps the pool as it is
+  policy.reset();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(Action::HOLD, policy.decide(sample(6, 3, 1ms)).action);
+  }
+}
+
+TEST(AutoscalingPolicy, bounds) {
+  auto options = policyOptions();
+  options.minThreads = 4;
+  options.maxThreads = 8;
+  AutoscalingPolicy policy(options);
+  auto d = policy.decide(sample(2, 0, 0ms));
+  EXPECT_EQ(Action::GROW, d.action);
+  EXPECT_EQ(4, d.newThreads);
+  d = policy.decide(sample(12, 0, 0ms));
+  EXPECT_EQ(Action::SHRINK, d.action);
+  EXPECT_EQ(8, d.newThreads);
+  for (int i = 0; i < 10; ++i) {
+    d = policy.decide(sample(4, 0, 0ms));
+    EXPECT_EQ(Action::HOLD, d.action);
+  }
+}
+
+TEST(ThreadPoolAutoscaler, growsUnderBacklog) {
+  CPUThreadPoolExecutor pool(1);
+  ThreadPoolAutoscaler::Options options;
+  options.interval = 0ms;
+  options.policy.targetQueueDelay = 1ms;
+  options.policy.maxThreads = 4;
+  std::vector<ThreadPoolAutoscaler::Decision> decisions;
+  options.onDecision = [&](const auto& d) { decisions.push_back(d); };
+  ThreadPoolAutoscaler autoscaler(pool, options);
+
+  Baton<> started;
+  for (int i = 0; i < 20; ++i) {
+    pool.add([&, i] {
+      if (i == 0) {
+        started.post();
+      }
+      /* sleep override */ std::this_thread::sleep_for(2ms);
+    });
+  }
+  started.wait();
+  /* sleep override */ std::this_thread::sleep_for(10ms);
+  auto d = autoscaler.tick();
+  EXPECT_EQ(Action::GROW, d.action);
+  EXPECT_EQ(1, d.oldThreads);
+  EXPECT_EQ(2, d.newThreads);
+  EXPECT_EQ(2, pool.numThreads());
+  EXPECT_GT(d.sample.pendingTasks, 0);
+
+  ASSERT_EQ(1, decisions.size());
+  EXPECT_EQ(Action::GROW, decisions[0].action);
+  auto stats = autoscaler.getStats();
+  EXPECT_EQ(1, stats.numDecisions);
+  EXPECT_EQ(1, stats.numGrows);
+  EXPECT_EQ(0, stats.numShrinks);
+  EXPECT_EQ(2, stats.lastDecision.newThreads);
+  pool.join();
+}
+
+TEST(ThreadPoolAutoscaler, shrinksWhenIdle) {
+  CPUThreadPoolExecutor pool(8);
+  ThreadPoolAutoscaler::Options options;
+  options.interval = 0ms;
+  options.policy.minThreads = 2;
+  options.policy.shrinkAfterIntervals = 2;
+  ThreadPoolAutoscaler autoscaler(pool, options);
+
+  EXPECT_EQ(Action::HOLD, autoscaler.tick().action);
+  EXPECT_EQ(Action::SHRINK, autoscaler.tick().action);
+  EXPECT_EQ(6, pool.numThreads());
+  for (int i = 0; i < 20; ++i) {
+    autoscaler.tick();
+  }
+  EXPECT_EQ(2, pool.numThreads());
+  auto stats = autoscaler.getStats();
+  EXPECT_EQ(22, stats.numDecisions);
+  EXPECT_EQ(0, stats.numGrows);
+  EXPECT_EQ(5, stats.numShrinks);
+}
+
+TEST(ThreadPoolAutoscaler, measuresTasks) {
+  CPUThreadPoolExecutor pool(2);
+  ThreadPoolAutoscaler::Options options;
+  options.interval = 0ms;
+  ThreadPoolAutoscaler autoscaler(pool, options);
+  for (int i = 0; i < 10; ++i) {
+    pool.add([] { /* sleep override */ std::this_thread::sleep_for(1ms); });
+  }
+  pool.join();
+  auto d = autoscaler.tick();
+  EXPECT_EQ(10, d.sample.dequeuedTasks);
+  EXPECT_GE(d.sample.busyTime, 10ms);
+  EXPECT_EQ(0, d.sample.pendingTasks);
+  // counters are reset by each tick
+  EXPECT_EQ(0, autoscaler.tick().sample.dequeuedTasks);
+}
+
+TEST(ThreadPoolAutoscaler, ticksInBackground) {
+  CPUThreadPoolExecutor pool(2);
+  ThreadPoolAutoscaler::Options options;
+  options.interval = 1ms;
+  std::atomic<int> decisions{0};
+  Baton<> done;
+  options.onDecision = [&](const auto&) {
+    if (++decisions == 3) {
+      done.post();
+    }
+  };
+  ThreadPoolAutoscaler autoscaler(pool, options);
+  done.wait();
+  EXPECT_GE(autoscaler.getStats().numDecisions, 3);
+}
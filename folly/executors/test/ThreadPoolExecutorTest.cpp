@@ -24,6 +24,7 @@
 #include <atomic>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <boost/thread.hpp>
 
@@ -36,11 +37,13 @@
 #include <folly/executors/VirtualExecutor.h>
 #include <folly/executors/task_queue/LifoSemMPMCQueue.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
+#include <folly/executors/thread_factory/CpuAffinityThreadFactory.h>
 #include <folly/executors/thread_factory/InitThreadFactory.h>
 #include <folly/executors/thread_factory/PriorityThreadFactory.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <folly/portability/PThread.h>
+#include <folly/portability/Sched.h>
 #include <folly/portability/SysResource.h>
 #include <folly/synchronization/detail/Spin.h>
 #include <folly/system/ThreadId.h>
@@ -101,11 +104,28 @@ FOLLY_KEEP std::unique_ptr<QueueObserverFactory> make_queue_observer_factory(
 
 } // namespace folly
 
+namespace {
+
+class WorkStealingCPUThreadPoolExecutor : public CPUThreadPoolExecutor {
+ public:
+  explicit WorkStealingCPUThreadPoolExecutor(
+      size_t numThreads,
+      std::shared_ptr<ThreadFactory> threadFactory =
+          std::make_shared<NamedThreadFactory>("CPUThreadPool"))
+      : CPUThreadPoolExecutor(
+            numThreads, makeWorkStealingQueue(), std::move(threadFactory)) {}
+};
+
+} // namespace
+
 template <typename T>
 class ThreadPoolExecutorTypedTest : public ::testing::Test {};
 
-using ValueTypes = ::testing::
-    Types<CPUThreadPoolExecutor, IOThreadPoolExecutor, EDFThreadPoolExecutor>;
+using ValueTypes = ::testing::Types<
+    CPUThreadPoolExecutor,
+    WorkStealingCPUThreadPoolExecutor,
+    IOThreadPoolExecutor,
+    EDFThreadPoolExecutor>;
 
 TYPED_TEST_SUITE(ThreadPoolExecutorTypedTest, ValueTypes);
 
@@ -189,6 +209,52 @@ TYPED_TEST(ThreadPoolExecutorTypedTest, Join) {
   join<TypeParam>();
 }
 
+template <class TPE>
+static void addBatch() {
+  TPE tpe(10);
+  std::atomic<int> completed(0);
+  std::vector<Func> funcs;
+  for (int i = 0; i < 1000; i++) {
+    funcs.emplace_back([&] {
+      burnMs(1)();
+      completed++;
+    });
+  }
+  tpe.addBatch(funcs);
+  tpe.addBatch({});
+  tpe.join();
+  EXPECT_EQ(1000, completed);
+}
+
+TYPED_TEST(ThreadPoolExecutorTypedTest, AddBatch) {
+  addBatch<TypeParam>();
+}
+
+template <class TPE>
+static void addBatchWakesThreads() {
+  // Every task of the batch waits for all of the others, so they must run on
+  // distinct threads at once.
+  TPE tpe(4);
+  folly::Latch latch(4);
+  std::atomic<int> met(0);
+  std::vector<Func> funcs;
+  for (int i = 0; i < 4; i++) {
+    funcs.emplace_back([&] {
+      latch.count_down();
+      if (latch.try_wait_for(std::chrono::seconds(10))) {
+        met++;
+      }
+    });
+  }
+  tpe.addBatch(funcs);
+  tpe.join();
+  EXPECT_EQ(4, met);
+}
+
+TYPED_TEST(ThreadPoolExecutorTypedTest, AddBatchWakesThreads) {
+  addBatchWakesThreads<TypeParam>();
+}
+
 template <class TPE>
 static void destroy() {
   TPE tpe(1);
@@ -536,6 +602,53 @@ TEST(ThreadPoolExecutorTest, PriorityPreemptionTest) {
   EXPECT_EQ(100, completed);
 }
 
+TEST(ThreadPoolExecutorTest, WorkStealingPriorityPreemptionTest) {
+  bool tookLopri = false;
+  auto completed = 0;
+  auto hipri = [&] {
+    EXPECT_FALSE(tookLopri);
+    completed++;
+  };
+  auto lopri = [&] {
+    tookLopri = true;
+    completed++;
+  };
+  CPUThreadPoolExecutor pool(
+      0, CPUThreadPoolExecutor::makeWorkStealingPriorityQueue(2));
+  {
+    VirtualExecutor ve(pool);
+    for (int i = 0; i < 50; i++) {
+      ve.addWithPriority(lopri, Executor::LO_PRI);
+    }
+    for (int i = 0; i < 50; i++) {
+      ve.addWithPriority(hipri, Executor::HI_PRI);
+    }
+    pool.setNumThreads(1);
+  }
+  EXPECT_EQ(100, completed);
+}
+
+TEST(ThreadPoolExecutorTest, WorkStealingJoinRunsSpawnedTasks) {
+  // Tasks added from the pool's threads go to their own deques; join() must
+  // still run all of them, and the tasks they add in turn.
+  std::atomic<int> completed{0};
+  CPUThreadPoolExecutor pool(
+      4, CPUThreadPoolExecutor::makeWorkStealingQueue());
+  Function<void(int)> spawn = [&](int depth) {
+    if (depth > 0) {
+      for (int i = 0; i < 2; ++i) {
+        pool.add([&, depth] { spawn(depth - 1); });
+      }
+    }
+    completed++;
+  };
+  for (int i = 0; i < 8; ++i) {
+    pool.add([&] { spawn(8); });
+  }
+  pool.join();
+  EXPECT_EQ(8 * ((1 << 9) - 1), completed);
+}
+
 class TestObserver : public ThreadPoolExecutor::Observer {
  public:
   void threadStarted(ThreadPoolExecutor::ThreadHandle*) override { threads_++; }
@@ -647,6 +760,29 @@ TEST(PriorityThreadFactoryTest, ThreadPriority) {
   EXPECT_EQ(desiredPriority, actualPriority);
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST(CpuAffinityThreadFactoryTest, ThreadAffinity) {
+  cpu_set_t allowed;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+  size_t cpu = 0;
+  while (!CPU_ISSET(cpu, &allowed)) {
+    ++cpu;
+  }
+
+  CpuAffinityThreadFactory factory(
+      std::make_shared<NamedThreadFactory>("stuff"), {cpu});
+  cpu_set_t actual;
+  CPU_ZERO(&actual);
+  factory
+      .newThread([&]() {
+        EXPECT_EQ(0, sched_getaffinity(0, sizeof(actual), &actual));
+      })
+      .join();
+  EXPECT_EQ(1, CPU_COUNT(&actual));
+  EXPECT_TRUE(CPU_ISSET(cpu, &actual));
+}
+#endif
+
 TEST(InitThreadFactoryTest, InitializerCalled) {
   int initializerCalledCount = 0;
   InitThreadFactory factory(
@@ -972,6 +1108,37 @@ TEST(ThreadPoolExecutorTest, DynamicThreadsTest) {
           std::chrono::steady_clock::now() + std::chrono::seconds(1), pred));
 }
 
+TEST(ThreadPoolExecutorTest, AddBatchStartsThreadsForUnclaimedTasks) {
+  std::vector<std::unique_ptr<BlockingQueue<CPUThreadPoolExecutor::CPUTask>>>
+      queues;
+  queues.push_back(CPUThreadPoolExecutor::makeLifoSemQueue());
+  queues.push_back(CPUThreadPoolExecutor::makeThrottledLifoSemQueue());
+  queues.push_back(CPUThreadPoolExecutor::makeWorkStealingQueue());
+  for (auto& queue : queues) {
+    CPUThreadPoolExecutor e(std::make_pair(16, 4), std::move(queue));
+    EXPECT_EQ(4, e.numActiveThreads()) << "sanity check";
+    // Let the 4 threads wait for tasks.
+    /* sleep override */ std::this_thread::sleep_for(milliseconds(100));
+
+    // Every task blocks, so that each runs on its own thread. The 4 idle
+    // threads take 4 of them, and only 4 more threads should be started.
+    Latch release(1);
+    std::atomic<int> completed(0);
+    std::vector<Func> funcs;
+    for (int i = 0; i < 8; i++) {
+      funcs.emplace_back([&] {
+        release.wait();
+        completed++;
+      });
+    }
+    e.addBatch(funcs);
+    EXPECT_EQ(8, e.numActiveThreads());
+    release.count_down();
+    e.join();
+    EXPECT_EQ(8, completed);
+  }
+}
+
 TEST(ThreadPoolExecutorTest, GetThreadIdCollector) {
   CPUThreadPoolExecutor e(1);
   auto* collector = e.getThreadIdCollector();
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/thread_factory/CpuAffinityThreadFactory.h>
+
+#include <glog/logging.h>
+#include <folly/String.h>
+#include <folly/portability/Sched.h>
+#include <folly/system/ThreadName.h>
+
+namespace folly {
+
+CpuAffinityThreadFactory::CpuAffinityThreadFactory(
+    std::shared_ptr<ThreadFactory> factory, std::vector<size_t> cpus)
+    : InitThreadFactory(std::move(factory), [cpus = std::move(cpus)] {
+#if defined(__linux__) && !defined(__ANDROID__)
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (auto cpu : cpus) {
+          if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuset);
+          }
+        }
+        if (sched_setaffinity(0, sizeof(cpuset), &cpuset) == 0) {
+          return;
+        }
+        int errnoCopy = errno;
+        LOG(WARNING) << "sched_setaffinity on thread \""
+                     << folly::getCurrentThreadName().value_or("<unknown>")
+                     << "\" failed with error " << errnoCopy << " ("
+                     << errnoStr(errnoCopy) << ")";
+#else
+        (void)cpus;
+        LOG_FIRST_N(WARNING, 1) << "CpuAffinityThreadFactory: cpu affinity is "
+                                << "not supported on this platform";
+#endif
+      }) {}
+
+} // namespace folly
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <folly/executors/thread_factory/InitThreadFactory.h>
+
+namespace folly {
+
+/**
+ * A ThreadFactory that restricts each thread to a set of cpus, for example
+ * the cpus of one NUMA node (see NumaTopology), so that the threads of a
+ * CPUThreadPoolExecutor or IOThreadPoolExecutor stay close to their memory.
+ *
+ * Setting the affinity is only supported on Linux; elsewhere, and when the
+ * kernel rejects the cpu set, threads run unrestricted and a warning is
+ * logged.
+ */
+class CpuAffinityThreadFactory : public InitThreadFactory {
+ public:
+  CpuAffinityThreadFactory(
+      std::shared_ptr<ThreadFactory> factory, std::vector<size_t> cpus);
+};
+
+} // namespace folly
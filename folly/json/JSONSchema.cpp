@@ -22,9 +22,9 @@
 #include <folly/CPortability.h>
 #include <folly/Conv.h>
 #include <folly/Memory.h>
-#include <folly/Optional.h>
 #include <folly/Singleton.h>
 #include <folly/String.h>
+#include <folly/hash/Hash.h>
 #include <folly/json/json.h>
 #include <folly/portability/Math.h>
 
@@ -53,784 +53,896 @@ struct FOLLY_EXPORT SchemaError : std::runtime_error {
             toJson(value))) {}
 };
 
-template <class... Args>
-Optional<SchemaError> makeError(Args&&... args) {
-  return Optional<SchemaError>(SchemaError(std::forward<Args>(args)...));
-}
-
-struct ValidationContext;
-
-struct IValidator {
-  virtual ~IValidator() = default;
+/**
+ * A schema is compiled into a block of instructions, one per keyword that
+ * constrains anything, which are executed in order until one fails.
+ * Subschemas are blocks of their own, referred to by their index; they are
+ * also compiled once for each $ref, which is how recursive schemas work.
+ *
+ * Everything a block refers to is stored in flat tables owned by the
+ * validator: lists of subschemas and of keys, hash tables of properties,
+ * compiled regexes, and the keyword values that errors print. Validation
+ * builds an error message only when it fails, so that it does not
+ * allocate when it succeeds.
+ */
+constexpr uint32_t kNoSchema = ~uint32_t(0);
+
+enum class Op : uint8_t {
+  // a: the index of the keyword value in constants_, for errors.
+  kMultipleOf,
+  kMinimum,
+  kMaximum,
+  // integer: the bound; type: the type of value it applies to.
+  kMinSize,
+  kMaxSize,
+  // a: the regex.
+  kPattern,
+  // a: the schema of every item.
+  kItems,
+  // [a, a + b): in lists_, the schemas of the first items; c: the schema
+  // of the others, if flag allows them.
+  kTupleItems,
+  kUniqueItems,
+  // a: the table of properties.
+  kProperties,
+  // [a, a + b): in lists_, the keys.
+  kRequired,
+  // [a, a + b): the dependencies.
+  kDependencies,
+  // a: the index of the enum array in constants_.
+  kEnum,
+  // a: a bit per allowed dynamic::Type; c: the constant for errors.
+  kType,
+  // [a, a + b): in lists_, the schemas.
+  kAllOf,
+  kAnyOf,
+  kOneOf,
+  // a: the schema.
+  kNot,
+  kRef,
+};
 
- private:
-  friend struct ValidationContext;
+struct Instruction {
+  Op op;
+  // kMinimum, kMaximum: the bound is exclusive. kTupleItems: additional
+  // items are allowed.
+  bool flag{false};
+  // kMultipleOf, kMinimum, kMaximum: the keyword value is a double.
+  bool isDouble{false};
+  uint8_t type{0};
+  uint32_t a{0};
+  uint32_t b{0};
+  uint32_t c{0};
+  union {
+    int64_t integer{0};
+    double number;
+  };
+};
 
-  virtual Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const = 0;
+// A range of code_.
+struct Block {
+  uint32_t begin;
+  uint32_t end;
 };
 
-/**
- * This is a 'context' used only when executing the validators to validate some
- * json. It keeps track of which validators have been executed on which json so
- * we can detect infinite recursion.
- */
-struct ValidationContext {
-  Optional<SchemaError> validate(IValidator* validator, const dynamic& value) {
-    auto ret = seen.insert(std::make_pair(validator, &value));
-    if (!ret.second) {
-      throw std::runtime_error("Infinite recursion detected");
-    }
-    return validator->validate(*this, value);
-  }
+struct PropertySlot {
+  size_t hash{0};
+  uint32_t key{0};
+  // kNoSchema for empty slots.
+  uint32_t schema{kNoSchema};
+};
 
- private:
-  std::unordered_set<std::pair<const IValidator*, const dynamic*>> seen;
+// An open addressing table of the "properties" of a schema, whose size is a
+// power of 2, followed by its "patternProperties" and
+// "additionalProperties".
+struct PropertyTable {
+  uint32_t slots{0};
+  uint32_t mask{0};
+  uint32_t patterns{0};
+  uint32_t patternCount{0};
+  uint32_t additional{kNoSchema};
+  bool allowAdditional{true};
 };
 
-/**
- * This is a 'context' used only when building the schema validators from a
- * piece of json. It stores the original schema and the set of refs, so that we
- * can have parts of the schema refer to other parts.
- */
-struct SchemaValidatorContext final {
-  explicit SchemaValidatorContext(const dynamic& s) : schema(s) {}
+// If the object has key, it must have keys [keys, keys + keyCount) in
+// lists_, and match schema unless it is kNoSchema.
+struct Dependency {
+  uint32_t key;
+  uint32_t keys;
+  uint32_t keyCount;
+  uint32_t schema;
+};
 
-  const dynamic& schema;
-  std::unordered_map<std::string, IValidator*> refs;
+// Where validation failed: the instruction, the value it was applied to,
+// and, for missing properties, the key.
+struct Failure {
+  const Instruction* instruction{nullptr};
+  const dynamic* value{nullptr};
+  uint32_t key{0};
 };
 
-/**
- * Root validator for a schema.
- */
-struct SchemaValidator final : IValidator, public Validator {
-  SchemaValidator() = default;
-  void loadSchema(SchemaValidatorContext& context, const dynamic& schema);
+// The schemas being applied, innermost first, to detect infinite recursion.
+struct Active {
+  uint32_t schema;
+  const dynamic* value;
+  const Active* parent;
+};
 
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override;
+struct SchemaValidator final : Validator {
+  explicit SchemaValidator(const dynamic& schema);
 
   // Validator interface
   void validate(const dynamic& value) const override;
   exception_wrapper try_validate(const dynamic& value) const noexcept override;
 
-  static std::unique_ptr<SchemaValidator> make(
-      SchemaValidatorContext& context, const dynamic& schema) {
-    // We break apart the constructor and actually loading the schema so that
-    // we can handle the case where a schema refers to itself, e.g. via
-    // "$ref": "#".
-    auto v = std::make_unique<SchemaValidator>();
-    v->loadSchema(context, schema);
-    return v;
-  }
-
  private:
-  std::vector<std::unique_ptr<IValidator>> validators_;
+  uint32_t compile(const dynamic& schema);
+  void compileRef(const dynamic& ref, std::vector<Instruction>& out);
+  uint32_t compileList(const dynamic& schemas);
+  uint32_t compileProperties(
+      const dynamic* properties,
+      const dynamic* patternProperties,
+      const dynamic* additionalProperties);
+  uint32_t addKey(const std::string& key);
+  uint32_t addConstant(dynamic value);
+  bool hasRecursion(uint32_t schema, std::vector<uint8_t>& state) const;
+
+  bool run(
+      uint32_t schema,
+      const dynamic& value,
+      const Active* parent,
+      Failure& failure) const;
+  uint32_t findProperty(const PropertyTable& table, StringPiece key) const;
+  SchemaError makeError(const Failure& failure) const;
+
+  std::vector<Instruction> code_;
+  std::vector<Block> schemas_;
+  std::vector<uint32_t> lists_;
+  std::vector<std::string> keys_;
+  std::vector<PropertySlot> slots_;
+  std::vector<PropertyTable> tables_;
+  // (regex, schema) of patternProperties.
+  std::vector<std::pair<uint32_t, uint32_t>> patterns_;
+  std::vector<boost::regex> regexes_;
+  std::vector<Dependency> dependencies_;
+  std::vector<dynamic> constants_;
+  // Whether a schema can apply itself to the value it validates, e.g. via
+  // {"not": {"$ref": "#"}}, which validation must detect.
+  bool checkRecursion_{false};
+
+  // Only while compiling: the root schema, and the schemas of refs.
+  const dynamic* root_{nullptr};
+  std::unordered_map<std::string, uint32_t> refs_;
 };
 
-struct MultipleOfValidator final : IValidator {
-  explicit MultipleOfValidator(dynamic schema) : schema_(std::move(schema)) {}
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    if (!schema_.isNumber() || !value.isNumber()) {
-      return none;
-    }
-    if (schema_.isDouble() || value.isDouble()) {
-      const auto rem = folly::remainder(value.asDouble(), schema_.asDouble());
-      if (std::abs(rem) > std::numeric_limits<double>::epsilon()) {
-        return makeError("a multiple of ", schema_, value);
-      }
-    } else { // both ints
-      if ((value.getInt() % schema_.getInt()) != 0) {
-        return makeError("a multiple of ", schema_, value);
-      }
-    }
-    return none;
-  }
-  dynamic schema_;
-};
+SchemaValidator::SchemaValidator(const dynamic& schema) : root_(&schema) {
+  refs_["#"] = 0;
+  compile(schema);
 
-struct ComparisonValidator final : IValidator {
-  enum class Type { MIN, MAX };
-  ComparisonValidator(dynamic schema, const dynamic* exclusive, Type type)
-      : schema_(std::move(schema)), exclusive_(false), type_(type) {
-    if (exclusive && exclusive->isBool()) {
-      exclusive_ = exclusive->getBool();
-    }
+  std::vector<uint8_t> state(schemas_.size());
+  for (uint32_t i = 0; i < schemas_.size() && !checkRecursion_; ++i) {
+    checkRecursion_ = hasRecursion(i, state);
   }
+  root_ = nullptr;
+  refs_.clear();
+}
 
-  template <typename Numeric>
-  Optional<SchemaError> validateHelper(
-      const dynamic& value, Numeric s, Numeric v) const {
-    if (type_ == Type::MIN) {
-      if (exclusive_) {
-        if (v <= s) {
-          return makeError("greater than ", schema_, value);
-        }
-      } else {
-        if (v < s) {
-          return makeError("greater than or equal to ", schema_, value);
-        }
-      }
-    } else if (type_ == Type::MAX) {
-      if (exclusive_) {
-        if (v >= s) {
-          return makeError("less than ", schema_, value);
-        }
+uint32_t SchemaValidator::compile(const dynamic& schema) {
+  auto id = uint32_t(schemas_.size());
+  schemas_.push_back({0, 0});
+  // Subschemas are compiled while this one is, so its instructions are
+  // appended to code_ at the end.
+  std::vector<Instruction> out;
+  auto emit = [&](Op op) -> Instruction& {
+    out.emplace_back();
+    out.back().op = op;
+    return out.back();
+  };
+  auto emitSize = [&](Op op, const dynamic* p, dynamic::Type type) {
+    if (p && p->isInt() && p->getInt() >= 0) {
+      auto& in = emit(op);
+      in.type = uint8_t(type);
+      in.integer = p->getInt();
+    }
+  };
+  auto emitComparison = [&](Op op, const dynamic* p, const dynamic* ex) {
+    if (p && p->isNumber()) {
+      auto& in = emit(op);
+      in.flag = ex && ex->isBool() && ex->getBool();
+      in.isDouble = p->isDouble();
+      in.a = addConstant(*p);
+      if (in.isDouble) {
+        in.number = p->getDouble();
       } else {
-        if (v > s) {
-          return makeError("less than or equal to ", schema_, value);
-        }
+        in.integer = p->getInt();
       }
     }
-    return none;
-  }
-
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    if (!schema_.isNumber() || !value.isNumber()) {
-      return none;
-    }
-    if (schema_.isDouble() || value.isDouble()) {
-      return validateHelper(value, schema_.asDouble(), value.asDouble());
-    } else { // both ints
-      return validateHelper(value, schema_.asInt(), value.asInt());
-    }
-  }
-
-  dynamic schema_;
-  bool exclusive_;
-  Type type_;
-};
-
-template <class Comparison>
-struct SizeValidator final : IValidator {
-  explicit SizeValidator(const dynamic& schema, dynamic::Type type)
-      : length_(-1), type_(type) {
-    if (schema.isInt()) {
-      length_ = schema.getInt();
-    }
-  }
-
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    if (length_ < 0) {
-      return none;
-    }
-    if (value.type() != type_) {
-      return none;
-    }
-    if (!Comparison()(length_, int64_t(value.size()))) {
-      return makeError("different length string/array/object", value);
-    }
-    return none;
-  }
-  int64_t length_;
-  dynamic::Type type_;
-};
-
-struct StringPatternValidator final : IValidator {
-  explicit StringPatternValidator(const dynamic& schema) {
-    if (schema.isString()) {
-      regex_ = boost::regex(schema.getString());
-    }
-  }
-
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    if (!value.isString() || regex_.empty()) {
-      return none;
-    }
-    if (!boost::regex_search(value.getString(), regex_)) {
-      return makeError("string matching regex", value);
-    }
-    return none;
-  }
-  boost::regex regex_;
-};
+  };
 
-struct ArrayUniqueValidator final : IValidator {
-  explicit ArrayUniqueValidator(const dynamic& schema) : unique_(false) {
-    if (schema.isBool()) {
-      unique_ = schema.getBool();
-    }
+  if (!schema.isObject() || schema.empty()) {
+    schemas_[id] = {uint32_t(code_.size()), uint32_t(code_.size())};
+    return id;
   }
 
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    if (!unique_ || !value.isArray()) {
-      return none;
-    }
-    for (const auto& i : value) {
-      for (const auto& j : value) {
-        if (&i != &j && i == j) {
-          return makeError("unique items in array", value);
-        }
-      }
-    }
-    return none;
+  // Check for $ref, if we have one we won't apply anything else. Refs are
+  // pointers to other parts of the json, e.g. #/foo/bar points to the schema
+  // located at root["foo"]["bar"].
+  const auto* ref = schema.get_ptr("$ref");
+  if (ref) {
+    compileRef(*ref, out);
   }
-  bool unique_;
-};
 
-struct ArrayItemsValidator final : IValidator {
-  ArrayItemsValidator(
-      SchemaValidatorContext& context,
-      const dynamic* items,
-      const dynamic* additionalItems)
-      : allowAdditionalItems_(true) {
-    if (items && items->isObject()) {
-      itemsValidator_ = SchemaValidator::make(context, *items);
-      return; // Additional items is ignored
-    } else if (items && items->isArray()) {
-      for (const auto& item : *items) {
-        itemsValidators_.emplace_back(SchemaValidator::make(context, item));
-      }
-    } else {
-      // If items isn't present or is invalid, it defaults to an empty schema.
-      itemsValidator_ = SchemaValidator::make(context, dynamic::object);
+  if (out.empty()) {
+    // Numeric validators
+    if (const auto* p = schema.get_ptr("multipleOf")) {
+      emitComparison(Op::kMultipleOf, p, nullptr);
     }
-    if (additionalItems) {
-      if (additionalItems->isBool()) {
-        allowAdditionalItems_ = additionalItems->getBool();
-      } else if (additionalItems->isObject()) {
-        additionalItemsValidator_ =
-            SchemaValidator::make(context, *additionalItems);
+    emitComparison(
+        Op::kMaximum,
+        schema.get_ptr("maximum"),
+        schema.get_ptr("exclusiveMaximum"));
+    emitComparison(
+        Op::kMinimum,
+        schema.get_ptr("minimum"),
+        schema.get_ptr("exclusiveMinimum"));
+
+    // String validators
+    emitSize(Op::kMaxSize, schema.get_ptr("maxLength"), dynamic::STRING);
+    emitSize(Op::kMinSize, schema.get_ptr("minLength"), dynamic::STRING);
+    if (const auto* p = schema.get_ptr("pattern")) {
+      if (p->isString()) {
+        regexes_.emplace_back(p->getString());
+        emit(Op::kPattern).a = uint32_t(regexes_.size() - 1);
       }
     }
-  }
 
-  Optional<SchemaError> validate(
-      ValidationContext& vc, const dynamic& value) const override {
-    if (!value.isArray()) {
-      return none;
-    }
-    if (itemsValidator_) {
-      for (const auto& v : value) {
-        if (auto se = vc.validate(itemsValidator_.get(), v)) {
-          return se;
+    // Array validators. Without items, additionalItems does nothing.
+    if (const auto* items = schema.get_ptr("items")) {
+      const auto* additionalItems = schema.get_ptr("additionalItems");
+      if (items->isObject()) {
+        auto itemsSchema = compile(*items);
+        emit(Op::kItems).a = itemsSchema;
+      } else if (items->isArray()) {
+        auto list = compileList(*items);
+        uint32_t additional = kNoSchema;
+        bool allow = true;
+        if (additionalItems && additionalItems->isBool()) {
+          allow = additionalItems->getBool();
+        } else if (additionalItems && additionalItems->isObject()) {
+          additional = compile(*additionalItems);
         }
+        auto& in = emit(Op::kTupleItems);
+        in.a = list;
+        in.b = uint32_t(items->size());
+        in.c = additional;
+        in.flag = allow;
       }
-      return none;
     }
-    size_t pos = 0;
-    for (; pos < value.size() && pos < itemsValidators_.size(); ++pos) {
-      if (auto se = vc.validate(itemsValidators_[pos].get(), value[pos])) {
-        return se;
-      }
-    }
-    if (!allowAdditionalItems_ && pos < value.size()) {
-      return makeError("no more additional items", value);
-    }
-    if (additionalItemsValidator_) {
-      for (; pos < value.size(); ++pos) {
-        if (auto se =
-                vc.validate(additionalItemsValidator_.get(), value[pos])) {
-          return se;
-        }
+    emitSize(Op::kMaxSize, schema.get_ptr("maxItems"), dynamic::ARRAY);
+    emitSize(Op::kMinSize, schema.get_ptr("minItems"), dynamic::ARRAY);
+    if (const auto* p = schema.get_ptr("uniqueItems")) {
+      if (p->isBool() && p->getBool()) {
+        emit(Op::kUniqueItems);
       }
     }
-    return none;
-  }
-  std::unique_ptr<IValidator> itemsValidator_;
-  std::vector<std::unique_ptr<IValidator>> itemsValidators_;
-  std::unique_ptr<IValidator> additionalItemsValidator_;
-  bool allowAdditionalItems_;
-};
 
-struct RequiredValidator final : IValidator {
-  explicit RequiredValidator(const dynamic& schema) {
-    if (schema.isArray()) {
-      for (const auto& item : schema) {
-        if (item.isString()) {
-          properties_.emplace_back(item.getString());
-        }
-      }
+    // Object validators
+    const auto* properties = schema.get_ptr("properties");
+    const auto* patternProperties = schema.get_ptr("patternProperties");
+    const auto* additionalProperties = schema.get_ptr("additionalProperties");
+    if (properties || patternProperties || additionalProperties) {
+      auto table = compileProperties(
+          properties, patternProperties, additionalProperties);
+      emit(Op::kProperties).a = table;
     }
-  }
-
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    if (value.isObject()) {
-      for (const auto& prop : properties_) {
-        if (!value.get_ptr(prop)) {
-          return makeError("property ", prop, value);
+    emitSize(Op::kMaxSize, schema.get_ptr("maxProperties"), dynamic::OBJECT);
+    emitSize(Op::kMinSize, schema.get_ptr("minProperties"), dynamic::OBJECT);
+    if (const auto* p = schema.get_ptr("required")) {
+      if (p->isArray()) {
+        auto begin = uint32_t(lists_.size());
+        for (const auto& item : *p) {
+          if (item.isString()) {
+            lists_.push_back(addKey(item.getString()));
+          }
         }
+        auto& in = emit(Op::kRequired);
+        in.a = begin;
+        in.b = uint32_t(lists_.size()) - begin;
       }
     }
-    return none;
-  }
 
- private:
-  std::vector<std::string> properties_;
-};
-
-struct PropertiesValidator final : IValidator {
-  PropertiesValidator(
-      SchemaValidatorContext& context,
-      const dynamic* properties,
-      const dynamic* patternProperties,
-      const dynamic* additionalProperties)
-      : allowAdditionalProperties_(true) {
-    if (properties && properties->isObject()) {
-      for (const auto& pair : properties->items()) {
-        if (pair.first.isString()) {
-          propertyValidators_[pair.first.getString()] =
-              SchemaValidator::make(context, pair.second);
-        }
-      }
-    }
-    if (patternProperties && patternProperties->isObject()) {
-      for (const auto& pair : patternProperties->items()) {
-        if (pair.first.isString()) {
-          patternPropertyValidators_.emplace_back(
-              boost::regex(pair.first.getString()),
-              SchemaValidator::make(context, pair.second));
+    // Misc validators
+    if (const auto* p = schema.get_ptr("dependencies")) {
+      if (p->isObject()) {
+        // Property dependencies are checked before schema dependencies.
+        std::vector<Dependency> schemaDeps;
+        auto begin = uint32_t(dependencies_.size());
+        for (const auto& pair : p->items()) {
+          if (!pair.first.isString()) {
+            continue;
+          }
+          auto key = addKey(pair.first.getString());
+          if (pair.second.isArray()) {
+            auto keys = uint32_t(lists_.size());
+            for (const auto& item : pair.second) {
+              if (item.isString()) {
+                lists_.push_back(addKey(item.getString()));
+              }
+            }
+            dependencies_.push_back(
+                {key, keys, uint32_t(lists_.size()) - keys, kNoSchema});
+          } else if (pair.second.isObject()) {
+            schemaDeps.push_back({key, 0, 0, compile(pair.second)});
+          }
         }
+        dependencies_.insert(
+            dependencies_.end(), schemaDeps.begin(), schemaDeps.end());
+        auto& in = emit(Op::kDependencies);
+        in.a = begin;
+        in.b = uint32_t(dependencies_.size()) - begin;
       }
     }
-    if (additionalProperties) {
-      if (additionalProperties->isBool()) {
-        allowAdditionalProperties_ = additionalProperties->getBool();
-      } else if (additionalProperties->isObject()) {
-        additionalPropertyValidator_ =
-            SchemaValidator::make(context, *additionalProperties);
+    if (const auto* p = schema.get_ptr("enum")) {
+      if (p->isArray()) {
+        emit(Op::kEnum).a = addConstant(*p);
       }
     }
-  }
-
-  Optional<SchemaError> validate(
-      ValidationContext& vc, const dynamic& value) const override {
-    if (!value.isObject()) {
-      return none;
-    }
-    for (const auto& pair : value.items()) {
-      if (!pair.first.isString()) {
-        continue;
-      }
-      const std::string& key = pair.first.getString();
-      auto it = propertyValidators_.find(key);
-      bool matched = false;
-      if (it != propertyValidators_.end()) {
-        if (auto se = vc.validate(it->second.get(), pair.second)) {
-          return se;
-        }
-        matched = true;
-      }
-
-      const std::string& strkey = key;
-      for (const auto& ppv : patternPropertyValidators_) {
-        if (boost::regex_search(strkey, ppv.first)) {
-          if (auto se = vc.validate(ppv.second.get(), pair.second)) {
-            return se;
+    if (const auto* p = schema.get_ptr("type")) {
+      uint32_t mask = 0;
+      std::string names; // for errors
+      auto addType = [&](StringPiece name) {
+        static constexpr std::pair<StringPiece, uint32_t> kTypes[] = {
+            {"array", 1u << dynamic::ARRAY},
+            {"boolean", 1u << dynamic::BOOL},
+            {"integer", 1u << dynamic::INT64},
+            {"number", (1u << dynamic::INT64) | (1u << dynamic::DOUBLE)},
+            {"null", 1u << dynamic::NULLT},
+            {"object", 1u << dynamic::OBJECT},
+            {"string", 1u << dynamic::STRING},
+        };
+        for (const auto& type : kTypes) {
+          if (type.first == name) {
+            mask |= type.second;
+            if (!names.empty()) {
+              names += ", ";
+            }
+            names += name.str();
           }
-          matched = true;
         }
-      }
-      if (matched) {
-        continue;
-      }
-      if (!allowAdditionalProperties_) {
-        return makeError("no more additional properties", value);
-      }
-      if (additionalPropertyValidator_) {
-        if (auto se =
-                vc.validate(additionalPropertyValidator_.get(), pair.second)) {
-          return se;
-        }
-      }
-    }
-    return none;
-  }
-
-  std::unordered_map<std::string, std::unique_ptr<IValidator>>
-      propertyValidators_;
-  std::vector<std::pair<boost::regex, std::unique_ptr<IValidator>>>
-      patternPropertyValidators_;
-  std::unique_ptr<IValidator> additionalPropertyValidator_;
-  bool allowAdditionalProperties_;
-};
-
-struct DependencyValidator final : IValidator {
-  DependencyValidator(SchemaValidatorContext& context, const dynamic& schema) {
-    if (!schema.isObject()) {
-      return;
-    }
-    for (const auto& pair : schema.items()) {
-      if (!pair.first.isString()) {
-        continue;
-      }
-      if (pair.second.isArray()) {
-        auto p = make_pair(pair.first.getString(), std::vector<std::string>());
-        for (const auto& item : pair.second) {
+      };
+      if (p->isString()) {
+        addType(p->stringPiece());
+      } else if (p->isArray()) {
+        for (const auto& item : *p) {
           if (item.isString()) {
-            p.second.push_back(item.getString());
+            addType(item.stringPiece());
           }
         }
-        propertyDep_.emplace_back(std::move(p));
-      }
-      if (pair.second.isObject()) {
-        schemaDep_.emplace_back(
-            pair.first.getString(),
-            SchemaValidator::make(context, pair.second));
       }
+      // A type that names no valid type allows nothing.
+      auto& in = emit(Op::kType);
+      in.a = mask;
+      in.c = addConstant(std::move(names));
     }
-  }
-
-  Optional<SchemaError> validate(
-      ValidationContext& vc, const dynamic& value) const override {
-    if (!value.isObject()) {
-      return none;
+    if (const auto* p = schema.get_ptr("allOf")) {
+      auto list = compileList(*p);
+      auto& in = emit(Op::kAllOf);
+      in.a = list;
+      in.b = p->isArray() ? uint32_t(p->size()) : 0;
     }
-    for (const auto& pair : propertyDep_) {
-      if (value.count(pair.first)) {
-        for (const auto& prop : pair.second) {
-          if (!value.count(prop)) {
-            return makeError("property ", prop, value);
-          }
-        }
-      }
+    if (const auto* p = schema.get_ptr("anyOf")) {
+      auto list = compileList(*p);
+      auto& in = emit(Op::kAnyOf);
+      in.a = list;
+      in.b = p->isArray() ? uint32_t(p->size()) : 0;
     }
-    for (const auto& pair : schemaDep_) {
-      if (value.count(pair.first)) {
-        if (auto se = vc.validate(pair.second.get(), value)) {
-          return se;
-        }
-      }
+    if (const auto* p = schema.get_ptr("oneOf")) {
+      auto list = compileList(*p);
+      auto& in = emit(Op::kOneOf);
+      in.a = list;
+      in.b = p->isArray() ? uint32_t(p->size()) : 0;
+    }
+    if (const auto* p = schema.get_ptr("not")) {
+      auto notSchema = compile(*p);
+      emit(Op::kNot).a = notSchema;
     }
-    return none;
   }
 
-  std::vector<std::pair<std::string, std::vector<std::string>>> propertyDep_;
-  std::vector<std::pair<std::string, std::unique_ptr<IValidator>>> schemaDep_;
-};
+  auto begin = uint32_t(code_.size());
+  code_.insert(code_.end(), out.begin(), out.end());
+  schemas_[id] = {begin, uint32_t(code_.size())};
+  return id;
+}
 
-struct EnumValidator final : IValidator {
-  explicit EnumValidator(dynamic schema) : schema_(std::move(schema)) {}
+void SchemaValidator::compileRef(
+    const dynamic& ref, std::vector<Instruction>& out) {
+  // We only support absolute refs, i.e. those starting with '#'
+  if (!ref.isString() || !ref.stringPiece().startsWith('#')) {
+    return;
+  }
+  auto it = refs_.find(ref.getString());
+  if (it != refs_.end()) {
+    out.emplace_back();
+    out.back().op = Op::kRef;
+    out.back().a = it->second;
+    return;
+  }
 
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    if (!schema_.isArray()) {
-      return none;
+  // This is a ref, but we haven't loaded it yet. Find where it is based on
+  // the root schema.
+  std::vector<std::string> parts;
+  split("/", ref.stringPiece(), parts);
+  const auto* s = root_; // First part is '#'
+  for (size_t i = 1; s && i < parts.size(); ++i) {
+    // Per the standard, we must replace ~1 with / and then ~0 with ~
+    boost::replace_all(parts[i], "~1", "/");
+    boost::replace_all(parts[i], "~0", "~");
+    if (s->isObject()) {
+      s = s->get_ptr(parts[i]);
+      continue;
     }
-    for (const auto& item : schema_) {
-      if (value == item) {
-        return none;
+    if (s->isArray()) {
+      auto pos = tryTo<size_t>(parts[i]);
+      if (pos && *pos < s->size()) {
+        s = s->get_ptr(*pos);
+        continue;
       }
     }
-    return makeError("one of enum values: ", schema_, value);
+    break;
   }
-  dynamic schema_;
-};
-
-struct TypeValidator final : IValidator {
-  explicit TypeValidator(const dynamic& schema) {
-    if (schema.isString()) {
-      addType(schema.stringPiece());
-    } else if (schema.isArray()) {
-      for (const auto& item : schema) {
-        if (item.isString()) {
-          addType(item.stringPiece());
-        }
-      }
-    }
+  // Register the schema before compiling it, so that it can refer to
+  // itself, e.g. {"items": {"$ref": "#/definitions/list"}} at
+  // #/definitions/list.
+  if (s) {
+    auto id = uint32_t(schemas_.size());
+    refs_[ref.getString()] = id;
+    compile(*s);
+    out.emplace_back();
+    out.back().op = Op::kRef;
+    out.back().a = id;
   }
+}
 
-  Optional<SchemaError> validate(
-      ValidationContext&, const dynamic& value) const override {
-    auto it =
-        std::find(allowedTypes_.begin(), allowedTypes_.end(), value.type());
-    if (it == allowedTypes_.end()) {
-      return makeError("a value of type ", typeStr_, value);
-    }
-    return none;
+uint32_t SchemaValidator::compileList(const dynamic& schemas) {
+  if (!schemas.isArray()) {
+    return uint32_t(lists_.size());
   }
-
- private:
-  std::vector<dynamic::Type> allowedTypes_;
-  std::string typeStr_; // for errors
-
-  void addType(StringPiece value) {
-    if (value == "array") {
-      allowedTypes_.push_back(dynamic::Type::ARRAY);
-    } else if (value == "boolean") {
-      allowedTypes_.push_back(dynamic::Type::BOOL);
-    } else if (value == "integer") {
-      allowedTypes_.push_back(dynamic::Type::INT64);
-    } else if (value == "number") {
-      allowedTypes_.push_back(dynamic::Type::INT64);
-      allowedTypes_.push_back(dynamic::Type::DOUBLE);
-    } else if (value == "null") {
-      allowedTypes_.push_back(dynamic::Type::NULLT);
-    } else if (value == "object") {
-      allowedTypes_.push_back(dynamic::Type::OBJECT);
-    } else if (value == "string") {
-      allowedTypes_.push_back(dynamic::Type::STRING);
-    } else {
-      return;
-    }
-    if (!typeStr_.empty()) {
-      typeStr_ += ", ";
-    }
-    typeStr_ += value.str();
+  std::vector<uint32_t> ids;
+  for (const auto& item : schemas) {
+    ids.push_back(compile(item));
   }
-};
+  auto begin = uint32_t(lists_.size());
+  lists_.insert(lists_.end(), ids.begin(), ids.end());
+  return begin;
+}
 
-struct AllOfValidator final : IValidator {
-  AllOfValidator(SchemaValidatorContext& context, const dynamic& schema) {
-    if (schema.isArray()) {
-      for (const auto& item : schema) {
-        validators_.emplace_back(SchemaValidator::make(context, item));
+uint32_t SchemaValidator::compileProperties(
+    const dynamic* properties,
+    const dynamic* patternProperties,
+    const dynamic* additionalProperties) {
+  std::vector<std::pair<uint32_t, uint32_t>> named;
+  if (properties && properties->isObject()) {
+    for (const auto& pair : properties->items()) {
+      if (pair.first.isString()) {
+        auto key = addKey(pair.first.getString());
+        named.emplace_back(key, compile(pair.second));
       }
     }
   }
-
-  Optional<SchemaError> validate(
-      ValidationContext& vc, const dynamic& value) const override {
-    for (const auto& val : validators_) {
-      if (auto se = vc.validate(val.get(), value)) {
-        return se;
+  std::vector<std::pair<uint32_t, uint32_t>> patterns;
+  if (patternProperties && patternProperties->isObject()) {
+    for (const auto& pair : patternProperties->items()) {
+      if (pair.first.isString()) {
+        regexes_.emplace_back(pair.first.getString());
+        auto regex = uint32_t(regexes_.size() - 1);
+        patterns.emplace_back(regex, compile(pair.second));
       }
     }
-    return none;
   }
-
-  std::vector<std::unique_ptr<IValidator>> validators_;
-};
-
-struct AnyOfValidator final : IValidator {
-  enum class Type { EXACTLY_ONE, ONE_OR_MORE };
-
-  AnyOfValidator(
-      SchemaValidatorContext& context, const dynamic& schema, Type type)
-      : type_(type) {
-    if (schema.isArray()) {
-      for (const auto& item : schema) {
-        validators_.emplace_back(SchemaValidator::make(context, item));
-      }
+  PropertyTable table;
+  if (additionalProperties) {
+    if (additionalProperties->isBool()) {
+      table.allowAdditional = additionalProperties->getBool();
+    } else if (additionalProperties->isObject()) {
+      table.additional = compile(*additionalProperties);
     }
   }
 
-  Optional<SchemaError> validate(
-      ValidationContext& vc, const dynamic& value) const override {
-    std::vector<SchemaError> errors;
-    for (const auto& val : validators_) {
-      if (auto se = vc.validate(val.get(), value)) {
-        errors.emplace_back(*se);
-      }
-    }
-    const auto success = validators_.size() - errors.size();
-    if (success == 0) {
-      return makeError("at least one valid schema", value);
-    } else if (success > 1 && type_ == Type::EXACTLY_ONE) {
-      return makeError("exactly one valid schema", value);
+  // At most half full, so that misses end early.
+  size_t size = 1;
+  while (size < 2 * named.size()) {
+    size *= 2;
+  }
+  table.slots = uint32_t(slots_.size());
+  table.mask = uint32_t(size - 1);
+  slots_.resize(slots_.size() + size);
+  for (const auto& [key, schema] : named) {
+    auto hash = hasher<StringPiece>()(keys_[key]);
+    auto i = hash & table.mask;
+    while (slots_[table.slots + i].schema != kNoSchema) {
+      i = (i + 1) & table.mask;
     }
-    return none;
+    slots_[table.slots + i] = {hash, key, schema};
   }
+  table.patterns = uint32_t(patterns_.size());
+  table.patternCount = uint32_t(patterns.size());
+  patterns_.insert(patterns_.end(), patterns.begin(), patterns.end());
+  tables_.push_back(table);
+  return uint32_t(tables_.size() - 1);
+}
 
-  Type type_;
-  std::vector<std::unique_ptr<IValidator>> validators_;
-};
+uint32_t SchemaValidator::addKey(const std::string& key) {
+  keys_.push_back(key);
+  return uint32_t(keys_.size() - 1);
+}
 
-struct RefValidator final : IValidator {
-  explicit RefValidator(IValidator* validator) : validator_(validator) {}
+uint32_t SchemaValidator::addConstant(dynamic value) {
+  constants_.push_back(std::move(value));
+  return uint32_t(constants_.size() - 1);
+}
 
-  Optional<SchemaError> validate(
-      ValidationContext& vc, const dynamic& value) const override {
-    return vc.validate(validator_, value);
+// Whether a cycle of schemas that apply to the value they validate goes
+// through schema. state is 1 for the schemas on the current path, 2 for
+// those that are done.
+bool SchemaValidator::hasRecursion(
+    uint32_t schema, std::vector<uint8_t>& state) const {
+  if (state[schema] != 0) {
+    return state[schema] == 1;
   }
-  IValidator* validator_;
-};
-
-struct NotValidator final : IValidator {
-  NotValidator(SchemaValidatorContext& context, const dynamic& schema)
-      : validator_(SchemaValidator::make(context, schema)) {}
-
-  Optional<SchemaError> validate(
-      ValidationContext& vc, const dynamic& value) const override {
-    if (vc.validate(validator_.get(), value)) {
-      return none;
+  state[schema] = 1;
+  auto visit = [&](uint32_t sub) {
+    return sub != kNoSchema && hasRecursion(sub, state);
+  };
+  for (auto i = schemas_[schema].begin; i != schemas_[schema].end; ++i) {
+    const auto& in = code_[i];
+    switch (in.op) {
+      case Op::kNot:
+      case Op::kRef:
+        if (visit(in.a)) {
+          return true;
+        }
+        break;
+      case Op::kAllOf:
+      case Op::kAnyOf:
+      case Op::kOneOf:
+        for (auto j = in.a; j != in.a + in.b; ++j) {
+          if (visit(lists_[j])) {
+            return true;
+          }
+        }
+        break;
+      case Op::kDependencies:
+        for (auto j = in.a; j != in.a + in.b; ++j) {
+          if (visit(dependencies_[j].schema)) {
+            return true;
+          }
+        }
+        break;
+      default:
+        break;
     }
-    return makeError("Expected schema validation to fail", value);
   }
-  std::unique_ptr<IValidator> validator_;
-};
+  state[schema] = 2;
+  return false;
+}
 
-void SchemaValidator::loadSchema(
-    SchemaValidatorContext& context, const dynamic& schema) {
-  if (!schema.isObject() || schema.empty()) {
-    return;
+uint32_t SchemaValidator::findProperty(
+    const PropertyTable& table, StringPiece key) const {
+  auto hash = hasher<StringPiece>()(key);
+  for (auto i = hash & table.mask;; i = (i + 1) & table.mask) {
+    const auto& slot = slots_[table.slots + i];
+    if (slot.schema == kNoSchema) {
+      return kNoSchema;
+    }
+    if (slot.hash == hash && keys_[slot.key] == key) {
+      return slot.schema;
+    }
   }
+}
 
-  // Check for $ref, if we have one we won't apply anything else. Refs are
-  // pointers to other parts of the json, e.g. #/foo/bar points to the schema
-  // located at root["foo"]["bar"].
-  if (const auto* p = schema.get_ptr("$ref")) {
-    // We only support absolute refs, i.e. those starting with '#'
-    if (p->isString() && p->stringPiece()[0] == '#') {
-      auto it = context.refs.find(p->getString());
-      if (it != context.refs.end()) {
-        validators_.emplace_back(std::make_unique<RefValidator>(it->second));
-        return;
+bool SchemaValidator::run(
+    uint32_t schema,
+    const dynamic& value,
+    const Active* parent,
+    Failure& failure) const {
+  if (checkRecursion_) {
+    for (auto p = parent; p && p->value == &value; p = p->parent) {
+      if (p->schema == schema) {
+        throw std::runtime_error("Infinite recursion detected");
       }
-
-      // This is a ref, but we haven't loaded it yet. Find where it is based on
-      // the root schema.
-      std::vector<std::string> parts;
-      split("/", p->stringPiece(), parts);
-      const auto* s = &context.schema; // First part is '#'
-      for (size_t i = 1; s && i < parts.size(); ++i) {
-        // Per the standard, we must replace ~1 with / and then ~0 with ~
-        boost::replace_all(parts[i], "~1", "/");
-        boost::replace_all(parts[i], "~0", "~");
-        if (s->isObject()) {
-          s = s->get_ptr(parts[i]);
-          continue;
+    }
+  }
+  const Active active{schema, &value, parent};
+  auto fail = [&](const Instruction& in, uint32_t key = 0) {
+    failure = {&in, &value, key};
+    return false;
+  };
+
+  const auto& block = schemas_[schema];
+  for (auto i = block.begin; i != block.end; ++i) {
+    const auto& in = code_[i];
+    switch (in.op) {
+      case Op::kMultipleOf:
+        if (!value.isNumber()) {
+          break;
+        }
+        if (in.isDouble || value.isDouble()) {
+          auto divisor = in.isDouble ? in.number : double(in.integer);
+          auto rem = folly::remainder(value.asDouble(), divisor);
+          if (std::abs(rem) > std::numeric_limits<double>::epsilon()) {
+            return fail(in);
+          }
+        } else if (
+            in.integer != 0 && in.integer != -1 &&
+            value.getInt() % in.integer != 0) {
+          return fail(in);
+        }
+        break;
+      case Op::kMinimum:
+      case Op::kMaximum: {
+        if (!value.isNumber()) {
+          break;
+        }
+        // The sign of value - bound.
+        int cmp;
+        if (in.isDouble || value.isDouble()) {
+          auto bound = in.isDouble ? in.number : double(in.integer);
+          auto v = value.asDouble();
+          cmp = v < bound ? -1 : v > bound ? 1 : 0;
+        } else {
+          auto v = value.getInt();
+          cmp = v < in.integer ? -1 : v > in.integer ? 1 : 0;
+        }
+        if (in.op == Op::kMaximum) {
+          cmp = -cmp;
         }
-        if (s->isArray()) {
-          try {
-            const size_t pos = to<size_t>(parts[i]);
-            if (pos < s->size()) {
-              s = s->get_ptr(pos);
-              continue;
+        if (cmp < 0 || (cmp == 0 && in.flag)) {
+          return fail(in);
+        }
+        break;
+      }
+      case Op::kMinSize:
+        if (value.type() == in.type && int64_t(value.size()) < in.integer) {
+          return fail(in);
+        }
+        break;
+      case Op::kMaxSize:
+        if (value.type() == in.type && int64_t(value.size()) > in.integer) {
+          return fail(in);
+        }
+        break;
+      case Op::kPattern:
+        if (value.isString()) {
+          auto s = value.stringPiece();
+          if (!boost::regex_search(s.begin(), s.end(), regexes_[in.a])) {
+            return fail(in);
+          }
+        }
+        break;
+      case Op::kItems:
+        if (value.isArray()) {
+          for (const auto& item : value) {
+            if (!run(in.a, item, &active, failure)) {
+              return false;
             }
-          } catch (const std::range_error&) {
-            // ignore
+          }
+        }
+        break;
+      case Op::kTupleItems:
+        if (value.isArray()) {
+          size_t pos = 0;
+          for (; pos < value.size() && pos < in.b; ++pos) {
+            if (!run(lists_[in.a + pos], value[pos], &active, failure)) {
+              return false;
+            }
+          }
+          if (!in.flag && pos < value.size()) {
+            return fail(in);
+          }
+          if (in.c != kNoSchema) {
+            for (; pos < value.size(); ++pos) {
+              if (!run(in.c, value[pos], &active, failure)) {
+                return false;
+              }
+            }
+          }
+        }
+        break;
+      case Op::kUniqueItems:
+        if (value.isArray()) {
+          for (size_t j = 0; j < value.size(); ++j) {
+            for (size_t k = j + 1; k < value.size(); ++k) {
+              if (value[j] == value[k]) {
+                return fail(in);
+              }
+            }
+          }
+        }
+        break;
+      case Op::kProperties: {
+        if (!value.isObject()) {
+          break;
+        }
+        const auto& table = tables_[in.a];
+        for (const auto& pair : value.items()) {
+          if (!pair.first.isString()) {
+            continue;
+          }
+          auto key = pair.first.stringPiece();
+          bool matched = false;
+          auto sub = findProperty(table, key);
+          if (sub != kNoSchema) {
+            if (!run(sub, pair.second, &active, failure)) {
+              return false;
+            }
+            matched = true;
+          }
+          for (auto j = table.patterns;
+               j != table.patterns + table.patternCount;
+               ++j) {
+            const auto& [regex, patternSchema] = patterns_[j];
+            if (boost::regex_search(key.begin(), key.end(), regexes_[regex])) {
+              if (!run(patternSchema, pair.second, &active, failure)) {
+                return false;
+              }
+              matched = true;
+            }
+          }
+          if (matched) {
+            continue;
+          }
+          if (!table.allowAdditional) {
+            return fail(in);
+          }
+          if (table.additional != kNoSchema &&
+              !run(table.additional, pair.second, &active, failure)) {
+            return false;
           }
         }
         break;
       }
-      // If you have a self-recursive reference, this avoids getting into an
-      // infinite recursion, where we try to load a schema that just references
-      // itself, and then we try to load it again, and so on.
-      // Instead we load a pointer to the schema into the refs, so that any
-      // future references to it will just see that pointer and won't try to
-      // keep parsing further.
-      if (s) {
-        auto v = std::make_unique<SchemaValidator>();
-        context.refs[p->getString()] = v.get();
-        v->loadSchema(context, *s);
-        validators_.emplace_back(std::move(v));
-        return;
+      case Op::kRequired:
+        if (value.isObject()) {
+          for (auto j = in.a; j != in.a + in.b; ++j) {
+            if (!value.get_ptr(keys_[lists_[j]])) {
+              return fail(in, lists_[j]);
+            }
+          }
+        }
+        break;
+      case Op::kDependencies:
+        if (!value.isObject()) {
+          break;
+        }
+        for (auto j = in.a; j != in.a + in.b; ++j) {
+          const auto& dep = dependencies_[j];
+          if (!value.get_ptr(keys_[dep.key])) {
+            continue;
+          }
+          for (auto k = dep.keys; k != dep.keys + dep.keyCount; ++k) {
+            if (!value.get_ptr(keys_[lists_[k]])) {
+              return fail(in, lists_[k]);
+            }
+          }
+          if (dep.schema != kNoSchema &&
+              !run(dep.schema, value, &active, failure)) {
+            return false;
+          }
+        }
+        break;
+      case Op::kEnum: {
+        const auto& values = constants_[in.a];
+        if (std::find(values.begin(), values.end(), value) == values.end()) {
+          return fail(in);
+        }
+        break;
       }
+      case Op::kType:
+        if (!(in.a & (1u << value.type()))) {
+          return fail(in);
+        }
+        break;
+      case Op::kAllOf:
+        for (auto j = in.a; j != in.a + in.b; ++j) {
+          if (!run(lists_[j], value, &active, failure)) {
+            return false;
+          }
+        }
+        break;
+      case Op::kAnyOf:
+      case Op::kOneOf: {
+        // The failures of the subschemas are not reported.
+        Failure ignored;
+        uint32_t valid = 0;
+        for (auto j = in.a; j != in.a + in.b; ++j) {
+          if (run(lists_[j], value, &active, ignored) &&
+              (++valid == 2 || in.op == Op::kAnyOf)) {
+            break;
+          }
+        }
+        if (valid == 0 || (valid > 1 && in.op == Op::kOneOf)) {
+          return fail(in, valid);
+        }
+        break;
+      }
+      case Op::kNot: {
+        Failure ignored;
+        if (run(in.a, value, &active, ignored)) {
+          return fail(in);
+        }
+        break;
+      }
+      case Op::kRef:
+        if (!run(in.a, value, &active, failure)) {
+          return false;
+        }
+        break;
     }
   }
+  return true;
+}
 
-  // Numeric validators
-  if (const auto* p = schema.get_ptr("multipleOf")) {
-    validators_.emplace_back(std::make_unique<MultipleOfValidator>(*p));
-  }
-  if (const auto* p = schema.get_ptr("maximum")) {
-    validators_.emplace_back(std::make_unique<ComparisonValidator>(
-        *p,
-        schema.get_ptr("exclusiveMaximum"),
-        ComparisonValidator::Type::MAX));
-  }
-  if (const auto* p = schema.get_ptr("minimum")) {
-    validators_.emplace_back(std::make_unique<ComparisonValidator>(
-        *p,
-        schema.get_ptr("exclusiveMinimum"),
-        ComparisonValidator::Type::MIN));
-  }
-
-  // String validators
-  if (const auto* p = schema.get_ptr("maxLength")) {
-    validators_.emplace_back(
-        std::make_unique<SizeValidator<std::greater_equal<int64_t>>>(
-            *p, dynamic::Type::STRING));
-  }
-  if (const auto* p = schema.get_ptr("minLength")) {
-    validators_.emplace_back(
-        std::make_unique<SizeValidator<std::less_equal<int64_t>>>(
-            *p, dynamic::Type::STRING));
-  }
-  if (const auto* p = schema.get_ptr("pattern")) {
-    validators_.emplace_back(std::make_unique<StringPatternValidator>(*p));
-  }
-
-  // Array validators
-  const auto* items = schema.get_ptr("items");
-  const auto* additionalItems = schema.get_ptr("additionalItems");
-  if (items || additionalItems) {
-    validators_.emplace_back(
-        std::make_unique<ArrayItemsValidator>(context, items, additionalItems));
-  }
-  if (const auto* p = schema.get_ptr("maxItems")) {
-    validators_.emplace_back(
-        std::make_unique<SizeValidator<std::greater_equal<int64_t>>>(
-            *p, dynamic::Type::ARRAY));
-  }
-  if (const auto* p = schema.get_ptr("minItems")) {
-    validators_.emplace_back(
-        std::make_unique<SizeValidator<std::less_equal<int64_t>>>(
-            *p, dynamic::Type::ARRAY));
-  }
-  if (const auto* p = schema.get_ptr("uniqueItems")) {
-    validators_.emplace_back(std::make_unique<ArrayUniqueValidator>(*p));
-  }
-
-  // Object validators
-  const auto* properties = schema.get_ptr("properties");
-  const auto* patternProperties = schema.get_ptr("patternProperties");
-  const auto* additionalProperties = schema.get_ptr("additionalProperties");
-  if (properties || patternProperties || additionalProperties) {
-    validators_.emplace_back(std::make_unique<PropertiesValidator>(
-        context, properties, patternProperties, additionalProperties));
-  }
-  if (const auto* p = schema.get_ptr("maxProperties")) {
-    validators_.emplace_back(
-        std::make_unique<SizeValidator<std::greater_equal<int64_t>>>(
-            *p, dynamic::Type::OBJECT));
-  }
-  if (const auto* p = schema.get_ptr("minProperties")) {
-    validators_.emplace_back(
-        std::make_unique<SizeValidator<std::less_equal<int64_t>>>(
-            *p, dynamic::Type::OBJECT));
-  }
-  if (const auto* p = schema.get_ptr("required")) {
-    validators_.emplace_back(std::make_unique<RequiredValidator>(*p));
-  }
-
-  // Misc validators
-  if (const auto* p = schema.get_ptr("dependencies")) {
-    validators_.emplace_back(
-        std::make_unique<DependencyValidator>(context, *p));
-  }
-  if (const auto* p = schema.get_ptr("enum")) {
-    validators_.emplace_back(std::make_unique<EnumValidator>(*p));
-  }
-  if (const auto* p = schema.get_ptr("type")) {
-    validators_.emplace_back(std::make_unique<TypeValidator>(*p));
-  }
-  if (const auto* p = schema.get_ptr("allOf")) {
-    validators_.emplace_back(std::make_unique<AllOfValidator>(context, *p));
-  }
-  if (const auto* p = schema.get_ptr("anyOf")) {
-    validators_.emplace_back(std::make_unique<AnyOfValidator>(
-        context, *p, AnyOfValidator::Type::ONE_OR_MORE));
-  }
-  if (const auto* p = schema.get_ptr("oneOf")) {
-    validators_.emplace_back(std::make_unique<AnyOfValidator>(
-        context, *p, AnyOfValidator::Type::EXACTLY_ONE));
-  }
-  if (const auto* p = schema.get_ptr("not")) {
-    validators_.emplace_back(std::make_unique<NotValidator>(context, *p));
+SchemaError SchemaValidator::makeError(const Failure& failure) const {
+  const auto& in = *failure.instruction;
+  const auto& value = *failure.value;
+  switch (in.op) {
+    case Op::kMultipleOf:
+      return SchemaError("a multiple of ", constants_[in.a], value);
+    case Op::kMinimum:
+      return in.flag
+          ? SchemaError("greater than ", constants_[in.a], value)
+          : SchemaError("greater than or equal to ", constants_[in.a], value);
+    case Op::kMaximum:
+      return in.flag
+          ? SchemaError("less than ", constants_[in.a], value)
+          : SchemaError("less than or equal to ", constants_[in.a], value);
+    case Op::kMinSize:
+    case Op::kMaxSize:
+      return SchemaError("different length string/array/object", value);
+    case Op::kPattern:
+      return SchemaError("string matching regex", value);
+    case Op::kTupleItems:
+      return SchemaError("no more additional items", value);
+    case Op::kUniqueItems:
+      return SchemaError("unique items in array", value);
+    case Op::kProperties:
+      return SchemaError("no more additional properties", value);
+    case Op::kRequired:
+    case Op::kDependencies:
+      return SchemaError("property ", keys_[failure.key], value);
+    case Op::kEnum:
+      return SchemaError("one of enum values: ", constants_[in.a], value);
+    case Op::kType:
+      return SchemaError("a value of type ", constants_[in.c], value);
+    case Op::kAnyOf:
+    case Op::kOneOf:
+      return failure.key == 0
+          ? SchemaError("at least one valid schema", value)
+          : SchemaError("exactly one valid schema", value);
+    case Op::kNot:
+      return SchemaError("Expected schema validation to fail", value);
+    case Op::kItems:
+    case Op::kAllOf:
+    case Op::kRef:
+      break;
   }
+  // These report the failures of their subschemas.
+  throw std::logic_error("Unexpected schema failure");
 }
 
 void SchemaValidator::validate(const dynamic& value) const {
-  ValidationContext vc;
-  if (auto se = validate(vc, value)) {
-    throw *se;
+  Failure failure;
+  if (!run(0, value, nullptr, failure)) {
+    throw makeError(failure);
   }
 }
 
 exception_wrapper SchemaValidator::try_validate(
     const dynamic& value) const noexcept {
   try {
-    ValidationContext vc;
-    if (auto se = validate(vc, value)) {
-      return make_exception_wrapper<SchemaError>(*se);
+    Failure failure;
+    if (!run(0, value, nullptr, failure)) {
+      return make_exception_wrapper<SchemaError>(makeError(failure));
     }
   } catch (...) {
     return exception_wrapper(current_exception());
@@ -838,16 +950,6 @@ exception_wrapper SchemaValidator::try_validate(
   return exception_wrapper();
 }
 
-Optional<SchemaError> SchemaValidator::validate(
-    ValidationContext& vc, const dynamic& value) const {
-  for (const auto& validator : validators_) {
-    if (auto se = vc.validate(validator.get(), value)) {
-      return se;
-    }
-  }
-  return none;
-}
-
 /**
  * Metaschema, i.e. schema for schema.
  * Inlined from the $schema url
@@ -1016,11 +1118,7 @@ folly::Singleton<Validator> schemaValidator([]() {
 Validator::~Validator() = default;
 
 std::unique_ptr<Validator> makeValidator(const dynamic& schema) {
-  auto v = std::make_unique<SchemaValidator>();
-  SchemaValidatorContext context(schema);
-  context.refs["#"] = v.get();
-  v->loadSchema(context, schema);
-  return v;
+  return std::make_unique<SchemaValidator>(schema);
 }
 
 std::shared_ptr<Validator> makeSchemaValidator() {
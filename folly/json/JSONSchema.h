@@ -61,6 +61,10 @@ struct Validator {
 
 /**
  * Make a validator that can be used to check various json. Thread-safe.
+ *
+ * The schema is compiled into a flat program once, here; validating a value
+ * that passes does not allocate. The validator does not refer to schema
+ * after it is made.
  */
 std::unique_ptr<Validator> makeValidator(const dynamic& schema);
 
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * JsonConverter decodes json text straight into C++ types, without building
+ * a dynamic first:
+ *
+ *   auto v = parseJsonAs<std::vector<F14FastMap<std::string, int>>>(text);
+ *
+ * gives the same result as, but allocates much less than
+ *
+ *   auto v = convertTo<std::vector<F14FastMap<std::string, int>>>(
+ *       parseJson(text));
+ *
+ * The supported types and the conversions are those of DynamicConverter.h:
+ * arithmetic types and enums, strings, pairs, optionals, containers and
+ * associative containers. Duplicate keys in an object decoded into a map keep
+ * the last value, as in parseJson. Any other type is decoded by parsing its
+ * value into a dynamic and calling convertTo, so DynamicConverter
+ * specializations keep working. Specialize JsonConverter, in namespace folly,
+ * to decode a type directly; json::convertFields() does it for simple
+ * structs:
+ *
+ *   struct Point {
+ *     int x = 0;
+ *     int y = 0;
+ *   };
+ *
+ *   template <>
+ *   struct JsonConverter<Point> {
+ *     static Point convert(json::reader& reader) {
+ *       return json::convertFields<Point>(
+ *           reader, json::field("x", &Point::x), json::field("y", &Point::y));
+ *     }
+ *   };
+ *
+ * @file JsonConverter.h
+ */
+
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <folly/FBString.h>
+#include <folly/Range.h>
+#include <folly/Traits.h>
+#include <folly/json/DynamicConverter.h>
+#include <folly/json/dynamic.h>
+#include <folly/json/json.h>
+#include <folly/json/json_reader.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+
+/**
+ * Decode the next value of the reader.
+ *
+ * @see JsonConverter for supported types and customization
+ */
+template <typename T>
+T convertTo(json::reader& reader);
+
+/**
+ * Decode a json document, with the same result as
+ * convertTo<T>(parseJson(range, opts)).
+ */
+template <typename T>
+T parseJsonAs(StringPiece range, json::serialization_opts const& opts);
+template <typename T>
+T parseJsonAs(StringPiece range);
+
+namespace jsonconverter_detail {
+
+template <typename T>
+using detect_try_emplace = decltype(std::declval<T&>().try_emplace(
+    std::declval<typename T::key_type>(),
+    std::declval<typename T::mapped_type>()));
+
+// Keys are only valid until the next read: convert them first.
+template <typename K>
+K convertKey(StringPiece key) {
+  if constexpr (std::is_same<K, std::string>::value) {
+    return std::string(key);
+  } else {
+    return convertTo<K>(dynamic(key));
+  }
+}
+
+// The element of a container decoded from an object member, like the
+// conversion of dynamic::items().
+template <typename T>
+T convertMember(StringPiece key, json::reader& reader) {
+  if constexpr (is_instantiation_of_v<std::pair, T>) {
+    auto first = convertKey<typename T::first_type>(key);
+    return T(std::move(first), convertTo<typename T::second_type>(reader));
+  } else {
+    throw_exception<TypeError>("array", dynamic::Type::OBJECT);
+  }
+}
+
+[[noreturn]] inline void throwTypeError(
+    char const* expected, json::reader& reader) {
+  throw_exception<TypeError>(expected, reader.readValue().type());
+}
+
+} // namespace jsonconverter_detail
+
+///////////////////////////////////////////////////////////////////////////////
+// JsonConverter specializations
+
+/**
+ * Each specialization of JsonConverter has the function
+ *     'static T convert(json::reader&);'
+ * which reads exactly one value.
+ */
+
+// default - through dynamic and DynamicConverter
+template <typename T, typename Enable = void>
+struct JsonConverter {
+  static T convert(json::reader& reader) {
+    return convertTo<T>(reader.readValue());
+  }
+};
+
+// dynamic
+template <>
+struct JsonConverter<dynamic> {
+  static dynamic convert(json::reader& reader) { return reader.readValue(); }
+};
+
+// strings
+template <>
+struct JsonConverter<std::string> {
+  static std::string convert(json::reader& reader) {
+    if (reader.peek() == '"') {
+      return reader.readString();
+    }
+    return convertTo<std::string>(reader.readValue());
+  }
+};
+
+template <>
+struct JsonConverter<fbstring> {
+  static fbstring convert(json::reader& reader) {
+    if (reader.peek() == '"') {
+      auto s = reader.readStringPiece();
+      return fbstring(s.data(), s.size());
+    }
+    return convertTo<fbstring>(reader.readValue());
+  }
+};
+
+// std::pair
+template <typename F, typename S>
+struct JsonConverter<std::pair<F, S>> {
+  static std::pair<F, S> convert(json::reader& reader) {
+    constexpr auto kExpected = "array (size 2) or object (size 1)";
+    switch (reader.peek()) {
+      case '[': {
+        reader.beginArray();
+        if (!reader.nextElement()) {
+          throw_exception<TypeError>(kExpected, dynamic::Type::ARRAY);
+        }
+        auto first = convertTo<F>(reader);
+        if (!reader.nextElement()) {
+          throw_exception<TypeError>(kExpected, dynamic::Type::ARRAY);
+        }
+        auto second = convertTo<S>(reader);
+        if (reader.nextElement()) {
+          throw_exception<TypeError>(kExpected, dynamic::Type::ARRAY);
+        }
+        return std::pair<F, S>(std::move(first), std::move(second));
+      }
+      case '{': {
+        reader.beginObject();
+        StringPiece key;
+        if (!reader.nextKey(key)) {
+          throw_exception<TypeError>(kExpected, dynamic::Type::OBJECT);
+        }
+        auto ret = jsonconverter_detail::convertMember<std::pair<F, S>>(
+            key, reader);
+        if (reader.nextKey(key)) {
+          throw_exception<TypeError>(kExpected, dynamic::Type::OBJECT);
+        }
+        return ret;
+      }
+      default:
+        jsonconverter_detail::throwTypeError(kExpected, reader);
+    }
+  }
+};
+
+// optionals
+template <typename T>
+struct JsonConverter<
+    T,
+    typename std::enable_if<
+        dynamicconverter_detail::is_optional<T>::value>::type> {
+  static T convert(json::reader& reader) {
+    if (reader.peek() == 'n') {
+      reader.skipValue();
+      return {};
+    }
+    return convertTo<typename T::value_type>(reader);
+  }
+};
+
+// non-associative containers
+template <typename C>
+struct JsonConverter<
+    C,
+    typename std::enable_if<
+        dynamicconverter_detail::is_container<C>::value &&
+        !dynamicconverter_detail::is_associative<C>::value>::type> {
+  static C convert(json::reader& reader) {
+    using value_type = typename C::value_type;
+    C ret;
+    switch (reader.peek()) {
+      case '[':
+        reader.beginArray();
+        while (reader.nextElement()) {
+          ret.insert(ret.end(), convertTo<value_type>(reader));
+        }
+        break;
+      case '{': {
+        reader.beginObject();
+        StringPiece key;
+        while (reader.nextKey(key)) {
+          ret.insert(
+              ret.end(),
+              jsonconverter_detail::convertMember<value_type>(key, reader));
+        }
+        break;
+      }
+      default:
+        jsonconverter_detail::throwTypeError("object or array", reader);
+    }
+    return ret;
+  }
+};
+
+// associative containers
+template <typename C>
+struct JsonConverter<
+    C,
+    typename std::enable_if<
+        dynamicconverter_detail::is_container<C>::value &&
+        dynamicconverter_detail::is_associative<C>::value>::type> {
+  static C convert(json::reader& reader) {
+    using value_type = typename C::value_type;
+    C ret;
+    switch (reader.peek()) {
+      case '[':
+        reader.beginArray();
+        while (reader.nextElement()) {
+          ret.insert(convertTo<value_type>(reader));
+        }
+        break;
+      case '{':
+        reader.beginObject();
+        convertObject(reader, ret);
+        break;
+      default:
+        jsonconverter_detail::throwTypeError("object or array", reader);
+    }
+    return ret;
+  }
+
+ private:
+  static void convertObject(json::reader& reader, C& ret) {
+    StringPiece key;
+    while (reader.nextKey(key)) {
+      if constexpr (is_detected_v<
+                        jsonconverter_detail::detect_try_emplace,
+                        C>) {
+        auto k = jsonconverter_detail::convertKey<typename C::key_type>(key);
+        auto v = convertTo<typename C::mapped_type>(reader);
+        auto [it, inserted] = ret.try_emplace(std::move(k), std::move(v));
+        if (!inserted) {
+          if (reader.opts().validate_keys) {
+            reader.error("duplicate key inserted");
+          }
+          it->second = std::move(v);
+        }
+      } else {
+        using value_type = std::remove_const_t<typename C::value_type>;
+        ret.insert(
+            jsonconverter_detail::convertMember<value_type>(key, reader));
+      }
+    }
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+namespace json {
+
+template <typename T, typename M>
+struct field_binding {
+  StringPiece name;
+  M T::*member;
+};
+
+/**
+ * Bind a json object key to a data member, for convertFields.
+ */
+template <typename T, typename M>
+constexpr field_binding<T, M> field(StringPiece name, M T::*member) {
+  return {name, member};
+}
+
+namespace detail {
+template <typename T, typename M>
+bool convertField(
+    reader& reader, StringPiece key, T& ret, field_binding<T, M> const& field) {
+  if (key != field.name) {
+    return false;
+  }
+  ret.*field.member = convertTo<M>(reader);
+  return true;
+}
+} // namespace detail
+
+/**
+ * Decode an object into a value-initialized T, setting the bound members from
+ * the keys that are present. Other keys are skipped.
+ */
+template <typename T, typename... Fields>
+T convertFields(reader& reader, Fields const&... fields) {
+  if (reader.peek() != '{') {
+    jsonconverter_detail::throwTypeError("object", reader);
+  }
+  T ret{};
+  reader.beginObject();
+  StringPiece key;
+  while (reader.nextKey(key)) {
+    bool const found = (detail::convertField(reader, key, ret, fields) || ...);
+    if (!found) {
+      reader.skipValue();
+    }
+  }
+  return ret;
+}
+
+} // namespace json
+
+///////////////////////////////////////////////////////////////////////////////
+// implementation
+
+template <typename T>
+T convertTo(json::reader& reader) {
+  return JsonConverter<typename std::remove_cv<T>::type>::convert(reader);
+}
+
+template <typename T>
+T parseJsonAs(StringPiece range, json::serialization_opts const& opts) {
+  json::reader reader(range, opts);
+  auto ret = convertTo<T>(reader);
+  reader.finish();
+  return ret;
+}
+
+template <typename T>
+T parseJsonAs(StringPiece range) {
+  json::reader reader(range);
+  auto ret = convertTo<T>(reader);
+  reader.finish();
+  return ret;
+}
+
+} // namespace folly
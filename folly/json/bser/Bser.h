@@ -16,10 +16,14 @@
 
 #pragma once
 
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <folly/CPortability.h>
 #include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/json/dynamic.h>
@@ -100,6 +104,169 @@ size_t decodePduLength(const folly::IOBuf*);
 folly::fbstring toBser(folly::dynamic const&, const serialization_opts&);
 std::unique_ptr<folly::IOBuf> toBserIOBuf(
     folly::dynamic const&, const serialization_opts&);
+
+// Decodes BSER values one at a time, straight from an IOBuf chain, without
+// building a dynamic:
+//
+//   BserReader reader(pdu.get());
+//   reader.readPduHeader();
+//   auto n = reader.beginObject();
+//   while (n-- > 0) {
+//     auto key = reader.readString();
+//     if (key == "name") {
+//       use(reader.readString());
+//     } else {
+//       reader.skipValue();
+//     }
+//   }
+//
+// Strings are returned as views into the buffer when they do not straddle
+// two buffers of the chain, and are copied otherwise. Either way, they are
+// only valid until the next call on the reader.
+//
+// Reading a value of the wrong type throws BserDecodeError; running out of
+// data throws std::out_of_range, like parseBser.
+class BserReader {
+ public:
+  explicit BserReader(const folly::IOBuf* buf) : cursor_(buf) {}
+  explicit BserReader(folly::io::Cursor cursor) : cursor_(cursor) {}
+
+  // Read the header of a PDU and return the length of the value that
+  // follows it.
+  size_t readPduHeader();
+
+  // The type of the next value. Integers are reported as Int8 to Int64,
+  // and a key missing from a templated object as Skip.
+  BserType peekType() { return BserType(cursor_.peekBytes().at(0)); }
+
+  int64_t readInt();
+  double readReal();
+  bool readBool();
+  void readNull();
+  folly::StringPiece readString();
+
+  // Step into an array and return its number of elements, each to be read
+  // or skipped in turn.
+  size_t beginArray();
+
+  // Step into an object and return its number of members, each to be read
+  // as a key, with readString(), and a value.
+  size_t beginObject();
+
+  // Step into an array of templated objects: set names to the keys of the
+  // objects and return their number. Each object is len(names) values, one
+  // per key, any of which may be Skip.
+  size_t beginTemplate(std::vector<std::string>& names);
+
+  // Skip the next value, or Skip marker.
+  void skipValue();
+
+  // Read the next value as parseBser would.
+  folly::dynamic readValue();
+
+  const folly::io::Cursor& cursor() const { return cursor_; }
+
+ private:
+  int64_t readIntOf(BserType enc);
+  void expect(BserType type, const char* what);
+  [[noreturn]] void throwDecodeError(folly::StringPiece what);
+
+  folly::io::Cursor cursor_;
+  std::string scratch_;
+};
+
+// Splits a stream of bytes, received in chunks of any size, into complete
+// PDUs:
+//
+//   splitter.append(std::move(chunk));
+//   while (auto pdu = splitter.next()) {
+//     BserReader reader(pdu.get());
+//     ...
+//   }
+//
+// PDUs are split off the buffers they arrived in, without copying.
+class BserPduSplitter {
+ public:
+  void append(std::unique_ptr<folly::IOBuf> buf) {
+    queue_.append(std::move(buf));
+  }
+  void append(folly::ByteRange bytes) {
+    queue_.append(bytes.data(), bytes.size());
+  }
+
+  // The next complete PDU, header included, or nullptr if more data is
+  // needed. Throws if the stream is not BSER.
+  std::unique_ptr<folly::IOBuf> next();
+
+  // The number of bytes received but not returned by next() yet.
+  size_t pending() const { return queue_.chainLength(); }
+
+ private:
+  folly::IOBufQueue queue_{folly::IOBufQueue::cacheChainLength()};
+  // The length of the PDU at the front of the queue, once its header is in.
+  size_t pduLength_{0};
+};
+
+// Encodes BSER values one at a time into an IOBufQueue. Values written
+// between beginPdu() and endPdu() form a PDU:
+//
+//   BserWriter writer(queue);
+//   writer.beginPdu();
+//   writer.beginObject(2);
+//   writer.writeString("name");
+//   writer.writeString(path);
+//   writer.writeString("size");
+//   writer.writeInt(size);
+//   writer.endPdu();
+//
+// The length of a PDU is only known at its end: beginPdu() leaves room for
+// a 32 bit length, which endPdu() fills in, so PDUs are limited to 2GB.
+// The queue must not be modified while a PDU is being written.
+class BserWriter {
+ public:
+  explicit BserWriter(folly::IOBufQueue& queue, size_t growth = 8192)
+      : appender_(&queue, growth) {}
+
+  void beginPdu();
+  void endPdu();
+
+  void writeInt(int64_t value);
+  void writeReal(double value);
+  void writeBool(bool value) {
+    write(int8_t(value ? BserType::True : BserType::False));
+  }
+  void writeNull() { write(int8_t(BserType::Null)); }
+  void writeString(folly::StringPiece value);
+
+  // Followed by size values.
+  void beginArray(size_t size);
+
+  // Followed by size keys, written with writeString(), and values.
+  void beginObject(size_t size);
+
+  // Followed by size objects, each written as len(names) values, one per
+  // key, or writeSkip() for a key that the object does not have.
+  void beginTemplate(
+      folly::Range<const folly::StringPiece*> names, size_t size);
+  void writeSkip() { write(int8_t(BserType::Skip)); }
+
+  // Write a value as toBser would.
+  void writeValue(folly::dynamic const& dyn, const serialization_opts& opts);
+
+ private:
+  template <typename T>
+  void write(T value) {
+    appender_.write(value);
+    size_ += sizeof(T);
+  }
+
+  folly::io::QueueAppender appender_;
+  // The number of bytes written.
+  size_t size_{0};
+  // The length field of the current PDU, and the value of size_ after it.
+  uint8_t* pduLength_{nullptr};
+  size_t pduBegin_{0};
+};
 } // namespace bser
 } // namespace folly
 
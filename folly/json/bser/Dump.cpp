@@ -20,7 +20,6 @@
 
 using namespace folly;
 using folly::bser::serialization_opts;
-using folly::io::QueueAppender;
 
 namespace folly {
 namespace bser {
@@ -28,9 +27,7 @@ namespace bser {
 const uint8_t kMagic[2] = {0, 1};
 
 static void bserEncode(
-    dynamic const& dyn,
-    QueueAppender& appender,
-    const serialization_opts& opts);
+    dynamic const& dyn, BserWriter& writer, const serialization_opts& opts);
 
 serialization_opts::serialization_opts()
     : sort_keys(false), growth_increment(8192) {}
@@ -48,7 +45,7 @@ static const dynamic* getTemplate(
   return &it->second;
 }
 
-static void bserEncodeInt(int64_t ival, QueueAppender& appender) {
+void BserWriter::writeInt(int64_t ival) {
   /* Return the smallest size int that can store the value */
   auto size =
       ((ival == ((int8_t)ival))        ? 1
@@ -59,56 +56,111 @@ static void bserEncodeInt(int64_t ival, QueueAppender& appender) {
 
   switch (size) {
     case 1:
-      appender.write((int8_t)BserType::Int8);
-      appender.write(int8_t(ival));
+      write((int8_t)BserType::Int8);
+      write(int8_t(ival));
       return;
     case 2:
-      appender.write((int8_t)BserType::Int16);
-      appender.write(int16_t(ival));
+      write((int8_t)BserType::Int16);
+      write(int16_t(ival));
       return;
     case 4:
-      appender.write((int8_t)BserType::Int32);
-      appender.write(int32_t(ival));
+      write((int8_t)BserType::Int32);
+      write(int32_t(ival));
       return;
     case 8:
-      appender.write((int8_t)BserType::Int64);
-      appender.write(ival);
+      write((int8_t)BserType::Int64);
+      write(ival);
       return;
     default:
       throw std::runtime_error("impossible integer size");
   }
 }
 
-static void bserEncodeString(folly::StringPiece str, QueueAppender& appender) {
-  appender.write((int8_t)BserType::String);
-  bserEncodeInt(int64_t(str.size()), appender);
-  appender.push((uint8_t*)str.data(), str.size());
+void BserWriter::writeReal(double value) {
+  write((int8_t)BserType::Real);
+  write(value);
+}
+
+void BserWriter::writeString(folly::StringPiece str) {
+  write((int8_t)BserType::String);
+  writeInt(int64_t(str.size()));
+  appender_.push((const uint8_t*)str.data(), str.size());
+  size_ += str.size();
+}
+
+void BserWriter::beginArray(size_t size) {
+  write((int8_t)BserType::Array);
+  writeInt(int64_t(size));
+}
+
+void BserWriter::beginObject(size_t size) {
+  write((int8_t)BserType::Object);
+  writeInt(int64_t(size));
+}
+
+void BserWriter::beginTemplate(
+    folly::Range<const folly::StringPiece*> names, size_t size) {
+  write((int8_t)BserType::Template);
+  beginArray(names.size());
+  for (auto name : names) {
+    writeString(name);
+  }
+  writeInt(int64_t(size));
+}
+
+void BserWriter::beginPdu() {
+  if (pduLength_) {
+    throw std::logic_error("BSER PDU already begun");
+  }
+  // Keep the length field contiguous, to fill it in place.
+  appender_.ensure(sizeof(kMagic) + 1 + sizeof(int32_t));
+  for (auto b : kMagic) {
+    write(b);
+  }
+  write((int8_t)BserType::Int32);
+  pduLength_ = appender_.writableData();
+  write(int32_t(0));
+  pduBegin_ = size_;
+}
+
+void BserWriter::endPdu() {
+  if (!pduLength_) {
+    throw std::logic_error("no BSER PDU to end");
+  }
+  auto len = size_ - pduBegin_;
+  if (len > uint64_t(std::numeric_limits<int32_t>::max())) {
+    throw std::range_error(folly::to<std::string>(
+        "serialized data size ", len, " is too large for a BserWriter PDU"));
+  }
+  storeUnaligned(pduLength_, int32_t(len));
+  pduLength_ = nullptr;
+}
+
+void BserWriter::writeValue(
+    dynamic const& dyn, const serialization_opts& opts) {
+  bserEncode(dyn, *this, opts);
 }
 
 static void bserEncodeArraySimple(
-    dynamic const& dyn,
-    QueueAppender& appender,
-    const serialization_opts& opts) {
-  appender.write((int8_t)BserType::Array);
-  bserEncodeInt(int64_t(dyn.size()), appender);
+    dynamic const& dyn, BserWriter& writer, const serialization_opts& opts) {
+  writer.beginArray(dyn.size());
   for (const auto& ele : dyn) {
-    bserEncode(ele, appender, opts);
+    bserEncode(ele, writer, opts);
   }
 }
 
 static void bserEncodeArray(
-    dynamic const& dyn,
-    QueueAppender& appender,
-    const serialization_opts& opts) {
+    dynamic const& dyn, BserWriter& writer, const serialization_opts& opts) {
   auto templ = getTemplate(opts, dyn);
   if (FOLLY_UNLIKELY(templ != nullptr)) {
-    appender.write((int8_t)BserType::Template);
-
-    // Emit the list of property names
-    bserEncodeArraySimple(*templ, appender, opts);
-
-    // The number of objects in the array
-    bserEncodeInt(int64_t(dyn.size()), appender);
+    // Emit the list of property names, and the number of objects in the
+    // array
+    std::vector<StringPiece> names;
+    names.reserve(templ->size());
+    for (const auto& name : *templ) {
+      names.push_back(name.stringPiece());
+    }
+    writer.beginTemplate(range(names), dyn.size());
 
     // For each object in the array
     for (const auto& ele : dyn) {
@@ -118,73 +170,64 @@ static void bserEncodeArray(
           if (found->isNull()) {
             // Prefer to Skip rather than encode a null value for
             // compatibility with the other bser implementations
-            appender.write((int8_t)BserType::Skip);
+            writer.writeSkip();
           } else {
-            bserEncode(*found, appender, opts);
+            bserEncode(*found, writer, opts);
           }
         } else {
-          appender.write((int8_t)BserType::Skip);
+          writer.writeSkip();
         }
       }
     }
     return;
   }
 
-  bserEncodeArraySimple(dyn, appender, opts);
+  bserEncodeArraySimple(dyn, writer, opts);
 }
 
 static void bserEncodeObject(
-    dynamic const& dyn,
-    QueueAppender& appender,
-    const serialization_opts& opts) {
-  appender.write((int8_t)BserType::Object);
-  bserEncodeInt(int64_t(dyn.size()), appender);
+    dynamic const& dyn, BserWriter& writer, const serialization_opts& opts) {
+  writer.beginObject(dyn.size());
 
   if (opts.sort_keys) {
     std::vector<std::pair<dynamic, dynamic>> sorted(
         dyn.items().begin(), dyn.items().end());
     std::sort(sorted.begin(), sorted.end());
     for (const auto& item : sorted) {
-      bserEncode(item.first, appender, opts);
-      bserEncode(item.second, appender, opts);
+      bserEncode(item.first, writer, opts);
+      bserEncode(item.second, writer, opts);
     }
   } else {
     for (const auto& item : dyn.items()) {
-      bserEncode(item.first, appender, opts);
-      bserEncode(item.second, appender, opts);
+      bserEncode(item.first, writer, opts);
+      bserEncode(item.second, writer, opts);
     }
   }
 }
 
 static void bserEncode(
-    dynamic const& dyn,
-    QueueAppender& appender,
-    const serialization_opts& opts) {
+    dynamic const& dyn, BserWriter& writer, const serialization_opts& opts) {
   switch (dyn.type()) {
     case dynamic::Type::NULLT:
-      appender.write((int8_t)BserType::Null);
+      writer.writeNull();
       return;
     case dynamic::Type::BOOL:
-      appender.write(
-          (int8_t)(dyn.getBool() ? BserType::True : BserType::False));
+      writer.writeBool(dyn.getBool());
       return;
-    case dynamic::Type::DOUBLE: {
-      double dval = dyn.getDouble();
-      appender.write((int8_t)BserType::Real);
-      appender.write(dval);
+    case dynamic::Type::DOUBLE:
+      writer.writeReal(dyn.getDouble());
       return;
-    }
     case dynamic::Type::INT64:
-      bserEncodeInt(dyn.getInt(), appender);
+      writer.writeInt(dyn.getInt());
       return;
     case dynamic::Type::OBJECT:
-      bserEncodeObject(dyn, appender, opts);
+      bserEncodeObject(dyn, writer, opts);
       return;
     case dynamic::Type::ARRAY:
-      bserEncodeArray(dyn, appender, opts);
+      bserEncodeArray(dyn, writer, opts);
       return;
     case dynamic::Type::STRING:
-      bserEncodeString(dyn.getString(), appender);
+      writer.writeString(dyn.getString());
       return;
   }
 }
@@ -201,8 +244,8 @@ std::unique_ptr<folly::IOBuf> toBserIOBuf(
   q.append(std::move(firstbuf));
 
   // encode the value
-  QueueAppender appender(&q, opts.growth_increment);
-  bserEncode(dyn, appender, opts);
+  BserWriter writer(q, opts.growth_increment);
+  bserEncode(dyn, writer, opts);
 
   // compute the length
   auto len = q.chainLength();
@@ -16,8 +16,11 @@
 
 #include <folly/json/bser/Bser.h>
 
+#include <algorithm>
+
 #include <folly/String.h>
 #include <folly/io/Cursor.h>
+#include <folly/lang/CheckedMath.h>
 
 using namespace folly;
 using folly::io::Cursor;
@@ -239,6 +242,302 @@ folly::dynamic parseBser(ByteRange str) {
 folly::dynamic parseBser(StringPiece str) {
   return parseBser(ByteRange((uint8_t*)str.data(), str.size()));
 }
+
+// The length of the PDU at the front of the data, or none if its header is
+// incomplete.
+static Optional<size_t> tryDecodePduLength(Cursor curs) {
+  if (!curs.canAdvance(sizeof(kMagic) + 1)) {
+    return none;
+  }
+  char header[sizeof(kMagic)];
+  curs.pull(header, sizeof(header));
+  if (memcmp(header, kMagic, sizeof(kMagic))) {
+    throw std::runtime_error("invalid BSER magic header");
+  }
+  size_t int_size;
+  switch ((BserType)curs.peekBytes().at(0)) {
+    case BserType::Int8:
+      int_size = 1;
+      break;
+    case BserType::Int16:
+      int_size = 2;
+      break;
+    case BserType::Int32:
+      int_size = 4;
+      break;
+    case BserType::Int64:
+      int_size = 8;
+      break;
+    case BserType::Array:
+    case BserType::Object:
+    case BserType::String:
+    case BserType::Real:
+    case BserType::True:
+    case BserType::False:
+    case BserType::Null:
+    case BserType::Template:
+    case BserType::Skip:
+    default:
+      throwDecodeError(curs, "invalid PDU length encoding");
+  }
+  if (!curs.canAdvance(1 + int_size)) {
+    return none;
+  }
+  auto len = decodeInt(curs);
+  if (len < 0) {
+    throw std::range_error("PDU length must not be negative");
+  }
+  return int_size + 3 /* magic + int type */ + size_t(len);
+}
+
+size_t BserReader::readPduHeader() {
+  auto begin = cursor_.getCurrentPosition();
+  auto len = decodeHeader(cursor_);
+  return len - (cursor_.getCurrentPosition() - begin);
+}
+
+int64_t BserReader::readIntOf(BserType enc) {
+  switch (enc) {
+    case BserType::Int8:
+      return cursor_.read<int8_t>();
+    case BserType::Int16:
+      return cursor_.read<int16_t>();
+    case BserType::Int32:
+      return cursor_.read<int32_t>();
+    case BserType::Int64:
+      return cursor_.read<int64_t>();
+    case BserType::Array:
+    case BserType::Object:
+    case BserType::String:
+    case BserType::Real:
+    case BserType::True:
+    case BserType::False:
+    case BserType::Null:
+    case BserType::Template:
+    case BserType::Skip:
+    default:
+      throwDecodeError(folly::to<std::string>(
+          "invalid integer encoding detected (", (int8_t)enc, ")"));
+  }
+}
+
+void BserReader::expect(BserType type, const char* what) {
+  if ((BserType)cursor_.read<int8_t>() != type) {
+    throwDecodeError(folly::to<std::string>("expected ", what));
+  }
+}
+
+void BserReader::throwDecodeError(StringPiece what) {
+  bser::throwDecodeError(cursor_, what);
+}
+
+int64_t BserReader::readInt() {
+  return readIntOf((BserType)cursor_.read<int8_t>());
+}
+
+double BserReader::readReal() {
+  expect(BserType::Real, "Real");
+  return cursor_.read<double>();
+}
+
+bool BserReader::readBool() {
+  switch ((BserType)cursor_.read<int8_t>()) {
+    case BserType::True:
+      return true;
+    case BserType::False:
+      return false;
+    case BserType::Array:
+    case BserType::Object:
+    case BserType::String:
+    case BserType::Int8:
+    case BserType::Int16:
+    case BserType::Int32:
+    case BserType::Int64:
+    case BserType::Real:
+    case BserType::Null:
+    case BserType::Template:
+    case BserType::Skip:
+    default:
+      throwDecodeError("expected True or False");
+  }
+}
+
+void BserReader::readNull() {
+  expect(BserType::Null, "Null");
+}
+
+StringPiece BserReader::readString() {
+  expect(BserType::String, "String");
+  auto len = readInt();
+  if (len < 0) {
+    throw std::range_error("string length must not be negative");
+  }
+  auto bytes = cursor_.peekBytes();
+  if (bytes.size() >= size_t(len)) {
+    StringPiece ret(reinterpret_cast<const char*>(bytes.data()), size_t(len));
+    cursor_.skip(size_t(len));
+    return ret;
+  }
+  scratch_.resize(size_t(len));
+  if (cursor_.pullAtMost(&scratch_[0], size_t(len)) != size_t(len)) {
+    throwDecodeError("no data available while decoding a string");
+  }
+  return scratch_;
+}
+
+size_t BserReader::beginArray() {
+  expect(BserType::Array, "Array");
+  return size_t(std::max<int64_t>(readInt(), 0));
+}
+
+size_t BserReader::beginObject() {
+  expect(BserType::Object, "Object");
+  return size_t(std::max<int64_t>(readInt(), 0));
+}
+
+size_t BserReader::beginTemplate(std::vector<std::string>& names) {
+  expect(BserType::Template, "Template");
+  auto n = beginArray();
+  names.clear();
+  names.reserve(n);
+  while (n-- > 0) {
+    names.push_back(readString().str());
+  }
+  return size_t(std::max<int64_t>(readInt(), 0));
+}
+
+void BserReader::skipValue() {
+  auto type = (BserType)cursor_.read<int8_t>();
+  switch (type) {
+    case BserType::Int8:
+    case BserType::Int16:
+    case BserType::Int32:
+    case BserType::Int64:
+      readIntOf(type);
+      return;
+    case BserType::Real:
+      cursor_.skip(sizeof(double));
+      return;
+    case BserType::True:
+    case BserType::False:
+    case BserType::Null:
+    case BserType::Skip:
+      return;
+    case BserType::String: {
+      auto len = readInt();
+      if (len < 0) {
+        throw std::range_error("string length must not be negative");
+      }
+      cursor_.skip(size_t(len));
+      return;
+    }
+    case BserType::Array:
+      for (auto n = readInt(); n > 0; --n) {
+        skipValue();
+      }
+      return;
+    case BserType::Object:
+      for (auto n = readInt(); n > 0; --n) {
+        skipValue();
+        skipValue();
+      }
+      return;
+    case BserType::Template: {
+      expect(BserType::Array, "Array encoding for property names");
+      auto names = std::max<int64_t>(readInt(), 0);
+      for (auto n = names; n > 0; --n) {
+        skipValue();
+      }
+      auto rows = std::max<int64_t>(readInt(), 0);
+      uint64_t values;
+      if (!folly::checked_mul(&values, uint64_t(rows), uint64_t(names))) {
+        throwDecodeError("too many values in template");
+      }
+      for (auto n = values; n > 0; --n) {
+        skipValue();
+      }
+      return;
+    }
+    default:
+      throw std::runtime_error("invalid bser encoding");
+  }
+}
+
+dynamic BserReader::readValue() {
+  switch (peekType()) {
+    case BserType::Int8:
+    case BserType::Int16:
+    case BserType::Int32:
+    case BserType::Int64:
+      return readInt();
+    case BserType::Real:
+      return readReal();
+    case BserType::True:
+    case BserType::False:
+      return readBool();
+    case BserType::Null:
+      cursor_.skip(1);
+      return nullptr;
+    case BserType::String:
+      return readString();
+    case BserType::Array: {
+      dynamic arr = dynamic::array;
+      for (auto n = beginArray(); n > 0; --n) {
+        arr.push_back(readValue());
+      }
+      return arr;
+    }
+    case BserType::Object: {
+      dynamic obj = dynamic::object;
+      for (auto n = beginObject(); n > 0; --n) {
+        dynamic key = readString();
+        obj[std::move(key)] = readValue();
+      }
+      return obj;
+    }
+    case BserType::Template: {
+      std::vector<std::string> names;
+      dynamic arr = dynamic::array;
+      for (auto n = beginTemplate(names); n > 0; --n) {
+        dynamic obj = dynamic::object;
+        for (auto& name : names) {
+          if (peekType() == BserType::Skip) {
+            cursor_.skip(1);
+            obj[name] = nullptr;
+          } else {
+            obj[name] = readValue();
+          }
+        }
+        arr.push_back(std::move(obj));
+      }
+      return arr;
+    }
+    case BserType::Skip:
+      throw std::runtime_error(
+          "Skip not valid at this location in the bser stream");
+    default:
+      throw std::runtime_error("invalid bser encoding");
+  }
+}
+
+std::unique_ptr<IOBuf> BserPduSplitter::next() {
+  if (queue_.empty()) {
+    return nullptr;
+  }
+  if (pduLength_ == 0) {
+    auto len = tryDecodePduLength(Cursor(queue_.front()));
+    if (!len) {
+      return nullptr;
+    }
+    pduLength_ = *len;
+  }
+  if (queue_.chainLength() < pduLength_) {
+    return nullptr;
+  }
+  auto pdu = queue_.split(pduLength_);
+  pduLength_ = 0;
+  return pdu;
+}
 } // namespace bser
 } // namespace folly
 
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/bser/Bser.h>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+using namespace folly;
+using namespace folly::bser;
+
+namespace {
+
+constexpr size_t kNumFiles = 1000;
+
+// A watchman-like query result: an array of file descriptions.
+dynamic makeFiles() {
+  dynamic files = dynamic::array;
+  for (size_t i = 0; i < kNumFiles; ++i) {
+    files.push_back(
+        dynamic::object("name", sformat("fbcode/folly/json/bser/{}.cpp", i))(
+            "size", int64_t(i * 4096))("exists", i % 7 != 0)(
+            "mtime_ms", int64_t(1700000000000 + i))("new", false));
+  }
+  return files;
+}
+
+const dynamic& files() {
+  static const dynamic files = makeFiles();
+  return files;
+}
+
+// The files as one PDU per file, as subscriptions deliver them.
+const std::unique_ptr<IOBuf>& stream() {
+  static const auto stream = [] {
+    IOBufQueue queue{IOBufQueue::cacheChainLength()};
+    for (const auto& file : files()) {
+      queue.append(toBserIOBuf(file, serialization_opts()));
+    }
+    return queue.move();
+  }();
+  return stream;
+}
+
+// The files as one PDU of templated objects.
+const std::unique_ptr<IOBuf>& templated() {
+  static const auto buf = [] {
+    serialization_opts opts;
+    opts.templates = serialization_opts::TemplateMap{{
+        &files(),
+        dynamic::array("name", "size", "exists", "mtime_ms", "new"),
+    }};
+    return toBserIOBuf(files(), opts);
+  }();
+  return buf;
+}
+
+} // namespace
+
+BENCHMARK(ParseBserPdus, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    BserPduSplitter splitter;
+    splitter.append(stream()->clone());
+    size_t total = 0;
+    while (auto pdu = splitter.next()) {
+      total += parseBser(pdu.get())["size"].asInt();
+    }
+    doNotOptimizeAway(total);
+  }
+}
+
+BENCHMARK_RELATIVE(ReadBserPdus, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    BserPduSplitter splitter;
+    splitter.append(stream()->clone());
+    size_t total = 0;
+    while (auto pdu = splitter.next()) {
+      BserReader reader(pdu.get());
+      reader.readPduHeader();
+      for (auto n = reader.beginObject(); n > 0; --n) {
+        auto key = reader.readString();
+        if (key == "size") {
+          total += reader.readInt();
+        } else if (key == "name") {
+          total += reader.readString().size();
+        } else {
+          reader.skipValue();
+        }
+      }
+    }
+    doNotOptimizeAway(total);
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ParseBserTemplate, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    doNotOptimizeAway(parseBser(templated().get()));
+  }
+}
+
+BENCHMARK_RELATIVE(ReadBserTemplateToDynamic, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    BserReader reader(templated().get());
+    reader.readPduHeader();
+    doNotOptimizeAway(reader.readValue());
+  }
+}
+
+BENCHMARK_RELATIVE(ReadBserTemplateFields, iters) {
+  std::vector<std::string> names;
+  for (size_t i = 0; i < iters; ++i) {
+    BserReader reader(templated().get());
+    reader.readPduHeader();
+    size_t total = 0;
+    for (auto n = reader.beginTemplate(names); n > 0; --n) {
+      for (const auto& name : names) {
+        if (reader.peekType() == BserType::Skip) {
+          reader.skipValue();
+        } else if (name == "size") {
+          total += reader.readInt();
+        } else if (name == "name") {
+          total += reader.readString().size();
+        } else {
+          reader.skipValue();
+        }
+      }
+    }
+    doNotOptimizeAway(total);
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ToBserIOBufPdus, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    IOBufQueue queue{IOBufQueue::cacheChainLength()};
+    for (const auto& file : files()) {
+      queue.append(toBserIOBuf(file, serialization_opts()));
+    }
+    doNotOptimizeAway(queue.chainLength());
+  }
+}
+
+BENCHMARK_RELATIVE(BserWriterPdus, iters) {
+  serialization_opts opts;
+  for (size_t i = 0; i < iters; ++i) {
+    IOBufQueue queue{IOBufQueue::cacheChainLength()};
+    BserWriter writer(queue);
+    for (const auto& file : files()) {
+      writer.beginPdu();
+      writer.writeValue(file, opts);
+      writer.endPdu();
+    }
+    doNotOptimizeAway(queue.chainLength());
+  }
+}
+
+int main(int argc, char** argv) {
+  folly::Init init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
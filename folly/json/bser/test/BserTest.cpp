@@ -146,5 +146,201 @@ TEST(Bser, CursorLength) {
   }
 }
 
+// Copies data into a chain of IOBufs of chunk bytes each.
+static std::unique_ptr<folly::IOBuf> fragment(
+    folly::ByteRange data, size_t chunk) {
+  folly::IOBufQueue q;
+  while (!data.empty()) {
+    auto n = std::min(chunk, data.size());
+    q.append(folly::IOBuf::copyBuffer(data.data(), n));
+    data.advance(n);
+  }
+  return q.move();
+}
+
+TEST(Bser, ReaderRoundTrip) {
+  std::vector<dynamic> values(std::begin(roundtrips), std::end(roundtrips));
+  values.push_back(dynamic::array(
+      dynamic::object("a", dynamic::array(1.5, nullptr))("b", false),
+      std::string(300, 'x'),
+      dynamic::array()));
+  for (const auto& dyn : values) {
+    auto str = folly::bser::toBser(dyn, folly::bser::serialization_opts());
+    for (size_t chunk : {size_t(1), size_t(3), str.size()}) {
+      auto buf = fragment(folly::StringPiece(str), chunk);
+      folly::bser::BserReader reader(buf.get());
+      auto len = reader.readPduHeader();
+      EXPECT_EQ(len, reader.cursor().totalLength());
+      EXPECT_EQ(dyn, reader.readValue()) << chunk;
+      EXPECT_TRUE(reader.cursor().isAtEnd());
+
+      folly::bser::BserReader skipper(buf.get());
+      skipper.readPduHeader();
+      skipper.skipValue();
+      EXPECT_TRUE(skipper.cursor().isAtEnd());
+    }
+  }
+}
+
+TEST(Bser, ReaderFields) {
+  folly::bser::serialization_opts opts;
+  auto buf = folly::bser::toBserIOBuf(
+      dynamic::object("name", "foo/bar.txt")("size", 1234)("exists", true)(
+          "mtime", 1.5)("children", dynamic::array(1, 2, 3)),
+      opts);
+  folly::bser::BserReader reader(buf.get());
+  reader.readPduHeader();
+  EXPECT_EQ(folly::bser::BserType::Object, reader.peekType());
+  size_t fields = 0;
+  for (auto n = reader.beginObject(); n > 0; --n) {
+    auto key = reader.readString();
+    if (key == "name") {
+      auto name = reader.readString();
+      EXPECT_EQ("foo/bar.txt", name);
+      // A view into the buffer.
+      EXPECT_GE(name.data(), reinterpret_cast<const char*>(buf->data()));
+      EXPECT_LT(name.data(), reinterpret_cast<const char*>(buf->tail()));
+    } else if (key == "size") {
+      EXPECT_EQ(1234, reader.readInt());
+    } else if (key == "exists") {
+      EXPECT_TRUE(reader.readBool());
+    } else if (key == "mtime") {
+      EXPECT_EQ(1.5, reader.readReal());
+    } else {
+      EXPECT_EQ("children", key);
+      reader.skipValue();
+    }
+    ++fields;
+  }
+  EXPECT_EQ(5, fields);
+  EXPECT_TRUE(reader.cursor().isAtEnd());
+
+  folly::bser::BserReader wrong(buf.get());
+  wrong.readPduHeader();
+  EXPECT_THROW(wrong.beginArray(), folly::bser::BserDecodeError);
+}
+
+TEST(Bser, ReaderTemplate) {
+  auto buf = folly::IOBuf::wrapBuffer(template_blob, sizeof(template_blob) - 1);
+  folly::bser::BserReader reader(buf.get());
+  reader.readPduHeader();
+  EXPECT_EQ(template_dynamic, reader.readValue());
+
+  folly::bser::BserReader pull(buf.get());
+  pull.readPduHeader();
+  std::vector<std::string> names;
+  EXPECT_EQ(3, pull.beginTemplate(names));
+  EXPECT_EQ((std::vector<std::string>{"name", "age"}), names);
+  EXPECT_EQ("fred", pull.readString());
+  EXPECT_EQ(20, pull.readInt());
+  pull.skipValue();
+  pull.skipValue();
+  EXPECT_EQ(folly::bser::BserType::Skip, pull.peekType());
+  pull.skipValue();
+  EXPECT_EQ(25, pull.readInt());
+  EXPECT_TRUE(pull.cursor().isAtEnd());
+}
+
+TEST(Bser, SkipTemplateOverflow) {
+  // A template with 3 names and INT64_MAX rows, whose number of values does
+  // not fit in 64 bits.
+  const uint8_t blob[] =
+      "\x0b\x00\x03\x03\x02\x03\x01\x61\x02\x03\x01\x62"
+      "\x02\x03\x01\x63\x06\xff\xff\xff\xff\xff\xff\xff\x7f";
+  auto buf = folly::IOBuf::wrapBuffer(blob, sizeof(blob) - 1);
+  folly::bser::BserReader reader(buf.get());
+  EXPECT_THROW(reader.skipValue(), folly::bser::BserDecodeError);
+}
+
+TEST(Bser, PduSplitter) {
+  folly::bser::serialization_opts opts;
+  std::vector<dynamic> values;
+  std::string stream;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(dynamic::object("id", i)("name", std::string(i * 3, 'n')));
+    stream += folly::bser::toBser(values.back(), opts).toStdString();
+  }
+
+  for (size_t chunk : {1, 7, 100, 100000}) {
+    folly::bser::BserPduSplitter splitter;
+    size_t decoded = 0;
+    folly::ByteRange rest(folly::StringPiece{stream});
+    while (!rest.empty()) {
+      auto n = std::min(chunk, rest.size());
+      if (chunk == 7) {
+        splitter.append(rest.subpiece(0, n));
+      } else {
+        splitter.append(folly::IOBuf::copyBuffer(rest.data(), n));
+      }
+      rest.advance(n);
+      while (auto pdu = splitter.next()) {
+        ASSERT_LT(decoded, values.size());
+        EXPECT_EQ(values[decoded++], folly::bser::parseBser(pdu.get()));
+      }
+    }
+    EXPECT_EQ(values.size(), decoded);
+    EXPECT_EQ(0, splitter.pending());
+  }
+
+  folly::bser::BserPduSplitter splitter;
+  splitter.append(folly::StringPiece("\x01\x01\x03\x01"));
+  EXPECT_THROW(splitter.next(), std::runtime_error);
+}
+
+TEST(Bser, Writer) {
+  folly::IOBufQueue q;
+  folly::bser::BserWriter writer(q, 16);
+
+  writer.beginPdu();
+  writer.beginObject(3);
+  writer.writeString("name");
+  writer.writeString(std::string(100, 'x'));
+  writer.writeString("sizes");
+  writer.beginArray(4);
+  writer.writeInt(1);
+  writer.writeInt(1000);
+  writer.writeInt(100000);
+  writer.writeInt(10000000000);
+  writer.writeString("more");
+  writer.beginArray(3);
+  writer.writeReal(1.5);
+  writer.writeBool(false);
+  writer.writeNull();
+  writer.endPdu();
+
+  // A templated array, like toBser's.
+  writer.beginPdu();
+  std::vector<folly::StringPiece> names = {"name", "age"};
+  writer.beginTemplate(folly::range(names), 3);
+  writer.writeString("fred");
+  writer.writeInt(20);
+  writer.writeString("pete");
+  writer.writeInt(30);
+  writer.writeSkip();
+  writer.writeInt(25);
+  writer.endPdu();
+
+  writer.beginPdu();
+  writer.writeValue(template_dynamic, folly::bser::serialization_opts());
+  writer.endPdu();
+  EXPECT_THROW(writer.endPdu(), std::logic_error);
+
+  folly::bser::BserPduSplitter splitter;
+  splitter.append(q.move());
+  auto pdu = splitter.next();
+  ASSERT_TRUE(pdu);
+  dynamic expected = dynamic::object("name", std::string(100, 'x'))(
+      "sizes", dynamic::array(1, 1000, 100000, 10000000000))(
+      "more", dynamic::array(1.5, false, nullptr));
+  EXPECT_EQ(expected, folly::bser::parseBser(pdu.get()));
+  pdu = splitter.next();
+  ASSERT_TRUE(pdu);
+  EXPECT_EQ(template_dynamic, folly::bser::parseBser(pdu.get()));
+  pdu = splitter.next();
+  ASSERT_TRUE(pdu);
+  EXPECT_EQ(template_dynamic, folly::bser::parseBser(pdu.get()));
+  EXPECT_FALSE(splitter.next());
+}
+
 /* vim:ts=2:sw=2:et:
  */
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/detail/JsonStructuralIndex.h>
+#include <folly/json/detail/JsonStructuralIndexImpl.h>
+
+namespace folly {
+namespace json {
+namespace detail {
+
+void buildJsonStructuralIndex(
+    StringPiece input, std::vector<std::uint32_t>& out) {
+  buildJsonStructuralIndexImpl<simd::detail::SimdPlatform<std::uint8_t>>(
+      input, out);
+}
+
+} // namespace detail
+} // namespace json
+} // namespace folly
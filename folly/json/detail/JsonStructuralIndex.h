@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace folly {
+namespace json {
+namespace detail {
+
+/**
+ * Stage one of the indexed json parser (see parseJsonIndexed in json.h).
+ *
+ * Appends to `out` the offsets of every structural position of `input`, in
+ * increasing order:
+ *  - `{`, `}`, `[`, `]`, `:` and `,` outside of strings;
+ *  - every unescaped `"`, so that each string shows up as an open/close pair;
+ *  - the first byte of every bare scalar, i.e. of every run of bytes outside
+ *    of strings that are neither whitespace nor one of the characters above.
+ *
+ * The input is not validated: stage two walks the index and reports
+ * malformed documents. The input must be smaller than 4GB.
+ */
+void buildJsonStructuralIndex(
+    StringPiece input, std::vector<std::uint32_t>& out);
+
+} // namespace detail
+} // namespace json
+} // namespace folly
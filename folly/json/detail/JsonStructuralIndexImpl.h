@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <folly/Portability.h>
+#include <folly/Range.h>
+#include <folly/algorithm/simd/Ignore.h>
+#include <folly/algorithm/simd/Movemask.h>
+#include <folly/algorithm/simd/detail/SimdPlatform.h>
+#include <folly/lang/Bits.h>
+
+// This file is not supposed to be included by users.
+// It should be included in CPP file which exposes apis.
+// It is a header file to test different platforms.
+
+namespace folly {
+namespace json {
+namespace detail {
+
+// Classification of a 64 byte block of input, one bit per byte.
+struct JsonBlockMasks {
+  std::uint64_t quote{0};
+  std::uint64_t backslash{0};
+  std::uint64_t op{0}; // {}[]:,
+  std::uint64_t whitespace{0}; // space, \t, \n, \r
+};
+
+constexpr std::size_t kJsonBlockSize = 64;
+
+// Bit i of the result is the xor of bits [0, i] of x.
+FOLLY_ALWAYS_INLINE std::uint64_t jsonPrefixXor(std::uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+// Movemask gives us one bit per byte on x86 and one nibble per byte
+// on arm. Squash both to one bit per byte.
+template <typename Bits, std::uint32_t BitsPerElement>
+FOLLY_ALWAYS_INLINE std::uint64_t jsonCompactMovemask(
+    std::pair<Bits, std::integral_constant<std::uint32_t, BitsPerElement>>
+        mmask) {
+  std::uint64_t x = mmask.first;
+  if constexpr (BitsPerElement == 4) {
+    x &= 0x1111111111111111;
+    x = (x | (x >> 3)) & 0x0303030303030303;
+    x = (x | (x >> 6)) & 0x000F000F000F000F;
+    x = (x | (x >> 12)) & 0x000000FF000000FF;
+    x = (x | (x >> 24)) & 0x000000000000FFFF;
+  } else {
+    static_assert(BitsPerElement == 1, "unexpected movemask layout");
+  }
+  return x;
+}
+
+template <typename Platform>
+struct PlatformJsonBlockClassifier {
+  using reg_t = typename Platform::reg_t;
+  using logical_t = typename Platform::logical_t;
+
+  static constexpr int kRegsPerBlock =
+      int(kJsonBlockSize) / Platform::kCardinal;
+
+  FOLLY_ALWAYS_INLINE static std::uint64_t bits(logical_t logical) {
+    return jsonCompactMovemask(simd::movemask<std::uint8_t>(logical));
+  }
+
+  FOLLY_ALWAYS_INLINE JsonBlockMasks
+  operator()(const std::uint8_t* block) const {
+    JsonBlockMasks res;
+    for (int i = 0; i != kRegsPerBlock; ++i) {
+      reg_t reg = Platform::loadu(
+          block + i * Platform::kCardinal, simd::ignore_none{});
+
+      logical_t op = Platform::logical_or(
+          Platform::logical_or(
+              Platform::equal(reg, '{'), Platform::equal(reg, '}')),
+          Platform::logical_or(
+              Platform::equal(reg, '['), Platform::equal(reg, ']')));
+      op = Platform::logical_or(
+          op,
+          Platform::logical_or(
+              Platform::equal(reg, ':'), Platform::equal(reg, ',')));
+      logical_t ws = Platform::logical_or(
+          Platform::logical_or(
+              Platform::equal(reg, ' '), Platform::equal(reg, '\t')),
+          Platform::logical_or(
+              Platform::equal(reg, '\n'), Platform::equal(reg, '\r')));
+
+      auto shift = std::uint32_t(i * Platform::kCardinal);
+      res.quote |= bits(Platform::equal(reg, '"')) << shift;
+      res.backslash |= bits(Platform::equal(reg, '\\')) << shift;
+      res.op |= bits(op) << shift;
+      res.whitespace |= bits(ws) << shift;
+    }
+    return res;
+  }
+};
+
+template <>
+struct PlatformJsonBlockClassifier<void> {
+  FOLLY_ALWAYS_INLINE JsonBlockMasks
+  operator()(const std::uint8_t* block) const {
+    JsonBlockMasks res;
+    for (std::size_t i = 0; i != kJsonBlockSize; ++i) {
+      std::uint64_t bit = std::uint64_t(1) << i;
+      switch (block[i]) {
+        case '"':
+          res.quote |= bit;
+          break;
+        case '\\':
+          res.backslash |= bit;
+          break;
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+          res.op |= bit;
+          break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+          res.whitespace |= bit;
+          break;
+        default:
+          break;
+      }
+    }
+    return res;
+  }
+};
+
+// Turns block classifications into structural bits, carrying the string,
+// escape and scalar state from one block to the next.
+class JsonStructuralScanner {
+ public:
+  FOLLY_ALWAYS_INLINE std::uint64_t next(JsonBlockMasks const& m) {
+    std::uint64_t escaped = nextEscaped(m.backslash);
+    std::uint64_t quote = m.quote & ~escaped;
+
+    // Set for the opening quote and the string contents, clear for the
+    // closing quote.
+    std::uint64_t inString = jsonPrefixXor(quote) ^ prevInString_;
+    prevInString_ = std::uint64_t(std::int64_t(inString) >> 63);
+
+    std::uint64_t op = m.op & ~inString;
+    std::uint64_t scalar = ~(m.op | m.whitespace | m.quote | inString);
+    std::uint64_t scalarStart = scalar & ~((scalar << 1) | prevScalar_);
+    prevScalar_ = scalar >> 63;
+
+    return op | quote | scalarStart;
+  }
+
+ private:
+  // Escapes are rare in practice, so walk the backslashes one by one
+  // instead of computing odd-length runs branch-free.
+  FOLLY_ALWAYS_INLINE std::uint64_t nextEscaped(std::uint64_t backslash) {
+    std::uint64_t escaped = prevEscaped_;
+    backslash &= ~prevEscaped_;
+    prevEscaped_ = 0;
+    while (backslash) {
+      auto i = folly::findFirstSet(backslash) - 1;
+      if (i == 63) {
+        prevEscaped_ = 1;
+        break;
+      }
+      escaped |= std::uint64_t(2) << i;
+      backslash &= ~(std::uint64_t(3) << i);
+    }
+    return escaped;
+  }
+
+  std::uint64_t prevEscaped_{0};
+  std::uint64_t prevInString_{0};
+  std::uint64_t prevScalar_{0};
+};
+
+FOLLY_ALWAYS_INLINE void flattenJsonStructurals(
+    std::uint64_t bits, std::uint32_t offset, std::vector<std::uint32_t>& out) {
+  if (!bits) {
+    return;
+  }
+  auto pos = out.size();
+  out.resize(pos + std::size_t(folly::popcount(bits)));
+  std::uint32_t* w = out.data() + pos;
+  while (bits) {
+    *w++ = offset + std::uint32_t(folly::findFirstSet(bits) - 1);
+    bits &= bits - 1;
+  }
+}
+
+template <typename Platform>
+void buildJsonStructuralIndexImpl(
+    folly::StringPiece input, std::vector<std::uint32_t>& out) {
+  PlatformJsonBlockClassifier<Platform> classify;
+  JsonStructuralScanner scanner;
+
+  // Most documents have a structural every 4-8 bytes.
+  out.reserve(out.size() + input.size() / 4 + 1);
+
+  auto f = reinterpret_cast<const std::uint8_t*>(input.data());
+  std::size_t size = input.size();
+  std::size_t offset = 0;
+  for (; offset + kJsonBlockSize <= size; offset += kJsonBlockSize) {
+    flattenJsonStructurals(
+        scanner.next(classify(f + offset)), std::uint32_t(offset), out);
+  }
+  if (offset != size) {
+    // Whitespace padding does not change the meaning of the tail.
+    std::uint8_t tail[kJsonBlockSize];
+    std::memset(tail, ' ', sizeof(tail));
+    std::memcpy(tail, f + offset, size - offset);
+    flattenJsonStructurals(
+        scanner.next(classify(tail)), std::uint32_t(offset), out);
+  }
+}
+
+} // namespace detail
+} // namespace json
+} // namespace folly
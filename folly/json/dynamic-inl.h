@@ -172,7 +172,10 @@ struct dynamic::ObjectImpl
           dynamic,
           dynamic,
           detail::DynamicHasher,
-          detail::DynamicKeyEqual> {};
+          detail::DynamicKeyEqual,
+          dynamic_detail::Allocator<std::pair<dynamic const, dynamic>>> {
+  using F14NodeMap::F14NodeMap;
+};
 
 //////////////////////////////////////////////////////////////////////
 
@@ -333,6 +336,21 @@ inline dynamic::dynamic(ObjectMaker (*)()) : type_(OBJECT) {
   new (getAddress<ObjectImpl>()) ObjectImpl();
 }
 
+inline dynamic dynamic::array_in(dynamic_arena& arena) {
+  dynamic ret;
+  ret.type_ = ARRAY;
+  new (&ret.u_.array) Array(dynamic_detail::Allocator<dynamic>(&arena));
+  return ret;
+}
+
+inline dynamic dynamic::object_in(dynamic_arena& arena) {
+  dynamic ret;
+  ret.type_ = OBJECT;
+  new (ret.getAddress<ObjectImpl>()) ObjectImpl(
+      dynamic_detail::Allocator<std::pair<dynamic const, dynamic>>(&arena));
+  return ret;
+}
+
 inline dynamic::dynamic(char const* s) : type_(STRING) {
   new (&u_.string) std::string(s);
 }
@@ -143,6 +143,24 @@ dynamic::dynamic(dynamic&& o) noexcept : type_(o.type_) {
 #undef FB_X
 }
 
+dynamic::dynamic(dynamic const& o, dynamic_arena& arena)
+    : dynamic(
+          o.isArray()        ? array_in(arena)
+              : o.isObject() ? object_in(arena)
+                             : o) {
+  if (auto* array = get_nothrow<Array>()) {
+    array->reserve(o.size());
+    for (auto const& item : o) {
+      array->emplace_back(item, arena);
+    }
+  } else if (auto* obj = get_nothrow<ObjectImpl>()) {
+    obj->reserve(o.size());
+    for (auto const& [key, value] : o.items()) {
+      obj->emplace(dynamic(key, arena), dynamic(value, arena));
+    }
+  }
+}
+
 dynamic& dynamic::operator=(dynamic const& o) {
   if (&o != this) {
     if (type_ == o.type_) {
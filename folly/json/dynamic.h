@@ -85,11 +85,81 @@ struct TypeError;
 
 //////////////////////////////////////////////////////////////////////
 
+class dynamic_arena;
+
 namespace dynamic_detail {
 template <typename T>
 using detect_construct_string = decltype(std::string(
     FOLLY_DECLVAL(T const&).data(), FOLLY_DECLVAL(T const&).size()));
-}
+
+// See dynamic_arena.h.
+void* arenaAllocate(dynamic_arena& arena, std::size_t size);
+
+/*
+ * Allocator of the arrays and objects held by dynamic. Containers use the
+ * heap unless they were given an arena, with dynamic::array_in(),
+ * dynamic::object_in() or parseJson(); those allocate from it and never
+ * free.
+ *
+ * Moves and swaps carry the allocator along. Copies use the heap, since they
+ * may outlive the arena of the original.
+ *
+ * Being stateful, the allocator takes a pointer in every container, which
+ * makes arrays and objects 32 bytes. With libc++, std::string is 24 bytes,
+ * so this grows sizeof(dynamic), type tag included, from 32 to 40 bytes.
+ * With libstdc++, std::string is already 32 bytes, and sizeof(dynamic) stays
+ * at 40.
+ */
+template <class T>
+class Allocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  Allocator() noexcept : arena_(nullptr) {}
+  explicit Allocator(dynamic_arena* arena) noexcept : arena_(arena) {}
+  template <class U>
+  /* implicit */ Allocator(Allocator<U> const& other) noexcept
+      : arena_(other.arena_) {}
+
+  T* allocate(std::size_t n) {
+    if (arena_) {
+      return static_cast<T*>(arenaAllocate(*arena_, n * sizeof(T)));
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    if (!arena_) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  }
+
+  Allocator select_on_container_copy_construction() const noexcept {
+    return Allocator();
+  }
+
+  dynamic_arena* arena() const noexcept { return arena_; }
+
+  template <class U>
+  friend bool operator==(Allocator const& a, Allocator<U> const& b) noexcept {
+    return a.arena_ == b.arena();
+  }
+  template <class U>
+  friend bool operator!=(Allocator const& a, Allocator<U> const& b) noexcept {
+    return !(a == b);
+  }
+
+ private:
+  template <class U>
+  friend class Allocator;
+
+  dynamic_arena* arena_;
+};
+} // namespace dynamic_detail
 
 struct dynamic {
   enum Type {
@@ -114,7 +184,7 @@ struct dynamic {
    * Object item iterators dereference as pairs of (key, value).
    */
  private:
-  typedef std::vector<dynamic> Array;
+  typedef std::vector<dynamic, dynamic_detail::Allocator<dynamic>> Array;
 
   /*
    * Violating spec, std::vector<bool>::const_reference is not bool in libcpp:
@@ -205,6 +275,17 @@ struct dynamic {
   static ObjectMaker object();
   static ObjectMaker object(dynamic, dynamic);
 
+  /**
+   * Construct an empty array or object whose storage comes from arena, see
+   * dynamic_arena.h. Only these containers use the arena: the values added
+   * to them keep their own storage.
+   *
+   * @methodset Array
+   */
+  static dynamic array_in(dynamic_arena& arena);
+  /// @methodset Object
+  static dynamic object_in(dynamic_arena& arena);
+
   /**
    * Default constructor, initializes with nullptr.
    */
@@ -288,6 +369,12 @@ struct dynamic {
 
   dynamic(dynamic const&);
   dynamic(dynamic&&) noexcept;
+
+  /**
+   * Deep copy whose arrays and objects all come from arena. Plain copies use
+   * the heap, even when the original is in an arena.
+   */
+  dynamic(dynamic const& o, dynamic_arena& arena);
   ~dynamic() noexcept;
 
   /**
@@ -1159,7 +1246,13 @@ struct dynamic {
      * incomplete type right now).  (Note that in contrast we know it
      * is ok to do this with fbvector because we own it.)
      */
-    aligned_storage_for_t<F14NodeMap<int, int>> objectBuffer;
+    aligned_storage_for_t<F14NodeMap<
+        int,
+        int,
+        std::hash<int>,
+        std::equal_to<int>,
+        dynamic_detail::Allocator<std::pair<int const, int>>>>
+        objectBuffer;
   } u_;
 };
 
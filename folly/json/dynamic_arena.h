@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Arena allocation for the arrays and objects of dynamic trees.
+ *
+ * Each dynamic array owns a heap buffer and each object a hash table plus one
+ * heap node per item, so building and freeing a large parsed document spends
+ * most of its time in malloc and free. Containers given an arena allocate
+ * from it instead, and freeing them is a no-op: the memory is returned all at
+ * once when the arena is destroyed.
+ *
+ * The arena is always opted into explicitly: parseJson() takes one for the
+ * whole document, dynamic::array_in() and dynamic::object_in() make empty
+ * containers in one, and dynamic(other, arena) copies a tree into one.
+ *
+ *   folly::dynamic_arena arena;
+ *   {
+ *     folly::dynamic doc = folly::parseJson(payload, {}, arena);
+ *     use(doc);
+ *   }
+ *
+ * Everything else uses the heap, including the copies of arena-backed
+ * containers, so copies can outlive the arena. Strings are unaffected: short
+ * ones are stored inline, longer ones still use the heap.
+ *
+ * Every dynamic that holds arena-backed containers, including the ones they
+ * are moved into, must be destroyed before the arena. An arena must not be
+ * used on several threads at the same time.
+ *
+ * @file dynamic_arena.h
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <folly/json/dynamic.h>
+#include <folly/memory/Arena.h>
+
+namespace folly {
+
+class dynamic_arena {
+ public:
+  explicit dynamic_arena(
+      std::size_t minBlockSize = SysArena::kDefaultMinBlockSize)
+      : arena_(minBlockSize, SysArena::kNoSizeLimit, alignof(max_align_t)) {}
+
+  dynamic_arena(dynamic_arena const&) = delete;
+  dynamic_arena& operator=(dynamic_arena const&) = delete;
+
+  void* allocate(std::size_t size) { return arena_.allocate(size); }
+
+  /**
+   * Bytes handed out to containers, and bytes obtained from the system.
+   */
+  std::size_t bytesUsed() const { return arena_.bytesUsed(); }
+  std::size_t totalSize() const { return arena_.totalSize(); }
+
+ private:
+  SysArena arena_;
+};
+
+} // namespace folly
@@ -0,0 +1,683 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/frozen_dynamic.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/algorithm/simd/detail/SimdPlatform.h>
+#include <folly/container/F14Map.h>
+#include <folly/lang/Bits.h>
+#include <folly/lang/Exception.h>
+#include <folly/system/MemoryMapping.h>
+
+namespace folly {
+namespace json {
+
+namespace {
+
+// The encoding starts with a header, whose root slot is the value. Then:
+//
+//   int64, double: the 8 bytes of the value, 8 byte aligned.
+//   string: uint32 size, the bytes, NUL; 4 byte aligned.
+//   array: uint32 size, uint32 unused, the slots of the elements.
+//   object: uint32 size, uint32 unused, then, in key order,
+//     - the key prefixes: the first 4 bytes of each key, zero padded and
+//       big endian, so that they sort like the keys; padded with zeros to
+//       a multiple of kPrefixBlock entries, so that they can be scanned a
+//       vector at a time;
+//     - the offsets of the key strings, padded to an even number;
+//     - the slots of the values.
+//
+// Containers are written before their contents, so in a depth first walk
+// of the tree their offsets increase.
+
+enum frozen_kind : std::uint32_t {
+  kNull,
+  kFalse,
+  kTrue,
+  kSmallInt,
+  kInt,
+  kDouble,
+  kString,
+  kArray,
+  kObject,
+  kNumKinds,
+};
+
+constexpr dynamic::Type kKindTypes[kNumKinds] = {
+    dynamic::NULLT,
+    dynamic::BOOL,
+    dynamic::BOOL,
+    dynamic::INT64,
+    dynamic::INT64,
+    dynamic::DOUBLE,
+    dynamic::STRING,
+    dynamic::ARRAY,
+    dynamic::OBJECT,
+};
+
+// "FZDY" as a native integer.
+constexpr std::uint32_t kMagic = 0x46'5a'44'59;
+constexpr std::uint32_t kVersion = 1;
+
+struct frozen_header {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint64_t size;
+  detail::frozen_slot root;
+};
+static_assert(sizeof(frozen_header) == 24, "");
+static_assert(sizeof(detail::frozen_slot) == 8, "");
+
+constexpr std::uint32_t kPrefixBlock = 8;
+// Objects with more keys are binary searched.
+constexpr std::uint32_t kLinearSearchMax = 32;
+
+constexpr std::uint64_t roundUp(std::uint64_t n, std::uint64_t to) {
+  return (n + to - 1) / to * to;
+}
+
+template <typename T>
+T const* ptrAt(std::uint8_t const* base, std::uint64_t offset) {
+  return reinterpret_cast<T const*>(base + offset);
+}
+
+StringPiece stringAt(std::uint8_t const* base, std::uint32_t offset) {
+  return {
+      ptrAt<char>(base, offset + sizeof(std::uint32_t)),
+      *ptrAt<std::uint32_t>(base, offset)};
+}
+
+struct object_layout {
+  std::uint32_t size;
+  std::uint32_t const* prefixes;
+  std::uint32_t const* keys;
+  detail::frozen_slot const* values;
+};
+
+constexpr std::uint64_t objectBytes(std::uint64_t size) {
+  return 8 + 4 * roundUp(size, kPrefixBlock) + 4 * roundUp(size, 2) +
+      sizeof(detail::frozen_slot) * size;
+}
+
+object_layout objectAt(std::uint8_t const* base, std::uint32_t offset) {
+  object_layout ret;
+  ret.size = *ptrAt<std::uint32_t>(base, offset);
+  ret.prefixes = ptrAt<std::uint32_t>(base, offset + 8);
+  ret.keys = ret.prefixes + roundUp(ret.size, kPrefixBlock);
+  ret.values = reinterpret_cast<detail::frozen_slot const*>(
+      ret.keys + roundUp(ret.size, 2));
+  return ret;
+}
+
+std::uint32_t keyPrefix(StringPiece key) {
+  std::uint32_t prefix = 0;
+  if (!key.empty()) {
+    std::memcpy(&prefix, key.data(), std::min<std::size_t>(key.size(), 4));
+  }
+  return Endian::big(prefix);
+}
+
+class frozen_builder {
+ public:
+  std::string build(dynamic const& value) {
+    allocate(sizeof(frozen_header), 8);
+    frozen_header header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.root = encode(value);
+    buf_.resize(roundUp(buf_.size(), 8));
+    header.size = buf_.size();
+    store(0, header);
+    return std::move(buf_);
+  }
+
+ private:
+  // Append n zero bytes at a multiple of align and return their offset.
+  std::uint32_t allocate(std::uint64_t n, std::uint64_t align) {
+    auto offset = roundUp(buf_.size(), align);
+    if (offset + n > std::numeric_limits<std::uint32_t>::max()) {
+      throw_exception<std::length_error>("frozen_dynamic exceeds 4GB");
+    }
+    buf_.resize(offset + n);
+    return static_cast<std::uint32_t>(offset);
+  }
+
+  template <typename T>
+  void store(std::uint64_t offset, T const& value) {
+    std::memcpy(&buf_[offset], &value, sizeof(T));
+  }
+
+  detail::frozen_slot encode(dynamic const& value) {
+    switch (value.type()) {
+      case dynamic::NULLT:
+        return {kNull, 0};
+      case dynamic::BOOL:
+        return {value.getBool() ? kTrue : kFalse, 0};
+      case dynamic::INT64: {
+        auto i = value.getInt();
+        if (i >= std::numeric_limits<std::int32_t>::min() &&
+            i <= std::numeric_limits<std::int32_t>::max()) {
+          return {kSmallInt, static_cast<std::uint32_t>(i)};
+        }
+        auto offset = allocate(sizeof(i), 8);
+        store(offset, i);
+        return {kInt, offset};
+      }
+      case dynamic::DOUBLE: {
+        auto d = value.getDouble();
+        auto offset = allocate(sizeof(d), 8);
+        store(offset, d);
+        return {kDouble, offset};
+      }
+      case dynamic::STRING:
+        return {kString, encodeString(value.stringPiece())};
+      case dynamic::ARRAY:
+        return {kArray, encodeArray(value)};
+      case dynamic::OBJECT:
+        return {kObject, encodeObject(value)};
+    }
+    throw_exception<std::logic_error>("unknown dynamic type");
+  }
+
+  std::uint32_t encodeString(StringPiece s) {
+    auto [it, inserted] = strings_.try_emplace(s, 0);
+    if (inserted) {
+      if (s.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw_exception<std::length_error>("frozen_dynamic exceeds 4GB");
+      }
+      it->second = allocate(sizeof(std::uint32_t) + s.size() + 1, 4);
+      store(it->second, static_cast<std::uint32_t>(s.size()));
+      if (!s.empty()) {
+        std::memcpy(
+            &buf_[it->second + sizeof(std::uint32_t)], s.data(), s.size());
+      }
+    }
+    return it->second;
+  }
+
+  std::uint32_t encodeArray(dynamic const& value) {
+    auto size = static_cast<std::uint32_t>(value.size());
+    auto offset = allocate(8 + sizeof(detail::frozen_slot) * size, 8);
+    store(offset, size);
+    for (std::uint32_t i = 0; i < size; ++i) {
+      store(offset + 8 + sizeof(detail::frozen_slot) * i, encode(value[i]));
+    }
+    return offset;
+  }
+
+  std::uint32_t encodeObject(dynamic const& value) {
+    std::vector<std::pair<StringPiece, dynamic const*>> items;
+    items.reserve(value.size());
+    for (auto const& item : value.items()) {
+      if (!item.first.isString()) {
+        throw_exception<TypeError>("string", item.first.type());
+      }
+      items.emplace_back(item.first.stringPiece(), &item.second);
+    }
+    std::sort(items.begin(), items.end(), [](auto const& a, auto const& b) {
+      return a.first < b.first;
+    });
+
+    auto size = static_cast<std::uint32_t>(items.size());
+    auto offset = allocate(objectBytes(size), 8);
+    store(offset, size);
+    auto prefixes = offset + 8;
+    auto keys = prefixes + 4 * roundUp(size, kPrefixBlock);
+    auto values = keys + 4 * roundUp(size, 2);
+    for (std::uint32_t i = 0; i < size; ++i) {
+      store(prefixes + 4 * i, keyPrefix(items[i].first));
+      store(keys + 4 * i, encodeString(items[i].first));
+      store(
+          values + sizeof(detail::frozen_slot) * i, encode(*items[i].second));
+    }
+    return offset;
+  }
+
+  std::string buf_;
+  // The strings of the dynamic being encoded, which outlives the builder.
+  F14FastMap<StringPiece, std::uint32_t> strings_;
+};
+
+[[noreturn]] void throwCorrupt(char const* what) {
+  throw_exception<std::runtime_error>(
+      sformat("frozen_dynamic: corrupt encoding: {}", what));
+}
+
+// The index of the first key of layout whose prefix is needle, or
+// layout.size.
+std::size_t findPrefix(object_layout const& layout, std::uint32_t needle) {
+#if FOLLY_DETAIL_HAS_SIMD_PLATFORM
+  using Platform = simd::detail::SimdPlatform<std::uint32_t>;
+  static_assert(kPrefixBlock % Platform::kCardinal == 0, "");
+  // The table is padded to a whole number of vectors.
+  for (std::size_t i = 0; i < layout.size; i += Platform::kCardinal) {
+    auto reg = Platform::loadu(layout.prefixes + i, simd::ignore_none{});
+    auto [bits, bitsPerElement] =
+        simd::movemask<std::uint32_t>(Platform::equal(reg, needle));
+    if (bits) {
+      // Matches in the padding are past layout.size.
+      return std::min<std::size_t>(
+          layout.size, i + (findFirstSet(bits) - 1) / bitsPerElement);
+    }
+  }
+  return layout.size;
+#else
+  for (std::size_t i = 0; i < layout.size; ++i) {
+    if (layout.prefixes[i] == needle) {
+      return i;
+    }
+  }
+  return layout.size;
+#endif
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// frozen_dynamic
+
+frozen_dynamic::frozen_dynamic(
+    ByteRange bytes, std::shared_ptr<void const> owner)
+    : bytes_(bytes), owner_(std::move(owner)) {}
+
+frozen_dynamic::frozen_dynamic(dynamic const& value) {
+  auto encoded = frozen_builder().build(value);
+  // Copied into 8 byte words, for the alignment of the 8 byte values.
+  auto words = std::make_shared<std::vector<std::uint64_t>>(
+      encoded.size() / sizeof(std::uint64_t));
+  std::memcpy(words->data(), encoded.data(), encoded.size());
+  bytes_ = ByteRange(
+      reinterpret_cast<std::uint8_t const*>(words->data()), encoded.size());
+  owner_ = std::move(words);
+}
+
+frozen_dynamic frozen_dynamic::fromBytes(ByteRange bytes) {
+  if (bytes.size() < sizeof(frozen_header)) {
+    throwCorrupt("too short");
+  }
+  if (reinterpret_cast<std::uintptr_t>(bytes.data()) % 8 != 0) {
+    throw_exception<std::invalid_argument>(
+        "frozen_dynamic: bytes are not 8 byte aligned");
+  }
+  auto header = ptrAt<frozen_header>(bytes.data(), 0);
+  if (header->magic != kMagic) {
+    throwCorrupt(
+        header->magic == Endian::swap(kMagic) ? "wrong byte order"
+                                              : "bad magic");
+  }
+  if (header->version != kVersion) {
+    throwCorrupt("unknown version");
+  }
+  if (header->size != bytes.size()) {
+    throwCorrupt("wrong size");
+  }
+  return frozen_dynamic(bytes, nullptr);
+}
+
+frozen_dynamic frozen_dynamic::mapFile(char const* path) {
+  auto mapping = std::make_shared<MemoryMapping>(path);
+  auto ret = fromBytes(mapping->range());
+  ret.owner_ = std::move(mapping);
+  return ret;
+}
+
+frozen_view frozen_dynamic::root() const {
+  return {bytes_.data(), ptrAt<frozen_header>(bytes_.data(), 0)->root};
+}
+
+void frozen_dynamic::validate() const {
+  auto base = bytes_.data();
+  auto size = bytes_.size();
+  auto checkRange = [&](std::uint64_t offset, std::uint64_t n, unsigned align) {
+    if (offset % align != 0 || offset < sizeof(frozen_header) ||
+        offset + n > size) {
+      throwCorrupt("offset out of bounds");
+    }
+  };
+  auto checkString = [&](std::uint32_t offset) {
+    checkRange(offset, sizeof(std::uint32_t), 4);
+    auto s = stringAt(base, offset);
+    checkRange(offset, sizeof(std::uint32_t) + s.size() + 1, 4);
+    if (s.end()[0] != '\0') {
+      throwCorrupt("unterminated string");
+    }
+    return s;
+  };
+
+  // Depth first, with the offsets of containers increasing, so that the
+  // tree has no cycles and no shared subtrees, and the walk is linear.
+  std::uint64_t lastContainer = 0;
+  std::vector<detail::frozen_slot> stack{root().slot_};
+  while (!stack.empty()) {
+    auto slot = stack.back();
+    stack.pop_back();
+    switch (slot.kind) {
+      case kNull:
+      case kFalse:
+      case kTrue:
+      case kSmallInt:
+        break;
+      case kInt:
+      case kDouble:
+        checkRange(slot.payload, 8, 8);
+        break;
+      case kString:
+        checkString(slot.payload);
+        break;
+      case kArray:
+      case kObject: {
+        if (slot.payload <= lastContainer) {
+          throwCorrupt("containers out of order");
+        }
+        lastContainer = slot.payload;
+        checkRange(slot.payload, 8, 8);
+        auto n = *ptrAt<std::uint32_t>(base, slot.payload);
+        if (slot.kind == kArray) {
+          checkRange(slot.payload, 8 + sizeof(detail::frozen_slot) * n, 8);
+          auto elements = ptrAt<detail::frozen_slot>(base, slot.payload + 8);
+          stack.insert(
+              stack.end(),
+              std::make_reverse_iterator(elements + n),
+              std::make_reverse_iterator(elements));
+          break;
+        }
+        checkRange(slot.payload, objectBytes(n), 8);
+        auto layout = objectAt(base, slot.payload);
+        StringPiece prev;
+        for (std::uint32_t i = 0; i < n; ++i) {
+          auto key = checkString(layout.keys[i]);
+          if (layout.prefixes[i] != keyPrefix(key)) {
+            throwCorrupt("wrong key prefix");
+          }
+          if (i > 0 && !(prev < key)) {
+            throwCorrupt("unsorted keys");
+          }
+          prev = key;
+        }
+        stack.insert(
+            stack.end(),
+            std::make_reverse_iterator(layout.values + n),
+            std::make_reverse_iterator(layout.values));
+        break;
+      }
+      default:
+        throwCorrupt("unknown kind");
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// frozen_view
+
+dynamic::Type frozen_view::type() const {
+  return kKindTypes[slot_.kind];
+}
+
+void frozen_view::requireKind(dynamic::Type t, char const* expected) const {
+  if (type() != t) {
+    throw_exception<TypeError>(expected, type());
+  }
+}
+
+std::uint32_t frozen_view::containerSize() const {
+  return *ptrAt<std::uint32_t>(base_, slot_.payload);
+}
+
+bool frozen_view::getBool() const {
+  requireKind(dynamic::BOOL, "bool");
+  return slot_.kind == kTrue;
+}
+
+std::int64_t frozen_view::getInt() const {
+  requireKind(dynamic::INT64, "int64");
+  if (slot_.kind == kSmallInt) {
+    return static_cast<std::int32_t>(slot_.payload);
+  }
+  return *ptrAt<std::int64_t>(base_, slot_.payload);
+}
+
+double frozen_view::getDouble() const {
+  requireKind(dynamic::DOUBLE, "double");
+  return *ptrAt<double>(base_, slot_.payload);
+}
+
+StringPiece frozen_view::getString() const {
+  requireKind(dynamic::STRING, "string");
+  return stringAt(base_, slot_.payload);
+}
+
+bool frozen_view::asBool() const {
+  if (isBool()) {
+    return getBool();
+  }
+  if (isArray() || isObject()) {
+    throw_exception<TypeError>("int/double/bool/string", type());
+  }
+  return toDynamic().asBool();
+}
+
+std::int64_t frozen_view::asInt() const {
+  if (isInt()) {
+    return getInt();
+  }
+  if (isArray() || isObject()) {
+    throw_exception<TypeError>("int/double/bool/string", type());
+  }
+  return toDynamic().asInt();
+}
+
+double frozen_view::asDouble() const {
+  if (isDouble()) {
+    return getDouble();
+  }
+  if (isArray() || isObject()) {
+    throw_exception<TypeError>("int/double/bool/string", type());
+  }
+  return toDynamic().asDouble();
+}
+
+std::string frozen_view::asString() const {
+  if (isString()) {
+    return getString().str();
+  }
+  if (isArray() || isObject()) {
+    throw_exception<TypeError>("int/double/bool/string", type());
+  }
+  return toDynamic().asString();
+}
+
+std::size_t frozen_view::size() const {
+  switch (slot_.kind) {
+    case kString:
+      return getString().size();
+    case kArray:
+    case kObject:
+      return containerSize();
+    default:
+      throw_exception<TypeError>("array/object/string", type());
+  }
+}
+
+std::size_t frozen_view::findKey(StringPiece key) const {
+  auto layout = objectAt(base_, slot_.payload);
+  auto needle = keyPrefix(key);
+  std::size_t i = 0;
+  if (layout.size > kLinearSearchMax) {
+    i = std::lower_bound(
+            layout.prefixes, layout.prefixes + layout.size, needle) -
+        layout.prefixes;
+  } else {
+    i = findPrefix(layout, needle);
+  }
+  // Keys with the same prefix are adjacent.
+  for (; i < layout.size && layout.prefixes[i] == needle; ++i) {
+    if (stringAt(base_, layout.keys[i]) == key) {
+      return i;
+    }
+  }
+  return layout.size;
+}
+
+Optional<frozen_view> frozen_view::get_ptr(StringPiece key) const {
+  requireKind(dynamic::OBJECT, "object");
+  auto i = findKey(key);
+  auto layout = objectAt(base_, slot_.payload);
+  if (i == layout.size) {
+    return none;
+  }
+  return frozen_view(base_, layout.values[i]);
+}
+
+Optional<frozen_view> frozen_view::get_ptr(std::size_t idx) const {
+  requireKind(dynamic::ARRAY, "array");
+  if (idx >= containerSize()) {
+    return none;
+  }
+  return begin()[idx];
+}
+
+frozen_view frozen_view::at(StringPiece key) const {
+  auto ret = get_ptr(key);
+  if (!ret) {
+    throw_exception<std::out_of_range>(
+        sformat("couldn't find key {} in dynamic object", key));
+  }
+  return *ret;
+}
+
+frozen_view frozen_view::at(std::size_t idx) const {
+  auto ret = get_ptr(idx);
+  if (!ret) {
+    throw_exception<std::out_of_range>("out of range in dynamic array");
+  }
+  return *ret;
+}
+
+frozen_view::item_iterator frozen_view::find(StringPiece key) const {
+  requireKind(dynamic::OBJECT, "object");
+  return item_iterator(
+      base_, slot_.payload, static_cast<std::uint32_t>(findKey(key)));
+}
+
+Optional<frozen_view> frozen_view::get_ptr(json_pointer const& jsonPtr) const {
+  frozen_view curr = *this;
+  for (auto const& token : jsonPtr.tokens()) {
+    switch (curr.slot_.kind) {
+      case kArray: {
+        if (token.size() > 1 && token[0] == '0') {
+          throw std::invalid_argument(
+              "leading zero not allowed when indexing arrays");
+        }
+        // Appending, or resolving past an append, finds nothing.
+        if (token == "-") {
+          return none;
+        }
+        auto idx = tryTo<std::size_t>(token);
+        if (!idx) {
+          throw std::invalid_argument("array index is not numeric");
+        }
+        auto next = curr.get_ptr(*idx);
+        if (!next) {
+          return none;
+        }
+        curr = *next;
+        break;
+      }
+      case kObject: {
+        auto next = curr.get_ptr(StringPiece(token));
+        if (!next) {
+          return none;
+        }
+        curr = *next;
+        break;
+      }
+      default:
+        throw_exception<TypeError>("object/array", curr.type());
+    }
+  }
+  return curr;
+}
+
+frozen_view::array_iterator frozen_view::begin() const {
+  requireKind(dynamic::ARRAY, "array");
+  return array_iterator(
+      base_, ptrAt<detail::frozen_slot>(base_, slot_.payload + 8));
+}
+
+frozen_view::array_iterator frozen_view::end() const {
+  return begin() + containerSize();
+}
+
+Range<frozen_view::item_iterator> frozen_view::items() const {
+  requireKind(dynamic::OBJECT, "object");
+  return {
+      item_iterator(base_, slot_.payload, 0),
+      item_iterator(base_, slot_.payload, containerSize())};
+}
+
+frozen_view::item_iterator::value_type frozen_view::item_iterator::operator*()
+    const {
+  auto layout = objectAt(base_, object_);
+  return {
+      stringAt(base_, layout.keys[idx_]),
+      frozen_view(base_, layout.values[idx_])};
+}
+
+dynamic frozen_view::toDynamic() const {
+  switch (slot_.kind) {
+    case kNull:
+      return nullptr;
+    case kFalse:
+    case kTrue:
+      return getBool();
+    case kSmallInt:
+    case kInt:
+      return getInt();
+    case kDouble:
+      return getDouble();
+    case kString:
+      return getString();
+    case kArray: {
+      dynamic ret = dynamic::array;
+      ret.reserve(containerSize());
+      for (auto element : *this) {
+        ret.push_back(element.toDynamic());
+      }
+      return ret;
+    }
+    case kObject: {
+      dynamic ret = dynamic::object;
+      ret.reserve(containerSize());
+      for (auto item : items()) {
+        ret.insert(item.first, item.second.toDynamic());
+      }
+      return ret;
+    }
+  }
+  throw_exception<std::logic_error>("unknown frozen_dynamic kind");
+}
+
+} // namespace json
+} // namespace folly
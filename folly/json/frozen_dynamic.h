@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * An immutable dynamic, encoded in one contiguous buffer.
+ *
+ *   folly::json::frozen_dynamic config(parseJson(text));
+ *   auto port = config.root().at("server").at("port").getInt();
+ *
+ * A frozen_dynamic holds no pointers: every value is an 8 byte slot, and
+ * arrays, objects and strings refer to their contents by offset. It takes
+ * a fraction of the memory of the dynamic it was built from, and it can be
+ * written to a file with bytes() and mapped back with mapFile(), which
+ * costs no parsing and no allocation:
+ *
+ *   writeFile(config.bytes(), "config.frozen");
+ *   ...
+ *   auto config = folly::json::frozen_dynamic::mapFile("config.frozen");
+ *
+ * Equal strings, which are mostly the keys of similar objects, are stored
+ * once. The keys of each object are sorted, along with a table of their
+ * first four bytes, which lookups scan with SIMD instructions, or binary
+ * search in large objects. Object items are iterated in key order.
+ *
+ * Object keys must be strings. The encoding is limited to 4GB, and is in
+ * the byte order of the machine that wrote it.
+ *
+ * @file frozen_dynamic.h
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/json/dynamic.h>
+#include <folly/json/json_pointer.h>
+
+namespace folly {
+namespace json {
+
+class frozen_view;
+
+namespace detail {
+
+// A value: its kind, and either the value itself (booleans, integers that
+// fit in 32 bits) or the offset of its contents in the buffer.
+struct frozen_slot {
+  std::uint32_t kind;
+  std::uint32_t payload;
+};
+
+} // namespace detail
+
+class frozen_dynamic {
+ public:
+  /**
+   * Encode value. Throws TypeError if an object has a key that is not a
+   * string, and std::length_error if the encoding would exceed 4GB.
+   */
+  explicit frozen_dynamic(dynamic const& value);
+
+  /**
+   * Use the bytes() of a frozen_dynamic, without copying them. bytes must
+   * be 8 byte aligned and outlive the result and its copies.
+   *
+   * Only the header is checked, so this is constant time; call validate()
+   * before reading bytes that may be corrupt.
+   */
+  static frozen_dynamic fromBytes(ByteRange bytes);
+
+  /**
+   * Map a file that holds the bytes() of a frozen_dynamic. The mapping is
+   * shared by the copies of the result, and unmapped with the last of them.
+   */
+  static frozen_dynamic mapFile(char const* path);
+
+  /**
+   * The encoding, to be stored and passed to fromBytes() or mapFile().
+   */
+  ByteRange bytes() const { return bytes_; }
+
+  frozen_view root() const;
+
+  /**
+   * Check that every offset and size of the encoding is within bounds and
+   * that objects are sorted. Throws std::runtime_error if not.
+   */
+  void validate() const;
+
+ private:
+  frozen_dynamic(ByteRange bytes, std::shared_ptr<void const> owner);
+
+  ByteRange bytes_;
+  // Keeps the bytes alive, unless they are borrowed.
+  std::shared_ptr<void const> owner_;
+};
+
+/**
+ * A handle to one value of a frozen_dynamic: 16 bytes, cheap to copy, and
+ * valid as long as the bytes of the frozen_dynamic.
+ *
+ * The accessors mirror the read-only API of dynamic and throw the same
+ * exceptions: TypeError when the value has a different type,
+ * std::out_of_range for missing keys or indices.
+ */
+class frozen_view {
+ public:
+  class array_iterator;
+  class item_iterator;
+
+  dynamic::Type type() const;
+
+  bool isNull() const { return type() == dynamic::NULLT; }
+  bool isBool() const { return type() == dynamic::BOOL; }
+  bool isInt() const { return type() == dynamic::INT64; }
+  bool isDouble() const { return type() == dynamic::DOUBLE; }
+  bool isNumber() const { return isInt() || isDouble(); }
+  bool isString() const { return type() == dynamic::STRING; }
+  bool isArray() const { return type() == dynamic::ARRAY; }
+  bool isObject() const { return type() == dynamic::OBJECT; }
+
+  /**
+   * Scalar accessors. The get* versions require the exact type; the as*
+   * versions convert like their dynamic counterparts. getString() points
+   * into the buffer; the string is followed by a NUL.
+   */
+  bool getBool() const;
+  std::int64_t getInt() const;
+  double getDouble() const;
+  StringPiece getString() const;
+
+  bool asBool() const;
+  std::int64_t asInt() const;
+  double asDouble() const;
+  std::string asString() const;
+
+  /**
+   * Number of elements of an array, of items of an object, or of bytes of
+   * a string.
+   */
+  std::size_t size() const;
+  bool empty() const { return size() == 0; }
+
+  /**
+   * Element lookup. get_ptr returns none on misses, at and operator[]
+   * throw std::out_of_range.
+   */
+  Optional<frozen_view> get_ptr(StringPiece key) const;
+  Optional<frozen_view> get_ptr(std::size_t idx) const;
+  frozen_view at(StringPiece key) const;
+  frozen_view at(std::size_t idx) const;
+  frozen_view operator[](StringPiece key) const { return at(key); }
+  frozen_view operator[](std::size_t idx) const { return at(idx); }
+  std::size_t count(StringPiece key) const { return get_ptr(key) ? 1 : 0; }
+
+  /**
+   * The item with the given key, or items().end().
+   */
+  item_iterator find(StringPiece key) const;
+
+  /**
+   * Resolve a json_pointer relative to this value, with the same
+   * semantics as dynamic::get_ptr(json_pointer const&).
+   */
+  Optional<frozen_view> get_ptr(json_pointer const& jsonPtr) const;
+
+  /**
+   * Array elements.
+   */
+  array_iterator begin() const;
+  array_iterator end() const;
+
+  /**
+   * Object items, as pairs of key and value, in key order.
+   */
+  Range<item_iterator> items() const;
+
+  /**
+   * Decode this value, and everything below it, into a dynamic.
+   */
+  dynamic toDynamic() const;
+
+ private:
+  friend class frozen_dynamic;
+
+  frozen_view(std::uint8_t const* base, detail::frozen_slot slot)
+      : base_(base), slot_(slot) {}
+
+  void requireKind(dynamic::Type t, char const* expected) const;
+  std::uint32_t containerSize() const;
+  std::size_t findKey(StringPiece key) const;
+
+  std::uint8_t const* base_;
+  detail::frozen_slot slot_;
+};
+
+class frozen_view::array_iterator {
+ public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = frozen_view;
+  using difference_type = std::ptrdiff_t;
+  using pointer = frozen_view const*;
+  using reference = frozen_view;
+
+  array_iterator() = default;
+
+  frozen_view operator*() const { return {base_, *slot_}; }
+  frozen_view operator[](difference_type n) const { return {base_, slot_[n]}; }
+
+  array_iterator& operator++() {
+    ++slot_;
+    return *this;
+  }
+  array_iterator operator++(int) {
+    auto ret = *this;
+    ++slot_;
+    return ret;
+  }
+  array_iterator& operator--() {
+    --slot_;
+    return *this;
+  }
+  array_iterator operator--(int) {
+    auto ret = *this;
+    --slot_;
+    return ret;
+  }
+  array_iterator& operator+=(difference_type n) {
+    slot_ += n;
+    return *this;
+  }
+  array_iterator& operator-=(difference_type n) {
+    slot_ -= n;
+    return *this;
+  }
+  friend array_iterator operator+(array_iterator it, difference_type n) {
+    return it += n;
+  }
+  friend array_iterator operator+(difference_type n, array_iterator it) {
+    return it += n;
+  }
+  friend array_iterator operator-(array_iterator it, difference_type n) {
+    return it -= n;
+  }
+  friend difference_type operator-(
+      array_iterator const& a, array_iterator const& b) {
+    return a.slot_ - b.slot_;
+  }
+
+  friend bool operator==(array_iterator const& a, array_iterator const& b) {
+    return a.slot_ == b.slot_;
+  }
+  friend bool operator!=(array_iterator const& a, array_iterator const& b) {
+    return a.slot_ != b.slot_;
+  }
+  friend bool operator<(array_iterator const& a, array_iterator const& b) {
+    return a.slot_ < b.slot_;
+  }
+  friend bool operator>(array_iterator const& a, array_iterator const& b) {
+    return a.slot_ > b.slot_;
+  }
+  friend bool operator<=(array_iterator const& a, array_iterator const& b) {
+    return a.slot_ <= b.slot_;
+  }
+  friend bool operator>=(array_iterator const& a, array_iterator const& b) {
+    return a.slot_ >= b.slot_;
+  }
+
+ private:
+  friend class frozen_view;
+
+  array_iterator(std::uint8_t const* base, detail::frozen_slot const* slot)
+      : base_(base), slot_(slot) {}
+
+  std::uint8_t const* base_{nullptr};
+  detail::frozen_slot const* slot_{nullptr};
+};
+
+class frozen_view::item_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::pair<StringPiece, frozen_view>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = value_type const*;
+  using reference = value_type;
+
+  item_iterator() = default;
+
+  value_type operator*() const;
+
+  item_iterator& operator++() {
+    ++idx_;
+    return *this;
+  }
+  item_iterator operator++(int) {
+    auto ret = *this;
+    ++idx_;
+    return ret;
+  }
+
+  friend bool operator==(item_iterator const& a, item_iterator const& b) {
+    return a.idx_ == b.idx_;
+  }
+  friend bool operator!=(item_iterator const& a, item_iterator const& b) {
+    return a.idx_ != b.idx_;
+  }
+
+ private:
+  friend class frozen_view;
+
+  item_iterator(
+      std::uint8_t const* base, std::uint32_t object, std::uint32_t idx)
+      : base_(base), object_(object), idx_(idx) {}
+
+  std::uint8_t const* base_{nullptr};
+  // Offset of the object.
+  std::uint32_t object_{0};
+  std::uint32_t idx_{0};
+};
+
+} // namespace json
+} // namespace folly
@@ -30,7 +30,17 @@
 #include <folly/Range.h>
 #include <folly/Unicode.h>
 #include <folly/Utility.h>
+#include <folly/algorithm/simd/Ignore.h>
+#include <folly/algorithm/simd/Movemask.h>
+#include <folly/algorithm/simd/detail/SimdPlatform.h>
+#include <folly/json/detail/JsonStructuralIndex.h>
+#include <folly/json/json_events.h>
+#include <folly/json/json_reader.h>
+#include <folly/json/json_writer.h>
+#include <folly/lang/Assume.h>
 #include <folly/lang/Bits.h>
+#include <folly/lang/ToAscii.h>
+#include <folly/memory/UninitializedMemoryHacks.h>
 #include <folly/portability/Constexpr.h>
 
 namespace folly {
@@ -53,6 +63,28 @@ parse_error make_parse_error(
       expected));
 }
 
+// A writer into a std::string. The string holds uninitialized room past pos_
+// until finish() trims it.
+class string_writer : public writer {
+ public:
+  explicit string_writer(std::string& out) : out_(out) {
+    pos_ = end_ = &out_[0] + out_.size();
+  }
+
+  void finish() { out_.resize(size_t(pos_ - &out_[0])); }
+
+ private:
+  void grow(size_t n) override {
+    auto size = size_t(pos_ - &out_[0]);
+    resizeWithoutInitialization(
+        out_, std::max({size + n, 2 * size, out_.capacity()}));
+    pos_ = &out_[0] + size;
+    end_ = &out_[0] + out_.size();
+  }
+
+  std::string& out_;
+};
+
 struct Printer {
   // Context class is allows to restore the path to element that we are about to
   // print so that if error happens we can throw meaningful exception.
@@ -95,7 +127,7 @@ struct Printer {
   };
 
   explicit Printer(
-      std::string& out, unsigned* indentLevel, serialization_opts const* opts)
+      writer& out, unsigned* indentLevel, serialization_opts const* opts)
       : out_(out), indentLevel_(indentLevel), opts_(*opts) {}
 
   void operator()(dynamic const& v, const Context& context) const {
@@ -116,12 +148,15 @@ struct Printer {
                 contextDescription(context));
           }
         }
-        toAppend(
-            v.asDouble(),
-            &out_,
-            opts_.dtoa_mode,
-            opts_.double_num_digits,
-            opts_.dtoa_flags);
+        char buffer[folly::detail::kFloatingToCharsBufferSize];
+        out_.append(
+            buffer,
+            folly::detail::floatingToChars(
+                buffer,
+                v.asDouble(),
+                opts_.dtoa_mode,
+                opts_.double_num_digits,
+                opts_.dtoa_flags));
         break;
       }
       case dynamic::INT64: {
@@ -131,14 +166,27 @@ struct Printer {
           // as a double without loss of precision.
           intval = int64_t(to<double>(intval));
         }
-        toAppend(intval, &out_);
+        auto uintval = intval < 0 ? ~static_cast<uint64_t>(intval) + 1
+                                  : static_cast<uint64_t>(intval);
+        char buffer[1 + to_ascii_size_max_decimal<uint64_t>];
+        buffer[0] = '-';
+        auto sign = size_t(intval < 0);
+        out_.append(
+            buffer,
+            sign +
+                to_ascii_decimal(
+                    buffer + sign, buffer + sizeof(buffer), uintval));
         break;
       }
       case dynamic::BOOL:
-        out_ += v.asBool() ? "true" : "false";
+        if (v.asBool()) {
+          out_.append("true", 4);
+        } else {
+          out_.append("false", 5);
+        }
         break;
       case dynamic::NULLT:
-        out_ += "null";
+        out_.append("null", 4);
         break;
       case dynamic::STRING:
         escapeString(v.stringPiece(), out_, opts_);
@@ -188,7 +236,7 @@ struct Printer {
       const {
     printKV(o, *begin, context);
     for (++begin; begin != end; ++begin) {
-      out_ += ',';
+      out_.push_back(',');
       newline();
       printKV(o, *begin, context);
     }
@@ -196,11 +244,11 @@ struct Printer {
 
   void printObject(dynamic const& o, const Context* context) const {
     if (o.empty()) {
-      out_ += "{}";
+      out_.append("{}", 2);
       return;
     }
 
-    out_ += '{';
+    out_.push_back('{');
     indent();
     newline();
     if (opts_.sort_keys || opts_.sort_keys_by) {
@@ -223,18 +271,20 @@ struct Printer {
     }
     outdent();
     newline();
-    out_ += '}';
+    out_.push_back('}');
   }
 
   static std::string toStringOr(dynamic const& v, const char* placeholder) {
     try {
       std::string result;
+      string_writer out(result);
       unsigned indentLevel = 0;
       serialization_opts opts;
       opts.allow_nan_inf = true;
       opts.allow_non_string_keys = true;
-      Printer printer(result, &indentLevel, &opts);
+      Printer printer(out, &indentLevel, &opts);
       printer(v, nullptr);
+      out.finish();
       return result;
     } catch (...) {
       return placeholder;
@@ -250,22 +300,22 @@ struct Printer {
 
   void printArray(dynamic const& a, const Context* context) const {
     if (a.empty()) {
-      out_ += "[]";
+      out_.append("[]", 2);
       return;
     }
 
-    out_ += '[';
+    out_.push_back('[');
     indent();
     newline();
     (*this)(a[0], Context(context, dynamic(0)));
     for (auto it = std::next(a.begin()); it != a.end(); ++it) {
-      out_ += ',';
+      out_.push_back(',');
       newline();
       (*this)(*it, Context(context, dynamic(std::distance(a.begin(), it))));
     }
     outdent();
     newline();
-    out_ += ']';
+    out_.push_back(']');
   }
 
  private:
@@ -284,14 +334,21 @@ struct Printer {
   void newline() const {
     if (indentLevel_) {
       auto indent = *indentLevel_ * opts_.pretty_formatting_indent_width;
-      out_ += to<std::string>('\n', std::string(indent, ' '));
+      out_.push_back('\n');
+      out_.append(indent, ' ');
     }
   }
 
-  void mapColon() const { out_ += indentLevel_ ? ": " : ":"; }
+  void mapColon() const {
+    if (indentLevel_) {
+      out_.append(": ", 2);
+    } else {
+      out_.push_back(':');
+    }
+  }
 
  private:
-  std::string& out_;
+  writer& out_;
   unsigned* const indentLevel_;
   serialization_opts const& opts_;
 };
@@ -300,8 +357,15 @@ struct Printer {
 
 // Wraps our input buffer with some helper functions.
 struct Input {
-  explicit Input(StringPiece range, json::serialization_opts const* opts)
-      : range_(range), opts_(*opts), lineNum_(0) {
+  explicit Input(
+      StringPiece range,
+      json::serialization_opts const* opts,
+      unsigned lineNum = 0,
+      unsigned recursionLevel = 0)
+      : range_(range),
+        opts_(*opts),
+        lineNum_(lineNum),
+        currentRecursionLevel_(recursionLevel) {
     storeCurrent();
   }
 
@@ -312,6 +376,8 @@ struct Input {
 
   unsigned getLineNum() const { return lineNum_; }
 
+  StringPiece remaining() const { return range_; }
+
   // Parse ahead for as long as the supplied predicate is satisfied,
   // returning a range of what was skipped.
   template <class Predicate>
@@ -416,6 +482,10 @@ struct Input {
 
   json::serialization_opts const& getOpts() { return opts_; }
 
+  // The arena of the arrays and objects, or null for the heap.
+  dynamic_arena* getArena() const { return arena_; }
+  void setArena(dynamic_arena* arena) { arena_ = arena; }
+
   void incrementRecursionLevel() {
     if (currentRecursionLevel_ > opts_.recursion_limit) {
       error("recursion limit exceeded");
@@ -425,6 +495,8 @@ struct Input {
 
   void decrementRecursionLevel() { currentRecursionLevel_--; }
 
+  unsigned getRecursionLevel() const { return currentRecursionLevel_; }
+
  private:
   void storeCurrent() { current_ = range_.empty() ? EOF : range_.front(); }
 
@@ -434,6 +506,7 @@ struct Input {
   unsigned lineNum_;
   int current_;
   unsigned int currentRecursionLevel_{0};
+  dynamic_arena* arena_{nullptr};
 };
 
 class RecursionGuard {
@@ -482,7 +555,8 @@ dynamic parseObject(Input& in, json::metadata_map* map) {
   DCHECK_EQ(*in, '{');
   ++in;
 
-  dynamic ret = dynamic::object;
+  dynamic ret = in.getArena() ? dynamic::object_in(*in.getArena())
+                             : dynamic(dynamic::object);
 
   in.skipWhitespace();
   if (*in == '}') {
@@ -523,7 +597,8 @@ dynamic parseArray(Input& in, json::metadata_map* map) {
   DCHECK_EQ(*in, '[');
   ++in;
 
-  dynamic ret = dynamic::array;
+  dynamic ret = in.getArena() ? dynamic::array_in(*in.getArena())
+                             : dynamic(dynamic::array);
 
   in.skipWhitespace();
   if (*in == ']') {
@@ -666,11 +741,8 @@ void decodeUnicodeEscape(Input& in, std::string& out) {
   appendCodePointToUtf8(codePoint, out);
 }
 
-std::string parseString(Input& in) {
-  DCHECK_EQ(*in, '\"');
-  ++in;
-
-  std::string ret;
+// Decodes the rest of a string whose opening quote was consumed.
+void parseStringTail(Input& in, std::string& ret) {
   for (;;) {
     auto range = in.skipWhile([](char c) { return c != '\"' && c != '\\'; });
     ret.append(range.begin(), range.end());
@@ -716,19 +788,37 @@ std::string parseString(Input& in) {
     ret.push_back(char(*in));
     ++in;
   }
+}
+
+std::string parseString(Input& in) {
+  DCHECK_EQ(*in, '\"');
+  ++in;
 
+  std::string ret;
+  parseStringTail(in, ret);
   return ret;
 }
 
-dynamic parseValue(Input& in, json::metadata_map* map) {
-  RecursionGuard guard(in);
+// Like parseString, but returns strings without escapes in place, and
+// decodes the others into scratch.
+StringPiece parseStringPiece(Input& in, std::string& scratch) {
+  DCHECK_EQ(*in, '\"');
+  ++in;
 
-  in.skipWhitespace();
+  auto range = in.skipWhile([](char c) { return c != '\"' && c != '\\'; });
+  if (*in == '\"') {
+    ++in;
+    return range;
+  }
+  scratch.assign(range.begin(), range.end());
+  parseStringTail(in, scratch);
+  return scratch;
+}
+
+// Numbers and bare literals.
+dynamic parseScalar(Input& in) {
   // clang-format off
   return
-      *in == '[' ? parseArray(in, map) :
-      *in == '{' ? parseObject(in, map) :
-      *in == '\"' ? parseString(in) :
       (*in == '-' || (*in >= '0' && *in <= '9')) ? parseNumber(in) :
       in.consume("true") ? true :
       in.consume("false") ? false :
@@ -743,6 +833,402 @@ dynamic parseValue(Input& in, json::metadata_map* map) {
   // clang-format on
 }
 
+dynamic parseValue(Input& in, json::metadata_map* map) {
+  RecursionGuard guard(in);
+
+  in.skipWhitespace();
+  // clang-format off
+  return
+      *in == '[' ? parseArray(in, map) :
+      *in == '{' ? parseObject(in, map) :
+      *in == '\"' ? parseString(in) :
+      parseScalar(in);
+  // clang-format on
+}
+
+// Object keys for the event and reader interfaces, which only take strings.
+StringPiece parseKey(Input& in, std::string& scratch) {
+  in.skipWhitespace();
+  if (*in == '\"') {
+    RecursionGuard guard(in);
+    return parseStringPiece(in, scratch);
+  }
+  auto const& opts = in.getOpts();
+  auto key = parseValue(in, nullptr);
+  if (!opts.convert_int_keys || !key.isInt()) {
+    in.error(
+        opts.convert_int_keys ? "expected string or integer for object key"
+                              : "expected string for object key");
+  }
+  scratch = key.asString();
+  return scratch;
+}
+
+void parseEvents(
+    Input& in, json::event_handler& handler, std::string& scratch);
+
+void parseObjectEvents(
+    Input& in, json::event_handler& handler, std::string& scratch) {
+  DCHECK_EQ(*in, '{');
+  ++in;
+  handler.on_begin_object();
+
+  in.skipWhitespace();
+  if (*in == '}') {
+    ++in;
+    handler.on_end_object();
+    return;
+  }
+
+  for (;;) {
+    if (in.getOpts().allow_trailing_comma && *in == '}') {
+      break;
+    }
+    handler.on_key(parseKey(in, scratch));
+    in.skipWhitespace();
+    in.expect(':');
+    parseEvents(in, handler, scratch);
+
+    in.skipWhitespace();
+    if (*in != ',') {
+      break;
+    }
+    ++in;
+    in.skipWhitespace();
+  }
+  in.expect('}');
+  handler.on_end_object();
+}
+
+void parseArrayEvents(
+    Input& in, json::event_handler& handler, std::string& scratch) {
+  DCHECK_EQ(*in, '[');
+  ++in;
+  handler.on_begin_array();
+
+  in.skipWhitespace();
+  if (*in == ']') {
+    ++in;
+    handler.on_end_array();
+    return;
+  }
+
+  for (;;) {
+    if (in.getOpts().allow_trailing_comma && *in == ']') {
+      break;
+    }
+    parseEvents(in, handler, scratch);
+    in.skipWhitespace();
+    if (*in != ',') {
+      break;
+    }
+    ++in;
+    in.skipWhitespace();
+  }
+  in.expect(']');
+  handler.on_end_array();
+}
+
+void parseScalarEvents(Input& in, json::event_handler& handler) {
+  auto value = parseScalar(in);
+  switch (value.type()) {
+    case dynamic::NULLT:
+      handler.on_null();
+      break;
+    case dynamic::BOOL:
+      handler.on_bool(value.getBool());
+      break;
+    case dynamic::INT64:
+      handler.on_int(value.getInt());
+      break;
+    case dynamic::DOUBLE:
+      handler.on_double(value.getDouble());
+      break;
+    case dynamic::STRING: // parse_numbers_as_strings
+      handler.on_string(value.getString());
+      break;
+    case dynamic::ARRAY:
+    case dynamic::OBJECT:
+      folly::assume_unreachable();
+  }
+}
+
+void parseEvents(
+    Input& in, json::event_handler& handler, std::string& scratch) {
+  RecursionGuard guard(in);
+
+  in.skipWhitespace();
+  switch (*in) {
+    case '[':
+      parseArrayEvents(in, handler, scratch);
+      break;
+    case '{':
+      parseObjectEvents(in, handler, scratch);
+      break;
+    case '\"':
+      handler.on_string(parseStringPiece(in, scratch));
+      break;
+    default:
+      parseScalarEvents(in, handler);
+      break;
+  }
+}
+
+// Drops the events of values skipped by json::reader.
+class IgnoreEvents : public json::event_handler {
+ public:
+  void on_null() override {}
+  void on_bool(bool) override {}
+  void on_int(int64_t) override {}
+  void on_double(double) override {}
+  void on_string(StringPiece) override {}
+  void on_begin_array() override {}
+  void on_end_array() override {}
+  void on_begin_object() override {}
+  void on_key(StringPiece) override {}
+  void on_end_object() override {}
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// Stage two of the indexed parser: walks the offsets produced by
+// detail::buildJsonStructuralIndex instead of the raw bytes.  Whitespace is
+// never looked at, strings without escapes are copied in one go, and scalars
+// and escaped strings are handed to the byte-wise helpers above.
+class IndexedInput {
+ public:
+  IndexedInput(
+      StringPiece doc,
+      std::vector<uint32_t> const& index,
+      json::serialization_opts const& opts)
+      : doc_(doc),
+        pos_(index.data()),
+        end_(index.data() + index.size()),
+        opts_(opts) {}
+
+  IndexedInput(IndexedInput const&) = delete;
+  IndexedInput& operator=(IndexedInput const&) = delete;
+
+  bool done() const { return pos_ == end_; }
+
+  // The character at the next structural position, or EOF.
+  int peek() const { return done() ? EOF : doc_[*pos_]; }
+
+  uint32_t offset() const { return done() ? uint32_t(doc_.size()) : *pos_; }
+
+  uint32_t next() { return *pos_++; }
+
+  // Drop the rest of the index.
+  void finish() { pos_ = end_; }
+
+  void expect(char c) {
+    if (peek() != c) {
+      throw json::make_parse_error(
+          lineAt(offset()),
+          context(offset()),
+          to<std::string>("expected '", c, '\''));
+    }
+    ++pos_;
+  }
+
+  StringPiece doc() const { return doc_; }
+
+  json::serialization_opts const& getOpts() const { return opts_; }
+
+  [[noreturn]] void error(uint32_t offset, char const* what) const {
+    throw json::make_parse_error(lineAt(offset), context(offset), what);
+  }
+
+  // Line numbers are only needed for errors, so they are computed on demand
+  // rather than tracked while parsing.
+  unsigned lineAt(uint32_t offset) const {
+    return unsigned(std::count(doc_.begin(), doc_.begin() + offset, '\n'));
+  }
+
+  std::string context(uint32_t offset) const {
+    return doc_.subpiece(offset, 16 /* arbitrary */).toString();
+  }
+
+  void incrementRecursionLevel() {
+    if (currentRecursionLevel_ > opts_.recursion_limit) {
+      error(offset(), "recursion limit exceeded");
+    }
+    currentRecursionLevel_++;
+  }
+
+  void decrementRecursionLevel() { currentRecursionLevel_--; }
+
+ private:
+  StringPiece doc_;
+  uint32_t const* pos_;
+  uint32_t const* end_;
+  json::serialization_opts const& opts_;
+  unsigned int currentRecursionLevel_{0};
+};
+
+class IndexedRecursionGuard {
+ public:
+  explicit IndexedRecursionGuard(IndexedInput& in) : in_(in) {
+    in_.incrementRecursionLevel();
+  }
+
+  ~IndexedRecursionGuard() { in_.decrementRecursionLevel(); }
+
+ private:
+  IndexedInput& in_;
+};
+
+// Runs one of the byte-wise helpers over [begin, end) of the document. Parse
+// errors are rare, so only then is the token parsed again with the right line
+// number in place so that the error matches the one parseJson would report.
+template <typename F>
+auto parseIndexedToken(
+    IndexedInput& in, uint32_t begin, uint32_t end, F&& parse) {
+  auto token = in.doc().subpiece(begin, end - begin);
+  try {
+    Input sub(token, &in.getOpts());
+    return parse(sub);
+  } catch (json::parse_error const&) {
+    Input sub(token, &in.getOpts(), in.lineAt(begin));
+    return parse(sub);
+  }
+}
+
+dynamic parseIndexedValue(IndexedInput& in, bool topLevel = false);
+
+std::string parseIndexedString(IndexedInput& in, uint32_t open) {
+  DCHECK_EQ(in.doc()[open], '\"');
+  if (in.peek() != '\"') {
+    in.error(open, "unterminated string");
+  }
+  uint32_t close = in.next();
+  auto body = in.doc().subpiece(open + 1, close - open - 1);
+  auto special = std::find_if(body.begin(), body.end(), [](char c) {
+    return c == '\\' || c == '\0';
+  });
+  if (FOLLY_LIKELY(special == body.end())) {
+    return body.toString();
+  }
+  return parseIndexedToken(
+      in, open, close + 1, [](Input& sub) { return parseString(sub); });
+}
+
+// The scalar runs until the next whitespace or structural character.
+dynamic parseIndexedScalar(IndexedInput& in, uint32_t begin, bool topLevel) {
+  auto doc = in.doc();
+  uint32_t end = begin;
+  while (end < doc.size()) {
+    char c = doc[end];
+    if (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '{' ||
+        c == '}' || c == '[' || c == ']' || c == ':' || c == ',' ||
+        c == '\"') {
+      break;
+    }
+    ++end;
+  }
+  return parseIndexedToken(in, begin, end, [&](Input& sub) {
+    auto ret = parseScalar(sub);
+    if (sub.size()) {
+      // Like parseJson, ignore anything after a null byte that follows the
+      // top-level value.
+      if (!topLevel || *sub != '\0') {
+        sub.error("unexpected character after json value");
+      }
+      in.finish();
+    }
+    return ret;
+  });
+}
+
+dynamic parseIndexedObject(IndexedInput& in) {
+  dynamic ret = dynamic::object;
+  if (in.peek() == '}') {
+    in.next();
+    return ret;
+  }
+
+  const auto& opts = in.getOpts();
+  const bool distinct = opts.validate_keys || opts.convert_int_keys;
+  for (;;) {
+    if (opts.allow_trailing_comma && in.peek() == '}') {
+      break;
+    }
+    auto keyOffset = in.offset();
+    dynamic key = parseIndexedValue(in);
+    if (opts.convert_int_keys && key.isInt()) {
+      key = key.asString();
+    } else if (!opts.allow_non_string_keys && !key.isString()) {
+      in.error(
+          keyOffset,
+          opts.convert_int_keys ? "expected string or integer for object key"
+                                : "expected string for object key");
+    }
+    in.expect(':');
+    auto value = parseIndexedValue(in);
+    auto [it, inserted] = ret.try_emplace(std::move(key), std::move(value));
+    if (!inserted) {
+      if (distinct) {
+        in.error(keyOffset, "duplicate key inserted");
+      }
+      it->second = std::move(value);
+    }
+
+    if (in.peek() != ',') {
+      break;
+    }
+    in.next();
+  }
+  in.expect('}');
+
+  return ret;
+}
+
+dynamic parseIndexedArray(IndexedInput& in) {
+  dynamic ret = dynamic::array;
+  if (in.peek() == ']') {
+    in.next();
+    return ret;
+  }
+
+  for (;;) {
+    if (in.getOpts().allow_trailing_comma && in.peek() == ']') {
+      break;
+    }
+    ret.push_back(parseIndexedValue(in));
+    if (in.peek() != ',') {
+      break;
+    }
+    in.next();
+  }
+  in.expect(']');
+
+  return ret;
+}
+
+dynamic parseIndexedValue(IndexedInput& in, bool topLevel) {
+  IndexedRecursionGuard guard(in);
+
+  if (in.done()) {
+    in.error(in.offset(), "expected json value");
+  }
+  uint32_t begin = in.next();
+  switch (in.doc()[begin]) {
+    case '{':
+      return parseIndexedObject(in);
+    case '[':
+      return parseIndexedArray(in);
+    case '\"':
+      return parseIndexedString(in, begin);
+    case '}':
+    case ']':
+    case ':':
+    case ',':
+      in.error(begin, "expected json value");
+    default:
+      return parseIndexedScalar(in, begin, topLevel);
+  }
+}
+
 } // namespace
 
 //////////////////////////////////////////////////////////////////////
@@ -759,10 +1245,99 @@ std::array<uint64_t, 2> buildExtraAsciiToEscapeBitmap(StringPiece chars) {
 
 std::string serialize(dynamic const& dyn, serialization_opts const& opts) {
   std::string ret;
+  string_writer out(ret);
+  serialize(dyn, opts, out);
+  out.finish();
+  return ret;
+}
+
+void serialize(
+    dynamic const& dyn, serialization_opts const& opts, writer& out) {
+  out.reserve(estimateSerializedSize(dyn, opts));
   unsigned indentLevel = 0;
-  Printer p(ret, opts.pretty_formatting ? &indentLevel : nullptr, &opts);
+  Printer p(out, opts.pretty_formatting ? &indentLevel : nullptr, &opts);
   p(dyn, nullptr);
-  return ret;
+}
+
+namespace {
+
+// Most doubles print shorter than their maximum length.
+constexpr size_t kEstimatedDoubleSize = 12;
+
+// Only the first elements of containers are measured, so that the estimate
+// stays cheap next to the serialization of large documents. The others are
+// counted at their smallest size rather than extrapolated from the first
+// ones: elements can differ wildly in size, and the estimate is reserved up
+// front, so it must not exceed the output by much.
+constexpr size_t kEstimateSampleSize = 16;
+
+// The smallest serialization of an element, and of an object member: 0 and
+// "":0.
+constexpr size_t kMinElementSize = 1;
+constexpr size_t kMinMemberSize = 4;
+
+size_t estimateSize(
+    dynamic const& v, serialization_opts const& opts, size_t indent) {
+  switch (v.type()) {
+    case dynamic::NULLT:
+      return 4;
+    case dynamic::BOOL:
+      return v.asBool() ? 4 : 5;
+    case dynamic::INT64:
+      return estimateSpaceNeeded(v.asInt());
+    case dynamic::DOUBLE:
+      return kEstimatedDoubleSize;
+    case dynamic::STRING:
+      return v.stringPiece().size() + 2;
+    case dynamic::ARRAY:
+    case dynamic::OBJECT:
+      break;
+  }
+  if (v.empty()) {
+    return 2;
+  }
+  auto const n = v.size();
+  // Brackets and commas.
+  size_t ret = n + 1;
+  size_t inner = indent;
+  if (opts.pretty_formatting) {
+    inner += opts.pretty_formatting_indent_width;
+    // A newline before each element and before the closing bracket, and the
+    // indentation that follows them.
+    ret += n + 1 + n * inner + indent;
+  }
+  size_t sampled = 0;
+  size_t elements = 0;
+  if (v.isArray()) {
+    for (auto const& e : v) {
+      if (sampled++ == kEstimateSampleSize) {
+        break;
+      }
+      elements += estimateSize(e, opts, inner);
+    }
+  } else {
+    for (auto const& [key, value] : v.items()) {
+      if (sampled++ == kEstimateSampleSize) {
+        break;
+      }
+      elements += opts.pretty_formatting ? 2 : 1; // colon
+      elements += estimateSize(key, opts, inner);
+      elements += size_t(opts.convert_int_keys && key.isInt()) * 2; // quotes
+      elements += estimateSize(value, opts, inner);
+    }
+  }
+  if (n > kEstimateSampleSize) {
+    elements += (n - kEstimateSampleSize) *
+        (v.isArray() ? kMinElementSize : kMinMemberSize);
+  }
+  return ret + elements;
+}
+
+} // namespace
+
+size_t estimateSerializedSize(
+    dynamic const& dyn, serialization_opts const& opts) {
+  return estimateSize(dyn, opts, 0);
 }
 
 // Fast path to determine the longest prefix that can be left
@@ -823,10 +1398,43 @@ size_t firstEscapableInWord(T s, const serialization_opts& opts) {
   }
 }
 
+#if FOLLY_DETAIL_HAS_SIMD_PLATFORM
+
+// Skips the bytes that never need escaping, a vector at a time, up to the
+// first one that may need it or to the last partial vector.
+const unsigned char* skipUnescapedSimd(
+    const unsigned char* p, const unsigned char* e) {
+  using Platform = simd::detail::SimdPlatform<std::uint8_t>;
+  while (e - p >= std::ptrdiff_t(Platform::kCardinal)) {
+    auto reg = Platform::loadu(p, simd::ignore_none{});
+    auto special = Platform::logical_or(
+        Platform::less_equal(reg, 0x1f),
+        Platform::logical_or(
+            Platform::equal(reg, '"'), Platform::equal(reg, '\\')));
+    auto [bits, bitsPerElement] = simd::movemask<std::uint8_t>(special);
+    // Bytes >= 0x80 are the ones that are not <= 0x7f.
+    auto ascii = simd::movemask<std::uint8_t>(
+                     Platform::less_equal(reg, 0x7f))
+                     .first;
+    constexpr auto kAll = n_least_significant_bits<decltype(bits)>(
+        Platform::kCardinal * decltype(bitsPerElement)::value);
+    auto needsEscape = bits | (ascii ^ kAll);
+    if (needsEscape) {
+      return p +
+          (folly::findFirstSet(needsEscape) - 1) /
+          decltype(bitsPerElement)::value;
+    }
+    p += Platform::kCardinal;
+  }
+  return p;
+}
+
+#endif
+
 // Escape a string so that it is legal to print it in JSON text.
-template <bool EnableExtraAsciiEscapes>
+template <bool EnableExtraAsciiEscapes, class Out>
 void escapeStringImpl(
-    StringPiece input, std::string& out, const serialization_opts& opts) {
+    StringPiece input, Out& out, const serialization_opts& opts) {
   auto hexDigit = [](uint8_t c) -> char {
     return c < 10 ? c + '0' : c - 10 + 'a';
   };
@@ -841,6 +1449,11 @@ void escapeStringImpl(
     // Find the longest prefix that does not need escaping, and copy
     // it literally into the output string.
     auto firstEsc = p;
+#if FOLLY_DETAIL_HAS_SIMD_PLATFORM
+    if constexpr (!EnableExtraAsciiEscapes) {
+      firstEsc = skipUnescapedSimd(p, e);
+    }
+#endif
     while (firstEsc < e) {
       auto avail = to_unsigned(e - firstEsc);
       uint64_t word = 0;
@@ -970,6 +1583,17 @@ void escapeString(
   }
 }
 
+void escapeString(
+    StringPiece input, writer& out, const serialization_opts& opts) {
+  if (FOLLY_UNLIKELY(
+          opts.extra_ascii_to_escape_bitmap[0] ||
+          opts.extra_ascii_to_escape_bitmap[1])) {
+    escapeStringImpl<true>(input, out, opts);
+  } else {
+    escapeStringImpl<false>(input, out, opts);
+  }
+}
+
 std::string stripComments(StringPiece jsonC) {
   std::string result;
   enum class State {
@@ -1033,6 +1657,148 @@ std::string stripComments(StringPiece jsonC) {
   return result;
 }
 
+// The byte-wise parser, resuming from where the reader stopped. The reader
+// moves past whatever it consumed.
+struct reader_input : Input {
+  explicit reader_input(reader& r)
+      : Input(r.range_, &r.opts_, r.lineNum_, r.recursionLevel_), reader_(r) {}
+
+  ~reader_input() {
+    reader_.range_ = remaining();
+    reader_.lineNum_ = getLineNum();
+    reader_.recursionLevel_ = getRecursionLevel();
+  }
+
+  reader& reader_;
+};
+
+namespace {
+serialization_opts const& defaultReaderOpts() {
+  static serialization_opts const opts;
+  return opts;
+}
+} // namespace
+
+reader::reader(StringPiece range) : reader(range, defaultReaderOpts()) {}
+
+reader::reader(StringPiece range, serialization_opts const& opts)
+    : range_(range), opts_(opts) {}
+
+char reader::peek() {
+  reader_input in(*this);
+  in.skipWhitespace();
+  return *in == EOF ? '\0' : char(*in);
+}
+
+dynamic reader::readValue() {
+  reader_input in(*this);
+  return parseValue(in, nullptr);
+}
+
+std::string reader::readString() {
+  reader_input in(*this);
+  RecursionGuard guard(in);
+  in.skipWhitespace();
+  if (*in != '\"') {
+    in.expect('\"');
+  }
+  return parseString(in);
+}
+
+StringPiece reader::readStringPiece() {
+  reader_input in(*this);
+  RecursionGuard guard(in);
+  in.skipWhitespace();
+  if (*in != '\"') {
+    in.expect('\"');
+  }
+  return parseStringPiece(in, scratch_);
+}
+
+void reader::skipValue() {
+  reader_input in(*this);
+  IgnoreEvents ignore;
+  parseEvents(in, ignore, scratch_);
+}
+
+void reader::beginArray() {
+  reader_input in(*this);
+  in.incrementRecursionLevel();
+  in.skipWhitespace();
+  in.expect('[');
+  first_ = true;
+}
+
+bool reader::nextElement() {
+  reader_input in(*this);
+  in.skipWhitespace();
+  if (first_) {
+    first_ = false;
+    if (*in != ']') {
+      return true;
+    }
+  } else if (*in == ',') {
+    ++in;
+    in.skipWhitespace();
+    if (!opts_.allow_trailing_comma || *in != ']') {
+      return true;
+    }
+  }
+  in.expect(']');
+  in.decrementRecursionLevel();
+  return false;
+}
+
+void reader::beginObject() {
+  reader_input in(*this);
+  in.incrementRecursionLevel();
+  in.skipWhitespace();
+  in.expect('{');
+  first_ = true;
+}
+
+bool reader::nextKey(StringPiece& key) {
+  reader_input in(*this);
+  in.skipWhitespace();
+  if (first_) {
+    first_ = false;
+    if (*in == '}') {
+      ++in;
+      in.decrementRecursionLevel();
+      return false;
+    }
+  } else if (*in == ',') {
+    ++in;
+    in.skipWhitespace();
+    if (opts_.allow_trailing_comma && *in == '}') {
+      ++in;
+      in.decrementRecursionLevel();
+      return false;
+    }
+  } else {
+    in.expect('}');
+    in.decrementRecursionLevel();
+    return false;
+  }
+  key = parseKey(in, scratch_);
+  in.skipWhitespace();
+  in.expect(':');
+  return true;
+}
+
+void reader::finish() {
+  reader_input in(*this);
+  in.skipWhitespace();
+  if (in.size() && *in != '\0') {
+    in.error("parsing didn't consume all input");
+  }
+}
+
+void reader::error(char const* what) const {
+  Input in(range_, &opts_, lineNum_);
+  in.error(what);
+}
+
 } // namespace json
 
 //////////////////////////////////////////////////////////////////////
@@ -1075,6 +1841,60 @@ dynamic parseJson(StringPiece range, json::serialization_opts const& opts) {
   return ret;
 }
 
+dynamic parseJson(
+    StringPiece range,
+    json::serialization_opts const& opts,
+    dynamic_arena& arena) {
+  json::Input in(range, &opts);
+  in.setArena(&arena);
+
+  auto ret = parseValue(in, nullptr);
+  in.skipWhitespace();
+  if (in.size() && *in != '\0') {
+    in.error("parsing didn't consume all input");
+  }
+  return ret;
+}
+
+void parseJson(StringPiece range, json::event_handler& handler) {
+  parseJson(range, json::serialization_opts(), handler);
+}
+
+void parseJson(
+    StringPiece range,
+    json::serialization_opts const& opts,
+    json::event_handler& handler) {
+  json::Input in(range, &opts);
+
+  std::string scratch;
+  parseEvents(in, handler, scratch);
+  in.skipWhitespace();
+  if (in.size() && *in != '\0') {
+    in.error("parsing didn't consume all input");
+  }
+}
+
+dynamic parseJsonIndexed(StringPiece range) {
+  return parseJsonIndexed(range, json::serialization_opts());
+}
+
+dynamic parseJsonIndexed(
+    StringPiece range, json::serialization_opts const& opts) {
+  if (range.size() >= std::numeric_limits<uint32_t>::max()) {
+    return parseJson(range, opts);
+  }
+
+  std::vector<uint32_t> index;
+  json::detail::buildJsonStructuralIndex(range, index);
+
+  json::IndexedInput in(range, index, opts);
+  auto ret = parseIndexedValue(in, /* topLevel = */ true);
+  if (!in.done() && range[in.offset()] != '\0') {
+    in.error(in.offset(), "parsing didn't consume all input");
+  }
+  return ret;
+}
+
 std::string toJson(dynamic const& dyn) {
   return json::serialize(dyn, json::serialization_opts());
 }
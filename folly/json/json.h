@@ -151,7 +151,8 @@ std::array<uint64_t, 2> buildExtraAsciiToEscapeBitmap(StringPiece chars);
  *
  * Main JSON serialization routine taking folly::dynamic parameters.
  * For the most common use cases there are simpler functions in the
- * main folly namespace.
+ * main folly namespace. json_writer.h and json_iobuf_writer.h serialize into
+ * other buffers, such as an IOBufQueue.
  */
 std::string serialize(dynamic const&, serialization_opts const&);
 
@@ -199,6 +200,8 @@ struct parse_metadata {
 
 using metadata_map = std::unordered_map<dynamic const*, parse_metadata>;
 
+class event_handler;
+
 } // namespace json
 
 //////////////////////////////////////////////////////////////////////
@@ -210,6 +213,35 @@ using metadata_map = std::unordered_map<dynamic const*, parse_metadata>;
 dynamic parseJson(StringPiece, json::serialization_opts const&);
 dynamic parseJson(StringPiece);
 
+/**
+ * Like parseJson, but the arrays and objects of the result are allocated from
+ * arena, see dynamic_arena.h.
+ */
+dynamic parseJson(
+    StringPiece, json::serialization_opts const&, dynamic_arena& arena);
+
+/**
+ * Parse a json blob like parseJson, in two passes.
+ *
+ * The first pass uses SIMD to find the offsets of all quotes, brackets,
+ * braces, colons, commas and scalars in the input; the second builds the
+ * dynamic by walking those offsets, so it never looks at whitespace and copies
+ * strings without escapes in one go. This is considerably faster than
+ * parseJson on large documents, and produces the same result for the same
+ * input and options. Error messages may differ for malformed input.
+ */
+dynamic parseJsonIndexed(StringPiece, json::serialization_opts const&);
+dynamic parseJsonIndexed(StringPiece);
+
+/**
+ * Parse a json blob like parseJson, but report it to handler as a sequence of
+ * events (see json_events.h) instead of building a dynamic. Object keys must
+ * be strings, or integers with convert_int_keys.
+ */
+void parseJson(
+    StringPiece, json::serialization_opts const&, json::event_handler&);
+void parseJson(StringPiece, json::event_handler&);
+
 dynamic parseJsonWithMetadata(StringPiece range, json::metadata_map* map);
 dynamic parseJsonWithMetadata(
     StringPiece range,
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json_events.h>
+
+#include <glog/logging.h>
+
+#include <folly/json/json.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+namespace json {
+
+void dynamic_builder::on_begin_array() {
+  stack_.push_back({dynamic::array, nullptr});
+}
+
+void dynamic_builder::on_end_array() {
+  DCHECK(!stack_.empty() && stack_.back().value.isArray());
+  end();
+}
+
+void dynamic_builder::on_begin_object() {
+  stack_.push_back({dynamic::object, nullptr});
+}
+
+void dynamic_builder::on_key(StringPiece key) {
+  DCHECK(!stack_.empty() && stack_.back().value.isObject());
+  stack_.back().key = key;
+}
+
+void dynamic_builder::on_end_object() {
+  DCHECK(!stack_.empty() && stack_.back().value.isObject());
+  end();
+}
+
+void dynamic_builder::reset() {
+  stack_.clear();
+  result_ = nullptr;
+}
+
+void dynamic_builder::add(dynamic&& value) {
+  if (stack_.empty()) {
+    result_ = std::move(value);
+    return;
+  }
+  auto& top = stack_.back();
+  if (top.value.isArray()) {
+    top.value.push_back(std::move(value));
+  } else {
+    auto [it, inserted] =
+        top.value.try_emplace(std::move(top.key), std::move(value));
+    if (!inserted) {
+      if (distinctKeys_) {
+        throw_exception<parse_error>(
+            "json parse error: duplicate key inserted");
+      }
+      // Like parseJson, the last of several equal keys wins.
+      it->second = std::move(value);
+    }
+  }
+}
+
+void dynamic_builder::end() {
+  auto value = std::move(stack_.back().value);
+  stack_.pop_back();
+  add(std::move(value));
+}
+
+} // namespace json
+} // namespace folly
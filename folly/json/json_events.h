@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Event (SAX-style) interface to the json parsers.
+ *
+ * A parser reports a document as a sequence of calls on an event_handler,
+ * in document order. For `{"a": [1, "x"]}` these are:
+ *
+ *   on_begin_object()
+ *   on_key("a")
+ *   on_begin_array()
+ *   on_int(1)
+ *   on_string("x")
+ *   on_end_array()
+ *   on_end_object()
+ *
+ * Strings and keys are passed already unescaped. The StringPiece is only
+ * valid for the duration of the call.
+ *
+ * dynamic_builder is the event_handler that assembles the events into a
+ * dynamic, with the same result as parseJson().
+ *
+ * @file json_events.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/json/dynamic.h>
+
+namespace folly {
+namespace json {
+
+class event_handler {
+ public:
+  virtual ~event_handler() = default;
+
+  virtual void on_null() = 0;
+  virtual void on_bool(bool value) = 0;
+  virtual void on_int(std::int64_t value) = 0;
+  virtual void on_double(double value) = 0;
+  virtual void on_string(StringPiece value) = 0;
+
+  virtual void on_begin_array() = 0;
+  virtual void on_end_array() = 0;
+
+  virtual void on_begin_object() = 0;
+  // Followed by the events of the value of this key.
+  virtual void on_key(StringPiece key) = 0;
+  virtual void on_end_object() = 0;
+};
+
+class dynamic_builder : public event_handler {
+ public:
+  /**
+   * With distinctKeys, an object with a repeated key throws
+   * json::parse_error, as parseJson does with validate_keys. Otherwise the
+   * last of the repeated keys wins.
+   */
+  explicit dynamic_builder(bool distinctKeys = false)
+      : distinctKeys_(distinctKeys) {}
+
+  void on_null() override { add(nullptr); }
+  void on_bool(bool value) override { add(value); }
+  void on_int(std::int64_t value) override { add(value); }
+  void on_double(double value) override { add(value); }
+  void on_string(StringPiece value) override { add(value); }
+
+  void on_begin_array() override;
+  void on_end_array() override;
+  void on_begin_object() override;
+  void on_key(StringPiece key) override;
+  void on_end_object() override;
+
+  /**
+   * The value built so far. Complete once the parser reached the end of the
+   * document.
+   */
+  dynamic& result() { return result_; }
+
+  /**
+   * Forget the value built so far, to build another one.
+   */
+  void reset();
+
+ private:
+  struct frame {
+    dynamic value;
+    dynamic key;
+  };
+
+  void add(dynamic&& value);
+  void end();
+
+  bool distinctKeys_;
+  std::vector<frame> stack_;
+  dynamic result_;
+};
+
+} // namespace json
+} // namespace folly
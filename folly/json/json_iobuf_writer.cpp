@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json_iobuf_writer.h>
+
+#include <algorithm>
+
+namespace folly {
+namespace json {
+
+void iobuf_writer::flush() {
+  if (pos_ != begin_) {
+    queue_.postallocate(std::size_t(pos_ - begin_));
+  }
+  // The next write asks the queue for its tailroom again.
+  begin_ = pos_ = end_ = nullptr;
+}
+
+void iobuf_writer::grow(std::size_t n) {
+  flush();
+  auto [data, size] = queue_.preallocate(n, std::max(n, growth_));
+  begin_ = pos_ = static_cast<char*>(data);
+  end_ = pos_ + size;
+}
+
+void serialize(
+    dynamic const& dyn, serialization_opts const& opts, IOBufQueue& queue) {
+  iobuf_writer out(queue);
+  serialize(dyn, opts, out);
+}
+
+} // namespace json
+} // namespace folly
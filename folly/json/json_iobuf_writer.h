@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Serialize json straight into an IOBufQueue, e.g. the write queue of a
+ * socket, without building a std::string first:
+ *
+ *   folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+ *   folly::json::serialize(response, opts, queue);
+ *   transport->writeChain(callback, queue.move());
+ *
+ * @file json_iobuf_writer.h
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <folly/io/IOBufQueue.h>
+#include <folly/json/dynamic.h>
+#include <folly/json/json.h>
+#include <folly/json/json_writer.h>
+
+namespace folly {
+namespace json {
+
+/**
+ * A json::writer that writes into the tailroom of an IOBufQueue, allocating
+ * buffers of at least growth bytes when it runs out. The text is appended to
+ * the queue by flush() and by the destructor; in between, the queue must not
+ * be modified.
+ */
+class iobuf_writer : public writer {
+ public:
+  explicit iobuf_writer(IOBufQueue& queue, std::size_t growth = 4096)
+      : queue_(queue), growth_(growth) {}
+  ~iobuf_writer() { flush(); }
+
+  void flush();
+
+ private:
+  void grow(std::size_t n) override;
+
+  IOBufQueue& queue_;
+  std::size_t const growth_;
+  char* begin_{nullptr};
+};
+
+/**
+ * Append the serialization of dyn to the queue, in buffers sized from
+ * estimateSerializedSize(). If it throws, the queue holds the text written
+ * before the error.
+ */
+void serialize(
+    dynamic const& dyn, serialization_opts const& opts, IOBufQueue& queue);
+
+} // namespace json
+} // namespace folly
@@ -0,0 +1,637 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json_lazy_view.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/Unicode.h>
+#include <folly/json/detail/JsonStructuralIndex.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+namespace json {
+
+namespace {
+
+bool isJsonOp(char c) {
+  switch (c) {
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool isJsonWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Reads the 4 hex digits of a \u escape at p, or returns -1.
+int readHex4(char const* p, char const* end) {
+  if (end - p < 4) {
+    return -1;
+  }
+  int ret = 0;
+  for (int i = 0; i != 4; ++i) {
+    int v = hexValue(p[i]);
+    if (v < 0) {
+      return -1;
+    }
+    ret = ret * 16 + v;
+  }
+  return ret;
+}
+
+// Compares the contents of a json string literal, between the quotes, with
+// `str`, decoding escapes on the fly. Malformed escapes never compare equal.
+bool unescapedEquals(StringPiece raw, StringPiece str) {
+  auto s = str.begin();
+  auto matches = [&](StringPiece piece) {
+    if (size_t(str.end() - s) < piece.size() ||
+        !std::equal(piece.begin(), piece.end(), s)) {
+      return false;
+    }
+    s += piece.size();
+    return true;
+  };
+
+  char const* p = raw.begin();
+  char const* end = raw.end();
+  while (p != end) {
+    if (*p != '\\') {
+      auto run = std::find(p, end, '\\');
+      if (!matches(StringPiece(p, run))) {
+        return false;
+      }
+      p = run;
+      continue;
+    }
+    if (++p == end) {
+      return false;
+    }
+    char c;
+    switch (*p++) {
+      case '"':
+        c = '"';
+        break;
+      case '\\':
+        c = '\\';
+        break;
+      case '/':
+        c = '/';
+        break;
+      case 'b':
+        c = '\b';
+        break;
+      case 'f':
+        c = '\f';
+        break;
+      case 'n':
+        c = '\n';
+        break;
+      case 'r':
+        c = '\r';
+        break;
+      case 't':
+        c = '\t';
+        break;
+      case 'u': {
+        int cu = readHex4(p, end);
+        if (cu < 0) {
+          return false;
+        }
+        p += 4;
+        char32_t cp = char32_t(cu);
+        if (utf16_code_unit_is_high_surrogate(char16_t(cu))) {
+          if (end - p < 2 || p[0] != '\\' || p[1] != 'u') {
+            return false;
+          }
+          int low = readHex4(p + 2, end);
+          if (low < 0 || !utf16_code_unit_is_low_surrogate(char16_t(low))) {
+            return false;
+          }
+          p += 6;
+          cp = unicode_code_point_from_utf16_surrogate_pair(
+              char16_t(cu), char16_t(low));
+        } else if (utf16_code_unit_is_low_surrogate(char16_t(cu))) {
+          return false;
+        }
+        // At most 4 bytes, so this does not allocate.
+        if (!matches(codePointToUtf8(cp))) {
+          return false;
+        }
+        continue;
+      }
+      default:
+        return false;
+    }
+    if (!matches(StringPiece(&c, 1))) {
+      return false;
+    }
+  }
+  return s == str.end();
+}
+
+} // namespace
+
+lazy_document::lazy_document(StringPiece json)
+    : lazy_document(json, serialization_opts()) {}
+
+lazy_document::lazy_document(StringPiece json, serialization_opts const& opts)
+    : json_(json),
+      allowTrailingComma_(opts.allow_trailing_comma),
+      doubleFallback_(opts.double_fallback),
+      recursionLimit_(opts.recursion_limit) {
+  if (json_.size() > std::numeric_limits<std::uint32_t>::max()) {
+    throw_exception<parse_error>("json document too large for lazy_document");
+  }
+  detail::buildJsonStructuralIndex(json_, index_);
+  buildSkips();
+}
+
+lazy_view lazy_document::root() const {
+  return lazy_view(this, 0);
+}
+
+void lazy_document::error(std::uint32_t offset, char const* what) const {
+  auto line = std::count(json_.begin(), json_.begin() + offset, '\n');
+  auto context = json_.subpiece(offset, 16 /* arbitrary */);
+  throw_exception<parse_error>(to<std::string>(
+      "json parse error on line ",
+      line,
+      !context.empty() ? to<std::string>(" near `", context, '\'') : "",
+      ": ",
+      what));
+}
+
+// Validates the bracket/colon/comma structure of the document and records,
+// for every open bracket, where its value ends, and for every object, the
+// backward chain of its keys. Scalars are only checked to be in a value
+// position.
+void lazy_document::buildSkips() {
+  enum class Expect {
+    Value,
+    ValueOrClose, // just after '['
+    Key,
+    KeyOrClose, // just after '{'
+    Colon,
+    CommaOrClose,
+    End,
+  };
+
+  auto const n = std::uint32_t(index_.size());
+  skip_.assign(n, 0);
+
+  std::vector<std::uint32_t> stack;
+  // The last key seen in each object of the stack, 0 for none or for arrays.
+  std::vector<std::uint32_t> lastKey;
+  auto close = [&](std::uint32_t i) {
+    skip_[stack.back()] = i + 1;
+    skip_[i] = lastKey.back();
+    stack.pop_back();
+    lastKey.pop_back();
+  };
+  auto inObject = [&] { return json_[index_[stack.back()]] == '{'; };
+  auto afterValue = [&] {
+    return stack.empty() ? Expect::End : Expect::CommaOrClose;
+  };
+  auto offsetOf = [&](std::uint32_t i) {
+    return i < n ? index_[i] : std::uint32_t(json_.size());
+  };
+
+  Expect expect = Expect::Value;
+  std::uint32_t i = 0;
+  while (i < n) {
+    char c = json_[index_[i]];
+    switch (expect) {
+      case Expect::Value:
+      case Expect::ValueOrClose:
+        if (c == ']' && expect == Expect::ValueOrClose) {
+          close(i);
+          ++i;
+          expect = afterValue();
+          break;
+        }
+        if (stack.size() > recursionLimit_) {
+          error(index_[i], "recursion limit exceeded");
+        }
+        if (c == '[' || c == '{') {
+          stack.push_back(i);
+          lastKey.push_back(0);
+          ++i;
+          expect = c == '[' ? Expect::ValueOrClose : Expect::KeyOrClose;
+        } else if (c == '"') {
+          if (i + 1 == n) {
+            error(index_[i], "unterminated string");
+          }
+          i += 2;
+          expect = afterValue();
+        } else if (isJsonOp(c)) {
+          error(index_[i], "expected json value");
+        } else {
+          ++i;
+          expect = afterValue();
+        }
+        break;
+      case Expect::Key:
+      case Expect::KeyOrClose:
+        if (c == '}' && expect == Expect::KeyOrClose) {
+          close(i);
+          ++i;
+          expect = afterValue();
+        } else if (c == '"') {
+          if (i + 1 == n) {
+            error(index_[i], "unterminated string");
+          }
+          skip_[i] = lastKey.back();
+          lastKey.back() = i;
+          i += 2;
+          expect = Expect::Colon;
+        } else {
+          error(index_[i], "expected string for object key");
+        }
+        break;
+      case Expect::Colon:
+        if (c != ':') {
+          error(index_[i], "expected ':'");
+        }
+        ++i;
+        expect = Expect::Value;
+        break;
+      case Expect::CommaOrClose:
+        if (c == ',') {
+          ++i;
+          if (inObject()) {
+            expect = allowTrailingComma_ ? Expect::KeyOrClose : Expect::Key;
+          } else {
+            expect = allowTrailingComma_ ? Expect::ValueOrClose : Expect::Value;
+          }
+        } else if (c == (inObject() ? '}' : ']')) {
+          close(i);
+          ++i;
+          expect = afterValue();
+        } else {
+          error(
+              index_[i],
+              inObject() ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+        break;
+      case Expect::End:
+        // Like parseJson, allow trailing garbage after a NUL.
+        if (c != '\0') {
+          error(index_[i], "parsing didn't consume all input");
+        }
+        i = n;
+        break;
+    }
+  }
+
+  if (expect != Expect::End) {
+    error(offsetOf(i), "unexpected end of input");
+  }
+}
+
+dynamic::Type lazy_view::type() const {
+  switch (first()) {
+    case '{':
+      return dynamic::OBJECT;
+    case '[':
+      return dynamic::ARRAY;
+    case '"':
+      return dynamic::STRING;
+    default:
+      break;
+  }
+  auto token = scalarToken();
+  if (token == "true" || token == "false") {
+    return dynamic::BOOL;
+  }
+  if (token == "null") {
+    return dynamic::NULLT;
+  }
+  if (token == "NaN" || token == "Infinity" || token == "-Infinity") {
+    return dynamic::DOUBLE;
+  }
+  if (!token.empty() &&
+      (token[0] == '-' || (token[0] >= '0' && token[0] <= '9'))) {
+    if (token.find_first_of(".eE") != StringPiece::npos) {
+      return dynamic::DOUBLE;
+    }
+    if (doc_->doubleFallback_ && !tryTo<std::int64_t>(token).hasValue() &&
+        tryTo<double>(token).hasValue()) {
+      return dynamic::DOUBLE;
+    }
+    return dynamic::INT64;
+  }
+  doc_->error(doc_->index_[pos_], "expected json value");
+}
+
+StringPiece lazy_view::scalarToken() const {
+  auto const& json = doc_->json_;
+  auto begin = json.begin() + doc_->index_[pos_];
+  auto end = std::find_if(begin, json.end(), [](char c) {
+    return c == '\0' || c == '"' || isJsonOp(c) || isJsonWhitespace(c);
+  });
+  return StringPiece(begin, end);
+}
+
+StringPiece lazy_view::rawString() const {
+  auto const& json = doc_->json_;
+  return StringPiece(
+      json.begin() + doc_->index_[pos_] + 1,
+      json.begin() + doc_->index_[pos_ + 1]);
+}
+
+std::uint32_t lazy_view::next() const {
+  switch (first()) {
+    case '{':
+    case '[':
+      return doc_->skip_[pos_];
+    case '"':
+      return pos_ + 2;
+    default:
+      return pos_ + 1;
+  }
+}
+
+StringPiece lazy_view::raw() const {
+  auto const& json = doc_->json_;
+  auto begin = json.begin() + doc_->index_[pos_];
+  switch (first()) {
+    case '{':
+    case '[':
+    case '"':
+      return StringPiece(begin, json.begin() + doc_->index_[next() - 1] + 1);
+    default:
+      return scalarToken();
+  }
+}
+
+void lazy_view::requireType(dynamic::Type t, char const* expected) const {
+  auto actual = type();
+  if (actual != t) {
+    throw_exception<TypeError>(expected, actual);
+  }
+}
+
+bool lazy_view::getBool() const {
+  requireType(dynamic::BOOL, "bool");
+  return first() == 't';
+}
+
+std::int64_t lazy_view::getInt() const {
+  requireType(dynamic::INT64, "int64");
+  auto ret = tryTo<std::int64_t>(scalarToken());
+  if (!ret) {
+    doc_->error(doc_->index_[pos_], "invalid number");
+  }
+  return *ret;
+}
+
+double lazy_view::getDouble() const {
+  requireType(dynamic::DOUBLE, "double");
+  auto token = scalarToken();
+  if (token == "NaN") {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  if (token == "Infinity") {
+    return std::numeric_limits<double>::infinity();
+  }
+  if (token == "-Infinity") {
+    return -std::numeric_limits<double>::infinity();
+  }
+  auto ret = tryTo<double>(token);
+  if (!ret) {
+    doc_->error(doc_->index_[pos_], "invalid number");
+  }
+  return *ret;
+}
+
+std::string lazy_view::getString() const {
+  requireType(dynamic::STRING, "string");
+  auto str = rawString();
+  if (str.find('\\') == StringPiece::npos &&
+      str.find('\0') == StringPiece::npos) {
+    return str.str();
+  }
+  // Escaped strings go through the regular parser, which also reports
+  // malformed escapes.
+  return std::move(parseJson(raw()).getString());
+}
+
+bool lazy_view::asBool() const {
+  return toDynamic().asBool();
+}
+
+std::int64_t lazy_view::asInt() const {
+  return toDynamic().asInt();
+}
+
+double lazy_view::asDouble() const {
+  return toDynamic().asDouble();
+}
+
+std::string lazy_view::asString() const {
+  return toDynamic().asString();
+}
+
+bool lazy_view::stringEquals(StringPiece str) const {
+  requireType(dynamic::STRING, "string");
+  auto raw = rawString();
+  if (raw.find('\\') == StringPiece::npos) {
+    return raw == str;
+  }
+  return unescapedEquals(raw, str);
+}
+
+std::size_t lazy_view::size() const {
+  switch (first()) {
+    case '[':
+      return std::size_t(std::distance(begin(), end()));
+    case '{':
+      return std::size_t(std::distance(items().begin(), items().end()));
+    default:
+      throw_exception<TypeError>("array/object", type());
+  }
+}
+
+bool lazy_view::empty() const {
+  switch (first()) {
+    case '[':
+      return begin() == end();
+    case '{':
+      return items().empty();
+    default:
+      throw_exception<TypeError>("array/object", type());
+  }
+}
+
+Optional<lazy_view> lazy_view::get_ptr(StringPiece key) const {
+  if (first() != '{') {
+    throw_exception<TypeError>("object", type());
+  }
+  // Walk the keys from the last one, so that the last of several equal keys
+  // wins, as in parseJson().
+  auto const& skip = doc_->skip_;
+  for (auto k = skip[skip[pos_] - 1]; k != 0; k = skip[k]) {
+    if (lazy_view(doc_, k).stringEquals(key)) {
+      // The key is an open/close quote pair followed by a colon.
+      return lazy_view(doc_, k + 3);
+    }
+  }
+  return none;
+}
+
+Optional<lazy_view> lazy_view::get_ptr(std::size_t idx) const {
+  if (first() != '[') {
+    throw_exception<TypeError>("array", type());
+  }
+  for (auto it = begin(); it != end(); ++it, --idx) {
+    if (idx == 0) {
+      return *it;
+    }
+  }
+  return none;
+}
+
+lazy_view lazy_view::at(StringPiece key) const {
+  auto ret = get_ptr(key);
+  if (!ret) {
+    throw_exception<std::out_of_range>(
+        sformat("couldn't find key {} in dynamic object", key));
+  }
+  return *ret;
+}
+
+lazy_view lazy_view::at(std::size_t idx) const {
+  auto ret = get_ptr(idx);
+  if (!ret) {
+    throw_exception<std::out_of_range>("out of range in dynamic array");
+  }
+  return *ret;
+}
+
+Optional<lazy_view> lazy_view::get_ptr(json_pointer const& jsonPtr) const {
+  lazy_view curr = *this;
+  for (auto const& token : jsonPtr.tokens()) {
+    switch (curr.first()) {
+      case '[': {
+        if (token.size() > 1 && token[0] == '0') {
+          throw_exception<std::invalid_argument>(
+              "leading zero not allowed when indexing arrays");
+        }
+        // Appending, or resolving past an append, finds nothing.
+        if (token == "-") {
+          return none;
+        }
+        auto idx = tryTo<std::size_t>(token);
+        if (!idx) {
+          throw_exception<std::invalid_argument>("array index is not numeric");
+        }
+        auto next = curr.get_ptr(*idx);
+        if (!next) {
+          return none;
+        }
+        curr = *next;
+        break;
+      }
+      case '{': {
+        auto next = curr.get_ptr(StringPiece(token));
+        if (!next) {
+          return none;
+        }
+        curr = *next;
+        break;
+      }
+      default:
+        throw_exception<TypeError>("object/array", curr.type());
+    }
+  }
+  return curr;
+}
+
+lazy_view::array_iterator lazy_view::begin() const {
+  if (first() != '[') {
+    throw_exception<TypeError>("array", type());
+  }
+  return array_iterator(doc_, pos_ + 1);
+}
+
+lazy_view::array_iterator lazy_view::end() const {
+  if (first() != '[') {
+    throw_exception<TypeError>("array", type());
+  }
+  return array_iterator(doc_, next() - 1);
+}
+
+Range<lazy_view::object_iterator> lazy_view::items() const {
+  if (first() != '{') {
+    throw_exception<TypeError>("object", type());
+  }
+  return Range<object_iterator>(
+      object_iterator(doc_, pos_ + 1), object_iterator(doc_, next() - 1));
+}
+
+dynamic lazy_view::toDynamic() const {
+  serialization_opts opts;
+  opts.allow_trailing_comma = doc_->allowTrailingComma_;
+  opts.double_fallback = doc_->doubleFallback_;
+  opts.recursion_limit = doc_->recursionLimit_;
+  return parseJson(raw(), opts);
+}
+
+lazy_view::array_iterator& lazy_view::array_iterator::operator++() {
+  pos_ = lazy_view(doc_, pos_).next();
+  // Step over the comma; the closing bracket is the end position.
+  if (doc_->json_[doc_->index_[pos_]] == ',') {
+    ++pos_;
+  }
+  return *this;
+}
+
+lazy_view::object_iterator& lazy_view::object_iterator::operator++() {
+  pos_ = lazy_view(doc_, pos_ + 3).next();
+  if (doc_->json_[doc_->index_[pos_]] == ',') {
+    ++pos_;
+  }
+  return *this;
+}
+
+} // namespace json
+} // namespace folly
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Read parts of a json document without materializing it as a dynamic.
+ *
+ *   folly::json::lazy_document doc(payload);
+ *   auto user = doc.root().at("user");
+ *   int64_t id = user.at("id").asInt();
+ *   if (auto name = doc.root().get_ptr(json_pointer::parse("/user/name"))) {
+ *     use(name->getString());
+ *   }
+ *
+ * lazy_document builds the structural index of the document (see
+ * detail/JsonStructuralIndex.h) and checks that the brackets, colons and
+ * commas are well formed. Strings and numbers are only decoded when they are
+ * read, and only the values that are read are decoded, so reading a few
+ * fields of a large payload costs a fraction of parseJson().
+ *
+ * Lookups by key or json_pointer do not allocate. Objects are searched
+ * linearly, from the last key backwards; like parseJson(), the last of several
+ * equal keys wins.
+ *
+ * The document text is not copied: it must outlive the lazy_document, and
+ * the lazy_document must outlive every lazy_view obtained from it.
+ *
+ * @file json_lazy_view.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/json/dynamic.h>
+#include <folly/json/json.h>
+#include <folly/json/json_pointer.h>
+
+namespace folly {
+namespace json {
+
+class lazy_view;
+
+class lazy_document {
+ public:
+  /**
+   * Index `json`. Throws json::parse_error if the structure of the document
+   * is malformed; errors inside strings and numbers are reported when those
+   * values are read.
+   *
+   * Of the serialization_opts, allow_trailing_comma, recursion_limit and
+   * double_fallback are honored. Object keys must be strings.
+   */
+  explicit lazy_document(StringPiece json);
+  lazy_document(StringPiece json, serialization_opts const& opts);
+
+  lazy_document(lazy_document const&) = delete;
+  lazy_document& operator=(lazy_document const&) = delete;
+
+  lazy_view root() const;
+
+  StringPiece data() const { return json_; }
+
+ private:
+  friend class lazy_view;
+
+  void buildSkips();
+  [[noreturn]] void error(std::uint32_t offset, char const* what) const;
+
+  StringPiece json_;
+  // Offsets of the structural characters of json_.
+  std::vector<std::uint32_t> index_;
+  // For each entry of index_ that opens an array or object, the entry just
+  // past its closing bracket. For each object key, the entry of the previous
+  // key of the object, and for each closing bracket, the entry of the last
+  // key of the object; 0 when there is none.
+  std::vector<std::uint32_t> skip_;
+
+  bool allowTrailingComma_{false};
+  bool doubleFallback_{false};
+  unsigned recursionLimit_{100};
+};
+
+/**
+ * A cheap, copyable handle to one value of a lazy_document.
+ *
+ * The accessors mirror the read-only API of dynamic and throw the same
+ * exceptions: TypeError when the value has a different type,
+ * std::out_of_range for missing keys or indices.
+ */
+class lazy_view {
+ public:
+  class array_iterator;
+  class object_iterator;
+
+  dynamic::Type type() const;
+
+  bool isNull() const { return type() == dynamic::NULLT; }
+  bool isBool() const { return type() == dynamic::BOOL; }
+  bool isInt() const { return type() == dynamic::INT64; }
+  bool isDouble() const { return type() == dynamic::DOUBLE; }
+  bool isNumber() const { return isInt() || isDouble(); }
+  bool isString() const { return type() == dynamic::STRING; }
+  bool isArray() const { return type() == dynamic::ARRAY; }
+  bool isObject() const { return type() == dynamic::OBJECT; }
+
+  /**
+   * The json text of this value, e.g. `{"a": [1, 2]}` or `"x\ny"`.
+   */
+  StringPiece raw() const;
+
+  /**
+   * Scalar accessors. The get* versions require the exact type; the as*
+   * versions convert like their dynamic counterparts.
+   */
+  bool getBool() const;
+  std::int64_t getInt() const;
+  double getDouble() const;
+  std::string getString() const;
+
+  bool asBool() const;
+  std::int64_t asInt() const;
+  double asDouble() const;
+  std::string asString() const;
+
+  /**
+   * For strings: whether the decoded string equals `str`, without
+   * decoding it.
+   */
+  bool stringEquals(StringPiece str) const;
+
+  /**
+   * Number of elements of an array or of items of an object. Linear in the
+   * number of elements.
+   */
+  std::size_t size() const;
+  bool empty() const;
+
+  /**
+   * Element lookup. get_ptr returns none on misses, at throws
+   * std::out_of_range. Of several equal keys, the last one is found, as in
+   * parseJson().
+   */
+  Optional<lazy_view> get_ptr(StringPiece key) const;
+  Optional<lazy_view> get_ptr(std::size_t idx) const;
+  lazy_view at(StringPiece key) const;
+  lazy_view at(std::size_t idx) const;
+  std::size_t count(StringPiece key) const { return get_ptr(key) ? 1 : 0; }
+
+  /**
+   * Resolve a json_pointer relative to this value, with the same
+   * semantics as dynamic::get_ptr(json_pointer const&).
+   */
+  Optional<lazy_view> get_ptr(json_pointer const& jsonPtr) const;
+
+  /**
+   * Array elements.
+   */
+  array_iterator begin() const;
+  array_iterator end() const;
+
+  /**
+   * Object items, as pairs of (key, value) views.
+   */
+  Range<object_iterator> items() const;
+
+  /**
+   * Parse this value, and everything below it, into a dynamic.
+   */
+  dynamic toDynamic() const;
+
+ private:
+  friend class lazy_document;
+
+  lazy_view(lazy_document const* doc, std::uint32_t pos)
+      : doc_(doc), pos_(pos) {}
+
+  char first() const { return doc_->json_[doc_->index_[pos_]]; }
+  std::uint32_t next() const;
+  StringPiece scalarToken() const;
+  StringPiece rawString() const;
+  void requireType(dynamic::Type t, char const* expected) const;
+
+  lazy_document const* doc_;
+  // Position in doc_->index_ of the first structural of this value.
+  std::uint32_t pos_;
+};
+
+class lazy_view::array_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = lazy_view;
+  using difference_type = std::ptrdiff_t;
+  using pointer = lazy_view const*;
+  using reference = lazy_view;
+
+  lazy_view operator*() const { return {doc_, pos_}; }
+
+  array_iterator& operator++();
+  array_iterator operator++(int) {
+    auto ret = *this;
+    ++*this;
+    return ret;
+  }
+
+  friend bool operator==(array_iterator const& a, array_iterator const& b) {
+    return a.pos_ == b.pos_;
+  }
+  friend bool operator!=(array_iterator const& a, array_iterator const& b) {
+    return !(a == b);
+  }
+
+ private:
+  friend class lazy_view;
+
+  array_iterator(lazy_document const* doc, std::uint32_t pos)
+      : doc_(doc), pos_(pos) {}
+
+  lazy_document const* doc_;
+  std::uint32_t pos_;
+};
+
+class lazy_view::object_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::pair<lazy_view, lazy_view>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = value_type const*;
+  using reference = value_type;
+
+  value_type operator*() const {
+    // The key is an open/close quote pair followed by a colon.
+    return {lazy_view(doc_, pos_), lazy_view(doc_, pos_ + 3)};
+  }
+
+  object_iterator& operator++();
+  object_iterator operator++(int) {
+    auto ret = *this;
+    ++*this;
+    return ret;
+  }
+
+  friend bool operator==(object_iterator const& a, object_iterator const& b) {
+    return a.pos_ == b.pos_;
+  }
+  friend bool operator!=(object_iterator const& a, object_iterator const& b) {
+    return !(a == b);
+  }
+
+ private:
+  friend class lazy_view;
+
+  object_iterator(lazy_document const* doc, std::uint32_t pos)
+      : doc_(doc), pos_(pos) {}
+
+  lazy_document const* doc_;
+  std::uint32_t pos_;
+};
+
+} // namespace json
+} // namespace folly
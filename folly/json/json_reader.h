@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Pull interface to the json parser.
+ *
+ * A json::reader walks a document one value at a time, letting the caller
+ * decide how to consume each one: as a dynamic, as a string, or by stepping
+ * into it if it is an array or an object. This is what JsonConverter.h uses to
+ * decode json text straight into C++ types.
+ *
+ *   json::reader r(R"({"a": [1, 2], "b": "x"})");
+ *   r.beginObject();
+ *   StringPiece key;
+ *   while (r.nextKey(key)) {
+ *     if (key == "a") {
+ *       r.beginArray();
+ *       while (r.nextElement()) {
+ *         use(r.readValue().asInt());
+ *       }
+ *     } else {
+ *       r.skipValue();
+ *     }
+ *   }
+ *   r.finish();
+ *
+ * The grammar, the options and the errors are those of parseJson: the same
+ * input gives the same values, or throws json::parse_error with the same
+ * message. Object keys must be strings, or integers with convert_int_keys.
+ *
+ * @file json_reader.h
+ */
+
+#pragma once
+
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/json/dynamic.h>
+#include <folly/json/json.h>
+
+namespace folly {
+namespace json {
+
+class reader {
+ public:
+  explicit reader(StringPiece range);
+  // opts must outlive the reader.
+  reader(StringPiece range, serialization_opts const& opts);
+
+  reader(reader const&) = delete;
+  reader& operator=(reader const&) = delete;
+
+  /**
+   * The first character of the next value: '[', '{', '"', or the first
+   * character of a number or literal ('n' for null).
+   */
+  char peek();
+
+  /**
+   * Parse the next value, whatever it is, like parseJson would.
+   */
+  dynamic readValue();
+
+  /**
+   * Parse the next value, which must be a string. The StringPiece is only
+   * valid until the next call on the reader.
+   */
+  std::string readString();
+  StringPiece readStringPiece();
+
+  /**
+   * Skip the next value without building it.
+   */
+  void skipValue();
+
+  /**
+   * Step into the next value, which must be an array, and iterate over its
+   * elements: each call to nextElement() that returns true must be followed
+   * by reading or skipping one value.
+   */
+  void beginArray();
+  bool nextElement();
+
+  /**
+   * Step into the next value, which must be an object, and iterate over its
+   * members: each call to nextKey() that returns true sets key (valid until
+   * the next call on the reader) and must be followed by reading or skipping
+   * its value.
+   */
+  void beginObject();
+  bool nextKey(StringPiece& key);
+
+  /**
+   * Check that nothing but whitespace follows the document.
+   */
+  void finish();
+
+  serialization_opts const& opts() const { return opts_; }
+
+  /**
+   * Throw a json::parse_error at the current position.
+   */
+  [[noreturn]] void error(char const* what) const;
+
+ private:
+  friend struct reader_input;
+
+  StringPiece range_;
+  serialization_opts const& opts_;
+  unsigned lineNum_{0};
+  unsigned recursionLevel_{0};
+  // Set by beginArray/beginObject until the first nextElement/nextKey.
+  bool first_{false};
+  std::string scratch_;
+};
+
+} // namespace json
+} // namespace folly
@@ -0,0 +1,532 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json_stream_parser.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+#include <folly/Conv.h>
+#include <folly/Unicode.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+namespace json {
+
+namespace {
+
+bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isScalarEnd(char c) {
+  switch (c) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+    case '"':
+    case '\0':
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+} // namespace
+
+stream_parser::stream_parser(event_handler& handler)
+    : stream_parser(handler, serialization_opts()) {}
+
+stream_parser::stream_parser(
+    event_handler& handler, serialization_opts const& opts)
+    : handler_(handler),
+      allowTrailingComma_(opts.allow_trailing_comma),
+      doubleFallback_(opts.double_fallback),
+      convertIntKeys_(opts.convert_int_keys),
+      numbersAsStrings_(opts.parse_numbers_as_strings),
+      recursionLimit_(opts.recursion_limit) {
+  if (opts.allow_non_string_keys) {
+    // Events only carry string keys.
+    throw_exception<std::invalid_argument>(
+        "json::stream_parser does not support allow_non_string_keys");
+  }
+}
+
+void stream_parser::feed(StringPiece fragment) {
+  if (ignoreRest_) {
+    return;
+  }
+  char const* p = fragment.begin();
+  char const* end = fragment.end();
+  fragmentEnd_ = end;
+  // A token left open by the previous fragment continues here.
+  tokenBegin_ = p;
+  while (p != end) {
+    switch (state_) {
+      case state::string:
+        p = continueString(p, end);
+        break;
+      case state::scalar:
+        p = continueScalar(p, end);
+        break;
+      default:
+        p = structural(p, end);
+        break;
+    }
+  }
+}
+
+void stream_parser::feed(IOBuf const& chain) {
+  for (auto buf : chain) {
+    feed(buf);
+  }
+}
+
+void stream_parser::feed(io::Cursor cursor) {
+  while (!cursor.isAtEnd()) {
+    auto bytes = cursor.peekBytes();
+    feed(bytes);
+    cursor.skip(bytes.size());
+  }
+}
+
+void stream_parser::finish() {
+  fragmentEnd_ = nullptr;
+  if (state_ == state::scalar) {
+    endScalar(token_);
+    token_.clear();
+  }
+  if (state_ == state::string) {
+    error(nullptr, "unterminated string");
+  }
+  if (state_ != state::done) {
+    error(nullptr, "unexpected end of input");
+  }
+}
+
+void stream_parser::reset() {
+  state_ = state::value;
+  stack_.clear();
+  token_.clear();
+  inKey_ = false;
+  escapePending_ = false;
+  hasEscape_ = false;
+  ignoreRest_ = false;
+  lineNum_ = 0;
+}
+
+char const* stream_parser::structural(char const* p, char const* end) {
+  for (; p != end && isWhitespace(*p); ++p) {
+    lineNum_ += *p == '\n';
+  }
+  if (p == end) {
+    return p;
+  }
+
+  char c = *p;
+  switch (state_) {
+    case state::value:
+    case state::value_or_end:
+      if (c == ']' && state_ == state::value_or_end) {
+        endContainer(c);
+        return p + 1;
+      }
+      return beginValue(p);
+    case state::key:
+    case state::key_or_end:
+      if (c == '}' && state_ == state::key_or_end) {
+        endContainer(c);
+        return p + 1;
+      }
+      inKey_ = true;
+      if (c != '"') {
+        // Numbers are keys with convert_int_keys, as integers, and with
+        // parse_numbers_as_strings.
+        if (!(convertIntKeys_ || numbersAsStrings_) || isScalarEnd(c)) {
+          nonStringKey(p);
+        }
+        state_ = state::scalar;
+        tokenBegin_ = p;
+        return p;
+      }
+      state_ = state::string;
+      tokenBegin_ = p + 1;
+      return p + 1;
+    case state::colon:
+      if (c != ':') {
+        error(p, "expected ':'");
+      }
+      state_ = state::value;
+      return p + 1;
+    case state::comma_or_end:
+      if (c == ',') {
+        if (stack_.back() == '{') {
+          state_ = allowTrailingComma_ ? state::key_or_end : state::key;
+        } else {
+          state_ = allowTrailingComma_ ? state::value_or_end : state::value;
+        }
+        return p + 1;
+      }
+      if (c != (stack_.back() == '{' ? '}' : ']')) {
+        error(
+            p,
+            stack_.back() == '{' ? "expected ',' or '}'"
+                                 : "expected ',' or ']'");
+      }
+      endContainer(c);
+      return p + 1;
+    case state::done:
+      // Like parseJson, ignore anything after a null byte that follows the
+      // document.
+      if (c != '\0') {
+        error(p, "parsing didn't consume all input");
+      }
+      ignoreRest_ = true;
+      return end;
+    case state::string:
+    case state::scalar:
+      break;
+  }
+  return p;
+}
+
+char const* stream_parser::beginValue(char const* p) {
+  if (stack_.size() > recursionLimit_) {
+    error(p, "recursion limit exceeded");
+  }
+  switch (*p) {
+    case '[':
+      stack_.push_back('[');
+      state_ = state::value_or_end;
+      handler_.on_begin_array();
+      return p + 1;
+    case '{':
+      stack_.push_back('{');
+      state_ = state::key_or_end;
+      handler_.on_begin_object();
+      return p + 1;
+    case '"':
+      state_ = state::string;
+      inKey_ = false;
+      tokenBegin_ = p + 1;
+      return p + 1;
+    case '}':
+    case ']':
+    case ':':
+    case ',':
+    case '\0':
+      error(p, "expected json value");
+    default:
+      state_ = state::scalar;
+      inKey_ = false;
+      tokenBegin_ = p;
+      return p;
+  }
+}
+
+char const* stream_parser::continueString(char const* p, char const* end) {
+  for (;;) {
+    if (escapePending_) {
+      if (p == end) {
+        break;
+      }
+      escapePending_ = false;
+      ++p;
+      continue;
+    }
+    auto q = std::find_if(
+        p, end, [](char c) { return c == '"' || c == '\\' || c == '\0'; });
+    if (q == end) {
+      break;
+    }
+    if (*q == '\0') {
+      // Unlike parseJson, which lets them through.
+      error(q, "null byte in string");
+    }
+    if (*q == '\\') {
+      hasEscape_ = true;
+      escapePending_ = true;
+      p = q + 1;
+      continue;
+    }
+    if (token_.empty()) {
+      endString(q, StringPiece(tokenBegin_, q));
+    } else {
+      token_.append(tokenBegin_, q);
+      endString(q, token_);
+    }
+    return q + 1;
+  }
+  token_.append(tokenBegin_, end);
+  return end;
+}
+
+char const* stream_parser::continueScalar(char const* p, char const* end) {
+  auto q = std::find_if(p, end, isScalarEnd);
+  if (q == end) {
+    token_.append(tokenBegin_, end);
+    return end;
+  }
+  if (token_.empty()) {
+    endScalar(StringPiece(tokenBegin_, q));
+  } else {
+    token_.append(tokenBegin_, q);
+    endScalar(token_);
+    token_.clear();
+  }
+  return q;
+}
+
+void stream_parser::endString(char const* p, StringPiece raw) {
+  StringPiece value = raw;
+  if (hasEscape_) {
+    scratch_.clear();
+    unescape(p, raw, scratch_);
+    value = scratch_;
+    hasEscape_ = false;
+  }
+  if (inKey_) {
+    state_ = state::colon;
+    handler_.on_key(value);
+  } else {
+    endValue();
+    handler_.on_string(value);
+  }
+  token_.clear();
+}
+
+void stream_parser::endScalar(StringPiece token) {
+  // Set the state first: the token may be the document's last one.
+  bool const key = inKey_;
+  if (key) {
+    state_ = state::colon;
+  } else {
+    endValue();
+  }
+  auto const onString = [&](StringPiece value) {
+    key ? handler_.on_key(value) : handler_.on_string(value);
+  };
+  auto const onDouble = [&](double value) {
+    key ? nonStringKey(nullptr) : handler_.on_double(value);
+  };
+
+  if (token == "true" || token == "false") {
+    key ? nonStringKey(nullptr) : handler_.on_bool(token == "true");
+    return;
+  }
+  if (token == "null") {
+    key ? nonStringKey(nullptr) : handler_.on_null();
+    return;
+  }
+  // Accepted whether or not allow_nan_inf is set, as parseJson does: the
+  // option only applies to serialization.
+  if (token == "NaN" || token == "Infinity" || token == "-Infinity") {
+    if (numbersAsStrings_) {
+      onString(token);
+    } else if (token == "NaN") {
+      onDouble(std::numeric_limits<double>::quiet_NaN());
+    } else {
+      auto const inf = std::numeric_limits<double>::infinity();
+      onDouble(token == "Infinity" ? inf : -inf);
+    }
+    return;
+  }
+
+  bool const negative = token[0] == '-';
+  auto p = std::find_if_not(token.begin() + negative, token.end(), isDigit);
+  if (p == token.begin() + negative) {
+    error(
+        nullptr,
+        negative ? "expected digits after `-'" : "expected json value");
+  }
+  bool const integer = p == token.end();
+  // The grammar of parseJson: digits, then an optional fraction and
+  // exponent, whose digits may be missing.
+  if (p != token.end() && *p == '.') {
+    p = std::find_if_not(p + 1, token.end(), isDigit);
+  }
+  if (p != token.end() && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p != token.end() && (*p == '+' || *p == '-')) {
+      ++p;
+    }
+    p = std::find_if_not(p, token.end(), isDigit);
+  }
+  if (p != token.end()) {
+    error(nullptr, "invalid number");
+  }
+
+  if (numbersAsStrings_) {
+    onString(token);
+    return;
+  }
+  if (integer) {
+    if (auto val = tryTo<std::int64_t>(token)) {
+      if (!key) {
+        handler_.on_int(*val);
+      } else if (convertIntKeys_) {
+        handler_.on_key(to<std::string>(*val));
+      } else {
+        nonStringKey(nullptr);
+      }
+      return;
+    }
+    if (!doubleFallback_) {
+      error(nullptr, "integer out of range");
+    }
+  }
+  auto val = tryTo<double>(token);
+  if (!val) {
+    error(nullptr, "invalid number");
+  }
+  onDouble(*val);
+}
+
+void stream_parser::endValue() {
+  state_ = stack_.empty() ? state::done : state::comma_or_end;
+}
+
+void stream_parser::endContainer(char c) {
+  DCHECK_EQ(c == '}' ? '{' : '[', stack_.back());
+  stack_.pop_back();
+  endValue();
+  if (c == '}') {
+    handler_.on_end_object();
+  } else {
+    handler_.on_end_array();
+  }
+}
+
+void stream_parser::unescape(
+    char const* p, StringPiece raw, std::string& out) const {
+  auto readHex = [&](char const*& in) {
+    if (raw.end() - in < 4) {
+      error(p, "expected 4 hex digits");
+    }
+    std::uint16_t ret = 0;
+    for (int i = 0; i != 4; ++i) {
+      char c = *in++;
+      // clang-format off
+      ret = std::uint16_t(ret * 16 + (
+          c >= '0' && c <= '9' ? c - '0' :
+          c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+          c >= 'A' && c <= 'F' ? c - 'A' + 10 :
+          (error(p, "invalid hex digit"), 0)));
+      // clang-format on
+    }
+    return ret;
+  };
+
+  out.reserve(raw.size());
+  char const* in = raw.begin();
+  while (in != raw.end()) {
+    auto run = std::find(in, raw.end(), '\\');
+    out.append(in, run);
+    if (run == raw.end()) {
+      break;
+    }
+    in = run + 1;
+    // The escaped character is always in the token: a string cannot end on
+    // a backslash.
+    switch (*in++) {
+        // clang-format off
+      case '\"': out.push_back('\"'); break;
+      case '\\': out.push_back('\\'); break;
+      case '/':  out.push_back('/');  break;
+      case 'b':  out.push_back('\b'); break;
+      case 'f':  out.push_back('\f'); break;
+      case 'n':  out.push_back('\n'); break;
+      case 'r':  out.push_back('\r'); break;
+      case 't':  out.push_back('\t'); break;
+      // clang-format on
+      case 'u': {
+        std::uint16_t prefix = readHex(in);
+        char32_t codePoint = prefix;
+        if (utf16_code_unit_is_high_surrogate(prefix)) {
+          if (raw.end() - in < 2 || in[0] != '\\' || in[1] != 'u') {
+            error(
+                p,
+                "expected another unicode escape for second half of "
+                "surrogate pair");
+          }
+          in += 2;
+          std::uint16_t suffix = readHex(in);
+          if (!utf16_code_unit_is_low_surrogate(suffix)) {
+            error(p, "second character in surrogate pair is invalid");
+          }
+          codePoint =
+              unicode_code_point_from_utf16_surrogate_pair(prefix, suffix);
+        } else if (!utf16_code_unit_is_bmp(prefix)) {
+          error(p, "invalid unicode code point (in range [0xdc00,0xdfff])");
+        }
+        appendCodePointToUtf8(codePoint, out);
+        break;
+      }
+      default:
+        error(p, "unknown escape in string");
+    }
+  }
+}
+
+void stream_parser::nonStringKey(char const* p) const {
+  error(
+      p,
+      convertIntKeys_ ? "expected string or integer for object key"
+                      : "expected string for object key");
+}
+
+void stream_parser::error(char const* p, char const* what) const {
+  StringPiece context;
+  if (p && fragmentEnd_) {
+    context = StringPiece(p, std::min(p + 16 /* arbitrary */, fragmentEnd_));
+  }
+  throw_exception<parse_error>(to<std::string>(
+      "json parse error on line ",
+      lineNum_,
+      !context.empty() ? to<std::string>(" near `", context, '\'') : "",
+      ": ",
+      what));
+}
+
+} // namespace json
+
+dynamic parseJson(IOBuf const& chain) {
+  return parseJson(chain, json::serialization_opts());
+}
+
+dynamic parseJson(IOBuf const& chain, json::serialization_opts const& opts) {
+  json::dynamic_builder builder(opts.validate_keys || opts.convert_int_keys);
+  json::stream_parser parser(builder, opts);
+  parser.feed(chain);
+  parser.finish();
+  return std::move(builder.result());
+}
+
+} // namespace folly
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Incremental (push) json parser.
+ *
+ * The document is fed in fragments of any size, e.g. the buffers of an IOBuf
+ * chain as they come off a socket, and is reported to an event_handler (see
+ * json_events.h) as soon as each token is complete:
+ *
+ *   folly::json::dynamic_builder builder;
+ *   folly::json::stream_parser parser(builder);
+ *   parser.feed(*firstChunk);
+ *   parser.feed(*secondChunk);
+ *   parser.finish();
+ *   use(builder.result());
+ *
+ * Between fragments the parser only keeps the container nesting and the
+ * partial token that straddles the fragment boundary, if any. Tokens that lie
+ * within a fragment are handed to the handler without being copied.
+ *
+ * The serialization_opts that apply to parsing are honored as by parseJson,
+ * except allow_non_string_keys, which events cannot represent: the
+ * constructor throws std::invalid_argument if it is set. Integer keys are
+ * reported as strings with convert_int_keys. Distinct keys, as checked with
+ * validate_keys and convert_int_keys, are up to the handler; dynamic_builder
+ * can check them.
+ *
+ * Unlike parseJson, a null byte inside a string is rejected, escaped or not.
+ *
+ * Errors throw json::parse_error, from the call that fed the offending byte.
+ *
+ * @file json_stream_parser.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/json/json.h>
+#include <folly/json/json_events.h>
+
+namespace folly {
+namespace json {
+
+class stream_parser {
+ public:
+  explicit stream_parser(event_handler& handler);
+  stream_parser(event_handler& handler, serialization_opts const& opts);
+
+  stream_parser(stream_parser const&) = delete;
+  stream_parser& operator=(stream_parser const&) = delete;
+
+  /**
+   * Parse the next fragment of the document.
+   */
+  void feed(StringPiece fragment);
+  void feed(ByteRange fragment) { feed(StringPiece(fragment)); }
+
+  /**
+   * Parse every buffer of the chain, or the rest of the cursor's chain.
+   */
+  void feed(IOBuf const& chain);
+  void feed(io::Cursor cursor);
+
+  /**
+   * Signal the end of the document. Throws if it is incomplete.
+   */
+  void finish();
+
+  /**
+   * Whether a complete document has been parsed. Only trailing whitespace is
+   * accepted after it.
+   */
+  bool done() const { return state_ == state::done; }
+
+  /**
+   * Get ready to parse another document with the same handler.
+   */
+  void reset();
+
+ private:
+  enum class state : std::uint8_t {
+    value,
+    value_or_end, // after '[', or after ',' with trailing commas allowed
+    key,
+    key_or_end, // after '{', or after ',' with trailing commas allowed
+    colon,
+    comma_or_end,
+    done,
+    string, // inside a string value or key
+    scalar, // inside a number or literal
+  };
+
+  // Each of these consumes input from p and returns where it stopped.
+  char const* structural(char const* p, char const* end);
+  char const* beginValue(char const* p);
+  char const* continueString(char const* p, char const* end);
+  char const* continueScalar(char const* p, char const* end);
+
+  void endString(char const* p, StringPiece raw);
+  void endScalar(StringPiece token);
+  void endValue();
+  void endContainer(char c);
+  void unescape(char const* p, StringPiece raw, std::string& out) const;
+
+  [[noreturn]] void nonStringKey(char const* p) const;
+  [[noreturn]] void error(char const* p, char const* what) const;
+
+  event_handler& handler_;
+  bool allowTrailingComma_;
+  bool doubleFallback_;
+  bool convertIntKeys_;
+  bool numbersAsStrings_;
+  unsigned recursionLimit_;
+
+  state state_{state::value};
+  // '[' or '{' for every open container.
+  std::vector<char> stack_;
+
+  // Start of the current string or scalar in the current fragment, and its
+  // beginning from the previous fragments.
+  char const* tokenBegin_{nullptr};
+  std::string token_;
+  // Unescaped strings.
+  std::string scratch_;
+  bool inKey_{false};
+  bool escapePending_{false};
+  bool hasEscape_{false};
+  // A null byte followed the document.
+  bool ignoreRest_{false};
+
+  // For error messages.
+  unsigned lineNum_{0};
+  char const* fragmentEnd_{nullptr};
+};
+
+} // namespace json
+
+/**
+ * Parse a json document from an IOBuf chain without coalescing it. Accepts
+ * and rejects the same documents as parseJson(StringPiece, opts), except that
+ * allow_non_string_keys is not supported and null bytes in strings are
+ * rejected.
+ */
+dynamic parseJson(IOBuf const& chain);
+dynamic parseJson(IOBuf const& chain, json::serialization_opts const& opts);
+
+} // namespace folly
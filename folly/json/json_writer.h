@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Output of the json serializer.
+ *
+ * json::serialize() writes into a json::writer, a window of memory that the
+ * serializer fills directly and that the writer's implementation refills when
+ * it runs out. serialize() and toJson() use one backed by a std::string;
+ * json_iobuf_writer.h has one that writes into an IOBufQueue, so that the
+ * text can be sent without being copied first.
+ *
+ * Before writing a value, serialize() estimates the size of its text and
+ * asks for that much room at once.
+ *
+ * @file json_writer.h
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include <folly/CPortability.h>
+#include <folly/Range.h>
+#include <folly/json/dynamic.h>
+#include <folly/json/json.h>
+
+namespace folly {
+namespace json {
+
+class writer {
+ public:
+  writer(writer const&) = delete;
+  writer& operator=(writer const&) = delete;
+
+  void push_back(char c) {
+    reserve(1);
+    *pos_++ = c;
+  }
+
+  void append(char const* s, std::size_t n) {
+    reserve(n);
+    std::memcpy(pos_, s, n);
+    pos_ += n;
+  }
+
+  void append(char const* s) { append(s, std::strlen(s)); }
+
+  void append(std::size_t n, char c) {
+    reserve(n);
+    std::memset(pos_, c, n);
+    pos_ += n;
+  }
+
+  /**
+   * Make room for at least n more characters.
+   */
+  void reserve(std::size_t n) {
+    if (FOLLY_UNLIKELY(std::size_t(end_ - pos_) < n)) {
+      grow(n);
+    }
+  }
+
+ protected:
+  writer() = default;
+  ~writer() = default;
+
+  /**
+   * Keep the characters written so far, up to pos_, and point [pos_, end_)
+   * to room for at least n more.
+   */
+  virtual void grow(std::size_t n) = 0;
+
+  char* pos_{nullptr};
+  char* end_{nullptr};
+};
+
+/**
+ * Serialize dyn into out, like serialize(dyn, opts).
+ */
+void serialize(dynamic const& dyn, serialization_opts const& opts, writer& out);
+
+/**
+ * Like escapeString(input, std::string&, opts).
+ */
+void escapeString(
+    StringPiece input, writer& out, const serialization_opts& opts);
+
+/**
+ * An estimate of the length of serialize(dyn, opts), from the sizes of the
+ * strings and the numbers in dyn. Only the first 16 elements of arrays and
+ * objects are measured; the others count as the smallest element, so larger
+ * documents are underestimated rather than overestimated. Exact for smaller
+ * documents, unless strings need escaping or there are doubles.
+ */
+std::size_t estimateSerializedSize(
+    dynamic const& dyn, serialization_opts const& opts);
+
+} // namespace json
+} // namespace folly
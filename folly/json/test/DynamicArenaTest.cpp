@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/dynamic_arena.h>
+
+#include <memory>
+
+#include <folly/json/json.h>
+#include <folly/portability/GTest.h>
+
+namespace folly {
+namespace test {
+
+namespace {
+
+constexpr StringPiece kDocument = R"({
+  "a": [1, 2, 3, {"b": null, "c": [true, false]}],
+  "d": {"e": "a string long enough to not fit inline", "f": 1.5},
+  "g": []
+})";
+
+} // namespace
+
+TEST(DynamicArena, ParseAndBuild) {
+  dynamic_arena arena;
+  auto expected = parseJson(kDocument);
+  EXPECT_EQ(0, arena.bytesUsed());
+  {
+    auto doc = parseJson(kDocument, {}, arena);
+    EXPECT_NE(0, arena.bytesUsed());
+    EXPECT_EQ(expected, doc);
+
+    auto used = arena.bytesUsed();
+    auto h = dynamic::array_in(arena);
+    h.push_back(1);
+    h.push_back(dynamic::object_in(arena));
+    h[1]["i"] = "j";
+    doc["h"] = std::move(h);
+    doc["a"].push_back(4);
+    EXPECT_GT(arena.bytesUsed(), used);
+    EXPECT_EQ(4, doc["a"][4]);
+    EXPECT_EQ("j", doc["h"][1]["i"]);
+
+    doc.erase("h");
+    doc["a"].erase(doc["a"].begin());
+    EXPECT_EQ(expected["d"], doc["d"]);
+    EXPECT_EQ(4, doc["a"].size());
+  }
+}
+
+TEST(DynamicArena, OnlyExplicitUse) {
+  dynamic_arena arena;
+  auto doc = parseJson(kDocument, {}, arena);
+  doc["x"] = nullptr;
+  auto used = arena.bytesUsed();
+  // Values built without the arena use the heap, even when they are stored
+  // in a container that is in the arena.
+  doc["x"] = dynamic::array(1, dynamic::object("y", 2));
+  doc["x"][1]["z"] = dynamic::array(3);
+  EXPECT_EQ(used, arena.bytesUsed());
+}
+
+TEST(DynamicArena, CopiesUseHeap) {
+  // Copies, including those made while the original is alive, are
+  // heap-backed and outlive the arena.
+  dynamic copy;
+  dynamic copyConstructed;
+  dynamic assigned;
+  {
+    auto arena = std::make_unique<dynamic_arena>();
+    auto doc = parseJson(kDocument, {}, *arena);
+    auto used = arena->bytesUsed();
+    copy = doc;
+    copyConstructed = dynamic(doc["a"]);
+    assigned = dynamic::array(0);
+    assigned = doc["a"];
+    EXPECT_EQ(doc["a"], copyConstructed);
+    EXPECT_EQ(used, arena->bytesUsed());
+    doc = nullptr;
+    arena.reset();
+    copy["a"][3]["c"].push_back(nullptr);
+    copyConstructed[3]["c"].push_back(nullptr);
+    assigned[3]["c"].push_back(nullptr);
+  }
+  EXPECT_EQ(copy["a"], copyConstructed);
+  EXPECT_EQ(copy["a"], assigned);
+  auto expected = parseJson(kDocument);
+  expected["a"][3]["c"].push_back(nullptr);
+  EXPECT_EQ(expected, copy);
+}
+
+TEST(DynamicArena, CopyIntoArena) {
+  auto heap = parseJson(kDocument);
+  dynamic_arena arena;
+  dynamic copy(heap, arena);
+  EXPECT_EQ(heap, copy);
+  auto used = arena.bytesUsed();
+  EXPECT_NE(0, used);
+  copy["a"][3]["c"].push_back(1);
+  EXPECT_GT(arena.bytesUsed(), used);
+  EXPECT_EQ(dynamic(1.5), dynamic(dynamic(1.5), arena));
+}
+
+TEST(DynamicArena, MixHeapAndArena) {
+  dynamic heap = dynamic::object("x", dynamic::array(1, 2));
+  dynamic_arena arena;
+  {
+    dynamic doc = parseJson(kDocument, {}, arena);
+
+    // Moves and swaps carry the storage along, in both directions.
+    doc["x"] = std::move(heap["x"]);
+    heap["x"] = std::move(doc["a"]);
+    std::swap(heap["x"], doc["x"]);
+    EXPECT_EQ(dynamic::array(1, 2), heap["x"]);
+    EXPECT_EQ(parseJson(kDocument)["a"], doc["x"]);
+  }
+  heap["x"].push_back(3);
+  EXPECT_EQ(dynamic::array(1, 2, 3), heap["x"]);
+}
+
+} // namespace test
+} // namespace folly
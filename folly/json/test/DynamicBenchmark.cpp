@@ -18,6 +18,9 @@
 
 #include <folly/Benchmark.h>
 #include <folly/init/Init.h>
+#include <folly/json/dynamic_arena.h>
+#include <folly/json/frozen_dynamic.h>
+#include <folly/json/json.h>
 
 using folly::dynamic;
 
@@ -139,6 +142,113 @@ BENCHMARK(sizeLongString, iters) {
   }
 }
 
+BENCHMARK_DRAW_LINE();
+
+// A document shaped like a typical parsed payload: an array of small
+// objects with short keys and a nested array each.
+static dynamic makeDocument() {
+  dynamic doc = dynamic::array;
+  for (int64_t i = 0; i < 1000; ++i) {
+    doc.push_back(dynamic::object("id", i)("name", "item")("score", 0.5)(
+        "tags", dynamic::array("a", "b", "c"))("meta", dynamic::object)(
+        "active", true));
+  }
+  return doc;
+}
+
+static std::string const& documentJson() {
+  static auto const json = folly::toJson(makeDocument());
+  return json;
+}
+
+BENCHMARK(parseDocument, iters) {
+  folly::BenchmarkSuspender braces;
+  auto const& json = documentJson();
+  braces.dismiss();
+  for (size_t i = 0; i < iters; ++i) {
+    auto doc = folly::parseJson(json);
+    folly::doNotOptimizeAway(doc);
+    braces.rehire();
+    doc = nullptr;
+    braces.dismiss();
+  }
+}
+
+BENCHMARK_RELATIVE(parseDocumentArena, iters) {
+  folly::BenchmarkSuspender braces;
+  auto const& json = documentJson();
+  for (size_t i = 0; i < iters; ++i) {
+    auto arena = std::make_unique<folly::dynamic_arena>();
+    braces.dismiss();
+    {
+      auto doc = folly::parseJson(json, {}, *arena);
+      folly::doNotOptimizeAway(doc);
+      braces.rehire();
+    }
+    arena.reset();
+  }
+}
+
+BENCHMARK(destroyDocument, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    folly::BenchmarkSuspender braces;
+    auto doc = folly::parseJson(documentJson());
+    braces.dismiss();
+    doc = nullptr;
+    folly::doNotOptimizeAway(doc);
+  }
+}
+
+BENCHMARK_RELATIVE(destroyDocumentArena, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    folly::BenchmarkSuspender braces;
+    auto arena = std::make_unique<folly::dynamic_arena>();
+    auto doc = folly::parseJson(documentJson(), {}, *arena);
+    braces.dismiss();
+    doc = nullptr;
+    arena.reset();
+    folly::doNotOptimizeAway(doc);
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(lookupDocument, iters) {
+  folly::BenchmarkSuspender braces;
+  auto doc = makeDocument();
+  braces.dismiss();
+  for (size_t i = 0; i < iters; ++i) {
+    int64_t sum = 0;
+    for (auto const& item : doc) {
+      sum += item.at("id").getInt() + item.at("tags").size();
+    }
+    folly::doNotOptimizeAway(sum);
+  }
+}
+
+BENCHMARK_RELATIVE(lookupFrozen, iters) {
+  folly::BenchmarkSuspender braces;
+  folly::json::frozen_dynamic doc(makeDocument());
+  braces.dismiss();
+  for (size_t i = 0; i < iters; ++i) {
+    int64_t sum = 0;
+    for (auto item : doc.root()) {
+      sum += item.at("id").getInt() + item.at("tags").size();
+    }
+    folly::doNotOptimizeAway(sum);
+  }
+}
+
+BENCHMARK(freezeDocument, iters) {
+  folly::BenchmarkSuspender braces;
+  auto doc = makeDocument();
+  braces.dismiss();
+  for (size_t i = 0; i < iters; ++i) {
+    folly::json::frozen_dynamic frozen(doc);
+    folly::doNotOptimizeAway(frozen.bytes().size());
+  }
+}
+
 int main(int argc, char** argv) {
   folly::Init init(&argc, &argv);
   folly::runBenchmarks();
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/frozen_dynamic.h>
+
+#include <cstring>
+#include <vector>
+
+#include <folly/FileUtil.h>
+#include <folly/json/json.h>
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+using folly::dynamic;
+using folly::json::frozen_dynamic;
+using folly::json::frozen_view;
+
+namespace {
+
+dynamic makeConfig() {
+  return folly::parseJson(R"({
+    "name": "service",
+    "port": 8080,
+    "big": 12345678901234,
+    "negative": -2147483649,
+    "ratio": 0.25,
+    "enabled": true,
+    "disabled": false,
+    "nothing": null,
+    "": "empty key",
+    "a": "one byte key",
+    "ab\u0000c": "key with a NUL",
+    "été": "non ascii",
+    "servers": [
+      {"host": "a.example.com", "port": 80, "tags": []},
+      {"host": "b.example.com", "port": 81, "tags": ["x", "y"]}
+    ],
+    "nested": {"empty": {}, "list": [[], [1, [2, [3]]]], "s": ""}
+  })");
+}
+
+} // namespace
+
+TEST(FrozenDynamic, RoundTrip) {
+  auto config = makeConfig();
+  frozen_dynamic frozen(config);
+  EXPECT_EQ(config, frozen.root().toDynamic());
+  frozen.validate();
+
+  for (dynamic const& scalar :
+       {dynamic(nullptr),
+        dynamic(true),
+        dynamic(0),
+        dynamic(std::numeric_limits<int64_t>::min()),
+        dynamic(-0.5),
+        dynamic(""),
+        dynamic("x"),
+        dynamic::array,
+        dynamic::object}) {
+    frozen_dynamic f(scalar);
+    EXPECT_EQ(scalar, f.root().toDynamic());
+    EXPECT_EQ(scalar.type(), f.root().type());
+    f.validate();
+  }
+}
+
+TEST(FrozenDynamic, Accessors) {
+  frozen_dynamic frozen(makeConfig());
+  auto root = frozen.root();
+  EXPECT_TRUE(root.isObject());
+  EXPECT_EQ(14, root.size());
+  EXPECT_EQ("service", root.at("name").getString());
+  EXPECT_EQ(8080, root["port"].getInt());
+  EXPECT_EQ(12345678901234, root.at("big").getInt());
+  EXPECT_EQ(-2147483649, root.at("negative").asInt());
+  EXPECT_EQ(0.25, root.at("ratio").getDouble());
+  EXPECT_TRUE(root.at("enabled").getBool());
+  EXPECT_FALSE(root.at("disabled").asBool());
+  EXPECT_TRUE(root.at("nothing").isNull());
+  EXPECT_EQ("empty key", root.at("").getString());
+  EXPECT_EQ("one byte key", root.at("a").getString());
+  EXPECT_EQ(
+      "key with a NUL", root.at(folly::StringPiece("ab\0c", 4)).asString());
+  EXPECT_EQ("non ascii", root.at("été").getString());
+  EXPECT_EQ("8080", root.at("port").asString());
+  EXPECT_EQ(8080.0, root.at("port").asDouble());
+
+  // Strings are NUL terminated, and equal strings are stored once.
+  auto name = root.at("name").getString();
+  EXPECT_EQ('\0', name.end()[0]);
+  auto servers = root.at("servers");
+  EXPECT_EQ(
+      (*servers[0].items().begin()).first.data(),
+      (*servers[1].items().begin()).first.data());
+
+  EXPECT_FALSE(root.get_ptr("ab"));
+  EXPECT_FALSE(root.get_ptr("abc"));
+  EXPECT_EQ(0, root.count("missing"));
+  EXPECT_EQ(1, root.count("a"));
+  EXPECT_THROW(root.at("missing"), std::out_of_range);
+  EXPECT_THROW(servers.at(2), std::out_of_range);
+  EXPECT_FALSE(servers.get_ptr(2));
+  EXPECT_EQ(81, servers.at(1).at("port").getInt());
+
+  EXPECT_THROW(root.at(0), folly::TypeError);
+  EXPECT_THROW(servers.at("x"), folly::TypeError);
+  EXPECT_THROW(root.at("name").getInt(), folly::TypeError);
+  EXPECT_THROW(root.at("port").getString(), folly::TypeError);
+  EXPECT_THROW(root.at("port").size(), folly::TypeError);
+  EXPECT_THROW(servers.asInt(), folly::TypeError);
+  EXPECT_THROW(root.begin(), folly::TypeError);
+  EXPECT_THROW(servers.items(), folly::TypeError);
+
+  auto found = root.find("port");
+  ASSERT_NE(root.items().end(), found);
+  EXPECT_EQ("port", (*found).first);
+  EXPECT_EQ(8080, (*found).second.getInt());
+  EXPECT_EQ(root.items().end(), root.find("nope"));
+}
+
+TEST(FrozenDynamic, Iteration) {
+  auto config = makeConfig();
+  frozen_dynamic frozen(config);
+  auto root = frozen.root();
+
+  std::vector<std::string> keys;
+  for (auto const& item : root.items()) {
+    keys.push_back(item.first.str());
+    EXPECT_EQ(config[item.first], item.second.toDynamic());
+  }
+  EXPECT_EQ(config.size(), keys.size());
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+  auto list = root.at("nested").at("list").at(1);
+  EXPECT_EQ(2, list.end() - list.begin());
+  EXPECT_EQ(1, (*list.begin()).getInt());
+  EXPECT_EQ(2, list.begin()[1][0].getInt());
+  size_t n = 0;
+  for (auto element : root.at("servers")) {
+    EXPECT_EQ(80 + n++, element.at("port").getInt());
+  }
+  EXPECT_EQ(2, n);
+  EXPECT_TRUE(root.at("nested").at("empty").empty());
+  EXPECT_TRUE(root.at("nested").at("empty").items().empty());
+}
+
+TEST(FrozenDynamic, LargeObjects) {
+  // Enough keys to be binary searched, many of them sharing a prefix.
+  dynamic obj = dynamic::object;
+  for (int i = 0; i < 1000; ++i) {
+    obj[folly::to<std::string>("key", i)] = i;
+    obj[folly::to<std::string>(i)] = -i;
+  }
+  obj["k"] = "short";
+  obj["\xff\xff\xff\xff"] = "high bytes";
+  for (auto size : {1, 7, 8, 9, 31, 32, 33, 2002}) {
+    dynamic sub = dynamic::object;
+    for (auto const& item : obj.items()) {
+      if (sub.size() == size_t(size)) {
+        break;
+      }
+      sub.insert(item.first, item.second);
+    }
+    frozen_dynamic frozen(sub);
+    frozen.validate();
+    auto root = frozen.root();
+    for (auto const& item : sub.items()) {
+      auto value = root.get_ptr(item.first.stringPiece());
+      ASSERT_TRUE(value) << item.first;
+      EXPECT_EQ(item.second, value->toDynamic());
+    }
+    EXPECT_FALSE(root.get_ptr("key"));
+    EXPECT_FALSE(root.get_ptr("key10000"));
+    EXPECT_FALSE(root.get_ptr(""));
+  }
+}
+
+TEST(FrozenDynamic, JsonPointer) {
+  frozen_dynamic frozen(makeConfig());
+  auto root = frozen.root();
+  auto ptr = [](char const* s) { return folly::json_pointer::parse(s); };
+  EXPECT_EQ(root.toDynamic(), root.get_ptr(ptr(""))->toDynamic());
+  EXPECT_EQ(
+      "b.example.com", root.get_ptr(ptr("/servers/1/host"))->getString());
+  EXPECT_EQ(3, root.get_ptr(ptr("/nested/list/1/1/1/0"))->getInt());
+  EXPECT_FALSE(root.get_ptr(ptr("/servers/2")));
+  EXPECT_FALSE(root.get_ptr(ptr("/servers/-")));
+  EXPECT_FALSE(root.get_ptr(ptr("/missing/x")));
+  EXPECT_THROW(root.get_ptr(ptr("/servers/01")), std::invalid_argument);
+  EXPECT_THROW(root.get_ptr(ptr("/servers/x")), std::invalid_argument);
+  EXPECT_THROW(root.get_ptr(ptr("/port/x")), folly::TypeError);
+}
+
+TEST(FrozenDynamic, Errors) {
+  EXPECT_THROW(frozen_dynamic(dynamic::object(1, 2)), folly::TypeError);
+}
+
+TEST(FrozenDynamic, FromBytes) {
+  auto config = makeConfig();
+  frozen_dynamic frozen(config);
+  auto bytes = frozen.bytes();
+  EXPECT_EQ(0, bytes.size() % 8);
+
+  std::vector<uint64_t> copy(bytes.size() / 8);
+  std::memcpy(copy.data(), bytes.data(), bytes.size());
+  folly::ByteRange range(
+      reinterpret_cast<uint8_t const*>(copy.data()), bytes.size());
+  auto loaded = frozen_dynamic::fromBytes(range);
+  loaded.validate();
+  EXPECT_EQ(config, loaded.root().toDynamic());
+  EXPECT_EQ(range.data(), loaded.bytes().data());
+
+  EXPECT_THROW(
+      frozen_dynamic::fromBytes(range.subpiece(0, 16)), std::runtime_error);
+  EXPECT_THROW(
+      frozen_dynamic::fromBytes(range.subpiece(0, range.size() - 8)),
+      std::runtime_error);
+  EXPECT_THROW(
+      frozen_dynamic::fromBytes(range.subpiece(1)), std::invalid_argument);
+
+  auto corrupt = [&](size_t at, uint8_t byte) {
+    auto c = copy;
+    reinterpret_cast<uint8_t*>(c.data())[at] = byte;
+    folly::ByteRange r(
+        reinterpret_cast<uint8_t const*>(c.data()), range.size());
+    frozen_dynamic::fromBytes(r).validate();
+  };
+  // The magic, the version, the root slot.
+  EXPECT_THROW(corrupt(0, 'x'), std::runtime_error);
+  EXPECT_THROW(corrupt(4, 9), std::runtime_error);
+  EXPECT_THROW(corrupt(16, 42), std::runtime_error);
+  EXPECT_THROW(corrupt(20, 0xff), std::runtime_error);
+  // Offset of the root object: out of order, unaligned, out of bounds.
+  EXPECT_THROW(corrupt(20, 1), std::runtime_error);
+  EXPECT_THROW(corrupt(23, 0x7f), std::runtime_error);
+  // The first key prefix.
+  EXPECT_THROW(corrupt(32, 1), std::runtime_error);
+}
+
+TEST(FrozenDynamic, MapFile) {
+  auto config = makeConfig();
+  folly::test::TemporaryFile file;
+  {
+    frozen_dynamic frozen(config);
+    auto bytes = frozen.bytes();
+    ASSERT_EQ(
+        bytes.size(), folly::writeFull(file.fd(), bytes.data(), bytes.size()));
+  }
+  // The mapping outlives the first frozen_dynamic, through its copy.
+  auto copy = [&] {
+    auto mapped = frozen_dynamic::mapFile(file.path().string().c_str());
+    mapped.validate();
+    auto ret = mapped;
+    return ret;
+  }();
+  EXPECT_EQ(config, copy.root().toDynamic());
+  EXPECT_EQ(80, copy.root().at("servers").at(0).at("port").getInt());
+}
@@ -448,3 +448,98 @@ TEST(JSONSchemaTest, TestProductSchema) {
   }";
   ASSERT_TRUE(check(parseJson(productSchema), parseJson(product)));
 }
+
+TEST(JSONSchemaTest, TestErrorMessages) {
+  auto what = [](const dynamic& schema, const dynamic& value) {
+    auto ew = makeValidator(schema)->try_validate(value);
+    EXPECT_TRUE(ew);
+    return ew ? std::string(ew.get_exception()->what()) : std::string();
+  };
+  EXPECT_EQ(
+      "Expected to get a value of type \"integer, string\" for value 1.5",
+      what(dynamic::object("type", dynamic::array("integer", "string")), 1.5));
+  EXPECT_EQ(
+      "Expected to get property \"bar\" for value {\"foo\":1}",
+      what(
+          dynamic::object("required", dynamic::array("foo", "bar")),
+          dynamic::object("foo", 1)));
+  EXPECT_EQ(
+      "Expected to get greater than 3 for value 3",
+      what(dynamic::object("minimum", 3)("exclusiveMinimum", true), 3));
+  // Failures in subschemas are reported for the values they apply to.
+  EXPECT_EQ(
+      "Expected to get less than or equal to 2 for value 5",
+      what(
+          dynamic::object(
+              "properties",
+              dynamic::object(
+                  "a",
+                  dynamic::object("items", dynamic::object("maximum", 2)))),
+          dynamic::object("a", dynamic::array(1, 5))));
+  EXPECT_EQ(
+      "Expected to get exactly one valid schema for value 4",
+      what(
+          dynamic::object(
+              "oneOf",
+              dynamic::array(
+                  dynamic::object("type", "integer"),
+                  dynamic::object("minimum", 2))),
+          4));
+}
+
+TEST(JSONSchemaTest, TestManyProperties) {
+  dynamic properties = dynamic::object;
+  dynamic value = dynamic::object;
+  for (int i = 0; i < 100; ++i) {
+    auto key = folly::to<std::string>("p", i);
+    properties[key] = dynamic::object("type", i % 2 ? "integer" : "string");
+    value[key] = i % 2 ? dynamic(i) : dynamic(key);
+  }
+  dynamic patterns = dynamic::object("^x", dynamic::object("minimum", 0));
+  dynamic schema = dynamic::object("properties", properties)(
+      "patternProperties", patterns)("additionalProperties", false);
+  ASSERT_TRUE(check(schema, value));
+  value["x1"] = 1;
+  ASSERT_TRUE(check(schema, value));
+  value["x2"] = -1;
+  ASSERT_FALSE(check(schema, value));
+  value.erase("x2");
+  value["p1"] = "not an integer";
+  ASSERT_FALSE(check(schema, value));
+  value["p1"] = 1;
+  value["p"] = 1;
+  ASSERT_FALSE(check(schema, value));
+}
+
+TEST(JSONSchemaTest, TestSharedRef) {
+  // The same subschema can apply to a value more than once, as long as it
+  // does not apply to it within itself.
+  dynamic definitions =
+      dynamic::object("int", dynamic::object("type", "integer"));
+  dynamic schema = dynamic::object("definitions", definitions)(
+      "anyOf",
+      dynamic::array(
+          dynamic::object("$ref", "#/definitions/int"),
+          dynamic::object("$ref", "#/definitions/int")))(
+      "allOf",
+      dynamic::array(
+          dynamic::object("$ref", "#/definitions/int"),
+          dynamic::object("$ref", "#/definitions/int")));
+  ASSERT_TRUE(check(schema, 1));
+  ASSERT_FALSE(check(schema, "1"));
+}
+
+TEST(JSONSchemaTest, TestConditionallyRecursiveRef) {
+  dynamic schema = dynamic::object("type", "string")(
+      "allOf", dynamic::array(dynamic::object("$ref", "#")));
+  auto validator = makeValidator(schema);
+  auto ew = validator->try_validate(1);
+  ASSERT_TRUE(ew);
+  EXPECT_EQ(
+      "Expected to get a value of type \"string\" for value 1",
+      std::string(ew.get_exception()->what()));
+  ew = validator->try_validate("a");
+  ASSERT_TRUE(ew);
+  EXPECT_EQ(
+      "Infinite recursion detected", std::string(ew.get_exception()->what()));
+}
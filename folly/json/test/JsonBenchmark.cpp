@@ -17,6 +17,12 @@
 #include <folly/json/json.h>
 
 #include <folly/Benchmark.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+#include <folly/json/JsonConverter.h>
+#include <folly/json/json_iobuf_writer.h>
+#include <folly/json/json_lazy_view.h>
+#include <folly/json/json_stream_parser.h>
 
 #include <fstream>
 #include <streambuf>
@@ -240,6 +246,171 @@ BENCHMARK(PerfJson2Obj, iters) {
   }
 }
 
+BENCHMARK_RELATIVE(PerfJson2ObjIndexed, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJsonIndexed(kJsonBenchmarkString));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+// The common pattern of parsing a payload to read a handful of fields.
+BENCHMARK(PerfJsonReadFields, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    auto parsed = parseJson(kJsonBenchmarkString);
+    auto const& app = parsed["web-app"];
+    folly::doNotOptimizeAway(app["servlet"][0]["servlet-name"].getString());
+    folly::doNotOptimizeAway(app["servlet-mapping"]["cofaxCDS"].getString());
+    folly::doNotOptimizeAway(app["taglib"]["taglib-uri"].getString());
+  }
+}
+
+BENCHMARK_RELATIVE(PerfJsonReadFieldsLazy, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    json::lazy_document doc(kJsonBenchmarkString);
+    auto app = doc.root().at("web-app");
+    folly::doNotOptimizeAway(
+        app.at("servlet").at(0).at("servlet-name").getString());
+    folly::doNotOptimizeAway(
+        app.at("servlet-mapping").at("cofaxCDS").getString());
+    folly::doNotOptimizeAway(app.at("taglib").at("taglib-uri").getString());
+  }
+}
+
+BENCHMARK_RELATIVE(PerfJsonReadFieldsLazyPointer, iters) {
+  BenchmarkSuspender s;
+  auto ptr = json_pointer::parse("/web-app/servlet/0/servlet-name");
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    json::lazy_document doc(kJsonBenchmarkString);
+    folly::doNotOptimizeAway(doc.root().get_ptr(ptr)->getString());
+  }
+}
+
+// A few MB of the sample above, to measure throughput on large documents.
+static std::string makeLargeJson(StringPiece element, size_t count) {
+  std::string ret = "[";
+  for (size_t i = 0; i < count; ++i) {
+    if (i != 0) {
+      ret += ",";
+    }
+    ret.append(element.begin(), element.end());
+  }
+  ret += "]";
+  return ret;
+}
+
+BENCHMARK(PerfJson2ObjLarge, iters) {
+  BenchmarkSuspender s;
+  auto json = makeLargeJson(kJsonBenchmarkString, 1000);
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJson(json));
+  }
+}
+
+BENCHMARK_RELATIVE(PerfJson2ObjLargeIndexed, iters) {
+  BenchmarkSuspender s;
+  auto json = makeLargeJson(kJsonBenchmarkString, 1000);
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJsonIndexed(json));
+  }
+}
+
+BENCHMARK(PerfJson2ObjLargeStrings, iters) {
+  BenchmarkSuspender s;
+  auto json = makeLargeJson(to<std::string>('"', kLargeAsciiString, '"'), 10000);
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJson(json));
+  }
+}
+
+BENCHMARK_RELATIVE(PerfJson2ObjLargeStringsIndexed, iters) {
+  BenchmarkSuspender s;
+  auto json = makeLargeJson(to<std::string>('"', kLargeAsciiString, '"'), 10000);
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJsonIndexed(json));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+// The large document split into 4KB buffers, as read off a socket.
+static std::unique_ptr<IOBuf> makeLargeJsonChain() {
+  auto json = makeLargeJson(kJsonBenchmarkString, 1000);
+  std::unique_ptr<IOBuf> chain;
+  for (size_t pos = 0; pos < json.size(); pos += 4096) {
+    auto buf = IOBuf::copyBuffer(
+        json.data() + pos, std::min<size_t>(4096, json.size() - pos));
+    if (chain) {
+      chain->appendToChain(std::move(buf));
+    } else {
+      chain = std::move(buf);
+    }
+  }
+  return chain;
+}
+
+BENCHMARK(PerfJson2ObjChainCoalesced, iters) {
+  BenchmarkSuspender s;
+  auto chain = makeLargeJsonChain();
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    auto copy = chain->cloneCoalescedAsValue();
+    folly::doNotOptimizeAway(parseJson(StringPiece(copy.coalesce())));
+  }
+}
+
+BENCHMARK_RELATIVE(PerfJson2ObjChainStream, iters) {
+  BenchmarkSuspender s;
+  auto chain = makeLargeJsonChain();
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJson(*chain));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+using TypedRecords =
+    std::vector<F14FastMap<std::string, std::vector<std::string>>>;
+
+static constexpr StringPiece kTypedRecord =
+    R"({"name": ["folly"], "tags": ["json", "parser", "benchmark"],
+        "authors": ["a", "b"], "empty": []})";
+
+BENCHMARK(PerfJson2Typed, iters) {
+  BenchmarkSuspender s;
+  auto json = makeLargeJson(kTypedRecord, 1000);
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(convertTo<TypedRecords>(parseJson(json)));
+  }
+}
+
+BENCHMARK_RELATIVE(PerfJson2TypedDirect, iters) {
+  BenchmarkSuspender s;
+  auto json = makeLargeJson(kTypedRecord, 1000);
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJsonAs<TypedRecords>(json));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
 BENCHMARK(PerfObj2Json, iters) {
   BenchmarkSuspender s;
   dynamic parsed = parseJson(kJsonBenchmarkString);
@@ -250,6 +421,28 @@ BENCHMARK(PerfObj2Json, iters) {
   }
 }
 
+BENCHMARK(PerfObj2JsonLarge, iters) {
+  BenchmarkSuspender s;
+  dynamic parsed = parseJson(makeLargeJson(kJsonBenchmarkString, 1000));
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(toJson(parsed));
+  }
+}
+
+BENCHMARK_RELATIVE(PerfObj2JsonLargeIOBuf, iters) {
+  BenchmarkSuspender s;
+  dynamic parsed = parseJson(makeLargeJson(kJsonBenchmarkString, 1000));
+  s.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    IOBufQueue queue;
+    json::serialize(parsed, json::serialization_opts(), queue);
+    folly::doNotOptimizeAway(queue.front());
+  }
+}
+
 // Benchmark results in a Macbook Pro 2015 (i7-4870HQ, 4th gen)
 // ============================================================================
 // folly/test/JsonBenchmark.cpp                   relative  time/iter   iters/s
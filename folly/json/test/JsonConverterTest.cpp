@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/JsonConverter.h>
+
+#include <deque>
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/FBVector.h>
+#include <folly/Optional.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+#include <folly/json/json_events.h>
+#include <folly/portability/GTest.h>
+
+namespace {
+
+struct Point {
+  int x = 0;
+  int y = 0;
+  std::string label;
+  std::vector<double> weights;
+};
+
+enum class Color { Red, Green };
+
+// Only decodable through DynamicConverter.
+struct Token {
+  int kind;
+  std::string lexeme;
+};
+
+} // namespace
+
+namespace folly {
+
+template <>
+struct JsonConverter<Point> {
+  static Point convert(json::reader& reader) {
+    return json::convertFields<Point>(
+        reader,
+        json::field("x", &Point::x),
+        json::field("y", &Point::y),
+        json::field("label", &Point::label),
+        json::field("weights", &Point::weights));
+  }
+};
+
+template <>
+struct DynamicConverter<Token> {
+  static Token convert(const dynamic& d) {
+    return Token{
+        convertTo<int>(d["kind"]), convertTo<std::string>(d["lexeme"])};
+  }
+};
+
+} // namespace folly
+
+using namespace folly;
+
+namespace {
+
+// parseJsonAs must agree with convertTo over parseJson.
+template <typename T>
+void expectSameAsConvertTo(StringPiece json) {
+  SCOPED_TRACE(json);
+  T expected;
+  try {
+    expected = convertTo<T>(parseJson(json));
+  } catch (json::parse_error const&) {
+    EXPECT_THROW(parseJsonAs<T>(json), json::parse_error);
+    return;
+  } catch (TypeError const&) {
+    EXPECT_THROW(parseJsonAs<T>(json), TypeError);
+    return;
+  } catch (std::range_error const&) {
+    EXPECT_THROW(parseJsonAs<T>(json), std::range_error);
+    return;
+  }
+  EXPECT_EQ(expected, parseJsonAs<T>(json));
+}
+
+} // namespace
+
+TEST(JsonConverter, Scalars) {
+  expectSameAsConvertTo<int>("12");
+  expectSameAsConvertTo<int>("\"12\"");
+  expectSameAsConvertTo<int>("1.5");
+  expectSameAsConvertTo<int>("true");
+  expectSameAsConvertTo<int>("[1]");
+  expectSameAsConvertTo<int8_t>("300");
+  expectSameAsConvertTo<uint64_t>("-1");
+  expectSameAsConvertTo<bool>("false");
+  expectSameAsConvertTo<bool>("0");
+  expectSameAsConvertTo<double>("1.5e3");
+  expectSameAsConvertTo<double>("2");
+  expectSameAsConvertTo<std::string>("\"a\\nb\\u00e9\"");
+  expectSameAsConvertTo<std::string>("12");
+  expectSameAsConvertTo<std::string>("{}");
+  expectSameAsConvertTo<fbstring>("\"abc\"");
+  expectSameAsConvertTo<Color>("1");
+  expectSameAsConvertTo<dynamic>(R"({"a": [1, 2.5, null]})");
+}
+
+TEST(JsonConverter, Containers) {
+  expectSameAsConvertTo<std::vector<int>>("[1, 2, 3]");
+  expectSameAsConvertTo<std::vector<int>>("[]");
+  expectSameAsConvertTo<std::vector<int>>("3");
+  expectSameAsConvertTo<std::vector<bool>>("[true, false]");
+  expectSameAsConvertTo<fbvector<fbvector<int>>>("[[1, 2], [], [3]]");
+  expectSameAsConvertTo<std::deque<std::string>>(R"(["a", "b"])");
+  expectSameAsConvertTo<std::list<int>>("[1, \"2\"]");
+  expectSameAsConvertTo<std::vector<std::pair<std::string, int>>>(
+      R"({"a": 1})");
+  expectSameAsConvertTo<std::vector<int>>(R"({"a": 1})");
+  expectSameAsConvertTo<std::set<int>>("[3, 1, 3]");
+  expectSameAsConvertTo<F14FastSet<std::string>>(R"(["x", "y"])");
+  expectSameAsConvertTo<std::map<std::string, int>>(R"({"a": 1, "b": 2})");
+  expectSameAsConvertTo<std::map<int, std::vector<int>>>(
+      R"({"1": [1], "2": []})");
+  expectSameAsConvertTo<std::map<std::string, int>>(R"([["a", 1], ["b", 2]])");
+  expectSameAsConvertTo<std::unordered_map<std::string, double>>(
+      R"({"a": 1.5})");
+  expectSameAsConvertTo<std::multimap<std::string, int>>(R"({"a": 1})");
+  expectSameAsConvertTo<F14NodeMap<std::string, std::vector<std::string>>>(
+      R"({"a": ["x"], "b": []})");
+  expectSameAsConvertTo<F14FastMap<std::string, int>>("[1, 2]");
+  expectSameAsConvertTo<std::map<std::string, int>>("null");
+}
+
+TEST(JsonConverter, PairsAndOptionals) {
+  expectSameAsConvertTo<std::pair<int, std::string>>(R"([1, "a"])");
+  expectSameAsConvertTo<std::pair<std::string, int>>(R"({"a": 1})");
+  expectSameAsConvertTo<std::pair<int, int>>("[1, 2, 3]");
+  expectSameAsConvertTo<std::pair<int, int>>("[1]");
+  expectSameAsConvertTo<std::pair<std::string, int>>(R"({"a": 1, "b": 2})");
+  expectSameAsConvertTo<std::pair<int, int>>("1");
+  expectSameAsConvertTo<Optional<int>>("null");
+  expectSameAsConvertTo<Optional<int>>("1");
+  expectSameAsConvertTo<std::optional<std::string>>("\"x\"");
+  expectSameAsConvertTo<std::vector<Optional<int>>>("[1, null, 3]");
+}
+
+TEST(JsonConverter, DuplicateKeys) {
+  using Map = std::map<std::string, int>;
+  auto m = parseJsonAs<Map>(R"({"a": 1, "a": 2})");
+  EXPECT_EQ(2, m["a"]);
+  EXPECT_EQ(2, convertTo<Map>(parseJson(R"({"a": 1, "a": 2})"))["a"]);
+
+  json::serialization_opts opts;
+  opts.validate_keys = true;
+  EXPECT_THROW(
+      parseJsonAs<Map>(R"({"a": 1, "a": 2})", opts), json::parse_error);
+}
+
+TEST(JsonConverter, Options) {
+  json::serialization_opts opts;
+  EXPECT_THROW(
+      parseJsonAs<std::vector<int>>("[1, 2,]", opts), json::parse_error);
+  opts.allow_trailing_comma = true;
+  EXPECT_EQ(
+      (std::vector<int>{1, 2}), parseJsonAs<std::vector<int>>("[1, 2,]", opts));
+  EXPECT_EQ(
+      (std::map<std::string, int>{{"a", 1}}),
+      (parseJsonAs<std::map<std::string, int>>(R"({"a": 1,})", opts)));
+
+  opts = {};
+  opts.recursion_limit = 2;
+  using Nested = std::vector<std::vector<std::vector<int>>>;
+  EXPECT_EQ(Nested{{{}}}, parseJsonAs<Nested>("[[[]]]", opts));
+  EXPECT_THROW(parseJsonAs<Nested>("[[[1]]]", opts), json::parse_error);
+  EXPECT_THROW(parseJson("[[[1]]]", opts), json::parse_error);
+
+  opts = {};
+  opts.convert_int_keys = true;
+  EXPECT_EQ(
+      (std::map<std::string, int>{{"1", 2}}),
+      (parseJsonAs<std::map<std::string, int>>(R"({1: 2})", opts)));
+  EXPECT_THROW(
+      (parseJsonAs<std::map<std::string, int>>(R"({1: 2})")),
+      json::parse_error);
+
+  opts = {};
+  opts.parse_numbers_as_strings = true;
+  EXPECT_EQ("1.50", parseJsonAs<std::string>("1.50", opts));
+}
+
+TEST(JsonConverter, Structs) {
+  auto p = parseJsonAs<Point>(
+      R"({"y": 2, "ignored": {"a": [1, "é"]}, "label": "p", "x": 1,
+          "weights": [0.5]})");
+  EXPECT_EQ(1, p.x);
+  EXPECT_EQ(2, p.y);
+  EXPECT_EQ("p", p.label);
+  EXPECT_EQ(std::vector<double>{0.5}, p.weights);
+
+  auto points = parseJsonAs<std::vector<Point>>(R"([{"x": 3}, {}])");
+  ASSERT_EQ(2, points.size());
+  EXPECT_EQ(3, points[0].x);
+  EXPECT_EQ(0, points[0].y);
+  EXPECT_EQ(0, points[1].x);
+
+  EXPECT_THROW(parseJsonAs<Point>("[]"), TypeError);
+  EXPECT_THROW(parseJsonAs<Point>(R"({"x": [})"), json::parse_error);
+  EXPECT_THROW(parseJsonAs<Point>(R"({"z": [}, "x": 1})"), json::parse_error);
+
+  auto tokens = parseJsonAs<std::map<std::string, Token>>(
+      R"({"t": {"kind": 1, "lexeme": "if"}})");
+  EXPECT_EQ(1, tokens["t"].kind);
+  EXPECT_EQ("if", tokens["t"].lexeme);
+}
+
+TEST(JsonConverter, Errors) {
+  EXPECT_THROW(parseJsonAs<int>("1 2"), json::parse_error);
+  EXPECT_THROW(parseJsonAs<std::vector<int>>("[1 2]"), json::parse_error);
+  EXPECT_THROW(parseJsonAs<std::vector<int>>("[1,"), json::parse_error);
+  EXPECT_THROW(
+      (parseJsonAs<std::map<std::string, int>>(R"({"a" 1})")),
+      json::parse_error);
+  EXPECT_EQ(1, parseJsonAs<int>(StringPiece("1\0garbage", 9)));
+
+  try {
+    parseJsonAs<std::vector<int>>("[1,\n2,\n]");
+    ADD_FAILURE();
+  } catch (json::parse_error const& e) {
+    try {
+      parseJson("[1,\n2,\n]");
+      ADD_FAILURE();
+    } catch (json::parse_error const& expected) {
+      EXPECT_STREQ(expected.what(), e.what());
+    }
+  }
+}
+
+namespace {
+
+class recorder : public json::event_handler {
+ public:
+  void on_null() override { out += "n "; }
+  void on_bool(bool v) override { out += v ? "t " : "f "; }
+  void on_int(int64_t v) override { out += to<std::string>(v, ' '); }
+  void on_double(double v) override { out += to<std::string>(v, ' '); }
+  void on_string(StringPiece v) override {
+    out += to<std::string>('"', v, "\" ");
+  }
+  void on_begin_array() override { out += "[ "; }
+  void on_end_array() override { out += "] "; }
+  void on_begin_object() override { out += "{ "; }
+  void on_key(StringPiece k) override { out += to<std::string>(k, ": "); }
+  void on_end_object() override { out += "} "; }
+
+  std::string out;
+};
+
+} // namespace
+
+TEST(JsonEvents, ParseJson) {
+  recorder rec;
+  parseJson(
+      R"({"a": [1, 2.5, "x\ty", true, null], "bé": {}, "c": []})", rec);
+  EXPECT_EQ(
+      "{ a: [ 1 2.5 \"x\ty\" t n ] bé: { } c: [ ] } ", rec.out);
+
+  EXPECT_THROW(parseJson("[1, 2", rec), json::parse_error);
+  EXPECT_THROW(parseJson("[1] 2", rec), json::parse_error);
+
+  json::serialization_opts opts;
+  opts.parse_numbers_as_strings = true;
+  rec.out.clear();
+  parseJson("[1.0, 2]", opts, rec);
+  EXPECT_EQ("[ \"1.0\" \"2\" ] ", rec.out);
+}
+
+TEST(JsonEvents, DynamicBuilder) {
+  for (auto json :
+       {R"({"a": [1, 2.5, "x", true, null], "b": {"c": {}}, "d": []})",
+        "[]",
+        "\"s\"",
+        "-3"}) {
+    json::dynamic_builder builder;
+    parseJson(json, builder);
+    EXPECT_EQ(parseJson(json), builder.result());
+  }
+}
+
+TEST(JsonReader, Walk) {
+  json::reader r(R"({"a": [1, 2], "b": "x", "c": {"d": null}} )");
+  EXPECT_EQ('{', r.peek());
+  r.beginObject();
+  StringPiece key;
+  std::vector<std::string> keys;
+  int64_t sum = 0;
+  while (r.nextKey(key)) {
+    keys.emplace_back(key);
+    if (key == "a") {
+      r.beginArray();
+      while (r.nextElement()) {
+        sum += r.readValue().asInt();
+      }
+    } else if (key == "b") {
+      EXPECT_EQ("x", r.readStringPiece());
+    } else {
+      r.skipValue();
+    }
+  }
+  r.finish();
+  EXPECT_EQ((std::vector<std::string>{"a", "b", "c"}), keys);
+  EXPECT_EQ(3, sum);
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json_lazy_view.h>
+
+#include <cmath>
+
+#include <folly/portability/GTest.h>
+
+using folly::dynamic;
+using folly::json_pointer;
+using folly::StringPiece;
+using folly::TypeError;
+using folly::json::lazy_document;
+using folly::json::lazy_view;
+using folly::json::parse_error;
+
+namespace {
+
+// Rebuilds a dynamic through the view API only, without toDynamic().
+dynamic walk(lazy_view v) {
+  switch (v.type()) {
+    case dynamic::NULLT:
+      return nullptr;
+    case dynamic::BOOL:
+      return v.getBool();
+    case dynamic::INT64:
+      return v.getInt();
+    case dynamic::DOUBLE:
+      return v.getDouble();
+    case dynamic::STRING:
+      return v.getString();
+    case dynamic::ARRAY: {
+      dynamic ret = dynamic::array;
+      for (auto elem : v) {
+        ret.push_back(walk(elem));
+      }
+      return ret;
+    }
+    case dynamic::OBJECT: {
+      dynamic ret = dynamic::object;
+      for (auto const& [key, value] : v.items()) {
+        ret[key.getString()] = walk(value);
+      }
+      return ret;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+TEST(JsonLazyView, Scalars) {
+  EXPECT_TRUE(lazy_document("null").root().isNull());
+  EXPECT_TRUE(lazy_document(" true ").root().getBool());
+  EXPECT_FALSE(lazy_document("false").root().getBool());
+  EXPECT_EQ(-12, lazy_document("-12").root().getInt());
+  EXPECT_EQ(1.5e3, lazy_document("1.5e3").root().getDouble());
+  EXPECT_EQ(0.25, lazy_document("0.25").root().getDouble());
+  EXPECT_TRUE(std::isnan(lazy_document("NaN").root().getDouble()));
+  EXPECT_EQ(-INFINITY, lazy_document("-Infinity").root().getDouble());
+  EXPECT_EQ("abc", lazy_document(R"("abc")").root().getString());
+  EXPECT_EQ(
+      "a\"b\\c/d\n\xe2\x99\xa5\xf0\x9f\x98\x80",
+      lazy_document(R"("a\"b\\c\/d\n♥😀")").root().getString());
+  EXPECT_EQ(7, lazy_document(StringPiece("7\0trailing", 10)).root().getInt());
+
+  lazy_document big("9223372036854775808");
+  EXPECT_TRUE(big.root().isInt());
+  EXPECT_ANY_THROW(big.root().getInt());
+
+  folly::json::serialization_opts opts;
+  opts.double_fallback = true;
+  lazy_document fallback("9223372036854775808", opts);
+  EXPECT_TRUE(fallback.root().isDouble());
+  EXPECT_EQ(9223372036854775808.0, fallback.root().getDouble());
+}
+
+TEST(JsonLazyView, Conversions) {
+  lazy_document doc(R"([1, 2.5, "3", true, null])");
+  auto root = doc.root();
+  EXPECT_EQ(1.0, root.at(0).asDouble());
+  EXPECT_EQ("2.5", root.at(1).asString());
+  EXPECT_EQ(3, root.at(2).asInt());
+  EXPECT_EQ(1, root.at(3).asInt());
+  EXPECT_TRUE(root.at(0).asBool());
+  EXPECT_THROW(root.at(4).asInt(), TypeError);
+
+  EXPECT_THROW(root.at(0).getString(), TypeError);
+  EXPECT_THROW(root.at(1).getInt(), TypeError);
+  EXPECT_THROW(root.at(2).getBool(), TypeError);
+  EXPECT_THROW(root.getDouble(), TypeError);
+}
+
+TEST(JsonLazyView, Containers) {
+  lazy_document doc(R"({
+    "id": 42,
+    "name": "widget",
+    "tags": ["a", "b", "c"],
+    "nested": {"empty": {}, "list": [], "deep": [[1], [2, [3]]]},
+    "id": 43
+  })");
+  auto root = doc.root();
+  EXPECT_TRUE(root.isObject());
+  EXPECT_EQ(5, root.size());
+  EXPECT_FALSE(root.empty());
+
+  // Duplicate keys: the last one wins, like parseJson.
+  EXPECT_EQ(43, root.at("id").getInt());
+  EXPECT_EQ(43, root.toDynamic()["id"].getInt());
+  EXPECT_EQ(1, root.count("name"));
+  EXPECT_EQ(0, root.count("missing"));
+  EXPECT_FALSE(root.get_ptr("missing").has_value());
+  EXPECT_THROW(root.at("missing"), std::out_of_range);
+
+  auto tags = root.at("tags");
+  EXPECT_EQ(3, tags.size());
+  EXPECT_EQ("b", tags.at(1).getString());
+  EXPECT_FALSE(tags.get_ptr(3).has_value());
+  EXPECT_THROW(tags.at(3), std::out_of_range);
+  EXPECT_THROW(tags.at("a"), TypeError);
+  EXPECT_THROW(root.at(0), TypeError);
+
+  auto nested = root.at("nested");
+  EXPECT_TRUE(nested.at("empty").empty());
+  EXPECT_TRUE(nested.at("list").empty());
+  EXPECT_EQ(0, nested.at("list").size());
+  EXPECT_EQ(3, nested.at("deep").at(1).at(1).at(0).getInt());
+
+  EXPECT_EQ(R"(["a", "b", "c"])", tags.raw());
+  EXPECT_EQ(R"("widget")", root.at("name").raw());
+  EXPECT_EQ("43", root.at("id").raw());
+}
+
+TEST(JsonLazyView, StringEquals) {
+  lazy_document doc(
+      R"({"plain": 1, "esc\"aped": 2, "été": 3, "😀": 4})");
+  auto root = doc.root();
+  EXPECT_EQ(1, root.at("plain").getInt());
+  EXPECT_EQ(2, root.at("esc\"aped").getInt());
+  EXPECT_EQ(3, root.at("\xc3\xa9t\xc3\xa9").getInt());
+  EXPECT_EQ(4, root.at("\xf0\x9f\x98\x80").getInt());
+  EXPECT_FALSE(root.get_ptr("esc").has_value());
+  EXPECT_FALSE(root.get_ptr("esc\"aped!").has_value());
+  EXPECT_FALSE(root.get_ptr("\xc3\xa9t").has_value());
+
+  EXPECT_TRUE(lazy_document(R"("a\tb")").root().stringEquals("a\tb"));
+  EXPECT_FALSE(lazy_document(R"("a\tb")").root().stringEquals("a\\tb"));
+  EXPECT_FALSE(lazy_document(R"("\ud83d")").root().stringEquals("?"));
+}
+
+TEST(JsonLazyView, JsonPointer) {
+  lazy_document doc(R"({"a": {"b": [10, {"c~/": "x"}]}, "": 5})");
+  auto root = doc.root();
+  auto get = [&](StringPiece ptr) {
+    return root.get_ptr(json_pointer::parse(ptr));
+  };
+  EXPECT_EQ(10, get("/a/b/0")->getInt());
+  EXPECT_EQ("x", get("/a/b/1/c~0~1")->getString());
+  EXPECT_EQ(5, get("/")->getInt());
+  EXPECT_TRUE(get("")->isObject());
+  EXPECT_FALSE(get("/a/b/2").has_value());
+  EXPECT_FALSE(get("/a/x").has_value());
+  EXPECT_FALSE(get("/a/b/-").has_value());
+  EXPECT_FALSE(get("/a/b/-/0").has_value());
+  EXPECT_THROW(get("/a/b/01"), std::invalid_argument);
+  EXPECT_THROW(get("/a/b/x"), std::invalid_argument);
+  EXPECT_THROW(get("/a/b/0/c"), TypeError);
+
+  // Same answers as dynamic.
+  auto dyn = root.toDynamic();
+  for (auto ptr : {"/a/b/0", "/a/b/1/c~0~1", "/", "/a/b/2", "/a/x"}) {
+    auto expected = dyn.get_ptr(json_pointer::parse(ptr));
+    auto actual = get(ptr);
+    ASSERT_EQ(expected != nullptr, actual.has_value()) << ptr;
+    if (expected) {
+      EXPECT_EQ(*expected, actual->toDynamic()) << ptr;
+    }
+  }
+}
+
+TEST(JsonLazyView, MatchesParseJson) {
+  for (StringPiece s : {
+           R"([])",
+           R"({})",
+           R"([1, -2, 3.5, "x", true, false, null, [], {}])",
+           R"({"a": {"b": {"c": [1, [2, [3, {"d": "e\nf"}]]]}}})",
+           R"({"k1": "v", "k2": [{"x": 1}, {"y": [true]}], "k3": -0.5e-3})",
+       }) {
+    lazy_document doc(s);
+    EXPECT_EQ(folly::parseJson(s), walk(doc.root())) << s;
+    EXPECT_EQ(folly::parseJson(s), doc.root().toDynamic()) << s;
+  }
+}
+
+TEST(JsonLazyView, DuplicateKeys) {
+  folly::json::serialization_opts opts;
+  opts.allow_trailing_comma = true;
+  for (StringPiece s : {
+           R"({"a": 1, "a": 2, "b": 3, "a": 4})",
+           R"({"a": {"a": 1}, "b": [{"a": 2}], "a": [3], "c": 4})",
+           R"({"a": 1, "a": 2, "b": {}})",
+           R"({"a": 1, "b": 2, "a": 3,})",
+           R"({"b": {"a": 1, "a": 2}})",
+           R"({"a": 1, "\u0061": 2})",
+       }) {
+    lazy_document doc(s, opts);
+    auto expected = folly::parseJson(s, opts);
+    for (auto key : {"a", "b", "c"}) {
+      auto actual = doc.root().get_ptr(key);
+      ASSERT_EQ(expected.count(key) != 0, actual.has_value()) << s << key;
+      if (actual) {
+        EXPECT_EQ(expected[key], actual->toDynamic()) << s << key;
+      }
+    }
+  }
+  lazy_document doc(R"({"x": {"y": 1, "y": 2}, "x": {"y": 3, "y": 4}})");
+  EXPECT_EQ(4, doc.root().get_ptr(json_pointer::parse("/x/y"))->getInt());
+}
+
+TEST(JsonLazyView, StructureErrors) {
+  for (StringPiece s : {
+           "",
+           " ",
+           "[",
+           "]",
+           "[1,]",
+           "[,]",
+           "[1 2]",
+           "[1,,2]",
+           "{",
+           "{\"a\"}",
+           "{\"a\":}",
+           "{\"a\" 1}",
+           "{1: 2}",
+           "{\"a\": 1,}",
+           "{\"a\": 1]",
+           "[1}",
+           "\"unterminated",
+           "[\"unterminated]",
+           "1 2",
+           "{} x",
+           "[]]",
+       }) {
+    EXPECT_THROW(lazy_document{s}, parse_error) << s;
+  }
+
+  folly::json::serialization_opts opts;
+  opts.allow_trailing_comma = true;
+  EXPECT_EQ(2, lazy_document("[1, 2,]", opts).root().size());
+  EXPECT_EQ(1, lazy_document(R"({"a": 1,})", opts).root().size());
+  EXPECT_THROW(lazy_document("[,]", opts), parse_error);
+
+  opts = {};
+  opts.recursion_limit = 3;
+  EXPECT_NO_THROW(lazy_document("[[[1]]]", opts));
+  EXPECT_NO_THROW(lazy_document("[[[[]]]]", opts));
+  EXPECT_THROW(lazy_document("[[[[1]]]]", opts), parse_error);
+
+  try {
+    lazy_document("{\n\"a\": 1\n\"b\": 2}");
+    ADD_FAILURE();
+  } catch (parse_error const& e) {
+    EXPECT_NE(std::string(e.what()).find("line 2"), std::string::npos)
+        << e.what();
+  }
+}
+
+TEST(JsonLazyView, ValueErrors) {
+  // Malformed scalars are only reported when read.
+  lazy_document doc(R"({"ok": 1, "bad": tru, "num": 12ab, "str": "\q"})");
+  auto root = doc.root();
+  EXPECT_EQ(1, root.at("ok").getInt());
+  EXPECT_THROW(root.at("bad").type(), parse_error);
+  EXPECT_THROW(root.at("num").getInt(), parse_error);
+  EXPECT_THROW(root.at("str").getString(), parse_error);
+  EXPECT_FALSE(root.at("str").stringEquals("q"));
+  EXPECT_THROW(root.toDynamic(), parse_error);
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json_stream_parser.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using folly::dynamic;
+using folly::IOBuf;
+using folly::StringPiece;
+using folly::json::dynamic_builder;
+using folly::json::parse_error;
+using folly::json::serialization_opts;
+using folly::json::stream_parser;
+
+namespace {
+
+// Parses s fed in fragments of the given size.
+dynamic parseInFragments(
+    StringPiece s, size_t fragmentSize, serialization_opts const& opts = {}) {
+  dynamic_builder builder(opts.validate_keys || opts.convert_int_keys);
+  stream_parser parser(builder, opts);
+  while (!s.empty()) {
+    auto n = std::min(fragmentSize, s.size());
+    // Copy each fragment so that reads past its end are caught by ASAN.
+    std::string fragment(s.subpiece(0, n));
+    parser.feed(StringPiece(fragment));
+    s.advance(n);
+  }
+  parser.finish();
+  return std::move(builder.result());
+}
+
+// Like ==, but NaN equals NaN.
+bool sameValue(dynamic const& a, dynamic const& b) {
+  if (a.type() != b.type()) {
+    return false;
+  }
+  if (a.isDouble()) {
+    return a.asDouble() == b.asDouble() ||
+        (std::isnan(a.asDouble()) && std::isnan(b.asDouble()));
+  }
+  if (a.isArray()) {
+    return a.size() == b.size() &&
+        std::equal(a.begin(), a.end(), b.begin(), sameValue);
+  }
+  if (a.isObject()) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (auto const& [key, value] : a.items()) {
+      auto other = b.get_ptr(key);
+      if (!other || !sameValue(value, *other)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return a == b;
+}
+
+// Parses s as a chain of buffers of 3 bytes.
+dynamic parseChain(StringPiece s, serialization_opts const& opts) {
+  auto chain = IOBuf::create(0);
+  for (size_t i = 0; i < s.size(); i += 3) {
+    chain->appendToChain(IOBuf::copyBuffer(s.subpiece(i, 3)));
+  }
+  return folly::parseJson(*chain, opts);
+}
+
+void expectSameAsParseJson(StringPiece s, serialization_opts const& opts = {}) {
+  dynamic expected;
+  try {
+    expected = folly::parseJson(s, opts);
+  } catch (std::exception const&) {
+    for (size_t n : {1, 2, 3, 7, 64}) {
+      EXPECT_THROW(parseInFragments(s, n, opts), parse_error) << s << " " << n;
+    }
+    EXPECT_THROW(parseChain(s, opts), parse_error) << s;
+    return;
+  }
+  auto const expectEq = [&](dynamic const& actual, size_t n) {
+    EXPECT_TRUE(sameValue(expected, actual)) << s << " " << n;
+  };
+  SCOPED_TRACE(s);
+  for (size_t n : {1, 2, 3, 7, 64}) {
+    expectEq(parseInFragments(s, n, opts), n);
+  }
+  expectEq(parseChain(s, opts), 3);
+}
+
+// Records the events as a string.
+class recorder : public folly::json::event_handler {
+ public:
+  void on_null() override { out += "n "; }
+  void on_bool(bool v) override { out += v ? "t " : "f "; }
+  void on_int(int64_t v) override { out += folly::to<std::string>(v, ' '); }
+  void on_double(double v) override {
+    out += folly::to<std::string>(v, ' ');
+  }
+  void on_string(StringPiece v) override {
+    out += folly::to<std::string>('"', v, "\" ");
+  }
+  void on_begin_array() override { out += "[ "; }
+  void on_end_array() override { out += "] "; }
+  void on_begin_object() override { out += "{ "; }
+  void on_key(StringPiece k) override {
+    out += folly::to<std::string>(k, ": ");
+  }
+  void on_end_object() override { out += "} "; }
+
+  std::string out;
+};
+
+} // namespace
+
+TEST(JsonStreamParser, Events) {
+  recorder rec;
+  stream_parser parser(rec);
+  parser.feed(StringPiece(R"({"a": [1, 2.5, "x\ty"], "b": {"c)"));
+  EXPECT_EQ("{ a: [ 1 2.5 \"x\ty\" ] b: { ", rec.out);
+  EXPECT_FALSE(parser.done());
+  parser.feed(StringPiece(R"(": null}, "d": [true, fal)"));
+  EXPECT_EQ("{ a: [ 1 2.5 \"x\ty\" ] b: { c: n } d: [ t ", rec.out);
+  parser.feed(StringPiece("se]}  \n"));
+  EXPECT_TRUE(parser.done());
+  parser.finish();
+  EXPECT_EQ("{ a: [ 1 2.5 \"x\ty\" ] b: { c: n } d: [ t f ] } ", rec.out);
+}
+
+TEST(JsonStreamParser, SameAsParseJson) {
+  using namespace std::string_literals;
+  for (auto const& s : {
+           "1"s,
+           " -12 "s,
+           "-"s,
+           "1.5e-3"s,
+           "1e5"s,
+           "1.5x"s,
+           "12ab"s,
+           "0x10"s,
+           "true"s,
+           "truex"s,
+           "null"s,
+           "NaN"s,
+           "-Infinity"s,
+           "9223372036854775807"s,
+           "-9223372036854775808"s,
+           R"("")"s,
+           R"("a\"b\\c\/d\b\f\n\r\t")"s,
+           R"("é♥😀")"s,
+           R"("♥ 😀")"s,
+           R"("\ud83d")"s,
+           R"("\ude00")"s,
+           R"("\u12g4")"s,
+           R"("\q")"s,
+           R"("unterminated)"s,
+           "[]"s,
+           "[1,2,3]"s,
+           "[1,,2]"s,
+           "[1,2,]"s,
+           "[,]"s,
+           "[1 2]"s,
+           "["s,
+           "]"s,
+           "{}"s,
+           R"({"a":1,"b":[true,false,null],"c":{"d":"e"}})"s,
+           R"({ "a" : 1 , "b" : [ ] })"s,
+           R"({"a":1,})"s,
+           R"({"a" 1})"s,
+           R"({"a":})"s,
+           R"({1:2})"s,
+           R"({"a":1,"a":2})"s,
+           R"({"a":1}})"s,
+           R"({"a":1} x)"s,
+           R"({"a":1] )"s,
+           R"([1} )"s,
+           R"([[[[[[[[[[]]]]]]]]]])"s,
+       }) {
+    expectSameAsParseJson(s);
+  }
+}
+
+TEST(JsonStreamParser, Options) {
+  serialization_opts opts;
+  opts.allow_trailing_comma = true;
+  expectSameAsParseJson("[1,2,]", opts);
+  expectSameAsParseJson(R"({"a":1,})", opts);
+  expectSameAsParseJson("[,]", opts);
+
+  opts = {};
+  opts.double_fallback = true;
+  expectSameAsParseJson("[9223372036854775808, -9223372036854775809]", opts);
+  opts.double_fallback = false;
+  EXPECT_THROW(parseInFragments("9223372036854775808", 4, opts), parse_error);
+
+  opts = {};
+  opts.recursion_limit = 3;
+  expectSameAsParseJson("[[[1]]]", opts);
+  expectSameAsParseJson("[[[[]]]]", opts);
+  expectSameAsParseJson("[[[[1]]]]", opts);
+}
+
+TEST(JsonStreamParser, OptionsSameAsParseJson) {
+  using namespace std::string_literals;
+  std::vector<serialization_opts> optionSets(9);
+  optionSets[1].allow_trailing_comma = true;
+  optionSets[2].double_fallback = true;
+  optionSets[3].parse_numbers_as_strings = true;
+  optionSets[4].convert_int_keys = true;
+  optionSets[5].validate_keys = true;
+  // These only apply to serialization, also in parseJson.
+  optionSets[6].validate_utf8 = true;
+  optionSets[7].allow_nan_inf = true;
+  optionSets[8].parse_numbers_as_strings = true;
+  optionSets[8].convert_int_keys = true;
+
+  for (auto const& opts : optionSets) {
+    for (auto const& s : {
+             "[1,-2,3.5,1e5,-0.5E+3]"s,
+             "[1.,1e,1e+,1.2.3]"s,
+             "1."s,
+             "1e"s,
+             ".5"s,
+             "[01,-007]"s,
+             "123456789012345678901234"s,
+             "[NaN,Infinity,-Infinity]"s,
+             "[nan,inf]"s,
+             R"({"a":1,"a":2})"s,
+             R"({"1":2,1:3})"s,
+             R"({1:2,-3:4,007:5})"s,
+             R"({1.5:2})"s,
+             R"({1e3:2})"s,
+             R"({true:1})"s,
+             R"({null:1})"s,
+             R"({NaN:1})"s,
+             R"({123456789012345678901234:1})"s,
+             R"({[1]:2})"s,
+             R"({"a":1,})"s,
+             "[1,2,]"s,
+             "\"\xff\xfe\""s,
+             "1\0"s,
+             "1 \0 garbage"s,
+             "{}\0{]"s,
+             "[1]\0\0"s,
+             "\0"s,
+             " \0"s,
+             "[\0]"s,
+             "[1\0]"s,
+             "{\"a\":1\0}"s,
+         }) {
+      expectSameAsParseJson(s, opts);
+    }
+  }
+}
+
+TEST(JsonStreamParser, NullByteInString) {
+  using namespace std::string_literals;
+  for (auto const& s : {
+           "\"a\0b\""s,
+           "{\"a\0\":1}"s,
+           "[\"\0\"]"s,
+       }) {
+    // parseJson keeps them, the stream parser does not.
+    EXPECT_NO_THROW(folly::parseJson(s)) << s;
+    for (size_t n : {1, 2, 3, 7, 64}) {
+      EXPECT_THROW(parseInFragments(s, n), parse_error) << s << " " << n;
+    }
+    EXPECT_THROW(parseChain(s, {}), parse_error) << s;
+  }
+}
+
+TEST(JsonStreamParser, UnsupportedOptions) {
+  dynamic_builder builder;
+  serialization_opts opts;
+  opts.allow_non_string_keys = true;
+  EXPECT_THROW(stream_parser(builder, opts), std::invalid_argument);
+  EXPECT_THROW(parseChain("{}", opts), std::invalid_argument);
+}
+
+TEST(JsonStreamParser, RandomFragments) {
+  std::string doc = "[";
+  for (int i = 0; i != 200; ++i) {
+    doc += folly::to<std::string>(
+        i ? "," : "",
+        R"({"id":)",
+        i,
+        R"(,"name":"item \")",
+        i,
+        R"(\" é","tags":["a","bé",true,null],"score":)",
+        i * 0.25,
+        "}\n");
+  }
+  doc += "]";
+  auto expected = folly::parseJson(doc);
+
+  std::mt19937 rng(42);
+  for (int iter = 0; iter != 20; ++iter) {
+    // Build a chain of random-sized buffers.
+    std::unique_ptr<IOBuf> chain;
+    for (size_t pos = 0; pos < doc.size();) {
+      auto n = std::min<size_t>(
+          doc.size() - pos, std::uniform_int_distribution<size_t>(1, 40)(rng));
+      auto buf = IOBuf::copyBuffer(doc.data() + pos, n);
+      if (chain) {
+        chain->appendToChain(std::move(buf));
+      } else {
+        chain = std::move(buf);
+      }
+      pos += n;
+    }
+    EXPECT_EQ(expected, folly::parseJson(*chain));
+
+    dynamic_builder builder;
+    stream_parser parser(builder);
+    parser.feed(folly::io::Cursor(chain.get()));
+    parser.finish();
+    EXPECT_EQ(expected, builder.result());
+  }
+}
+
+TEST(JsonStreamParser, FinishAndReset) {
+  dynamic_builder builder;
+  stream_parser parser(builder);
+  parser.feed(StringPiece("[1, 2"));
+  EXPECT_THROW(parser.finish(), parse_error);
+
+  parser.reset();
+  builder.reset();
+  parser.feed(StringPiece("12"));
+  EXPECT_FALSE(parser.done());
+  parser.feed(StringPiece("34"));
+  parser.finish();
+  EXPECT_TRUE(parser.done());
+  EXPECT_EQ(1234, builder.result());
+
+  parser.reset();
+  builder.reset();
+  parser.feed(StringPiece("\"abc"));
+  EXPECT_THROW(parser.finish(), parse_error);
+}
+
+TEST(JsonStreamParser, ErrorLineNumbers) {
+  try {
+    parseInFragments("{\n\"a\": 1,\n\"b\": 2,\n}", 3);
+    ADD_FAILURE();
+  } catch (parse_error const& e) {
+    EXPECT_NE(std::string(e.what()).find("line 3"), std::string::npos)
+        << e.what();
+  }
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/detail/JsonStructuralIndex.h>
+#include <folly/json/detail/JsonStructuralIndexImpl.h>
+
+#include <random>
+
+#include <folly/json/json.h>
+#include <folly/portability/GTest.h>
+
+namespace folly {
+namespace json {
+namespace detail {
+
+namespace {
+
+// Byte at a time version of the index, to compare the kernels against.
+// Like the kernels, a backslash escapes the next byte even outside of strings;
+// that only matters for documents that are invalid anyway.
+std::vector<std::uint32_t> referenceIndex(StringPiece s) {
+  std::vector<bool> escaped(s.size(), false);
+  for (std::size_t i = 0; i + 1 < s.size(); ++i) {
+    if (s[i] == '\\' && !escaped[i]) {
+      escaped[i + 1] = true;
+    }
+  }
+
+  std::vector<std::uint32_t> res;
+  bool inString = false;
+  bool inScalar = false;
+  for (std::uint32_t i = 0; i != s.size(); ++i) {
+    char c = s[i];
+    if (c == '"' && !escaped[i]) {
+      res.push_back(i);
+      inString = !inString;
+      inScalar = false;
+      continue;
+    }
+    if (inString) {
+      continue;
+    }
+    switch (c) {
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+        res.push_back(i);
+        inScalar = false;
+        break;
+      case '"':
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        inScalar = false;
+        break;
+      default:
+        if (!inScalar) {
+          res.push_back(i);
+        }
+        inScalar = true;
+        break;
+    }
+  }
+  return res;
+}
+
+template <typename Platform>
+std::vector<std::uint32_t> platformIndex(StringPiece s) {
+  std::vector<std::uint32_t> res;
+  buildJsonStructuralIndexImpl<Platform>(s, res);
+  return res;
+}
+
+template <typename Platform>
+void testPlatform(StringPiece s) {
+  ASSERT_EQ(referenceIndex(s), platformIndex<Platform>(s)) << s;
+}
+
+void testAllPlatforms(StringPiece s) {
+  ASSERT_NO_FATAL_FAILURE(testPlatform<void>(s));
+#if FOLLY_X64 && FOLLY_SSE_PREREQ(4, 2)
+  ASSERT_NO_FATAL_FAILURE(
+      testPlatform<simd::detail::SimdSse42Platform<std::uint8_t>>(s));
+#if defined(__AVX2__)
+  ASSERT_NO_FATAL_FAILURE(
+      testPlatform<simd::detail::SimdAvx2Platform<std::uint8_t>>(s));
+#endif
+#endif
+#if FOLLY_AARCH64
+  ASSERT_NO_FATAL_FAILURE(
+      testPlatform<simd::detail::SimdAarch64Platform<std::uint8_t>>(s));
+#endif
+  std::vector<std::uint32_t> res;
+  buildJsonStructuralIndex(s, res);
+  ASSERT_EQ(referenceIndex(s), res) << s;
+}
+
+} // namespace
+
+TEST(JsonStructuralIndexTest, Basic) {
+  using idx = std::vector<std::uint32_t>;
+  ASSERT_EQ(platformIndex<void>(""), idx{});
+  ASSERT_EQ(platformIndex<void>("  "), idx{});
+  ASSERT_EQ(platformIndex<void>("{}"), (idx{0, 1}));
+  ASSERT_EQ(platformIndex<void>(R"({"a": 12})"), (idx{0, 1, 3, 4, 6, 8}));
+  ASSERT_EQ(platformIndex<void>(R"(["a,b", true])"), (idx{0, 1, 5, 6, 8, 12}));
+  ASSERT_EQ(platformIndex<void>(R"("a\"b")"), (idx{0, 5}));
+  ASSERT_EQ(platformIndex<void>(R"("a\\" 1)"), (idx{0, 4, 6}));
+  ASSERT_EQ(platformIndex<void>(R"("{[:,]}")"), (idx{0, 7}));
+}
+
+TEST(JsonStructuralIndexTest, BlockBoundaries) {
+  // Put every interesting construct across the 16/32/64 byte boundaries.
+  for (std::size_t pad = 0; pad != 130; ++pad) {
+    std::string prefix(pad, ' ');
+    ASSERT_NO_FATAL_FAILURE(testAllPlatforms(prefix + R"(["a\"b", 1.5e3])"));
+    ASSERT_NO_FATAL_FAILURE(testAllPlatforms(prefix + R"({"k\\":null})"));
+    ASSERT_NO_FATAL_FAILURE(testAllPlatforms(prefix + R"("\\\\\"\\" true)"));
+    ASSERT_NO_FATAL_FAILURE(
+        testAllPlatforms("\"" + prefix + R"(\"", -123456789012345)"));
+    ASSERT_NO_FATAL_FAILURE(testAllPlatforms(prefix + "\"unterminated"));
+  }
+}
+
+TEST(JsonStructuralIndexTest, Random) {
+  std::mt19937 rng(12345);
+  static constexpr StringPiece kAlphabet = "{}[]:,\" \t\n\r\\\\\\ab1-.e\0\xff";
+  for (int i = 0; i != 2000; ++i) {
+    std::string s(std::uniform_int_distribution<std::size_t>(0, 300)(rng), ' ');
+    for (auto& c : s) {
+      c = kAlphabet[std::uniform_int_distribution<std::size_t>(
+          0, kAlphabet.size() - 1)(rng)];
+    }
+    ASSERT_NO_FATAL_FAILURE(testAllPlatforms(s));
+  }
+}
+
+} // namespace detail
+} // namespace json
+
+namespace {
+
+void expectSameParse(StringPiece s, json::serialization_opts const& opts) {
+  dynamic expected;
+  try {
+    expected = parseJson(s, opts);
+  } catch (std::exception const&) {
+    EXPECT_ANY_THROW(parseJsonIndexed(s, opts)) << s;
+    return;
+  }
+  dynamic actual;
+  EXPECT_NO_THROW(actual = parseJsonIndexed(s, opts)) << s;
+  if (expected.isDouble() && std::isnan(expected.asDouble())) {
+    EXPECT_TRUE(actual.isDouble() && std::isnan(actual.asDouble())) << s;
+  } else {
+    EXPECT_EQ(expected, actual) << s;
+  }
+}
+
+void expectSameParse(StringPiece s) {
+  expectSameParse(s, json::serialization_opts());
+}
+
+} // namespace
+
+TEST(JsonIndexedTest, SameAsParseJson) {
+  using namespace std::string_literals;
+  for (auto const& s : {
+           ""s,
+           "   "s,
+           "1"s,
+           " 1 "s,
+           "-0"s,
+           "-"s,
+           "1.5e-3"s,
+           "1e5"s,
+           "12ab"s,
+           "true"s,
+           "truex"s,
+           "null"s,
+           "false"s,
+           "NaN"s,
+           "Infinity"s,
+           "-Infinity"s,
+           "9223372036854775807"s,
+           "9223372036854775808"s,
+           R"("")"s,
+           R"("abc")"s,
+           R"("a\"b\\c\/d\b\f\n\r\t")"s,
+           R"("♥ 😀")"s,
+           R"("\ud83d")"s,
+           R"("\q")"s,
+           R"("unterminated)"s,
+           R"("a)"
+           "\0"
+           R"(b")"s,
+           "[]"s,
+           "[ ]"s,
+           "[1,2,3]"s,
+           "[1,,2]"s,
+           "[1,2,]"s,
+           "[1 2]"s,
+           "["s,
+           "]"s,
+           "{}"s,
+           R"({"a":1,"b":[true,false,null],"c":{"d":"e"}})"s,
+           R"({ "a" : 1 , "b" : [ ] })"s,
+           R"({"a":1,})"s,
+           R"({"a" 1})"s,
+           R"({"a":})"s,
+           R"({1:2})"s,
+           R"({"a":1,"a":2})"s,
+           R"({"a":1}}")"s,
+           R"({"a":1} x)"s,
+           "{}\0trailing"s,
+           "1\0trailing"s,
+           "1\0{"s,
+           "\"a\" \0x"s,
+           R"([1, "x" 2])"s,
+           R"([[[[[[[[[[]]]]]]]]]])"s,
+       }) {
+    expectSameParse(s);
+  }
+}
+
+TEST(JsonIndexedTest, Options) {
+  json::serialization_opts opts;
+  opts.allow_trailing_comma = true;
+  expectSameParse("[1,2,]", opts);
+  expectSameParse(R"({"a":1,})", opts);
+  expectSameParse("[,]", opts);
+
+  opts = {};
+  opts.allow_non_string_keys = true;
+  expectSameParse("{1:2, true:false, null:[1], [1]:{}}", opts);
+
+  opts = {};
+  opts.convert_int_keys = true;
+  expectSameParse(R"({1:2, "3":4})", opts);
+  expectSameParse(R"({1:2, "1":4})", opts);
+
+  opts = {};
+  opts.validate_keys = true;
+  expectSameParse(R"({"a":1,"a":2})", opts);
+
+  opts = {};
+  opts.parse_numbers_as_strings = true;
+  expectSameParse("[1, -2.5e3, NaN, -Infinity]", opts);
+
+  opts = {};
+  opts.double_fallback = true;
+  expectSameParse("[9223372036854775808, -9223372036854775809]", opts);
+
+  opts = {};
+  opts.recursion_limit = 3;
+  expectSameParse("[[[1]]]", opts);
+  expectSameParse("[[[[[1]]]]]", opts);
+}
+
+TEST(JsonIndexedTest, LargeDocument) {
+  std::string doc = "[";
+  for (int i = 0; i != 1000; ++i) {
+    doc += to<std::string>(
+        i ? "," : "",
+        R"({"id":)",
+        i,
+        R"(,"name":"item \")",
+        i,
+        R"(\"","tags":["a","bé"],"score":)",
+        i * 0.25,
+        "}\n");
+  }
+  doc += "]";
+  expectSameParse(doc);
+}
+
+TEST(JsonIndexedTest, ErrorLineNumbers) {
+  try {
+    parseJsonIndexed("{\n\"a\": 1,\n\"b\": tru\n}");
+    ADD_FAILURE();
+  } catch (json::parse_error const& e) {
+    EXPECT_NE(std::string(e.what()).find("line 2"), std::string::npos)
+        << e.what();
+  }
+}
+
+} // namespace folly
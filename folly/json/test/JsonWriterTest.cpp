@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json_iobuf_writer.h>
+
+#include <random>
+
+#include <folly/Format.h>
+#include <folly/portability/GTest.h>
+
+using folly::dynamic;
+using folly::IOBufQueue;
+using folly::StringPiece;
+using folly::json::serialization_opts;
+
+namespace {
+
+// The escaping of the default options, a byte at a time.
+std::string naiveEscape(StringPiece s) {
+  std::string ret = "\"";
+  for (char c : s) {
+    switch (c) {
+        // clang-format off
+      case '"':  ret += "\\\""; break;
+      case '\\': ret += "\\\\"; break;
+      case '\b': ret += "\\b";  break;
+      case '\f': ret += "\\f";  break;
+      case '\n': ret += "\\n";  break;
+      case '\r': ret += "\\r";  break;
+      case '\t': ret += "\\t";  break;
+      // clang-format on
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          ret += folly::sformat("\\u{:04x}", int(c));
+        } else {
+          ret += c;
+        }
+    }
+  }
+  return ret + "\"";
+}
+
+std::string serializeToQueue(
+    dynamic const& dyn, serialization_opts const& opts) {
+  IOBufQueue queue{IOBufQueue::cacheChainLength()};
+  folly::json::serialize(dyn, opts, queue);
+  return queue.move()->moveToFbString().toStdString();
+}
+
+dynamic makeDocument(int size = 50) {
+  dynamic doc = dynamic::array;
+  for (int i = 0; i != size; ++i) {
+    dynamic item = dynamic::object;
+    item["id"] = i;
+    item["name"] = folly::to<std::string>("item ", i);
+    item["tags"] = dynamic::array("a", "b", true, nullptr, -i);
+    item["nested"] = dynamic::object("x", dynamic::array())("y", 0);
+    doc.push_back(std::move(item));
+  }
+  return doc;
+}
+
+} // namespace
+
+TEST(JsonWriter, EscapeRandomStrings) {
+  // Escapable bytes at every offset of strings of every length around the
+  // vector and word sizes.
+  std::string const alphabet = std::string("abc \"\\\n\t\x01\x1f\x7f", 12) +
+      "\xc3\xa9\xe2\x99\xa5\xf0\x9f\x98\x80";
+  std::mt19937 rng(42);
+  serialization_opts opts;
+  for (int iter = 0; iter != 2000; ++iter) {
+    std::string s;
+    auto size = std::uniform_int_distribution<size_t>(0, 100)(rng);
+    auto escapes = std::uniform_int_distribution<int>(0, 3)(rng);
+    for (size_t i = 0; i != size; ++i) {
+      s += alphabet[std::uniform_int_distribution<size_t>(
+          0, escapes ? alphabet.size() - 1 : 3)(rng)];
+    }
+    std::string out;
+    folly::json::escapeString(s, out, opts);
+    EXPECT_EQ(naiveEscape(s), out);
+    EXPECT_EQ(s, folly::parseJson(out).asString());
+  }
+}
+
+TEST(JsonWriter, EscapeOptions) {
+  std::string s = "0123456789abcdef\"é\n0123456789abcdef♥0123456789abcdef😀";
+  serialization_opts opts;
+  opts.encode_non_ascii = true;
+  EXPECT_EQ(
+      R"("0123456789abcdef\"\u00e9\n0123456789abcdef\u2665)"
+      R"(0123456789abcdef\ud83d\ude00")",
+      folly::json::serialize(s, opts));
+
+  opts = {};
+  opts.validate_utf8 = true;
+  EXPECT_EQ(naiveEscape(s), folly::json::serialize(s, opts));
+  EXPECT_THROW(
+      folly::json::serialize("0123456789abcdef0123\xff", opts),
+      std::runtime_error);
+
+  opts = {};
+  opts.extra_ascii_to_escape_bitmap =
+      folly::json::buildExtraAsciiToEscapeBitmap("d");
+  EXPECT_EQ(
+      R"("abc\u0064efghijklmnopqrstuvwxyzabc\u0064")",
+      folly::json::serialize("abcdefghijklmnopqrstuvwxyzabcd", opts));
+}
+
+TEST(JsonWriter, EstimateSize) {
+  auto doc = makeDocument(10);
+  doc.push_back(dynamic::object(1, "int key"));
+  auto large = makeDocument(1000);
+  for (bool pretty : {false, true}) {
+    serialization_opts opts;
+    opts.pretty_formatting = pretty;
+    opts.convert_int_keys = true;
+    EXPECT_EQ(
+        folly::json::serialize(doc, opts).size(),
+        folly::json::estimateSerializedSize(doc, opts));
+
+    // Only the first elements are measured.
+    auto size = folly::json::serialize(large, opts).size();
+    auto estimate = folly::json::estimateSerializedSize(large, opts);
+    EXPECT_LE(estimate, size);
+    EXPECT_GE(estimate, folly::json::serialize(makeDocument(16), opts).size());
+  }
+  EXPECT_EQ(2, folly::json::estimateSerializedSize(dynamic::array, {}));
+  EXPECT_EQ(
+      folly::json::serialize(-1234, {}).size(),
+      folly::json::estimateSerializedSize(-1234, {}));
+}
+
+TEST(JsonWriter, EstimateSizeSkewed) {
+  // Large elements first must not be extrapolated to the rest.
+  dynamic doc = dynamic::array;
+  for (int i = 0; i < 16; ++i) {
+    doc.push_back(std::string(1 << 20, 'x'));
+  }
+  dynamic nulls = dynamic::array;
+  for (int i = 0; i < 1000000; ++i) {
+    nulls.push_back(nullptr);
+  }
+  doc.push_back(std::move(nulls));
+  dynamic nested = dynamic::array(doc, doc);
+
+  for (auto const& d : {doc, nested}) {
+    auto json = folly::json::serialize(d, {});
+    EXPECT_LE(folly::json::estimateSerializedSize(d, {}), json.size());
+
+    IOBufQueue queue;
+    folly::json::serialize(d, {}, queue);
+    EXPECT_EQ(json, queue.move()->toString());
+  }
+}
+
+TEST(JsonWriter, IOBufQueue) {
+  auto doc = makeDocument();
+  doc.push_back(1.5);
+  doc.push_back("needs \"escaping\"\n");
+  for (bool pretty : {false, true}) {
+    serialization_opts opts;
+    opts.pretty_formatting = pretty;
+    opts.sort_keys = true;
+    EXPECT_EQ(folly::json::serialize(doc, opts), serializeToQueue(doc, opts));
+  }
+  EXPECT_EQ("null", serializeToQueue(nullptr, {}));
+}
+
+TEST(JsonWriter, IOBufWriterMultipleDocuments) {
+  auto doc = makeDocument();
+  doc.push_back("longer \"once escaped\"");
+  auto expected = folly::toJson(doc);
+
+  IOBufQueue queue{IOBufQueue::cacheChainLength()};
+  {
+    folly::json::iobuf_writer out(queue, 16);
+    folly::json::serialize(doc, {}, out);
+    out.push_back('\n');
+    folly::json::serialize(doc, {}, out);
+    out.flush();
+    EXPECT_EQ(2 * expected.size() + 1, queue.chainLength());
+    out.push_back('\n');
+  }
+  EXPECT_EQ(2 * expected.size() + 2, queue.chainLength());
+  auto text = queue.move()->moveToFbString().toStdString();
+  EXPECT_EQ(expected + "\n" + expected + "\n", text);
+}
+
+TEST(JsonWriter, Errors) {
+  serialization_opts opts;
+  auto doc = dynamic::array(1, 2, dynamic::object("a", NAN));
+  EXPECT_THROW(serializeToQueue(doc, opts), folly::json::print_error);
+  opts.allow_nan_inf = true;
+  EXPECT_EQ("[1,2,{\"a\":NaN}]", serializeToQueue(doc, opts));
+}
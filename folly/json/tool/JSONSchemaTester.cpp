@@ -14,12 +14,17 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <sstream>
 #include <string>
 
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
 #include <folly/json/JSONSchema.h>
 #include <folly/json/json.h>
+#include <folly/portability/GFlags.h>
 
 /**
  * A binary that supports testing against the official tests from:
@@ -27,9 +32,73 @@
  *
  * Use it like:
  *   ./jsonschema_tester /path/to/test.json
+ *
+ * With --benchmark_iterations=N, it also compiles each schema and validates
+ * each test N times, and prints the average times per file:
+ *   ./jsonschema_tester --benchmark_iterations=10000 /path/to/tests/<file>.json
  */
 
+DEFINE_int32(
+    benchmark_iterations,
+    0,
+    "How many times to compile each schema and validate each test, to time "
+    "them. 0 to only run the tests.");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double nanosPerIteration(Clock::duration elapsed, size_t iterations) {
+  return double(std::chrono::nanoseconds(elapsed).count()) /
+      double(std::max<size_t>(iterations, 1));
+}
+
+void benchmark(const folly::dynamic& d) {
+  const size_t iterations = FLAGS_benchmark_iterations;
+  Clock::duration compile{};
+  Clock::duration valid{};
+  Clock::duration invalid{};
+  size_t schemas = 0;
+  size_t validTests = 0;
+  size_t invalidTests = 0;
+  for (const auto& item : d) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      folly::doNotOptimizeAway(
+          folly::jsonschema::makeValidator(item["schema"]));
+    }
+    compile += Clock::now() - start;
+    ++schemas;
+
+    auto v = folly::jsonschema::makeValidator(item["schema"]);
+    for (const auto& t : item["tests"]) {
+      const auto& data = t["data"];
+      start = Clock::now();
+      for (size_t i = 0; i < iterations; ++i) {
+        folly::doNotOptimizeAway(v->try_validate(data));
+      }
+      auto elapsed = Clock::now() - start;
+      if (t["valid"].asBool()) {
+        valid += elapsed;
+        ++validTests;
+      } else {
+        invalid += elapsed;
+        ++invalidTests;
+      }
+    }
+  }
+  printf(
+      "BENCHMARK: %.0fns per schema compiled, %.0fns per valid test, "
+      "%.0fns per invalid test\n",
+      nanosPerIteration(compile, schemas * iterations),
+      nanosPerIteration(valid, validTests * iterations),
+      nanosPerIteration(invalid, invalidTests * iterations));
+}
+
+} // namespace
+
 int main(int argc, char** argv) {
+  folly::Init init(&argc, &argv);
   if (argc < 2) {
     printf("Usage: %s <testfile> [testfile2]...\n", argv[0]);
     return -1;
@@ -54,5 +123,8 @@ int main(int argc, char** argv) {
         }
       }
     }
+    if (FLAGS_benchmark_iterations > 0) {
+      benchmark(d);
+    }
   }
 }
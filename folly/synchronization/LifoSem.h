@@ -400,13 +400,16 @@ struct LifoSemBase {
   /// guaranteeing exact saturation (similar to the cost of maintaining
   /// linearizability near the zero value, but without as much of
   /// a benefit).
-  void post(uint32_t n) {
+  /// Returns how many of the n posts were not handed off to a waiter, and
+  /// so went to the value of the semaphore instead.
+  uint32_t post(uint32_t n) {
     uint32_t idx;
     while (n > 0 && (idx = incrOrPop(n)) != 0) {
       // pop accounts for only 1
       idxToNode(idx).handoff().post();
       --n;
     }
+    return n;
   }
 
   /// Returns true iff shutdown() has been called
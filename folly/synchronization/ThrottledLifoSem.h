@@ -88,7 +88,12 @@ class ThrottledLifoSem {
   // Returns true if there are enough waiters to consume the updated value, even
   // though they may not be awoken immediately. Silently saturates if value is
   // already 2^32-1.
-  bool post(uint32_t n = 1) {
+  bool post() { return post(1) == 0; }
+
+  // Equivalent to n calls to post(). Returns how many of the n posts are not
+  // matched by a waiter, that is, by how much the updated value exceeds the
+  // number of waiters, up to n.
+  uint32_t post(uint32_t n) {
     uint32_t newValue;
     uint64_t oldState = state_.load(std::memory_order_relaxed);
     uint64_t newState;
@@ -110,7 +115,9 @@ class ThrottledLifoSem {
       maybeStartWakingChain();
     }
 
-    return newValue <= numWaiters;
+    return newValue <= numWaiters
+        ? 0
+        : static_cast<uint32_t>(std::min<uint64_t>(n, newValue - numWaiters));
   }
 
   bool try_wait() { return tryWaitImpl<DecrNumWaiters::Never>(); }
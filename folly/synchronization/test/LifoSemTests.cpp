@@ -48,6 +48,22 @@ TEST(LifoSem, basic) {
   sem.wait();
 }
 
+TEST(LifoSem, postN) {
+  LifoSem sem;
+  EXPECT_EQ(0, sem.post(0));
+  EXPECT_EQ(3, sem.post(3));
+  EXPECT_EQ(3, sem.valueGuess());
+  EXPECT_EQ(3, sem.tryWait(3));
+
+  std::thread waiter([&] { sem.wait(); });
+  /* sleep override */ std::this_thread::sleep_for(
+      std::chrono::milliseconds(10));
+  // at most one of the posts goes to the waiter, the rest to the value
+  EXPECT_LE(1, sem.post(2));
+  waiter.join();
+  EXPECT_EQ(1, sem.valueGuess());
+}
+
 TEST(LifoSem, multi) {
   LifoSem sem;
 
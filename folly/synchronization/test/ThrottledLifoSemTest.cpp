@@ -46,13 +46,29 @@ const auto kNoSpin =
 
 TEST(ThrottledLifoSem, Basic) {
   folly::ThrottledLifoSem sem;
-  EXPECT_TRUE(sem.post(0));
+  EXPECT_EQ(0, sem.post(0));
   EXPECT_FALSE(sem.post());
   EXPECT_TRUE(sem.try_wait());
   EXPECT_FALSE(sem.try_wait());
   EXPECT_FALSE(sem.try_wait_for(std::chrono::milliseconds(1)));
 }
 
+TEST(ThrottledLifoSem, PostN) {
+  folly::ThrottledLifoSem sem;
+  // without waiters, none of the posts are matched
+  EXPECT_EQ(3, sem.post(3));
+  EXPECT_EQ(3, sem.valueGuess());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(sem.try_wait());
+  }
+
+  std::thread waiter([&] { sem.wait(); });
+  folly::ThrottledLifoSemTestHelper::spinUntilWaiters(sem, 1);
+  // one of the posts is matched by the waiter
+  EXPECT_EQ(1, sem.post(2));
+  waiter.join();
+}
+
 TEST(ThrottledLifoSem, Timeouts) {
   constexpr auto kWakeUpInterval = std::chrono::milliseconds(200);
 
@@ -132,7 +148,7 @@ TEST(ThrottledLifoSem, MultipleWaiters) {
 
     // Use the batch post() for half the rounds.
     if (round % 2 == 0) {
-      EXPECT_TRUE(sem.post(kNumWaiters));
+      EXPECT_EQ(0, sem.post(kNumWaiters));
     } else {
       for (size_t i = 0; i < kNumWaiters; ++i) {
         EXPECT_TRUE(sem.post());
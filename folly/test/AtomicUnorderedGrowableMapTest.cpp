@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/AtomicUnorderedGrowableMap.h>
+
+#include <fcntl.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/AtomicUnorderedMap.h>
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+using namespace folly;
+
+namespace {
+
+using IntMap = AtomicUnorderedGrowableInsertMap<uint64_t, uint64_t>;
+
+File reopen(const test::TemporaryFile& file) {
+  return File(file.path().string(), O_RDWR);
+}
+
+} // namespace
+
+TEST(AtomicUnorderedGrowableInsertMap, basic) {
+  AtomicUnorderedGrowableInsertMap<std::string, std::string> m(100);
+
+  EXPECT_TRUE(m.cbegin() == m.cend());
+  EXPECT_TRUE(m.emplace("abc", "ABC").second);
+  EXPECT_FALSE(m.emplace("abc", "XYZ").second);
+  EXPECT_EQ(1, m.size());
+  EXPECT_TRUE(m.find("abc") != m.cend());
+  EXPECT_EQ(m.find("abc")->first, "abc");
+  EXPECT_EQ(m.find("abc")->second, "ABC");
+  EXPECT_TRUE(m.find("def") == m.cend());
+  auto iter = m.cbegin();
+  EXPECT_TRUE(iter != m.cend());
+  EXPECT_TRUE(iter == m.find("abc"));
+  auto a = iter++;
+  EXPECT_TRUE(iter == m.cend());
+  EXPECT_TRUE(a == m.find("abc"));
+
+  // long enough to need heap storage, which the destructor must free
+  m.emplace("a key that does not fit in the sso buffer", "and a value too");
+  size_t count = 0;
+  for (const auto& [key, value] : m) {
+    EXPECT_EQ(m.find(key)->second, value);
+    ++count;
+  }
+  EXPECT_EQ(2, count);
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, grows) {
+  IntMap m(1 << 16);
+  auto const initialBuckets = m.bucketCount();
+
+  for (uint64_t i = 0; i < 50000; ++i) {
+    auto pr = m.findOrConstruct(i, [&] { return i * 10; });
+    EXPECT_TRUE(pr.second);
+    EXPECT_EQ(i * 10, pr.first->second);
+  }
+  EXPECT_EQ(50000, m.size());
+  EXPECT_LT(initialBuckets, m.bucketCount());
+  EXPECT_LE(m.bucketCount(), 1 << 17);
+
+  for (uint64_t i = 0; i < 60000; ++i) {
+    auto iter = m.find(i);
+    if (i < 50000) {
+      ASSERT_TRUE(iter != m.cend());
+      EXPECT_EQ(i * 10, iter->second);
+    } else {
+      EXPECT_TRUE(iter == m.cend());
+    }
+  }
+
+  std::vector<bool> seen(50000);
+  for (const auto& [key, value] : m) {
+    EXPECT_FALSE(seen[key]);
+    seen[key] = true;
+  }
+  EXPECT_EQ(seen, std::vector<bool>(50000, true));
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, capacityExceeded) {
+  IntMap m(5000);
+
+  for (uint64_t i = 0; i < 5000; ++i) {
+    m.emplace(i, i);
+  }
+  EXPECT_THROW(m.emplace(5000, 0), std::bad_alloc);
+  EXPECT_EQ(5000, m.size());
+  EXPECT_FALSE(m.emplace(1, 0).second);
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, invalidOptions) {
+  EXPECT_THROW(IntMap(0), std::invalid_argument);
+  EXPECT_THROW(
+      IntMap(100, IntMap::Options().setCommitBytes(3000)),
+      std::invalid_argument);
+  EXPECT_THROW(
+      IntMap(100, IntMap::Options().setMaxLoadFactor(0)),
+      std::invalid_argument);
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, throwingConstructor) {
+  IntMap m(10);
+  EXPECT_THROW(
+      m.findOrConstruct(1, []() -> uint64_t { throw std::runtime_error(""); }),
+      std::runtime_error);
+  EXPECT_EQ(0, m.size());
+  EXPECT_TRUE(m.find(1) == m.cend());
+  EXPECT_TRUE(m.emplace(1, 1).second);
+  EXPECT_EQ(1, m.size());
+
+  // the slot of the failed insert was reused
+  for (uint64_t i = 2; i <= 10; ++i) {
+    EXPECT_TRUE(m.emplace(i, i).second);
+  }
+  EXPECT_EQ(10, m.size());
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, hugePages) {
+  IntMap m(1 << 20, IntMap::Options().setHugePages(true));
+  for (uint64_t i = 0; i < 100000; ++i) {
+    m.emplace(i * 7, i);
+  }
+  EXPECT_EQ(100000, m.size());
+  EXPECT_EQ(12345, m.find(12345 * 7)->second);
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, valueMutation) {
+  AtomicUnorderedGrowableInsertMap<int, MutableAtom<int>> m(100);
+
+  for (int i = 0; i < 50; ++i) {
+    m.emplace(i, i);
+  }
+
+  m.find(1)->second.data++;
+  EXPECT_EQ(2, m.find(1)->second.data.load());
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, concurrentInsert) {
+  constexpr uint64_t kKeys = 100000;
+  constexpr size_t kThreads = 8;
+  // a slot of headroom for the insert each thread may have in flight
+  AtomicUnorderedGrowableInsertMap<uint64_t, MutableAtom<uint64_t>> m(
+      kKeys + kThreads, decltype(m)::Options().setCommitBytes(4096));
+
+  // every thread inserts every key, in a different order
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (uint64_t i = 0; i < kKeys; ++i) {
+        auto key = (i * 7919 + t * 104729) % kKeys;
+        auto pr = m.emplace(key, 0);
+        pr.first->second.data.fetch_add(1);
+        ASSERT_EQ(key, pr.first->first);
+        if (i % 1000 == 0) {
+          ASSERT_TRUE(m.find(key) == pr.first);
+        }
+      }
+    });
+  }
+  for (auto& thr : threads) {
+    thr.join();
+  }
+
+  EXPECT_EQ(kKeys, m.size());
+  size_t count = 0;
+  for (const auto& [key, value] : m) {
+    EXPECT_EQ(kThreads, value.data.load()) << key;
+    ++count;
+  }
+  EXPECT_EQ(count, m.size());
+  for (uint64_t i = 0; i < kKeys; i += 97) {
+    EXPECT_EQ(i, m.find(i)->first);
+  }
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, persistent) {
+  test::TemporaryFile file;
+  auto const options = IntMap::Options().setCommitBytes(4096);
+
+  {
+    IntMap m(reopen(file), 100000, options);
+    for (uint64_t i = 0; i < 50000; ++i) {
+      m.emplace(i, i + 1);
+    }
+  }
+  {
+    IntMap m(reopen(file), 100000, options);
+    EXPECT_EQ(50000, m.size());
+    for (uint64_t i = 0; i < 50000; ++i) {
+      ASSERT_EQ(i + 1, m.find(i)->second);
+    }
+    EXPECT_FALSE(m.emplace(7, 0).second);
+    for (uint64_t i = 50000; i < 100000; ++i) {
+      m.emplace(i, i + 1);
+    }
+  }
+  {
+    IntMap m(reopen(file), 100000, options);
+    EXPECT_EQ(100000, m.size());
+    EXPECT_EQ(100000, m.find(99999)->second);
+    EXPECT_THROW(m.emplace(100000, 0), std::bad_alloc);
+  }
+
+  EXPECT_THROW(IntMap(reopen(file), 1000, options), std::invalid_argument);
+  EXPECT_THROW(IntMap(reopen(file), 100000), std::invalid_argument);
+  EXPECT_THROW(
+      (AtomicUnorderedGrowableInsertMap<uint64_t, uint32_t>(
+          reopen(file), 100000, options)),
+      std::invalid_argument);
+}
+
+TEST(AtomicUnorderedGrowableInsertMap, persistentRejectsOtherFiles) {
+  test::TemporaryFile file;
+  {
+    IntMap m(reopen(file), 100);
+    m.emplace(1, 1);
+  }
+  uint64_t const junk = 0;
+  ASSERT_EQ(sizeof(junk), ::pwrite(file.fd(), &junk, sizeof(junk), 0));
+  EXPECT_THROW(IntMap(reopen(file), 100), std::invalid_argument);
+}
+
+namespace {
+
+template <typename Map>
+void fillAndLookup(size_t iters, size_t n) {
+  while (iters--) {
+    Map m(n);
+    for (size_t i = 0; i < n; ++i) {
+      m.emplace(i, i);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      folly::doNotOptimizeAway(&*m.find(i));
+    }
+  }
+}
+
+using FixedMap = AtomicUnorderedInsertMap<uint64_t, uint64_t>;
+
+} // namespace
+
+BENCHMARK(fixed_map_100000, iters) {
+  fillAndLookup<FixedMap>(iters, 100000);
+}
+
+BENCHMARK_RELATIVE(growable_map_100000, iters) {
+  fillAndLookup<IntMap>(iters, 100000);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(lookup_growable_hit, iters) {
+  std::unique_ptr<IntMap> ptr;
+  size_t capacity = 100000;
+
+  BENCHMARK_SUSPEND {
+    ptr = std::make_unique<IntMap>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+      auto k = 3 * ((5641 * i) % capacity);
+      ptr->emplace(k, k + 1);
+    }
+  }
+
+  for (size_t i = 0; i < iters; ++i) {
+    size_t k = 3 * (((i * 7919) ^ (i * 4001)) % capacity);
+    auto iter = ptr->find(k);
+    if (iter == ptr->cend() || iter->second != k + 1) {
+      auto jter = ptr->find(k);
+      EXPECT_TRUE(iter == jter);
+    }
+    EXPECT_EQ(iter->second, k + 1);
+  }
+
+  BENCHMARK_SUSPEND {
+    ptr.reset();
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  int rv = RUN_ALL_TESTS();
+  folly::runBenchmarksOnFlag();
+  return rv;
+}
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/ConcurrentRoaringBitmap.h>
+
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/container/BitIterator.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/GTest.h>
+
+namespace folly {
+namespace test {
+
+namespace {
+
+// Bits [0, kUniverse) of a plain bitset, for reference.  Four chunks, plus
+// the top chunk of the uint32_t range through kHighBase.
+constexpr uint32_t kUniverse = uint32_t(1) << 18;
+constexpr uint32_t kHighBase = 0xffff0000;
+
+using Reference = std::vector<uint64_t>;
+
+uint32_t toIdx(size_t bit) {
+  return bit < kUniverse / 2 ? uint32_t(bit)
+                             : kHighBase + uint32_t(bit - kUniverse / 2);
+}
+
+void set(Reference& ref, size_t bit) {
+  ref[bit / 64] |= uint64_t(1) << (bit % 64);
+}
+
+// Chunk 0 sparse, chunk 1 dense, the high chunk in between, and the rest
+// empty, so that all pairs of container kinds occur.
+Reference makeReference(uint32_t seed, ConcurrentRoaringBitmap& bm) {
+  Reference ref(kUniverse / 64);
+  std::mt19937 rng(seed);
+  auto fill = [&](size_t from, size_t n, size_t num) {
+    std::uniform_int_distribution<size_t> dist(from, from + n - 1);
+    for (size_t i = 0; i < num; ++i) {
+      auto bit = dist(rng);
+      set(ref, bit);
+      bm.set(toIdx(bit));
+    }
+  };
+  fill(0, 1 << 16, 1000);
+  fill(1 << 16, 1 << 16, 30000);
+  fill(kUniverse / 2, 1 << 16, 3000 + seed % 2 * 3000);
+  return ref;
+}
+
+std::vector<uint32_t> setBits(const Reference& ref) {
+  // cross-check against BitIterator
+  std::vector<uint32_t> res;
+  auto const end = makeBitIterator(ref.end());
+  for (auto it = findFirstSet(makeBitIterator(ref.begin()), end); it != end;
+       it = findFirstSet(++it, end)) {
+    res.push_back(toIdx(it - makeBitIterator(ref.begin())));
+  }
+  return res;
+}
+
+std::vector<uint32_t> setBits(const ConcurrentRoaringBitmap& bm) {
+  std::vector<uint32_t> res;
+  bm.forEach([&](uint32_t idx) { res.push_back(idx); });
+  return res;
+}
+
+size_t popcount(const Reference& ref) {
+  size_t n = 0;
+  for (auto w : ref) {
+    n += folly::popcount(w);
+  }
+  return n;
+}
+
+} // namespace
+
+TEST(ConcurrentRoaringBitmap, Simple) {
+  ConcurrentRoaringBitmap bm;
+  EXPECT_TRUE(bm.none());
+  EXPECT_EQ(0, bm.count());
+
+  EXPECT_FALSE(bm.set(42));
+  EXPECT_TRUE(bm.set(42));
+  EXPECT_FALSE(bm.set(0xffffffff));
+  EXPECT_FALSE(bm.set(1 << 20));
+  EXPECT_TRUE(bm[42]);
+  EXPECT_TRUE(bm.test(0xffffffff));
+  EXPECT_TRUE(bm.test(1 << 20));
+  EXPECT_FALSE(bm.test(43));
+  EXPECT_FALSE(bm.test(42 + (1 << 16)));
+  EXPECT_EQ(3, bm.count());
+  EXPECT_FALSE(bm.none());
+  EXPECT_EQ((std::vector<uint32_t>{42, 1 << 20, 0xffffffff}), setBits(bm));
+
+  EXPECT_TRUE(bm.reset(42));
+  EXPECT_FALSE(bm.reset(42));
+  EXPECT_FALSE(bm.reset(7));
+  EXPECT_FALSE(bm.reset(12345678));
+  EXPECT_TRUE(bm.set(1 << 20, false));
+  EXPECT_FALSE(bm.set(5, true));
+  EXPECT_EQ((std::vector<uint32_t>{5, 0xffffffff}), setBits(bm));
+
+  bm.clear();
+  EXPECT_TRUE(bm.none());
+  EXPECT_TRUE(setBits(bm).empty());
+}
+
+TEST(ConcurrentRoaringBitmap, ArrayToBitmap) {
+  ConcurrentRoaringBitmap bm;
+  // every other bit, so that the chunk holds more than an array can
+  for (uint32_t i = 0; i < 20000; i += 2) {
+    EXPECT_FALSE(bm.set(i));
+  }
+  EXPECT_EQ(10000, bm.count());
+  for (uint32_t i = 0; i < 20000; ++i) {
+    ASSERT_EQ(i % 2 == 0, bm.test(i)) << i;
+  }
+  for (uint32_t i = 0; i < 20000; i += 2) {
+    EXPECT_TRUE(bm.reset(i));
+  }
+  EXPECT_EQ(0, bm.count());
+  EXPECT_TRUE(bm.none());
+  EXPECT_TRUE(setBits(bm).empty());
+  EXPECT_FALSE(bm.set(3));
+  EXPECT_EQ((std::vector<uint32_t>{3}), setBits(bm));
+}
+
+TEST(ConcurrentRoaringBitmap, Iteration) {
+  for (uint32_t seed = 0; seed < 4; ++seed) {
+    ConcurrentRoaringBitmap bm;
+    auto ref = makeReference(seed, bm);
+    EXPECT_EQ(setBits(ref), setBits(bm));
+    EXPECT_EQ(popcount(ref), bm.count());
+  }
+}
+
+TEST(ConcurrentRoaringBitmap, BulkOps) {
+  ConcurrentRoaringBitmap a;
+  ConcurrentRoaringBitmap b;
+  auto refA = makeReference(1, a);
+  auto refB = makeReference(2, b);
+
+  auto expect = [&](const ConcurrentRoaringBitmap& bm, auto op) {
+    Reference ref(refA.size());
+    for (size_t i = 0; i < ref.size(); ++i) {
+      ref[i] = op(refA[i], refB[i]);
+    }
+    EXPECT_EQ(setBits(ref), setBits(bm));
+    EXPECT_EQ(popcount(ref), bm.count());
+  };
+  auto bitOr = [](uint64_t x, uint64_t y) { return x | y; };
+  auto bitAnd = [](uint64_t x, uint64_t y) { return x & y; };
+  auto bitAndNot = [](uint64_t x, uint64_t y) { return x & ~y; };
+
+  expect(a | b, bitOr);
+  expect(a & b, bitAnd);
+  expect(a - b, bitAndNot);
+  EXPECT_EQ((a & b).count(), intersectionCount(a, b));
+  EXPECT_EQ((a & b).count(), intersectionCount(b, a));
+  EXPECT_TRUE((a - a).none());
+
+  ConcurrentRoaringBitmap c;
+  c |= a;
+  expect(c -= b, bitAndNot);
+  c |= a;
+  expect(c &= b, bitAnd);
+  c |= a;
+  expect(c |= b, bitOr);
+
+  ConcurrentRoaringBitmap empty;
+  c &= empty;
+  EXPECT_TRUE(c.none());
+  EXPECT_EQ(0, intersectionCount(a, empty));
+}
+
+TEST(ConcurrentRoaringBitmap, Move) {
+  ConcurrentRoaringBitmap a;
+  a.set(1);
+  a.set(100000);
+  ConcurrentRoaringBitmap b(std::move(a));
+  EXPECT_EQ((std::vector<uint32_t>{1, 100000}), setBits(b));
+  a = std::move(b);
+  EXPECT_EQ((std::vector<uint32_t>{1, 100000}), setBits(a));
+}
+
+TEST(ConcurrentRoaringBitmap, ConcurrentUpdates) {
+  constexpr size_t kThreads = 8;
+  constexpr uint32_t kBitsPerThread = 20000;
+  ConcurrentRoaringBitmap bm;
+  ConcurrentRoaringBitmap other;
+  for (uint32_t i = 0; i < kThreads * kBitsPerThread; i += 3) {
+    other.set(i);
+  }
+
+  // Each thread owns the bits equal to its index modulo kThreads, which
+  // interleave within every chunk, and all of them run bulk ops that do
+  // not change the final state concurrently.
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (uint32_t i = 0; i < kBitsPerThread; ++i) {
+        auto idx = uint32_t(i * kThreads + t);
+        ASSERT_FALSE(bm.set(idx));
+        if (i % 2) {
+          ASSERT_TRUE(bm.reset(idx));
+        }
+        ASSERT_EQ(i % 2 == 0, bm.test(idx));
+        if (i % 1000 == 0) {
+          ConcurrentRoaringBitmap none;
+          bm |= none;
+          bm -= none;
+          folly::doNotOptimizeAway((bm & other).count());
+          folly::doNotOptimizeAway(intersectionCount(bm, other));
+        }
+      }
+    });
+  }
+  for (auto& thr : threads) {
+    thr.join();
+  }
+
+  EXPECT_EQ(kThreads * kBitsPerThread / 2, bm.count());
+  uint32_t expected = 0;
+  size_t n = 0;
+  bm.forEach([&](uint32_t idx) {
+    EXPECT_EQ(expected, idx);
+    ++n;
+    if (++expected % kThreads == 0) {
+      expected += kThreads;
+    }
+  });
+  EXPECT_EQ(kThreads * kBitsPerThread / 2, n);
+}
+
+TEST(ConcurrentRoaringBitmap, ConcurrentBulkOps) {
+  constexpr size_t kThreads = 4;
+  ConcurrentRoaringBitmap target;
+  std::vector<ConcurrentRoaringBitmap> sources(kThreads);
+  Reference ref(kUniverse / 64);
+  for (size_t t = 0; t < kThreads; ++t) {
+    auto r = makeReference(uint32_t(t), sources[t]);
+    for (size_t i = 0; i < ref.size(); ++i) {
+      ref[i] |= r[i];
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] { target |= sources[t]; });
+  }
+  for (auto& thr : threads) {
+    thr.join();
+  }
+  EXPECT_EQ(setBits(ref), setBits(target));
+
+  threads.clear();
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] { target -= sources[t]; });
+  }
+  for (auto& thr : threads) {
+    thr.join();
+  }
+  EXPECT_TRUE(setBits(target).empty());
+}
+
+namespace {
+
+ConcurrentRoaringBitmap denseBitmap(uint32_t seed) {
+  ConcurrentRoaringBitmap bm;
+  makeReference(seed, bm);
+  return bm;
+}
+
+} // namespace
+
+BENCHMARK(set_sparse, iters) {
+  ConcurrentRoaringBitmap bm;
+  for (size_t i = 0; i < iters; ++i) {
+    bm.set(uint32_t(i * 7919 * 65537));
+  }
+}
+
+BENCHMARK(or_and_count, iters) {
+  ConcurrentRoaringBitmap a;
+  ConcurrentRoaringBitmap b;
+  BENCHMARK_SUSPEND {
+    a = denseBitmap(1);
+    b = denseBitmap(2);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway((a | b).count());
+  }
+}
+
+BENCHMARK(intersection_count, iters) {
+  ConcurrentRoaringBitmap a;
+  ConcurrentRoaringBitmap b;
+  BENCHMARK_SUSPEND {
+    a = denseBitmap(1);
+    b = denseBitmap(2);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(intersectionCount(a, b));
+  }
+}
+
+BENCHMARK(for_each, iters) {
+  ConcurrentRoaringBitmap a;
+  BENCHMARK_SUSPEND {
+    a = denseBitmap(1);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    uint64_t sum = 0;
+    a.forEach([&](uint32_t idx) { sum += idx; });
+    folly::doNotOptimizeAway(sum);
+  }
+}
+
+} // namespace test
+} // namespace folly
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  int rv = RUN_ALL_TESTS();
+  folly::runBenchmarksOnFlag();
+  return rv;
+}
@@ -25,6 +25,7 @@
 #include <glog/logging.h>
 
 #include <folly/Benchmark.h>
+#include <folly/container/sorted_vector_types.h>
 #include <folly/hash/Hash.h>
 #include <folly/portability/GFlags.h>
 #include <folly/synchronization/RWSpinLock.h>
@@ -48,6 +49,8 @@ typedef int ValueType;
 typedef ConcurrentSkipList<ValueType> SkipListType;
 typedef SkipListType::Accessor SkipListAccessor;
 typedef std::set<ValueType> SetType;
+typedef std::map<ValueType, ValueType> MapType;
+typedef folly::sorted_vector_map<ValueType, ValueType> SortedVectorMapType;
 
 static std::vector<ValueType> gData;
 static void initData() {
@@ -305,6 +308,162 @@ void BM_AddSkipList(int iters, int size) {
   }
 }
 
+// Loading a sorted run of iters new keys into a container of size keys.
+// As in a time-indexed index, the run goes after the keys already there.
+// The maps are guarded by a lock, as they would be when shared.
+static std::vector<ValueType> sortedRun(int iters) {
+  std::vector<ValueType> run(iters);
+  for (int i = 0; i < iters; ++i) {
+    run[i] = kMaxValue + i;
+  }
+  return run;
+}
+
+void BM_LoadRunMap(int iters, int size) {
+  BenchmarkSuspender susp;
+  MapType amap;
+  RWSpinLock lock;
+  for (int i = 0; i < size; ++i) {
+    amap.emplace(gData[i], gData[i]);
+  }
+  auto run = sortedRun(iters);
+  susp.dismiss();
+
+  std::unique_lock g(lock);
+  for (auto v : run) {
+    amap.emplace_hint(amap.end(), v, v);
+  }
+}
+
+void BM_LoadRunSortedVectorMap(int iters, int size) {
+  BenchmarkSuspender susp;
+  SortedVectorMapType amap;
+  RWSpinLock lock;
+  std::vector<std::pair<ValueType, ValueType>> pairs;
+  for (int i = 0; i < size; ++i) {
+    pairs.emplace_back(gData[i], gData[i]);
+  }
+  amap.insert(pairs.begin(), pairs.end());
+  pairs.clear();
+  for (auto v : sortedRun(iters)) {
+    pairs.emplace_back(v, v);
+  }
+  susp.dismiss();
+
+  std::unique_lock g(lock);
+  amap.insert(folly::sorted_unique, pairs.begin(), pairs.end());
+}
+
+void BM_LoadRunSkipList(int iters, int size) {
+  BenchmarkSuspender susp;
+  auto skipList = SkipListType::create(kInitHeadHeight);
+  for (int i = 0; i < size; ++i) {
+    skipList.add(gData[i]);
+  }
+  auto run = sortedRun(iters);
+  susp.dismiss();
+
+  for (auto v : run) {
+    skipList.add(v);
+  }
+}
+
+void BM_LoadRunSkipListBatch(int iters, int size) {
+  BenchmarkSuspender susp;
+  auto skipList = SkipListType::create(kInitHeadHeight);
+  for (int i = 0; i < size; ++i) {
+    skipList.add(gData[i]);
+  }
+  auto run = sortedRun(iters);
+  susp.dismiss();
+
+  skipList.insert(run.begin(), run.end());
+}
+
+// [lo, hi) scans over a container of size keys, visiting about 64 keys
+// each. One iteration is one scan. The containers are built once per size.
+static const int kScanKeys = 64;
+
+struct ScanData {
+  explicit ScanData(int size)
+      : skipList(SkipListType::create(kInitHeadHeight)),
+        span(kScanKeys * (kMaxValue / size)),
+        starts(1 << 16) {
+    std::vector<std::pair<ValueType, ValueType>> pairs;
+    for (int i = 0; i < size; ++i) {
+      amap.emplace(gData[i], gData[i]);
+      skipList.add(gData[i]);
+      pairs.emplace_back(gData[i], gData[i]);
+    }
+    sortedVectorMap.insert(pairs.begin(), pairs.end());
+    std::mt19937 rng;
+    for (auto& lo : starts) {
+      lo = rng() % kMaxValue;
+    }
+  }
+
+  MapType amap;
+  SortedVectorMapType sortedVectorMap;
+  SkipListAccessor skipList;
+  RWSpinLock lock;
+  int span;
+  std::vector<ValueType> starts;
+};
+
+static ScanData& scanData(int size) {
+  static std::map<int, std::unique_ptr<ScanData>> data;
+  auto& ptr = data[size];
+  if (!ptr) {
+    ptr = std::make_unique<ScanData>(size);
+  }
+  return *ptr;
+}
+
+template <typename Map>
+int64_t scanMap(ScanData& d, const Map& amap, int iters) {
+  int64_t sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    auto lo = d.starts[i % d.starts.size()];
+    std::shared_lock g(d.lock);
+    auto end = amap.lower_bound(lo + d.span);
+    for (auto it = amap.lower_bound(lo); it != end; ++it) {
+      sum += it->first;
+    }
+  }
+  return sum;
+}
+
+void BM_ScanMap(int iters, int size) {
+  ScanData* d;
+  BENCHMARK_SUSPEND {
+    d = &scanData(size);
+  }
+  doNotOptimizeAway(scanMap(*d, d->amap, iters));
+}
+
+void BM_ScanSortedVectorMap(int iters, int size) {
+  ScanData* d;
+  BENCHMARK_SUSPEND {
+    d = &scanData(size);
+  }
+  doNotOptimizeAway(scanMap(*d, d->sortedVectorMap, iters));
+}
+
+void BM_ScanSkipList(int iters, int size) {
+  ScanData* d;
+  BENCHMARK_SUSPEND {
+    d = &scanData(size);
+  }
+  int64_t sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    auto lo = d->starts[i % d->starts.size()];
+    for (auto v : d->skipList.range(lo, lo + d->span)) {
+      sum += v;
+    }
+  }
+  doNotOptimizeAway(sum);
+}
+
 BENCHMARK(Accessor, iters) {
   BenchmarkSuspender susp;
   auto skiplist = SkipListType::createInstance(kInitHeadHeight);
@@ -571,6 +730,28 @@ BENCHMARK_PARAM(BM_AddSet, 1000000)
 BENCHMARK_PARAM(BM_AddSkipList, 1000000)
 BENCHMARK_DRAW_LINE();
 
+BENCHMARK_PARAM(BM_LoadRunMap, 1000)
+BENCHMARK_PARAM(BM_LoadRunSortedVectorMap, 1000)
+BENCHMARK_PARAM(BM_LoadRunSkipList, 1000)
+BENCHMARK_PARAM(BM_LoadRunSkipListBatch, 1000)
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(BM_LoadRunMap, 65536)
+BENCHMARK_PARAM(BM_LoadRunSortedVectorMap, 65536)
+BENCHMARK_PARAM(BM_LoadRunSkipList, 65536)
+BENCHMARK_PARAM(BM_LoadRunSkipListBatch, 65536)
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(BM_ScanMap, 65536)
+BENCHMARK_PARAM(BM_ScanSortedVectorMap, 65536)
+BENCHMARK_PARAM(BM_ScanSkipList, 65536)
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(BM_ScanMap, 1000000)
+BENCHMARK_PARAM(BM_ScanSortedVectorMap, 1000000)
+BENCHMARK_PARAM(BM_ScanSkipList, 1000000)
+BENCHMARK_DRAW_LINE();
+
 BENCHMARK_PARAM(BM_SetMerge, 1000)
 BENCHMARK_PARAM(BM_CSLMergeIntersection, 1000)
 BENCHMARK_PARAM(BM_CSLMergeLookup, 1000)
@@ -299,6 +299,116 @@ TEST(ConcurrentSkipList, TestMovableData) {
       accessor.find(std::unique_ptr<int>(new int(N))) == accessor.end());
 }
 
+TEST(ConcurrentSkipList, BatchInsert) {
+  auto skipList(SkipListType::create(kHeadHeight));
+  SetType verifier;
+  vector<ValueType> run;
+  for (int i = 0; i < 3000; i += 3) {
+    run.push_back(i);
+  }
+  EXPECT_EQ(run.size(), skipList.insert(run.begin(), run.end()));
+  verifier.insert(run.begin(), run.end());
+  verifyEqual(skipList, verifier);
+
+  // Interleave a second sorted run, with duplicates of the first.
+  run.clear();
+  for (int i = 0; i < 6000; i += 2) {
+    run.push_back(i);
+  }
+  size_t fresh = 0;
+  for (auto v : run) {
+    fresh += verifier.insert(v).second;
+  }
+  EXPECT_EQ(fresh, skipList.insert(run.begin(), run.end()));
+  verifyEqual(skipList, verifier);
+
+  // Unsorted input is slower, but still correct.
+  run.clear();
+  for (int i = 0; i < 2000; ++i) {
+    run.push_back(rand() % 20000);
+  }
+  fresh = 0;
+  for (auto v : run) {
+    fresh += verifier.insert(v).second;
+  }
+  EXPECT_EQ(fresh, skipList.insert(run.begin(), run.end()));
+  verifyEqual(skipList, verifier);
+  EXPECT_EQ(0, skipList.insert(run.begin(), run.end()));
+}
+
+TEST(ConcurrentSkipList, BatchInsertMovable) {
+  typedef folly::ConcurrentSkipList<std::unique_ptr<int>, UniquePtrComp>
+      SkipListT;
+  auto accessor = SkipListT::create();
+  vector<std::unique_ptr<int>> run;
+  for (int i = 0; i < 100; ++i) {
+    run.push_back(std::make_unique<int>(i));
+  }
+  EXPECT_EQ(
+      100,
+      accessor.insert(
+          std::make_move_iterator(run.begin()),
+          std::make_move_iterator(run.end())));
+  int expected = 0;
+  for (auto& p : accessor) {
+    EXPECT_EQ(expected++, *p);
+  }
+  EXPECT_EQ(100, expected);
+}
+
+TEST(ConcurrentSkipList, ConcurrentBatchInsert) {
+  int numThreads = 8;
+  auto skipList(SkipListType::create(kHeadHeight));
+  vector<std::thread> threads;
+  vector<vector<ValueType>> runs(numThreads);
+  for (int i = 0; i < numThreads; ++i) {
+    // Sorted runs that overlap each other.
+    for (int v = i; v < 200000; v += 1 + (i % 3)) {
+      runs[i].push_back(v);
+    }
+    threads.push_back(std::thread([&skipList, &runs, i] {
+      skipList.insert(runs[i].begin(), runs[i].end());
+      for (int v = i; v < 200000; v += 97) {
+        skipList.remove(v);
+      }
+    }));
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_TRUE(std::is_sorted(skipList.begin(), skipList.end()));
+  EXPECT_EQ(
+      skipList.size(), std::distance(skipList.begin(), skipList.end()));
+}
+
+TEST(ConcurrentSkipList, RangeScan) {
+  auto skipList(SkipListType::create(kHeadHeight));
+  for (int i = 0; i < 1000; i += 2) {
+    skipList.add(i);
+  }
+  auto collect = [&](int lo, int hi) {
+    vector<ValueType> out;
+    for (auto v : skipList.range(lo, hi)) {
+      out.push_back(v);
+    }
+    return out;
+  };
+  EXPECT_EQ(vector<ValueType>({10, 12, 14}), collect(10, 16));
+  EXPECT_EQ(vector<ValueType>({10, 12, 14, 16}), collect(9, 17));
+  EXPECT_EQ(vector<ValueType>({996, 998}), collect(995, 5000));
+  EXPECT_TRUE(collect(11, 12).empty());
+  EXPECT_TRUE(collect(20, 10).empty());
+  EXPECT_TRUE(skipList.range(2000, 3000).empty());
+  EXPECT_EQ(500, collect(-1, 1000).size());
+
+  // Removed elements are skipped, and the scan still stops at hi.
+  skipList.remove(12);
+  skipList.remove(16);
+  EXPECT_EQ(vector<ValueType>({10, 14}), collect(10, 18));
+  auto range = skipList.range(0, 10);
+  EXPECT_EQ(5, std::distance(range.begin(), range.end()));
+}
+
 TEST(ConcurrentSkipList, ConcurrentAdd) {
   int numThreads = 100;
   auto skipList(SkipListType::create(kHeadHeight));
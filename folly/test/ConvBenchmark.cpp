@@ -19,11 +19,14 @@
 #include <array>
 #include <limits>
 #include <stdexcept>
+#include <vector>
 
 #include <boost/lexical_cast.hpp>
 
 #include <folly/Benchmark.h>
 #include <folly/CppAttributes.h>
+#include <folly/Random.h>
+#include <folly/String.h>
 #include <folly/container/Foreach.h>
 #include <folly/lang/ToAscii.h>
 
@@ -1128,6 +1131,121 @@ FLOAT_TO_ARITH_BENCHMARK(int, Int, double2IntGood, double2IntBad)
 #undef INT_TO_ARITH_BENCHMARK
 #undef FLOAT_TO_ARITH_BENCHMARK
 
+// Columns of numbers, converted one at a time and in batches.
+
+namespace {
+
+constexpr size_t kColumnSize = 1000;
+
+template <class T>
+std::vector<T> makeColumn() {
+  std::vector<T> ret;
+  for (size_t i = 0; i < kColumnSize; ++i) {
+    if constexpr (std::is_floating_point<T>::value) {
+      ret.push_back(T((Random::randDouble01() - 0.5) * 1e6));
+    } else {
+      ret.push_back(T(Random::rand64() >> Random::rand32(64)));
+    }
+  }
+  return ret;
+}
+
+template <class T>
+std::string makeLine(const std::vector<T>& column) {
+  std::string ret;
+  for (size_t i = 0; i < column.size(); ++i) {
+    toAppend(i == 0 ? "" : ",", column[i], &ret);
+  }
+  return ret;
+}
+
+const auto int64Column = makeColumn<int64_t>();
+const auto int32Column = makeColumn<int32_t>();
+const auto doubleColumn = makeColumn<double>();
+const auto int64Line = makeLine(int64Column);
+const auto int32Line = makeLine(int32Column);
+const auto doubleLine = makeLine(doubleColumn);
+
+template <class T>
+void parseColumnSplit(const std::string& line, size_t n) {
+  std::vector<StringPiece> fields;
+  std::vector<T> out(kColumnSize);
+  for (size_t iter = 0; iter < n; ++iter) {
+    fields.clear();
+    split(',', line, fields);
+    for (size_t i = 0; i < fields.size(); ++i) {
+      out[i] = to<T>(fields[i]);
+    }
+    doNotOptimizeAway(out.data());
+  }
+}
+
+template <class T>
+void parseColumnBatch(const std::string& line, size_t n) {
+  std::vector<T> out(kColumnSize);
+  for (size_t iter = 0; iter < n; ++iter) {
+    StringPiece src(line);
+    auto ret = tryToBatch<T>(&src, ',', range(out));
+    CHECK(ret && ret.count == kColumnSize);
+    doNotOptimizeAway(out.data());
+  }
+}
+
+template <class T>
+void formatColumnLoop(const std::vector<T>& column, size_t n) {
+  for (size_t iter = 0; iter < n; ++iter) {
+    std::string out;
+    for (size_t i = 0; i < column.size(); ++i) {
+      toAppend(i == 0 ? "" : ",", column[i], &out);
+    }
+    doNotOptimizeAway(out);
+  }
+}
+
+template <class T>
+void formatColumnBatch(const std::vector<T>& column, size_t n) {
+  for (size_t iter = 0; iter < n; ++iter) {
+    std::string out;
+    toAppendDelimBatch(',', range(column), &out);
+    doNotOptimizeAway(out);
+  }
+}
+
+} // namespace
+
+BENCHMARK_DRAW_LINE();
+BENCHMARK(parseInt64ColumnSplit, n) {
+  parseColumnSplit<int64_t>(int64Line, n);
+}
+BENCHMARK_RELATIVE(parseInt64ColumnBatch, n) {
+  parseColumnBatch<int64_t>(int64Line, n);
+}
+BENCHMARK(parseInt32ColumnSplit, n) {
+  parseColumnSplit<int32_t>(int32Line, n);
+}
+BENCHMARK_RELATIVE(parseInt32ColumnBatch, n) {
+  parseColumnBatch<int32_t>(int32Line, n);
+}
+BENCHMARK(parseDoubleColumnSplit, n) {
+  parseColumnSplit<double>(doubleLine, n);
+}
+BENCHMARK_RELATIVE(parseDoubleColumnBatch, n) {
+  parseColumnBatch<double>(doubleLine, n);
+}
+BENCHMARK_DRAW_LINE();
+BENCHMARK(formatInt64ColumnLoop, n) {
+  formatColumnLoop(int64Column, n);
+}
+BENCHMARK_RELATIVE(formatInt64ColumnBatch, n) {
+  formatColumnBatch(int64Column, n);
+}
+BENCHMARK(formatDoubleColumnLoop, n) {
+  formatColumnLoop(doubleColumn, n);
+}
+BENCHMARK_RELATIVE(formatDoubleColumnBatch, n) {
+  formatColumnBatch(doubleColumn, n);
+}
+
 int main(int argc, char** argv) {
   folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
   folly::runBenchmarks();
@@ -2248,3 +2248,249 @@ TEST(Conv, DtoaFlags) {
       DtoaFlags::EMIT_TRAILING_ZERO_AFTER_POINT);
   EXPECT_EQ(combo & DtoaFlags::UNIQUE_ZERO, DtoaFlags::NO_FLAGS);
 }
+
+namespace {
+
+template <class T>
+void checkBatchMatchesTryTo(const std::vector<std::string>& strings) {
+  std::vector<StringPiece> pieces(strings.begin(), strings.end());
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    T value{};
+    auto ret = tryToBatch<T>(
+        Range<const StringPiece*>(&pieces[i], 1), Range<T*>(&value, 1));
+    auto expected = tryTo<T>(pieces[i]);
+    ASSERT_EQ(expected.hasValue(), bool(ret)) << pieces[i];
+    if (expected) {
+      EXPECT_EQ(1, ret.count);
+      EXPECT_EQ(*expected, value) << pieces[i];
+    } else {
+      EXPECT_EQ(0, ret.count);
+      EXPECT_EQ(expected.error(), ret.code) << pieces[i];
+    }
+
+    // The same string, as the field of a line.
+    auto line = folly::to<std::string>("0,", pieces[i], ",1");
+    StringPiece src(line);
+    T values[3] = {};
+    ret = tryToBatch<T>(&src, ',', Range<T*>(values, 3));
+    if (expected) {
+      EXPECT_TRUE(ret) << line;
+      EXPECT_EQ(3, ret.count);
+      EXPECT_EQ(*expected, values[1]) << line;
+      EXPECT_EQ(1, values[2]);
+      EXPECT_TRUE(src.empty());
+    } else {
+      EXPECT_EQ(1, ret.count);
+      EXPECT_EQ(line.data() + 2, src.data()) << line;
+    }
+  }
+}
+
+template <class T>
+std::vector<std::string> batchTestStrings() {
+  using L = std::numeric_limits<T>;
+  std::vector<std::string> ret = {
+      "",
+      "0",
+      "-0",
+      "+1",
+      "-",
+      "+",
+      "7",
+      "-7",
+      "12345678",
+      "123456789",
+      "-12345678",
+      "00000000000000000000000042",
+      "1234567890123456789",
+      "12345678901234567890",
+      "99999999999999999999",
+      " 12",
+      "12 ",
+      "\t-12\n",
+      "1x",
+      "12345678x",
+      "1234567x9",
+      "x",
+      "1.5",
+      "1e3",
+      "--1",
+      "1-",
+      to<std::string>(L::max()),
+      to<std::string>(L::min()),
+      to<std::string>(L::max()) + "0",
+      to<std::string>(L::min()) + "0",
+  };
+  if (L::max() < std::numeric_limits<uint64_t>::max()) {
+    ret.push_back(to<std::string>(uint64_t(L::max()) + 1));
+    ret.push_back(to<std::string>(uint64_t(L::max()) * 3 + 1));
+  }
+  if (std::is_signed<T>::value) {
+    if constexpr (sizeof(T) < sizeof(int64_t)) {
+      ret.push_back(to<std::string>(int64_t(L::min()) - 1));
+    } else {
+      ret.push_back("-9223372036854775809");
+    }
+  }
+  for (int i = 0; i < 500; ++i) {
+    auto s = to<std::string>(folly::Random::rand64() >> (i % 64));
+    ret.push_back(s);
+    ret.push_back("-" + s);
+    ret.push_back(s.substr(0, i % 20));
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST(Conv, TryToBatchMatchesTryTo) {
+  checkBatchMatchesTryTo<int8_t>(batchTestStrings<int8_t>());
+  checkBatchMatchesTryTo<uint8_t>(batchTestStrings<uint8_t>());
+  checkBatchMatchesTryTo<int16_t>(batchTestStrings<int16_t>());
+  checkBatchMatchesTryTo<uint16_t>(batchTestStrings<uint16_t>());
+  checkBatchMatchesTryTo<int32_t>(batchTestStrings<int32_t>());
+  checkBatchMatchesTryTo<uint32_t>(batchTestStrings<uint32_t>());
+  checkBatchMatchesTryTo<int64_t>(batchTestStrings<int64_t>());
+  checkBatchMatchesTryTo<uint64_t>(batchTestStrings<uint64_t>());
+  checkBatchMatchesTryTo<double>(
+      {"", "0", "-1.5", "1e308", "-inf", " 2.5 ", "1.5x"});
+  checkBatchMatchesTryTo<float>({"0.1", "-3.25", "x"});
+}
+
+TEST(Conv, TryToBatchDelimited) {
+  StringPiece src = "1,-22,333,4444,55555,666666,7777777,88888888,999999999";
+  std::vector<int> values(4);
+  auto ret = tryToBatch<int>(&src, ',', range(values));
+  EXPECT_TRUE(ret);
+  EXPECT_EQ(4, ret.count);
+  EXPECT_EQ((std::vector<int>{1, -22, 333, 4444}), values);
+  EXPECT_EQ("55555,666666,7777777,88888888,999999999", src);
+  ret = tryToBatch<int>(&src, ',', range(values));
+  EXPECT_EQ(4, ret.count);
+  EXPECT_EQ("999999999", src);
+  ret = tryToBatch<int>(&src, ',', range(values));
+  EXPECT_TRUE(ret);
+  EXPECT_EQ(1, ret.count);
+  EXPECT_EQ(999999999, values[0]);
+  EXPECT_TRUE(src.empty());
+  ret = tryToBatch<int>(&src, ',', range(values));
+  EXPECT_TRUE(ret);
+  EXPECT_EQ(0, ret.count);
+
+  // Empty fields, in the middle and at the end.
+  src = "1,,2";
+  ret = tryToBatch<int>(&src, ',', range(values));
+  EXPECT_EQ(ConversionCode::EMPTY_INPUT_STRING, ret.code);
+  EXPECT_EQ(1, ret.count);
+  EXPECT_EQ(",2", src);
+  src = "1,2,";
+  ret = tryToBatch<int>(&src, ',', range(values));
+  EXPECT_EQ(ConversionCode::EMPTY_INPUT_STRING, ret.code);
+  EXPECT_EQ(2, ret.count);
+  EXPECT_TRUE(src.empty());
+  src = "1,2,";
+  ret = tryToBatch<int>(&src, ',', Range<int*>(values.data(), 2));
+  EXPECT_TRUE(ret);
+  EXPECT_TRUE(src.empty());
+
+  // Whitespace around fields, and whitespace and digits as delimiters.
+  src = " 1 , 2\t,3 ";
+  ret = tryToBatch<int>(&src, ',', range(values));
+  EXPECT_EQ(3, ret.count);
+  EXPECT_EQ(3, values[2]);
+  src = "10 20\t30";
+  ret = tryToBatch<int>(&src, ' ', range(values));
+  EXPECT_EQ(ConversionCode::NON_WHITESPACE_AFTER_END, ret.code);
+  EXPECT_EQ(1, ret.count);
+  EXPECT_EQ("20\t30", src);
+  src = "1090-3";
+  ret = tryToBatch<int>(&src, '0', range(values));
+  EXPECT_TRUE(ret);
+  EXPECT_EQ(3, ret.count);
+  EXPECT_EQ(9, values[1]);
+  EXPECT_EQ(-3, values[2]);
+  src = "1-2";
+  ret = tryToBatch<int>(&src, '-', range(values));
+  EXPECT_EQ(2, ret.count);
+  EXPECT_EQ(2, values[1]);
+
+  src = "0.5|-1e-3|inf";
+  std::vector<double> doubles(3);
+  ret = tryToBatch<double>(&src, '|', range(doubles));
+  EXPECT_TRUE(ret);
+  EXPECT_EQ((std::vector<double>{0.5, -1e-3, INFINITY}), doubles);
+}
+
+TEST(Conv, ToBatch) {
+  std::vector<StringPiece> strings = {"1", "20", "300", "x", "5"};
+  std::vector<int16_t> values(strings.size());
+  auto ret = tryToBatch<int16_t>(range(strings), range(values));
+  EXPECT_EQ(ConversionCode::INVALID_LEADING_CHAR, ret.code);
+  EXPECT_EQ(3, ret.count);
+  EXPECT_EQ(300, values[2]);
+
+  // Converts as many values as there is room for.
+  ret = tryToBatch<int16_t>(range(strings), Range<int16_t*>(values.data(), 2));
+  EXPECT_TRUE(ret);
+  EXPECT_EQ(2, ret.count);
+
+  toBatch<int16_t>(Range<const StringPiece*>(strings.data(), 3), range(values));
+  EXPECT_EQ(20, values[1]);
+  EXPECT_THROW(
+      toBatch<int16_t>(range(strings), range(values)), ConversionError);
+  strings[3] = "70000";
+  try {
+    toBatch<int16_t>(range(strings), range(values));
+    ADD_FAILURE();
+  } catch (const ConversionError& e) {
+    EXPECT_EQ(ConversionCode::POSITIVE_OVERFLOW, e.errorCode());
+    EXPECT_NE(std::string::npos, std::string(e.what()).find("70000"));
+  }
+}
+
+TEST(Conv, ToAppendDelimBatch) {
+  std::vector<int64_t> ints = {
+      0,
+      -1,
+      7,
+      std::numeric_limits<int64_t>::min(),
+      std::numeric_limits<int64_t>::max()};
+  for (int i = 0; i < 2000; ++i) {
+    ints.push_back(int64_t(folly::Random::rand64()) >> (i % 64));
+  }
+  std::string expected;
+  for (size_t i = 0; i < ints.size(); ++i) {
+    toAppend(i == 0 ? "" : ", ", ints[i], &expected);
+  }
+  std::string out = "prefix";
+  toAppendDelimBatch(", ", range(ints), &out);
+  EXPECT_EQ("prefix" + expected, out);
+
+  std::vector<uint8_t> bytes = {0, 128, 255};
+  out.clear();
+  toAppendDelimBatch(':', range(bytes), &out);
+  EXPECT_EQ("0:128:255", out);
+
+  std::vector<double> doubles = {0.0, -0.5, 1e300, 1.0 / 3, NAN, -INFINITY};
+  for (int i = 0; i < 1000; ++i) {
+    doubles.push_back(folly::Random::randDouble01() * (i - 500));
+  }
+  expected.clear();
+  toAppendDelim(',', doubles[0], doubles[1], &expected);
+  for (size_t i = 2; i < doubles.size(); ++i) {
+    toAppend(',', doubles[i], &expected);
+  }
+  out.clear();
+  toAppendDelimBatch(',', range(doubles), &out);
+  EXPECT_EQ(expected, out);
+
+  const std::vector<float> floats = {0.1f, -2.5f};
+  fbstring fbout;
+  toAppendDelimBatch(std::string(5000, '-'), range(floats), &fbout);
+  EXPECT_EQ(
+      to<fbstring>(floats[0], std::string(5000, '-'), floats[1]), fbout);
+
+  out.clear();
+  toAppendDelimBatch(',', Range<const int*>(), &out);
+  EXPECT_TRUE(out.empty());
+}